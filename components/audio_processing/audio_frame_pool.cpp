@@ -0,0 +1,316 @@
+#include "audio_frame_pool.h"
+#include <chrono>
+#include <new>
+
+namespace audio_processing {
+
+// ---------------------------------------------------------------------------
+// FrameRef
+// ---------------------------------------------------------------------------
+
+FrameRef::FrameRef(const FrameRef& other) : _frame(other._frame) {
+    if (_frame != nullptr) {
+        _frame->pool->retain(_frame);
+    }
+}
+
+FrameRef& FrameRef::operator=(const FrameRef& other) {
+    if (this != &other) {
+        if (other._frame != nullptr) {
+            other._frame->pool->retain(other._frame);
+        }
+        reset();
+        _frame = other._frame;
+    }
+    return *this;
+}
+
+FrameRef& FrameRef::operator=(FrameRef&& other) noexcept {
+    if (this != &other) {
+        reset();
+        _frame = other._frame;
+        other._frame = nullptr;
+    }
+    return *this;
+}
+
+void FrameRef::reset() {
+    if (_frame != nullptr) {
+        _frame->pool->release(_frame);
+        _frame = nullptr;
+    }
+}
+
+// ---------------------------------------------------------------------------
+// FramePool
+// ---------------------------------------------------------------------------
+
+FramePool::FramePool()
+    : _frames(nullptr), _storage(nullptr), _free_list(nullptr), _free_count(0),
+      _frame_count(0), _frame_samples(0), _exhausted(0) {
+}
+
+FramePool::~FramePool() {
+    deinit();
+}
+
+bool FramePool::init(size_t frame_count, size_t frame_samples, MemoryRegion region) {
+    if (_frames != nullptr) {
+        AUDIO_LOGF("FramePool already initialized\n");
+        return false;
+    }
+    if (frame_count == 0 || frame_samples == 0) {
+        AUDIO_LOGF("Invalid frame pool dimensions\n");
+        return false;
+    }
+
+    // Headers hold atomics and are touched on every publish, keep them internal
+    _frames = static_cast<AudioFrame*>(audioAlloc(frame_count * sizeof(AudioFrame), MemoryRegion::INTERNAL));
+    _free_list = static_cast<AudioFrame**>(audioAlloc(frame_count * sizeof(AudioFrame*), MemoryRegion::INTERNAL));
+    _storage = static_cast<int16_t*>(audioAlloc(frame_count * frame_samples * sizeof(int16_t), region));
+
+    if (!_frames || !_free_list || !_storage) {
+        AUDIO_LOGF("Failed to allocate frame pool (%u frames x %u samples)\n",
+                   (unsigned)frame_count, (unsigned)frame_samples);
+        audioFree(_frames);
+        audioFree(_free_list);
+        audioFree(_storage);
+        _frames = nullptr;
+        _free_list = nullptr;
+        _storage = nullptr;
+        return false;
+    }
+
+    _frame_count = frame_count;
+    _frame_samples = frame_samples;
+    for (size_t i = 0; i < frame_count; i++) {
+        AudioFrame* frame = new (&_frames[i]) AudioFrame();
+        frame->samples = _storage + i * frame_samples;
+        frame->capacity = frame_samples;
+        frame->length = 0;
+        frame->sequence = 0;
+        frame->timestamp_us = 0;
+        frame->flags = 0;
+        frame->refs.store(0);
+        frame->pool = this;
+        _free_list[i] = frame;
+    }
+    _free_count = frame_count;
+    _exhausted.store(0);
+    return true;
+}
+
+void FramePool::deinit() {
+    if (_frames == nullptr) {
+        return;
+    }
+    if (_free_count != _frame_count) {
+        AUDIO_LOGF("FramePool deinit with %u frames still referenced\n",
+                   (unsigned)(_frame_count - _free_count));
+    }
+    for (size_t i = 0; i < _frame_count; i++) {
+        _frames[i].~AudioFrame();
+    }
+    audioFree(_frames);
+    audioFree(_free_list);
+    audioFree(_storage);
+    _frames = nullptr;
+    _free_list = nullptr;
+    _storage = nullptr;
+    _free_count = 0;
+    _frame_count = 0;
+    _frame_samples = 0;
+}
+
+FrameRef FramePool::acquire() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_free_count == 0) {
+        _exhausted.fetch_add(1);
+        return FrameRef();
+    }
+    AudioFrame* frame = _free_list[--_free_count];
+    frame->length = 0;
+    frame->sequence = 0;
+    frame->timestamp_us = audioMicros();
+    frame->flags = 0;
+    frame->refs.store(1);
+    return FrameRef(frame);
+}
+
+size_t FramePool::available() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _free_count;
+}
+
+void FramePool::retain(AudioFrame* frame) {
+    frame->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FramePool::release(AudioFrame* frame) {
+    if (frame->refs.fetch_sub(1, std::memory_order_acq_rel) != 1) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(_mutex);
+    _free_list[_free_count++] = frame;
+}
+
+// ---------------------------------------------------------------------------
+// FrameFanout
+// ---------------------------------------------------------------------------
+
+FrameFanout::FrameFanout() : _consumer_count(0), _next_sequence(1) {
+}
+
+FrameFanout::~FrameFanout() {
+    clear();
+}
+
+int FrameFanout::addConsumer(const char* name, size_t queue_depth,
+                             BackpressurePolicy policy, uint32_t block_timeout_ms) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_consumer_count >= MAX_CONSUMERS || queue_depth == 0) {
+        return -1;
+    }
+
+    Consumer& consumer = _consumers[_consumer_count];
+    consumer.queue = static_cast<AudioFrame**>(
+        audioAlloc(queue_depth * sizeof(AudioFrame*), MemoryRegion::INTERNAL));
+    if (consumer.queue == nullptr) {
+        AUDIO_LOGF("Failed to allocate queue for consumer %s\n", name);
+        return -1;
+    }
+
+    consumer.name = name;
+    consumer.queue_depth = queue_depth;
+    consumer.head = 0;
+    consumer.count = 0;
+    consumer.policy = policy;
+    consumer.block_timeout_ms = block_timeout_ms;
+    consumer.last_sequence = _next_sequence - 1;
+    consumer.stats = ConsumerStats();
+    return _consumer_count++;
+}
+
+void FrameFanout::pushLocked(Consumer& consumer, AudioFrame* frame) {
+    size_t tail = (consumer.head + consumer.count) % consumer.queue_depth;
+    consumer.queue[tail] = frame;
+    consumer.count++;
+    consumer.stats.delivered++;
+    if (consumer.count > consumer.stats.max_depth) {
+        consumer.stats.max_depth = consumer.count;
+    }
+    consumer.data_ready.notify_one();
+}
+
+AudioFrame* FrameFanout::popLocked(Consumer& consumer) {
+    AudioFrame* frame = consumer.queue[consumer.head];
+    consumer.head = (consumer.head + 1) % consumer.queue_depth;
+    consumer.count--;
+    consumer.space_ready.notify_one();
+    return frame;
+}
+
+size_t FrameFanout::publish(const FrameRef& frame) {
+    if (!frame) {
+        return 0;
+    }
+
+    std::unique_lock<std::mutex> lock(_mutex);
+    frame->sequence = _next_sequence++;
+
+    size_t accepted = 0;
+    for (int i = 0; i < _consumer_count; i++) {
+        Consumer& consumer = _consumers[i];
+
+        if (consumer.count == consumer.queue_depth) {
+            if (consumer.policy == BackpressurePolicy::DROP_OLDEST) {
+                FrameRef evicted(popLocked(consumer));
+                consumer.stats.dropped++;
+            } else if (consumer.policy == BackpressurePolicy::BLOCK) {
+                consumer.space_ready.wait_for(lock, std::chrono::milliseconds(consumer.block_timeout_ms),
+                                              [&consumer] { return consumer.count < consumer.queue_depth; });
+            }
+        }
+
+        if (consumer.count < consumer.queue_depth) {
+            FrameRef ref(frame);
+            pushLocked(consumer, ref.detach());
+            accepted++;
+        } else {
+            consumer.stats.dropped++;
+        }
+
+        uint32_t lag = frame->sequence - consumer.last_sequence;
+        if (lag > consumer.stats.max_lag_frames) {
+            consumer.stats.max_lag_frames = lag;
+        }
+    }
+    return accepted;
+}
+
+bool FrameFanout::receive(int consumer_id, FrameRef& frame, uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (consumer_id < 0 || consumer_id >= _consumer_count) {
+        return false;
+    }
+
+    Consumer& consumer = _consumers[consumer_id];
+    if (consumer.count == 0) {
+        if (timeout_ms == 0) {
+            return false;
+        }
+        if (!consumer.data_ready.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                                          [&consumer] { return consumer.count > 0; })) {
+            return false;
+        }
+    }
+
+    AudioFrame* raw = popLocked(consumer);
+    consumer.last_sequence = raw->sequence;
+    consumer.stats.consumed++;
+
+    uint64_t latency = audioMicros() - raw->timestamp_us;
+    consumer.stats.last_latency_us = latency;
+    if (latency > consumer.stats.max_latency_us) {
+        consumer.stats.max_latency_us = latency;
+    }
+
+    lock.unlock();
+    frame = FrameRef(raw);
+    return true;
+}
+
+bool FrameFanout::getStats(int consumer_id, ConsumerStats* stats) const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (consumer_id < 0 || consumer_id >= _consumer_count || stats == nullptr) {
+        return false;
+    }
+    const Consumer& consumer = _consumers[consumer_id];
+    *stats = consumer.stats;
+    stats->depth = consumer.count;
+    stats->lag_frames = (_next_sequence - 1) - consumer.last_sequence;
+    return true;
+}
+
+const char* FrameFanout::consumerName(int consumer_id) const {
+    if (consumer_id < 0 || consumer_id >= _consumer_count) {
+        return nullptr;
+    }
+    return _consumers[consumer_id].name;
+}
+
+void FrameFanout::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int i = 0; i < _consumer_count; i++) {
+        Consumer& consumer = _consumers[i];
+        while (consumer.count > 0) {
+            FrameRef released(popLocked(consumer));
+        }
+        audioFree(consumer.queue);
+        consumer.queue = nullptr;
+        consumer.queue_depth = 0;
+    }
+    _consumer_count = 0;
+}
+
+} // namespace audio_processing
@@ -4,7 +4,7 @@
 namespace audio_processing {
 
 AudioInput::AudioInput() : _buffer(nullptr), _buffer_size(0), _is_recording(false), 
-                          _sample_rate(16000), _decimation_factor(64) {
+                          _sample_rate(16000), _decimation_factor(64), _filter_enabled(true) {
     // Constructor
 }
 
@@ -111,14 +111,14 @@ bool AudioInput::readAudioData(int16_t* output_buffer, size_t output_size, size_
     }
     Serial.println();
 
-    // Apply additional filtering if needed
-    if (!_pdm_proc.applyFilter(output_buffer, pcm_size)) {
-        Serial.println("[ERROR] Failed to apply filter");
-        return false;
+    // Apply additional filtering if needed (deferred to filterAudio() when gated)
+    if (_filter_enabled) {
+        if (!filterAudio(output_buffer, pcm_size)) {
+            return false;
+        }
+        Serial.println("[DEBUG] Filter applied successfully");
     }
 
-    Serial.println("[DEBUG] Filter applied successfully");
-
     // Set the number of samples read
     *samples_read = pcm_size;
     Serial.printf("[DEBUG] Total PCM samples read: %d\n", *samples_read);
@@ -126,6 +126,30 @@ bool AudioInput::readAudioData(int16_t* output_buffer, size_t output_size, size_
     return true;
 }
 
+bool AudioInput::readAudioFrame(FramePool& pool, FrameRef& frame) {
+    frame = pool.acquire();
+    if (!frame) {
+        Serial.println("[ERROR] Frame pool exhausted");
+        return false;
+    }
+
+    size_t samples_read = 0;
+    if (!readAudioData(frame->samples, frame->capacity, &samples_read)) {
+        frame.reset();
+        return false;
+    }
+
+    frame->length = samples_read;
+    return true;
+}
+
+bool AudioInput::filterAudio(int16_t* samples, size_t count) {
+    if (!_pdm_proc.applyFilter(samples, count)) {
+        Serial.println("[ERROR] Failed to apply filter");
+        return false;
+    }
+    return true;
+}
 
 float AudioInput::getAudioLevel() {
     if (!_is_recording || _buffer == nullptr) {
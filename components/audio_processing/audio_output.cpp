@@ -0,0 +1,190 @@
+#include "audio_output.h"
+#include <Arduino.h>
+#include "driver/i2s.h"
+
+// External DAC / amplifier pins for Xiao ESP32 (D2, D3, D4)
+#define I2S_OUT_BCLK 3   // Bit clock
+#define I2S_OUT_WS   4   // Word select (LRCLK)
+#define I2S_OUT_DOUT 5   // Serial data out
+#define I2S_OUT_PORT I2S_NUM_1   // I2S_NUM_0 is the PDM microphone
+
+#define FEEDER_STACK_SIZE 3072
+
+namespace audio_processing {
+
+AudioOutput::AudioOutput() : _latency(LatencyProfile::BALANCED), _sample_rate(16000), _block(nullptr),
+                             _initialized(false), _running(false), _finished(true), _pause(false), _parked(false) {
+    // Constructor
+}
+
+AudioOutput::~AudioOutput() {
+    // Destructor - ensure cleanup
+    deinit();
+}
+
+bool AudioOutput::init(int sample_rate, LatencyProfile latency) {
+    if (_initialized) {
+        Serial.println("Audio output already initialized");
+        return true;
+    }
+    _sample_rate = sample_rate;
+    _latency = latency;
+    OutputProfile profile = outputProfile(latency);
+
+    // Ring and block in internal RAM: the feeder runs at high priority and
+    // must not wait on PSRAM cache misses
+    if (!_feeder.init(profile, MemoryRegion::INTERNAL)) {
+        Serial.println("Failed to allocate output ring");
+        return false;
+    }
+    _feeder.setSampleRate(sample_rate);
+    _block = static_cast<int16_t*>(audioAlloc(profile.dma_frames * sizeof(int16_t), MemoryRegion::INTERNAL));
+    if (_block == nullptr) {
+        Serial.println("Failed to allocate output block");
+        _feeder.deinit();
+        return false;
+    }
+
+    i2s_config_t i2s_config = {
+        .mode = (i2s_mode_t)(I2S_MODE_MASTER | I2S_MODE_TX),
+        .sample_rate = (uint32_t)sample_rate,
+        .bits_per_sample = I2S_BITS_PER_SAMPLE_16BIT,
+        .channel_format = I2S_CHANNEL_FMT_ONLY_LEFT,   // Mono
+        .communication_format = I2S_COMM_FORMAT_STAND_I2S,
+        .intr_alloc_flags = ESP_INTR_FLAG_LEVEL1,
+        .dma_buf_count = (int)profile.dma_buffers,
+        .dma_buf_len = (int)profile.dma_frames,
+        .use_apll = false,
+        .tx_desc_auto_clear = true,   // Zeros if the feeder ever misses a buffer
+        .fixed_mclk = 0
+    };
+
+    i2s_pin_config_t pin_config = {
+        .bck_io_num = I2S_OUT_BCLK,
+        .ws_io_num = I2S_OUT_WS,
+        .data_out_num = I2S_OUT_DOUT,
+        .data_in_num = I2S_PIN_NO_CHANGE   // Not used for output
+    };
+
+    esp_err_t result = i2s_driver_install(I2S_OUT_PORT, &i2s_config, 0, NULL);
+    if (result != ESP_OK) {
+        Serial.println("Failed to install I2S TX driver");
+        deinit();
+        return false;
+    }
+    _initialized = true;
+
+    result = i2s_set_pin(I2S_OUT_PORT, &pin_config);
+    if (result != ESP_OK) {
+        Serial.println("Failed to set I2S TX pins");
+        deinit();
+        return false;
+    }
+    i2s_zero_dma_buffer(I2S_OUT_PORT);
+
+    Serial.printf("Audio output initialized: %d Hz, %u x %u DMA, %u us latency\n", sample_rate,
+                  (unsigned)profile.dma_buffers, (unsigned)profile.dma_frames, (unsigned)latencyUs());
+    return true;
+}
+
+bool AudioOutput::start(int core, int priority) {
+    if (!_initialized) {
+        Serial.println("[ERROR] Audio output not initialized");
+        return false;
+    }
+    if (_running.load()) {
+        return true;
+    }
+    _running.store(true);
+    _finished.store(false);
+    if (xTaskCreatePinnedToCore(feederEntry, "audio_out", FEEDER_STACK_SIZE, this, priority, NULL, core) != pdPASS) {
+        Serial.println("Failed to create audio output task");
+        _running.store(false);
+        _finished.store(true);
+        return false;
+    }
+    return true;
+}
+
+bool AudioOutput::stop() {
+    if (!_running.exchange(false)) {
+        return true;
+    }
+    // The task notices within one DMA buffer
+    while (!_finished.load()) {
+        vTaskDelay(1);
+    }
+    i2s_zero_dma_buffer(I2S_OUT_PORT);
+    return true;
+}
+
+bool AudioOutput::setSampleRate(int sample_rate) {
+    if (!_initialized) {
+        return false;
+    }
+    if (sample_rate == _sample_rate) {
+        return true;
+    }
+    _feeder.flush();
+
+    // The driver must not be inside i2s_write() while the clock changes;
+    // the feeder parks within one DMA buffer
+    bool parked = _running.load();
+    if (parked) {
+        _pause.store(true);
+        while (!_parked.load() && !_finished.load()) {
+            vTaskDelay(1);
+        }
+    }
+    i2s_stop(I2S_OUT_PORT);
+    esp_err_t result = i2s_set_clk(I2S_OUT_PORT, sample_rate, I2S_BITS_PER_SAMPLE_16BIT, I2S_CHANNEL_MONO);
+    if (result == ESP_OK) {
+        _sample_rate = sample_rate;
+        _feeder.setSampleRate(sample_rate);
+    } else {
+        Serial.println("Failed to set I2S TX clock");
+    }
+    i2s_zero_dma_buffer(I2S_OUT_PORT);
+    i2s_start(I2S_OUT_PORT);
+    if (parked) {
+        _pause.store(false);
+    }
+    return result == ESP_OK;
+}
+
+void AudioOutput::feederLoop() {
+    const size_t frames = _feeder.profile().dma_frames;
+    while (_running.load()) {
+        if (_pause.load()) {
+            _parked.store(true);
+            while (_pause.load() && _running.load()) {
+                vTaskDelay(1);
+            }
+            _parked.store(false);
+            continue;
+        }
+        _feeder.fill(_block, frames);
+        size_t written = 0;
+        i2s_write(I2S_OUT_PORT, _block, frames * sizeof(int16_t), &written, portMAX_DELAY);
+    }
+}
+
+void AudioOutput::feederEntry(void* arg) {
+    AudioOutput* self = static_cast<AudioOutput*>(arg);
+    self->feederLoop();
+    self->_finished.store(true);
+    vTaskDelete(NULL);
+}
+
+void AudioOutput::deinit() {
+    stop();
+    if (_initialized) {
+        i2s_driver_uninstall(I2S_OUT_PORT);
+        _initialized = false;
+    }
+    audioFree(_block);
+    _block = nullptr;
+    _feeder.deinit();
+}
+
+} // namespace audio_processing
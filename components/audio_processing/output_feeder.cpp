@@ -0,0 +1,189 @@
+#include "output_feeder.h"
+#include <cstring>
+
+namespace audio_processing {
+
+OutputProfile outputProfile(LatencyProfile profile) {
+    OutputProfile p;
+    switch (profile) {
+        case LatencyProfile::LOW_LATENCY:
+            p.dma_buffers = 3;
+            p.dma_frames = 128;
+            p.ring_samples = 2048;
+            p.start_samples = 256;
+            break;
+        case LatencyProfile::ROBUST:
+            p.dma_buffers = 8;
+            p.dma_frames = 512;
+            p.ring_samples = 16384;
+            p.start_samples = 4096;
+            break;
+        case LatencyProfile::BALANCED:
+        default:
+            p.dma_buffers = 4;
+            p.dma_frames = 256;
+            p.ring_samples = 8192;
+            p.start_samples = 1024;
+            break;
+    }
+    return p;
+}
+
+uint32_t outputLatencyUs(const OutputProfile& profile, int sample_rate) {
+    if (sample_rate <= 0) {
+        return 0;
+    }
+    uint64_t samples = (uint64_t)profile.dma_buffers * profile.dma_frames + profile.start_samples;
+    return (uint32_t)(samples * 1000000ull / (uint64_t)sample_rate);
+}
+
+OutputFeeder::OutputFeeder()
+    : _reference(nullptr), _reference_rate(0), _sample_rate(0), _tap_rate(0), _tap_step(0), _tap_pos(0),
+      _tap_prev(0), _playing(false), _rebuffering(false), _end_requested(false), _flush_requested(false) {
+    memset(&_profile, 0, sizeof(_profile));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+OutputFeeder::~OutputFeeder() {
+    deinit();
+}
+
+bool OutputFeeder::init(const OutputProfile& profile, MemoryRegion region) {
+    deinit();
+    if (profile.dma_frames == 0 || profile.ring_samples < profile.dma_frames) {
+        return false;
+    }
+    if (!_ring.init(profile.ring_samples, region)) {
+        return false;
+    }
+    _profile = profile;
+    // The threshold must be reachable with the ring full
+    if (_profile.start_samples > _ring.capacity()) {
+        _profile.start_samples = _ring.capacity();
+    }
+    _playing = false;
+    _rebuffering = false;
+    _end_requested.store(false);
+    _flush_requested.store(false);
+    _tap_rate = 0;
+    memset(&_stats, 0, sizeof(_stats));
+    return true;
+}
+
+void OutputFeeder::deinit() {
+    _ring.deinit();
+    _playing = false;
+    _rebuffering = false;
+}
+
+void OutputFeeder::setReference(PcmRing* reference, int reference_rate) {
+    _reference = reference;
+    _reference_rate = reference_rate;
+    _tap_rate = 0;
+}
+
+size_t OutputFeeder::fill(int16_t* block, size_t count) {
+    if (count == 0) {
+        return 0;
+    }
+    size_t n = fillBlock(block, count);
+    if (_reference != nullptr) {
+        tapReference(block, count);
+    }
+    return n;
+}
+
+void OutputFeeder::tapReference(const int16_t* block, size_t count) {
+    int rate = _sample_rate.load(std::memory_order_relaxed);
+    if (_reference_rate <= 0 || rate <= 0 || rate == _reference_rate) {
+        writeReference(block, count);
+        return;
+    }
+    if (rate != _tap_rate) {
+        // New clock: restart the interpolator from silence
+        _tap_rate = rate;
+        _tap_step = ((uint64_t)rate << 32) / (uint64_t)_reference_rate;
+        _tap_pos = 0;
+        _tap_prev = 0;
+    }
+
+    // Position 0 is the previous block's last sample, i is block[i - 1]
+    const uint64_t end = (uint64_t)count << 32;
+    size_t n = 0;
+    while (_tap_pos < end) {
+        size_t i = (size_t)(_tap_pos >> 32);
+        int32_t a = i == 0 ? _tap_prev : block[i - 1];
+        int32_t b = block[i];
+        int32_t frac = (int32_t)((_tap_pos >> 17) & 0x7FFF);
+        _tap_chunk[n++] = (int16_t)(a + (((b - a) * frac) >> 15));
+        _tap_pos += _tap_step;
+        if (n == TAP_CHUNK) {
+            writeReference(_tap_chunk, n);
+            n = 0;
+        }
+    }
+    writeReference(_tap_chunk, n);
+    _tap_pos -= end;
+    _tap_prev = block[count - 1];
+}
+
+void OutputFeeder::writeReference(const int16_t* samples, size_t count) {
+    size_t written = _reference->write(samples, count);
+    _stats.reference_dropped += count - written;
+}
+
+size_t OutputFeeder::fillBlock(int16_t* block, size_t count) {
+    _stats.blocks++;
+    if (_flush_requested.exchange(false, std::memory_order_acquire)) {
+        _ring.clear();
+        _end_requested.store(false, std::memory_order_relaxed);
+        _playing = false;
+        _rebuffering = false;
+        _stats.flushes++;
+    }
+
+    if (!_playing) {
+        // The end flag is read before the level: once it is seen, every
+        // sample of the stream is already in the ring
+        bool ending = _end_requested.load(std::memory_order_acquire);
+        size_t buffered = _ring.available();
+        if (buffered >= _profile.start_samples || (ending && buffered > 0)) {
+            if (!_rebuffering) {
+                _stats.streams++;
+            }
+            _playing = true;
+            _rebuffering = false;
+        } else {
+            if (ending && buffered == 0) {
+                _end_requested.store(false, std::memory_order_relaxed);
+                _rebuffering = false;
+            }
+            if (_rebuffering) {
+                _stats.underrun_samples += count;
+            }
+            memset(block, 0, count * sizeof(int16_t));
+            _stats.silence_samples += count;
+            return 0;
+        }
+    }
+
+    size_t n = _ring.read(block, count);
+    _stats.samples += n;
+    if (n == count) {
+        return n;
+    }
+
+    memset(block + n, 0, (count - n) * sizeof(int16_t));
+    _stats.silence_samples += count - n;
+    _playing = false;
+    if (_end_requested.load(std::memory_order_acquire) && _ring.available() == 0) {
+        _end_requested.store(false, std::memory_order_relaxed);
+    } else {
+        _rebuffering = true;
+        _stats.underruns++;
+        _stats.underrun_samples += count - n;
+    }
+    return n;
+}
+
+} // namespace audio_processing
@@ -0,0 +1,101 @@
+#include "pcm_ring.h"
+#include <cstring>
+
+namespace audio_processing {
+
+PcmRing::PcmRing()
+    : _buffer(nullptr), _capacity(0), _mask(0), _head(0), _tail(0), _written(0), _read(0) {}
+
+PcmRing::~PcmRing() {
+    deinit();
+}
+
+bool PcmRing::init(size_t capacity_samples, MemoryRegion region) {
+    deinit();
+    if (capacity_samples == 0) {
+        return false;
+    }
+    size_t capacity = 1;
+    while (capacity < capacity_samples) {
+        capacity <<= 1;
+    }
+    _buffer = static_cast<int16_t*>(audioAlloc(capacity * sizeof(int16_t), region));
+    if (_buffer == nullptr) {
+        AUDIO_LOGF("Failed to allocate PCM ring of %u samples\n", (unsigned)capacity);
+        return false;
+    }
+    _capacity = capacity;
+    _mask = capacity - 1;
+    _head.store(0);
+    _tail.store(0);
+    _written.store(0);
+    _read.store(0);
+    return true;
+}
+
+void PcmRing::deinit() {
+    audioFree(_buffer);
+    _buffer = nullptr;
+    _capacity = 0;
+    _mask = 0;
+    _head.store(0);
+    _tail.store(0);
+}
+
+size_t PcmRing::available() const {
+    return _head.load(std::memory_order_acquire) - _tail.load(std::memory_order_acquire);
+}
+
+size_t PcmRing::write(const int16_t* samples, size_t count) {
+    if (_buffer == nullptr) {
+        return 0;
+    }
+    const size_t head = _head.load(std::memory_order_relaxed);
+    const size_t tail = _tail.load(std::memory_order_acquire);
+    size_t n = _capacity - (head - tail);
+    if (n > count) {
+        n = count;
+    }
+    // At most two copies: up to the end of the storage, then from its start
+    size_t offset = head & _mask;
+    size_t first = _capacity - offset;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(_buffer + offset, samples, first * sizeof(int16_t));
+    memcpy(_buffer, samples + first, (n - first) * sizeof(int16_t));
+    _head.store(head + n, std::memory_order_release);
+    _written.fetch_add(n, std::memory_order_relaxed);
+    return n;
+}
+
+size_t PcmRing::read(int16_t* out, size_t count) {
+    if (_buffer == nullptr) {
+        return 0;
+    }
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    const size_t head = _head.load(std::memory_order_acquire);
+    size_t n = head - tail;
+    if (n > count) {
+        n = count;
+    }
+    size_t offset = tail & _mask;
+    size_t first = _capacity - offset;
+    if (first > n) {
+        first = n;
+    }
+    memcpy(out, _buffer + offset, first * sizeof(int16_t));
+    memcpy(out + first, _buffer, (n - first) * sizeof(int16_t));
+    _tail.store(tail + n, std::memory_order_release);
+    _read.fetch_add(n, std::memory_order_relaxed);
+    return n;
+}
+
+size_t PcmRing::clear() {
+    const size_t tail = _tail.load(std::memory_order_relaxed);
+    const size_t head = _head.load(std::memory_order_acquire);
+    _tail.store(head, std::memory_order_release);
+    return head - tail;
+}
+
+} // namespace audio_processing
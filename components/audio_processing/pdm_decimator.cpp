@@ -0,0 +1,269 @@
+#include "pdm_decimator.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+namespace audio_processing {
+
+PDMDecimator::PDMDecimator()
+    : _initialized(false), _decimation_factor(0), _bytes_per_sample(0),
+      _filter_bytes(0), _history_bytes(0), _table(nullptr), _history(nullptr),
+      _min_parallel_samples(64), _job_data(nullptr), _job_first(0), _job_last(0),
+      _job_output(nullptr), _job_pending(false), _job_done(false),
+      _worker_running(false), _worker_finished(true) {
+}
+
+PDMDecimator::~PDMDecimator() {
+    deinit();
+}
+
+bool PDMDecimator::init(int decimation_factor, int filter_taps, int worker_core) {
+    if (_initialized) {
+        deinit();
+    }
+    if (filter_taps == 0) {
+        filter_taps = 2 * decimation_factor;
+    }
+    if (decimation_factor <= 0 || decimation_factor % 8 != 0 ||
+        filter_taps <= 0 || filter_taps % 8 != 0) {
+        AUDIO_LOGF("Invalid PDM decimator config: decimation %d, taps %d\n",
+                   decimation_factor, filter_taps);
+        return false;
+    }
+
+    _decimation_factor = decimation_factor;
+    _bytes_per_sample = decimation_factor / 8;
+    _filter_bytes = filter_taps / 8;
+    _history_bytes = _filter_bytes > _bytes_per_sample ? _filter_bytes - _bytes_per_sample : 0;
+
+    _table = static_cast<int32_t*>(audioAlloc(_filter_bytes * 256 * sizeof(int32_t), MemoryRegion::INTERNAL));
+    _history = static_cast<uint8_t*>(audioAlloc(_history_bytes > 0 ? _history_bytes : 1, MemoryRegion::INTERNAL));
+    float* coeffs = static_cast<float*>(audioAlloc(filter_taps * sizeof(float), MemoryRegion::INTERNAL));
+    if (!_table || !_history || !coeffs) {
+        AUDIO_LOGF("Failed to allocate PDM decimator tables\n");
+        audioFree(coeffs);
+        _initialized = true;
+        deinit();
+        return false;
+    }
+
+    // Windowed-sinc lowpass at the output Nyquist frequency, unity DC gain
+    float cutoff = 0.5f / decimation_factor;
+    float center = (filter_taps - 1) / 2.0f;
+    float sum = 0.0f;
+    for (int i = 0; i < filter_taps; i++) {
+        float x = (float)M_PI * (i - center);
+        float h = (fabsf(x) < 1e-6f) ? 2.0f * cutoff : sinf(2.0f * cutoff * x) / x;
+        h *= 0.54f - 0.46f * cosf(2.0f * (float)M_PI * i / (filter_taps - 1));
+        coeffs[i] = h;
+        sum += h;
+    }
+
+    // Fold each 8-tap group into a table indexed by the PDM byte value
+    const float scale = 32767.0f * (float)(1 << COEFF_SHIFT) / sum;
+    for (size_t byte = 0; byte < _filter_bytes; byte++) {
+        int32_t quantized[8];
+        for (int bit = 0; bit < 8; bit++) {
+            quantized[bit] = (int32_t)lroundf(coeffs[byte * 8 + bit] * scale);
+        }
+        int32_t* row = &_table[byte * 256];
+        for (int value = 0; value < 256; value++) {
+            int32_t acc = 0;
+            for (int bit = 0; bit < 8; bit++) {
+                acc += (value & (1 << bit)) ? quantized[bit] : -quantized[bit];
+            }
+            row[value] = acc;
+        }
+    }
+    audioFree(coeffs);
+
+    memset(_history, 0, _history_bytes > 0 ? _history_bytes : 1);
+    _initialized = true;
+
+    if (!startWorker(worker_core)) {
+        deinit();
+        return false;
+    }
+    return true;
+}
+
+void PDMDecimator::deinit() {
+    if (!_initialized) {
+        return;
+    }
+    stopWorker();
+    audioFree(_table);
+    audioFree(_history);
+    _table = nullptr;
+    _history = nullptr;
+    _decimation_factor = 0;
+    _initialized = false;
+}
+
+void PDMDecimator::reset() {
+    if (_initialized && _history_bytes > 0) {
+        memset(_history, 0, _history_bytes);
+    }
+}
+
+void PDMDecimator::decodeRange(const uint8_t* pdm_data, size_t first, size_t last, int16_t* pcm_data) const {
+    const ptrdiff_t history = (ptrdiff_t)_history_bytes;
+    for (size_t n = first; n < last; n++) {
+        // Window of _filter_bytes ending at the last byte of sample n
+        ptrdiff_t start = (ptrdiff_t)((n + 1) * _bytes_per_sample) - (ptrdiff_t)_filter_bytes;
+        const int32_t* row = _table;
+        int32_t acc = 0;
+
+        size_t byte = 0;
+        for (; byte < _filter_bytes && start + (ptrdiff_t)byte < 0; byte++, row += 256) {
+            acc += row[_history[history + start + (ptrdiff_t)byte]];
+        }
+        const uint8_t* src = pdm_data + start + (ptrdiff_t)byte;
+        for (; byte < _filter_bytes; byte++, row += 256) {
+            acc += row[*src++];
+        }
+
+        acc >>= COEFF_SHIFT;
+        if (acc > 32767) acc = 32767;
+        if (acc < -32768) acc = -32768;
+        pcm_data[n] = (int16_t)acc;
+    }
+}
+
+void PDMDecimator::updateHistory(const uint8_t* pdm_data, size_t pdm_size) {
+    if (_history_bytes == 0) {
+        return;
+    }
+    if (pdm_size >= _history_bytes) {
+        memcpy(_history, pdm_data + pdm_size - _history_bytes, _history_bytes);
+    } else {
+        memmove(_history, _history + pdm_size, _history_bytes - pdm_size);
+        memcpy(_history + _history_bytes - pdm_size, pdm_data, pdm_size);
+    }
+}
+
+bool PDMDecimator::decode(const uint8_t* pdm_data, size_t pdm_size, int16_t* pcm_data, size_t* pcm_samples) {
+    if (!_initialized || !pdm_data || !pcm_data || !pcm_samples) {
+        return false;
+    }
+    size_t samples = pdm_size / _bytes_per_sample;
+    if (pdm_size % _bytes_per_sample != 0 || samples > *pcm_samples) {
+        return false;
+    }
+
+    decodeRange(pdm_data, 0, samples, pcm_data);
+    updateHistory(pdm_data, pdm_size);
+    *pcm_samples = samples;
+    return true;
+}
+
+bool PDMDecimator::decodeParallel(const uint8_t* pdm_data, size_t pdm_size, int16_t* pcm_data, size_t* pcm_samples) {
+    if (!_initialized || !pdm_data || !pcm_data || !pcm_samples) {
+        return false;
+    }
+    size_t samples = pdm_size / _bytes_per_sample;
+    if (pdm_size % _bytes_per_sample != 0 || samples > *pcm_samples) {
+        return false;
+    }
+    if (samples < _min_parallel_samples || !_worker_running.load()) {
+        return decode(pdm_data, pdm_size, pcm_data, pcm_samples);
+    }
+
+    // The second half reads the preceding _filter_bytes straight from the
+    // block, so both halves see exactly the input a serial pass would
+    size_t split = samples / 2;
+    {
+        std::lock_guard<std::mutex> lock(_job_mutex);
+        _job_data = pdm_data;
+        _job_first = split;
+        _job_last = samples;
+        _job_output = pcm_data;
+        _job_done = false;
+        _job_pending = true;
+    }
+    _job_cv.notify_all();
+
+    decodeRange(pdm_data, 0, split, pcm_data);
+
+    {
+        std::unique_lock<std::mutex> lock(_job_mutex);
+        _job_cv.wait(lock, [this] { return _job_done; });
+    }
+
+    updateHistory(pdm_data, pdm_size);
+    *pcm_samples = samples;
+    return true;
+}
+
+void PDMDecimator::workerLoop() {
+    while (true) {
+        std::unique_lock<std::mutex> lock(_job_mutex);
+        _job_cv.wait(lock, [this] { return _job_pending || !_worker_running.load(); });
+        if (!_worker_running.load()) {
+            break;
+        }
+        _job_pending = false;
+        lock.unlock();
+
+        decodeRange(_job_data, _job_first, _job_last, _job_output);
+
+        lock.lock();
+        _job_done = true;
+        lock.unlock();
+        _job_cv.notify_all();
+    }
+}
+
+void PDMDecimator::workerEntry(void* arg) {
+    PDMDecimator* self = static_cast<PDMDecimator*>(arg);
+    self->workerLoop();
+    self->_worker_finished.store(true);
+#ifdef ESP_PLATFORM
+    vTaskDelete(NULL);
+#endif
+}
+
+bool PDMDecimator::startWorker(int core) {
+    _worker_running.store(true);
+    _worker_finished.store(false);
+#ifdef ESP_PLATFORM
+    // Same priority as the caller so the two halves really run side by side
+    BaseType_t result = xTaskCreatePinnedToCore(workerEntry, "pdm_decimator", 3072, this,
+                                                uxTaskPriorityGet(NULL), NULL, core);
+    if (result != pdPASS) {
+        AUDIO_LOGF("Failed to create PDM decimator worker\n");
+        _worker_running.store(false);
+        _worker_finished.store(true);
+        return false;
+    }
+#else
+    (void)core;
+    _worker = std::thread(workerEntry, this);
+#endif
+    return true;
+}
+
+void PDMDecimator::stopWorker() {
+    {
+        std::lock_guard<std::mutex> lock(_job_mutex);
+        if (!_worker_running.exchange(false)) {
+            return;
+        }
+    }
+    _job_cv.notify_all();
+#ifdef ESP_PLATFORM
+    while (!_worker_finished.load()) {
+        vTaskDelay(1);
+    }
+#else
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+#endif
+}
+
+} // namespace audio_processing
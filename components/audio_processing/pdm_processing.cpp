@@ -3,6 +3,7 @@
 #include "dsps_fir.h"
 #include "dsps_conv.h"
 #include "dsp_platform.h"
+#include "dsp_budget.h"
 #include <math.h>
 #include "esp_heap_caps.h"
 #include <vector>
@@ -13,7 +14,7 @@ PDMProcessing::PDMProcessing()
     : _initialized(false), _sample_rate(0), _bit_depth(0),
       _fir_coeffs(nullptr), _delay_line(nullptr),
       _pdm_float_buffer(nullptr), _pcm_float_buffer(nullptr),
-      _filter_len(64), _decimation_factor(64) {
+      _filter_len(64), _decimation_factor(64), _decode_mode(PDMDecodeMode::CHUNKED) {
     memset(&_fir_filter, 0, sizeof(fir_f32_t));
 }
 
@@ -85,10 +86,35 @@ bool PDMProcessing::init(int sample_rate, int bit_depth) {
     }
     
     _initialized = true;
+
+    // Re-apply a decimator mode selected before init
+    if (_decode_mode != PDMDecodeMode::CHUNKED && !setDecodeMode(_decode_mode)) {
+        deinit();
+        return false;
+    }
+
     Serial.println("PDM Processing initialized successfully with ESP-DSP");
     return true;
 }
 
+bool PDMProcessing::setDecodeMode(PDMDecodeMode mode) {
+    _decode_mode = mode;
+    if (!_initialized || mode == PDMDecodeMode::CHUNKED) {
+        return true;
+    }
+
+    // Helper task goes on the core the caller is not running on
+    int worker_core = (xPortGetCoreID() == 0) ? 1 : 0;
+    if (_decimator.decimationFactor() != _decimation_factor &&
+        !_decimator.init(_decimation_factor, 0, worker_core)) {
+        Serial.println("Failed to initialize PDM decimator");
+        _decode_mode = PDMDecodeMode::CHUNKED;
+        return false;
+    }
+    _decimator.reset();
+    return true;
+}
+
 void PDMProcessing::pdmBitsToFloat(const uint8_t* pdm_data, unsigned int pdm_size, float* float_buffer) {
     for (unsigned int i = 0; i < pdm_size; i++) {
         uint8_t byte = pdm_data[i];
@@ -117,6 +143,19 @@ bool PDMProcessing::convertPDMtoPCM(const uint8_t* pdm_data, unsigned int pdm_si
         return false;
     }
 
+    if (_decode_mode != PDMDecodeMode::CHUNKED) {
+        size_t samples = *pcm_samples;
+        bool ok = (_decode_mode == PDMDecodeMode::DECIMATOR_PARALLEL) ?
+            _decimator.decodeParallel(pdm_data, pdm_size, pcm_data, &samples) :
+            _decimator.decode(pdm_data, pdm_size, pcm_data, &samples);
+        if (!ok) {
+            Serial.println("PDM decimation failed.");
+            return false;
+        }
+        *pcm_samples = samples;
+        return true;
+    }
+
     Serial.printf("Converting PDM to PCM. PDM size: %d\n", pdm_size);
 
     const unsigned int CHUNK_SIZE = 256;
@@ -177,7 +216,7 @@ bool PDMProcessing::convertPDMtoPCM(const uint8_t* pdm_data, unsigned int pdm_si
         total_samples += chunk_samples;
         
         free(int_buffer);
-        yield();
+        dsp_budget_poll();
     }
     
     *pcm_samples = total_samples;
@@ -197,8 +236,10 @@ bool PDMProcessing::convertPDMtoWAV(const uint8_t* pdm_data, unsigned int pdm_si
     }
 
     // Convert PDM to PCM first
-    std::vector<int16_t> pcm_data(pdm_size / _decimation_factor);
-    unsigned int pcm_samples = 0;
+    unsigned int expected_samples = (_decode_mode == PDMDecodeMode::CHUNKED) ?
+        pdm_size / _decimation_factor : pdm_size * 8 / _decimation_factor;
+    std::vector<int16_t> pcm_data(expected_samples);
+    unsigned int pcm_samples = expected_samples;
     if (!convertPDMtoPCM(pdm_data, pdm_size, pcm_data.data(), &pcm_samples)) {
         Serial.println("Failed to convert PDM to PCM.");
         return false;
@@ -302,6 +343,7 @@ void PDMProcessing::deinit() {
         
         // Stop any ongoing processing first
         _initialized = false;
+        _decimator.deinit();
         
         // Add delay to ensure no ongoing operations
         delay(100);
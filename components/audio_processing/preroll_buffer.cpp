@@ -0,0 +1,154 @@
+#include "preroll_buffer.h"
+#include <new>
+
+namespace audio_processing {
+
+PreRollBuffer::PreRollBuffer()
+    : _ring(nullptr), _capacity(0), _head(0), _count(0), _live(nullptr), _evicted(0) {
+}
+
+PreRollBuffer::~PreRollBuffer() {
+    deinit();
+}
+
+size_t PreRollBuffer::framesFor(uint32_t duration_ms, int sample_rate, size_t frame_samples) {
+    if (sample_rate <= 0 || frame_samples == 0) {
+        return 0;
+    }
+    uint64_t samples = (uint64_t)duration_ms * (uint64_t)sample_rate / 1000;
+    return (size_t)((samples + frame_samples - 1) / frame_samples);
+}
+
+bool PreRollBuffer::init(size_t frame_count) {
+    deinit();
+    if (frame_count == 0) {
+        return false;
+    }
+
+    _ring = static_cast<FrameRef*>(audioAlloc(frame_count * sizeof(FrameRef), MemoryRegion::INTERNAL));
+    if (_ring == nullptr) {
+        AUDIO_LOGF("Failed to allocate pre-roll ring of %u frames\n", (unsigned)frame_count);
+        return false;
+    }
+    for (size_t i = 0; i < frame_count; i++) {
+        new (&_ring[i]) FrameRef();
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    _capacity = frame_count;
+    _head = 0;
+    _count = 0;
+    _live = nullptr;
+    _evicted = 0;
+    return true;
+}
+
+void PreRollBuffer::deinit() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ring == nullptr) {
+        return;
+    }
+    for (size_t i = 0; i < _capacity; i++) {
+        _ring[i].~FrameRef();
+    }
+    audioFree(_ring);
+    _ring = nullptr;
+    _capacity = 0;
+    _head = 0;
+    _count = 0;
+    _live = nullptr;
+}
+
+void PreRollBuffer::push(const FrameRef& frame) {
+    if (!frame) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_live != nullptr) {
+        _live->publish(frame);
+        return;
+    }
+    if (_capacity == 0) {
+        return;
+    }
+
+    size_t tail = (_head + _count) % _capacity;
+    if (_count == _capacity) {
+        // Overwriting the oldest slot drops its reference
+        _head = (_head + 1) % _capacity;
+        _evicted++;
+    } else {
+        _count++;
+    }
+    _ring[tail] = frame;
+}
+
+size_t PreRollBuffer::trigger(FrameFanout& fanout) {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t published = _count;
+    for (size_t i = 0; i < _count; i++) {
+        FrameRef& slot = _ring[(_head + i) % _capacity];
+        fanout.publish(slot);
+        slot.reset();
+    }
+    _head = 0;
+    _count = 0;
+    _live = &fanout;
+    return published;
+}
+
+void PreRollBuffer::stopLive() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    _live = nullptr;
+}
+
+size_t PreRollBuffer::takeHistory(FrameRef* frames, size_t max_frames) {
+    if (frames == nullptr) {
+        return 0;
+    }
+
+    std::lock_guard<std::mutex> lock(_mutex);
+    // Keep the newest frames so the history stays adjacent to live audio
+    size_t skip = _count > max_frames ? _count - max_frames : 0;
+    size_t taken = 0;
+    for (size_t i = skip; i < _count; i++) {
+        frames[taken++] = std::move(_ring[(_head + i) % _capacity]);
+    }
+    clearLocked();
+    return taken;
+}
+
+void PreRollBuffer::clear() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    clearLocked();
+}
+
+void PreRollBuffer::clearLocked() {
+    for (size_t i = 0; i < _count; i++) {
+        _ring[(_head + i) % _capacity].reset();
+    }
+    _head = 0;
+    _count = 0;
+}
+
+bool PreRollBuffer::isLive() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _live != nullptr;
+}
+
+size_t PreRollBuffer::size() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    return _count;
+}
+
+size_t PreRollBuffer::historySamples() const {
+    std::lock_guard<std::mutex> lock(_mutex);
+    size_t samples = 0;
+    for (size_t i = 0; i < _count; i++) {
+        samples += _ring[(_head + i) % _capacity].size();
+    }
+    return samples;
+}
+
+} // namespace audio_processing
@@ -1,7 +1,9 @@
 #include "../library/bluetooth_manager.h"
+#include "feature_stream.h"
 
 BluetoothManager::BluetoothManager() 
-    : _initialized(false), _streaming(false), _dataCallback(nullptr), _connectionCallback(nullptr) {
+    : _initialized(false), _streaming(false), _featureEncoder(nullptr), _dataCallback(nullptr),
+      _connectionCallback(nullptr) {
 }
 
 BluetoothManager::~BluetoothManager() {
@@ -44,6 +46,7 @@ void BluetoothManager::deinit() {
         _serialBT.end();
         _initialized = false;
         _streaming = false;
+        _featureEncoder = nullptr;
     }
 }
 
@@ -114,6 +117,30 @@ bool BluetoothManager::sendAudioData(const int16_t* audioData, size_t samples) {
     return sendData((const uint8_t*)audioData, samples * sizeof(int16_t));
 }
 
+bool BluetoothManager::startFeatureStream(FeatureStreamEncoder& encoder) {
+    if (!isConnected() || _streaming || _featureEncoder != nullptr) {
+        return false;
+    }
+    
+    // The encoder's CONFIG packet describes the stream, no text command needed
+    if (!encoder.begin([this](const uint8_t* data, size_t length) { return sendData(data, length); })) {
+        return false;
+    }
+    
+    _featureEncoder = &encoder;
+    return true;
+}
+
+bool BluetoothManager::stopFeatureStream() {
+    if (_featureEncoder == nullptr) {
+        return false;
+    }
+    
+    bool sent = _featureEncoder->end();
+    _featureEncoder = nullptr;
+    return sent;
+}
+
 void BluetoothManager::update() {
     if (!_initialized) {
         return;
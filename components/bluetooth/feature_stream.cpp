@@ -0,0 +1,294 @@
+#include "feature_stream.h"
+#include <math.h>
+#include <string.h>
+
+using audio_processing::FrameRef;
+
+uint16_t featureCrc16(const uint8_t* data, size_t length, uint16_t crc) {
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+FeatureStreamConfig defaultFeatureStreamConfig() {
+    FeatureStreamConfig config;
+    config.min_value = -24.0f;
+    config.max_value = 8.0f;
+    config.frames_per_packet = 4;
+    return config;
+}
+
+static void putU16(uint8_t* p, uint16_t v) {
+    p[0] = (uint8_t)v;
+    p[1] = (uint8_t)(v >> 8);
+}
+
+static void putU32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+static uint16_t getU16(const uint8_t* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t getU32(const uint8_t* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static void putF32(uint8_t* p, float v) {
+    uint32_t bits;
+    memcpy(&bits, &v, sizeof(bits));
+    putU32(p, bits);
+}
+
+static float getF32(const uint8_t* p) {
+    uint32_t bits = getU32(p);
+    float v;
+    memcpy(&v, &bits, sizeof(v));
+    return v;
+}
+
+FeatureStreamEncoder::FeatureStreamEncoder(const LogMelConfig& mel, const FeatureStreamConfig& config)
+    : mel_(mel), config_(config), frontend_(mel), frame_index_(0), first_frame_(0), pending_(0), seq_(0),
+      streaming_(false) {
+    size_t max_frames = (FEATURE_MAX_PAYLOAD - 4) / frontend_.melBins();
+    if (config_.frames_per_packet == 0) {
+        config_.frames_per_packet = 1;
+    }
+    if (config_.frames_per_packet > max_frames) {
+        config_.frames_per_packet = (uint8_t)max_frames;
+    }
+    // 256 levels over the range, zero at its middle
+    scale_ = (config_.max_value - config_.min_value) / 255.0f;
+    offset_ = config_.min_value + 128.0f * scale_;
+    packet_.resize(FEATURE_HEADER_BYTES + 4 + (size_t)config_.frames_per_packet * frontend_.melBins() +
+                   FEATURE_CRC_BYTES);
+    on_frame_ = [this](const float* features) {
+        pushFrame(features);
+    };
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+void FeatureStreamEncoder::sendPacket(FeaturePacketType type, size_t payload) {
+    uint8_t* p = packet_.data();
+    p[0] = FEATURE_SYNC_0;
+    p[1] = FEATURE_SYNC_1;
+    p[2] = (uint8_t)type;
+    p[3] = seq_++;
+    putU16(p + 4, (uint16_t)payload);
+    putU16(p + FEATURE_HEADER_BYTES + payload, featureCrc16(p + 2, FEATURE_HEADER_BYTES - 2 + payload));
+    size_t length = FEATURE_HEADER_BYTES + payload + FEATURE_CRC_BYTES;
+    if (write_ && write_(p, length)) {
+        stats_.bytes += length;
+    } else {
+        stats_.write_failures++;
+    }
+    stats_.packets++;
+}
+
+bool FeatureStreamEncoder::begin(WriteFunction write) {
+    write_ = write;
+    frontend_.reset();
+    frame_index_ = 0;
+    first_frame_ = 0;
+    pending_ = 0;
+    seq_ = 0;
+    streaming_ = true;
+
+    uint8_t* c = packet_.data() + FEATURE_HEADER_BYTES;
+    putU16(c, (uint16_t)mel_.sample_rate);
+    c[2] = (uint8_t)mel_.window_ms;
+    c[3] = (uint8_t)mel_.hop_ms;
+    c[4] = (uint8_t)frontend_.melBins();
+    c[5] = config_.frames_per_packet;
+    putF32(c + 6, scale_);
+    putF32(c + 10, offset_);
+    uint32_t failures = stats_.write_failures;
+    sendPacket(FeaturePacketType::CONFIG, FEATURE_CONFIG_BYTES);
+    return stats_.write_failures == failures;
+}
+
+size_t FeatureStreamEncoder::feed(const int16_t* samples, size_t count) {
+    if (!streaming_) {
+        return 0;
+    }
+    return frontend_.feed(samples, count, on_frame_);
+}
+
+void FeatureStreamEncoder::pushFrame(const float* features) {
+    if (!streaming_) {
+        return;
+    }
+    const int bins = frontend_.melBins();
+    if (pending_ == 0) {
+        first_frame_ = frame_index_;
+    }
+    int8_t* q = reinterpret_cast<int8_t*>(packet_.data() + FEATURE_HEADER_BYTES + 4 + (size_t)pending_ * bins);
+    const float inv = 1.0f / scale_;
+    for (int i = 0; i < bins; i++) {
+        float level = roundf((features[i] - offset_) * inv);
+        if (level < -128.0f || level > 127.0f) {
+            stats_.clipped++;
+            level = level < -128.0f ? -128.0f : 127.0f;
+        }
+        q[i] = (int8_t)level;
+    }
+    frame_index_++;
+    stats_.frames++;
+    if (++pending_ == config_.frames_per_packet) {
+        putU32(packet_.data() + FEATURE_HEADER_BYTES, first_frame_);
+        sendPacket(FeaturePacketType::FEATURES, 4 + (size_t)pending_ * bins);
+        pending_ = 0;
+    }
+}
+
+bool FeatureStreamEncoder::end() {
+    if (!streaming_) {
+        return false;
+    }
+    frontend_.flush(on_frame_);
+    if (pending_ > 0) {
+        putU32(packet_.data() + FEATURE_HEADER_BYTES, first_frame_);
+        sendPacket(FeaturePacketType::FEATURES, 4 + (size_t)pending_ * frontend_.melBins());
+        pending_ = 0;
+    }
+    putU32(packet_.data() + FEATURE_HEADER_BYTES, frame_index_);
+    uint32_t failures = stats_.write_failures;
+    sendPacket(FeaturePacketType::END, 4);
+    streaming_ = false;
+    return stats_.write_failures == failures;
+}
+
+audio_processing::PipelineRuntime::StageFunction FeatureStreamEncoder::stageFunction() {
+    return [this](FrameRef& frame) {
+        feed(frame.data(), frame.size());
+        return true;
+    };
+}
+
+FeatureStreamReceiver::FeatureStreamReceiver()
+    : start_(0), has_config_(false), has_seq_(false), next_seq_(0), next_frame_(0) {
+    memset(&info_, 0, sizeof(info_));
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+void FeatureStreamReceiver::push(const uint8_t* data, size_t length) {
+    buffer_.insert(buffer_.end(), data, data + length);
+    while (parse()) {
+    }
+    // Drop what has been consumed once it dominates the buffer
+    if (start_ > 0 && start_ * 2 >= buffer_.size()) {
+        buffer_.erase(buffer_.begin(), buffer_.begin() + start_);
+        start_ = 0;
+    }
+}
+
+// One step over the buffer: a packet, a skipped byte, or false for more input
+bool FeatureStreamReceiver::parse() {
+    const size_t available = buffer_.size() - start_;
+    const uint8_t* p = buffer_.data() + start_;
+    if (available < 2) {
+        return false;
+    }
+    if (p[0] != FEATURE_SYNC_0 || p[1] != FEATURE_SYNC_1) {
+        start_++;
+        stats_.skipped_bytes++;
+        return true;
+    }
+    if (available < FEATURE_HEADER_BYTES) {
+        return false;
+    }
+    uint8_t type = p[2];
+    size_t payload = getU16(p + 4);
+    if (type < (uint8_t)FeaturePacketType::CONFIG || type > (uint8_t)FeaturePacketType::END ||
+        payload > FEATURE_MAX_PAYLOAD) {
+        start_++;                       // Sync bytes inside data; keep looking
+        stats_.skipped_bytes++;
+        return true;
+    }
+    size_t total = FEATURE_HEADER_BYTES + payload + FEATURE_CRC_BYTES;
+    if (available < total) {
+        return false;
+    }
+    if (featureCrc16(p + 2, FEATURE_HEADER_BYTES - 2 + payload) != getU16(p + FEATURE_HEADER_BYTES + payload)) {
+        stats_.crc_errors++;
+        start_++;
+        stats_.skipped_bytes++;
+        return true;
+    }
+
+    uint8_t seq = p[3];
+    if (has_seq_ && type != (uint8_t)FeaturePacketType::CONFIG && seq != next_seq_) {
+        stats_.lost_packets += (uint8_t)(seq - next_seq_);
+    }
+    has_seq_ = true;
+    next_seq_ = (uint8_t)(seq + 1);
+    stats_.packets++;
+    start_ += total;
+    handlePacket((FeaturePacketType)type, p + FEATURE_HEADER_BYTES, payload);
+    return true;
+}
+
+void FeatureStreamReceiver::handlePacket(FeaturePacketType type, const uint8_t* payload, size_t length) {
+    switch (type) {
+        case FeaturePacketType::CONFIG:
+            if (length < FEATURE_CONFIG_BYTES || payload[4] == 0) {
+                return;
+            }
+            info_.sample_rate = getU16(payload);
+            info_.window_ms = payload[2];
+            info_.hop_ms = payload[3];
+            info_.mel_bins = payload[4];
+            info_.frames_per_packet = payload[5];
+            info_.scale = getF32(payload + 6);
+            info_.offset = getF32(payload + 10);
+            has_config_ = true;
+            next_frame_ = 0;
+            features_.assign(info_.mel_bins, 0.0f);
+            if (config_) {
+                config_(info_);
+            }
+            break;
+
+        case FeaturePacketType::FEATURES: {
+            if (!has_config_ || length < 4 || (length - 4) % info_.mel_bins != 0) {
+                return;
+            }
+            uint32_t index = getU32(payload);
+            if (index > next_frame_) {
+                stats_.lost_frames += index - next_frame_;
+            }
+            const int8_t* q = reinterpret_cast<const int8_t*>(payload + 4);
+            size_t frames = (length - 4) / info_.mel_bins;
+            for (size_t f = 0; f < frames; f++, q += info_.mel_bins) {
+                for (int i = 0; i < info_.mel_bins; i++) {
+                    features_[i] = info_.offset + info_.scale * q[i];
+                }
+                stats_.frames++;
+                if (frame_) {
+                    frame_(index + (uint32_t)f, features_.data());
+                }
+            }
+            next_frame_ = index + (uint32_t)frames;
+            break;
+        }
+
+        case FeaturePacketType::END:
+            if (length >= 4) {
+                uint32_t frames = getU32(payload);
+                if (frames > next_frame_) {
+                    stats_.lost_frames += frames - next_frame_;
+                }
+                if (end_) {
+                    end_(frames);
+                }
+            }
+            break;
+    }
+}
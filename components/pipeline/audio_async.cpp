@@ -0,0 +1,496 @@
+#include "audio_async.h"
+
+#if defined(__cpp_impl_coroutine)
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#endif
+
+namespace audio_processing {
+
+static thread_local Executor* t_current_executor = nullptr;
+
+// ---------------------------------------------------------------------------
+// Executor
+// ---------------------------------------------------------------------------
+
+Executor::Executor()
+    : _ready_head(0), _ready_count(0), _reserved(0), _timer_count(0), _live_tasks(0),
+      _wakeups(0), _stop(false)
+#ifdef ESP_PLATFORM
+      , _task(nullptr)
+#else
+      , _notified(false)
+#endif
+{
+}
+
+Executor::~Executor() {
+    // Destroy coroutines that never finished
+    while (_ready_count > 0) {
+        std::coroutine_handle<> handle = _ready[_ready_head];
+        _ready_head = (_ready_head + 1) % MAX_READY;
+        _ready_count--;
+        if (handle) {
+            handle.destroy();
+        }
+    }
+    for (size_t i = 0; i < _timer_count; i++) {
+        _timers[i].handle.destroy();
+    }
+}
+
+Executor* Executor::current() {
+    return t_current_executor;
+}
+
+bool Executor::spawn(Task task) {
+    std::coroutine_handle<> handle = task.release();
+    if (!handle) {
+        return false;
+    }
+    _live_tasks.fetch_add(1);
+    if (!post(handle)) {
+        handle.destroy();
+        _live_tasks.fetch_sub(1);
+        return false;
+    }
+    return true;
+}
+
+bool Executor::post(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_ready_count + _reserved >= MAX_READY) {
+            AUDIO_LOGF("Executor ready queue full\n");
+            return false;
+        }
+        enqueueLocked(handle);
+    }
+    notify();
+    return true;
+}
+
+bool Executor::reserve() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    if (_ready_count + _reserved >= MAX_READY) {
+        AUDIO_LOGF("Executor ready queue full, cannot suspend\n");
+        return false;
+    }
+    _reserved++;
+    return true;
+}
+
+void Executor::postReserved(std::coroutine_handle<> handle) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _reserved--;
+        enqueueLocked(handle);
+    }
+    notify();
+}
+
+void Executor::enqueueLocked(std::coroutine_handle<> handle) {
+    _ready[(_ready_head + _ready_count) % MAX_READY] = handle;
+    _ready_count++;
+#ifndef ESP_PLATFORM
+    _notified = true;
+#endif
+}
+
+void Executor::notify() {
+#ifdef ESP_PLATFORM
+    if (_task != nullptr) {
+        xTaskNotifyGive((TaskHandle_t)_task);
+    }
+#else
+    _wake.notify_one();
+#endif
+}
+
+bool Executor::addTimer(std::coroutine_handle<> handle, uint64_t deadline_us) {
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_timer_count == MAX_TIMERS) {
+            return false;
+        }
+        _timers[_timer_count].handle = handle;
+        _timers[_timer_count].deadline_us = deadline_us;
+        _timer_count++;
+    }
+    return true;
+}
+
+bool Executor::SleepAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    // Resume immediately if the timer table is full
+    return executor->addTimer(handle, audioMicros() + (uint64_t)ms * 1000);
+}
+
+uint64_t Executor::fireTimers() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    uint64_t now = audioMicros();
+    uint64_t next = 0;
+    size_t i = 0;
+    while (i < _timer_count) {
+        if (_timers[i].deadline_us <= now && _ready_count + _reserved < MAX_READY) {
+            _ready[(_ready_head + _ready_count) % MAX_READY] = _timers[i].handle;
+            _ready_count++;
+            _timers[i] = _timers[--_timer_count];
+            continue;
+        }
+        if (next == 0 || _timers[i].deadline_us < next) {
+            next = _timers[i].deadline_us;
+        }
+        i++;
+    }
+    return next;
+}
+
+void Executor::resume(std::coroutine_handle<> handle) {
+    handle.resume();
+    if (handle.done()) {
+        handle.destroy();
+        _live_tasks.fetch_sub(1);
+    }
+}
+
+int Executor::runOnce() {
+    Executor* previous = t_current_executor;
+    t_current_executor = this;
+
+    fireTimers();
+    int resumed = 0;
+    while (true) {
+        std::coroutine_handle<> handle;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            if (_ready_count == 0) {
+                break;
+            }
+            handle = _ready[_ready_head];
+            _ready_head = (_ready_head + 1) % MAX_READY;
+            _ready_count--;
+        }
+        resume(handle);
+        resumed++;
+    }
+
+    t_current_executor = previous;
+    return resumed;
+}
+
+void Executor::waitForWork(uint64_t next_deadline_us) {
+#ifdef ESP_PLATFORM
+    TickType_t ticks = portMAX_DELAY;
+    if (next_deadline_us > 0) {
+        uint64_t now = audioMicros();
+        uint64_t wait_ms = next_deadline_us > now ? (next_deadline_us - now + 999) / 1000 : 0;
+        ticks = pdMS_TO_TICKS(wait_ms);
+    }
+    // Notifications latch, so a post() that raced with this call is not lost
+    ulTaskNotifyTake(pdTRUE, ticks);
+#else
+    std::unique_lock<std::mutex> lock(_mutex);
+    if (next_deadline_us > 0) {
+        uint64_t now = audioMicros();
+        uint64_t wait_us = next_deadline_us > now ? next_deadline_us - now : 0;
+        _wake.wait_for(lock, std::chrono::microseconds(wait_us),
+                       [this] { return _notified || _stop.load(); });
+    } else {
+        _wake.wait(lock, [this] { return _notified || _stop.load(); });
+    }
+    _notified = false;
+#endif
+    _wakeups.fetch_add(1);
+}
+
+void Executor::run() {
+#ifdef ESP_PLATFORM
+    _task = xTaskGetCurrentTaskHandle();
+#endif
+    _stop.store(false);
+    while (!_stop.load()) {
+        runOnce();
+
+        uint64_t next_deadline = fireTimers();
+        bool idle;
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            idle = (_ready_count == 0);
+        }
+        if (idle && !_stop.load()) {
+            waitForWork(next_deadline);
+        }
+    }
+}
+
+void Executor::stop() {
+    _stop.store(true);
+#ifdef ESP_PLATFORM
+    if (_task != nullptr) {
+        xTaskNotifyGive((TaskHandle_t)_task);
+    }
+#else
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _notified = true;
+    }
+    _wake.notify_one();
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// FrameChannel
+// ---------------------------------------------------------------------------
+
+FrameChannel::FrameChannel()
+    : _head(0), _count(0), _closed(false), _dropped(0),
+      _waiter(nullptr), _waiter_executor(nullptr) {
+}
+
+FrameChannel::~FrameChannel() {
+    std::lock_guard<std::mutex> lock(_mutex);
+    for (int i = 0; i < MAX_QUEUED; i++) {
+        _queue[i].reset();
+    }
+}
+
+bool FrameChannel::popLocked(FrameRef& frame) {
+    if (_count == 0) {
+        return false;
+    }
+    frame = std::move(_queue[_head]);
+    _head = (_head + 1) % MAX_QUEUED;
+    _count--;
+    return true;
+}
+
+void FrameChannel::push(FrameRef frame) {
+    std::coroutine_handle<> handle;
+    Executor* executor = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        if (_closed) {
+            return;
+        }
+        if (_waiter != nullptr) {
+            // Hand the frame straight to the suspended coroutine
+            _waiter->frame = std::move(frame);
+            handle = _waiter_handle;
+            executor = _waiter_executor;
+            _waiter = nullptr;
+        } else {
+            if (_count == MAX_QUEUED) {
+                FrameRef oldest;
+                popLocked(oldest);
+                _dropped++;
+            }
+            _queue[(_head + _count) % MAX_QUEUED] = std::move(frame);
+            _count++;
+        }
+    }
+    if (executor != nullptr) {
+        executor->postReserved(handle);
+    }
+}
+
+void FrameChannel::close() {
+    std::coroutine_handle<> handle;
+    Executor* executor = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _closed = true;
+        if (_waiter != nullptr) {
+            handle = _waiter_handle;
+            executor = _waiter_executor;
+            _waiter = nullptr;
+        }
+    }
+    if (executor != nullptr) {
+        executor->postReserved(handle);
+    }
+}
+
+bool FrameChannel::NextAwaiter::await_ready() {
+    std::lock_guard<std::mutex> lock(channel->_mutex);
+    return channel->popLocked(frame) || channel->_closed;
+}
+
+bool FrameChannel::NextAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    std::lock_guard<std::mutex> lock(channel->_mutex);
+    Executor* executor = Executor::current();
+    if (channel->popLocked(frame) || channel->_closed || executor == nullptr) {
+        return false;
+    }
+    // Single consumer: a second waiter would orphan the first, so it
+    // completes at once with an empty frame
+    if (channel->_waiter != nullptr) {
+        AUDIO_LOGF("FrameChannel: second consumer awaiting nextFrame()\n");
+        return false;
+    }
+    // Without a slot for the wake-up, complete as if the channel closed
+    if (!executor->reserve()) {
+        return false;
+    }
+    channel->_waiter = this;
+    channel->_waiter_handle = handle;
+    channel->_waiter_executor = executor;
+    return true;
+}
+
+// ---------------------------------------------------------------------------
+// AsyncSink
+// ---------------------------------------------------------------------------
+
+AsyncSink::AsyncSink() : _head(0), _count(0), _running(false), _finished(true) {
+}
+
+AsyncSink::~AsyncSink() {
+    end();
+}
+
+bool AsyncSink::begin(const char* name, WriteFunction write, int core, int priority) {
+    if (_running.load() || !write) {
+        return false;
+    }
+    _write = write;
+    _running.store(true);
+    _finished.store(false);
+#ifdef ESP_PLATFORM
+    if (xTaskCreatePinnedToCore(workerEntry, name, 4096, this, priority, NULL, core) != pdPASS) {
+        AUDIO_LOGF("Failed to create sink worker %s\n", name);
+        _running.store(false);
+        _finished.store(true);
+        return false;
+    }
+#else
+    (void)name;
+    (void)core;
+    (void)priority;
+    _worker = std::thread(workerEntry, this);
+#endif
+    return true;
+}
+
+void AsyncSink::end() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+    _job_ready.notify_all();
+#ifdef ESP_PLATFORM
+    while (!_finished.load()) {
+        vTaskDelay(1);
+    }
+#else
+    if (_worker.joinable()) {
+        _worker.join();
+    }
+#endif
+
+    // Fail whatever is still queued so no coroutine stays suspended forever
+    std::unique_lock<std::mutex> lock(_mutex);
+    while (_count > 0) {
+        Job job = _jobs[_head];
+        _head = (_head + 1) % MAX_JOBS;
+        _count--;
+        job.awaiter->result = false;
+        lock.unlock();
+        job.executor->postReserved(job.handle);
+        lock.lock();
+    }
+}
+
+bool AsyncSink::WriteAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    Executor* executor = Executor::current();
+    {
+        std::lock_guard<std::mutex> lock(sink->_mutex);
+        if (!sink->_running.load() || sink->_count == MAX_JOBS || executor == nullptr ||
+            !executor->reserve()) {
+            result = false;
+            return false;
+        }
+        Job& job = sink->_jobs[(sink->_head + sink->_count) % MAX_JOBS];
+        job.awaiter = this;
+        job.handle = handle;
+        job.executor = executor;
+        sink->_count++;
+    }
+    sink->_job_ready.notify_one();
+    return true;
+}
+
+void AsyncSink::workerLoop() {
+    while (true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _job_ready.wait(lock, [this] { return _count > 0 || !_running.load(); });
+            if (!_running.load()) {
+                break;
+            }
+            job = _jobs[_head];
+            _head = (_head + 1) % MAX_JOBS;
+            _count--;
+        }
+
+        job.awaiter->result = _write(job.awaiter->frame);
+        job.executor->postReserved(job.handle);
+    }
+}
+
+void AsyncSink::workerEntry(void* arg) {
+    AsyncSink* self = static_cast<AsyncSink*>(arg);
+    self->workerLoop();
+    self->_finished.store(true);
+#ifdef ESP_PLATFORM
+    vTaskDelete(NULL);
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// AsyncEvent
+// ---------------------------------------------------------------------------
+
+AsyncEvent::AsyncEvent() : _set(false), _waiter_count(0) {
+}
+
+void AsyncEvent::set() {
+    Waiter waiters[MAX_WAITERS];
+    size_t count;
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _set.store(true);
+        count = _waiter_count;
+        for (size_t i = 0; i < count; i++) {
+            waiters[i] = _waiters[i];
+        }
+        _waiter_count = 0;
+    }
+    for (size_t i = 0; i < count; i++) {
+        waiters[i].executor->postReserved(waiters[i].handle);
+    }
+}
+
+void AsyncEvent::reset() {
+    _set.store(false);
+}
+
+bool AsyncEvent::WaitAwaiter::await_suspend(std::coroutine_handle<> handle) {
+    Executor* executor = Executor::current();
+    std::lock_guard<std::mutex> lock(event->_mutex);
+    if (event->_set.load() || executor == nullptr || event->_waiter_count == MAX_WAITERS ||
+        !executor->reserve()) {
+        return false;
+    }
+    event->_waiters[event->_waiter_count].handle = handle;
+    event->_waiters[event->_waiter_count].executor = executor;
+    event->_waiter_count++;
+    return true;
+}
+
+} // namespace audio_processing
+
+#endif // __cpp_impl_coroutine
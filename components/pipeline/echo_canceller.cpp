@@ -0,0 +1,490 @@
+#include "echo_canceller.h"
+#include <math.h>
+#include <string.h>
+
+namespace audio_processing {
+
+// Double-talk floor rise per block: x2 in ~35 blocks, so a changed echo
+// path, which looks like endless double talk, is re-learned after about a
+// second. The floor stops at 20 dB of cancellation; below that, residual
+// fluctuations would read as talk.
+static const float RATIO_FLOOR_RISE = 1.02f;
+static const float RATIO_FLOOR_MIN = 0.01f;
+// Error this much stronger than the microphone for this many blocks in a
+// row means the filter diverged; single blocks happen at far-end pauses
+static const float DIVERGENCE_RATIO = 4.0f;
+static const uint32_t DIVERGENCE_BLOCKS = 50;
+static const float ERLE_SMOOTHING = 0.05f;
+
+// Bulk delay search
+static const int DELAY_BANDS = 32;
+static const float DELAY_LOW_HZ = 250.0f;
+static const float DELAY_HIGH_HZ = 4000.0f;
+static const float BAND_MEAN_SMOOTHING = 0.05f;
+static const float DELAY_SMOOTHING = 0.05f;
+static const float DELAY_MATCH_RATIO = 0.75f;    // Best distance vs mean distance over all delays
+static const uint32_t DELAY_CONFIRM_BLOCKS = 25;
+
+EchoCancellerConfig defaultEchoCancellerConfig(int sample_rate) {
+    EchoCancellerConfig config;
+    config.sample_rate = sample_rate;
+    size_t block = 64;
+    while (block * 2 <= (size_t)sample_rate * 8 / 1000) {
+        block <<= 1;
+    }
+    config.block_samples = block;
+    config.partitions = ((size_t)sample_rate * 128 / 1000 + block - 1) / block;
+    config.max_delay_blocks = (size_t)sample_rate * 512 / 1000 / block;
+    config.lead_blocks = 2;
+    config.estimate_delay = true;
+    config.fixed_delay_blocks = 0;
+    config.step_size = 0.5f;
+    config.far_power_floor = 1000.0f;
+    config.double_talk_ratio = 8.0f;
+    config.double_talk_hangover = (uint32_t)((size_t)sample_rate / 10 / block);
+    config.reference_backlog = 2 * block;
+    return config;
+}
+
+// Y += W * X over packed spectra (DC and Nyquist real in [0] and [1])
+static void multiplyAccumulate(float* y, const float* w, const float* x, size_t n) {
+    y[0] += w[0] * x[0];
+    y[1] += w[1] * x[1];
+    for (size_t i = 2; i < n; i += 2) {
+        y[i] += w[i] * x[i] - w[i + 1] * x[i + 1];
+        y[i + 1] += w[i] * x[i + 1] + w[i + 1] * x[i];
+    }
+}
+
+static int16_t clampSample(float value) {
+    if (value > 32767.0f) {
+        return 32767;
+    }
+    if (value < -32768.0f) {
+        return -32768;
+    }
+    return (int16_t)lrintf(value);
+}
+
+EchoCanceller::EchoCanceller()
+    : _bins(0), _twiddle(nullptr), _bitrev(nullptr), _weights(nullptr), _far_spectra(nullptr),
+      _far_power(nullptr), _far_prev(nullptr), _fft(nullptr), _echo(nullptr), _spectrum_head(0),
+      _constrain_next(0), _far_active(0), _delay_line(nullptr), _delay_head(0), _far_bits(nullptr),
+      _delay_cost(nullptr), _delay_blocks(0), _filter_delay(0), _candidate(-1), _candidate_blocks(0),
+      _far_seen(0), _ratio_floor(1.0f), _double_talk_hold(0), _diverged_blocks(0), _near_energy(0.0f),
+      _error_energy(0.0f), _reference(nullptr), _far_block(nullptr) {
+    memset(&_config, 0, sizeof(_config));
+    memset(&_plan, 0, sizeof(_plan));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+EchoCanceller::~EchoCanceller() {
+    deinit();
+}
+
+bool EchoCanceller::init(const EchoCancellerConfig& config, MemoryRegion region) {
+    deinit();
+    const size_t n = config.block_samples;
+    if (n < 64 || n > 1024 || (n & (n - 1)) != 0 || config.partitions == 0 ||
+        config.sample_rate <= 0 || config.lead_blocks > config.max_delay_blocks ||
+        config.fixed_delay_blocks > config.max_delay_blocks) {
+        AUDIO_LOGF("Invalid echo canceller configuration\n");
+        return false;
+    }
+    _config = config;
+    _bins = n + 1;
+    const size_t fft_size = 2 * n;
+    const size_t slots = config.max_delay_blocks + 1;
+
+    bool ok = true;
+    auto alloc = [&](size_t bytes) {
+        void* ptr = audioAlloc(bytes, region);
+        ok = ok && ptr != nullptr;
+        return ptr;
+    };
+    _twiddle = static_cast<float*>(alloc(DSPS_FFT_TWIDDLE_LEN(fft_size) * sizeof(float)));
+    _bitrev = static_cast<uint16_t*>(alloc(DSPS_FFT_BITREV_LEN(fft_size) * sizeof(uint16_t)));
+    _weights = static_cast<float*>(alloc(config.partitions * fft_size * sizeof(float)));
+    _far_spectra = static_cast<float*>(alloc(config.partitions * fft_size * sizeof(float)));
+    _far_power = static_cast<float*>(alloc(_bins * sizeof(float)));
+    _far_prev = static_cast<float*>(alloc(n * sizeof(float)));
+    _fft = static_cast<float*>(alloc(fft_size * sizeof(float)));
+    _echo = static_cast<float*>(alloc(fft_size * sizeof(float)));
+    _delay_line = static_cast<int16_t*>(alloc(slots * n * sizeof(int16_t)));
+    _far_bits = static_cast<uint32_t*>(alloc(slots * sizeof(uint32_t)));
+    _delay_cost = static_cast<float*>(alloc(slots * sizeof(float)));
+    _far_block = static_cast<int16_t*>(alloc(n * sizeof(int16_t)));
+    if (!ok) {
+        AUDIO_LOGF("Failed to allocate echo canceller buffers\n");
+        deinit();
+        return false;
+    }
+    dsps_fft_plan_init_f32(&_plan, _twiddle, _bitrev, (int)fft_size);
+
+    // Delay search bands: evenly spaced bins across the speech range
+    int low = (int)(DELAY_LOW_HZ * fft_size / config.sample_rate);
+    int high = (int)(DELAY_HIGH_HZ * fft_size / config.sample_rate);
+    if (high > (int)n) {
+        high = (int)n;
+    }
+    if (high - low < DELAY_BANDS) {
+        low = high - DELAY_BANDS > 1 ? high - DELAY_BANDS : 1;
+    }
+    for (int b = 0; b <= DELAY_BANDS; b++) {
+        _band_start[b] = (uint16_t)(low + b * (high - low) / DELAY_BANDS);
+    }
+
+    reset();
+    return true;
+}
+
+void EchoCanceller::deinit() {
+    audioFree(_twiddle);
+    audioFree(_bitrev);
+    audioFree(_weights);
+    audioFree(_far_spectra);
+    audioFree(_far_power);
+    audioFree(_far_prev);
+    audioFree(_fft);
+    audioFree(_echo);
+    audioFree(_delay_line);
+    audioFree(_far_bits);
+    audioFree(_delay_cost);
+    audioFree(_far_block);
+    _twiddle = nullptr;
+    _bitrev = nullptr;
+    _weights = nullptr;
+    _far_spectra = nullptr;
+    _far_power = nullptr;
+    _far_prev = nullptr;
+    _fft = nullptr;
+    _echo = nullptr;
+    _delay_line = nullptr;
+    _far_bits = nullptr;
+    _delay_cost = nullptr;
+    _far_block = nullptr;
+}
+
+void EchoCanceller::clearFilter() {
+    const size_t fft_size = 2 * _config.block_samples;
+    memset(_weights, 0, _config.partitions * fft_size * sizeof(float));
+    memset(_far_spectra, 0, _config.partitions * fft_size * sizeof(float));
+    memset(_far_prev, 0, _config.block_samples * sizeof(float));
+    _spectrum_head = 0;
+    _constrain_next = 0;
+    _ratio_floor = 1.0f;
+    _double_talk_hold = 0;
+    _diverged_blocks = 0;
+}
+
+void EchoCanceller::reset() {
+    if (!isInitialized()) {
+        return;
+    }
+    const size_t slots = _config.max_delay_blocks + 1;
+    clearFilter();
+    memset(_far_power, 0, _bins * sizeof(float));
+    memset(_delay_line, 0, slots * _config.block_samples * sizeof(int16_t));
+    memset(_far_bits, 0, slots * sizeof(uint32_t));
+    for (size_t d = 0; d < slots; d++) {
+        _delay_cost[d] = DELAY_BANDS / 2;
+    }
+    memset(_far_band_mean, 0, sizeof(_far_band_mean));
+    memset(_near_band_mean, 0, sizeof(_near_band_mean));
+    _delay_head = 0;
+    _far_active = 0;
+    _far_seen = 0;
+    _candidate = -1;
+    _candidate_blocks = 0;
+    _delay_blocks = _config.estimate_delay ? 0 : (int)_config.fixed_delay_blocks;
+    _filter_delay = _delay_blocks > (int)_config.lead_blocks ? _delay_blocks - (int)_config.lead_blocks : 0;
+    _near_energy = 0.0f;
+    _error_energy = 0.0f;
+    memset(&_stats, 0, sizeof(_stats));
+    _stats.delay_blocks = _delay_blocks;
+}
+
+bool EchoCanceller::process(const int16_t* near, const int16_t* far, int16_t* out, size_t count) {
+    if (!isInitialized() || count % _config.block_samples != 0) {
+        return false;
+    }
+    for (size_t offset = 0; offset < count; offset += _config.block_samples) {
+        processBlock(near + offset, far + offset, out + offset);
+    }
+    return true;
+}
+
+bool EchoCanceller::process(FrameRef& frame) {
+    if (!frame) {
+        return false;
+    }
+    const size_t n = _config.block_samples;
+    const size_t length = frame.size();
+    if ((frame->flags & FRAME_FLAG_SILENCE) || length == 0 || !isInitialized() || length % n != 0) {
+        return true;
+    }
+
+    if (_reference != nullptr) {
+        // A reference far ahead of capture (output started first, or capture
+        // stalled) would put the echo before the far end; keep the newest
+        size_t available = _reference->available();
+        size_t keep = length + _config.reference_backlog;
+        while (available > keep) {
+            size_t drop = available - keep < n ? available - keep : n;
+            size_t dropped = _reference->read(_far_block, drop);
+            _stats.reference_dropped += dropped;
+            available -= dropped;
+            if (dropped < drop) {
+                break;
+            }
+        }
+    }
+
+    int16_t* samples = frame.data();
+    for (size_t offset = 0; offset < length; offset += n) {
+        size_t got = _reference != nullptr ? _reference->read(_far_block, n) : 0;
+        if (got < n) {
+            memset(_far_block + got, 0, (n - got) * sizeof(int16_t));
+            _stats.reference_missing += n - got;
+        }
+        processBlock(samples + offset, _far_block, samples + offset);
+    }
+    return true;
+}
+
+PipelineRuntime::StageFunction EchoCanceller::stageFunction() {
+    return [this](FrameRef& frame) { return process(frame); };
+}
+
+uint32_t EchoCanceller::binarySpectrum(const int16_t* samples, float* band_mean) {
+    const size_t n = _config.block_samples;
+    for (size_t i = 0; i < n; i++) {
+        _fft[i] = samples[i];
+    }
+    memset(&_fft[n], 0, n * sizeof(float));
+    dsps_rfft_f32(&_plan, _fft);
+
+    uint32_t bits = 0;
+    for (int b = 0; b < DELAY_BANDS; b++) {
+        float power = 0.0f;
+        for (int k = _band_start[b]; k < _band_start[b + 1]; k++) {
+            power += _fft[2 * k] * _fft[2 * k] + _fft[2 * k + 1] * _fft[2 * k + 1];
+        }
+        if (power > band_mean[b]) {
+            bits |= 1u << b;
+        }
+        band_mean[b] += BAND_MEAN_SMOOTHING * (power - band_mean[b]);
+    }
+    return bits;
+}
+
+void EchoCanceller::estimateDelay(const int16_t* near, const int16_t* far) {
+    const size_t n = _config.block_samples;
+    const size_t slots = _config.max_delay_blocks + 1;
+    float far_energy = 0.0f;
+    float near_energy = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        far_energy += (float)far[i] * far[i];
+        near_energy += (float)near[i] * near[i];
+    }
+    if (far_energy > _config.far_power_floor * n) {
+        _far_seen = (uint32_t)slots;
+    } else if (_far_seen > 0) {
+        _far_seen--;
+    }
+
+    _far_bits[_delay_head] = binarySpectrum(far, _far_band_mean);
+    uint32_t near_bits = binarySpectrum(near, _near_band_mean);
+    // Only a microphone hearing something while the far end has played
+    // says anything about the delay
+    if (_far_seen == 0 || near_energy <= _config.far_power_floor * n) {
+        return;
+    }
+
+    int best = 0;
+    float total = 0.0f;
+    for (size_t d = 0; d < slots; d++) {
+        size_t slot = (_delay_head + slots - d) % slots;
+        float distance = (float)__builtin_popcount(near_bits ^ _far_bits[slot]);
+        _delay_cost[d] += DELAY_SMOOTHING * (distance - _delay_cost[d]);
+        total += _delay_cost[d];
+        if (_delay_cost[d] < _delay_cost[best]) {
+            best = (int)d;
+        }
+    }
+    if (_delay_cost[best] > DELAY_MATCH_RATIO * total / slots) {
+        _candidate = -1;
+        _candidate_blocks = 0;
+        return;
+    }
+    if (best == _candidate) {
+        _candidate_blocks++;
+    } else {
+        _candidate = best;
+        _candidate_blocks = 1;
+    }
+    if (_candidate_blocks < DELAY_CONFIRM_BLOCKS) {
+        return;
+    }
+
+    _delay_blocks = best;
+    _stats.delay_blocks = best;
+    // The lead absorbs a block either way; only a larger move restarts
+    int target = best > (int)_config.lead_blocks ? best - (int)_config.lead_blocks : 0;
+    if (target - _filter_delay >= 2 || _filter_delay - target >= 2) {
+        setFilterDelay(target);
+    }
+}
+
+void EchoCanceller::setFilterDelay(int delay_blocks) {
+    _filter_delay = delay_blocks;
+    clearFilter();
+    _stats.delay_changes++;
+}
+
+void EchoCanceller::processBlock(const int16_t* near, const int16_t* far, int16_t* out) {
+    uint64_t begin = audioMicros();
+    const size_t n = _config.block_samples;
+    const size_t fft_size = 2 * n;
+    const size_t partitions = _config.partitions;
+    const size_t slots = _config.max_delay_blocks + 1;
+    _stats.blocks++;
+
+    // Far end into the delay line; the filter input is taken _filter_delay
+    // blocks back
+    memcpy(&_delay_line[_delay_head * n], far, n * sizeof(int16_t));
+    if (_config.estimate_delay) {
+        estimateDelay(near, far);
+    }
+    const int16_t* x = &_delay_line[((_delay_head + slots - _filter_delay) % slots) * n];
+    _delay_head = (_delay_head + 1) % slots;
+
+    // Overlap-save input: previous block then this one
+    float far_energy = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        float v = x[i];
+        _fft[i] = _far_prev[i];
+        _fft[n + i] = v;
+        _far_prev[i] = v;
+        far_energy += v * v;
+    }
+    dsps_rfft_f32(&_plan, _fft);
+    _spectrum_head = (_spectrum_head + 1) % partitions;
+    float* newest = &_far_spectra[_spectrum_head * fft_size];
+    memcpy(newest, _fft, fft_size * sizeof(float));
+
+    // Per-bin far power averaged over about one tail
+    const float alpha = 1.0f / partitions;
+    _far_power[0] += alpha * (newest[0] * newest[0] - _far_power[0]);
+    _far_power[n] += alpha * (newest[1] * newest[1] - _far_power[n]);
+    for (size_t k = 1; k < n; k++) {
+        float power = newest[2 * k] * newest[2 * k] + newest[2 * k + 1] * newest[2 * k + 1];
+        _far_power[k] += alpha * (power - _far_power[k]);
+    }
+    if (far_energy > _config.far_power_floor * n) {
+        _far_active = (uint32_t)partitions + 1;
+    } else if (_far_active > 0) {
+        _far_active--;
+    }
+
+    // Echo estimate: sum over partitions of W_p * X_(t-p), last half of the IFFT
+    memset(_echo, 0, fft_size * sizeof(float));
+    for (size_t p = 0; p < partitions; p++) {
+        size_t index = (_spectrum_head + partitions - p) % partitions;
+        multiplyAccumulate(_echo, &_weights[p * fft_size], &_far_spectra[index * fft_size], fft_size);
+    }
+    dsps_irfft_f32(&_plan, _echo);
+
+    float near_energy = 0.0f;
+    float error_energy = 0.0f;
+    for (size_t i = 0; i < n; i++) {
+        float d = near[i];
+        float e = d - _echo[n + i];
+        near_energy += d * d;
+        error_energy += e * e;
+        _fft[i] = 0.0f;
+        _fft[n + i] = e;
+    }
+
+    const bool heard = near_energy > _config.far_power_floor * n;
+    if (heard && error_energy > DIVERGENCE_RATIO * near_energy) {
+        _diverged_blocks++;
+    } else {
+        _diverged_blocks = 0;
+    }
+    if (_diverged_blocks >= DIVERGENCE_BLOCKS) {
+        clearFilter();
+        _stats.resets++;
+    }
+    if (error_energy > DIVERGENCE_RATIO * near_energy) {
+        // Never make the microphone much louder
+        if (out != near) {
+            memcpy(out, near, n * sizeof(int16_t));
+        }
+    } else {
+        for (size_t i = 0; i < n; i++) {
+            out[i] = clampSample(_fft[n + i]);
+        }
+    }
+
+    // Double talk: the error/near ratio jumps above its converged floor
+    const bool active = _far_active > 0;
+    bool double_talk = false;
+    if (active && heard) {
+        float ratio = error_energy / near_energy;
+        double_talk = ratio > _ratio_floor * _config.double_talk_ratio;
+        float risen = _ratio_floor * RATIO_FLOOR_RISE;
+        _ratio_floor = ratio < _ratio_floor ? ratio : (risen < 1.0f ? risen : 1.0f);
+        if (_ratio_floor < RATIO_FLOOR_MIN) {
+            _ratio_floor = RATIO_FLOOR_MIN;
+        }
+    }
+    if (double_talk) {
+        _double_talk_hold = _config.double_talk_hangover + 1;
+        _stats.double_talk_blocks++;
+    } else if (_double_talk_hold > 0) {
+        _double_talk_hold--;
+    }
+
+    if (active && !double_talk) {
+        _near_energy += ERLE_SMOOTHING * (near_energy - _near_energy);
+        _error_energy += ERLE_SMOOTHING * (error_energy - _error_energy);
+        _stats.erle_db = 10.0f * log10f((_near_energy + 1.0f) / (_error_energy + 1.0f));
+    }
+
+    if (active && _double_talk_hold == 0) {
+        // Error spectrum, then W_p += mu * conj(X_p) * E / (P * S + delta)
+        dsps_rfft_f32(&_plan, _fft);
+        const float delta = (float)partitions * fft_size * _config.far_power_floor;
+        float* norm = _echo;
+        for (size_t k = 0; k < _bins; k++) {
+            norm[k] = _config.step_size / (partitions * _far_power[k] + delta);
+        }
+        for (size_t p = 0; p < partitions; p++) {
+            size_t index = (_spectrum_head + partitions - p) % partitions;
+            const float* xp = &_far_spectra[index * fft_size];
+            float* w = &_weights[p * fft_size];
+            w[0] += norm[0] * xp[0] * _fft[0];
+            w[1] += norm[n] * xp[1] * _fft[1];
+            for (size_t k = 1; k < n; k++) {
+                float xr = xp[2 * k];
+                float xi = xp[2 * k + 1];
+                float er = _fft[2 * k];
+                float ei = _fft[2 * k + 1];
+                w[2 * k] += norm[k] * (xr * er + xi * ei);
+                w[2 * k + 1] += norm[k] * (xr * ei - xi * er);
+            }
+        }
+
+        // Gradient constraint on one partition: keep the first N taps
+        float* w = &_weights[_constrain_next * fft_size];
+        dsps_irfft_f32(&_plan, w);
+        memset(&w[n], 0, n * sizeof(float));
+        dsps_rfft_f32(&_plan, w);
+        _constrain_next = (_constrain_next + 1) % partitions;
+        _stats.adapted_blocks++;
+    }
+    _stats.process_us += audioMicros() - begin;
+}
+
+} // namespace audio_processing
@@ -0,0 +1,70 @@
+#include "keyword_gate.h"
+
+namespace audio_processing {
+
+KeywordGate::KeywordGate(KeywordSpotter& spotter, uint32_t listen_ms, int sample_rate)
+    : _spotter(spotter), _listen_samples((uint64_t)listen_ms * sample_rate / 1000), _listened(0),
+      _open(false), _close_requested(false), _frames_in(0), _frames_passed(0),
+      _frames_dropped(0), _wakes(0), _spot_us(0) {
+    _last_hit = KwsHit();
+    _spotter.setHit([this](const KwsHit& hit) { _last_hit = hit; });
+}
+
+bool KeywordGate::process(FrameRef& frame) {
+    if (!frame) {
+        return false;
+    }
+    _frames_in.fetch_add(1);
+
+    // close() may come from another task; apply it at a frame boundary
+    if (_close_requested.exchange(false) && _open.load()) {
+        _open.store(false);
+        _spotter.reset();
+    }
+
+    if (_open.load()) {
+        _listened += frame.size();
+        if (_listened >= _listen_samples) {
+            _open.store(false);
+            _spotter.reset();
+        }
+        _frames_passed.fetch_add(1);
+        return true;
+    }
+
+    uint64_t begin = audioMicros();
+    bool spotted = _spotter.feed(frame.data(), frame.size());
+    _spot_us.fetch_add(audioMicros() - begin);
+    _frames_dropped.fetch_add(1);
+
+    if (spotted) {
+        _listened = 0;
+        _open.store(true);
+        _wakes.fetch_add(1);
+        if (_wake) {
+            _wake(_last_hit);
+        }
+    }
+    return false;
+}
+
+PipelineRuntime::StageFunction KeywordGate::stageFunction() {
+    return [this](FrameRef& frame) { return process(frame); };
+}
+
+void KeywordGate::close() {
+    _close_requested.store(true);
+}
+
+void KeywordGate::getStats(KeywordGateStats* stats) const {
+    if (stats == nullptr) {
+        return;
+    }
+    stats->frames_in = _frames_in.load();
+    stats->frames_passed = _frames_passed.load();
+    stats->frames_dropped = _frames_dropped.load();
+    stats->wakes = _wakes.load();
+    stats->spot_us = _spot_us.load();
+}
+
+} // namespace audio_processing
@@ -0,0 +1,444 @@
+#include "noise_suppressor.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_idf_version.h"
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace audio_processing {
+
+// Speech decision band; below is hum and handling noise, above carries
+// little speech energy at the capture rates used here
+static const float SPEECH_LOW_HZ = 100.0f;
+static const float SPEECH_HIGH_HZ = 4000.0f;
+// Per-bin posterior SNR cap in the speech decision, so a few strong bins
+// (a whistle, a tonal hum the estimate has not caught up with) cannot
+// outvote the rest of the band
+static const float SNR_CAP = 10.0f;
+// Once the estimate is established, bins this far above it keep their
+// noise value even on noise hops: under an exponential power
+// distribution only 2% of true noise bins are skipped, so the estimate
+// stays nearly unbiased while speech the decision missed is kept out
+static const float NOISE_GATE = 4.0f;
+
+static uint32_t nsCycleCount() {
+#ifdef ESP_PLATFORM
+    #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    return (uint32_t)esp_cpu_get_cycle_count();
+    #else
+    return esp_cpu_get_ccount();
+    #endif
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)audioMicros();
+#endif
+}
+
+NoiseSuppressorConfig defaultNoiseSuppressorConfig(int sample_rate) {
+    NoiseSuppressorConfig config;
+    config.sample_rate = sample_rate;
+    size_t hop = 64;
+    while (hop * 2 <= (size_t)sample_rate * 8 / 1000) {
+        hop <<= 1;
+    }
+    config.hop_samples = hop;
+    config.mode = NoiseSuppressorMode::FLOAT;
+    config.min_gain_db = -15.0f;
+    config.dd_smoothing = 0.95f;
+    config.noise_smoothing = 0.95f;
+    config.speech_ratio = 1.5f;
+    config.init_frames = (uint32_t)((size_t)sample_rate / 4 / hop);
+    config.noise_refresh_frames = (uint32_t)((size_t)sample_rate * 2 / hop);
+    return config;
+}
+
+static int16_t clampSample(int32_t value) {
+    if (value > 32767) {
+        return 32767;
+    }
+    if (value < -32768) {
+        return -32768;
+    }
+    return (int16_t)value;
+}
+
+// Real and imaginary parts of bin k in the packed FFT layout; the
+// imaginary parts of DC and Nyquist are zero and not stored
+template <typename T>
+static inline void binParts(T* packed, size_t k, size_t bins, T** re, T** im) {
+    if (k == 0) {
+        *re = &packed[0];
+        *im = nullptr;
+    } else if (k == bins - 1) {
+        *re = &packed[1];
+        *im = nullptr;
+    } else {
+        *re = &packed[2 * k];
+        *im = &packed[2 * k + 1];
+    }
+}
+
+NoiseSuppressor::NoiseSuppressor()
+    : _bins(0), _band_low(0), _band_high(0), _input(nullptr), _bitrev(nullptr), _window(nullptr),
+      _twiddle(nullptr), _fft(nullptr), _noise(nullptr), _clean(nullptr), _overlap(nullptr),
+      _window_q15(nullptr), _twiddle_q15(nullptr), _fft_q15(nullptr), _noise_q4(nullptr),
+      _clean_q4(nullptr), _overlap_q(nullptr), _min_gain_q15(0), _dd_q15(0), _noise_q15(0),
+      _speech_ratio_q4(0), _min_gain(0.0f), _frames_seen(0), _speech_run(0) {
+    memset(&_config, 0, sizeof(_config));
+    memset(&_plan, 0, sizeof(_plan));
+    memset(&_plan_q15, 0, sizeof(_plan_q15));
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+NoiseSuppressor::~NoiseSuppressor() {
+    deinit();
+}
+
+bool NoiseSuppressor::init(const NoiseSuppressorConfig& config, MemoryRegion region) {
+    deinit();
+    const size_t hop = config.hop_samples;
+    if (hop < 32 || hop > 1024 || (hop & (hop - 1)) != 0 || config.sample_rate <= 0 ||
+        config.min_gain_db > 0.0f || config.dd_smoothing < 0.0f || config.dd_smoothing >= 1.0f ||
+        config.noise_smoothing < 0.0f || config.noise_smoothing >= 1.0f || config.speech_ratio < 1.0f) {
+        AUDIO_LOGF("Invalid noise suppressor configuration\n");
+        return false;
+    }
+    _config = config;
+    _bins = hop + 1;
+    const size_t fft_size = 2 * hop;
+    const bool fixed = config.mode == NoiseSuppressorMode::FIXED;
+
+    bool ok = true;
+    auto alloc = [&](size_t bytes) {
+        void* ptr = audioAlloc(bytes, region);
+        ok = ok && ptr != nullptr;
+        return ptr;
+    };
+    _input = static_cast<int16_t*>(alloc(fft_size * sizeof(int16_t)));
+    _bitrev = static_cast<uint16_t*>(alloc(DSPS_FFT_BITREV_LEN(fft_size) * sizeof(uint16_t)));
+    if (fixed) {
+        _window_q15 = static_cast<int16_t*>(alloc(fft_size * sizeof(int16_t)));
+        _twiddle_q15 = static_cast<int16_t*>(alloc(DSPS_FFT_TWIDDLE_LEN(fft_size) * sizeof(int16_t)));
+        _fft_q15 = static_cast<int16_t*>(alloc(fft_size * sizeof(int16_t)));
+        _noise_q4 = static_cast<uint32_t*>(alloc(_bins * sizeof(uint32_t)));
+        _clean_q4 = static_cast<uint32_t*>(alloc(_bins * sizeof(uint32_t)));
+        _overlap_q = static_cast<int32_t*>(alloc(hop * sizeof(int32_t)));
+    } else {
+        _window = static_cast<float*>(alloc(fft_size * sizeof(float)));
+        _twiddle = static_cast<float*>(alloc(DSPS_FFT_TWIDDLE_LEN(fft_size) * sizeof(float)));
+        _fft = static_cast<float*>(alloc(fft_size * sizeof(float)));
+        _noise = static_cast<float*>(alloc(_bins * sizeof(float)));
+        _clean = static_cast<float*>(alloc(_bins * sizeof(float)));
+        _overlap = static_cast<float*>(alloc(hop * sizeof(float)));
+    }
+    if (!ok) {
+        AUDIO_LOGF("Failed to allocate noise suppressor buffers\n");
+        deinit();
+        return false;
+    }
+
+    // Periodic square-root Hann: w[i]^2 + w[i + H]^2 = 1
+    for (size_t i = 0; i < fft_size; i++) {
+        double w = sin(M_PI * (double)i / (double)fft_size);
+        if (fixed) {
+            _window_q15[i] = (int16_t)lrint(fmin(w * 32768.0, 32767.0));
+        } else {
+            _window[i] = (float)w;
+        }
+    }
+    if (fixed) {
+        dsps_fft_plan_init_s16(&_plan_q15, _twiddle_q15, _bitrev, (int)fft_size);
+    } else {
+        dsps_fft_plan_init_f32(&_plan, _twiddle, _bitrev, (int)fft_size);
+    }
+
+    _min_gain = powf(10.0f, config.min_gain_db / 20.0f);
+    _min_gain_q15 = (int32_t)lrintf(_min_gain * 32768.0f);
+    _dd_q15 = (int32_t)lrintf(config.dd_smoothing * 32768.0f);
+    _noise_q15 = (int32_t)lrintf((1.0f - config.noise_smoothing) * 32768.0f);
+    _speech_ratio_q4 = (uint64_t)lrintf(config.speech_ratio * 16.0f);
+
+    _band_low = (size_t)(SPEECH_LOW_HZ * fft_size / config.sample_rate);
+    _band_high = (size_t)(SPEECH_HIGH_HZ * fft_size / config.sample_rate);
+    if (_band_low < 1) {
+        _band_low = 1;
+    }
+    if (_band_high > hop) {
+        _band_high = hop;
+    }
+
+    reset();
+    return true;
+}
+
+void NoiseSuppressor::deinit() {
+    audioFree(_input);
+    audioFree(_bitrev);
+    audioFree(_window);
+    audioFree(_twiddle);
+    audioFree(_fft);
+    audioFree(_noise);
+    audioFree(_clean);
+    audioFree(_overlap);
+    audioFree(_window_q15);
+    audioFree(_twiddle_q15);
+    audioFree(_fft_q15);
+    audioFree(_noise_q4);
+    audioFree(_clean_q4);
+    audioFree(_overlap_q);
+    _input = nullptr;
+    _bitrev = nullptr;
+    _window = nullptr;
+    _twiddle = nullptr;
+    _fft = nullptr;
+    _noise = nullptr;
+    _clean = nullptr;
+    _overlap = nullptr;
+    _window_q15 = nullptr;
+    _twiddle_q15 = nullptr;
+    _fft_q15 = nullptr;
+    _noise_q4 = nullptr;
+    _clean_q4 = nullptr;
+    _overlap_q = nullptr;
+}
+
+void NoiseSuppressor::reset() {
+    if (!isInitialized()) {
+        return;
+    }
+    const size_t hop = _config.hop_samples;
+    memset(_input, 0, 2 * hop * sizeof(int16_t));
+    if (_config.mode == NoiseSuppressorMode::FIXED) {
+        memset(_noise_q4, 0, _bins * sizeof(uint32_t));
+        memset(_clean_q4, 0, _bins * sizeof(uint32_t));
+        memset(_overlap_q, 0, hop * sizeof(int32_t));
+    } else {
+        memset(_noise, 0, _bins * sizeof(float));
+        memset(_clean, 0, _bins * sizeof(float));
+        memset(_overlap, 0, hop * sizeof(float));
+    }
+    _frames_seen = 0;
+    _speech_run = 0;
+    memset(&_stats, 0, sizeof(_stats));
+}
+
+bool NoiseSuppressor::process(const int16_t* in, int16_t* out, size_t count) {
+    if (!isInitialized() || count % _config.hop_samples != 0) {
+        return false;
+    }
+    uint64_t start = audioMicros();
+    for (size_t offset = 0; offset < count; offset += _config.hop_samples) {
+        processHop(in + offset, out + offset);
+    }
+    _stats.process_us += audioMicros() - start;
+    return true;
+}
+
+bool NoiseSuppressor::process(FrameRef& frame) {
+    if (!frame) {
+        return false;
+    }
+    const size_t length = frame.size();
+    if ((frame->flags & FRAME_FLAG_SILENCE) || length == 0 || !isInitialized() ||
+        length % _config.hop_samples != 0) {
+        return true;
+    }
+    process(frame.data(), frame.data(), length);
+    return true;
+}
+
+PipelineRuntime::StageFunction NoiseSuppressor::stageFunction() {
+    return [this](FrameRef& frame) { return process(frame); };
+}
+
+int32_t NoiseSuppressor::noiseWeight(bool loud, bool* averaging) {
+    if (loud) {
+        _speech_run++;
+        _stats.speech_frames++;
+        if (_config.noise_refresh_frames == 0 || _speech_run < _config.noise_refresh_frames) {
+            return 0;
+        }
+        _speech_run = 0;
+        _frames_seen = 0;
+        _stats.noise_relearns++;
+    }
+    *averaging = _frames_seen < _config.init_frames;
+    if (*averaging) {
+        // Running mean over the leading hops; the first replaces the
+        // estimate outright
+        _frames_seen++;
+        _stats.noise_updates++;
+        return (int32_t)(32768 / _frames_seen);
+    }
+    _speech_run = 0;
+    _stats.noise_updates++;
+    return _noise_q15;
+}
+
+void NoiseSuppressor::processHop(const int16_t* in, int16_t* out) {
+    const size_t hop = _config.hop_samples;
+    uint32_t start = nsCycleCount();
+
+    memmove(_input, _input + hop, hop * sizeof(int16_t));
+    memcpy(_input + hop, in, hop * sizeof(int16_t));
+    if (_config.mode == NoiseSuppressorMode::FIXED) {
+        processFixed(out);
+    } else {
+        processFloat(out);
+    }
+
+    uint32_t cycles = nsCycleCount() - start;
+    _stats.frames++;
+    _stats.last_cycles = cycles;
+    _stats.total_cycles += cycles;
+    if (cycles > _stats.max_cycles) {
+        _stats.max_cycles = cycles;
+    }
+}
+
+void NoiseSuppressor::processFloat(int16_t* out) {
+    const size_t hop = _config.hop_samples;
+    const size_t fft_size = 2 * hop;
+    for (size_t i = 0; i < fft_size; i++) {
+        _fft[i] = _input[i] * _window[i];
+    }
+    dsps_rfft_f32(&_plan, _fft);
+
+    float snr_sum = 0.0f;
+    for (size_t k = _band_low; k < _band_high; k++) {
+        float power = _fft[2 * k] * _fft[2 * k] + _fft[2 * k + 1] * _fft[2 * k + 1];
+        snr_sum += power < SNR_CAP * _noise[k] ? power / _noise[k] : SNR_CAP;
+    }
+    const bool loud = _frames_seen >= _config.init_frames &&
+                      snr_sum > _config.speech_ratio * (_band_high - _band_low);
+    bool averaging = false;
+    const float weight = noiseWeight(loud, &averaging) * (1.0f / 32768.0f);
+
+    const float dd = _config.dd_smoothing;
+    for (size_t k = 0; k < _bins; k++) {
+        float* re;
+        float* im;
+        binParts(_fft, k, _bins, &re, &im);
+        float power = *re * *re + (im ? *im * *im : 0.0f);
+        if (weight > 0.0f && (averaging || power < NOISE_GATE * _noise[k])) {
+            _noise[k] += weight * (power - _noise[k]);
+        }
+        float excess = power > _noise[k] ? power - _noise[k] : 0.0f;
+        float clean = dd * _clean[k] + (1.0f - dd) * excess;
+        float gain = clean + _noise[k] > 0.0f ? clean / (clean + _noise[k]) : 0.0f;
+        if (gain < _min_gain) {
+            gain = _min_gain;
+        }
+        _clean[k] = gain * gain * power;
+        *re *= gain;
+        if (im) {
+            *im *= gain;
+        }
+    }
+
+    dsps_irfft_f32(&_plan, _fft);
+    for (size_t i = 0; i < hop; i++) {
+        out[i] = clampSample((int32_t)lrintf(_overlap[i] + _fft[i] * _window[i]));
+        _overlap[i] = _fft[hop + i] * _window[hop + i];
+    }
+}
+
+void NoiseSuppressor::processFixed(int16_t* out) {
+    const size_t hop = _config.hop_samples;
+    const size_t fft_size = 2 * hop;
+
+    // Window, then shift up so the largest sample sits just below 2^14:
+    // the FFT halves every stage, and quiet frames would otherwise lose
+    // most of their bits
+    int32_t peak = 0;
+    for (size_t i = 0; i < fft_size; i++) {
+        int32_t v = (_input[i] * _window_q15[i] + (1 << 14)) >> 15;
+        _fft_q15[i] = (int16_t)v;
+        peak |= v < 0 ? -v : v;
+    }
+    int shift = 0;
+    while (peak != 0 && (peak << (shift + 1)) < (1 << 14)) {
+        shift++;
+    }
+    if (shift > 0) {
+        for (size_t i = 0; i < fft_size; i++) {
+            _fft_q15[i] = (int16_t)(_fft_q15[i] << shift);
+        }
+    }
+    dsps_rfft_s16(&_plan_q15, _fft_q15);
+
+    // Bin power in the frame's scale is |X / 2H|^2 * 4^shift; bring it to
+    // four fraction bits
+    const int power_shift = 2 * shift - 4;
+    auto binPower = [&](size_t k) -> uint32_t {
+        int16_t* re;
+        int16_t* im;
+        binParts(_fft_q15, k, _bins, &re, &im);
+        uint64_t power = (uint64_t)((int32_t)*re * *re) + (im ? (uint64_t)((int32_t)*im * *im) : 0);
+        if (power_shift >= 0) {
+            return (uint32_t)(power >> power_shift);
+        }
+        power <<= -power_shift;
+        return power > UINT32_MAX ? UINT32_MAX : (uint32_t)power;
+    };
+
+    const uint64_t cap_q4 = (uint64_t)(SNR_CAP * 16.0f);
+    uint64_t snr_sum_q4 = 0;
+    for (size_t k = _band_low; k < _band_high; k++) {
+        uint64_t power = binPower(k);
+        uint64_t noise = _noise_q4[k];
+        snr_sum_q4 += (power << 4) < cap_q4 * noise ? (power << 4) / noise : cap_q4;
+    }
+    const bool loud = _frames_seen >= _config.init_frames &&
+                      snr_sum_q4 > _speech_ratio_q4 * (_band_high - _band_low);
+    bool averaging = false;
+    const int64_t weight = noiseWeight(loud, &averaging);
+    const uint64_t gate_q4 = (uint64_t)(NOISE_GATE * 16.0f);
+
+    for (size_t k = 0; k < _bins; k++) {
+        uint32_t power = binPower(k);
+        uint32_t noise = _noise_q4[k];
+        if (weight > 0 && (averaging || ((uint64_t)power << 4) < gate_q4 * noise)) {
+            noise = (uint32_t)((int64_t)noise + ((((int64_t)power - noise) * weight + (1 << 14)) >> 15));
+            _noise_q4[k] = noise;
+        }
+        uint64_t excess = power > noise ? power - noise : 0;
+        uint64_t clean = ((uint64_t)_dd_q15 * _clean_q4[k] + (uint64_t)(32768 - _dd_q15) * excess) >> 15;
+        uint64_t total = clean + noise;
+        int32_t gain = total > 0 ? (int32_t)((clean << 15) / total) : 0;
+        if (gain > 32767) {
+            gain = 32767;
+        }
+        if (gain < _min_gain_q15) {
+            gain = _min_gain_q15;
+        }
+        uint64_t gain_sq = ((uint64_t)gain * gain) >> 15;
+        uint64_t next = (gain_sq * power) >> 15;
+        _clean_q4[k] = next > UINT32_MAX ? UINT32_MAX : (uint32_t)next;
+
+        int16_t* re;
+        int16_t* im;
+        binParts(_fft_q15, k, _bins, &re, &im);
+        *re = (int16_t)((*re * gain + (1 << 14)) >> 15);
+        if (im) {
+            *im = (int16_t)((*im * gain + (1 << 14)) >> 15);
+        }
+    }
+
+    // Inverse, undo the shift and apply the synthesis window in one step
+    dsps_irfft_s16(&_plan_q15, _fft_q15);
+    const int out_shift = 15 + shift;
+    const int32_t round = 1 << (out_shift - 1);
+    for (size_t i = 0; i < hop; i++) {
+        int32_t current = (_fft_q15[i] * _window_q15[i] + round) >> out_shift;
+        out[i] = clampSample(_overlap_q[i] + current);
+        _overlap_q[i] = (_fft_q15[hop + i] * _window_q15[hop + i] + round) >> out_shift;
+    }
+}
+
+} // namespace audio_processing
@@ -0,0 +1,266 @@
+#include "pipeline_runtime.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#endif
+
+namespace audio_processing {
+
+// Input wait per iteration, bounds how long stop() takes to be noticed
+static const uint32_t STAGE_RECEIVE_TIMEOUT_MS = 10;
+
+static void stageSleepMs(uint32_t ms) {
+#ifdef ESP_PLATFORM
+    vTaskDelay(pdMS_TO_TICKS(ms) > 0 ? pdMS_TO_TICKS(ms) : 1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+#endif
+}
+
+StageConfig defaultStageConfig(StageRole role, const char* name) {
+    StageConfig config;
+    config.name = name;
+    config.stack_size = 4096;
+    config.queue_depth = 4;
+    config.policy = BackpressurePolicy::DROP_OLDEST;
+
+    switch (role) {
+        case StageRole::CAPTURE:
+            config.core = PIPELINE_CORE_DSP;
+            config.priority = 6;
+            break;
+        case StageRole::PDM_CONVERSION:
+            config.core = PIPELINE_CORE_DSP;
+            config.priority = 5;
+            config.stack_size = 8192;
+            break;
+        case StageRole::VAD:
+            config.core = PIPELINE_CORE_DSP;
+            config.priority = 4;
+            break;
+        case StageRole::BLUETOOTH:
+            config.core = PIPELINE_CORE_IO;
+            config.priority = 3;
+            config.queue_depth = 8;
+            break;
+        case StageRole::SD_STORAGE:
+            // SD writes stall for tens of ms on erase, give them a deep queue
+            config.core = PIPELINE_CORE_IO;
+            config.priority = 2;
+            config.queue_depth = 16;
+            config.policy = BackpressurePolicy::DROP_NEWEST;
+            break;
+        case StageRole::CUSTOM:
+        default:
+            config.core = PIPELINE_CORE_DSP;
+            config.priority = 1;
+            break;
+    }
+    return config;
+}
+
+PipelineRuntime::PipelineRuntime() : _stage_count(0), _running(false), _start_us(0) {
+    for (int i = 0; i < MAX_STAGES; i++) {
+        _stages[i] = nullptr;
+    }
+}
+
+PipelineRuntime::~PipelineRuntime() {
+    stop();
+    for (int i = 0; i < _stage_count; i++) {
+        delete _stages[i];
+        _stages[i] = nullptr;
+    }
+}
+
+int PipelineRuntime::addStage(const StageConfig& config, StageFunction function) {
+    if (_running.load() || _stage_count >= MAX_STAGES || !function) {
+        return -1;
+    }
+
+    Stage* stage = new Stage();
+    stage->config = config;
+    stage->function = function;
+    stage->input = nullptr;
+    stage->input_consumer = -1;
+    stage->runtime = this;
+    stage->frames_processed.store(0);
+    stage->frames_forwarded.store(0);
+    stage->busy_us.store(0);
+    stage->finished.store(true);
+#ifdef ESP_PLATFORM
+    stage->task = nullptr;
+#endif
+
+    _stages[_stage_count] = stage;
+    return _stage_count++;
+}
+
+bool PipelineRuntime::connect(int from, int to) {
+    if (_running.load() || from < 0 || from >= _stage_count ||
+        to < 0 || to >= _stage_count || from == to) {
+        return false;
+    }
+
+    Stage* upstream = _stages[from];
+    Stage* downstream = _stages[to];
+    if (downstream->input != nullptr) {
+        AUDIO_LOGF("Stage %s already has an input\n", downstream->config.name);
+        return false;
+    }
+
+    int consumer = upstream->output.addConsumer(downstream->config.name,
+                                                downstream->config.queue_depth,
+                                                downstream->config.policy);
+    if (consumer < 0) {
+        return false;
+    }
+
+    downstream->input = &upstream->output;
+    downstream->input_consumer = consumer;
+    return true;
+}
+
+void PipelineRuntime::runStage(Stage& stage) {
+    while (_running.load()) {
+        FrameRef frame;
+        if (stage.input != nullptr &&
+            !stage.input->receive(stage.input_consumer, frame, STAGE_RECEIVE_TIMEOUT_MS)) {
+            continue;
+        }
+
+        uint64_t begin = audioMicros();
+        bool forward = stage.function(frame);
+        stage.busy_us.fetch_add(audioMicros() - begin);
+        stage.frames_processed.fetch_add(1);
+
+        if (forward && frame) {
+            if (stage.output.publish(frame) > 0) {
+                stage.frames_forwarded.fetch_add(1);
+            }
+        } else if (stage.input == nullptr && !forward) {
+            // Source had nothing to produce, do not spin
+            stageSleepMs(1);
+        }
+    }
+}
+
+void PipelineRuntime::taskEntry(void* arg) {
+    Stage* stage = static_cast<Stage*>(arg);
+    stage->runtime->runStage(*stage);
+    stage->finished.store(true);
+#ifdef ESP_PLATFORM
+    vTaskDelete(NULL);
+#endif
+}
+
+bool PipelineRuntime::start() {
+    if (_running.load()) {
+        return true;
+    }
+    if (_stage_count == 0) {
+        return false;
+    }
+
+    _running.store(true);
+    _start_us = audioMicros();
+
+    for (int i = 0; i < _stage_count; i++) {
+        Stage* stage = _stages[i];
+        stage->frames_processed.store(0);
+        stage->frames_forwarded.store(0);
+        stage->busy_us.store(0);
+        stage->finished.store(false);
+
+#ifdef ESP_PLATFORM
+        TaskHandle_t handle = nullptr;
+        BaseType_t result = xTaskCreatePinnedToCore(taskEntry, stage->config.name,
+                                                    stage->config.stack_size, stage,
+                                                    stage->config.priority, &handle,
+                                                    stage->config.core);
+        if (result != pdPASS) {
+            AUDIO_LOGF("Failed to create task for stage %s\n", stage->config.name);
+            stage->finished.store(true);
+            stop();
+            return false;
+        }
+        stage->task = handle;
+#else
+        stage->thread = std::thread(taskEntry, stage);
+#endif
+    }
+
+    AUDIO_LOGF("Pipeline started with %d stages\n", _stage_count);
+    return true;
+}
+
+void PipelineRuntime::stop() {
+    if (!_running.exchange(false)) {
+        return;
+    }
+
+    for (int i = 0; i < _stage_count; i++) {
+        Stage* stage = _stages[i];
+#ifdef ESP_PLATFORM
+        while (!stage->finished.load()) {
+            stageSleepMs(1);
+        }
+        stage->task = nullptr;
+#else
+        if (stage->thread.joinable()) {
+            stage->thread.join();
+        }
+#endif
+    }
+
+    // Return any frames still queued between stages to their pools
+    for (int i = 0; i < _stage_count; i++) {
+        Stage* stage = _stages[i];
+        if (stage->input == nullptr) {
+            continue;
+        }
+        FrameRef frame;
+        while (stage->input->receive(stage->input_consumer, frame, 0)) {
+            frame.reset();
+        }
+    }
+}
+
+bool PipelineRuntime::getStageStats(int stage_id, StageStats* stats) const {
+    if (stage_id < 0 || stage_id >= _stage_count || stats == nullptr) {
+        return false;
+    }
+
+    const Stage* stage = _stages[stage_id];
+    stats->frames_processed = stage->frames_processed.load();
+    stats->frames_forwarded = stage->frames_forwarded.load();
+    stats->busy_us = stage->busy_us.load();
+    stats->elapsed_us = _start_us > 0 ? audioMicros() - _start_us : 0;
+    stats->cpu_utilization = stats->elapsed_us > 0 ?
+        100.0f * (float)stats->busy_us / (float)stats->elapsed_us : 0.0f;
+
+    if (stage->input == nullptr ||
+        !stage->input->getStats(stage->input_consumer, &stats->input)) {
+        stats->input = ConsumerStats();
+    }
+    return true;
+}
+
+void PipelineRuntime::printStats() const {
+    for (int i = 0; i < _stage_count; i++) {
+        StageStats stats;
+        if (!getStageStats(i, &stats)) {
+            continue;
+        }
+        AUDIO_LOGF("[%s] core %d: %u frames, cpu %.1f%%, queue %u/%u, dropped %u\n",
+                   _stages[i]->config.name, _stages[i]->config.core,
+                   (unsigned)stats.frames_processed, stats.cpu_utilization,
+                   (unsigned)stats.input.depth, (unsigned)stats.input.max_depth,
+                   (unsigned)stats.input.dropped);
+    }
+}
+
+} // namespace audio_processing
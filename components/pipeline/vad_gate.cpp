@@ -0,0 +1,127 @@
+#include "vad_gate.h"
+
+namespace audio_processing {
+
+// Hop decisions inspected per process() call; longer frames only use the
+// final state for the remainder
+static const size_t GATE_MAX_DECISIONS = 16;
+
+VADGateConfig defaultVADGateConfig(int sample_rate, size_t frame_samples) {
+    VADGateConfig config;
+    config.energy_threshold = 1000.0f;
+    config.window_size = sample_rate / 50;
+    config.hop_size = sample_rate / 100;
+    config.attack_hops = 2;
+    config.hangover_hops = 30;
+    config.policy = SilencePolicy::MARKER;
+    config.marker_interval = frame_samples > 0 ? (uint32_t)(sample_rate / frame_samples) : 0;
+    return config;
+}
+
+VADGate::VADGate(const VADGateConfig& config)
+    : _config(config),
+      _vad(config.energy_threshold, config.window_size, config.hop_size,
+           config.attack_hops, config.hangover_hops),
+      _silent_run(0), _tracked_count(0), _frames_in(0), _frames_passed(0),
+      _frames_skipped(0), _markers_sent(0), _gate_us(0) {
+    if (config.policy == SilencePolicy::MARKER &&
+        !_markers.init(MARKER_POOL_SIZE, 1, MemoryRegion::INTERNAL)) {
+        AUDIO_LOGF("Failed to allocate VAD gate markers, skipping silence instead\n");
+        _config.policy = SilencePolicy::SKIP;
+    }
+}
+
+VADGate::~VADGate() {
+    _markers.deinit();
+}
+
+bool VADGate::process(FrameRef& frame) {
+    if (!frame) {
+        return false;
+    }
+
+    uint64_t begin = audioMicros();
+    VADDecision decisions[GATE_MAX_DECISIONS];
+    size_t count = _vad.process(frame.data(), frame.size(), decisions, GATE_MAX_DECISIONS);
+    bool speech = _vad.isSpeech();
+    for (size_t i = 0; i < count && !speech; i++) {
+        speech = decisions[i].speech;
+    }
+    _gate_us.fetch_add(audioMicros() - begin);
+    _frames_in.fetch_add(1);
+
+    if (speech) {
+        _silent_run = 0;
+        _frames_passed.fetch_add(1);
+        return true;
+    }
+
+    _frames_skipped.fetch_add(1);
+    bool marker_due = _config.policy == SilencePolicy::MARKER &&
+        (_silent_run == 0 ||
+         (_config.marker_interval > 0 && _silent_run % _config.marker_interval == 0));
+    _silent_run++;
+    if (!marker_due) {
+        return false;
+    }
+
+    FrameRef marker = _markers.acquire();
+    if (!marker) {
+        return false;
+    }
+    marker->timestamp_us = frame->timestamp_us;
+    marker->flags = FRAME_FLAG_SILENCE;
+    frame = std::move(marker);
+    _markers_sent.fetch_add(1);
+    return true;
+}
+
+PipelineRuntime::StageFunction VADGate::stageFunction() {
+    return [this](FrameRef& frame) { return process(frame); };
+}
+
+bool VADGate::trackDownstream(const PipelineRuntime* runtime, int stage) {
+    if (runtime == nullptr || stage < 0 || _tracked_count >= MAX_TRACKED) {
+        return false;
+    }
+    _tracked[_tracked_count].runtime = runtime;
+    _tracked[_tracked_count].stage = stage;
+    _tracked_count++;
+    return true;
+}
+
+void VADGate::getStats(GateStats* stats) const {
+    if (stats == nullptr) {
+        return;
+    }
+    stats->frames_in = _frames_in.load();
+    stats->frames_passed = _frames_passed.load();
+    stats->frames_skipped = _frames_skipped.load();
+    stats->markers_sent = _markers_sent.load();
+    stats->gate_us = _gate_us.load();
+    stats->skip_ratio = stats->frames_in > 0 ?
+        (float)stats->frames_skipped / (float)stats->frames_in : 0.0f;
+
+    // Marker handling is counted as audio work, so the estimate errs low
+    stats->downstream_us = 0;
+    for (int i = 0; i < _tracked_count; i++) {
+        StageStats stage;
+        if (_tracked[i].runtime->getStageStats(_tracked[i].stage, &stage)) {
+            stats->downstream_us += stage.busy_us;
+        }
+    }
+    stats->saved_us = stats->frames_passed > 0 ?
+        stats->downstream_us * stats->frames_skipped / stats->frames_passed : 0;
+}
+
+void VADGate::reset() {
+    _vad.reset();
+    _silent_run = 0;
+    _frames_in.store(0);
+    _frames_passed.store(0);
+    _frames_skipped.store(0);
+    _markers_sent.store(0);
+    _gate_us.store(0);
+}
+
+} // namespace audio_processing
@@ -0,0 +1,131 @@
+#include "band_energy.h"
+#include <cmath>
+#include <cstring>
+
+// Keeps the log in the flatness measure finite for empty bins
+static const float POWER_EPSILON = 1e-3f;
+
+BandEnergyAnalyzer::BandEnergyAnalyzer(int sample_rate)
+    : sample_rate_(0), first_bin_(0), bin_count_(0), split_index_(0) {
+    configure(sample_rate);
+}
+
+void BandEnergyAnalyzer::configure(int sample_rate) {
+    sample_rate_ = sample_rate > 0 ? sample_rate : 16000;
+    const float resolution = (float)sample_rate_ / BLOCK_SIZE;
+
+    for (int n = 0; n < BLOCK_SIZE; n++) {
+        window_[n] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * n / BLOCK_SIZE);
+    }
+
+    first_bin_ = (int)ceilf(SPEECH_LOW_HZ / resolution);
+    if (first_bin_ < 1) {
+        first_bin_ = 1;
+    }
+    int last_bin = (int)ceilf(SPEECH_HIGH_HZ / resolution) - 1;
+    if (last_bin > BLOCK_SIZE / 2 - 1) {
+        last_bin = BLOCK_SIZE / 2 - 1;
+    }
+    bin_count_ = last_bin >= first_bin_ ? last_bin - first_bin_ + 1 : 0;
+
+    split_index_ = bin_count_;
+    for (int i = 0; i < bin_count_; i++) {
+        int bin = first_bin_ + i;
+        coeff_[i] = 2.0f * cosf(2.0f * (float)M_PI * bin / BLOCK_SIZE);
+        if (split_index_ == bin_count_ && bin * resolution >= SPEECH_SPLIT_HZ) {
+            split_index_ = i;
+        }
+    }
+    memset(power_, 0, sizeof(power_));
+}
+
+float BandEnergyAnalyzer::binFrequency(int index) const {
+    return (float)(first_bin_ + index) * sample_rate_ / BLOCK_SIZE;
+}
+
+void BandEnergyAnalyzer::analyzeBlock(const int16_t* block, float* total) {
+    float energy = 0.0f;
+    for (int n = 0; n < BLOCK_SIZE; n++) {
+        float x = window_[n] * block[n];
+        block_[n] = x;
+        energy += x * x;
+    }
+    *total += energy;
+
+    // Four bins per pass: each Goertzel recurrence is a serial chain, so
+    // interleaving independent ones keeps the FPU pipeline busy
+    int i = 0;
+    for (; i + 4 <= bin_count_; i += 4) {
+        const float c0 = coeff_[i], c1 = coeff_[i + 1], c2 = coeff_[i + 2], c3 = coeff_[i + 3];
+        float a1 = 0.0f, a2 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+        float d1 = 0.0f, d2 = 0.0f, e1 = 0.0f, e2 = 0.0f;
+        for (int n = 0; n < BLOCK_SIZE; n++) {
+            const float x = block_[n];
+            float a0 = x + c0 * a1 - a2;
+            float b0 = x + c1 * b1 - b2;
+            float d0 = x + c2 * d1 - d2;
+            float e0 = x + c3 * e1 - e2;
+            a2 = a1; a1 = a0;
+            b2 = b1; b1 = b0;
+            d2 = d1; d1 = d0;
+            e2 = e1; e1 = e0;
+        }
+        power_[i] += a1 * a1 + a2 * a2 - c0 * a1 * a2;
+        power_[i + 1] += b1 * b1 + b2 * b2 - c1 * b1 * b2;
+        power_[i + 2] += d1 * d1 + d2 * d2 - c2 * d1 * d2;
+        power_[i + 3] += e1 * e1 + e2 * e2 - c3 * e1 * e2;
+    }
+    for (; i < bin_count_; i++) {
+        const float c = coeff_[i];
+        float s1 = 0.0f;
+        float s2 = 0.0f;
+        for (int n = 0; n < BLOCK_SIZE; n++) {
+            float s0 = block_[n] + c * s1 - s2;
+            s2 = s1;
+            s1 = s0;
+        }
+        power_[i] += s1 * s1 + s2 * s2 - c * s1 * s2;
+    }
+}
+
+BandFeatures BandEnergyAnalyzer::analyze(const int16_t* samples, size_t count) {
+    BandFeatures features;
+    memset(&features, 0, sizeof(features));
+    memset(power_, 0, sizeof(power_));
+    if (samples == nullptr || count < (size_t)BLOCK_SIZE || bin_count_ == 0) {
+        return features;
+    }
+
+    float total = 0.0f;
+    int blocks = 0;
+    size_t offset = 0;
+    for (; offset + BLOCK_SIZE <= count; offset += BLOCK_SIZE, blocks++) {
+        analyzeBlock(samples + offset, &total);
+    }
+    if (offset < count) {
+        analyzeBlock(samples + count - BLOCK_SIZE, &total);
+        blocks++;
+    }
+
+    float log_sum = 0.0f;
+    for (int i = 0; i < bin_count_; i++) {
+        power_[i] /= blocks;
+        if (i < split_index_) {
+            features.low_speech += power_[i];
+        } else {
+            features.high_speech += power_[i];
+        }
+        log_sum += logf(power_[i] + POWER_EPSILON);
+    }
+    float speech = features.low_speech + features.high_speech;
+
+    // Parseval: sum of |X[k]|^2 over all N bins equals N * block energy, and
+    // each one-sided bin appears twice
+    float out_of_band = (float)BLOCK_SIZE * total / blocks - 2.0f * speech;
+    features.out_of_band = out_of_band > 0.0f ? out_of_band / 2.0f : 0.0f;
+    features.band_ratio = speech / (features.out_of_band + POWER_EPSILON);
+
+    float mean = speech / bin_count_;
+    features.flatness = mean > 0.0f ? expf(log_sum / bin_count_) / (mean + POWER_EPSILON) : 0.0f;
+    return features;
+}
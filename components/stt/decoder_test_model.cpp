@@ -0,0 +1,122 @@
+#include "token_decoder.h"
+#include <math.h>
+#include <stdio.h>
+
+// Random decoder for host tests and benchmarks. Projections are uniform
+// int8 from a fixed LCG. The attention outputs and positional embedding
+// are scaled up so the context, not only the last token, picks the next
+// one: with the tied output projection a weak residual stream just
+// repeats its input token. Embeddings are FLOAT32, as Whisper keeps them
+// at higher precision.
+//
+// Residual dimension 0 is reserved for stopping: no projection writes
+// it, no token embedding but end-of-text's has it, and the positional
+// embedding sets it only at the position whose logits choose the token
+// after eot_after generated ones. There layer norm turns it into the
+// dominant feature and end-of-text wins.
+
+namespace {
+
+struct Lcg {
+    uint32_t state;
+
+    int8_t next() {
+        state = state * 1664525u + 1013904223u;
+        return (int8_t)((int32_t)(state >> 24) - 128);
+    }
+};
+
+const float INT8_STD = 73.9f;           // Standard deviation of uniform int8
+const float STOP_WEIGHT = 100.0f;       // End-of-text's embedding on the stop dimension
+
+void addRandom(ModelFileWriter& writer, Lcg& rng, const char* name, uint32_t rows, uint32_t cols, float stddev,
+               bool keep_row0) {
+    std::vector<int8_t> w((size_t)rows * cols);
+    for (size_t i = 0; i < w.size(); i++) {
+        w[i] = rng.next();
+    }
+    if (!keep_row0) {
+        for (uint32_t c = 0; c < cols; c++) {
+            w[c] = 0;                   // Output 0 is the stop dimension
+        }
+    }
+    const uint32_t dims[2] = {rows, cols};
+    writer.add(name, ModelTensorType::INT8, dims, 2, w.data(), stddev / INT8_STD);
+}
+
+void addNorm(ModelFileWriter& writer, const char* name, uint32_t d) {
+    std::vector<float> params(2 * d, 0.0f);
+    for (uint32_t i = 0; i < d; i++) {
+        params[i] = 1.0f;
+    }
+    const uint32_t dims[2] = {2, d};
+    writer.add(name, ModelTensorType::FLOAT32, dims, 2, params.data());
+}
+
+} // namespace
+
+std::vector<uint8_t> buildDecoderTestModel(const DecoderHparams& hparams, uint32_t seed, uint32_t eot_after) {
+    const DecoderHparams& hp = hparams;
+    const uint32_t d = hp.n_state;
+    ModelFileWriter writer("whisper");
+    Lcg rng{seed};
+
+    const uint32_t hp_dims[1] = {DECODER_HPARAMS_COUNT};
+    writer.add("dec.hparams", ModelTensorType::INT32, hp_dims, 1, &hparams);
+
+    std::vector<float> tok((size_t)hp.n_vocab * d);
+    for (uint32_t v = 0; v < hp.n_vocab; v++) {
+        for (uint32_t i = 0; i < d; i++) {
+            float value = rng.next() / INT8_STD;
+            bool eot = (int32_t)v == hp.token_eot;
+            tok[(size_t)v * d + i] = i == 0 ? (eot ? STOP_WEIGHT : 0.0f) : (eot ? 0.0f : value);
+        }
+    }
+    const uint32_t tok_dims[2] = {hp.n_vocab, d};
+    writer.add("dec.tok_emb", ModelTensorType::FLOAT32, tok_dims, 2, tok.data());
+
+    // Prompt is start-of-transcript and no-timestamps
+    std::vector<float> pos((size_t)hp.n_ctx * d);
+    for (uint32_t p = 0; p < hp.n_ctx; p++) {
+        for (uint32_t i = 0; i < d; i++) {
+            pos[(size_t)p * d + i] = 2.0f * rng.next() / INT8_STD;
+        }
+        pos[(size_t)p * d] = (eot_after > 0 && p == eot_after + 1) ? 4.0f * sqrtf((float)d) : 0.0f;
+    }
+    const uint32_t pos_dims[2] = {hp.n_ctx, d};
+    writer.add("dec.pos_emb", ModelTensorType::FLOAT32, pos_dims, 2, pos.data());
+    addNorm(writer, "dec.ln", d);
+
+    char name[MODEL_TENSOR_NAME_LEN + 8];
+    auto tensor = [&](uint32_t l, const char* part) {
+        snprintf(name, sizeof(name), "dec.%u.%s", (unsigned)l, part);
+        return name;
+    };
+    const float unit = 1.0f / sqrtf((float)d);
+    for (uint32_t l = 0; l < hp.n_layer; l++) {
+        addNorm(writer, tensor(l, "attn_ln"), d);
+        addRandom(writer, rng, tensor(l, "attn_q"), d, d, unit, true);
+        addRandom(writer, rng, tensor(l, "attn_k"), d, d, unit, true);
+        addRandom(writer, rng, tensor(l, "attn_v"), d, d, unit, true);
+        addRandom(writer, rng, tensor(l, "attn_out"), d, d, 2.0f * unit, false);
+        if (hp.n_audio_ctx > 0) {
+            addNorm(writer, tensor(l, "xattn_ln"), d);
+            addRandom(writer, rng, tensor(l, "xattn_q"), d, d, unit, true);
+            addRandom(writer, rng, tensor(l, "xattn_k"), d, d, unit, true);
+            addRandom(writer, rng, tensor(l, "xattn_v"), d, d, unit, true);
+            addRandom(writer, rng, tensor(l, "xattn_out"), d, d, 2.0f * unit, false);
+        }
+        addNorm(writer, tensor(l, "mlp_ln"), d);
+        addRandom(writer, rng, tensor(l, "mlp_fc1"), hp.n_mlp, d, unit, true);
+        addRandom(writer, rng, tensor(l, "mlp_fc2"), d, hp.n_mlp, 1.0f / sqrtf((float)hp.n_mlp), false);
+
+        // A bias on the attention output exercises the bias path
+        std::vector<float> bias(d);
+        for (uint32_t i = 0; i < d; i++) {
+            bias[i] = i == 0 ? 0.0f : 0.1f * rng.next() / INT8_STD;
+        }
+        const uint32_t bias_dims[1] = {d};
+        writer.add(tensor(l, "attn_out.b"), ModelTensorType::FLOAT32, bias_dims, 1, bias.data());
+    }
+    return writer.build();
+}
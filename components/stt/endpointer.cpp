@@ -0,0 +1,205 @@
+#include "endpointer.h"
+#include <cstring>
+#include <new>
+
+using audio_processing::FrameRef;
+
+// Hop decisions inspected per frame by the internal VAD
+static const size_t ENDPOINTER_MAX_DECISIONS = 16;
+
+EndpointerConfig defaultEndpointerConfig(int sample_rate) {
+    EndpointerConfig config;
+    config.sample_rate = sample_rate;
+    config.min_speech_ms = 200;
+    config.trailing_silence_ms = 500;
+    config.max_utterance_ms = 10000;
+    config.energy_threshold = 1000.0f;
+    return config;
+}
+
+size_t Utterance::copyTo(int16_t* output, size_t max_samples) const {
+    if (output == nullptr) {
+        return 0;
+    }
+    size_t limit = samples() < max_samples ? samples() : max_samples;
+    size_t copied = 0;
+    for (size_t i = 0; i < frame_count && copied < limit; i++) {
+        size_t n = frames[i].size();
+        if (n > limit - copied) {
+            n = limit - copied;
+        }
+        memcpy(output + copied, frames[i].data(), n * sizeof(int16_t));
+        copied += n;
+    }
+    return copied;
+}
+
+static uint64_t msToSamples(uint32_t ms, int sample_rate) {
+    return (uint64_t)ms * (uint64_t)sample_rate / 1000;
+}
+
+Endpointer::Endpointer(const EndpointerConfig& config)
+    : config_(config),
+      vad_(config.energy_threshold, config.sample_rate / 50, config.sample_rate / 100, 1, 1),
+      frames_(nullptr), capacity_(0), count_(0), speech_frames_(0), last_raw_(false),
+      stream_pos_(0), start_sample_(0), speech_end_sample_(0), speech_end_us_(0),
+      silence_samples_(0) {
+    min_speech_samples_ = msToSamples(config.min_speech_ms, config.sample_rate);
+    trailing_samples_ = msToSamples(config.trailing_silence_ms, config.sample_rate);
+    max_samples_ = msToSamples(config.max_utterance_ms, config.sample_rate);
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+Endpointer::~Endpointer() {
+    deinit();
+}
+
+bool Endpointer::init(size_t frame_samples) {
+    deinit();
+    if (frame_samples == 0) {
+        return false;
+    }
+
+    // Longest span plus the trailing silence held while waiting for the timeout
+    uint64_t samples = max_samples_ + trailing_samples_;
+    size_t capacity = (size_t)((samples + frame_samples - 1) / frame_samples) + 1;
+    frames_ = static_cast<FrameRef*>(audio_processing::audioAlloc(capacity * sizeof(FrameRef),
+                                                                  audio_processing::MemoryRegion::INTERNAL));
+    if (frames_ == nullptr) {
+        AUDIO_LOGF("Failed to allocate endpointer ring of %u frames\n", (unsigned)capacity);
+        return false;
+    }
+    for (size_t i = 0; i < capacity; i++) {
+        new (&frames_[i]) FrameRef();
+    }
+    capacity_ = capacity;
+    return true;
+}
+
+void Endpointer::deinit() {
+    if (frames_ == nullptr) {
+        return;
+    }
+    release();
+    for (size_t i = 0; i < capacity_; i++) {
+        frames_[i].~FrameRef();
+    }
+    audio_processing::audioFree(frames_);
+    frames_ = nullptr;
+    capacity_ = 0;
+}
+
+void Endpointer::feed(const FrameRef& frame) {
+    if (!frame) {
+        return;
+    }
+    VADDecision decisions[ENDPOINTER_MAX_DECISIONS];
+    size_t count = vad_.process(frame.data(), frame.size(), decisions, ENDPOINTER_MAX_DECISIONS);
+    if (count > 0) {
+        last_raw_ = false;
+        for (size_t i = 0; i < count; i++) {
+            last_raw_ = last_raw_ || decisions[i].raw_speech;
+        }
+    }
+    feed(frame, last_raw_);
+}
+
+void Endpointer::feed(const FrameRef& frame, bool speech) {
+    if (!frame || frames_ == nullptr) {
+        return;
+    }
+
+    uint64_t frame_start = stream_pos_;
+    uint64_t frame_end = frame_start + frame.size();
+    stream_pos_ = frame_end;
+
+    if (count_ == 0) {
+        if (!speech) {
+            return;
+        }
+        start_sample_ = frame_start;
+    }
+
+    if (speech) {
+        if (count_ > 0 && (frame_end - start_sample_ > max_samples_ || count_ == capacity_)) {
+            endUtterance(EndReason::MAX_LENGTH);
+            start_sample_ = frame_start;
+        }
+        frames_[count_++] = frame;
+        speech_frames_ = count_;
+        speech_end_sample_ = frame_end;
+        speech_end_us_ = frame->timestamp_us;
+        silence_samples_ = 0;
+        return;
+    }
+
+    // Trailing silence is held in case speech resumes before the timeout
+    silence_samples_ += frame.size();
+    if (count_ < capacity_) {
+        frames_[count_++] = frame;
+    }
+    if (silence_samples_ >= trailing_samples_ || count_ == capacity_) {
+        endUtterance(EndReason::SILENCE);
+    }
+}
+
+void Endpointer::flush() {
+    if (count_ > 0) {
+        endUtterance(EndReason::FLUSH);
+    }
+}
+
+void Endpointer::reset() {
+    release();
+    vad_.reset();
+    last_raw_ = false;
+    stream_pos_ = 0;
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+uint64_t Endpointer::averageLatencyUs() const {
+    return stats_.utterances > 0 ? stats_.total_latency_us / stats_.utterances : 0;
+}
+
+void Endpointer::endUtterance(EndReason reason) {
+    uint64_t speech_samples = speech_end_sample_ - start_sample_;
+    if (reason != EndReason::MAX_LENGTH && speech_samples < min_speech_samples_) {
+        stats_.rejected_short++;
+        release();
+        return;
+    }
+
+    Utterance utterance;
+    utterance.frames = frames_;
+    utterance.frame_count = speech_frames_;
+    utterance.start_sample = start_sample_;
+    utterance.end_sample = speech_end_sample_;
+    utterance.end_of_speech_us = speech_end_us_;
+    utterance.reason = reason;
+
+    uint64_t now = audio_processing::audioMicros();
+    uint64_t latency = now > speech_end_us_ ? now - speech_end_us_ : 0;
+    stats_.last_latency_us = latency;
+    if (latency > stats_.max_latency_us) {
+        stats_.max_latency_us = latency;
+    }
+    stats_.total_latency_us += latency;
+    stats_.utterances++;
+    if (reason == EndReason::MAX_LENGTH) {
+        stats_.forced_max++;
+    }
+
+    if (dispatch_) {
+        dispatch_(utterance);
+    }
+    release();
+}
+
+void Endpointer::release() {
+    for (size_t i = 0; i < count_; i++) {
+        frames_[i].reset();
+    }
+    count_ = 0;
+    speech_frames_ = 0;
+    silence_samples_ = 0;
+}
@@ -0,0 +1,367 @@
+#include "keyword_spotter.h"
+#include "audio_platform.h"
+#include "dspm_gemm_s8.h"
+#include <math.h>
+#include <string.h>
+
+#ifdef ESP_PLATFORM
+#include "esp_cpu.h"
+#include "esp_idf_version.h"
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static uint32_t kwsCycleCount() {
+#ifdef ESP_PLATFORM
+    #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    return (uint32_t)esp_cpu_get_cycle_count();
+    #else
+    return esp_cpu_get_ccount();
+    #endif
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)audio_processing::audioMicros();
+#endif
+}
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + 15) & ~(size_t)15;
+}
+
+// acc * multiplier * 2^-(31 + shift), rounded to nearest
+static inline int32_t requantize(int32_t acc, int32_t multiplier, int shift) {
+    int total = 31 + shift;
+    int64_t product = (int64_t)acc * multiplier;
+    return (int32_t)((product + ((int64_t)1 << (total - 1))) >> total);
+}
+
+static inline int8_t saturate(int32_t value, int32_t low) {
+    if (value < low) {
+        return (int8_t)low;
+    }
+    return (int8_t)(value > 127 ? 127 : value);
+}
+
+KwsConfig defaultKwsConfig(int sample_rate) {
+    KwsConfig config;
+    config.sample_rate = sample_rate;
+    config.hop_frames = 2;
+    config.smoothing = 4;
+    config.threshold = 0.8f;
+    config.refractory_ms = 1000;
+    return config;
+}
+
+static LogMelConfig frontEndConfig(const KwsModel& model, const KwsConfig& config) {
+    LogMelConfig mel = defaultLogMelConfig(config.sample_rate);
+    mel.mel_bins = model.input_bins;
+    return mel;
+}
+
+// Largest layer output in bytes, walking the shapes through the network
+static size_t largestActivation(const KwsModel& model) {
+    size_t largest = 0;
+    int frames = model.input_frames;
+    for (int i = 0; i < model.layer_count; i++) {
+        const KwsLayer& layer = model.layers[i];
+        switch (layer.type) {
+            case KwsLayerType::CONV1D:
+                frames = frames >= layer.kernel ? (frames - layer.kernel) / layer.stride + 1 : 0;
+                break;
+            case KwsLayerType::AVG_POOL:
+            case KwsLayerType::FULLY_CONNECTED:
+                frames = 1;
+                break;
+            default:
+                break;
+        }
+        size_t bytes = (size_t)frames * layer.out_channels;
+        if (bytes > largest) {
+            largest = bytes;
+        }
+    }
+    return largest;
+}
+
+size_t KeywordSpotter::arenaBytes(const KwsModel& model) {
+    // The input ring is stored twice so every window is contiguous
+    size_t ring = alignUp(2 * (size_t)model.input_frames * model.input_bins);
+    return ring + 2 * alignUp(largestActivation(model));
+}
+
+KeywordSpotter::KeywordSpotter(const KwsModel& model, const KwsConfig& config, void* arena, size_t arena_bytes)
+    : model_(model), config_(config), frontend_(frontEndConfig(model, config)), ready_(false),
+      arena_(static_cast<int8_t*>(arena)), arena_bytes_(arena_bytes), ring_(nullptr),
+      act_bytes_(0), ring_head_(0), frames_(0), since_inference_(0), refractory_frames_(0),
+      last_hit_frame_(0), hit_in_call_(false), history_count_(0), history_pos_(0) {
+    act_[0] = nullptr;
+    act_[1] = nullptr;
+    memset(raw_, 0, sizeof(raw_));
+    memset(smoothed_, 0, sizeof(smoothed_));
+    memset(&stats_, 0, sizeof(stats_));
+    on_frame_ = [this](const float* features) {
+        if (pushFeatures(features)) {
+            hit_in_call_ = true;
+        }
+    };
+}
+
+bool KeywordSpotter::init() {
+    ready_ = false;
+    if (model_.layers == nullptr || model_.layer_count == 0 || model_.class_count == 0 ||
+        model_.class_count > MAX_CLASSES || model_.first_keyword >= model_.class_count) {
+        AUDIO_LOGF("Keyword model is invalid\n");
+        return false;
+    }
+    for (uint8_t i = 0; i < model_.layer_count; i++) {
+        const KwsLayer& layer = model_.layers[i];
+        // Pooling layers have no requantization
+        for (uint16_t c = 0; layer.shift != nullptr && c < layer.out_channels; c++) {
+            if (layer.shift[c] < 0 || layer.shift[c] > DSPM_REQUANT_MAX_SHIFT) {
+                AUDIO_LOGF("Keyword layer %u has a requantization scale of one or more\n", (unsigned)i);
+                return false;
+            }
+        }
+    }
+    const KwsLayer& last = model_.layers[model_.layer_count - 1];
+    if (last.type != KwsLayerType::FULLY_CONNECTED || last.out_channels != model_.class_count) {
+        AUDIO_LOGF("Keyword model must end in a %u-way fully connected layer\n", (unsigned)model_.class_count);
+        return false;
+    }
+    size_t needed = arenaBytes(model_);
+    if (arena_ == nullptr || arena_bytes_ < needed) {
+        AUDIO_LOGF("Keyword arena too small: %u bytes, need %u\n", (unsigned)arena_bytes_, (unsigned)needed);
+        return false;
+    }
+    if (config_.smoothing < 1 || config_.smoothing > MAX_SMOOTHING) {
+        config_.smoothing = config_.smoothing < 1 ? 1 : MAX_SMOOTHING;
+    }
+    if (config_.hop_frames < 1) {
+        config_.hop_frames = 1;
+    }
+
+    size_t ring = alignUp(2 * (size_t)model_.input_frames * model_.input_bins);
+    act_bytes_ = alignUp(largestActivation(model_));
+    ring_ = arena_;
+    act_[0] = arena_ + ring;
+    act_[1] = act_[0] + act_bytes_;
+    refractory_frames_ = config_.refractory_ms / (uint32_t)(frontend_.hopSamples() * 1000 / config_.sample_rate);
+    ready_ = true;
+    reset();
+    return true;
+}
+
+void KeywordSpotter::reset() {
+    frontend_.reset();
+    if (ring_ != nullptr) {
+        memset(ring_, (int8_t)model_.input.zero_point, 2 * (size_t)model_.input_frames * model_.input_bins);
+    }
+    ring_head_ = 0;
+    frames_ = 0;
+    since_inference_ = 0;
+    last_hit_frame_ = 0;
+    history_count_ = 0;
+    history_pos_ = 0;
+    memset(raw_, 0, sizeof(raw_));
+    memset(smoothed_, 0, sizeof(smoothed_));
+}
+
+bool KeywordSpotter::feed(const int16_t* samples, size_t count) {
+    if (!ready_ || samples == nullptr) {
+        return false;
+    }
+    hit_in_call_ = false;
+    frontend_.feed(samples, count, on_frame_);
+    return hit_in_call_;
+}
+
+bool KeywordSpotter::pushFeatures(const float* features) {
+    if (!ready_) {
+        return false;
+    }
+
+    // Quantize into both copies of the ring slot
+    const int bins = model_.input_bins;
+    const float inv_scale = 1.0f / model_.input.scale;
+    int8_t* slot = ring_ + (size_t)ring_head_ * bins;
+    for (int i = 0; i < bins; i++) {
+        int32_t q = (int32_t)lrintf(features[i] * inv_scale) + model_.input.zero_point;
+        slot[i] = saturate(q, -128);
+    }
+    memcpy(slot + (size_t)model_.input_frames * bins, slot, bins);
+    ring_head_ = (ring_head_ + 1) % model_.input_frames;
+    frames_++;
+
+    if (frames_ < model_.input_frames || ++since_inference_ < config_.hop_frames) {
+        return false;
+    }
+    since_inference_ = 0;
+    infer();
+    return classify();
+}
+
+const int8_t* KeywordSpotter::infer() {
+    if (!ready_) {
+        return nullptr;
+    }
+    uint32_t start = kwsCycleCount();
+
+    // Oldest frame first: ring_head_ is the next slot to overwrite
+    const int8_t* input = ring_ + (size_t)ring_head_ * model_.input_bins;
+    int frames = model_.input_frames;
+    int8_t* output = act_[0];
+    for (int i = 0; i < model_.layer_count; i++) {
+        int out_frames = 0;
+        runLayer(model_.layers[i], input, frames, output, &out_frames);
+        input = output;
+        frames = out_frames;
+        output = (output == act_[0]) ? act_[1] : act_[0];
+    }
+
+    uint32_t cycles = kwsCycleCount() - start;
+    stats_.inferences++;
+    stats_.last_cycles = cycles;
+    stats_.total_cycles += cycles;
+    if (cycles > stats_.max_cycles) {
+        stats_.max_cycles = cycles;
+    }
+    return input;
+}
+
+void KeywordSpotter::runLayer(const KwsLayer& layer, const int8_t* input, int in_frames,
+                              int8_t* output, int* out_frames) {
+    // Zero point of this layer's input is the previous layer's output
+    const KwsLayer* previous = &layer == model_.layers ? nullptr : &layer - 1;
+    const int32_t in_zp = previous ? previous->output.zero_point : model_.input.zero_point;
+    const float in_scale = previous ? previous->output.scale : model_.input.scale;
+    const int32_t out_zp = layer.output.zero_point;
+    const int32_t low = layer.relu ? out_zp : -128;
+    const int cin = layer.in_channels;
+    const int cout = layer.out_channels;
+
+    dspm_requant_s8_t rq;
+    rq.bias = layer.bias;
+    rq.multiplier = layer.multiplier;
+    rq.shift = layer.shift;
+    rq.input_offset = -in_zp;
+    rq.output_offset = out_zp;
+    rq.act_min = low;
+    rq.act_max = 127;
+
+    switch (layer.type) {
+        case KwsLayerType::CONV1D: {
+            int frames = (in_frames - layer.kernel) / layer.stride + 1;
+            if (layer.packed) {
+                dsps_conv1d_s8(input, in_frames, cin, layer.packed, cout, layer.kernel, layer.stride, &rq, output);
+            } else {
+                dsps_conv1d_s8_ref(input, in_frames, cin, layer.weights, cout, layer.kernel, layer.stride, &rq, output);
+            }
+            *out_frames = frames;
+            break;
+        }
+        case KwsLayerType::DEPTHWISE_CONV1D: {
+            const int pad = layer.kernel / 2;
+            for (int t = 0; t < in_frames; t++) {
+                for (int c = 0; c < cin; c++) {
+                    int32_t acc = layer.bias[c];
+                    for (int k = 0; k < layer.kernel; k++) {
+                        int src = t + k - pad;
+                        if (src < 0 || src >= in_frames) {
+                            continue;   // Padding is real zero
+                        }
+                        acc += (int32_t)layer.weights[k * cin + c] * ((int32_t)input[src * cin + c] - in_zp);
+                    }
+                    output[t * cin + c] = saturate(requantize(acc, layer.multiplier[c], layer.shift[c]) + out_zp, low);
+                }
+            }
+            *out_frames = in_frames;
+            break;
+        }
+        case KwsLayerType::POINTWISE:
+        case KwsLayerType::FULLY_CONNECTED: {
+            // Fully connected flattens whatever time steps are left
+            int rows = layer.type == KwsLayerType::POINTWISE ? in_frames : 1;
+            int width = layer.type == KwsLayerType::POINTWISE ? cin : in_frames * cin;
+            if (layer.packed) {
+                dspm_gemm_s8(input, width, rows, width, layer.packed, cout, &rq, output, cout);
+            } else {
+                dspm_gemm_s8_ref(input, width, rows, width, layer.weights, cout, &rq, output, cout);
+            }
+            *out_frames = rows;
+            break;
+        }
+        case KwsLayerType::AVG_POOL: {
+            // Only cin values per inference, so float rescaling is fine here
+            float rescale = in_scale / (layer.output.scale * (float)in_frames);
+            for (int c = 0; c < cin; c++) {
+                int32_t sum = 0;
+                for (int t = 0; t < in_frames; t++) {
+                    sum += (int32_t)input[t * cin + c] - in_zp;
+                }
+                output[c] = saturate((int32_t)lrintf(sum * rescale) + out_zp, low);
+            }
+            *out_frames = 1;
+            break;
+        }
+    }
+}
+
+bool KeywordSpotter::classify() {
+    const int classes = model_.class_count;
+    const int8_t* logits = act_[(model_.layer_count - 1) % 2];
+    const KwsQuant& quant = model_.layers[model_.layer_count - 1].output;
+
+    float max_logit = -1e30f;
+    for (int c = 0; c < classes; c++) {
+        raw_[c] = quant.scale * (float)(logits[c] - quant.zero_point);
+        if (raw_[c] > max_logit) {
+            max_logit = raw_[c];
+        }
+    }
+    float sum = 0.0f;
+    for (int c = 0; c < classes; c++) {
+        raw_[c] = expf(raw_[c] - max_logit);
+        sum += raw_[c];
+    }
+    for (int c = 0; c < classes; c++) {
+        raw_[c] /= sum;
+    }
+
+    // Average over the last smoothing inferences
+    memcpy(history_[history_pos_], raw_, classes * sizeof(float));
+    history_pos_ = (history_pos_ + 1) % config_.smoothing;
+    if (history_count_ < config_.smoothing) {
+        history_count_++;
+    }
+    int best = -1;
+    for (int c = 0; c < classes; c++) {
+        float total = 0.0f;
+        for (int h = 0; h < history_count_; h++) {
+            total += history_[h][c];
+        }
+        smoothed_[c] = total / history_count_;
+        if (c >= model_.first_keyword && (best < 0 || smoothed_[c] > smoothed_[best])) {
+            best = c;
+        }
+    }
+
+    // A full window of evidence is required, and one hit per refractory period
+    if (best < 0 || history_count_ < config_.smoothing || smoothed_[best] < config_.threshold) {
+        return false;
+    }
+    if (last_hit_frame_ > 0 && frames_ - last_hit_frame_ < refractory_frames_) {
+        return false;
+    }
+    last_hit_frame_ = frames_;
+    stats_.hits++;
+    if (hit_) {
+        KwsHit hit;
+        hit.keyword = best;
+        hit.label = model_.labels ? model_.labels[best] : nullptr;
+        hit.score = smoothed_[best];
+        hit.frame = frames_;
+        hit_(hit);
+    }
+    return true;
+}
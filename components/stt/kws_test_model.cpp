@@ -0,0 +1,174 @@
+#include "keyword_spotter.h"
+
+// Hand-built model for host tests and bring-up. The weights are generated
+// at compile time into const tables (flash on target), with every
+// requantization scale a power of two so the expected outputs can be
+// checked by hand:
+//
+//   conv1     40 bins -> 8 channels, kernel 3, stride 2: channel g sums
+//             (x - THRESHOLD) over the five mel bins of group g, ReLU
+//   dw/pw x2  [0.25 0.5 0.25] temporal smoothing, identity mixing, ReLU
+//   pool      mean over time
+//   fc        silence = 2 - 0.05 * sum(all groups)
+//             unknown = 0.1 * (groups 0-2 - groups 4-5)      (< 1.1 kHz)
+//             keyword = 0.1 * (groups 4-5 - groups 0-2)      (1.8-3.7 kHz)
+
+namespace {
+
+constexpr int BINS = 40;
+constexpr int FRAMES = 49;
+constexpr int CHANNELS = 8;
+constexpr int CLASSES = 3;
+constexpr int GROUP = BINS / CHANNELS;
+constexpr int KERNEL = 3;
+
+constexpr float INPUT_SCALE = 0.25f;        // Log-mel in natural log units
+constexpr float ACT_SCALE = 2.0f;           // All hidden activations
+constexpr int32_t ACT_ZERO = -128;          // ReLU outputs start at the bottom
+constexpr float LOGIT_SCALE = 0.125f;
+constexpr double THRESHOLD = -6.0;          // ln power counted as "active"
+
+template <typename T, int N>
+struct Table {
+    T v[N];
+};
+
+template <int N>
+struct Requant {
+    Table<int32_t, N> multiplier;
+    Table<int8_t, N> shift;
+};
+
+// Q31 multiplier and right shift with multiplier * 2^-(31 + shift) == scale
+template <int N>
+constexpr Requant<N> requant(double scale) {
+    int shift = 0;
+    while (scale < 0.5) {
+        scale *= 2.0;
+        shift++;
+    }
+    double q = scale * 2147483648.0 + 0.5;
+    int32_t multiplier = q >= 2147483647.0 ? 2147483647 : (int32_t)q;
+    Requant<N> r{};
+    for (int i = 0; i < N; i++) {
+        r.multiplier.v[i] = multiplier;
+        r.shift.v[i] = (int8_t)shift;
+    }
+    return r;
+}
+
+// Weight quantization: value / scale, rounded
+constexpr int8_t q8(double value, double scale) {
+    double q = value / scale;
+    return (int8_t)(q >= 0 ? q + 0.5 : q - 0.5);
+}
+
+constexpr int32_t q32(double value, double scale) {
+    double q = value / scale;
+    return (int32_t)(q >= 0 ? q + 0.5 : q - 0.5);
+}
+
+constexpr double CONV_W_SCALE = 1.0 / 64;
+constexpr double DW_W_SCALE = 1.0 / 128;
+constexpr double PW_W_SCALE = 1.0 / 64;
+constexpr double FC_W_SCALE = 1.0 / 1024;
+
+constexpr Table<int8_t, CHANNELS * KERNEL * BINS> makeConvWeights() {
+    Table<int8_t, CHANNELS * KERNEL * BINS> t{};
+    for (int o = 0; o < CHANNELS; o++) {
+        for (int k = 0; k < KERNEL; k++) {
+            for (int i = o * GROUP; i < (o + 1) * GROUP; i++) {
+                t.v[(o * KERNEL + k) * BINS + i] = q8(1.0, CONV_W_SCALE);
+            }
+        }
+    }
+    return t;
+}
+
+constexpr Table<int32_t, CHANNELS> makeConvBias() {
+    Table<int32_t, CHANNELS> t{};
+    for (int o = 0; o < CHANNELS; o++) {
+        t.v[o] = q32(-THRESHOLD * GROUP * KERNEL, INPUT_SCALE * CONV_W_SCALE);
+    }
+    return t;
+}
+
+constexpr Table<int8_t, KERNEL * CHANNELS> makeDepthwiseWeights() {
+    Table<int8_t, KERNEL * CHANNELS> t{};
+    for (int c = 0; c < CHANNELS; c++) {
+        t.v[0 * CHANNELS + c] = q8(0.25, DW_W_SCALE);
+        t.v[1 * CHANNELS + c] = q8(0.5, DW_W_SCALE);
+        t.v[2 * CHANNELS + c] = q8(0.25, DW_W_SCALE);
+    }
+    return t;
+}
+
+constexpr Table<int8_t, CHANNELS * CHANNELS> makePointwiseWeights() {
+    Table<int8_t, CHANNELS * CHANNELS> t{};
+    for (int o = 0; o < CHANNELS; o++) {
+        t.v[o * CHANNELS + o] = q8(1.0, PW_W_SCALE);
+    }
+    return t;
+}
+
+constexpr bool isLowGroup(int g) {
+    return g <= 2;
+}
+
+constexpr bool isKeywordGroup(int g) {
+    return g == 4 || g == 5;
+}
+
+constexpr Table<int8_t, CLASSES * CHANNELS> makeFcWeights() {
+    Table<int8_t, CLASSES * CHANNELS> t{};
+    for (int g = 0; g < CHANNELS; g++) {
+        double low = isLowGroup(g) ? 1.0 : 0.0;
+        double kw = isKeywordGroup(g) ? 1.0 : 0.0;
+        t.v[0 * CHANNELS + g] = q8(-0.05, FC_W_SCALE);
+        t.v[1 * CHANNELS + g] = q8(0.1 * (low - kw), FC_W_SCALE);
+        t.v[2 * CHANNELS + g] = q8(0.1 * (kw - low), FC_W_SCALE);
+    }
+    return t;
+}
+
+constexpr Table<int32_t, CLASSES> FC_BIAS = {{q32(2.0, ACT_SCALE * FC_W_SCALE), 0, 0}};
+constexpr Table<int32_t, CHANNELS> ZERO_BIAS = {};
+
+constexpr auto CONV_W = makeConvWeights();
+constexpr auto CONV_B = makeConvBias();
+constexpr auto CONV_Q = requant<CHANNELS>(INPUT_SCALE * CONV_W_SCALE / ACT_SCALE);
+constexpr auto DW_W = makeDepthwiseWeights();
+constexpr auto DW_Q = requant<CHANNELS>(ACT_SCALE * DW_W_SCALE / ACT_SCALE);
+constexpr auto PW_W = makePointwiseWeights();
+constexpr auto PW_Q = requant<CHANNELS>(ACT_SCALE * PW_W_SCALE / ACT_SCALE);
+constexpr auto FC_W = makeFcWeights();
+constexpr auto FC_Q = requant<CLASSES>(ACT_SCALE * FC_W_SCALE / LOGIT_SCALE);
+
+const KwsLayer LAYERS[] = {
+    {KwsLayerType::CONV1D, BINS, CHANNELS, KERNEL, 2, true,
+     CONV_W.v, CONV_B.v, CONV_Q.multiplier.v, CONV_Q.shift.v, {ACT_SCALE, ACT_ZERO}},
+    {KwsLayerType::DEPTHWISE_CONV1D, CHANNELS, CHANNELS, KERNEL, 1, true,
+     DW_W.v, ZERO_BIAS.v, DW_Q.multiplier.v, DW_Q.shift.v, {ACT_SCALE, ACT_ZERO}},
+    {KwsLayerType::POINTWISE, CHANNELS, CHANNELS, 1, 1, true,
+     PW_W.v, ZERO_BIAS.v, PW_Q.multiplier.v, PW_Q.shift.v, {ACT_SCALE, ACT_ZERO}},
+    {KwsLayerType::DEPTHWISE_CONV1D, CHANNELS, CHANNELS, KERNEL, 1, true,
+     DW_W.v, ZERO_BIAS.v, DW_Q.multiplier.v, DW_Q.shift.v, {ACT_SCALE, ACT_ZERO}},
+    {KwsLayerType::POINTWISE, CHANNELS, CHANNELS, 1, 1, true,
+     PW_W.v, ZERO_BIAS.v, PW_Q.multiplier.v, PW_Q.shift.v, {ACT_SCALE, ACT_ZERO}},
+    {KwsLayerType::AVG_POOL, CHANNELS, CHANNELS, 0, 1, true,
+     nullptr, nullptr, nullptr, nullptr, {ACT_SCALE, ACT_ZERO}},
+    {KwsLayerType::FULLY_CONNECTED, CHANNELS, CLASSES, 1, 1, false,
+     FC_W.v, FC_BIAS.v, FC_Q.multiplier.v, FC_Q.shift.v, {LOGIT_SCALE, 0}},
+};
+
+const char* const LABELS[] = {"_silence_", "_unknown_", "keyword"};
+
+const KwsModel MODEL = {
+    FRAMES, BINS, {INPUT_SCALE, 0}, LAYERS, sizeof(LAYERS) / sizeof(LAYERS[0]), CLASSES, 2, LABELS
+};
+
+} // namespace
+
+const KwsModel& kwsTestModel() {
+    return MODEL;
+}
@@ -0,0 +1,180 @@
+#include "log_mel.h"
+#include <math.h>
+#include <string.h>
+
+static const float INT16_SCALE = 1.0f / 32768.0f;
+
+LogMelConfig defaultLogMelConfig(int sample_rate) {
+    LogMelConfig config;
+    config.sample_rate = sample_rate;
+    config.window_ms = 25;
+    config.hop_ms = 10;
+    config.mel_bins = 80;
+    config.min_hz = 0.0f;
+    config.max_hz = 0.0f;
+    config.power_floor = 1e-10f;
+    return config;
+}
+
+float fastLog(float x) {
+    union {
+        float f;
+        uint32_t i;
+    } bits = {x};
+    int exponent = (int)((bits.i >> 23) & 0xff) - 127;
+    bits.i = (bits.i & 0x007fffff) | 0x3f800000;   // Mantissa in [1, 2)
+    float t = bits.f - 1.0f;
+    // Least-squares fit of log2(1 + t) on [0, 1), exact at t = 0
+    float log2_m = t * (1.4385468f + t * (-0.6780815f + t * (0.3236304f - 0.0842851f * t)));
+    return ((float)exponent + log2_m) * 0.69314718f;
+}
+
+static float hzToMel(float hz) {
+    return 2595.0f * log10f(1.0f + hz / 700.0f);
+}
+
+static float melToHz(float mel) {
+    return 700.0f * (powf(10.0f, mel / 2595.0f) - 1.0f);
+}
+
+LogMelFrontEnd::LogMelFrontEnd(const LogMelConfig& config)
+    : config_(config), pending_count_(0), covered_(0), frames_(0) {
+    window_len_ = (size_t)config_.sample_rate * config_.window_ms / 1000;
+    hop_len_ = (size_t)config_.sample_rate * config_.hop_ms / 1000;
+    if (window_len_ < 2) {
+        window_len_ = 2;
+    }
+    if (hop_len_ < 1 || hop_len_ > window_len_) {
+        hop_len_ = window_len_;
+    }
+    fft_size_ = 4;
+    while ((size_t)fft_size_ < window_len_) {
+        fft_size_ <<= 1;
+    }
+
+    // Periodic Hann
+    window_.resize(window_len_);
+    for (size_t i = 0; i < window_len_; i++) {
+        window_[i] = 0.5f - 0.5f * cosf(2.0f * (float)M_PI * i / window_len_);
+    }
+
+    twiddle_.resize(DSPS_FFT_TWIDDLE_LEN(fft_size_));
+    bitrev_.resize(DSPS_FFT_BITREV_LEN(fft_size_));
+    dsps_fft_plan_init_f32(&plan_, twiddle_.data(), bitrev_.data(), fft_size_);
+
+    buildFilterbank();
+
+    pending_.assign(window_len_, 0.0f);
+    fft_buf_.assign(fft_size_, 0.0f);
+    power_.assign(fft_size_ / 2 + 1, 0.0f);
+    features_.assign(config_.mel_bins, 0.0f);
+}
+
+void LogMelFrontEnd::buildFilterbank() {
+    const int bins = fft_size_ / 2 + 1;
+    const float bin_hz = (float)config_.sample_rate / fft_size_;
+    float max_hz = config_.max_hz > 0.0f ? config_.max_hz : config_.sample_rate / 2.0f;
+    float min_mel = hzToMel(config_.min_hz);
+    float max_mel = hzToMel(max_hz);
+
+    mel_start_.assign(config_.mel_bins, 0);
+    mel_length_.assign(config_.mel_bins, 0);
+    mel_offset_.assign(config_.mel_bins, 0);
+    mel_weights_.clear();
+
+    for (int band = 0; band < config_.mel_bins; band++) {
+        float lo = melToHz(min_mel + (max_mel - min_mel) * band / (config_.mel_bins + 1));
+        float center = melToHz(min_mel + (max_mel - min_mel) * (band + 1) / (config_.mel_bins + 1));
+        float hi = melToHz(min_mel + (max_mel - min_mel) * (band + 2) / (config_.mel_bins + 1));
+
+        mel_offset_[band] = (uint32_t)mel_weights_.size();
+        int start = -1;
+        for (int k = 0; k < bins; k++) {
+            float f = k * bin_hz;
+            float weight = fminf((f - lo) / (center - lo), (hi - f) / (hi - center));
+            if (weight <= 0.0f) {
+                if (start >= 0) {
+                    break;   // Past the triangle
+                }
+                continue;
+            }
+            if (start < 0) {
+                start = k;
+            }
+            mel_weights_.push_back(weight);
+        }
+        mel_start_[band] = (uint16_t)(start >= 0 ? start : 0);
+        mel_length_[band] = (uint16_t)(mel_weights_.size() - mel_offset_[band]);
+    }
+}
+
+void LogMelFrontEnd::reset() {
+    pending_count_ = 0;
+    covered_ = 0;
+    frames_ = 0;
+}
+
+size_t LogMelFrontEnd::feed(const int16_t* samples, size_t count, const FrameCallback& frame) {
+    size_t produced = 0;
+    while (count > 0) {
+        size_t n = window_len_ - pending_count_;
+        if (n > count) {
+            n = count;
+        }
+        float* dst = &pending_[pending_count_];
+        for (size_t i = 0; i < n; i++) {
+            dst[i] = samples[i] * INT16_SCALE;
+        }
+        pending_count_ += n;
+        samples += n;
+        count -= n;
+
+        if (pending_count_ == window_len_) {
+            computeFrame(frame);
+            produced++;
+            // Keep the overlap for the next frame
+            memmove(pending_.data(), &pending_[hop_len_], (window_len_ - hop_len_) * sizeof(float));
+            pending_count_ -= hop_len_;
+            covered_ = pending_count_;
+        }
+    }
+    return produced;
+}
+
+size_t LogMelFrontEnd::flush(const FrameCallback& frame) {
+    size_t produced = 0;
+    if (pending_count_ > covered_) {
+        memset(&pending_[pending_count_], 0, (window_len_ - pending_count_) * sizeof(float));
+        computeFrame(frame);
+        produced = 1;
+    }
+    pending_count_ = 0;
+    covered_ = 0;
+    return produced;
+}
+
+void LogMelFrontEnd::computeFrame(const FrameCallback& frame) {
+    float* buf = fft_buf_.data();
+    for (size_t i = 0; i < window_len_; i++) {
+        buf[i] = pending_[i] * window_[i];
+    }
+    memset(&buf[window_len_], 0, (fft_size_ - window_len_) * sizeof(float));
+
+    dsps_rfft_f32(&plan_, buf);
+    dsps_rfft_power_f32(buf, power_.data(), fft_size_);
+
+    for (int band = 0; band < config_.mel_bins; band++) {
+        const float* weights = &mel_weights_[mel_offset_[band]];
+        const float* power = &power_[mel_start_[band]];
+        float sum = 0.0f;
+        for (int i = 0; i < mel_length_[band]; i++) {
+            sum += weights[i] * power[i];
+        }
+        features_[band] = fastLog(sum > config_.power_floor ? sum : config_.power_floor);
+    }
+
+    frames_++;
+    if (frame) {
+        frame(features_.data());
+    }
+}
@@ -0,0 +1,311 @@
+#include "model_file.h"
+#include "audio_platform.h"
+#include "dspm_gemm_s8.h"
+#include <cstdio>
+#include <cstring>
+
+#ifndef ESP_PLATFORM
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using audio_processing::audioMicros;
+
+static size_t elementBytes(ModelTensorType type) {
+    switch (type) {
+        case ModelTensorType::INT8:
+        case ModelTensorType::INT8_GEMM_PACKED:
+            return 1;
+        case ModelTensorType::INT16:
+            return 2;
+        case ModelTensorType::INT32:
+        case ModelTensorType::FLOAT32:
+            return 4;
+    }
+    return 0;
+}
+
+size_t modelTensorBytes(ModelTensorType type, const uint32_t* dims, uint8_t rank) {
+    if (dims == nullptr || rank == 0 || rank > MODEL_TENSOR_MAX_RANK || elementBytes(type) == 0) {
+        return 0;
+    }
+    if (type == ModelTensorType::INT8_GEMM_PACKED) {
+        return rank == 2 ? dspm_gemm_s8_packed_size((int)dims[0], (int)dims[1]) : 0;
+    }
+    uint64_t bytes = elementBytes(type);
+    for (uint8_t i = 0; i < rank; i++) {
+        bytes *= dims[i];
+        if (bytes > UINT32_MAX) {
+            return 0;
+        }
+    }
+    return (size_t)bytes;
+}
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + MODEL_FILE_ALIGN - 1) & ~(size_t)(MODEL_FILE_ALIGN - 1);
+}
+
+ModelFile::ModelFile() : base_(nullptr), mapped_bytes_(0), open_us_(0), owns_mapping_(false) {
+#ifdef ESP_PLATFORM
+    handle_ = 0;
+#endif
+}
+
+ModelFile::~ModelFile() {
+    close();
+}
+
+bool ModelFile::open(const char* source) {
+    close();
+    if (source == nullptr) {
+        return false;
+    }
+    uint64_t start = audioMicros();
+
+#ifdef ESP_PLATFORM
+    const esp_partition_t* partition = esp_partition_find_first(
+        ESP_PARTITION_TYPE_DATA, (esp_partition_subtype_t)MODEL_PARTITION_SUBTYPE, source);
+    if (partition == nullptr) {
+        AUDIO_LOGF("Model partition '%s' not found\n", source);
+        return false;
+    }
+    const void* mapped = nullptr;
+    esp_err_t err = esp_partition_mmap(partition, 0, partition->size, ESP_PARTITION_MMAP_DATA,
+                                       &mapped, &handle_);
+    if (err != ESP_OK) {
+        AUDIO_LOGF("Model partition '%s' map failed: %d\n", source, (int)err);
+        return false;
+    }
+    size_t bytes = partition->size;
+#else
+    int fd = ::open(source, O_RDONLY);
+    if (fd < 0) {
+        AUDIO_LOGF("Model file '%s' not found\n", source);
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size <= 0) {
+        ::close(fd);
+        AUDIO_LOGF("Model file '%s' is empty\n", source);
+        return false;
+    }
+    size_t bytes = (size_t)st.st_size;
+    void* mapped = mmap(nullptr, bytes, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);    // The mapping keeps the file referenced
+    if (mapped == MAP_FAILED) {
+        AUDIO_LOGF("Model file '%s' map failed\n", source);
+        return false;
+    }
+#endif
+
+    base_ = static_cast<const uint8_t*>(mapped);
+    mapped_bytes_ = bytes;
+    owns_mapping_ = true;
+    if (!validate(base_, bytes)) {
+        AUDIO_LOGF("Model '%s' is not a valid container\n", source);
+        close();
+        return false;
+    }
+    open_us_ = audioMicros() - start;
+    return true;
+}
+
+bool ModelFile::openMemory(const void* data, size_t bytes) {
+    close();
+    if (data == nullptr || ((uintptr_t)data & 15) != 0) {
+        return false;
+    }
+    uint64_t start = audioMicros();
+    if (!validate(static_cast<const uint8_t*>(data), bytes)) {
+        return false;
+    }
+    base_ = static_cast<const uint8_t*>(data);
+    mapped_bytes_ = bytes;
+    owns_mapping_ = false;
+    open_us_ = audioMicros() - start;
+    return true;
+}
+
+void ModelFile::unmap() {
+    if (!owns_mapping_ || base_ == nullptr) {
+        return;
+    }
+#ifdef ESP_PLATFORM
+    esp_partition_munmap(handle_);
+    handle_ = 0;
+#else
+    munmap(const_cast<uint8_t*>(base_), mapped_bytes_);
+#endif
+}
+
+void ModelFile::close() {
+    unmap();
+    base_ = nullptr;
+    mapped_bytes_ = 0;
+    owns_mapping_ = false;
+}
+
+// Header and table only: O(tensors), never touches the blobs
+bool ModelFile::validate(const uint8_t* base, size_t bytes) {
+    ModelFileHeader header;
+    if (bytes < sizeof(header)) {
+        return false;
+    }
+    memcpy(&header, base, sizeof(header));
+    if (header.magic != MODEL_FILE_MAGIC || header.version != MODEL_FILE_VERSION ||
+        header.header_bytes != sizeof(ModelFileHeader) || header.file_bytes > bytes ||
+        memchr(header.arch, 0, sizeof(header.arch)) == nullptr) {
+        return false;
+    }
+    uint64_t table_end = (uint64_t)header.table_offset + (uint64_t)header.tensor_count * sizeof(ModelTensorEntry);
+    if (header.table_offset < sizeof(header) || (header.table_offset & 3) != 0 || table_end > header.file_bytes) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < header.tensor_count; i++) {
+        ModelTensorEntry entry;
+        memcpy(&entry, base + header.table_offset + (size_t)i * sizeof(entry), sizeof(entry));
+        if (memchr(entry.name, 0, sizeof(entry.name)) == nullptr || entry.name[0] == '\0') {
+            return false;
+        }
+        size_t expected = modelTensorBytes(entry.type, entry.dims, entry.rank);
+        if (expected == 0 || entry.bytes != expected || (entry.offset % MODEL_FILE_ALIGN) != 0 ||
+            entry.offset < table_end || (uint64_t)entry.offset + entry.bytes > header.file_bytes) {
+            AUDIO_LOGF("Model tensor %u (%.*s) is malformed\n", (unsigned)i, MODEL_TENSOR_NAME_LEN, entry.name);
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* ModelFile::arch() const {
+    return base_ ? reinterpret_cast<const ModelFileHeader*>(base_)->arch : "";
+}
+
+uint32_t ModelFile::tensorCount() const {
+    return base_ ? reinterpret_cast<const ModelFileHeader*>(base_)->tensor_count : 0;
+}
+
+size_t ModelFile::fileBytes() const {
+    return base_ ? reinterpret_cast<const ModelFileHeader*>(base_)->file_bytes : 0;
+}
+
+bool ModelFile::tensor(uint32_t index, ModelTensor* out) const {
+    if (base_ == nullptr || out == nullptr || index >= tensorCount()) {
+        return false;
+    }
+    const ModelFileHeader* header = reinterpret_cast<const ModelFileHeader*>(base_);
+    const ModelTensorEntry* entry = reinterpret_cast<const ModelTensorEntry*>(
+        base_ + header->table_offset + (size_t)index * sizeof(ModelTensorEntry));
+    out->name = entry->name;
+    out->type = entry->type;
+    out->rank = entry->rank;
+    memcpy(out->dims, entry->dims, sizeof(out->dims));
+    out->data = base_ + entry->offset;
+    out->bytes = entry->bytes;
+    out->scale = entry->scale;
+    out->zero_point = entry->zero_point;
+    return true;
+}
+
+bool ModelFile::find(const char* name, ModelTensor* out) const {
+    if (name == nullptr) {
+        return false;
+    }
+    ModelTensor candidate;
+    for (uint32_t i = 0; i < tensorCount(); i++) {
+        if (tensor(i, &candidate) && strcmp(candidate.name, name) == 0) {
+            if (out) {
+                *out = candidate;
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+ModelFileWriter::ModelFileWriter(const char* arch) : arch_(arch ? arch : "") {}
+
+bool ModelFileWriter::add(const char* name, ModelTensorType type, const uint32_t* dims, uint8_t rank,
+                          const void* data, float scale, int32_t zero_point) {
+    size_t bytes = modelTensorBytes(type, dims, rank);
+    if (name == nullptr || name[0] == '\0' || strlen(name) >= MODEL_TENSOR_NAME_LEN ||
+        data == nullptr || bytes == 0) {
+        return false;
+    }
+    for (const Pending& existing : tensors_) {
+        if (strcmp(existing.entry.name, name) == 0) {
+            return false;
+        }
+    }
+    Pending pending;
+    memset(&pending.entry, 0, sizeof(pending.entry));
+    strncpy(pending.entry.name, name, MODEL_TENSOR_NAME_LEN - 1);
+    pending.entry.type = type;
+    pending.entry.rank = rank;
+    memcpy(pending.entry.dims, dims, rank * sizeof(uint32_t));
+    pending.entry.bytes = (uint32_t)bytes;
+    pending.entry.scale = scale;
+    pending.entry.zero_point = zero_point;
+    pending.data.assign(static_cast<const uint8_t*>(data), static_cast<const uint8_t*>(data) + bytes);
+    tensors_.push_back(pending);
+    return true;
+}
+
+bool ModelFileWriter::addPackedGemm(const char* name, const int8_t* w, uint32_t n, uint32_t k,
+                                    float scale, int32_t zero_point) {
+    const uint32_t dims[2] = {n, k};
+    size_t bytes = modelTensorBytes(ModelTensorType::INT8_GEMM_PACKED, dims, 2);
+    if (w == nullptr || bytes == 0) {
+        return false;
+    }
+    std::vector<int8_t> packed(bytes);
+    if (dspm_gemm_s8_pack(w, (int)n, (int)k, packed.data()) != DSP_RET_OK) {
+        return false;
+    }
+    return add(name, ModelTensorType::INT8_GEMM_PACKED, dims, 2, packed.data(), scale, zero_point);
+}
+
+std::vector<uint8_t> ModelFileWriter::build() const {
+    ModelFileHeader header;
+    memset(&header, 0, sizeof(header));
+    header.magic = MODEL_FILE_MAGIC;
+    header.version = MODEL_FILE_VERSION;
+    header.header_bytes = sizeof(ModelFileHeader);
+    strncpy(header.arch, arch_.c_str(), sizeof(header.arch) - 1);
+    header.tensor_count = (uint32_t)tensors_.size();
+    header.table_offset = sizeof(ModelFileHeader);
+
+    size_t offset = alignUp(header.table_offset + tensors_.size() * sizeof(ModelTensorEntry));
+    std::vector<ModelTensorEntry> table;
+    for (const Pending& pending : tensors_) {
+        ModelTensorEntry entry = pending.entry;
+        entry.offset = (uint32_t)offset;
+        table.push_back(entry);
+        offset = alignUp(offset + pending.data.size());
+    }
+    header.file_bytes = (uint32_t)offset;
+
+    std::vector<uint8_t> file(offset, 0);
+    memcpy(file.data(), &header, sizeof(header));
+    if (!table.empty()) {
+        memcpy(file.data() + header.table_offset, table.data(), table.size() * sizeof(ModelTensorEntry));
+    }
+    for (size_t i = 0; i < tensors_.size(); i++) {
+        memcpy(file.data() + table[i].offset, tensors_[i].data.data(), tensors_[i].data.size());
+    }
+    return file;
+}
+
+bool ModelFileWriter::write(const char* path) const {
+    std::vector<uint8_t> file = build();
+    FILE* out = fopen(path, "wb");
+    if (out == nullptr) {
+        return false;
+    }
+    bool ok = fwrite(file.data(), 1, file.size(), out) == file.size();
+    return fclose(out) == 0 && ok;
+}
@@ -0,0 +1,412 @@
+#include "recognition_service.h"
+#include <chrono>
+#include <cstring>
+#include <memory>
+#include <utility>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+using audio_processing::audioMicros;
+
+RecognitionServiceConfig defaultRecognitionServiceConfig() {
+    RecognitionServiceConfig config;
+    config.queue_depth = 4;
+    config.max_job_frames = 1000;        // 10 s of 10 ms frames, the endpointer maximum
+    config.feed_chunk_samples = 1600;
+    config.cancel_stale = true;
+    config.name = "recognizer";
+    // Below BT and SD so decoding only takes the I/O core's idle time
+    config.core = PIPELINE_CORE_IO;
+    config.priority = 1;
+    config.stack_size = 16384;
+    return config;
+}
+
+RecognitionService::RecognitionService(SpeechRecognizer& recognizer, const RecognitionServiceConfig& config)
+    : recognizer_(recognizer), config_(config), head_(0), count_(0), busy_(false), cancel_current_(false),
+      next_id_(0), running_(false), finished_(true) {
+    if (config_.queue_depth == 0) {
+        config_.queue_depth = 1;
+    }
+    if (config_.feed_chunk_samples == 0) {
+        config_.feed_chunk_samples = 1600;
+    }
+    clearJob(current_);
+    memset(&stats_, 0, sizeof(stats_));
+#ifdef ESP_PLATFORM
+    task_ = nullptr;
+#endif
+}
+
+RecognitionService::~RecognitionService() {
+    stop();
+}
+
+void RecognitionService::clearJob(Job& job) {
+    job.id = 0;
+    std::vector<int16_t>().swap(job.audio);     // The buffer was the caller's; free it
+    job.frames.clear();                         // Frames go back to their pool
+    job.frame_samples = 0;
+    job.done = nullptr;
+    job.submit_us = 0;
+}
+
+bool RecognitionService::start() {
+    if (running_.load()) {
+        return true;
+    }
+
+    // Everything a job needs is sized here, so submit() does not allocate
+    // beyond what the caller hands over
+    queue_.clear();
+    queue_.resize(config_.queue_depth);
+    for (Job& job : queue_) {
+        clearJob(job);
+        job.frames.reserve(config_.max_job_frames);
+    }
+    current_.frames.reserve(config_.max_job_frames);
+    cancelled_.reserve(config_.queue_depth + 1);
+    reporting_.reserve(config_.queue_depth + 1);
+    head_ = 0;
+    count_ = 0;
+    running_.store(true);
+    finished_.store(false);
+
+#ifdef ESP_PLATFORM
+    TaskHandle_t handle = nullptr;
+    BaseType_t result = xTaskCreatePinnedToCore(taskEntry, config_.name, config_.stack_size, this,
+                                                config_.priority, &handle, config_.core);
+    if (result != pdPASS) {
+        AUDIO_LOGF("Failed to create task %s\n", config_.name);
+        running_.store(false);
+        finished_.store(true);
+        return false;
+    }
+    task_ = handle;
+#else
+    thread_ = std::thread(taskEntry, this);
+#endif
+    return true;
+}
+
+void RecognitionService::stop() {
+    if (!running_.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        cancel_current_.store(true);
+    }
+    wake_.notify_all();
+
+#ifdef ESP_PLATFORM
+    while (!finished_.load()) {
+        vTaskDelay(1);
+    }
+    task_ = nullptr;
+#else
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+#endif
+
+    // The worker is gone: report what it left behind from here
+    std::vector<Cancelled> left;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (count_ > 0) {
+            cancelPendingLocked(0);
+        }
+        left.swap(cancelled_);
+    }
+    for (const Cancelled& cancelled : left) {
+        reportCancelled(cancelled);
+    }
+    idle_.notify_all();
+}
+
+void RecognitionService::taskEntry(void* arg) {
+    RecognitionService* service = static_cast<RecognitionService*>(arg);
+    service->run();
+    service->finished_.store(true);
+#ifdef ESP_PLATFORM
+    vTaskDelete(NULL);
+#endif
+}
+
+RecognitionService::Job* RecognitionService::reserveLocked() {
+    if (count_ >= queue_.size()) {
+        stats_.rejected++;
+        return nullptr;
+    }
+    return &queue_[(head_ + count_) % queue_.size()];
+}
+
+uint32_t RecognitionService::commitLocked(Job& job, ResultCallback done) {
+    if (++next_id_ == 0) {
+        next_id_ = 1;
+    }
+    job.id = next_id_;
+    job.done = std::move(done);
+    job.submit_us = audioMicros();
+    count_++;
+    stats_.submitted++;
+    stats_.queue_depth = (uint32_t)count_;
+    if (stats_.queue_depth > stats_.max_queue_depth) {
+        stats_.max_queue_depth = stats_.queue_depth;
+    }
+    wake_.notify_one();
+    return job.id;
+}
+
+// Remove the pending job at position index (from the head), keeping order
+void RecognitionService::cancelPendingLocked(size_t index) {
+    const size_t depth = queue_.size();
+    Job& job = queue_[(head_ + index) % depth];
+    Cancelled cancelled;
+    cancelled.id = job.id;
+    cancelled.done = std::move(job.done);
+    cancelled.submit_us = job.submit_us;
+    cancelled_.push_back(std::move(cancelled));
+    clearJob(job);
+
+    for (size_t i = index; i + 1 < count_; i++) {
+        std::swap(queue_[(head_ + i) % depth], queue_[(head_ + i + 1) % depth]);
+    }
+    count_--;
+    stats_.queue_depth = (uint32_t)count_;
+    wake_.notify_one();
+}
+
+// Whether count more pending jobs fit in cancelled_ without growing it
+bool RecognitionService::canCancelLocked(size_t count) const {
+    return cancelled_.size() + count <= config_.queue_depth + 1;
+}
+
+void RecognitionService::cancelStaleLocked() {
+    while (count_ > 0 && canCancelLocked(1)) {
+        cancelPendingLocked(0);
+    }
+    if (current_.id != 0) {
+        cancel_current_.store(true);
+    }
+}
+
+uint32_t RecognitionService::submit(std::vector<int16_t>&& audio, ResultCallback done) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_.load()) {
+        return 0;
+    }
+    if (config_.cancel_stale) {
+        if (!canCancelLocked(count_)) {
+            stats_.rejected++;
+            return 0;
+        }
+        cancelStaleLocked();
+    }
+    Job* job = reserveLocked();
+    if (job == nullptr) {
+        return 0;
+    }
+    job->audio = std::move(audio);
+    return commitLocked(*job, std::move(done));
+}
+
+uint32_t RecognitionService::submit(const Utterance& utterance, ResultCallback done) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!running_.load()) {
+        return 0;
+    }
+    if (utterance.frame_count > config_.max_job_frames) {
+        AUDIO_LOGF("Utterance of %u frames exceeds max_job_frames\n", (unsigned)utterance.frame_count);
+        stats_.rejected++;
+        return 0;
+    }
+    if (config_.cancel_stale) {
+        if (!canCancelLocked(count_)) {
+            stats_.rejected++;
+            return 0;
+        }
+        cancelStaleLocked();
+    }
+    Job* job = reserveLocked();
+    if (job == nullptr) {
+        return 0;
+    }
+    // Only references are taken; the samples stay in the pool frames
+    for (size_t i = 0; i < utterance.frame_count; i++) {
+        job->frames.push_back(utterance.frames[i]);
+    }
+    job->frame_samples = utterance.samples();
+    return commitLocked(*job, std::move(done));
+}
+
+std::future<RecognitionResult> RecognitionService::submit(std::vector<int16_t>&& audio) {
+    std::shared_ptr<std::promise<RecognitionResult>> promise = std::make_shared<std::promise<RecognitionResult>>();
+    std::future<RecognitionResult> future = promise->get_future();
+    uint32_t id = submit(std::move(audio), [promise](const RecognitionResult& result) {
+        promise->set_value(result);
+    });
+    return id != 0 ? std::move(future) : std::future<RecognitionResult>();
+}
+
+bool RecognitionService::cancel(uint32_t job_id) {
+    if (job_id == 0) {
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (current_.id == job_id) {
+        cancel_current_.store(true);
+        return true;
+    }
+    for (size_t i = 0; i < count_; i++) {
+        if (queue_[(head_ + i) % queue_.size()].id == job_id) {
+            if (!canCancelLocked(1)) {
+                return false;
+            }
+            cancelPendingLocked(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+void RecognitionService::cancelAll() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    cancelStaleLocked();
+}
+
+bool RecognitionService::waitIdle(uint32_t timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return idle_.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this] {
+        return count_ == 0 && cancelled_.empty() && !busy_;
+    });
+}
+
+void RecognitionService::getStats(RecognitionServiceStats* stats) const {
+    if (stats == nullptr) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    *stats = stats_;
+}
+
+void RecognitionService::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wake_.wait(lock, [this] { return !running_.load() || count_ > 0 || !cancelled_.empty(); });
+        if (!running_.load()) {
+            break;
+        }
+
+        busy_ = true;
+        reporting_.swap(cancelled_);
+        bool have_job = count_ > 0;
+        if (have_job) {
+            std::swap(current_, queue_[head_]);
+            head_ = (head_ + 1) % queue_.size();
+            count_--;
+            stats_.queue_depth = (uint32_t)count_;
+            cancel_current_.store(false);
+        }
+        lock.unlock();
+
+        for (const Cancelled& cancelled : reporting_) {
+            reportCancelled(cancelled);
+        }
+        reporting_.clear();
+
+        if (have_job) {
+            uint64_t start = audioMicros();
+            std::string text;
+            RecognitionStatus status = runJob(current_, &text);
+            report(current_, status, text, start);
+        }
+
+        lock.lock();
+        clearJob(current_);
+        busy_ = false;
+        idle_.notify_all();
+    }
+}
+
+// Stream the job through the recognizer, stopping early on cancel
+RecognitionStatus RecognitionService::runJob(Job& job, std::string* text) {
+    if (!recognizer_.begin()) {
+        AUDIO_LOGF("Recognizer failed to start job %u\n", (unsigned)job.id);
+        return RecognitionStatus::FAILED;
+    }
+    const size_t chunk = config_.feed_chunk_samples;
+    bool cancelled = false;
+    if (!job.frames.empty()) {
+        size_t remaining = job.frame_samples;
+        for (size_t i = 0; i < job.frames.size() && remaining > 0 && !cancelled; i++) {
+            size_t n = job.frames[i].size() < remaining ? job.frames[i].size() : remaining;
+            recognizer_.feed(job.frames[i].data(), n);
+            remaining -= n;
+            cancelled = cancel_current_.load();
+        }
+    } else {
+        for (size_t pos = 0; pos < job.audio.size() && !cancelled; pos += chunk) {
+            size_t n = job.audio.size() - pos < chunk ? job.audio.size() - pos : chunk;
+            recognizer_.feed(&job.audio[pos], n);
+            cancelled = cancel_current_.load();
+        }
+    }
+    // A cancelled session is still closed so the next one starts clean
+    std::string result = recognizer_.finish();
+    if (cancelled || cancel_current_.load()) {
+        return RecognitionStatus::CANCELLED;
+    }
+    *text = result;
+    return RecognitionStatus::DONE;
+}
+
+void RecognitionService::report(const Job& job, RecognitionStatus status, const std::string& text,
+                                uint64_t start_us) {
+    uint64_t now = audioMicros();
+    RecognitionResult result;
+    result.job_id = job.id;
+    result.status = status;
+    result.text = text;
+    result.queued_us = start_us - job.submit_us;
+    result.run_us = now - start_us;
+    result.latency_us = now - job.submit_us;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (status == RecognitionStatus::DONE) {
+            stats_.completed++;
+            stats_.last_latency_us = result.latency_us;
+            stats_.total_latency_us += result.latency_us;
+            if (result.latency_us > stats_.max_latency_us) {
+                stats_.max_latency_us = result.latency_us;
+            }
+        } else if (status == RecognitionStatus::FAILED) {
+            stats_.failed++;
+        } else {
+            stats_.cancelled++;
+        }
+    }
+    if (job.done) {
+        job.done(result);
+    }
+}
+
+void RecognitionService::reportCancelled(const Cancelled& cancelled) {
+    RecognitionResult result;
+    result.job_id = cancelled.id;
+    result.status = RecognitionStatus::CANCELLED;
+    result.queued_us = 0;
+    result.run_us = 0;
+    result.latency_us = audioMicros() - cancelled.submit_us;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stats_.cancelled++;
+    }
+    if (cancelled.done) {
+        cancelled.done(result);
+    }
+}
@@ -1,25 +1,83 @@
 #include "speech_recognizer.h"
-#include "whisper.h"  // Include Whisper API
+#include "audio_platform.h"
+#include <cstring>
 #include <vector>
 
-SpeechRecognizer::SpeechRecognizer() {
-    // Initialize Whisper or any necessary components
+using audio_processing::audioMicros;
+
+SpeechRecognizer::SpeechRecognizer() : backend_(&whisper_), in_session_(false) {
+    memset(&stats_, 0, sizeof(stats_));
 }
 
-bool SpeechRecognizer::initialize() {
-    // Perform any necessary initialization for Whisper
-    return true; // Return true if initialization is successful
+SpeechRecognizer::SpeechRecognizer(RecognizerBackend* backend)
+    : backend_(backend ? backend : &whisper_), in_session_(false) {
+    memset(&stats_, 0, sizeof(stats_));
 }
 
-std::string SpeechRecognizer::recognizeSpeech(const std::vector<int16_t>& audio_data) {
-    // Convert audio data to the format expected by Whisper
-    // Send audio data to Whisper and receive transcription
-    std::string transcription = whisper_transcribe(audio_data);
+bool SpeechRecognizer::initialize(const char* model_source) {
+    uint64_t start = audioMicros();
+    if (in_session_) {
+        finish();
+    }
+    if (model_source != nullptr) {
+        if (!model_.open(model_source)) {
+            return false;
+        }
+    } else {
+        model_.close();
+    }
+    bool ok = backend_->initialize(model_.isOpen() ? &model_ : nullptr);
+    stats_.init_us = audioMicros() - start;
+    return ok;
+}
+
+bool SpeechRecognizer::begin() {
+    if (in_session_) {
+        finish();
+    }
+    if (!backend_->begin()) {
+        return false;
+    }
+    in_session_ = true;
+    stats_.sessions++;
+    stats_.samples_fed = 0;
+    stats_.feed_us = 0;
+    return true;
+}
+
+bool SpeechRecognizer::feed(const int16_t* samples, size_t count) {
+    if (!in_session_ || (samples == nullptr && count > 0)) {
+        return false;
+    }
+    uint64_t start = audioMicros();
+    bool ok = backend_->feed(samples, count);
+    stats_.feed_us += audioMicros() - start;
+    stats_.samples_fed += count;
+    return ok;
+}
+
+std::string SpeechRecognizer::partial() {
+    return in_session_ ? backend_->partial() : std::string();
+}
+
+std::string SpeechRecognizer::finish() {
+    if (!in_session_) {
+        return std::string();
+    }
+    uint64_t start = audioMicros();
+    std::string transcription = backend_->finish();
+    stats_.last_finish_us = audioMicros() - start;
+    if (stats_.last_finish_us > stats_.max_finish_us) {
+        stats_.max_finish_us = stats_.last_finish_us;
+    }
+    in_session_ = false;
     return transcription;
 }
 
-std::string SpeechRecognizer::whisper_transcribe(const std::vector<int16_t>& audio_data) {
-    // Placeholder function to simulate Whisper transcription
-    // Replace with actual Whisper API call
-    return "Transcribed text from Whisper";
-}
\ No newline at end of file
+std::string SpeechRecognizer::recognizeSpeech(const std::vector<int16_t>& audio_data) {
+    if (!begin()) {
+        return std::string();
+    }
+    feed(audio_data.data(), audio_data.size());
+    return finish();
+}
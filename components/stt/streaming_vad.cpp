@@ -0,0 +1,98 @@
+#include "streaming_vad.h"
+#include <cstring>
+
+StreamingVAD::StreamingVAD(float energy_threshold, int window_size, int hop_size,
+                           int attack_hops, int hangover_hops)
+    : window_(nullptr), window_size_(window_size > 0 ? window_size : 1),
+      hop_size_(hop_size > 0 ? hop_size : 1),
+      attack_hops_(attack_hops > 0 ? attack_hops : 1),
+      hangover_hops_(hangover_hops > 0 ? hangover_hops : 1),
+      window_pos_(0), hop_pos_(0), sum_squares_(0), threshold_sum_(0),
+      total_samples_(0), speech_run_(0), silence_run_(0), speech_(false) {
+    window_ = new int16_t[window_size_];
+    setThreshold(energy_threshold);
+    reset();
+}
+
+StreamingVAD::~StreamingVAD() {
+    delete[] window_;
+}
+
+void StreamingVAD::setThreshold(float energy_threshold) {
+    if (energy_threshold < 0.0f) {
+        energy_threshold = 0.0f;
+    }
+    threshold_sum_ = (uint64_t)(energy_threshold * (float)window_size_);
+}
+
+void StreamingVAD::reset() {
+    memset(window_, 0, window_size_ * sizeof(int16_t));
+    window_pos_ = 0;
+    hop_pos_ = 0;
+    sum_squares_ = 0;
+    total_samples_ = 0;
+    speech_run_ = 0;
+    silence_run_ = 0;
+    speech_ = false;
+}
+
+size_t StreamingVAD::process(const int16_t* samples, size_t count,
+                             VADDecision* decisions, size_t max_decisions) {
+    if (samples == nullptr) {
+        return 0;
+    }
+
+    size_t emitted = 0;
+    size_t i = 0;
+    while (i < count) {
+        // Run to the next hop boundary without per-sample branching on it
+        size_t run = (size_t)(hop_size_ - hop_pos_);
+        if (run > count - i) {
+            run = count - i;
+        }
+
+        for (size_t n = 0; n < run; n++) {
+            int32_t x = samples[i + n];
+            int32_t old = window_[window_pos_];
+            sum_squares_ += (uint64_t)(x * x);
+            sum_squares_ -= (uint64_t)(old * old);
+            window_[window_pos_] = (int16_t)x;
+            if (++window_pos_ == window_size_) {
+                window_pos_ = 0;
+            }
+        }
+        i += run;
+        hop_pos_ += (int)run;
+        total_samples_ += run;
+
+        if (hop_pos_ < hop_size_) {
+            break;
+        }
+        hop_pos_ = 0;
+
+        bool raw = sum_squares_ > threshold_sum_;
+        if (raw) {
+            speech_run_++;
+            silence_run_ = 0;
+            if (!speech_ && speech_run_ >= attack_hops_) {
+                speech_ = true;
+            }
+        } else {
+            silence_run_++;
+            speech_run_ = 0;
+            if (speech_ && silence_run_ >= hangover_hops_) {
+                speech_ = false;
+            }
+        }
+
+        if (decisions != nullptr && emitted < max_decisions) {
+            VADDecision& d = decisions[emitted];
+            d.speech = speech_;
+            d.raw_speech = raw;
+            d.energy = currentEnergy();
+            d.end_sample = total_samples_;
+            emitted++;
+        }
+    }
+    return emitted;
+}
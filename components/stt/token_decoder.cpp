@@ -0,0 +1,487 @@
+#include "token_decoder.h"
+#include "audio_platform.h"
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+using audio_processing::audioAlloc;
+using audio_processing::audioFree;
+using audio_processing::audioMicros;
+using audio_processing::MemoryRegion;
+
+static const float LAYER_NORM_EPS = 1e-5f;
+
+static size_t alignUp(size_t bytes) {
+    return (bytes + 15) & ~(size_t)15;
+}
+
+DecoderConfig defaultDecoderConfig() {
+    DecoderConfig config;
+    config.max_context = 0;
+    config.max_audio_context = 0;
+    config.max_tokens = 0;
+    config.timestamps = false;
+    config.timestamp_step_s = 0.02f;
+    return config;
+}
+
+void ActivationArena::attach(void* base, size_t bytes) {
+    base_ = static_cast<uint8_t*>(base);
+    capacity_ = base_ ? bytes : 0;
+    used_ = 0;
+    peak_ = 0;
+}
+
+static uint32_t clampContext(uint32_t requested, uint32_t model) {
+    return requested == 0 || requested > model ? model : requested;
+}
+
+// Room for the prompt and at least one generated token
+static uint32_t textContext(const DecoderConfig& config, uint32_t model) {
+    uint32_t context = clampContext(config.max_context, model);
+    return context < 2 ? 2 : context;
+}
+
+// One slot past the context for the token that ends a full context
+static size_t tokenBytes(uint32_t context) {
+    return alignUp((context + 1) * sizeof(int32_t));
+}
+
+// The logits live for the utterance; one step adds the residual stream,
+// four n_state temporaries, the attention scores and the MLP hidden layer
+static size_t arenaBytes(const DecoderHparams& hp, uint32_t context, uint32_t audio_context) {
+    uint32_t keys = context > audio_context ? context : audio_context;
+    return alignUp(hp.n_vocab * sizeof(float)) + 5 * alignUp(hp.n_state * sizeof(float)) +
+           alignUp(keys * sizeof(float)) + alignUp(hp.n_mlp * sizeof(float));
+}
+
+size_t TokenDecoder::memoryBytes(const DecoderHparams& hparams, const DecoderConfig& config) {
+    uint32_t context = textContext(config, hparams.n_ctx);
+    uint32_t audio_context = clampContext(config.max_audio_context, hparams.n_audio_ctx);
+    size_t row = hparams.n_state * sizeof(float);
+    return alignUp(2 * (size_t)hparams.n_layer * context * row) +
+           alignUp(2 * (size_t)hparams.n_layer * audio_context * row) +
+           tokenBytes(context) + arenaBytes(hparams, context, audio_context);
+}
+
+TokenDecoder::TokenDecoder(const DecoderConfig& config)
+    : config_(config), max_context_(0), max_audio_context_(0), ln_(nullptr), block_(nullptr),
+      self_kv_(nullptr), cross_kv_(nullptr), tokens_(nullptr), logits_(nullptr), audio_frames_(0),
+      position_(0), count_(0), last_timestamp_(0), last_stop_(DecodeStop::END_OF_TEXT) {
+    memset(&hparams_, 0, sizeof(hparams_));
+    memset(&tok_emb_, 0, sizeof(tok_emb_));
+    memset(&pos_emb_, 0, sizeof(pos_emb_));
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+TokenDecoder::~TokenDecoder() {
+    unload();
+}
+
+void TokenDecoder::unload() {
+    audioFree(block_);
+    block_ = nullptr;
+    self_kv_ = nullptr;
+    cross_kv_ = nullptr;
+    tokens_ = nullptr;
+    logits_ = nullptr;
+    arena_.attach(nullptr, 0);
+    layers_.clear();
+    position_ = 0;
+    count_ = 0;
+    audio_frames_ = 0;
+}
+
+bool TokenDecoder::bindMatrix(const ModelFile& model, const char* name, uint32_t rows, uint32_t cols,
+                              Matrix* out) {
+    ModelTensor tensor;
+    if (!model.find(name, &tensor)) {
+        AUDIO_LOGF("Decoder tensor %s missing\n", name);
+        return false;
+    }
+    bool shape = tensor.rank == 2 && tensor.dims[0] == rows && tensor.dims[1] == cols;
+    bool int8 = tensor.type == ModelTensorType::INT8 && tensor.zero_point == 0;
+    if (!shape || !(int8 || tensor.type == ModelTensorType::FLOAT32)) {
+        AUDIO_LOGF("Decoder tensor %s has the wrong shape or type\n", name);
+        return false;
+    }
+    out->data = tensor.data;
+    out->int8 = int8;
+    out->rows = rows;
+    out->cols = cols;
+    out->scale = int8 ? tensor.scale : 1.0f;
+    out->bias = nullptr;
+
+    char bias_name[MODEL_TENSOR_NAME_LEN + 2];
+    snprintf(bias_name, sizeof(bias_name), "%s.b", name);
+    if (model.find(bias_name, &tensor)) {
+        if (tensor.type != ModelTensorType::FLOAT32 || tensor.rank != 1 || tensor.dims[0] != rows) {
+            AUDIO_LOGF("Decoder tensor %s has the wrong shape or type\n", bias_name);
+            return false;
+        }
+        out->bias = static_cast<const float*>(tensor.data);
+    }
+    return true;
+}
+
+bool TokenDecoder::bindNorm(const ModelFile& model, const char* name, const float** out) {
+    ModelTensor tensor;
+    if (!model.find(name, &tensor) || tensor.type != ModelTensorType::FLOAT32 || tensor.rank != 2 ||
+        tensor.dims[0] != 2 || tensor.dims[1] != hparams_.n_state) {
+        AUDIO_LOGF("Decoder norm %s missing or malformed\n", name);
+        return false;
+    }
+    *out = static_cast<const float*>(tensor.data);
+    return true;
+}
+
+bool TokenDecoder::load(const ModelFile& model) {
+    unload();
+    ModelTensor tensor;
+    if (!model.find("dec.hparams", &tensor) || tensor.type != ModelTensorType::INT32 ||
+        tensor.rank != 1 || tensor.dims[0] != DECODER_HPARAMS_COUNT) {
+        AUDIO_LOGF("Model has no decoder\n");
+        return false;
+    }
+    memcpy(&hparams_, tensor.data, sizeof(hparams_));
+    const DecoderHparams& hp = hparams_;
+    int32_t vocab = (int32_t)hp.n_vocab;
+    bool tokens_valid = hp.token_sot >= 0 && hp.token_sot < vocab && hp.token_eot >= 0 && hp.token_eot < vocab &&
+                        hp.token_no_timestamps >= 0 && hp.token_no_timestamps < vocab &&
+                        hp.token_timestamp_begin > 0 && hp.token_timestamp_begin <= vocab;
+    if (hp.n_vocab == 0 || hp.n_ctx < 2 || hp.n_state == 0 || hp.n_head == 0 || hp.n_state % hp.n_head != 0 ||
+        hp.n_layer == 0 || hp.n_mlp == 0 || !tokens_valid) {
+        AUDIO_LOGF("Decoder hparams are invalid\n");
+        return false;
+    }
+    max_context_ = textContext(config_, hp.n_ctx);
+    max_audio_context_ = clampContext(config_.max_audio_context, hp.n_audio_ctx);
+
+    const uint32_t d = hp.n_state;
+    bool ok = bindMatrix(model, "dec.tok_emb", hp.n_vocab, d, &tok_emb_) &&
+              bindMatrix(model, "dec.pos_emb", hp.n_ctx, d, &pos_emb_) && bindNorm(model, "dec.ln", &ln_);
+    layers_.resize(hp.n_layer);
+    char name[MODEL_TENSOR_NAME_LEN + 8];
+    for (uint32_t l = 0; ok && l < hp.n_layer; l++) {
+        Layer& layer = layers_[l];
+        memset(&layer, 0, sizeof(layer));
+        auto matrix = [&](const char* part, uint32_t rows, uint32_t cols, Matrix* out) {
+            snprintf(name, sizeof(name), "dec.%u.%s", (unsigned)l, part);
+            return bindMatrix(model, name, rows, cols, out);
+        };
+        auto norm = [&](const char* part, const float** out) {
+            snprintf(name, sizeof(name), "dec.%u.%s", (unsigned)l, part);
+            return bindNorm(model, name, out);
+        };
+        ok = norm("attn_ln", &layer.attn_ln) && matrix("attn_q", d, d, &layer.attn_q) &&
+             matrix("attn_k", d, d, &layer.attn_k) && matrix("attn_v", d, d, &layer.attn_v) &&
+             matrix("attn_out", d, d, &layer.attn_out) && norm("mlp_ln", &layer.mlp_ln) &&
+             matrix("mlp_fc1", hp.n_mlp, d, &layer.mlp_fc1) && matrix("mlp_fc2", d, hp.n_mlp, &layer.mlp_fc2);
+        if (ok && hp.n_audio_ctx > 0) {
+            ok = norm("xattn_ln", &layer.xattn_ln) && matrix("xattn_q", d, d, &layer.xattn_q) &&
+                 matrix("xattn_k", d, d, &layer.xattn_k) && matrix("xattn_v", d, d, &layer.xattn_v) &&
+                 matrix("xattn_out", d, d, &layer.xattn_out);
+        }
+    }
+    if (!ok) {
+        layers_.clear();
+        return false;
+    }
+
+    // One block for the whole lifetime of the model
+    size_t row = d * sizeof(float);
+    size_t self_bytes = alignUp(2 * (size_t)hp.n_layer * max_context_ * row);
+    size_t cross_bytes = alignUp(2 * (size_t)hp.n_layer * max_audio_context_ * row);
+    size_t token_bytes = tokenBytes(max_context_);
+    size_t arena_bytes = arenaBytes(hp, max_context_, max_audio_context_);
+    size_t total = self_bytes + cross_bytes + token_bytes + arena_bytes;
+    block_ = static_cast<uint8_t*>(audioAlloc(total, MemoryRegion::PSRAM));
+    if (block_ == nullptr) {
+        AUDIO_LOGF("Decoder needs %u bytes\n", (unsigned)total);
+        layers_.clear();
+        return false;
+    }
+    self_kv_ = reinterpret_cast<float*>(block_);
+    cross_kv_ = reinterpret_cast<float*>(block_ + self_bytes);
+    tokens_ = reinterpret_cast<int32_t*>(block_ + self_bytes + cross_bytes);
+    arena_.attach(block_ + self_bytes + cross_bytes + token_bytes, arena_bytes);
+
+    memset(&stats_, 0, sizeof(stats_));
+    stats_.kv_bytes = self_bytes + cross_bytes;
+    stats_.arena_bytes = arena_bytes;
+    stats_.total_bytes = total;
+    position_ = 0;
+    count_ = 0;
+    audio_frames_ = 0;
+    return true;
+}
+
+// y = W x (+ b); four partial sums keep the float adds independent
+void TokenDecoder::matvec(const Matrix& w, const float* x, float* y) const {
+    const uint32_t cols = w.cols;
+    for (uint32_t r = 0; r < w.rows; r++) {
+        float s0 = 0.0f, s1 = 0.0f, s2 = 0.0f, s3 = 0.0f;
+        uint32_t c = 0;
+        if (w.int8) {
+            const int8_t* row = static_cast<const int8_t*>(w.data) + (size_t)r * cols;
+            for (; c + 4 <= cols; c += 4) {
+                s0 += row[c] * x[c];
+                s1 += row[c + 1] * x[c + 1];
+                s2 += row[c + 2] * x[c + 2];
+                s3 += row[c + 3] * x[c + 3];
+            }
+            for (; c < cols; c++) {
+                s0 += row[c] * x[c];
+            }
+        } else {
+            const float* row = static_cast<const float*>(w.data) + (size_t)r * cols;
+            for (; c + 4 <= cols; c += 4) {
+                s0 += row[c] * x[c];
+                s1 += row[c + 1] * x[c + 1];
+                s2 += row[c + 2] * x[c + 2];
+                s3 += row[c + 3] * x[c + 3];
+            }
+            for (; c < cols; c++) {
+                s0 += row[c] * x[c];
+            }
+        }
+        y[r] = ((s0 + s1) + (s2 + s3)) * w.scale + (w.bias ? w.bias[r] : 0.0f);
+    }
+}
+
+void TokenDecoder::rowOf(const Matrix& w, uint32_t row, float* y) const {
+    if (w.int8) {
+        const int8_t* src = static_cast<const int8_t*>(w.data) + (size_t)row * w.cols;
+        for (uint32_t c = 0; c < w.cols; c++) {
+            y[c] = src[c] * w.scale;
+        }
+    } else {
+        memcpy(y, static_cast<const float*>(w.data) + (size_t)row * w.cols, w.cols * sizeof(float));
+    }
+}
+
+void TokenDecoder::layerNorm(const float* params, const float* x, float* y) const {
+    const uint32_t d = hparams_.n_state;
+    float mean = 0.0f;
+    for (uint32_t i = 0; i < d; i++) {
+        mean += x[i];
+    }
+    mean /= d;
+    float var = 0.0f;
+    for (uint32_t i = 0; i < d; i++) {
+        float c = x[i] - mean;
+        var += c * c;
+    }
+    float inv = 1.0f / sqrtf(var / d + LAYER_NORM_EPS);
+    for (uint32_t i = 0; i < d; i++) {
+        y[i] = (x[i] - mean) * inv * params[i] + params[d + i];
+    }
+}
+
+// Multi-head attention of one query over count cached rows
+void TokenDecoder::attend(const float* q, const float* keys, const float* values, size_t count, float* scores,
+                          float* out) const {
+    const uint32_t d = hparams_.n_state;
+    const uint32_t head_dim = d / hparams_.n_head;
+    const float scale = 1.0f / sqrtf((float)head_dim);
+    for (uint32_t h = 0; h < hparams_.n_head; h++) {
+        const uint32_t base = h * head_dim;
+        float max = -INFINITY;
+        for (size_t t = 0; t < count; t++) {
+            const float* k = keys + t * d + base;
+            float dot = 0.0f;
+            for (uint32_t i = 0; i < head_dim; i++) {
+                dot += q[base + i] * k[i];
+            }
+            scores[t] = dot * scale;
+            max = scores[t] > max ? scores[t] : max;
+        }
+        float sum = 0.0f;
+        for (size_t t = 0; t < count; t++) {
+            scores[t] = expf(scores[t] - max);
+            sum += scores[t];
+        }
+        float* o = out + base;
+        memset(o, 0, head_dim * sizeof(float));
+        for (size_t t = 0; t < count; t++) {
+            const float p = scores[t] / sum;
+            const float* v = values + t * d + base;
+            for (uint32_t i = 0; i < head_dim; i++) {
+                o[i] += p * v[i];
+            }
+        }
+    }
+}
+
+bool TokenDecoder::begin(const float* audio, size_t frames) {
+    if (!isLoaded() || frames > max_audio_context_ || (frames > 0 && audio == nullptr) ||
+        (hparams_.n_audio_ctx > 0 && frames == 0)) {
+        return false;
+    }
+    arena_.reset();
+    logits_ = arena_.alloc<float>(hparams_.n_vocab);
+    position_ = 0;
+    count_ = 0;
+    last_timestamp_ = hparams_.token_timestamp_begin;
+    audio_frames_ = frames;
+
+    // Cross-attention keys and values depend only on the audio
+    const uint32_t d = hparams_.n_state;
+    for (uint32_t l = 0; l < hparams_.n_layer && frames > 0; l++) {
+        float* keys = cross_kv_ + (size_t)2 * l * max_audio_context_ * d;
+        float* values = keys + (size_t)max_audio_context_ * d;
+        for (size_t t = 0; t < frames; t++) {
+            matvec(layers_[l].xattn_k, audio + t * d, keys + t * d);
+            matvec(layers_[l].xattn_v, audio + t * d, values + t * d);
+        }
+    }
+    return true;
+}
+
+// One token through every layer; its keys and values join the cache and
+// the next-token logits land in logits_
+void TokenDecoder::forward(int32_t token) {
+    const uint32_t d = hparams_.n_state;
+    const size_t pos = position_;
+    const size_t mark = arena_.mark();
+    float* x = arena_.alloc<float>(d);
+    float* h = arena_.alloc<float>(d);
+    float* q = arena_.alloc<float>(d);
+    float* a = arena_.alloc<float>(d);
+    float* row = arena_.alloc<float>(d);
+    float* scores = arena_.alloc<float>(max_context_ > max_audio_context_ ? max_context_ : max_audio_context_);
+    float* mlp = arena_.alloc<float>(hparams_.n_mlp);
+
+    rowOf(tok_emb_, (uint32_t)token, x);
+    rowOf(pos_emb_, (uint32_t)pos, row);
+    for (uint32_t i = 0; i < d; i++) {
+        x[i] += row[i];
+    }
+
+    for (uint32_t l = 0; l < hparams_.n_layer; l++) {
+        const Layer& layer = layers_[l];
+        float* keys = self_kv_ + (size_t)2 * l * max_context_ * d;
+        float* values = keys + (size_t)max_context_ * d;
+
+        layerNorm(layer.attn_ln, x, h);
+        matvec(layer.attn_q, h, q);
+        matvec(layer.attn_k, h, keys + pos * d);
+        matvec(layer.attn_v, h, values + pos * d);
+        attend(q, keys, values, pos + 1, scores, a);
+        matvec(layer.attn_out, a, row);
+        for (uint32_t i = 0; i < d; i++) {
+            x[i] += row[i];
+        }
+
+        if (audio_frames_ > 0) {
+            float* cross_keys = cross_kv_ + (size_t)2 * l * max_audio_context_ * d;
+            float* cross_values = cross_keys + (size_t)max_audio_context_ * d;
+            layerNorm(layer.xattn_ln, x, h);
+            matvec(layer.xattn_q, h, q);
+            attend(q, cross_keys, cross_values, audio_frames_, scores, a);
+            matvec(layer.xattn_out, a, row);
+            for (uint32_t i = 0; i < d; i++) {
+                x[i] += row[i];
+            }
+        }
+
+        layerNorm(layer.mlp_ln, x, h);
+        matvec(layer.mlp_fc1, h, mlp);
+        for (uint32_t i = 0; i < hparams_.n_mlp; i++) {
+            mlp[i] = 0.5f * mlp[i] * (1.0f + erff(mlp[i] * (float)M_SQRT1_2));
+        }
+        matvec(layer.mlp_fc2, mlp, row);
+        for (uint32_t i = 0; i < d; i++) {
+            x[i] += row[i];
+        }
+    }
+
+    layerNorm(ln_, x, h);
+    matvec(tok_emb_, h, logits_);      // Output projection tied to the embedding
+    position_++;
+    arena_.rewind(mark);
+}
+
+int32_t TokenDecoder::select(const float* logits, float* logit) const {
+    const DecoderHparams& hp = hparams_;
+    size_t prompt = config_.timestamps ? 1 : 2;
+    bool first = count_ == prompt;
+    int32_t best = -1;
+    float best_logit = -INFINITY;
+    for (int32_t v = 0; v < (int32_t)hp.n_vocab; v++) {
+        if (v == hp.token_sot || v == hp.token_no_timestamps) {
+            continue;
+        }
+        bool timestamp = v >= hp.token_timestamp_begin;
+        if (timestamp && (!config_.timestamps || v < last_timestamp_)) {
+            continue;
+        }
+        if (config_.timestamps && first && !timestamp) {
+            continue;                   // Text starts with a timestamp
+        }
+        if (logits[v] > best_logit) {
+            best_logit = logits[v];
+            best = v;
+        }
+    }
+    *logit = best_logit;
+    return best;
+}
+
+size_t TokenDecoder::decode(const TokenFunction& token) {
+    if (!isLoaded() || logits_ == nullptr || position_ != 0) {
+        return 0;                       // begin() first, once per decode()
+    }
+    const DecoderHparams& hp = hparams_;
+    uint64_t start = audioMicros();
+    tokens_[count_++] = hp.token_sot;
+    if (!config_.timestamps) {
+        tokens_[count_++] = hp.token_no_timestamps;
+    }
+    for (size_t i = 0; i < count_; i++) {
+        forward(tokens_[i]);
+    }
+
+    size_t generated = 0;
+    while (true) {
+        float logit;
+        int32_t next = select(logits_, &logit);
+        if (next < 0 || next == hp.token_eot) {
+            last_stop_ = DecodeStop::END_OF_TEXT;
+            break;
+        }
+        DecodedToken decoded;
+        decoded.id = next;
+        decoded.index = (uint32_t)generated;
+        decoded.timestamp = next >= hp.token_timestamp_begin;
+        decoded.time_s = decoded.timestamp ? (next - hp.token_timestamp_begin) * config_.timestamp_step_s : 0.0f;
+        decoded.logit = logit;
+        if (decoded.timestamp) {
+            last_timestamp_ = next;
+        }
+        tokens_[count_++] = next;
+        generated++;
+        if (token && !token(decoded)) {
+            last_stop_ = DecodeStop::CALLER;
+            break;
+        }
+        if (config_.max_tokens > 0 && generated >= config_.max_tokens) {
+            last_stop_ = DecodeStop::MAX_TOKENS;
+            break;
+        }
+        if (position_ >= max_context_) {
+            last_stop_ = DecodeStop::CONTEXT_FULL;
+            break;
+        }
+        forward(next);
+    }
+
+    uint64_t elapsed = audioMicros() - start;
+    stats_.utterances++;
+    stats_.tokens += (uint32_t)generated;
+    stats_.last_tokens = (uint32_t)generated;
+    stats_.last_decode_us = elapsed;
+    stats_.last_tokens_per_s = elapsed > 0 ? generated * 1e6f / elapsed : 0.0f;
+    stats_.peak_arena_bytes = arena_.peak();
+    return generated;
+}
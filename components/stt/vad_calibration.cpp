@@ -0,0 +1,162 @@
+#include "vad_calibration.h"
+#include <cmath>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "nvs.h"
+#else
+#include <cstdio>
+#include <string>
+#endif
+
+static const uint32_t CALIBRATION_MAGIC = 0x56414431; // "VAD1"
+
+struct CalibrationRecord {
+    uint32_t magic;
+    float floor;
+};
+
+NoiseFloorTracker::NoiseFloorTracker(float rise_rate, float fall_rate, uint32_t calibration_frames)
+    : rise_rate_(rise_rate), fall_rate_(fall_rate), calibration_frames_(calibration_frames),
+      floor_(0.0f), frames_(0) {}
+
+void NoiseFloorTracker::update(float energy, bool speech) {
+    if (frames_ == 0 && floor_ <= 0.0f) {
+        floor_ = energy;
+    } else if (energy < floor_) {
+        floor_ += fall_rate_ * (energy - floor_);
+    } else if (!speech) {
+        // Speech may only pull the floor down, never up
+        floor_ += rise_rate_ * (energy - floor_);
+    }
+    if (floor_ < 1.0f) {
+        floor_ = 1.0f;
+    }
+    if (frames_ < 0xFFFFFFFFu) {
+        frames_++;
+    }
+}
+
+void NoiseFloorTracker::seed(float floor) {
+    floor_ = floor < 1.0f ? 1.0f : floor;
+    frames_ = calibration_frames_;
+}
+
+void NoiseFloorTracker::reset() {
+    floor_ = 0.0f;
+    frames_ = 0;
+}
+
+#ifndef ESP_PLATFORM
+static std::string host_directory = ".";
+
+void VADCalibrationStore::setHostDirectory(const char* dir) {
+    host_directory = dir ? dir : ".";
+}
+
+static std::string hostPath(const char* key) {
+    return host_directory + "/vad_" + key + ".cal";
+}
+#endif
+
+VADCalibrationStore::VADCalibrationStore(const char* key, float min_change_db)
+    : key_(key), min_change_db_(min_change_db), last_saved_(0.0f), writes_(0) {}
+
+bool VADCalibrationStore::load(float* floor) {
+    if (floor == nullptr) {
+        return false;
+    }
+
+    CalibrationRecord record;
+    memset(&record, 0, sizeof(record));
+#ifdef ESP_PLATFORM
+    nvs_handle_t handle;
+    if (nvs_open("vad", NVS_READONLY, &handle) != ESP_OK) {
+        return false;
+    }
+    size_t length = sizeof(record);
+    esp_err_t err = nvs_get_blob(handle, key_, &record, &length);
+    nvs_close(handle);
+    if (err != ESP_OK || length != sizeof(record)) {
+        return false;
+    }
+#else
+    FILE* file = fopen(hostPath(key_).c_str(), "rb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t length = fread(&record, 1, sizeof(record), file);
+    fclose(file);
+    if (length != sizeof(record)) {
+        return false;
+    }
+#endif
+
+    if (record.magic != CALIBRATION_MAGIC || !std::isfinite(record.floor) || record.floor <= 0.0f) {
+        return false;
+    }
+    *floor = record.floor;
+    last_saved_ = record.floor;
+    return true;
+}
+
+bool VADCalibrationStore::save(float floor) {
+    if (!std::isfinite(floor) || floor <= 0.0f) {
+        return false;
+    }
+    if (last_saved_ > 0.0f &&
+        std::fabs(10.0f * std::log10(floor / last_saved_)) < min_change_db_) {
+        return false;
+    }
+
+    CalibrationRecord record;
+    record.magic = CALIBRATION_MAGIC;
+    record.floor = floor;
+#ifdef ESP_PLATFORM
+    nvs_handle_t handle;
+    if (nvs_open("vad", NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = nvs_set_blob(handle, key_, &record, sizeof(record));
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    if (err != ESP_OK) {
+        return false;
+    }
+#else
+    FILE* file = fopen(hostPath(key_).c_str(), "wb");
+    if (file == nullptr) {
+        return false;
+    }
+    size_t written = fwrite(&record, 1, sizeof(record), file);
+    fclose(file);
+    if (written != sizeof(record)) {
+        return false;
+    }
+#endif
+
+    last_saved_ = floor;
+    writes_++;
+    return true;
+}
+
+bool VADCalibrationStore::erase() {
+    last_saved_ = 0.0f;
+#ifdef ESP_PLATFORM
+    nvs_handle_t handle;
+    if (nvs_open("vad", NVS_READWRITE, &handle) != ESP_OK) {
+        return false;
+    }
+    esp_err_t err = nvs_erase_key(handle, key_);
+    if (err == ESP_OK) {
+        err = nvs_commit(handle);
+    }
+    nvs_close(handle);
+    return err == ESP_OK || err == ESP_ERR_NVS_NOT_FOUND;
+#else
+    remove(hostPath(key_).c_str());
+    return true;
+#endif
+}
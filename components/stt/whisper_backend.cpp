@@ -0,0 +1,66 @@
+#include "recognizer_backend.h"
+#include "audio_platform.h"
+#include <cstring>
+#if __has_include("whisper.h")
+#include "whisper.h"  // Include Whisper API
+#endif
+
+// Whisper models take 16 kHz audio and 80 mel bins, 30 s per window
+static const int WHISPER_SAMPLE_RATE = 16000;
+static const size_t WHISPER_WINDOW_SECONDS = 30;
+
+WhisperBackend::WhisperBackend()
+    : model_(nullptr), frontend_(defaultLogMelConfig(WHISPER_SAMPLE_RATE)), window_full_(false) {
+    max_mel_values_ = WHISPER_WINDOW_SECONDS * WHISPER_SAMPLE_RATE / frontend_.hopSamples() *
+                      (size_t)frontend_.melBins();
+    collect_ = [this](const float* features) {
+        if (mel_.size() + frontend_.melBins() > max_mel_values_) {
+            if (!window_full_) {
+                AUDIO_LOGF("Whisper window full, dropping audio past %u s\n", (unsigned)WHISPER_WINDOW_SECONDS);
+            }
+            window_full_ = true;
+            return;
+        }
+        mel_.insert(mel_.end(), features, features + frontend_.melBins());
+    };
+}
+
+bool WhisperBackend::initialize(const ModelFile* model) {
+    // Weights must be for this backend; they stay in the mapping
+    if (model != nullptr && strcmp(model->arch(), name()) != 0) {
+        AUDIO_LOGF("Model is for '%s', not %s\n", model->arch(), name());
+        return false;
+    }
+    model_ = model;
+    return true;
+}
+
+bool WhisperBackend::begin() {
+    frontend_.reset();
+    mel_.clear();
+    // Only the first session allocates; clear() keeps the capacity
+    mel_.reserve(max_mel_values_);
+    window_full_ = false;
+    return true;
+}
+
+bool WhisperBackend::feed(const int16_t* samples, size_t count) {
+    frontend_.feed(samples, count, collect_);
+    return !window_full_;
+}
+
+std::string WhisperBackend::finish() {
+    frontend_.flush(collect_);
+    // Send the log-mel features to Whisper and receive transcription
+    std::string transcription = whisper_transcribe(mel_, mel_.size() / frontend_.melBins());
+    mel_.clear();
+    return transcription;
+}
+
+std::string WhisperBackend::whisper_transcribe(const std::vector<float>& mel, size_t frames) {
+    // Placeholder function to simulate Whisper transcription
+    // Replace with actual Whisper API call
+    (void)mel;
+    (void)frames;
+    return "Transcribed text from Whisper";
+}
@@ -0,0 +1,118 @@
+#include "audio_sink.h"
+#include "audio_platform.h"
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+using audio_processing::audioMicros;
+
+static const size_t WAV_HEADER_BYTES = 44;
+
+static void sinkSleepTick() {
+#ifdef ESP_PLATFORM
+    vTaskDelay(1);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+#endif
+}
+
+RingSink::RingSink(audio_processing::PcmRing& ring, uint32_t timeout_ms)
+    : ring_(ring), timeout_ms_(timeout_ms), sample_rate_(0) {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+bool RingSink::begin(int sample_rate) {
+    sample_rate_ = sample_rate;
+    return ring_.isInitialized();
+}
+
+bool RingSink::write(const int16_t* samples, size_t count) {
+    uint64_t stalled_since = 0;
+    while (count > 0) {
+        size_t n = ring_.write(samples, count);
+        samples += n;
+        count -= n;
+        stats_.samples += n;
+        if (count == 0) {
+            break;
+        }
+        uint64_t now = audioMicros();
+        if (n > 0 || stalled_since == 0) {
+            stalled_since = now;
+            stats_.waits++;
+        } else if (now - stalled_since >= (uint64_t)timeout_ms_ * 1000) {
+            stats_.timeouts++;
+            return false;
+        }
+        sinkSleepTick();
+        stats_.wait_us += audioMicros() - now;
+    }
+    return true;
+}
+
+WavFileSink::WavFileSink(const char* path) : path_(path), file_(nullptr), sample_rate_(0), samples_(0) {}
+
+WavFileSink::~WavFileSink() {
+    end();
+}
+
+static void putLe(uint8_t* p, uint32_t v, int bytes) {
+    for (int i = 0; i < bytes; i++) {
+        p[i] = (uint8_t)(v >> (8 * i));
+    }
+}
+
+bool WavFileSink::writeHeader(uint32_t data_bytes) {
+    uint8_t h[WAV_HEADER_BYTES];
+    memcpy(h, "RIFF", 4);
+    putLe(h + 4, 36 + data_bytes, 4);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    putLe(h + 16, 16, 4);                       // fmt chunk size
+    putLe(h + 20, 1, 2);                        // PCM
+    putLe(h + 22, 1, 2);                        // Mono
+    putLe(h + 24, (uint32_t)sample_rate_, 4);
+    putLe(h + 28, (uint32_t)sample_rate_ * 2, 4);
+    putLe(h + 32, 2, 2);                        // Block align
+    putLe(h + 34, 16, 2);                       // Bits per sample
+    memcpy(h + 36, "data", 4);
+    putLe(h + 40, data_bytes, 4);
+    return fwrite(h, 1, sizeof(h), file_) == sizeof(h);
+}
+
+bool WavFileSink::begin(int sample_rate) {
+    end();
+    file_ = fopen(path_, "wb");
+    if (file_ == nullptr) {
+        AUDIO_LOGF("Failed to open %s\n", path_);
+        return false;
+    }
+    sample_rate_ = sample_rate;
+    samples_ = 0;
+    return writeHeader(0);
+}
+
+bool WavFileSink::write(const int16_t* samples, size_t count) {
+    if (file_ == nullptr) {
+        return false;
+    }
+    // Both the ESP32 and the host are little-endian, as WAV is
+    size_t n = fwrite(samples, sizeof(int16_t), count, file_);
+    samples_ += n;
+    return n == count;
+}
+
+void WavFileSink::end() {
+    if (file_ == nullptr) {
+        return;
+    }
+    fseek(file_, 0, SEEK_SET);
+    writeHeader((uint32_t)(samples_ * sizeof(int16_t)));
+    fclose(file_);
+    file_ = nullptr;
+}
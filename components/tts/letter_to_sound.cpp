@@ -0,0 +1,596 @@
+#include "text_processor.h"
+#include <cstring>
+
+// English letter-to-sound rules after Elovitz et al., "Letter-to-Sound
+// Rules for Automatic Translation of English Text to Phonetics" (NRL
+// 1976), trimmed and mapped to ARPAbet. A rule rewrites its match when
+// the letters around it fit both contexts; rules for a letter are tried
+// in order and the first fit wins, so the last rule of each letter is
+// its default. Context symbols:
+//
+//   ' '  word boundary          '#'  one or more vowels
+//   ':'  zero or more consonants '^'  one consonant
+//   '+'  e, i or y              '.'  a voiced consonant
+//   '%'  a suffix: er e es ed ing ely
+//   '&'  a sibilant: s c g z x j ch sh
+//   '@'  t s r d l z n j th ch sh, after which u reads as oo
+
+namespace {
+
+struct LtsRule {
+    const char* left;
+    const char* match;
+    const char* right;
+    const char* phonemes;
+};
+
+const LtsRule LTS_RULES[] = {
+    {"", "'", "", ""},
+
+    {" ", "a", " ", "AH"},
+    {"", "ar", "o", "AH R"},
+    {"", "ar", "#", "EH R"},
+    {" ^", "as", "#", "EY S"},
+    {"", "a", "wa", "AH"},
+    {"", "aw", "", "AO"},
+    {" :", "any", "", "EH N IY"},
+    {"", "a", "^+#", "EY"},
+    {"#:", "ally", "", "AH L IY"},
+    {" ", "al", "#", "AH L"},
+    {"", "again", "", "AH G EH N"},
+    {"#:", "ag", "e", "IH JH"},
+    {"", "a", "^+:#", "AE"},
+    {" :", "a", "^+ ", "EY"},
+    {"", "a", "^%", "EY"},
+    {" ", "arr", "", "AH R"},
+    {"", "arr", "", "AE R"},
+    {" :", "ar", " ", "AA R"},
+    {"", "ar", " ", "ER"},
+    {"", "ar", "", "AA R"},
+    {"", "air", "", "EH R"},
+    {"", "ai", "", "EY"},
+    {"", "ay", "", "EY"},
+    {"", "au", "", "AO"},
+    {"#:", "al", " ", "AH L"},
+    {"#:", "als", " ", "AH L Z"},
+    {"", "alk", "", "AO K"},
+    {"", "al", "^", "AO L"},
+    {" :", "able", "", "EY B AH L"},
+    {"", "able", "", "AH B AH L"},
+    {"", "ang", "+", "EY N JH"},
+    {"", "a", "", "AE"},
+
+    {" ", "be", "^#", "B IH"},
+    {"", "being", "", "B IY IH NG"},
+    {" ", "both", " ", "B OW TH"},
+    {" ", "bus", "#", "B IH Z"},
+    {"", "buil", "", "B IH L"},
+    {"", "b", "", "B"},
+
+    {" ", "ch", "^", "K"},
+    {"^e", "ch", "", "K"},
+    {"", "ch", "", "CH"},
+    {" s", "ci", "#", "S AY"},
+    {"", "ci", "a", "SH"},
+    {"", "ci", "o", "SH"},
+    {"", "ci", "en", "SH"},
+    {"", "c", "+", "S"},
+    {"", "ck", "", "K"},
+    {"", "com", "%", "K AH M"},
+    {"", "c", "", "K"},
+
+    {"#:", "ded", " ", "D IH D"},
+    {".e", "d", " ", "D"},
+    {"#^:e", "d", " ", "T"},
+    {" ", "de", "^#", "D IH"},
+    {" ", "do", " ", "D UW"},
+    {" ", "does", "", "D AH Z"},
+    {" ", "doing", "", "D UW IH NG"},
+    {" ", "dow", "", "D AW"},
+    {"", "du", "a", "JH UW"},
+    {"", "dg", "e", "JH"},
+    {"", "d", "", "D"},
+
+    {"#:", "e", " ", ""},
+    {" :", "e", " ", "IY"},
+    {"#", "ed", " ", "D"},
+    {"#:", "e", "d ", ""},
+    {"", "ev", "er", "EH V"},
+    {"", "e", "^%", "IY"},
+    {"", "eri", "#", "IY R IY"},
+    {"", "eri", "", "EH R IH"},
+    {"#:", "er", "#", "ER"},
+    {"", "er", "#", "EH R"},
+    {"", "er", "", "ER"},
+    {" ", "even", "", "IY V EH N"},
+    {"#:", "e", "w", ""},
+    {"@", "ew", "", "UW"},
+    {"", "ew", "", "Y UW"},
+    {"", "e", "o", "IY"},
+    {"#:&", "es", " ", "IH Z"},
+    {"#:", "e", "s ", ""},
+    {"#:", "ely", " ", "L IY"},
+    {"#:", "ement", "", "M EH N T"},
+    {"", "eful", "", "F UH L"},
+    {"", "ee", "", "IY"},
+    {"", "earn", "", "ER N"},
+    {" ", "ear", "^", "ER"},
+    {"", "ead", "", "EH D"},
+    {"#:", "ea", " ", "IY AH"},
+    {"", "ea", "su", "EH"},
+    {"", "ea", "", "IY"},
+    {"", "eigh", "", "EY"},
+    {"", "ei", "", "IY"},
+    {" ", "eye", "", "AY"},
+    {"", "ey", "", "IY"},
+    {"", "eu", "", "Y UW"},
+    {"", "e", "", "EH"},
+
+    {"", "ful", "", "F UH L"},
+    {"", "f", "", "F"},
+
+    {"", "giv", "", "G IH V"},
+    {" ", "g", "i^", "G"},
+    {"", "ge", "t", "G EH"},
+    {"su", "gges", "", "G JH EH S"},
+    {"", "gg", "", "G"},
+    {" b#", "g", "", "G"},
+    {"", "g", "+", "JH"},
+    {"", "great", "", "G R EY T"},
+    {"#", "gh", "", ""},
+    {"", "g", "", "G"},
+
+    {" ", "hav", "", "HH AE V"},
+    {" ", "here", "", "HH IY R"},
+    {" ", "hour", "", "AW ER"},
+    {"", "how", "", "HH AW"},
+    {"", "h", "#", "HH"},
+    {"", "h", "", ""},
+
+    {" ", "in", "", "IH N"},
+    {" ", "i", " ", "AY"},
+    {"", "in", "d", "AY N"},
+    {"", "ier", "", "IY ER"},
+    {"#:r", "ied", "", "IY D"},
+    {"", "ied", " ", "AY D"},
+    {"", "ien", "", "IY EH N"},
+    {"", "ie", "t", "AY EH"},
+    {" :", "i", "%", "AY"},
+    {"", "i", "%", "IY"},
+    {"", "ie", "", "IY"},
+    {"", "i", "^+:#", "IH"},
+    {"", "ir", "#", "AY R"},
+    {"", "iz", "%", "AY Z"},
+    {"", "is", "%", "AY Z"},
+    {"", "i", "d%", "AY"},
+    {"+^", "i", "^+", "IH"},
+    {"", "i", "t%", "AY"},
+    {"#^:", "i", "^+", "IH"},
+    {"", "i", "^+", "AY"},
+    {"", "ir", "", "ER"},
+    {"", "igh", "", "AY"},
+    {"", "ild", "", "AY L D"},
+    {"", "ign", " ", "AY N"},
+    {"", "ign", "^", "AY N"},
+    {"", "ign", "%", "AY N"},
+    {"", "ique", "", "IY K"},
+    {"", "i", "", "IH"},
+
+    {"", "j", "", "JH"},
+
+    {" ", "k", "n", ""},
+    {"", "k", "", "K"},
+
+    {"", "lo", "c#", "L OW"},
+    {"l", "l", "", ""},
+    {"#^:", "l", "%", "AH L"},
+    {"", "lead", "", "L IY D"},
+    {"", "l", "", "L"},
+
+    {"", "mov", "", "M UW V"},
+    {"", "m", "", "M"},
+
+    {"e", "ng", "+", "N JH"},
+    {"", "ng", "r", "NG G"},
+    {"", "ng", "#", "NG G"},
+    {"", "ngl", "%", "NG G AH L"},
+    {"", "ng", "", "NG"},
+    {"", "nk", "", "NG K"},
+    {" ", "now", " ", "N AW"},
+    {"", "n", "", "N"},
+
+    {"", "of", " ", "AH V"},
+    {"", "orough", "", "ER OW"},
+    {"#:", "or", " ", "ER"},
+    {"#:", "ors", " ", "ER Z"},
+    {"", "or", "", "AO R"},
+    {" ", "one", "", "W AH N"},
+    {"", "ow", "", "OW"},
+    {" ", "over", "", "OW V ER"},
+    {"", "ov", "", "AH V"},
+    {"", "o", "^%", "OW"},
+    {"", "o", "^en", "OW"},
+    {"", "o", "^i#", "OW"},
+    {"", "ol", "d", "OW L"},
+    {"", "ought", "", "AO T"},
+    {"", "ough", "", "AH F"},
+    {" ", "ou", "", "AW"},
+    {"h", "ou", "s#", "AW"},
+    {"", "ous", "", "AH S"},
+    {"", "our", "", "AO R"},
+    {"", "ould", "", "UH D"},
+    {"^", "ou", "^l", "AH"},
+    {"", "oup", "", "UW P"},
+    {"", "ou", "", "AW"},
+    {"", "oy", "", "OY"},
+    {"", "oing", "", "OW IH NG"},
+    {"", "oi", "", "OY"},
+    {"", "oor", "", "AO R"},
+    {"", "ook", "", "UH K"},
+    {"", "ood", "", "UH D"},
+    {"", "oo", "", "UW"},
+    {"", "o", "e", "OW"},
+    {"", "o", " ", "OW"},
+    {"", "oa", "", "OW"},
+    {" ", "only", "", "OW N L IY"},
+    {" ", "once", "", "W AH N S"},
+    {"", "on't", "", "OW N T"},
+    {"c", "o", "n", "AA"},
+    {"", "o", "ng", "AO"},
+    {" :^", "o", "n", "AH"},
+    {"i", "on", "", "AH N"},
+    {"#:", "on", " ", "AH N"},
+    {"#^", "on", "", "AH N"},
+    {"", "o", "st ", "OW"},
+    {"", "of", "^", "AO F"},
+    {"", "other", "", "AH DH ER"},
+    {"", "oss", " ", "AO S"},
+    {"#^:", "om", "", "AH M"},
+    {"", "o", "", "AA"},
+
+    {"", "ph", "", "F"},
+    {"", "peop", "", "P IY P"},
+    {"", "pow", "", "P AW"},
+    {"", "put", " ", "P UH T"},
+    {"", "p", "", "P"},
+
+    {"", "quar", "", "K W AO R"},
+    {"", "qu", "", "K W"},
+    {"", "q", "", "K"},
+
+    {" ", "re", "^#", "R IY"},
+    {"", "rh", "", "R"},
+    {"", "r", "", "R"},
+
+    {"", "sh", "", "SH"},
+    {"#", "sion", "", "ZH AH N"},
+    {"", "some", "", "S AH M"},
+    {"#", "sur", "#", "ZH ER"},
+    {"", "sur", "#", "SH ER"},
+    {"#", "su", "#", "ZH UW"},
+    {"#", "ssu", "#", "SH UW"},
+    {"#", "sed", " ", "Z D"},
+    {"#", "s", "#", "Z"},
+    {"", "said", "", "S EH D"},
+    {"^", "sion", "", "SH AH N"},
+    {"", "s", "s", ""},
+    {".", "s", " ", "Z"},
+    {"#:.e", "s", " ", "Z"},
+    {"#^:##", "s", " ", "Z"},
+    {"#^:#", "s", " ", "S"},
+    {"u", "s", " ", "S"},
+    {" :#", "s", " ", "Z"},
+    {" ", "sch", "", "S K"},
+    {"", "s", "c+", ""},
+    {"#", "sm", "", "Z M"},
+    {"#", "sn", "'", "Z AH N"},
+    {"", "s", "", "S"},
+
+    {" ", "the", " ", "DH AH"},
+    {"", "to", " ", "T UW"},
+    {"", "that", " ", "DH AE T"},
+    {" ", "this", " ", "DH IH S"},
+    {" ", "they", "", "DH EY"},
+    {" ", "there", "", "DH EH R"},
+    {"", "ther", "", "DH ER"},
+    {"", "their", "", "DH EH R"},
+    {" ", "than", " ", "DH AE N"},
+    {" ", "them", " ", "DH EH M"},
+    {"", "these", " ", "DH IY Z"},
+    {" ", "then", "", "DH EH N"},
+    {"", "through", "", "TH R UW"},
+    {"", "those", "", "DH OW Z"},
+    {"", "though", " ", "DH OW"},
+    {" ", "thus", "", "DH AH S"},
+    {"", "th", "", "TH"},
+    {"#:", "ted", " ", "T IH D"},
+    {"s", "ti", "#n", "CH"},
+    {"", "ti", "o", "SH"},
+    {"", "ti", "a", "SH"},
+    {"", "tien", "", "SH AH N"},
+    {"", "tur", "#", "CH ER"},
+    {"", "tu", "a", "CH UW"},
+    {" ", "two", "", "T UW"},
+    {"", "tch", "", "CH"},
+    {"", "t", "", "T"},
+
+    {" ", "un", "i", "Y UW N"},
+    {" ", "un", "", "AH N"},
+    {" ", "upon", "", "AH P AO N"},
+    {"@", "ur", "#", "UH R"},
+    {"", "ur", "#", "Y UH R"},
+    {"", "ur", "", "ER"},
+    {"", "u", "^ ", "AH"},
+    {"", "u", "^^", "AH"},
+    {"", "uy", "", "AY"},
+    {" g", "u", "#", ""},
+    {"g", "u", "%", ""},
+    {"g", "u", "#", "W"},
+    {"#n", "u", "", "Y UW"},
+    {"@", "u", "", "UW"},
+    {"", "u", "", "Y UW"},
+
+    {"", "view", "", "V Y UW"},
+    {"", "v", "", "V"},
+
+    {" ", "were", "", "W ER"},
+    {"", "wa", "s", "W AA"},
+    {"", "wa", "t", "W AA"},
+    {"", "where", "", "W EH R"},
+    {"", "what", "", "W AA T"},
+    {"", "whol", "", "HH OW L"},
+    {"", "who", "", "HH UW"},
+    {"", "wh", "", "W"},
+    {"", "war", "", "W AO R"},
+    {"", "wor", "^", "W ER"},
+    {"", "wr", "", "R"},
+    {"", "w", "", "W"},
+
+    {" ", "x", "", "Z"},
+    {"", "x", "", "K S"},
+
+    {"", "young", "", "Y AH NG"},
+    {" ", "you", "", "Y UW"},
+    {" ", "yes", "", "Y EH S"},
+    {" ", "y", "", "Y"},
+    {"#^:", "y", " ", "IY"},
+    {"#^:", "y", "i", "IY"},
+    {" :", "y", " ", "AY"},
+    {" :", "y", "#", "AY"},
+    {" :", "y", "^+:#", "IH"},
+    {" :", "y", "^#", "AY"},
+    {"", "y", "", "IH"},
+
+    {"", "z", "", "Z"},
+};
+const size_t LTS_RULE_COUNT = sizeof(LTS_RULES) / sizeof(LTS_RULES[0]);
+
+// First and one-past-last rule for each letter, index 26 is the apostrophe
+struct RuleIndex {
+    uint16_t first[27];
+    uint16_t last[27];
+
+    RuleIndex() {
+        memset(first, 0, sizeof(first));
+        memset(last, 0, sizeof(last));
+        for (size_t r = LTS_RULE_COUNT; r-- > 0;) {
+            int slot = slotOf(LTS_RULES[r].match[0]);
+            if (last[slot] == 0) {
+                last[slot] = (uint16_t)(r + 1);
+            }
+            first[slot] = (uint16_t)r;
+        }
+    }
+
+    static int slotOf(char c) { return c == '\'' ? 26 : c - 'a'; }
+};
+
+bool isVowel(char c) {
+    return c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u' || c == 'y';
+}
+
+bool isConsonant(char c) {
+    return c >= 'a' && c <= 'z' && !isVowel(c);
+}
+
+bool isVoiced(char c) {
+    return c != 0 && strchr("bdvgjlmnrwz", c) != nullptr;
+}
+
+bool isFront(char c) {
+    return c == 'e' || c == 'i' || c == 'y';
+}
+
+// Text the rules see: the word with boundaries around it
+struct Word {
+    const char* text;
+    int length;
+
+    char at(int i) const { return i >= 0 && i < length ? text[i] : 0; }
+    bool has(int i, const char* s) const {
+        for (int k = 0; s[k]; k++) {
+            if (at(i + k) != s[k]) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+bool matchRight(const char* pattern, const Word& w, int pos) {
+    static const char* const SUFFIXES[] = {"ing", "ely", "er", "es", "ed", "e"};
+    for (const char* p = pattern; *p; p++) {
+        switch (*p) {
+            case ' ':
+                if (w.at(pos) != 0) {
+                    return false;
+                }
+                break;
+            case '#':
+                if (!isVowel(w.at(pos))) {
+                    return false;
+                }
+                while (isVowel(w.at(pos))) {
+                    pos++;
+                }
+                break;
+            case ':':
+                while (isConsonant(w.at(pos))) {
+                    pos++;
+                }
+                break;
+            case '^':
+                if (!isConsonant(w.at(pos++))) {
+                    return false;
+                }
+                break;
+            case '+':
+                if (!isFront(w.at(pos++))) {
+                    return false;
+                }
+                break;
+            case '.':
+                if (!isVoiced(w.at(pos++))) {
+                    return false;
+                }
+                break;
+            case '%': {
+                bool found = false;
+                for (const char* suffix : SUFFIXES) {
+                    if (w.has(pos, suffix)) {
+                        pos += (int)strlen(suffix);
+                        found = true;
+                        break;
+                    }
+                }
+                if (!found) {
+                    return false;
+                }
+                break;
+            }
+            default:
+                if (w.at(pos++) != *p) {
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+bool matchLeft(const char* pattern, const Word& w, int pos) {
+    for (int k = (int)strlen(pattern) - 1; k >= 0; k--) {
+        switch (pattern[k]) {
+            case ' ':
+                if (w.at(pos) != 0) {
+                    return false;
+                }
+                break;
+            case '#':
+                if (!isVowel(w.at(pos))) {
+                    return false;
+                }
+                while (isVowel(w.at(pos))) {
+                    pos--;
+                }
+                break;
+            case ':':
+                while (isConsonant(w.at(pos))) {
+                    pos--;
+                }
+                break;
+            case '^':
+                if (!isConsonant(w.at(pos--))) {
+                    return false;
+                }
+                break;
+            case '+':
+                if (!isFront(w.at(pos--))) {
+                    return false;
+                }
+                break;
+            case '.':
+                if (!isVoiced(w.at(pos--))) {
+                    return false;
+                }
+                break;
+            case '&':
+                if (w.has(pos - 1, "ch") || w.has(pos - 1, "sh")) {
+                    pos -= 2;
+                } else if (w.at(pos) != 0 && strchr("scgzxj", w.at(pos)) != nullptr) {
+                    pos--;
+                } else {
+                    return false;
+                }
+                break;
+            case '@':
+                if (w.has(pos - 1, "th") || w.has(pos - 1, "ch") || w.has(pos - 1, "sh")) {
+                    pos -= 2;
+                } else if (w.at(pos) != 0 && strchr("tsrdlznj", w.at(pos)) != nullptr) {
+                    pos--;
+                } else {
+                    return false;
+                }
+                break;
+            default:
+                if (w.at(pos--) != pattern[k]) {
+                    return false;
+                }
+                break;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+size_t letterToSound(const char* word, size_t length, uint8_t* ids, size_t capacity) {
+    static const RuleIndex index;
+    const Word w = {word, (int)length};
+    size_t count = 0;
+    int pos = 0;
+    while (pos < w.length) {
+        char c = w.at(pos);
+        if (!(c >= 'a' && c <= 'z') && c != '\'') {
+            pos++;
+            continue;
+        }
+        // A doubled consonant is one sound (cc is not: accept)
+        if (isConsonant(c) && c != 'c' && w.at(pos + 1) == c) {
+            pos++;
+            continue;
+        }
+        int slot = RuleIndex::slotOf(c);
+        const LtsRule* rule = nullptr;
+        for (uint16_t r = index.first[slot]; r < index.last[slot]; r++) {
+            const LtsRule& candidate = LTS_RULES[r];
+            int n = (int)strlen(candidate.match);
+            if (w.has(pos, candidate.match) && matchLeft(candidate.left, w, pos - 1) &&
+                matchRight(candidate.right, w, pos + n)) {
+                rule = &candidate;
+                break;
+            }
+        }
+        if (rule == nullptr) {
+            pos++;
+            continue;
+        }
+        pos += (int)strlen(rule->match);
+
+        const char* p = rule->phonemes;
+        while (*p) {
+            const char* start = p;
+            while (*p && *p != ' ') {
+                p++;
+            }
+            uint8_t id = phonemeId(start, (size_t)(p - start));
+            if (id != 0 && count < capacity) {
+                ids[count++] = id;
+            }
+            while (*p == ' ') {
+                p++;
+            }
+        }
+    }
+    return count;
+}
@@ -0,0 +1,253 @@
+#include "text_processor.h"
+#include <algorithm>
+#include <cstring>
+
+static const char* const PHONEME_NAMES[PHONEME_COUNT + 1] = {
+    nullptr,
+    "AA", "AE", "AH", "AO", "AW", "AY", "B", "CH", "D", "DH",
+    "EH", "ER", "EY", "F", "G", "HH", "IH", "IY", "JH", "K",
+    "L", "M", "N", "NG", "OW", "OY", "P", "R", "S", "SH",
+    "T", "TH", "UH", "UW", "V", "W", "Y", "Z", "ZH"
+};
+
+const char* phonemeName(uint8_t id) {
+    if (id >= 1 && id <= PHONEME_COUNT) {
+        return PHONEME_NAMES[id];
+    }
+    if (id >= PHONEME_WORD_BREAK && id <= PHONEME_STOP) {
+        return "";
+    }
+    return nullptr;
+}
+
+uint8_t phonemeId(const char* name, size_t length) {
+    if (length > 0 && name[length - 1] >= '0' && name[length - 1] <= '9') {
+        length--;                       // Stress
+    }
+    for (uint8_t id = 1; id <= PHONEME_COUNT; id++) {
+        const char* candidate = PHONEME_NAMES[id];
+        if (strlen(candidate) == length && strncmp(candidate, name, length) == 0) {
+            return id;
+        }
+    }
+    return 0;
+}
+
+static int lexiconCode(char c) {
+    if (c >= 'a' && c <= 'z') {
+        return c - 'a' + 1;
+    }
+    return c == '\'' ? 27 : -1;
+}
+
+Lexicon::Lexicon() : da_(nullptr), pool_(nullptr), pool_bytes_(0) {
+    memset(&info_, 0, sizeof(info_));
+}
+
+bool Lexicon::attach(const ModelFile& model) {
+    detach();
+    ModelTensor info, da, pool;
+    if (!model.find("lex.info", &info) || !model.find("lex.da", &da) || !model.find("lex.pool", &pool)) {
+        return false;
+    }
+    if (info.type != ModelTensorType::INT32 || info.dims[0] < 2 || da.type != ModelTensorType::INT32 ||
+        da.rank != 2 || da.dims[1] != 2 || da.dims[0] == 0 || pool.type != ModelTensorType::INT8) {
+        return false;
+    }
+    const int32_t* values = static_cast<const int32_t*>(info.data);
+    da_ = static_cast<const int32_t*>(da.data);
+    pool_ = static_cast<const uint8_t*>(pool.data);
+    pool_bytes_ = pool.bytes;
+    info_.words = (uint32_t)values[0];
+    info_.max_phonemes = (uint32_t)values[1];
+    info_.states = da.dims[0];
+    info_.bytes = info.bytes + da.bytes + pool.bytes;
+    return true;
+}
+
+void Lexicon::detach() {
+    da_ = nullptr;
+    pool_ = nullptr;
+    pool_bytes_ = 0;
+    memset(&info_, 0, sizeof(info_));
+}
+
+bool Lexicon::lookup(const char* word, size_t length, const uint8_t** phonemes, size_t* count) const {
+    if (da_ == nullptr) {
+        return false;
+    }
+    int32_t s = 0;
+    for (size_t i = 0; i <= length; i++) {
+        int c = i < length ? lexiconCode(word[i]) : 0;
+        if (c < 0) {
+            return false;
+        }
+        uint32_t t = (uint32_t)(da_[2 * s] + c);
+        if (da_[2 * s] <= 0 || t >= info_.states || da_[2 * t + 1] != s) {
+            return false;
+        }
+        s = (int32_t)t;
+        int32_t base = da_[2 * s];
+        if (base >= 0) {
+            continue;
+        }
+
+        // Leaf: the rest of the word must be its tail
+        size_t offset = (size_t)(-(base + 1));
+        size_t rest = i < length ? length - i - 1 : 0;
+        // The pool comes from flash; the whole entry must lie inside it
+        if (offset >= pool_bytes_ || pool_bytes_ - offset < 2 + rest) {
+            return false;
+        }
+        const uint8_t* entry = pool_ + offset;
+        if (entry[0] != rest || memcmp(entry + 1, word + length - rest, rest) != 0) {
+            return false;
+        }
+        size_t n = entry[1 + rest];
+        if (pool_bytes_ - offset - 2 - rest < n) {
+            return false;
+        }
+        *count = n;
+        *phonemes = entry + 2 + rest;
+        return true;
+    }
+    return false;
+}
+
+bool LexiconBuilder::add(const char* word, const char* arpabet) {
+    Entry entry;
+    for (const char* p = word; *p; p++) {
+        char c = (*p >= 'A' && *p <= 'Z') ? (char)(*p - 'A' + 'a') : *p;
+        if (lexiconCode(c) < 0) {
+            return false;
+        }
+        entry.word += c;
+    }
+    const char* p = arpabet;
+    while (*p) {
+        while (*p == ' ') {
+            p++;
+        }
+        const char* start = p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+        if (p == start) {
+            break;
+        }
+        uint8_t id = phonemeId(start, (size_t)(p - start));
+        if (id == 0) {
+            return false;
+        }
+        entry.phonemes.push_back(id);
+    }
+    if (entry.word.empty() || entry.word.size() > 255 || entry.phonemes.empty() || entry.phonemes.size() > 255) {
+        return false;
+    }
+    entries_.push_back(entry);
+    return true;
+}
+
+void LexiconBuilder::grow(size_t states) {
+    if (check_.size() < states) {
+        base_.resize(states, 0);
+        check_.resize(states, -1);
+    }
+}
+
+int32_t LexiconBuilder::findBase(const int* codes, size_t count) {
+    int min_code = codes[0];
+    for (size_t i = 1; i < count; i++) {
+        min_code = std::min(min_code, codes[i]);
+    }
+    for (int32_t b = std::max<int32_t>(1, (int32_t)first_free_ - min_code);; b++) {
+        bool free = true;
+        for (size_t i = 0; i < count && free; i++) {
+            grow((size_t)b + codes[i] + 1);
+            free = check_[b + codes[i]] == -1;
+        }
+        if (free) {
+            return b;
+        }
+    }
+}
+
+void LexiconBuilder::place(int32_t state, size_t lo, size_t hi, size_t depth) {
+    int codes[LEXICON_CODE_COUNT] = {};
+    size_t starts[LEXICON_CODE_COUNT + 1];
+    size_t groups = 0;
+    for (size_t i = lo; i < hi; i++) {
+        const std::string& word = entries_[i].word;
+        int c = depth < word.size() ? lexiconCode(word[depth]) : 0;
+        if (groups == 0 || codes[groups - 1] != c) {
+            codes[groups] = c;
+            starts[groups] = i;
+            groups++;
+        }
+    }
+    starts[groups] = hi;
+
+    int32_t b = findBase(codes, groups);
+    base_[state] = b;
+    for (size_t g = 0; g < groups; g++) {
+        check_[b + codes[g]] = state;
+    }
+    while (first_free_ < check_.size() && check_[first_free_] != -1) {
+        first_free_++;
+    }
+
+    for (size_t g = 0; g < groups; g++) {
+        int32_t t = b + codes[g];
+        if (starts[g + 1] - starts[g] > 1) {
+            place(t, starts[g], starts[g + 1], depth + 1);
+            continue;
+        }
+        const Entry& entry = entries_[starts[g]];
+        size_t tail = codes[g] == 0 ? entry.word.size() : depth + 1;
+        base_[t] = -(int32_t)pool_.size() - 1;
+        pool_.push_back((uint8_t)(entry.word.size() - tail));
+        pool_.insert(pool_.end(), entry.word.begin() + tail, entry.word.end());
+        pool_.push_back((uint8_t)entry.phonemes.size());
+        pool_.insert(pool_.end(), entry.phonemes.begin(), entry.phonemes.end());
+    }
+}
+
+bool LexiconBuilder::build(ModelFileWriter& writer) {
+    std::stable_sort(entries_.begin(), entries_.end(),
+                     [](const Entry& a, const Entry& b) { return a.word < b.word; });
+    entries_.erase(std::unique(entries_.begin(), entries_.end(),
+                               [](const Entry& a, const Entry& b) { return a.word == b.word; }),
+                   entries_.end());
+    if (entries_.empty()) {
+        return false;
+    }
+
+    base_.clear();
+    check_.clear();
+    pool_.clear();
+    grow(1);
+    check_[0] = -2;                     // Root, never a transition target
+    first_free_ = 1;
+    place(0, 0, entries_.size(), 0);
+    while (check_.size() > 1 && check_.back() == -1) {
+        check_.pop_back();
+        base_.pop_back();
+    }
+
+    int32_t max_phonemes = 0;
+    for (const Entry& entry : entries_) {
+        max_phonemes = std::max(max_phonemes, (int32_t)entry.phonemes.size());
+    }
+    const int32_t info[2] = {(int32_t)entries_.size(), max_phonemes};
+    std::vector<int32_t> da(2 * base_.size());
+    for (size_t s = 0; s < base_.size(); s++) {
+        da[2 * s] = base_[s];
+        da[2 * s + 1] = check_[s];
+    }
+    const uint32_t info_dims[1] = {2};
+    const uint32_t da_dims[2] = {(uint32_t)base_.size(), 2};
+    const uint32_t pool_dims[1] = {(uint32_t)pool_.size()};
+    return writer.add("lex.info", ModelTensorType::INT32, info_dims, 1, info) &&
+           writer.add("lex.da", ModelTensorType::INT32, da_dims, 2, da.data()) &&
+           writer.add("lex.pool", ModelTensorType::INT8, pool_dims, 1, pool_.data());
+}
@@ -0,0 +1,64 @@
+#include "synthesizer_backend.h"
+#include "audio_platform.h"
+#include <cstring>
+#if __has_include("piper.h")
+#include "piper.h"  // Include Piper API
+#endif
+
+// Piper's defaults for its medium-quality voices
+TtsVoice defaultTtsVoice() {
+    TtsVoice voice;
+    voice.speaker = 0;
+    voice.length_scale = 1.0f;
+    voice.noise_scale = 0.667f;
+    voice.noise_w = 0.8f;
+    return voice;
+}
+
+// Placeholder pacing: roughly 14 characters per second of speech
+static const uint32_t PIPER_MS_PER_CHAR = 70;
+static const size_t PIPER_BLOCK_SAMPLES = 256;
+static const size_t PIPER_MAX_PHONEMES = 1024;
+
+PiperBackend::PiperBackend() : model_(nullptr), sample_rate_(22050), ids_(PIPER_MAX_PHONEMES) {}
+
+bool PiperBackend::initialize(const ModelFile* model) {
+    // Weights must be for this backend; they stay in the mapping
+    if (model != nullptr && strcmp(model->arch(), name()) != 0) {
+        AUDIO_LOGF("Model is for '%s', not %s\n", model->arch(), name());
+        return false;
+    }
+    model_ = model;
+    text_.detachLexicon();
+    if (model != nullptr && model->find("lex.da", nullptr)) {
+        return text_.attachLexicon(*model);
+    }
+    return true;
+}
+
+bool PiperBackend::synthesize(const char* text, size_t length, const TtsVoice& voice, const AudioFunction& out) {
+    if (text == nullptr || length == 0) {
+        return true;
+    }
+    size_t count = text_.process(text, length, ids_.data(), ids_.size());
+    return piper_synthesize(ids_.data(), count, length, voice, out);
+}
+
+bool PiperBackend::piper_synthesize(const uint8_t* ids, size_t count, size_t length, const TtsVoice& voice,
+                                    const AudioFunction& out) {
+    // Placeholder function to simulate Piper synthesis
+    // Replace with actual Piper API call; emits silence of the expected length
+    (void)ids;
+    (void)count;
+    static const int16_t silence[PIPER_BLOCK_SAMPLES] = {};
+    uint64_t total = (uint64_t)length * PIPER_MS_PER_CHAR * sample_rate_ / 1000;
+    total = (uint64_t)(total * voice.length_scale);
+    while (total > 0) {
+        size_t n = total < PIPER_BLOCK_SAMPLES ? (size_t)total : PIPER_BLOCK_SAMPLES;
+        if (!out(silence, n)) {
+            return false;
+        }
+        total -= n;
+    }
+    return true;
+}
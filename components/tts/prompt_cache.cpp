@@ -0,0 +1,652 @@
+#include "prompt_cache.h"
+#include "audio_platform.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <sys/stat.h>
+
+using audio_processing::MemoryRegion;
+using audio_processing::audioAlloc;
+using audio_processing::audioFree;
+using audio_processing::audioMicros;
+
+static const uint32_t PROMPT_FILE_MAGIC = 0x50435031; // "PCP1"
+static const size_t PROMPT_PATH_BYTES = 128;
+
+// One SD entry: this header, then the ADPCM blocks
+struct PromptFileHeader {
+    uint32_t magic;
+    uint32_t samples;
+    uint32_t bytes;
+    uint32_t reserved;
+    uint64_t key;
+};
+
+static const int IMA_INDEX_TABLE[8] = {-1, -1, -1, -1, 2, 4, 6, 8};
+
+static const int16_t IMA_STEP_TABLE[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796, 876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487,
+    12635, 13899, 15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static uint32_t blocksFor(uint32_t samples) {
+    return (samples + PROMPT_BLOCK_SAMPLES - 1) / PROMPT_BLOCK_SAMPLES;
+}
+
+// Apply one nibble to the predictor and step index, as the decoder does
+static void imaStep(uint8_t nibble, int* predictor, int* index) {
+    int step = IMA_STEP_TABLE[*index];
+    int delta = step >> 3;
+    if (nibble & 4) {
+        delta += step;
+    }
+    if (nibble & 2) {
+        delta += step >> 1;
+    }
+    if (nibble & 1) {
+        delta += step >> 2;
+    }
+    *predictor += (nibble & 8) ? -delta : delta;
+    if (*predictor > 32767) {
+        *predictor = 32767;
+    } else if (*predictor < -32768) {
+        *predictor = -32768;
+    }
+    *index += IMA_INDEX_TABLE[nibble & 7];
+    if (*index < 0) {
+        *index = 0;
+    } else if (*index > 88) {
+        *index = 88;
+    }
+}
+
+static uint8_t imaEncode(int sample, int* predictor, int* index) {
+    int diff = sample - *predictor;
+    uint8_t nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+    int step = IMA_STEP_TABLE[*index];
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+    if (diff >= step >> 1) {
+        nibble |= 2;
+        diff -= step >> 1;
+    }
+    if (diff >= step >> 2) {
+        nibble |= 1;
+    }
+    imaStep(nibble, predictor, index);
+    return nibble;
+}
+
+PromptCacheConfig defaultPromptCacheConfig() {
+    PromptCacheConfig config;
+    config.psram_budget_bytes = 512 * 1024;
+    config.max_entries = 64;
+    config.max_entry_samples = 8 * 22050;
+    config.sd_directory = nullptr;
+    config.sd_budget_bytes = 8 * 1024 * 1024;
+    config.max_sd_entries = 256;
+    config.spill_min_hits = 1;
+    return config;
+}
+
+uint64_t promptKey(const char* normalized, size_t length, const TtsVoice& voice, int sample_rate) {
+    // FNV-1a over the text, then the voice with its scales in thousandths
+    uint64_t hash = 0xcbf29ce484222325ull;
+    auto mix = [&hash](const void* data, size_t bytes) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        for (size_t i = 0; i < bytes; i++) {
+            hash ^= p[i];
+            hash *= 0x100000001b3ull;
+        }
+    };
+    mix(normalized, length);
+    const int32_t params[5] = {
+        (int32_t)voice.speaker,
+        (int32_t)lroundf(voice.length_scale * 1000.0f),
+        (int32_t)lroundf(voice.noise_scale * 1000.0f),
+        (int32_t)lroundf(voice.noise_w * 1000.0f),
+        (int32_t)sample_rate,
+    };
+    mix(params, sizeof(params));
+    return hash;
+}
+
+PromptCache::PromptCache(const PromptCacheConfig& config)
+    : config_(config), lru_head_(-1), lru_tail_(-1), clock_(0), sd_ready_(false), sd_pinned_(false),
+      sd_pinned_key_(0), recording_(false),
+      record_key_(0), staging_(nullptr), staging_bytes_(0), record_samples_(0), pending_count_(0),
+      encode_index_(0), hit_start_us_(0) {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+PromptCache::~PromptCache() {
+    deinit();
+}
+
+bool PromptCache::init() {
+    if (isInitialized()) {
+        return true;
+    }
+    if (config_.max_entries == 0 || config_.max_entry_samples == 0) {
+        return false;
+    }
+    staging_bytes_ = (size_t)blocksFor((uint32_t)config_.max_entry_samples) * PROMPT_BLOCK_BYTES;
+    staging_ = static_cast<uint8_t*>(audioAlloc(staging_bytes_, MemoryRegion::PSRAM));
+    if (staging_ == nullptr) {
+        staging_bytes_ = 0;
+        return false;
+    }
+    Slot empty;
+    memset(&empty, 0, sizeof(empty));
+    empty.prev = -1;
+    empty.next = -1;
+    slots_.assign(config_.max_entries, empty);
+    lru_head_ = -1;
+    lru_tail_ = -1;
+    clock_ = 0;
+    memset(&stats_, 0, sizeof(stats_));
+
+    sd_ready_ = false;
+    if (config_.sd_directory != nullptr && config_.max_sd_entries > 0 &&
+        strlen(config_.sd_directory) + 24 < PROMPT_PATH_BYTES) {
+        mkdir(config_.sd_directory, 0775);
+        DIR* dir = opendir(config_.sd_directory);
+        if (dir != nullptr) {
+            closedir(dir);
+            sd_slots_.reserve(config_.max_sd_entries);
+            sd_ready_ = true;
+            indexSdDirectory();
+        }
+    }
+    return true;
+}
+
+void PromptCache::deinit() {
+    for (Slot& slot : slots_) {
+        audioFree(slot.data);
+    }
+    slots_.clear();
+    slots_.shrink_to_fit();
+    sd_slots_.clear();
+    sd_slots_.shrink_to_fit();
+    audioFree(staging_);
+    staging_ = nullptr;
+    staging_bytes_ = 0;
+    recording_ = false;
+    sd_ready_ = false;
+    lru_head_ = -1;
+    lru_tail_ = -1;
+    stats_.entries = 0;
+    stats_.bytes = 0;
+    stats_.sd_entries = 0;
+    stats_.sd_bytes = 0;
+}
+
+bool PromptCache::sdPath(uint64_t key, char* path, size_t capacity) const {
+    int n = snprintf(path, capacity, "%s/%016llx.pcm", config_.sd_directory, (unsigned long long)key);
+    return n > 0 && (size_t)n < capacity;
+}
+
+void PromptCache::indexSdDirectory() {
+    DIR* dir = opendir(config_.sd_directory);
+    if (dir == nullptr) {
+        return;
+    }
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != nullptr) {
+        const char* name = entry->d_name;
+        if (strlen(name) != 20 || strcmp(name + 16, ".pcm") != 0) {
+            continue;
+        }
+        char* end = nullptr;
+        uint64_t key = strtoull(name, &end, 16);
+        char path[PROMPT_PATH_BYTES];
+        if (end != name + 16 || !sdPath(key, path, sizeof(path))) {
+            continue;
+        }
+
+        // Keep files that are whole and fit the budget; drop the rest
+        PromptFileHeader header;
+        memset(&header, 0, sizeof(header));
+        bool valid = false;
+        FILE* file = fopen(path, "rb");
+        if (file != nullptr) {
+            if (fread(&header, 1, sizeof(header), file) == sizeof(header) && header.magic == PROMPT_FILE_MAGIC &&
+                header.key == key && header.samples > 0 &&
+                header.bytes == blocksFor(header.samples) * PROMPT_BLOCK_BYTES && fseek(file, 0, SEEK_END) == 0) {
+                long size = ftell(file);
+                valid = size == (long)(sizeof(header) + header.bytes);
+            }
+            fclose(file);
+        }
+        size_t file_bytes = sizeof(header) + header.bytes;
+        if (!valid || sd_slots_.size() >= config_.max_sd_entries ||
+            stats_.sd_bytes + file_bytes > config_.sd_budget_bytes) {
+            remove(path);
+            continue;
+        }
+        SdSlot slot;
+        slot.key = key;
+        slot.bytes = (uint32_t)file_bytes;
+        slot.last_use = 0;
+        sd_slots_.push_back(slot);
+        stats_.sd_entries++;
+        stats_.sd_bytes += file_bytes;
+    }
+    closedir(dir);
+}
+
+int32_t PromptCache::findSlot(uint64_t key) const {
+    // A few dozen entries: a scan of the table beats keeping an index
+    for (size_t i = 0; i < slots_.size(); i++) {
+        if (slots_[i].data != nullptr && slots_[i].key == key) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+int32_t PromptCache::findSdSlot(uint64_t key) const {
+    for (size_t i = 0; i < sd_slots_.size(); i++) {
+        if (sd_slots_[i].key == key) {
+            return (int32_t)i;
+        }
+    }
+    return -1;
+}
+
+bool PromptCache::contains(uint64_t key) const {
+    return findSlot(key) >= 0 || findSdSlot(key) >= 0;
+}
+
+void PromptCache::unlink(int32_t slot) {
+    Slot& s = slots_[slot];
+    if (s.prev >= 0) {
+        slots_[s.prev].next = s.next;
+    } else {
+        lru_head_ = s.next;
+    }
+    if (s.next >= 0) {
+        slots_[s.next].prev = s.prev;
+    } else {
+        lru_tail_ = s.prev;
+    }
+    s.prev = -1;
+    s.next = -1;
+}
+
+void PromptCache::pushFront(int32_t slot) {
+    Slot& s = slots_[slot];
+    s.prev = -1;
+    s.next = lru_head_;
+    if (lru_head_ >= 0) {
+        slots_[lru_head_].prev = slot;
+    }
+    lru_head_ = slot;
+    if (lru_tail_ < 0) {
+        lru_tail_ = slot;
+    }
+}
+
+void PromptCache::evict(int32_t slot) {
+    Slot& s = slots_[slot];
+    if (sd_ready_ && !s.on_sd && s.hits >= config_.spill_min_hits) {
+        spill(s);
+    }
+    unlink(slot);
+    audioFree(s.data);
+    s.data = nullptr;
+    stats_.entries--;
+    stats_.bytes -= s.bytes;
+    stats_.evictions++;
+}
+
+bool PromptCache::makeRoom(size_t bytes) {
+    if (bytes > config_.psram_budget_bytes) {
+        return false;
+    }
+    while (lru_tail_ >= 0 &&
+           (stats_.bytes + bytes > config_.psram_budget_bytes || stats_.entries >= slots_.size())) {
+        evict(lru_tail_);
+    }
+    return true;
+}
+
+bool PromptCache::store(uint64_t key, uint8_t* data, uint32_t bytes, uint32_t samples, bool on_sd) {
+    for (size_t i = 0; i < slots_.size(); i++) {
+        Slot& s = slots_[i];
+        if (s.data != nullptr) {
+            continue;
+        }
+        s.key = key;
+        s.data = data;
+        s.bytes = bytes;
+        s.samples = samples;
+        s.hits = 0;
+        s.on_sd = on_sd;
+        pushFront((int32_t)i);
+        stats_.entries++;
+        stats_.bytes += bytes;
+        return true;
+    }
+    return false;
+}
+
+void PromptCache::removeSdSlot(int32_t sd_slot) {
+    char path[PROMPT_PATH_BYTES];
+    if (sdPath(sd_slots_[sd_slot].key, path, sizeof(path))) {
+        remove(path);
+    }
+    int32_t slot = findSlot(sd_slots_[sd_slot].key);
+    if (slot >= 0) {
+        slots_[slot].on_sd = false;
+    }
+    stats_.sd_entries--;
+    stats_.sd_bytes -= sd_slots_[sd_slot].bytes;
+    sd_slots_[sd_slot] = sd_slots_.back();
+    sd_slots_.pop_back();
+}
+
+void PromptCache::spill(const Slot& slot) {
+    PromptFileHeader header;
+    header.magic = PROMPT_FILE_MAGIC;
+    header.samples = slot.samples;
+    header.bytes = slot.bytes;
+    header.reserved = 0;
+    header.key = slot.key;
+    const size_t file_bytes = sizeof(header) + slot.bytes;
+    if (file_bytes > config_.sd_budget_bytes) {
+        return;
+    }
+
+    // Least recently used files make room, except a pinned one; with
+    // nothing left to remove the entry is dropped instead of spilled
+    while (stats_.sd_bytes + file_bytes > config_.sd_budget_bytes ||
+           sd_slots_.size() >= config_.max_sd_entries) {
+        int32_t oldest = -1;
+        for (size_t i = 0; i < sd_slots_.size(); i++) {
+            if (sd_pinned_ && sd_slots_[i].key == sd_pinned_key_) {
+                continue;
+            }
+            if (oldest < 0 || sd_slots_[i].last_use < sd_slots_[oldest].last_use) {
+                oldest = (int32_t)i;
+            }
+        }
+        if (oldest < 0) {
+            return;
+        }
+        removeSdSlot(oldest);
+        stats_.sd_evictions++;
+    }
+
+    char path[PROMPT_PATH_BYTES];
+    if (!sdPath(slot.key, path, sizeof(path))) {
+        return;
+    }
+    FILE* file = fopen(path, "wb");
+    bool ok = file != nullptr;
+    if (ok) {
+        ok = fwrite(&header, 1, sizeof(header), file) == sizeof(header) &&
+             fwrite(slot.data, 1, slot.bytes, file) == slot.bytes;
+        ok = fclose(file) == 0 && ok;
+    }
+    if (!ok) {
+        remove(path);
+        stats_.sd_errors++;
+        return;
+    }
+    SdSlot sd_slot;
+    sd_slot.key = slot.key;
+    sd_slot.bytes = (uint32_t)file_bytes;
+    sd_slot.last_use = ++clock_;
+    sd_slots_.push_back(sd_slot);
+    stats_.sd_entries++;
+    stats_.sd_bytes += file_bytes;
+    stats_.spills++;
+}
+
+bool PromptCache::decodeBlock(const uint8_t* block, uint32_t samples,
+                              const SynthesizerBackend::AudioFunction& out) {
+    int predictor = (int16_t)(block[0] | (block[1] << 8));
+    int index = block[2] > 88 ? 88 : block[2];
+    decoded_[0] = (int16_t)predictor;
+    for (uint32_t i = 1; i < samples; i++) {
+        uint8_t byte = block[4 + (i - 1) / 2];
+        uint8_t nibble = (i & 1) ? (byte & 0x0F) : (byte >> 4);
+        imaStep(nibble, &predictor, &index);
+        decoded_[i] = (int16_t)predictor;
+    }
+    if (hit_start_us_ != 0) {
+        stats_.first_audio_us = audioMicros() - hit_start_us_;
+        stats_.total_first_audio_us += stats_.first_audio_us;
+        if (stats_.first_audio_us > stats_.max_first_audio_us) {
+            stats_.max_first_audio_us = stats_.first_audio_us;
+        }
+        hit_start_us_ = 0;
+    }
+    return out(decoded_, samples);
+}
+
+PromptPlayback PromptCache::play(uint64_t key, const SynthesizerBackend::AudioFunction& out) {
+    if (!isInitialized()) {
+        return PromptPlayback::MISS;
+    }
+    const uint64_t start = audioMicros();
+    stats_.lookups++;
+    int32_t slot = findSlot(key);
+    if (slot < 0) {
+        int32_t sd_slot = findSdSlot(key);
+        if (sd_slot < 0) {
+            return PromptPlayback::MISS;
+        }
+        hit_start_us_ = start;
+        return playSd(sd_slot, out);
+    }
+
+    Slot& s = slots_[slot];
+    stats_.hits++;
+    stats_.psram_hits++;
+    s.hits++;
+    unlink(slot);
+    pushFront(slot);
+    if (s.on_sd) {
+        int32_t sd_slot = findSdSlot(key);
+        if (sd_slot >= 0) {
+            sd_slots_[sd_slot].last_use = ++clock_;
+        }
+    }
+
+    hit_start_us_ = start;
+    uint32_t remaining = s.samples;
+    for (const uint8_t* block = s.data; remaining > 0; block += PROMPT_BLOCK_BYTES) {
+        uint32_t n = remaining < PROMPT_BLOCK_SAMPLES ? remaining : PROMPT_BLOCK_SAMPLES;
+        if (!decodeBlock(block, n, out)) {
+            hit_start_us_ = 0;
+            return PromptPlayback::STOPPED;
+        }
+        remaining -= n;
+    }
+    return PromptPlayback::PLAYED;
+}
+
+PromptPlayback PromptCache::playSd(int32_t sd_slot, const SynthesizerBackend::AudioFunction& out) {
+    const uint64_t key = sd_slots_[sd_slot].key;
+    const uint32_t file_bytes = sd_slots_[sd_slot].bytes;
+    sd_slots_[sd_slot].last_use = ++clock_;
+
+    // Room for the copy first: evictions may spill, and the file being
+    // read stays pinned so a spill cannot push it out
+    const uint32_t bytes = file_bytes - (uint32_t)sizeof(PromptFileHeader);
+    uint8_t* data = nullptr;
+    sd_pinned_ = true;
+    sd_pinned_key_ = key;
+    if (makeRoom(bytes)) {
+        data = static_cast<uint8_t*>(audioAlloc(bytes, MemoryRegion::PSRAM));
+    }
+    sd_pinned_ = false;
+    sd_slot = findSdSlot(key);
+
+    char path[PROMPT_PATH_BYTES];
+    FILE* file = nullptr;
+    PromptFileHeader header;
+    if (sd_slot >= 0 && sdPath(key, path, sizeof(path))) {
+        file = fopen(path, "rb");
+    }
+    if (file == nullptr || fread(&header, 1, sizeof(header), file) != sizeof(header) ||
+        header.magic != PROMPT_FILE_MAGIC || header.key != key || header.bytes != bytes ||
+        header.bytes != blocksFor(header.samples) * PROMPT_BLOCK_BYTES) {
+        if (file != nullptr) {
+            fclose(file);
+        }
+        if (sd_slot >= 0) {
+            removeSdSlot(sd_slot);
+            stats_.sd_errors++;
+        }
+        audioFree(data);
+        hit_start_us_ = 0;
+        return PromptPlayback::MISS;
+    }
+    stats_.hits++;
+    stats_.sd_hits++;
+
+    // Each block goes out as soon as it is read, into the copy when there
+    // is one
+    PromptPlayback result = PromptPlayback::PLAYED;
+    uint32_t remaining = header.samples;
+    for (uint32_t b = 0; remaining > 0; b++) {
+        uint8_t* block = data != nullptr ? data + (size_t)b * PROMPT_BLOCK_BYTES : file_block_;
+        uint32_t n = remaining < PROMPT_BLOCK_SAMPLES ? remaining : PROMPT_BLOCK_SAMPLES;
+        if (fread(block, 1, PROMPT_BLOCK_BYTES, file) != PROMPT_BLOCK_BYTES) {
+            stats_.sd_errors++;
+            result = PromptPlayback::STOPPED;
+            break;
+        }
+        if (!decodeBlock(block, n, out)) {
+            result = PromptPlayback::STOPPED;
+            break;
+        }
+        remaining -= n;
+    }
+    fclose(file);
+    hit_start_us_ = 0;
+
+    if (result != PromptPlayback::PLAYED || data == nullptr || !store(key, data, bytes, header.samples, true)) {
+        audioFree(data);
+        return result;
+    }
+    slots_[findSlot(key)].hits = 1;
+    return result;
+}
+
+void PromptCache::beginInsert(uint64_t key) {
+    if (!isInitialized()) {
+        return;
+    }
+    recording_ = true;
+    record_key_ = key;
+    record_samples_ = 0;
+    pending_count_ = 0;
+    encode_index_ = 0;
+}
+
+void PromptCache::flushBlock() {
+    uint8_t* block = staging_ + (size_t)(record_samples_ / PROMPT_BLOCK_SAMPLES) * PROMPT_BLOCK_BYTES;
+    int predictor = pending_[0];
+    block[0] = (uint8_t)(predictor & 0xFF);
+    block[1] = (uint8_t)((predictor >> 8) & 0xFF);
+    block[2] = (uint8_t)encode_index_;
+    block[3] = 0;
+    memset(block + 4, 0, PROMPT_BLOCK_BYTES - 4);
+    for (uint32_t i = 1; i < pending_count_; i++) {
+        uint8_t nibble = imaEncode(pending_[i], &predictor, &encode_index_);
+        block[4 + (i - 1) / 2] |= (i & 1) ? nibble : (uint8_t)(nibble << 4);
+    }
+    record_samples_ += pending_count_;
+    pending_count_ = 0;
+}
+
+bool PromptCache::append(const int16_t* samples, size_t count) {
+    if (!recording_) {
+        return false;
+    }
+    if ((size_t)record_samples_ + pending_count_ + count > config_.max_entry_samples) {
+        recording_ = false;
+        stats_.rejected++;
+        return false;
+    }
+    while (count > 0) {
+        size_t n = PROMPT_BLOCK_SAMPLES - pending_count_;
+        if (n > count) {
+            n = count;
+        }
+        memcpy(pending_ + pending_count_, samples, n * sizeof(int16_t));
+        pending_count_ += (uint32_t)n;
+        samples += n;
+        count -= n;
+        if (pending_count_ == PROMPT_BLOCK_SAMPLES) {
+            flushBlock();
+        }
+    }
+    return true;
+}
+
+void PromptCache::abortInsert() {
+    recording_ = false;
+}
+
+bool PromptCache::commitInsert() {
+    if (!recording_) {
+        return false;
+    }
+    recording_ = false;
+    if (pending_count_ > 0) {
+        flushBlock();
+    }
+    if (record_samples_ == 0 || findSlot(record_key_) >= 0) {
+        return record_samples_ > 0;
+    }
+    const uint32_t bytes = blocksFor(record_samples_) * PROMPT_BLOCK_BYTES;
+    uint8_t* data = nullptr;
+    if (makeRoom(bytes)) {
+        data = static_cast<uint8_t*>(audioAlloc(bytes, MemoryRegion::PSRAM));
+    }
+    if (data == nullptr) {
+        stats_.rejected++;
+        return false;
+    }
+    memcpy(data, staging_, bytes);
+    if (!store(record_key_, data, bytes, record_samples_, findSdSlot(record_key_) >= 0)) {
+        audioFree(data);
+        stats_.rejected++;
+        return false;
+    }
+    stats_.inserts++;
+    return true;
+}
+
+void PromptCache::clear() {
+    for (size_t i = 0; i < slots_.size(); i++) {
+        audioFree(slots_[i].data);
+        slots_[i].data = nullptr;
+        slots_[i].prev = -1;
+        slots_[i].next = -1;
+    }
+    lru_head_ = -1;
+    lru_tail_ = -1;
+    stats_.entries = 0;
+    stats_.bytes = 0;
+    while (!sd_slots_.empty()) {
+        removeSdSlot((int32_t)sd_slots_.size() - 1);
+    }
+    recording_ = false;
+}
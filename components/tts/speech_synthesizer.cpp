@@ -0,0 +1,216 @@
+#include "speech_synthesizer.h"
+#include "audio_platform.h"
+#include <cstring>
+
+using audio_processing::audioMicros;
+
+// Longer texts are replies, not prompts, and are never cached
+static const size_t SYNTH_PROMPT_TEXT_BYTES = 512;
+
+SynthesizerConfig defaultSynthesizerConfig() {
+    SynthesizerConfig config;
+    config.first_chunk_chars = 12;
+    config.max_chunk_chars = 160;
+    return config;
+}
+
+static bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static bool isSentenceEnd(char c) {
+    return c == '.' || c == '!' || c == '?' || c == '\n';
+}
+
+static bool isPhraseEnd(char c) {
+    return isSentenceEnd(c) || c == ',' || c == ';' || c == ':';
+}
+
+TextChunker::TextChunker(const char* text, size_t length, const SynthesizerConfig& config)
+    : text_(text), length_(length), pos_(0), config_(config), first_(true) {
+    if (config_.max_chunk_chars == 0) {
+        config_.max_chunk_chars = 1;
+    }
+}
+
+bool TextChunker::next(const char** chunk, size_t* length) {
+    while (pos_ < length_ && isSpace(text_[pos_])) {
+        pos_++;
+    }
+    if (pos_ >= length_) {
+        return false;
+    }
+
+    const size_t start = pos_;
+    size_t limit = length_ - start;
+    if (limit > config_.max_chunk_chars) {
+        limit = config_.max_chunk_chars;
+    }
+    // A break is punctuation followed by whitespace or the end of the text
+    auto breakAt = [this, start](size_t i) {
+        return start + i + 1 >= length_ || isSpace(text_[start + i + 1]);
+    };
+
+    size_t end = 0;                     // Chunk length, 0 while not found
+    size_t phrase = 0;
+    size_t space = 0;
+    for (size_t i = 0; i < limit && end == 0; i++) {
+        char c = text_[start + i];
+        if (isSpace(c)) {
+            space = i;
+        }
+        if (!isPhraseEnd(c) || !breakAt(i)) {
+            continue;
+        }
+        phrase = i + 1;
+        if (isSentenceEnd(c) || (first_ && i + 1 >= config_.first_chunk_chars)) {
+            end = i + 1;
+        }
+    }
+    if (end == 0) {
+        if (start + limit >= length_) {
+            end = limit;                // The rest fits
+        } else if (phrase > 0) {
+            end = phrase;
+        } else if (space > 0) {
+            end = space;
+        } else {
+            end = limit;                // One long word
+        }
+    }
+
+    pos_ = start + end;
+    first_ = false;
+    while (end > 0 && isSpace(text_[start + end - 1])) {
+        end--;
+    }
+    *chunk = text_ + start;
+    *length = end;
+    return true;
+}
+
+SpeechSynthesizer::SpeechSynthesizer()
+    : backend_(&piper_), config_(defaultSynthesizerConfig()), voice_(defaultTtsVoice()), sink_(nullptr),
+      start_us_(0), job_(0), cancelled_job_(0), cache_(nullptr), normalizer_(0) {
+    on_audio_ = [this](const int16_t* samples, size_t count) {
+        return writeAudio(samples, count);
+    };
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+SpeechSynthesizer::SpeechSynthesizer(SynthesizerBackend* backend, const SynthesizerConfig& config)
+    : backend_(backend ? backend : &piper_), config_(config), voice_(defaultTtsVoice()), sink_(nullptr),
+      start_us_(0), job_(0), cancelled_job_(0), cache_(nullptr), normalizer_(0) {
+    on_audio_ = [this](const int16_t* samples, size_t count) {
+        return writeAudio(samples, count);
+    };
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+bool SpeechSynthesizer::initialize(const char* model_source) {
+    uint64_t start = audioMicros();
+    if (model_source != nullptr) {
+        if (!model_.open(model_source)) {
+            return false;
+        }
+    } else {
+        model_.close();
+    }
+    bool ok = backend_->initialize(model_.isOpen() ? &model_ : nullptr);
+    stats_.init_us = audioMicros() - start;
+    return ok;
+}
+
+void SpeechSynthesizer::setPromptCache(PromptCache* cache) {
+    cache_ = cache;
+    key_text_.resize(cache != nullptr ? SYNTH_PROMPT_TEXT_BYTES : 0);
+}
+
+bool SpeechSynthesizer::promptKeyOf(const char* text, uint64_t* key) {
+    const uint32_t truncated = normalizer_.stats().truncated;
+    size_t length = normalizer_.normalize(text, strlen(text), key_text_.data(), key_text_.size());
+    if (length == 0 || normalizer_.stats().truncated != truncated) {
+        return false;
+    }
+    *key = promptKey(key_text_.data(), length, voice_, backend_->sampleRate());
+    return true;
+}
+
+bool SpeechSynthesizer::writeAudio(const int16_t* samples, size_t count) {
+    if (isCancelled()) {
+        return false;
+    }
+    if (count == 0) {
+        return true;
+    }
+    uint64_t start = audioMicros();
+    if (stats_.samples == 0) {
+        stats_.first_audio_us = start - start_us_;
+        if (stats_.first_audio_us > stats_.max_first_audio_us) {
+            stats_.max_first_audio_us = stats_.first_audio_us;
+        }
+    }
+    bool ok = sink_->write(samples, count);
+    if (ok && cache_ != nullptr && cache_->isRecording()) {
+        cache_->append(samples, count);
+    }
+    stats_.samples += count;
+    stats_.sink_us += audioMicros() - start;
+    return ok;
+}
+
+bool SpeechSynthesizer::synthesize(const char* text, AudioSink& sink) {
+    // A new job: cancels aimed at earlier ones no longer match
+    job_.fetch_add(1);
+    start_us_ = audioMicros();
+    stats_.utterances++;
+    stats_.chunks = 0;
+    stats_.samples = 0;
+    stats_.first_audio_us = 0;
+    stats_.sink_us = 0;
+    stats_.from_cache = false;
+    if (text == nullptr || !sink.begin(backend_->sampleRate())) {
+        return false;
+    }
+    sink_ = &sink;
+
+    bool ok = true;
+    uint64_t key;
+    if (cache_ != nullptr && cache_->isInitialized() && promptKeyOf(text, &key)) {
+        PromptPlayback playback = cache_->play(key, on_audio_);
+        if (playback != PromptPlayback::MISS) {
+            stats_.from_cache = true;
+            stats_.cache_hits++;
+            ok = playback == PromptPlayback::PLAYED;
+        } else {
+            cache_->beginInsert(key);
+        }
+    }
+
+    TextChunker chunker(text, strlen(text), config_);
+    const char* chunk;
+    size_t length;
+    while (ok && !stats_.from_cache && !isCancelled() && chunker.next(&chunk, &length)) {
+        stats_.chunks++;
+        ok = backend_->synthesize(chunk, length, voice_, on_audio_);
+    }
+    if (cache_ != nullptr && cache_->isRecording()) {
+        if (ok && !isCancelled()) {
+            cache_->commitInsert();
+        } else {
+            cache_->abortInsert();
+        }
+    }
+    if (isCancelled()) {
+        stats_.cancelled++;
+        ok = false;
+    }
+    sink.end();
+    sink_ = nullptr;
+
+    uint64_t elapsed = audioMicros() - start_us_;
+    stats_.synth_us = elapsed - stats_.sink_us;
+    uint64_t audio_us = stats_.samples * 1000000ull / (uint64_t)backend_->sampleRate();
+    stats_.rtf = audio_us > 0 ? (float)stats_.synth_us / (float)audio_us : 0.0f;
+    return ok;
+}
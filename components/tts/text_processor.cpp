@@ -0,0 +1,718 @@
+#include "text_processor.h"
+#include <cstring>
+
+namespace {
+
+const char* const ONES[20] = {
+    "zero", "one", "two", "three", "four", "five", "six", "seven", "eight", "nine",
+    "ten", "eleven", "twelve", "thirteen", "fourteen", "fifteen", "sixteen", "seventeen", "eighteen", "nineteen"
+};
+const char* const TENS[10] = {
+    "", "", "twenty", "thirty", "forty", "fifty", "sixty", "seventy", "eighty", "ninety"
+};
+const char* const MONTHS[12] = {
+    "january", "february", "march", "april", "may", "june",
+    "july", "august", "september", "october", "november", "december"
+};
+const char* const LETTER_NAMES[26] = {
+    "ay", "bee", "see", "dee", "ee", "eff", "gee", "aitch", "eye", "jay", "kay", "el", "em",
+    "en", "oh", "pee", "cue", "ar", "ess", "tee", "you", "vee", "double you", "ex", "why", "zee"
+};
+
+struct Abbreviation {
+    const char* text;               // Lowercase, read when followed by '.'
+    const char* spoken;
+};
+
+const Abbreviation ABBREVIATIONS[] = {
+    {"mr", "mister"}, {"mrs", "missus"}, {"ms", "miz"}, {"dr", "doctor"}, {"prof", "professor"},
+    {"jr", "junior"}, {"sr", "senior"}, {"vs", "versus"}, {"etc", "et cetera"}, {"approx", "approximately"},
+};
+
+struct Unit {
+    const char* symbol;             // Case-sensitive, UTF-8
+    const char* singular;
+    const char* plural;
+};
+
+const Unit UNITS[] = {
+    {"%", "percent", "percent"},
+    {"\xc2\xb0" "C", "degree celsius", "degrees celsius"},
+    {"\xc2\xb0" "F", "degree fahrenheit", "degrees fahrenheit"},
+    {"\xc2\xb0", "degree", "degrees"},
+    {"km/h", "kilometer per hour", "kilometers per hour"},
+    {"mph", "mile per hour", "miles per hour"},
+    {"km", "kilometer", "kilometers"},
+    {"m", "meter", "meters"},
+    {"cm", "centimeter", "centimeters"},
+    {"mm", "millimeter", "millimeters"},
+    {"ft", "foot", "feet"},
+    {"kg", "kilogram", "kilograms"},
+    {"g", "gram", "grams"},
+    {"mg", "milligram", "milligrams"},
+    {"lb", "pound", "pounds"},
+    {"lbs", "pound", "pounds"},
+    {"oz", "ounce", "ounces"},
+    {"l", "liter", "liters"},
+    {"L", "liter", "liters"},
+    {"ml", "milliliter", "milliliters"},
+    {"mL", "milliliter", "milliliters"},
+    {"ms", "millisecond", "milliseconds"},
+    {"s", "second", "seconds"},
+    {"sec", "second", "seconds"},
+    {"min", "minute", "minutes"},
+    {"h", "hour", "hours"},
+    {"hr", "hour", "hours"},
+    {"Hz", "hertz", "hertz"},
+    {"kHz", "kilohertz", "kilohertz"},
+    {"MHz", "megahertz", "megahertz"},
+    {"GHz", "gigahertz", "gigahertz"},
+    {"W", "watt", "watts"},
+    {"kW", "kilowatt", "kilowatts"},
+    {"kWh", "kilowatt hour", "kilowatt hours"},
+    {"V", "volt", "volts"},
+    {"mA", "milliamp", "milliamps"},
+    {"mAh", "milliamp hour", "milliamp hours"},
+    {"KB", "kilobyte", "kilobytes"},
+    {"kB", "kilobyte", "kilobytes"},
+    {"MB", "megabyte", "megabytes"},
+    {"GB", "gigabyte", "gigabytes"},
+    {"TB", "terabyte", "terabytes"},
+    {"dB", "decibel", "decibels"},
+};
+
+struct Currency {
+    const char* symbol;             // UTF-8 prefix
+    const char* singular;
+    const char* plural;
+    const char* cent;
+    const char* cents;
+};
+
+const Currency CURRENCIES[] = {
+    {"$", "dollar", "dollars", "cent", "cents"},
+    {"\xe2\x82\xac", "euro", "euros", "cent", "cents"},
+    {"\xc2\xa3", "pound", "pounds", "penny", "pence"},
+};
+
+// Whole numbers beyond this are read digit by digit
+const uint64_t MAX_CARDINAL = 999999999999ull;
+const size_t MAX_WORD_BYTES = 32;
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+bool isUpper(char c) {
+    return c >= 'A' && c <= 'Z';
+}
+
+bool isAlpha(char c) {
+    return (c >= 'a' && c <= 'z') || isUpper(c);
+}
+
+char toLower(char c) {
+    return isUpper(c) ? (char)(c - 'A' + 'a') : c;
+}
+
+bool isPunct(char c) {
+    return c == ',' || c == ';' || c == ':' || c == '.' || c == '!' || c == '?';
+}
+
+// Normalized text under construction in a caller buffer. Words are
+// separated by one space; once something does not fit, everything after
+// it is dropped so the output always ends on a whole word.
+struct TextWriter {
+    char* out;
+    size_t capacity;
+    size_t length;
+    size_t last_word;               // Start of the last word
+    bool full;
+
+    void word(const char* w, size_t n) {
+        if (full || n == 0) {
+            return;
+        }
+        size_t space = length > 0 ? 1 : 0;
+        if (length + space + n + 1 > capacity) {
+            full = true;
+            return;
+        }
+        if (space) {
+            out[length++] = ' ';
+        }
+        last_word = length;
+        memcpy(out + length, w, n);
+        length += n;
+        out[length] = 0;
+    }
+
+    void word(const char* w) { word(w, strlen(w)); }
+
+    void punct(char c) {
+        if (full || length == 0 || isPunct(out[length - 1])) {
+            return;
+        }
+        if (length + 2 > capacity) {
+            full = true;
+            return;
+        }
+        out[length++] = c;
+        out[length] = 0;
+    }
+
+    // Replace the last word, e.g. with its ordinal
+    void replaceLast(const char* w) {
+        if (full || length == 0) {
+            return;
+        }
+        length = last_word > 0 ? last_word - 1 : 0;
+        out[length] = 0;
+        word(w);
+    }
+};
+
+// Reads digits at pos; count is the number of digits, 0 if none
+uint64_t readDigits(const char* text, size_t length, size_t pos, size_t* count) {
+    uint64_t value = 0;
+    size_t n = 0;
+    while (pos + n < length && isDigit(text[pos + n])) {
+        if (n < 19) {
+            value = value * 10 + (uint64_t)(text[pos + n] - '0');
+        }
+        n++;
+    }
+    *count = n;
+    return value;
+}
+
+bool startsWith(const char* text, size_t length, size_t pos, const char* prefix) {
+    size_t n = strlen(prefix);
+    return pos + n <= length && memcmp(text + pos, prefix, n) == 0;
+}
+
+bool startsWithNoCase(const char* text, size_t length, size_t pos, const char* prefix) {
+    size_t n = strlen(prefix);
+    if (pos + n > length) {
+        return false;
+    }
+    for (size_t i = 0; i < n; i++) {
+        if (toLower(text[pos + i]) != prefix[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// No letter or digit at pos
+bool endsToken(const char* text, size_t length, size_t pos) {
+    return pos >= length || !(isAlpha(text[pos]) || isDigit(text[pos]));
+}
+
+void under1000(TextWriter& w, uint32_t n) {
+    if (n >= 100) {
+        w.word(ONES[n / 100]);
+        w.word("hundred");
+        n %= 100;
+    }
+    if (n >= 20) {
+        w.word(TENS[n / 10]);
+        if (n % 10) {
+            w.word(ONES[n % 10]);
+        }
+    } else if (n > 0) {
+        w.word(ONES[n]);
+    }
+}
+
+void cardinal(TextWriter& w, uint64_t n) {
+    static const struct {
+        uint64_t value;
+        const char* name;
+    } SCALES[] = {{1000000000ull, "billion"}, {1000000ull, "million"}, {1000ull, "thousand"}};
+    if (n == 0) {
+        w.word(ONES[0]);
+        return;
+    }
+    for (const auto& scale : SCALES) {
+        if (n >= scale.value) {
+            under1000(w, (uint32_t)(n / scale.value));
+            w.word(scale.name);
+            n %= scale.value;
+        }
+    }
+    under1000(w, (uint32_t)n);
+}
+
+void digitByDigit(TextWriter& w, const char* digits, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (isDigit(digits[i])) {                   // Group commas are skipped
+            w.word(ONES[digits[i] - '0']);
+        }
+    }
+}
+
+// Turn the last number word into its ordinal: five -> fifth
+void ordinalize(TextWriter& w) {
+    static const char* const IRREGULAR[][2] = {
+        {"one", "first"}, {"two", "second"}, {"three", "third"}, {"five", "fifth"},
+        {"eight", "eighth"}, {"nine", "ninth"}, {"twelve", "twelfth"},
+    };
+    if (w.full || w.length == 0) {
+        return;
+    }
+    const char* last = w.out + w.last_word;
+    size_t n = w.length - w.last_word;
+    for (const auto& pair : IRREGULAR) {
+        if (strlen(pair[0]) == n && memcmp(last, pair[0], n) == 0) {
+            w.replaceLast(pair[1]);
+            return;
+        }
+    }
+    char buffer[MAX_WORD_BYTES];
+    if (n + 3 >= sizeof(buffer)) {
+        return;
+    }
+    memcpy(buffer, last, n);
+    if (buffer[n - 1] == 'y') {
+        memcpy(buffer + n - 1, "ieth", 5);          // twenty -> twentieth
+    } else {
+        memcpy(buffer + n, "th", 3);
+    }
+    w.replaceLast(buffer);
+}
+
+void year(TextWriter& w, uint32_t y) {
+    if (y < 1000 || y > 2999 || (y >= 2000 && y < 2010) || y % 1000 == 0) {
+        cardinal(w, y);                             // two thousand five
+        return;
+    }
+    under1000(w, y / 100);
+    if (y % 100 == 0) {
+        w.word("hundred");                          // nineteen hundred
+    } else if (y % 100 < 10) {
+        w.word("oh");                               // nineteen oh five
+        w.word(ONES[y % 10]);
+    } else {
+        under1000(w, y % 100);                      // nineteen eighty four
+    }
+}
+
+void date(TextWriter& w, uint32_t month, uint32_t day) {
+    w.word(MONTHS[month - 1]);
+    cardinal(w, day);
+    ordinalize(w);
+}
+
+// Month name or abbreviation of the word, 0 if it is none
+uint32_t monthOf(const char* word, size_t n) {
+    for (uint32_t m = 0; m < 12; m++) {
+        size_t full = strlen(MONTHS[m]);
+        if ((n == full || n == 3 || (m == 8 && n == 4)) && n <= full && memcmp(word, MONTHS[m], n) == 0) {
+            return m + 1;
+        }
+    }
+    return 0;
+}
+
+// Ordinal suffix at pos (1st, 2nd, 23rd, 5th), 0 if there is none
+size_t ordinalSuffix(const char* text, size_t length, size_t pos) {
+    static const char* const SUFFIXES[] = {"st", "nd", "rd", "th"};
+    for (const char* suffix : SUFFIXES) {
+        if (startsWithNoCase(text, length, pos, suffix) && endsToken(text, length, pos + 2)) {
+            return 2;
+        }
+    }
+    return 0;
+}
+
+// Longest unit symbol at pos that ends a token
+const Unit* unitAt(const char* text, size_t length, size_t pos, size_t* bytes) {
+    const Unit* best = nullptr;
+    size_t best_bytes = 0;
+    for (const Unit& unit : UNITS) {
+        size_t n = strlen(unit.symbol);
+        if (n > best_bytes && startsWith(text, length, pos, unit.symbol) &&
+            (!isAlpha(unit.symbol[n - 1]) || endsToken(text, length, pos + n))) {
+            best = &unit;
+            best_bytes = n;
+        }
+    }
+    *bytes = best_bytes;
+    return best;
+}
+
+// "am", "pm", "a.m.", "p.m." at pos; returns bytes and the letter
+size_t meridiemAt(const char* text, size_t length, size_t pos, char* letter) {
+    if (pos >= length || (toLower(text[pos]) != 'a' && toLower(text[pos]) != 'p')) {
+        return 0;
+    }
+    *letter = toLower(text[pos]);
+    if (startsWithNoCase(text, length, pos + 1, "m") && endsToken(text, length, pos + 2)) {
+        return 2;
+    }
+    if (startsWithNoCase(text, length, pos + 1, ".m.")) {
+        return 4;
+    }
+    return 0;
+}
+
+size_t skipSpaces(const char* text, size_t length, size_t pos, size_t max) {
+    size_t n = 0;
+    while (n < max && pos + n < length && text[pos + n] == ' ') {
+        n++;
+    }
+    return pos + n;
+}
+
+// Dates and times made only of digits; returns the end, or pos if none
+size_t numericDateOrTime(TextWriter& w, const char* text, size_t length, size_t pos) {
+    size_t a_n, b_n, c_n;
+    uint64_t a = readDigits(text, length, pos, &a_n);
+    size_t p = pos + a_n;
+
+    // 2024-03-05
+    if (a_n == 4 && p < length && text[p] == '-') {
+        uint64_t b = readDigits(text, length, p + 1, &b_n);
+        size_t q = p + 1 + b_n;
+        if (b_n == 2 && q < length && text[q] == '-') {
+            uint64_t c = readDigits(text, length, q + 1, &c_n);
+            if (c_n == 2 && b >= 1 && b <= 12 && c >= 1 && c <= 31 && endsToken(text, length, q + 1 + c_n)) {
+                date(w, (uint32_t)b, (uint32_t)c);
+                year(w, (uint32_t)a);
+                return q + 1 + c_n;
+            }
+        }
+    }
+
+    // 3/5/2024, month first
+    if (a_n <= 2 && p < length && text[p] == '/') {
+        uint64_t b = readDigits(text, length, p + 1, &b_n);
+        size_t q = p + 1 + b_n;
+        if (b_n >= 1 && b_n <= 2 && q < length && text[q] == '/') {
+            uint64_t c = readDigits(text, length, q + 1, &c_n);
+            if ((c_n == 2 || c_n == 4) && a >= 1 && a <= 12 && b >= 1 && b <= 31 &&
+                endsToken(text, length, q + 1 + c_n)) {
+                date(w, (uint32_t)a, (uint32_t)b);
+                year(w, (uint32_t)(c_n == 2 ? 2000 + c : c));
+                return q + 1 + c_n;
+            }
+        }
+    }
+
+    // 7:05, 19:30, 9:00 pm
+    if (a_n <= 2 && a <= 23 && p < length && text[p] == ':') {
+        uint64_t b = readDigits(text, length, p + 1, &b_n);
+        size_t q = p + 1 + b_n;
+        if (b_n == 2 && b <= 59 && (q >= length || (text[q] != ':' && endsToken(text, length, q)))) {
+            char letter = 0;
+            size_t r = skipSpaces(text, length, q, 1);
+            size_t meridiem = meridiemAt(text, length, r, &letter);
+            cardinal(w, a);
+            if (b == 0 && meridiem == 0) {
+                w.word("o'clock");
+            } else if (b > 0 && b < 10) {
+                w.word("oh");
+                w.word(ONES[b]);
+            } else if (b > 0) {
+                cardinal(w, b);
+            }
+            if (meridiem > 0) {
+                w.word(LETTER_NAMES[letter - 'a']);
+                w.word(LETTER_NAMES['m' - 'a']);
+                return r + meridiem;
+            }
+            return q;
+        }
+    }
+    return pos;
+}
+
+// A number with its sign, grouping, decimals and what follows it
+size_t number(TextWriter& w, const char* text, size_t length, size_t pos, const Currency* currency) {
+    bool negative = text[pos] == '-';
+    size_t start = negative ? pos + 1 : pos;
+
+    if (!negative && currency == nullptr) {
+        size_t end = numericDateOrTime(w, text, length, start);
+        if (end != start) {
+            return end;
+        }
+    }
+
+    size_t n;
+    uint64_t whole = readDigits(text, length, start, &n);
+    size_t p = start + n;
+    size_t whole_digits = n;
+    // 1,250,000: commas followed by exactly three digits
+    if (n <= 3 && text[start] != '0') {
+        while (p + 3 < length && text[p] == ',' && isDigit(text[p + 1])) {
+            size_t group_n;
+            uint64_t group = readDigits(text, length, p + 1, &group_n);
+            if (group_n != 3) {
+                break;
+            }
+            whole = whole * 1000 + group;
+            whole_digits += 3;
+            p += 4;
+        }
+    }
+    size_t whole_end = p;
+    size_t decimals = 0;
+    size_t decimal_start = 0;
+    if (p + 1 < length && text[p] == '.' && isDigit(text[p + 1])) {
+        decimal_start = p + 1;
+        readDigits(text, length, decimal_start, &decimals);
+        p = decimal_start + decimals;
+    }
+
+    if (negative) {
+        w.word("minus");
+    }
+
+    // $3.50 is dollars and cents
+    if (currency != nullptr && decimals == 2) {
+        size_t cents_n;
+        uint64_t cents = readDigits(text, length, decimal_start, &cents_n);
+        if (whole > 0 || cents == 0) {
+            cardinal(w, whole);
+            w.word(whole == 1 ? currency->singular : currency->plural);
+        }
+        if (cents > 0) {
+            if (whole > 0) {
+                w.word("and");
+            }
+            cardinal(w, cents);
+            w.word(cents == 1 ? currency->cent : currency->cents);
+        }
+        return p;
+    }
+
+    bool spell = whole_digits > 12 || whole > MAX_CARDINAL || (whole_digits > 1 && text[start] == '0');
+    bool one = whole == 1 && decimals == 0 && !spell;
+    size_t suffix = 0;
+    size_t unit_bytes = 0;
+    size_t u = p;
+    const Unit* unit = nullptr;
+    if (currency == nullptr) {
+        suffix = decimals == 0 && !spell ? ordinalSuffix(text, length, p) : 0;
+        if (suffix == 0) {
+            u = skipSpaces(text, length, p, 1);
+            unit = unitAt(text, length, u, &unit_bytes);
+        }
+    }
+    // A bare four-digit number reads as a year: 1984, 2024
+    bool as_year = currency == nullptr && !negative && suffix == 0 && unit == nullptr && decimals == 0 &&
+                   whole_digits == 4 && n == 4 && whole >= 1100 && whole <= 2099;
+
+    if (as_year) {
+        year(w, (uint32_t)whole);
+    } else if (spell) {
+        digitByDigit(w, text + start, whole_end - start);
+    } else {
+        cardinal(w, whole);
+    }
+    if (decimals > 0) {
+        w.word("point");
+        digitByDigit(w, text + decimal_start, decimals);
+    }
+
+    if (currency != nullptr) {
+        w.word(one ? currency->singular : currency->plural);
+        return p;
+    }
+    if (suffix > 0) {
+        ordinalize(w);
+        return p + suffix;
+    }
+    if (unit != nullptr) {
+        w.word(one ? unit->singular : unit->plural);
+        return u + unit_bytes;
+    }
+    return p;
+}
+
+// A run of letters; months with a day, abbreviations and acronyms
+size_t word(TextWriter& w, const char* text, size_t length, size_t pos) {
+    char lower[MAX_WORD_BYTES];
+    size_t n = 0;
+    size_t upper = 0;
+    size_t vowels = 0;
+    size_t p = pos;
+    // Longer runs stop at the buffer and the rest is read as the next
+    // word, so no letters are lost
+    while (p < length && n < sizeof(lower) &&
+           (isAlpha(text[p]) || (text[p] == '\'' && p + 1 < length && isAlpha(text[p + 1])))) {
+        char c = toLower(text[p]);
+        lower[n++] = c;
+        upper += isUpper(text[p]) ? 1 : 0;
+        vowels += (n > 1 && (c == 'a' || c == 'e' || c == 'i' || c == 'o' || c == 'u')) ? 1 : 0;
+        p++;
+    }
+
+    // Dr. -> doctor
+    if (p < length && text[p] == '.') {
+        for (const Abbreviation& abbreviation : ABBREVIATIONS) {
+            if (strlen(abbreviation.text) == n && memcmp(lower, abbreviation.text, n) == 0) {
+                w.word(abbreviation.spoken);
+                return p + 1;
+            }
+        }
+    }
+
+    // March 5th, 2024 -> march fifth, twenty twenty four
+    uint32_t month = monthOf(lower, n);
+    if (month > 0) {
+        size_t q = p < length && text[p] == '.' && n < strlen(MONTHS[month - 1]) ? p + 1 : p;
+        q = skipSpaces(text, length, q, 2);
+        size_t day_n;
+        uint64_t day = readDigits(text, length, q, &day_n);
+        if (q > p && day_n >= 1 && day_n <= 2 && day >= 1 && day <= 31) {
+            size_t r = q + day_n;
+            r += ordinalSuffix(text, length, r);
+            if (endsToken(text, length, r) && (r >= length || text[r] != ':')) {
+                date(w, month, (uint32_t)day);
+                size_t comma = r < length && text[r] == ',' ? r + 1 : r;
+                size_t y = skipSpaces(text, length, comma, 2);
+                size_t year_n;
+                uint64_t value = readDigits(text, length, y, &year_n);
+                if (y > r && year_n == 4 && endsToken(text, length, y + year_n)) {
+                    if (comma > r) {
+                        w.punct(',');
+                    }
+                    year(w, (uint32_t)value);
+                    return y + year_n;
+                }
+                return r;
+            }
+        }
+    }
+
+    // USB -> you ess bee: short all-caps words with no vowel after the
+    // first letter are spelled
+    if (n >= 2 && n <= 4 && upper == n && vowels == 0) {
+        for (size_t i = 0; i < n; i++) {
+            w.word(LETTER_NAMES[lower[i] - 'a']);
+        }
+        return p;
+    }
+
+    w.word(lower, n);
+    return p;
+}
+
+const Currency* currencyAt(const char* text, size_t length, size_t pos, size_t* bytes) {
+    for (const Currency& currency : CURRENCIES) {
+        size_t n = strlen(currency.symbol);
+        if (startsWith(text, length, pos, currency.symbol) && pos + n < length && isDigit(text[pos + n])) {
+            *bytes = n;
+            return &currency;
+        }
+    }
+    return nullptr;
+}
+
+} // namespace
+
+TextProcessor::TextProcessor(size_t max_text_bytes) : scratch_(max_text_bytes > 0 ? max_text_bytes : 1) {
+    memset(&stats_, 0, sizeof(stats_));
+}
+
+size_t TextProcessor::normalize(const char* text, size_t length, char* out, size_t capacity) {
+    if (capacity == 0) {
+        return 0;
+    }
+    TextWriter w = {out, capacity, 0, 0, false};
+    out[0] = 0;
+    stats_.texts++;
+
+    size_t i = 0;
+    while (i < length && !w.full) {
+        char c = text[i];
+        bool after_token = i > 0 && (isAlpha(text[i - 1]) || isDigit(text[i - 1]));
+        size_t currency_bytes;
+        const Currency* currency = currencyAt(text, length, i, &currency_bytes);
+
+        if (isDigit(c) || (c == '-' && !after_token && i + 1 < length && isDigit(text[i + 1]))) {
+            i = number(w, text, length, i, nullptr);
+        } else if (currency != nullptr) {
+            i = number(w, text, length, i + currency_bytes, currency);
+        } else if (c == '-' && i > 0 && isDigit(text[i - 1]) && i + 1 < length && isDigit(text[i + 1])) {
+            w.word("to");                           // 5-10
+            i++;
+        } else if (isAlpha(c)) {
+            i = word(w, text, length, i);
+        } else if (isPunct(c)) {
+            w.punct(c);
+            i++;
+        } else {
+            switch (c) {
+                case '&': w.word("and"); break;
+                case '+': w.word("plus"); break;
+                case '@': w.word("at"); break;
+                case '=': w.word("equals"); break;
+                case '%': w.word("percent"); break;
+                default: break;                     // Separators, symbols and other scripts
+            }
+            i++;
+        }
+    }
+    if (w.full) {
+        stats_.truncated++;
+    }
+    return w.length;
+}
+
+size_t TextProcessor::phonemize(const char* normalized, size_t length, uint8_t* ids, size_t capacity) {
+    size_t count = 0;
+    size_t i = 0;
+    uint8_t pending = 0;                // Boundary owed before the next word
+    uint8_t lts[MAX_WORD_BYTES * 2];
+    while (i < length) {
+        char c = normalized[i];
+        if (!((c >= 'a' && c <= 'z') || c == '\'')) {
+            if (c == '.' || c == '!' || c == '?') {
+                pending = PHONEME_STOP;
+            } else if ((c == ',' || c == ';' || c == ':') && pending != PHONEME_STOP) {
+                pending = PHONEME_PAUSE;
+            }
+            i++;
+            continue;
+        }
+        size_t start = i;
+        while (i < length && ((normalized[i] >= 'a' && normalized[i] <= 'z') || normalized[i] == '\'')) {
+            i++;
+        }
+
+        const uint8_t* phonemes;
+        size_t n;
+        if (lexicon_.lookup(normalized + start, i - start, &phonemes, &n)) {
+            stats_.lexicon_hits++;
+        } else {
+            n = letterToSound(normalized + start, i - start, lts, sizeof(lts));
+            phonemes = lts;
+            stats_.lts_words++;
+        }
+        stats_.words++;
+        if (count + n + (count > 0 ? 1 : 0) > capacity) {
+            stats_.truncated++;
+            pending = 0;
+            break;
+        }
+        if (count > 0) {
+            ids[count++] = pending != 0 ? pending : PHONEME_WORD_BREAK;
+        }
+        memcpy(ids + count, phonemes, n);
+        count += n;
+        pending = 0;
+    }
+    if (pending != 0 && count > 0 && count < capacity) {
+        ids[count++] = pending;
+    }
+    return count;
+}
+
+size_t TextProcessor::process(const char* text, size_t length, uint8_t* ids, size_t capacity) {
+    size_t n = normalize(text, length, scratch_.data(), scratch_.size());
+    return phonemize(scratch_.data(), n, ids, capacity);
+}
@@ -0,0 +1,326 @@
+#ifndef AUDIO_ASYNC_H
+#define AUDIO_ASYNC_H
+
+// Coroutine layer for capture, processing and sinks. Needs a C++20
+// toolchain (arduino-esp32 3.x / IDF 5, or the native host build).
+#if defined(__cpp_impl_coroutine)
+
+#include <atomic>
+#include <condition_variable>
+#include <coroutine>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include "audio_frame_pool.h"
+
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
+
+namespace audio_processing {
+
+class Executor;
+
+/**
+ * @class Task
+ * @brief Top-level coroutine run by an Executor
+ *
+ * Tasks start suspended and are handed to Executor::spawn(), which owns
+ * them and destroys the frame once the coroutine finishes.
+ */
+class Task {
+public:
+    struct promise_type {
+        Task get_return_object() { return Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+        std::suspend_always final_suspend() noexcept { return {}; }
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Task(Task&& other) noexcept : _handle(other._handle) { other._handle = nullptr; }
+    Task(const Task&) = delete;
+    Task& operator=(const Task&) = delete;
+    ~Task() { if (_handle) _handle.destroy(); }
+
+    std::coroutine_handle<> release() { auto h = _handle; _handle = nullptr; return h; }
+
+private:
+    explicit Task(std::coroutine_handle<promise_type> handle) : _handle(handle) {}
+    std::coroutine_handle<promise_type> _handle;
+};
+
+/**
+ * @class Executor
+ * @brief Single-threaded coroutine executor, one per core
+ *
+ * run() resumes ready coroutines and otherwise blocks on a task
+ * notification (condition variable on host), so suspended operations
+ * cost no CPU. post() may be called from any task.
+ *
+ * Awaitables woken from another task reserve their ready slot before
+ * suspending, so the wake-up itself can never be refused by a full queue
+ * and drop the coroutine.
+ */
+class Executor {
+public:
+    static const int MAX_READY = 32;
+    static const int MAX_TIMERS = 8;
+
+    Executor();
+    ~Executor();
+
+    /**
+     * Take ownership of a task and schedule its first step
+     *
+     * @return true if scheduled, false if the ready queue is full
+     */
+    bool spawn(Task task);
+
+    /**
+     * Schedule a suspended coroutine to be resumed by this executor
+     *
+     * @return true if scheduled, false if the ready queue is full
+     */
+    bool post(std::coroutine_handle<> handle);
+
+    /**
+     * Hold a ready slot for a coroutine that is about to suspend
+     *
+     * A successful reserve() must be paired with exactly one
+     * postReserved(). Slots held this way are not available to post()
+     * or spawn().
+     *
+     * @return true if a slot was reserved, false if the ready queue is full
+     */
+    bool reserve();
+
+    /**
+     * Schedule a coroutine into a slot taken by reserve(); cannot fail
+     */
+    void postReserved(std::coroutine_handle<> handle);
+
+    /**
+     * Run until stop() is called, blocking when there is nothing to do
+     */
+    void run();
+
+    /**
+     * Resume everything that is ready and due without blocking
+     *
+     * @return Number of coroutines resumed
+     */
+    int runOnce();
+
+    /**
+     * Ask run() to return (callable from any task)
+     */
+    void stop();
+
+    /**
+     * Awaitable that resumes the caller after a delay
+     */
+    struct SleepAwaiter {
+        Executor* executor;
+        uint32_t ms;
+        bool await_ready() const { return ms == 0; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const {}
+    };
+    SleepAwaiter sleepFor(uint32_t ms) { return SleepAwaiter{this, ms}; }
+
+    size_t liveTasks() const { return _live_tasks.load(); }
+    uint32_t wakeups() const { return _wakeups.load(); }
+
+    /**
+     * Executor running on the calling task, nullptr outside run()/runOnce()
+     */
+    static Executor* current();
+
+private:
+    struct Timer {
+        std::coroutine_handle<> handle;
+        uint64_t deadline_us;
+    };
+
+    bool addTimer(std::coroutine_handle<> handle, uint64_t deadline_us);
+    void resume(std::coroutine_handle<> handle);
+    void enqueueLocked(std::coroutine_handle<> handle);
+    void notify();
+    uint64_t fireTimers();
+    void waitForWork(uint64_t next_deadline_us);
+
+    std::coroutine_handle<> _ready[MAX_READY];
+    size_t _ready_head;
+    size_t _ready_count;
+    size_t _reserved;               // Slots held by suspended awaitables
+    Timer _timers[MAX_TIMERS];
+    size_t _timer_count;
+    std::atomic<size_t> _live_tasks;
+    std::atomic<uint32_t> _wakeups;
+    std::atomic<bool> _stop;
+    std::mutex _mutex;
+#ifdef ESP_PLATFORM
+    void* _task;
+#else
+    std::condition_variable _wake;
+    bool _notified;
+#endif
+};
+
+/**
+ * @class FrameChannel
+ * @brief Frames from a producer task, awaited with co_await nextFrame()
+ *
+ * The producer (capture task or a simulated source) calls push(); a
+ * coroutine suspended in nextFrame() is resumed on its own executor.
+ * When the queue is full the oldest frame is dropped.
+ *
+ * A channel has a single consumer: only one coroutine may be suspended in
+ * nextFrame() at a time. A second concurrent nextFrame() returns an empty
+ * frame immediately, as if the channel had closed.
+ */
+class FrameChannel {
+public:
+    static const int MAX_QUEUED = 8;
+
+    FrameChannel();
+    ~FrameChannel();
+
+    /**
+     * Queue a frame and wake the waiting coroutine, if any
+     */
+    void push(FrameRef frame);
+
+    /**
+     * End of stream: pending and future nextFrame() return an empty frame
+     */
+    void close();
+
+    struct NextAwaiter {
+        FrameChannel* channel;
+        FrameRef frame;
+        bool await_ready();
+        bool await_suspend(std::coroutine_handle<> handle);
+        FrameRef await_resume() { return std::move(frame); }
+    };
+    NextAwaiter nextFrame() { return NextAwaiter{this, FrameRef()}; }
+
+    uint32_t dropped() const { return _dropped; }
+
+private:
+    bool popLocked(FrameRef& frame);
+
+    FrameRef _queue[MAX_QUEUED];
+    size_t _head;
+    size_t _count;
+    bool _closed;
+    uint32_t _dropped;
+    NextAwaiter* _waiter;
+    std::coroutine_handle<> _waiter_handle;
+    Executor* _waiter_executor;
+    std::mutex _mutex;
+};
+
+/**
+ * @class AsyncSink
+ * @brief Runs blocking writes (BT, SD) on a worker task and completes
+ *        co_await write(frame) back on the caller's executor
+ */
+class AsyncSink {
+public:
+    using WriteFunction = std::function<bool(const FrameRef& frame)>;
+    static const int MAX_JOBS = 8;
+
+    AsyncSink();
+    ~AsyncSink();
+
+    /**
+     * Start the worker task
+     *
+     * @param name Worker task name
+     * @param write Blocking write function run on the worker
+     * @param core Core for the worker task (ignored on host)
+     * @param priority Worker priority (ignored on host)
+     * @return true if the worker started, false otherwise
+     */
+    bool begin(const char* name, WriteFunction write, int core = 0, int priority = 2);
+    void end();
+
+    struct WriteAwaiter {
+        AsyncSink* sink;
+        FrameRef frame;
+        bool result;
+        bool await_ready() const { return false; }
+        bool await_suspend(std::coroutine_handle<> handle);
+        bool await_resume() const { return result; }
+    };
+
+    /**
+     * co_await sink.write(frame) -> true if the frame was written
+     */
+    WriteAwaiter write(const FrameRef& frame) { return WriteAwaiter{this, frame, false}; }
+
+private:
+    struct Job {
+        WriteAwaiter* awaiter;
+        std::coroutine_handle<> handle;
+        Executor* executor;
+    };
+
+    static void workerEntry(void* arg);
+    void workerLoop();
+
+    WriteFunction _write;
+    Job _jobs[MAX_JOBS];
+    size_t _head;
+    size_t _count;
+    std::atomic<bool> _running;
+    std::atomic<bool> _finished;
+    std::mutex _mutex;
+    std::condition_variable _job_ready;
+#ifndef ESP_PLATFORM
+    std::thread _worker;
+#endif
+};
+
+/**
+ * @class AsyncEvent
+ * @brief Manual-reset event, e.g. Bluetooth connected, awaited with co_await wait()
+ */
+class AsyncEvent {
+public:
+    static const int MAX_WAITERS = 4;
+
+    AsyncEvent();
+
+    void set();
+    void reset();
+    bool isSet() const { return _set.load(); }
+
+    struct WaitAwaiter {
+        AsyncEvent* event;
+        bool await_ready() const { return event->isSet(); }
+        bool await_suspend(std::coroutine_handle<> handle);
+        void await_resume() const {}
+    };
+    WaitAwaiter wait() { return WaitAwaiter{this}; }
+
+private:
+    struct Waiter {
+        std::coroutine_handle<> handle;
+        Executor* executor;
+    };
+
+    std::atomic<bool> _set;
+    Waiter _waiters[MAX_WAITERS];
+    size_t _waiter_count;
+    std::mutex _mutex;
+};
+
+} // namespace audio_processing
+
+#endif // __cpp_impl_coroutine
+
+#endif // AUDIO_ASYNC_H
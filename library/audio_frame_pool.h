@@ -0,0 +1,239 @@
+#ifndef AUDIO_FRAME_POOL_H
+#define AUDIO_FRAME_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "audio_platform.h"
+
+namespace audio_processing {
+
+class FramePool;
+
+// AudioFrame::flags
+#define FRAME_FLAG_SILENCE  (1u << 0)   // Silence marker: no samples, audio resumes with the next frame
+
+/**
+ * @struct AudioFrame
+ * @brief One preallocated block of PCM samples owned by a FramePool
+ */
+struct AudioFrame {
+    int16_t* samples;              // Sample storage (never reallocated)
+    size_t capacity;               // Capacity in samples
+    size_t length;                 // Valid samples
+    uint32_t sequence;             // Sequence number assigned on publish
+    uint64_t timestamp_us;         // Capture time
+    uint32_t flags;                // FRAME_FLAG_* bits
+    std::atomic<uint32_t> refs;    // Outstanding references
+    FramePool* pool;               // Owning pool
+};
+
+/**
+ * @class FrameRef
+ * @brief Reference-counted handle to an AudioFrame
+ *
+ * Copying a FrameRef adds a reference, destroying it drops one. The frame
+ * goes back to its pool when the last reference is dropped.
+ */
+class FrameRef {
+public:
+    FrameRef() : _frame(nullptr) {}
+    explicit FrameRef(AudioFrame* frame) : _frame(frame) {}
+    FrameRef(const FrameRef& other);
+    FrameRef(FrameRef&& other) noexcept : _frame(other._frame) { other._frame = nullptr; }
+    FrameRef& operator=(const FrameRef& other);
+    FrameRef& operator=(FrameRef&& other) noexcept;
+    ~FrameRef() { reset(); }
+
+    /**
+     * Drop this reference (the frame is recycled if it was the last one)
+     */
+    void reset();
+
+    /**
+     * Give up ownership without dropping the reference
+     *
+     * @return The raw frame; caller becomes responsible for one reference
+     */
+    AudioFrame* detach() { AudioFrame* frame = _frame; _frame = nullptr; return frame; }
+
+    AudioFrame* get() const { return _frame; }
+    AudioFrame* operator->() const { return _frame; }
+    explicit operator bool() const { return _frame != nullptr; }
+
+    int16_t* data() const { return _frame ? _frame->samples : nullptr; }
+    size_t size() const { return _frame ? _frame->length : 0; }
+
+private:
+    AudioFrame* _frame;
+};
+
+/**
+ * @class FramePool
+ * @brief Fixed-size pool of audio frames allocated once at init
+ *
+ * Frame headers live in internal RAM, sample storage in the requested
+ * region (PSRAM by default). acquire() never allocates.
+ */
+class FramePool {
+public:
+    FramePool();
+    ~FramePool();
+
+    /**
+     * Preallocate the pool
+     *
+     * @param frame_count Number of frames
+     * @param frame_samples Capacity of each frame in samples
+     * @param region Memory region for sample storage
+     * @return true if all memory was allocated, false otherwise
+     */
+    bool init(size_t frame_count, size_t frame_samples, MemoryRegion region = MemoryRegion::PSRAM);
+
+    /**
+     * Free all memory. All frames must have been released.
+     */
+    void deinit();
+
+    /**
+     * Take a free frame with one reference
+     *
+     * @return Frame handle, empty if the pool is exhausted
+     */
+    FrameRef acquire();
+
+    size_t available() const;
+    size_t capacity() const { return _frame_count; }
+    size_t frameSamples() const { return _frame_samples; }
+    uint32_t exhaustedCount() const { return _exhausted.load(); }
+
+private:
+    friend class FrameRef;
+
+    void retain(AudioFrame* frame);
+    void release(AudioFrame* frame);
+
+    AudioFrame* _frames;          // Frame headers (internal RAM)
+    int16_t* _storage;            // Sample storage for all frames
+    AudioFrame** _free_list;      // Stack of free frames
+    size_t _free_count;
+    size_t _frame_count;
+    size_t _frame_samples;
+    std::atomic<uint32_t> _exhausted;
+    mutable std::mutex _mutex;
+};
+
+/**
+ * @brief What publish() does when a consumer queue is full
+ */
+enum class BackpressurePolicy {
+    DROP_OLDEST,   // Evict the oldest queued frame for that consumer
+    DROP_NEWEST,   // Skip the frame being published for that consumer
+    BLOCK          // Wait for space up to the consumer's block timeout
+};
+
+/**
+ * @struct ConsumerStats
+ * @brief Per-consumer delivery and lag metrics
+ */
+struct ConsumerStats {
+    uint32_t delivered;       // Frames queued to the consumer
+    uint32_t consumed;        // Frames taken by the consumer
+    uint32_t dropped;         // Frames lost to backpressure
+    uint32_t depth;           // Frames currently queued
+    uint32_t max_depth;       // High-water mark of queued frames
+    uint32_t lag_frames;      // Published frames not yet consumed
+    uint32_t max_lag_frames;  // High-water mark of lag
+    uint64_t last_latency_us; // Acquire-to-receive time of last frame, from timestamp_us
+    uint64_t max_latency_us;  // Worst acquire-to-receive time
+};
+
+/**
+ * @class FrameFanout
+ * @brief Publishes frames by reference to several consumers
+ *
+ * Each consumer (VAD, SD recorder, BT streamer, STT, ...) owns a bounded
+ * queue of frame references. Publishing adds one reference per consumer,
+ * so the samples are never copied.
+ */
+class FrameFanout {
+public:
+    static const int MAX_CONSUMERS = 8;
+
+    FrameFanout();
+    ~FrameFanout();
+
+    /**
+     * Register a consumer
+     *
+     * @param name Consumer name for diagnostics
+     * @param queue_depth Maximum frames queued for this consumer
+     * @param policy Backpressure policy when the queue is full
+     * @param block_timeout_ms Maximum wait for BLOCK policy
+     * @return Consumer id, or -1 on failure
+     */
+    int addConsumer(const char* name, size_t queue_depth,
+                    BackpressurePolicy policy, uint32_t block_timeout_ms = 100);
+
+    /**
+     * Publish a frame to every consumer
+     *
+     * @param frame Frame to publish (stamped with the next sequence number)
+     * @return Number of consumers that accepted the frame
+     */
+    size_t publish(const FrameRef& frame);
+
+    /**
+     * Take the next frame for a consumer
+     *
+     * @param consumer Consumer id
+     * @param frame Receives the frame reference
+     * @param timeout_ms Maximum wait, 0 to poll
+     * @return true if a frame was received, false otherwise
+     */
+    bool receive(int consumer, FrameRef& frame, uint32_t timeout_ms = 0);
+
+    /**
+     * Get metrics for a consumer
+     *
+     * @return true if the consumer id is valid, false otherwise
+     */
+    bool getStats(int consumer, ConsumerStats* stats) const;
+
+    const char* consumerName(int consumer) const;
+    int consumerCount() const { return _consumer_count; }
+
+    /**
+     * Release every queued frame and remove all consumers
+     */
+    void clear();
+
+private:
+    struct Consumer {
+        const char* name;
+        AudioFrame** queue;
+        size_t queue_depth;
+        size_t head;
+        size_t count;
+        BackpressurePolicy policy;
+        uint32_t block_timeout_ms;
+        uint32_t last_sequence;
+        ConsumerStats stats;
+        std::condition_variable data_ready;
+        std::condition_variable space_ready;
+    };
+
+    void pushLocked(Consumer& consumer, AudioFrame* frame);
+    AudioFrame* popLocked(Consumer& consumer);
+
+    Consumer _consumers[MAX_CONSUMERS];
+    int _consumer_count;
+    uint32_t _next_sequence;
+    mutable std::mutex _mutex;
+};
+
+} // namespace audio_processing
+
+#endif // AUDIO_FRAME_POOL_H
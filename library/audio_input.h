@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include "i2s_config.h"
 #include "pdm_processing.h"
+#include "audio_frame_pool.h"
 
 namespace audio_processing {
 
@@ -20,6 +21,7 @@ private:
     bool _is_recording;        // Recording state flag
     int _sample_rate;          // Audio sample rate
     int _decimation_factor;    // PDM decimation factor
+    bool _filter_enabled;      // Run the post filter inside readAudioData
 
 public:
     /**
@@ -66,6 +68,37 @@ public:
      */
     bool readAudioData(int16_t* output_buffer, size_t output_size, size_t* samples_read);
     
+    /**
+     * Read audio data straight into a frame taken from a pool
+     * 
+     * The frame is filled once and can then be published to several
+     * consumers by reference instead of copying the samples.
+     * 
+     * @param pool Pool to take the frame from
+     * @param frame Receives the filled frame (empty on failure)
+     * @return true if a frame was filled, false if the pool is exhausted or the read failed
+     */
+    bool readAudioFrame(FramePool& pool, FrameRef& frame);
+    
+    /**
+     * Enable or disable the post filter pass in readAudioData
+     * 
+     * Disable it when a VADGate sits after capture and run filterAudio()
+     * as a stage behind the gate, so silent frames skip the filter.
+     * 
+     * @param enabled true to filter inside readAudioData (default)
+     */
+    inline void setFilterEnabled(bool enabled) { _filter_enabled = enabled; }
+    
+    /**
+     * Apply the post filter to already converted PCM samples
+     * 
+     * @param samples Samples to filter in place
+     * @param count Number of samples
+     * @return true if the filter was applied, false otherwise
+     */
+    bool filterAudio(int16_t* samples, size_t count);
+    
     /**
      * Get current audio level in decibels
      * 
@@ -0,0 +1,143 @@
+#ifndef AUDIO_OUTPUT_H
+#define AUDIO_OUTPUT_H
+
+#include <Arduino.h>
+#include <atomic>
+#include "output_feeder.h"
+
+namespace audio_processing {
+
+/**
+ * @class AudioOutput
+ * @brief Plays audio to an external I2S DAC or amplifier
+ *
+ * Mirrors AudioInput on the transmit side: I2S TX in standard (Philips)
+ * mode, 16-bit mono, on its own port so capture keeps running. Producers
+ * write into ring() (a RingSink for the synthesizer) and a high-priority
+ * task moves one DMA buffer at a time from the ring to the driver through
+ * an OutputFeeder. i2s_write() blocks until a DMA buffer is free, so the
+ * task is paced by the I2S clock, and an empty ring becomes silence
+ * rather than a stalled or repeating DMA queue.
+ */
+class AudioOutput {
+private:
+    OutputFeeder _feeder;           // Ring and underrun policy
+    LatencyProfile _latency;        // Selected profile
+    int _sample_rate;               // Current I2S rate
+    int16_t* _block;                // One DMA buffer, feeder task only
+    bool _initialized;              // Driver installed
+    std::atomic<bool> _running;     // Feeder task should keep going
+    std::atomic<bool> _finished;    // Feeder task has exited
+    std::atomic<bool> _pause;       // Feeder task should park between writes
+    std::atomic<bool> _parked;      // Feeder task is parked, out of i2s_write()
+
+    static void feederEntry(void* arg);
+    void feederLoop();
+
+public:
+    /**
+     * Constructor
+     */
+    AudioOutput();
+
+    /**
+     * Destructor - stops the feeder task and uninstalls the driver
+     */
+    ~AudioOutput();
+
+    /**
+     * Install the I2S TX driver and allocate the ring
+     *
+     * @param sample_rate Output sample rate (default: 16000)
+     * @param latency Buffer sizes (default: BALANCED)
+     * @return true if initialization was successful, false otherwise
+     */
+    bool init(int sample_rate = 16000, LatencyProfile latency = LatencyProfile::BALANCED);
+
+    /**
+     * Start the feeder task; the DAC plays silence until audio arrives
+     *
+     * @param core Core for the feeder task
+     * @param priority Feeder priority, above the producers
+     * @return true if the task started, false otherwise
+     */
+    bool start(int core = 1, int priority = configMAX_PRIORITIES - 2);
+
+    /**
+     * Stop the feeder task and silence the DAC
+     *
+     * @return true once the task has exited
+     */
+    bool stop();
+
+    /**
+     * Change the I2S clock, e.g. to a synthesizer's rate
+     *
+     * Buffered audio is dropped. Safe while the feeder task runs: the task
+     * is parked between two writes while the clock changes.
+     *
+     * @param sample_rate New output sample rate
+     * @return true if the clock was set, false otherwise
+     */
+    bool setSampleRate(int sample_rate);
+
+    /**
+     * Ring the producer writes into
+     */
+    inline PcmRing& ring() { return _feeder.ring(); }
+
+    /**
+     * Copy everything played into a ring for an echo canceller
+     *
+     * Set before start(); the ring is written by the feeder task. Blocks
+     * played at another rate, e.g. after setSampleRate(22050) for Piper,
+     * are converted to capture_rate first.
+     *
+     * @param reference Far-end reference ring, or nullptr for none
+     * @param capture_rate Rate the echo canceller reads the ring at
+     */
+    inline void setEchoReference(PcmRing* reference, int capture_rate = 16000) {
+        _feeder.setReference(reference, capture_rate);
+    }
+
+    /**
+     * Mark the end of the current stream (producer side)
+     */
+    inline void endStream() { _feeder.endStream(); }
+
+    /**
+     * Drop buffered audio, e.g. when the user barges in
+     */
+    inline void flush() { _feeder.flush(); }
+
+    /**
+     * Worst-case delay from the ring to the DAC for the selected profile
+     *
+     * @return Latency in microseconds
+     */
+    inline uint32_t latencyUs() const { return outputLatencyUs(_feeder.profile(), _sample_rate); }
+
+    /**
+     * Underrun and playback counters, updated by the feeder task
+     */
+    inline const OutputStats& getStats() const { return _feeder.stats(); }
+
+    inline LatencyProfile latencyProfile() const { return _latency; }
+    inline int sampleRate() const { return _sample_rate; }
+
+    /**
+     * Check if the feeder task is running
+     *
+     * @return true if running, false otherwise
+     */
+    inline bool isRunning() const { return _running.load(); }
+
+    /**
+     * Stop playback and free resources
+     */
+    void deinit();
+};
+
+} // namespace audio_processing
+
+#endif // AUDIO_OUTPUT_H
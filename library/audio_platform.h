@@ -0,0 +1,93 @@
+#ifndef AUDIO_PLATFORM_H
+#define AUDIO_PLATFORM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#include "esp_timer.h"
+#else
+#include <chrono>
+#include <cstdio>
+#endif
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#define AUDIO_LOGF(...) Serial.printf(__VA_ARGS__)
+#else
+#define AUDIO_LOGF(...) printf(__VA_ARGS__)
+#endif
+
+namespace audio_processing {
+
+/**
+ * @brief Memory region used for preallocated audio buffers
+ *
+ * PSRAM is large but slower; INTERNAL is small but DMA capable and fast.
+ * On the host build both map to the regular heap.
+ */
+enum class MemoryRegion {
+    INTERNAL,
+    PSRAM
+};
+
+/**
+ * Allocate a 16-byte aligned block in the requested region
+ *
+ * Falls back to internal RAM when PSRAM is not available.
+ *
+ * @param bytes Number of bytes to allocate
+ * @param region Preferred memory region
+ * @return Pointer to the block, or nullptr on failure
+ */
+inline void* audioAlloc(size_t bytes, MemoryRegion region) {
+    if (bytes == 0) {
+        return nullptr;
+    }
+#ifdef ESP_PLATFORM
+    void* ptr = nullptr;
+    if (region == MemoryRegion::PSRAM) {
+        ptr = heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    }
+    if (ptr == nullptr) {
+        ptr = heap_caps_aligned_alloc(16, bytes, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    }
+    return ptr;
+#else
+    (void)region;
+    size_t rounded = (bytes + 15) & ~static_cast<size_t>(15);
+    return std::aligned_alloc(16, rounded);
+#endif
+}
+
+/**
+ * Free a block returned by audioAlloc
+ */
+inline void audioFree(void* ptr) {
+    if (ptr == nullptr) {
+        return;
+    }
+#ifdef ESP_PLATFORM
+    heap_caps_free(ptr);
+#else
+    std::free(ptr);
+#endif
+}
+
+/**
+ * Monotonic time in microseconds
+ */
+inline uint64_t audioMicros() {
+#ifdef ESP_PLATFORM
+    return static_cast<uint64_t>(esp_timer_get_time());
+#else
+    using namespace std::chrono;
+    return duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+} // namespace audio_processing
+
+#endif // AUDIO_PLATFORM_H
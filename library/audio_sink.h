@@ -0,0 +1,88 @@
+#ifndef AUDIO_SINK_H
+#define AUDIO_SINK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include "pcm_ring.h"
+
+// Destination for synthesized audio. begin() opens a stream at a sample
+// rate, write() takes samples as they are produced, end() closes it.
+// write() returning false means the sink cannot take more; the producer
+// stops.
+class AudioSink {
+public:
+    virtual ~AudioSink() {}
+
+    virtual bool begin(int sample_rate) = 0;
+    virtual bool write(const int16_t* samples, size_t count) = 0;
+    virtual void end() = 0;
+};
+
+struct RingSinkStats {
+    uint64_t samples;
+    uint32_t waits;             // Writes that found the ring full
+    uint64_t wait_us;           // Time spent waiting for the consumer
+    uint32_t timeouts;
+};
+
+/**
+ * @class RingSink
+ * @brief Feeds a PcmRing drained by a playback task
+ *
+ * The synthesizer runs ahead of playback in bursts; when the ring is full
+ * write() sleeps a tick at a time until the consumer makes room, and gives
+ * up after timeout_ms without progress (playback stopped). The ring is
+ * not cleared at begin() or end(): the consumer owns the read side and
+ * plays out whatever is left.
+ */
+class RingSink : public AudioSink {
+public:
+    explicit RingSink(audio_processing::PcmRing& ring, uint32_t timeout_ms = 1000);
+
+    bool begin(int sample_rate) override;
+    bool write(const int16_t* samples, size_t count) override;
+    void end() override {}
+
+    int sampleRate() const { return sample_rate_; }
+    const RingSinkStats& stats() const { return stats_; }
+
+private:
+    audio_processing::PcmRing& ring_;
+    uint32_t timeout_ms_;
+    int sample_rate_;
+    RingSinkStats stats_;
+};
+
+/**
+ * @class WavFileSink
+ * @brief Writes a 16-bit mono WAV file through stdio
+ *
+ * On the host this is the playback stand-in; on target it records to the
+ * SD card through the VFS. The header is written with zero sizes at
+ * begin() and patched at end(), so nothing is buffered beyond stdio.
+ */
+class WavFileSink : public AudioSink {
+public:
+    explicit WavFileSink(const char* path);
+    ~WavFileSink();
+
+    WavFileSink(const WavFileSink&) = delete;
+    WavFileSink& operator=(const WavFileSink&) = delete;
+
+    bool begin(int sample_rate) override;
+    bool write(const int16_t* samples, size_t count) override;
+    void end() override;
+
+    uint64_t samples() const { return samples_; }
+
+private:
+    bool writeHeader(uint32_t data_bytes);
+
+    const char* path_;
+    FILE* file_;
+    int sample_rate_;
+    uint64_t samples_;
+};
+
+#endif // AUDIO_SINK_H
@@ -0,0 +1,75 @@
+#ifndef BAND_ENERGY_H
+#define BAND_ENERGY_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief Spectral features of one frame
+ */
+struct BandFeatures {
+    float low_speech;     // Power in 300-1000 Hz
+    float high_speech;    // Power in 1-3 kHz
+    float out_of_band;    // Power outside 300-3000 Hz
+    float band_ratio;     // (low_speech + high_speech) / out_of_band
+    float flatness;       // Spectral flatness inside the speech bands, 0 (peaky) .. 1 (white)
+};
+
+/**
+ * @class BandEnergyAnalyzer
+ * @brief Goertzel filter bank over the speech bands
+ *
+ * Frames are cut into Hann-windowed blocks of BLOCK_SIZE samples and only
+ * the bins between 300 Hz and 3 kHz are evaluated with Goertzel filters.
+ * Out-of-band power is the windowed block energy minus the speech bins
+ * (Parseval), so the cost is one multiply-add per speech bin per sample
+ * and nothing for the rest of the spectrum. All state is fixed-size; no
+ * allocation after construction.
+ */
+class BandEnergyAnalyzer {
+public:
+    static const int BLOCK_SIZE = 128;
+    static const int MAX_BINS = BLOCK_SIZE / 2;
+
+    static constexpr float SPEECH_LOW_HZ = 300.0f;
+    static constexpr float SPEECH_SPLIT_HZ = 1000.0f;
+    static constexpr float SPEECH_HIGH_HZ = 3000.0f;
+
+    explicit BandEnergyAnalyzer(int sample_rate = 16000);
+
+    /**
+     * Recompute the filter bank for a sample rate
+     */
+    void configure(int sample_rate);
+
+    /**
+     * Analyze one frame
+     *
+     * @param samples Input samples
+     * @param count Number of samples, at least BLOCK_SIZE; a trailing partial
+     *              block is covered by one block aligned to the frame end
+     * @return Band features, all zero if the frame is too short
+     */
+    BandFeatures analyze(const int16_t* samples, size_t count);
+
+    int sampleRate() const { return sample_rate_; }
+    int binCount() const { return bin_count_; }
+    float binFrequency(int index) const;
+
+    // Per-bin power of the last analyzed frame, binCount() entries
+    const float* binPower() const { return power_; }
+
+private:
+    void analyzeBlock(const int16_t* block, float* total);
+
+    int sample_rate_;
+    int first_bin_;
+    int bin_count_;
+    int split_index_;
+    float window_[BLOCK_SIZE];
+    float coeff_[MAX_BINS];
+    float power_[MAX_BINS];
+    float block_[BLOCK_SIZE];
+};
+
+#endif // BAND_ENERGY_H
@@ -7,6 +7,8 @@
 #include <vector>
 #include <string>
 
+class FeatureStreamEncoder;
+
 class BluetoothManager {
 public:
     // Callback types
@@ -33,6 +35,11 @@ public:
     bool startAudioStream(int sampleRate = 16000, int bitsPerSample = 16);
     bool stopAudioStream();
     bool sendAudioData(const int16_t* audioData, size_t samples);
+
+    // Feature offload: quantized log-mel packets instead of PCM (about a
+    // quarter of the bandwidth); recognition runs on the paired host
+    bool startFeatureStream(FeatureStreamEncoder& encoder);
+    bool stopFeatureStream();
     
     // Utility functions
     void update(); // Call this in the main loop
@@ -42,6 +49,7 @@ private:
     String _deviceName;
     bool _initialized;
     bool _streaming;
+    FeatureStreamEncoder* _featureEncoder;
     
     // Callbacks
     DataReceivedCallback _dataCallback;
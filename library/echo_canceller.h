@@ -0,0 +1,219 @@
+#ifndef ECHO_CANCELLER_H
+#define ECHO_CANCELLER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "audio_frame_pool.h"
+#include "audio_platform.h"
+#include "dsps_fft.h"
+#include "pcm_ring.h"
+#include "pipeline_runtime.h"
+
+namespace audio_processing {
+
+/**
+ * @struct EchoCancellerConfig
+ * @brief Filter, delay search and double-talk parameters for an EchoCanceller
+ */
+struct EchoCancellerConfig {
+    int sample_rate;               // Sample rate in Hz
+    size_t block_samples;          // Filter block N, a power of two; FFT size is 2N
+    size_t partitions;             // Filter partitions P; the tail covers P * N samples
+    size_t max_delay_blocks;       // Bulk delay search range in blocks
+    size_t lead_blocks;            // Tail kept ahead of the estimated bulk delay
+    bool estimate_delay;           // Track the bulk delay, else use fixed_delay_blocks
+    size_t fixed_delay_blocks;     // Bulk delay when estimate_delay is false
+    float step_size;               // Normalized adaptation step, 0..1
+    float far_power_floor;         // Far-end mean square below which nothing adapts
+    float double_talk_ratio;       // Error/near energy rise over the converged floor that means double talk
+    uint32_t double_talk_hangover; // Blocks adaptation stays frozen after double talk
+    size_t reference_backlog;      // Reference samples kept beyond one frame; a longer backlog would
+                                   // make the far end lag its own echo, so older samples are dropped
+};
+
+/**
+ * Default canceller: 8 ms blocks, 128 ms tail, 512 ms delay search
+ *
+ * @param sample_rate Sample rate in Hz
+ * @return Canceller configuration
+ */
+EchoCancellerConfig defaultEchoCancellerConfig(int sample_rate = 16000);
+
+/**
+ * @struct EchoStats
+ * @brief Canceller counters and convergence metrics
+ */
+struct EchoStats {
+    uint64_t blocks;               // Blocks processed
+    uint64_t adapted_blocks;       // Blocks the filter was updated on
+    uint64_t double_talk_blocks;   // Blocks flagged as double talk
+    uint32_t delay_changes;        // Bulk delay moves (each restarts the filter)
+    uint32_t resets;               // Filter restarts after divergence
+    uint64_t reference_missing;    // Far-end samples padded with zeros
+    uint64_t reference_dropped;    // Far-end backlog samples discarded
+    int delay_blocks;              // Current bulk delay estimate
+    float erle_db;                 // Smoothed echo return loss enhancement while the far end is active
+    uint64_t process_us;           // Time spent in process()
+};
+
+/**
+ * @class EchoCanceller
+ * @brief Acoustic echo canceller for barge-in while prompts play
+ *
+ * Subtracts the speaker signal from the microphone with a partitioned-block
+ * frequency-domain adaptive filter (PBFDAF / MDF). The echo path tail of
+ * P * N samples is split into P partitions of N samples, each filtered in
+ * the frequency domain with overlap-save, so a 128 ms tail costs three
+ * FFTs of 2N points and P complex multiply-adds per bin per block instead
+ * of a 2048-tap time-domain NLMS. Each bin is normalized by the smoothed
+ * far-end power, and the gradient constraint (zeroing the circular half
+ * of one partition) is applied to one partition per block in turn.
+ *
+ * The far end reaches the microphone after the output DMA queue, the air
+ * and the capture DMA, usually more than the tail. A bulk delay estimator
+ * compares per-block binary spectra (one bit per band: above or below its
+ * running mean) of the far end and the microphone at every candidate
+ * delay; the delay with the lowest smoothed Hamming distance positions the
+ * filter, lead_blocks early so the estimate may be off by a block.
+ *
+ * Double talk is detected from the error to microphone energy ratio: once
+ * the filter has converged that ratio sits near a slowly rising floor, and
+ * near-end speech lifts it well above. Adaptation then freezes for a
+ * hangover so the near-end talker does not train the filter away. A
+ * sustained rise (a changed echo path) outlasts the floor's rise and
+ * adaptation resumes.
+ *
+ * All buffers are allocated in init(); process() does no allocation. The
+ * stage form reads the far end from a PcmRing filled by
+ * OutputFeeder::setReference() and rewrites the microphone frame in place,
+ * so it belongs right after capture, before frames fan out.
+ */
+class EchoCanceller {
+public:
+    EchoCanceller();
+    ~EchoCanceller();
+
+    EchoCanceller(const EchoCanceller&) = delete;
+    EchoCanceller& operator=(const EchoCanceller&) = delete;
+
+    /**
+     * Allocate the filter and delay buffers
+     *
+     * @param config Canceller configuration
+     * @param region Memory region for the buffers
+     * @return true if initialization was successful, false otherwise
+     */
+    bool init(const EchoCancellerConfig& config = defaultEchoCancellerConfig(),
+              MemoryRegion region = MemoryRegion::INTERNAL);
+
+    /**
+     * Free all buffers
+     */
+    void deinit();
+
+    bool isInitialized() const { return _weights != nullptr; }
+
+    /**
+     * Cancel echo from a block of microphone samples
+     *
+     * @param near Microphone samples
+     * @param far Far-end samples played over the same interval
+     * @param out Echo-cancelled output; may be the same buffer as near
+     * @param count Number of samples, a multiple of block_samples
+     * @return true if processed, false if not initialized or count is not
+     *         a multiple of block_samples
+     */
+    bool process(const int16_t* near, const int16_t* far, int16_t* out, size_t count);
+
+    /**
+     * Set the ring the stage form reads the far end from
+     *
+     * @param reference Ring filled by the output task at config.sample_rate
+     *        (OutputFeeder::setReference() with the capture rate), or
+     *        nullptr for none
+     */
+    void setReference(PcmRing* reference) { _reference = reference; }
+
+    /**
+     * Cancel echo from one capture frame in place, reading the far end from
+     * the reference ring
+     *
+     * Silence markers pass through. A missing far end is treated as silence.
+     *
+     * @param frame Microphone frame
+     * @return true to forward the frame
+     */
+    bool process(FrameRef& frame);
+
+    /**
+     * Stage function for PipelineRuntime::addStage
+     */
+    PipelineRuntime::StageFunction stageFunction();
+
+    /**
+     * Clear the filter, delay estimate and counters
+     */
+    void reset();
+
+    /**
+     * Counters, updated by the thread calling process()
+     */
+    const EchoStats& stats() const { return _stats; }
+
+    const EchoCancellerConfig& config() const { return _config; }
+    int delayBlocks() const { return _delay_blocks; }
+    bool isDoubleTalk() const { return _double_talk_hold > 0; }
+
+private:
+    void processBlock(const int16_t* near, const int16_t* far, int16_t* out);
+    void estimateDelay(const int16_t* near, const int16_t* far);
+    uint32_t binarySpectrum(const int16_t* samples, float* band_mean);
+    void setFilterDelay(int delay_blocks);
+    void clearFilter();
+
+    EchoCancellerConfig _config;
+    size_t _bins;                  // N + 1 bins of the 2N FFT
+
+    // Adaptive filter
+    float* _twiddle;
+    uint16_t* _bitrev;
+    fft_plan_f32_t _plan;
+    float* _weights;               // P packed spectra
+    float* _far_spectra;           // Last P far-end block spectra, ring
+    float* _far_power;             // Smoothed far-end power per bin
+    float* _far_prev;              // Previous delayed far-end block
+    float* _fft;                   // Scratch, 2N
+    float* _echo;                  // Scratch, 2N
+    size_t _spectrum_head;         // Newest entry of _far_spectra
+    size_t _constrain_next;        // Partition to constrain next
+    uint32_t _far_active;          // Blocks left in which the tail still holds far-end energy
+
+    // Far-end delay line and bulk delay estimation
+    int16_t* _delay_line;          // (max_delay_blocks + 1) blocks of raw far end
+    size_t _delay_head;            // Block slot written next
+    uint32_t* _far_bits;           // Binary spectra, same slots as _delay_line
+    float* _delay_cost;            // Smoothed Hamming distance per candidate delay
+    float _far_band_mean[32];
+    float _near_band_mean[32];
+    uint16_t _band_start[33];      // First bin of each band
+    int _delay_blocks;             // Estimated bulk delay
+    int _filter_delay;             // Delay the filter input is taken at
+    int _candidate;
+    uint32_t _candidate_blocks;
+    uint32_t _far_seen;            // Blocks left in which the search window holds far-end energy
+
+    // Double talk and convergence tracking
+    float _ratio_floor;
+    uint32_t _double_talk_hold;
+    uint32_t _diverged_blocks;     // Consecutive blocks with the error above the microphone
+    float _near_energy;            // Smoothed, for ERLE
+    float _error_energy;
+
+    PcmRing* _reference;
+    int16_t* _far_block;           // One block read from _reference
+    EchoStats _stats;
+};
+
+} // namespace audio_processing
+
+#endif // ECHO_CANCELLER_H
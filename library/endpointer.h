@@ -0,0 +1,140 @@
+#ifndef ENDPOINTER_H
+#define ENDPOINTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "audio_frame_pool.h"
+#include "speech_recognizer.h"
+#include "streaming_vad.h"
+
+struct EndpointerConfig {
+    int sample_rate;
+    uint32_t min_speech_ms;          // Shorter bursts (clicks, coughs) are dropped
+    uint32_t trailing_silence_ms;    // Silence that ends an utterance
+    uint32_t max_utterance_ms;       // Longer speech is cut and dispatched
+    float energy_threshold;          // Internal VAD threshold (feed without a decision)
+};
+
+EndpointerConfig defaultEndpointerConfig(int sample_rate = 16000);
+
+enum class EndReason {
+    SILENCE,        // Trailing silence timeout
+    MAX_LENGTH,     // Hit max_utterance_ms
+    FLUSH           // flush() at end of stream
+};
+
+// One utterance as references into the captured frames. Only valid during
+// the dispatch call; copy the FrameRefs to keep the audio longer.
+struct Utterance {
+    const audio_processing::FrameRef* frames;
+    size_t frame_count;
+    uint64_t start_sample;           // Stream position of the first sample
+    uint64_t end_sample;             // Stream position after the last speech sample
+    uint64_t end_of_speech_us;       // Capture time of the last speech frame
+    EndReason reason;
+
+    size_t samples() const { return (size_t)(end_sample - start_sample); }
+
+    // Copy the samples out, returns the number copied
+    size_t copyTo(int16_t* output, size_t max_samples) const;
+};
+
+struct EndpointerStats {
+    uint32_t utterances;             // Spans dispatched
+    uint32_t rejected_short;         // Bursts under min_speech_ms
+    uint32_t forced_max;             // Spans cut at max_utterance_ms
+    uint64_t last_latency_us;        // End of speech to dispatch
+    uint64_t max_latency_us;
+    uint64_t total_latency_us;
+};
+
+/**
+ * @class Endpointer
+ * @brief Cuts a frame stream into utterances and dispatches each one the
+ *        moment its trailing silence has elapsed
+ *
+ * Speech frames are held by reference in a ring sized for
+ * max_utterance_ms at init(), so spans are handed over without copying
+ * and nothing is allocated per frame. Frames after the last speech frame
+ * are trimmed from the span.
+ */
+class Endpointer {
+public:
+    using DispatchFunction = std::function<void(const Utterance& utterance)>;
+
+    explicit Endpointer(const EndpointerConfig& config);
+    ~Endpointer();
+
+    Endpointer(const Endpointer&) = delete;
+    Endpointer& operator=(const Endpointer&) = delete;
+
+    // Allocate the frame ring for frames of frame_samples
+    bool init(size_t frame_samples);
+    void deinit();
+
+    void setDispatch(DispatchFunction dispatch) { dispatch_ = dispatch; }
+
+    // Feed a frame classified by the internal energy VAD
+    void feed(const audio_processing::FrameRef& frame);
+
+    // Feed a frame with an external decision (VADGate, spectral VAD, ...)
+    void feed(const audio_processing::FrameRef& frame, bool speech);
+
+    // End of stream: dispatch a pending utterance if it is long enough
+    void flush();
+
+    // Drop a pending utterance and counters
+    void reset();
+
+    bool inUtterance() const { return count_ > 0; }
+    const EndpointerStats& stats() const { return stats_; }
+    uint64_t averageLatencyUs() const;
+
+private:
+    void endUtterance(EndReason reason);
+    void release();
+
+    EndpointerConfig config_;
+    StreamingVAD vad_;
+    DispatchFunction dispatch_;
+    audio_processing::FrameRef* frames_;
+    size_t capacity_;
+    size_t count_;                   // Frames held (speech and trailing silence)
+    size_t speech_frames_;           // Frames up to and including the last speech frame
+    bool last_raw_;                  // Internal VAD decision carried across short frames
+    uint64_t stream_pos_;            // Samples seen so far
+    uint64_t start_sample_;
+    uint64_t speech_end_sample_;
+    uint64_t speech_end_us_;
+    uint64_t silence_samples_;       // Trailing silence so far
+    uint64_t min_speech_samples_;
+    uint64_t trailing_samples_;
+    uint64_t max_samples_;
+    EndpointerStats stats_;
+};
+
+// Dispatch function that runs each utterance through a SpeechRecognizer
+inline Endpointer::DispatchFunction recognizerDispatch(
+    SpeechRecognizer& recognizer, std::function<void(const std::string& text)> result) {
+    return [&recognizer, result](const Utterance& utterance) {
+        // Stream the frames in place rather than copying the span
+        if (!recognizer.begin()) {
+            return;
+        }
+        size_t remaining = utterance.samples();
+        for (size_t i = 0; i < utterance.frame_count && remaining > 0; i++) {
+            size_t n = utterance.frames[i].size() < remaining ? utterance.frames[i].size() : remaining;
+            recognizer.feed(utterance.frames[i].data(), n);
+            remaining -= n;
+        }
+        std::string text = recognizer.finish();
+        if (result) {
+            result(text);
+        }
+    };
+}
+
+#endif // ENDPOINTER_H
@@ -0,0 +1,126 @@
+#include "dsp_budget.h"
+
+#ifdef ESP_PLATFORM
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "esp_cpu.h"
+#include "esp_idf_version.h"
+#else
+#include <chrono>
+#include <thread>
+#endif
+
+#ifdef CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#define DSP_BUDGET_CPU_MHZ CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ
+#else
+#define DSP_BUDGET_CPU_MHZ 240
+#endif
+
+static uint32_t dsp_default_clock(void) {
+#ifdef ESP_PLATFORM
+    #if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 0, 0)
+    return (uint32_t)esp_cpu_get_cycle_count();
+    #else
+    return esp_cpu_get_ccount();
+    #endif
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+static void dsp_default_yield(void) {
+#ifdef ESP_PLATFORM
+    taskYIELD();
+#else
+    std::this_thread::yield();
+#endif
+}
+
+static void dsp_sleep(uint32_t ticks) {
+#ifdef ESP_PLATFORM
+    vTaskDelay(ticks);
+#else
+    std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+#endif
+}
+
+#ifdef ESP_PLATFORM
+static const uint32_t DSP_DEFAULT_TICKS_PER_US = DSP_BUDGET_CPU_MHZ;
+#else
+static const uint32_t DSP_DEFAULT_TICKS_PER_US = 1;
+#endif
+
+static dsp_clock_fn_t s_clock = dsp_default_clock;
+static dsp_yield_fn_t s_yield = dsp_default_yield;
+static uint32_t s_ticks_per_us = DSP_DEFAULT_TICKS_PER_US;
+
+// One budget per task. slice_ticks is resolved lazily so tasks that never
+// call dsp_budget_set_slice_us() get the default slice.
+static thread_local dsp_budget_t t_budget = {0, 0, 0, 0, 0};
+static thread_local bool t_configured = false;
+
+static inline dsp_budget_t *dsp_budget_get(void) {
+    if (!t_configured) {
+        t_budget.slice_ticks = DSP_BUDGET_DEFAULT_SLICE_US * s_ticks_per_us;
+        t_budget.slice_start = s_clock();
+        t_configured = true;
+    }
+    return &t_budget;
+}
+
+void dsp_budget_set_clock(dsp_clock_fn_t clock, uint32_t ticks_per_us) {
+    s_clock = clock ? clock : dsp_default_clock;
+    s_ticks_per_us = clock ? ticks_per_us : DSP_DEFAULT_TICKS_PER_US;
+    if (s_ticks_per_us == 0) {
+        s_ticks_per_us = 1;
+    }
+    // Existing slices were measured with the old clock
+    t_configured = false;
+}
+
+void dsp_budget_set_yield(dsp_yield_fn_t yield_fn) {
+    s_yield = yield_fn ? yield_fn : dsp_default_yield;
+}
+
+void dsp_budget_set_slice_us(uint32_t slice_us) {
+    dsp_budget_t *budget = dsp_budget_get();
+    budget->slice_ticks = slice_us * s_ticks_per_us;
+    budget->slice_start = s_clock();
+    budget->yields = 0;
+    budget->polls = 0;
+}
+
+void dsp_budget_set_sleep_ticks(uint32_t ticks) {
+    dsp_budget_get()->sleep_ticks = ticks;
+}
+
+dsp_budget_t *dsp_budget_current(void) {
+    return dsp_budget_get();
+}
+
+void dsp_budget_restart(void) {
+    dsp_budget_get()->slice_start = s_clock();
+}
+
+int dsp_budget_poll(void) {
+    dsp_budget_t *budget = dsp_budget_get();
+    budget->polls++;
+    if (budget->slice_ticks == 0) {
+        return 0;
+    }
+
+    uint32_t now = s_clock();
+    if ((uint32_t)(now - budget->slice_start) < budget->slice_ticks) {
+        return 0;
+    }
+
+    if (budget->sleep_ticks != 0) {
+        dsp_sleep(budget->sleep_ticks);
+    } else {
+        s_yield();
+    }
+    budget->yields++;
+    budget->slice_start = s_clock();
+    return 1;
+}
@@ -0,0 +1,102 @@
+#ifndef _DSP_BUDGET_H_
+#define _DSP_BUDGET_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Default slice for tasks that never configured a budget. Long enough that
+// polling overhead is negligible; the default yield does not block, so a
+// short slice costs no throughput.
+#define DSP_BUDGET_DEFAULT_SLICE_US 2000
+
+/**
+ * @brief Clock source returning a free-running tick counter (may wrap)
+ */
+typedef uint32_t (*dsp_clock_fn_t)(void);
+
+/**
+ * @brief Function called when a slice is exhausted
+ */
+typedef void (*dsp_yield_fn_t)(void);
+
+/**
+ * @brief Per-task budget state
+ */
+typedef struct {
+    uint32_t slice_ticks;   // Ticks per slice, 0 = never yield
+    uint32_t slice_start;   // Tick count at the start of the current slice
+    uint32_t yields;        // Number of times the slice was exhausted
+    uint32_t polls;         // Number of budget checks
+    uint32_t sleep_ticks;   // RTOS ticks to block for at the end of a slice, 0 = yield
+} dsp_budget_t;
+
+/**
+ * @brief Replace the clock used by all budgets
+ *
+ * On target the default is the CPU cycle counter, on host a microsecond
+ * clock. Tests install a fake clock to drive slicing deterministically.
+ *
+ * @param clock Clock function, NULL restores the default
+ * @param ticks_per_us Clock ticks per microsecond
+ */
+void dsp_budget_set_clock(dsp_clock_fn_t clock, uint32_t ticks_per_us);
+
+/**
+ * @brief Replace the function used to give up the CPU
+ *
+ * The default is a non-blocking taskYIELD(): other ready tasks of the same
+ * priority get the core, the kernel carries on otherwise.
+ *
+ * @param yield_fn Yield function, NULL restores the default
+ */
+void dsp_budget_set_yield(dsp_yield_fn_t yield_fn);
+
+/**
+ * @brief Set the slice length for the calling task
+ *
+ * Pass 0 on a task that is subscribed to the task watchdog itself (or is
+ * otherwise allowed to hog its core): kernels will then never yield.
+ *
+ * @param slice_us Slice length in microseconds
+ */
+void dsp_budget_set_slice_us(uint32_t slice_us);
+
+/**
+ * @brief Block instead of yielding at the end of each slice, for the calling task
+ *
+ * taskYIELD() never lets lower-priority tasks run, the idle task included,
+ * so a task that keeps a core busy for longer than the task watchdog
+ * period must opt in to sleeping. Each slice then costs up to a whole
+ * tick: pair this with a slice of hundreds of milliseconds.
+ *
+ * @param ticks RTOS ticks to block for, 0 restores the non-blocking yield
+ */
+void dsp_budget_set_sleep_ticks(uint32_t ticks);
+
+/**
+ * @brief Get the budget state of the calling task
+ */
+dsp_budget_t *dsp_budget_current(void);
+
+/**
+ * @brief Start a new slice for the calling task
+ */
+void dsp_budget_restart(void);
+
+/**
+ * @brief Check the calling task's budget, yield if the slice is used up
+ *
+ * Cheap enough to call every few dozen samples from inner loops.
+ *
+ * @return 1 if the task yielded, 0 otherwise
+ */
+int dsp_budget_poll(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DSP_BUDGET_H_
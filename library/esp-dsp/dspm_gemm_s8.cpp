@@ -0,0 +1,344 @@
+#include "dspm_gemm_s8.h"
+#include "dsp_budget.h"
+#include <string.h>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+// Output channels per cache block: 64 channels of packed weights are
+// 64 * k bytes, which stays in L1 (or the S3 data cache) for typical k
+#define DSPM_GEMM_S8_NB 64
+
+#define DSPM_GEMM_S8_PANEL (DSPM_GEMM_S8_NR * DSPM_GEMM_S8_KB)
+
+// The PIE kernel is opt-in (CONFIG_DSP_GEMM_S8_PIE) until it has been
+// checked against dspm_gemm_s8_ref on hardware
+#if CONFIG_DSP_OPTIMIZED && CONFIG_IDF_TARGET_ESP32S3 && CONFIG_DSP_GEMM_S8_PIE
+#define DSPM_GEMM_S8_PIE 1
+#endif
+
+static inline int round_up(int value, int multiple) {
+    return (value + multiple - 1) / multiple * multiple;
+}
+
+static inline int8_t requant_one(int32_t acc, int n, const dspm_requant_s8_t *rq) {
+    if (rq->bias) {
+        acc += rq->bias[n];
+    }
+    int total = 31 + rq->shift[n];
+    int64_t product = (int64_t)acc * rq->multiplier[n];
+    int32_t value = (int32_t)((product + ((int64_t)1 << (total - 1))) >> total) + rq->output_offset;
+    if (value < rq->act_min) {
+        value = rq->act_min;
+    }
+    if (value > rq->act_max) {
+        value = rq->act_max;
+    }
+    return (int8_t)value;
+}
+
+// Scales must be below one (shift >= 0), and 31 + shift must stay a
+// valid shift of the int64 product in requant_one()
+static bool requant_valid(const dspm_requant_s8_t *rq, int n) {
+    if (!rq || !rq->multiplier || !rq->shift || rq->act_min < -128 || rq->act_max > 127 ||
+        rq->act_min > rq->act_max) {
+        return false;
+    }
+    for (int i = 0; i < n; i++) {
+        if (rq->shift[i] < 0 || rq->shift[i] > DSPM_REQUANT_MAX_SHIFT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+size_t dspm_gemm_s8_packed_size(int n, int k) {
+    if (n <= 0 || k <= 0) {
+        return 0;
+    }
+    size_t np = (size_t)round_up(n, DSPM_GEMM_S8_NR);
+    size_t kp = (size_t)round_up(k, DSPM_GEMM_S8_KB);
+    return np * kp + np * sizeof(int32_t);
+}
+
+dsp_ret_t dspm_gemm_s8_pack(const int8_t *w, int n, int k, int8_t *packed) {
+    if (!w || !packed || n <= 0 || k <= 0) {
+        return DSP_RET_FAIL;
+    }
+
+    const int np = round_up(n, DSPM_GEMM_S8_NR);
+    const int kblocks = round_up(k, DSPM_GEMM_S8_KB) / DSPM_GEMM_S8_KB;
+    for (int nb = 0; nb < np / DSPM_GEMM_S8_NR; nb++) {
+        for (int kb = 0; kb < kblocks; kb++) {
+            int8_t *panel = packed + ((size_t)nb * kblocks + kb) * DSPM_GEMM_S8_PANEL;
+            for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+                int row = nb * DSPM_GEMM_S8_NR + r;
+                for (int j = 0; j < DSPM_GEMM_S8_KB; j++) {
+                    int col = kb * DSPM_GEMM_S8_KB + j;
+                    panel[r * DSPM_GEMM_S8_KB + j] = (row < n && col < k) ? w[(size_t)row * k + col] : 0;
+                }
+            }
+        }
+    }
+
+    // Row sums fold the input offset out of the inner loop
+    int32_t *sums = (int32_t *)(packed + (size_t)np * kblocks * DSPM_GEMM_S8_KB);
+    for (int row = 0; row < np; row++) {
+        int32_t sum = 0;
+        for (int col = 0; row < n && col < k; col++) {
+            sum += w[(size_t)row * k + col];
+        }
+        memcpy(&sums[row], &sum, sizeof(sum));
+    }
+
+    return DSP_RET_OK;
+}
+
+// Two rows by four channels over `blocks` panels, accumulating into acc
+static void kernel_2x4_generic(const int8_t *a0, const int8_t *a1, const int8_t *panel, int blocks,
+                               int32_t acc[2][DSPM_GEMM_S8_NR]) {
+    for (int kb = 0; kb < blocks; kb++) {
+        const int8_t *x0 = a0 + kb * DSPM_GEMM_S8_KB;
+        const int8_t *x1 = a1 + kb * DSPM_GEMM_S8_KB;
+        const int8_t *w = panel + kb * DSPM_GEMM_S8_PANEL;
+        for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+            const int8_t *wr = w + r * DSPM_GEMM_S8_KB;
+            int32_t s0 = 0;
+            int32_t s1 = 0;
+            for (int j = 0; j < DSPM_GEMM_S8_KB; j += 4) {
+                s0 += x0[j] * wr[j] + x0[j + 1] * wr[j + 1] + x0[j + 2] * wr[j + 2] + x0[j + 3] * wr[j + 3];
+                s1 += x1[j] * wr[j] + x1[j + 1] * wr[j + 1] + x1[j + 2] * wr[j + 2] + x1[j + 3] * wr[j + 3];
+            }
+            acc[0][r] += s0;
+            acc[1][r] += s1;
+        }
+    }
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+// Four vectors of partial sums to one vector of four totals
+static inline __m128i reduce4(__m128i v0, __m128i v1, __m128i v2, __m128i v3) {
+    __m128i s01 = _mm_add_epi32(_mm_unpacklo_epi32(v0, v1), _mm_unpackhi_epi32(v0, v1));
+    __m128i s23 = _mm_add_epi32(_mm_unpacklo_epi32(v2, v3), _mm_unpackhi_epi32(v2, v3));
+    return _mm_add_epi32(_mm_unpacklo_epi64(s01, s23), _mm_unpackhi_epi64(s01, s23));
+}
+#endif
+
+#if defined(__AVX2__)
+static inline __m128i fold256(__m256i v) {
+    return _mm_add_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1));
+}
+
+static void kernel_2x4(const int8_t *a0, const int8_t *a1, const int8_t *panel, int blocks,
+                       int32_t acc[2][DSPM_GEMM_S8_NR]) {
+    __m256i c0[DSPM_GEMM_S8_NR];
+    __m256i c1[DSPM_GEMM_S8_NR];
+    for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+        c0[r] = _mm256_setzero_si256();
+        c1[r] = _mm256_setzero_si256();
+    }
+    for (int kb = 0; kb < blocks; kb++) {
+        __m256i x0 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(a0 + kb * DSPM_GEMM_S8_KB)));
+        __m256i x1 = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(a1 + kb * DSPM_GEMM_S8_KB)));
+        const int8_t *w = panel + kb * DSPM_GEMM_S8_PANEL;
+        for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+            __m256i wr = _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)(w + r * DSPM_GEMM_S8_KB)));
+            c0[r] = _mm256_add_epi32(c0[r], _mm256_madd_epi16(x0, wr));
+            c1[r] = _mm256_add_epi32(c1[r], _mm256_madd_epi16(x1, wr));
+        }
+    }
+    __m128i t0 = reduce4(fold256(c0[0]), fold256(c0[1]), fold256(c0[2]), fold256(c0[3]));
+    __m128i t1 = reduce4(fold256(c1[0]), fold256(c1[1]), fold256(c1[2]), fold256(c1[3]));
+    __m128i old0 = _mm_loadu_si128((const __m128i *)acc[0]);
+    __m128i old1 = _mm_loadu_si128((const __m128i *)acc[1]);
+    _mm_storeu_si128((__m128i *)acc[0], _mm_add_epi32(old0, t0));
+    _mm_storeu_si128((__m128i *)acc[1], _mm_add_epi32(old1, t1));
+}
+#elif defined(__SSE2__)
+// Sign-extend the low and high 8 bytes to int16
+static inline void widen(__m128i v, __m128i *lo, __m128i *hi) {
+    *lo = _mm_srai_epi16(_mm_unpacklo_epi8(v, v), 8);
+    *hi = _mm_srai_epi16(_mm_unpackhi_epi8(v, v), 8);
+}
+
+static void kernel_2x4(const int8_t *a0, const int8_t *a1, const int8_t *panel, int blocks,
+                       int32_t acc[2][DSPM_GEMM_S8_NR]) {
+    __m128i c0[DSPM_GEMM_S8_NR];
+    __m128i c1[DSPM_GEMM_S8_NR];
+    for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+        c0[r] = _mm_setzero_si128();
+        c1[r] = _mm_setzero_si128();
+    }
+    for (int kb = 0; kb < blocks; kb++) {
+        __m128i x0lo, x0hi, x1lo, x1hi;
+        widen(_mm_loadu_si128((const __m128i *)(a0 + kb * DSPM_GEMM_S8_KB)), &x0lo, &x0hi);
+        widen(_mm_loadu_si128((const __m128i *)(a1 + kb * DSPM_GEMM_S8_KB)), &x1lo, &x1hi);
+        const int8_t *w = panel + kb * DSPM_GEMM_S8_PANEL;
+        for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+            __m128i wlo, whi;
+            widen(_mm_loadu_si128((const __m128i *)(w + r * DSPM_GEMM_S8_KB)), &wlo, &whi);
+            c0[r] = _mm_add_epi32(c0[r], _mm_add_epi32(_mm_madd_epi16(x0lo, wlo), _mm_madd_epi16(x0hi, whi)));
+            c1[r] = _mm_add_epi32(c1[r], _mm_add_epi32(_mm_madd_epi16(x1lo, wlo), _mm_madd_epi16(x1hi, whi)));
+        }
+    }
+    __m128i t0 = reduce4(c0[0], c0[1], c0[2], c0[3]);
+    __m128i t1 = reduce4(c1[0], c1[1], c1[2], c1[3]);
+    __m128i old0 = _mm_loadu_si128((const __m128i *)acc[0]);
+    __m128i old1 = _mm_loadu_si128((const __m128i *)acc[1]);
+    _mm_storeu_si128((__m128i *)acc[0], _mm_add_epi32(old0, t0));
+    _mm_storeu_si128((__m128i *)acc[1], _mm_add_epi32(old1, t1));
+}
+#elif defined(DSPM_GEMM_S8_PIE)
+// One 16-aligned row against one packed channel: `blocks` 16-byte vector
+// MACs into ACCX, weights stepping one panel (64 bytes) at a time
+static inline int32_t dot_s8_pie(const int8_t *x, const int8_t *w, int blocks) {
+    int32_t result;
+    int32_t shift = 0;
+    int32_t stride = DSPM_GEMM_S8_PANEL;
+    __asm__ volatile(
+        "ee.zero.accx\n"
+        "loopnez %[n], 1f\n"
+        "ee.vld.128.ip q0, %[x], 16\n"
+        "ee.vld.128.xp q1, %[w], %[stride]\n"
+        "ee.vmulas.s8.accx q0, q1\n"
+        "1:\n"
+        "ee.srs.accx %[res], %[shift], 0\n"
+        : [res] "=r"(result), [x] "+r"(x), [w] "+r"(w)
+        : [n] "r"(blocks), [stride] "r"(stride), [shift] "r"(shift)
+        : "memory");
+    return result;
+}
+
+static void kernel_2x4(const int8_t *a0, const int8_t *a1, const int8_t *panel, int blocks,
+                       int32_t acc[2][DSPM_GEMM_S8_NR]) {
+    // The vector loads ignore the low address bits, so unaligned rows
+    // take the portable kernel
+    if ((((uintptr_t)a0 | (uintptr_t)a1 | (uintptr_t)panel) & 15) != 0) {
+        kernel_2x4_generic(a0, a1, panel, blocks, acc);
+        return;
+    }
+    for (int r = 0; r < DSPM_GEMM_S8_NR; r++) {
+        const int8_t *w = panel + r * DSPM_GEMM_S8_KB;
+        acc[0][r] += dot_s8_pie(a0, w, blocks);
+        if (a1 != a0) {
+            acc[1][r] += dot_s8_pie(a1, w, blocks);
+        }
+    }
+}
+#else
+#define kernel_2x4 kernel_2x4_generic
+#endif
+
+dsp_ret_t dspm_gemm_s8(const int8_t *a, int lda, int m, int k, const int8_t *packed, int n,
+                       const dspm_requant_s8_t *rq, int8_t *c, int ldc) {
+    if (!a || !packed || !c || m <= 0 || k <= 0 || n <= 0 || lda <= 0 || ldc < n || !requant_valid(rq, n)) {
+        return DSP_RET_FAIL;
+    }
+
+    const int np = round_up(n, DSPM_GEMM_S8_NR);
+    const int kblocks = round_up(k, DSPM_GEMM_S8_KB) / DSPM_GEMM_S8_KB;
+    const int kfull = k / DSPM_GEMM_S8_KB;
+    const int ktail = k - kfull * DSPM_GEMM_S8_KB;
+    const int8_t *sums_bytes = packed + (size_t)np * kblocks * DSPM_GEMM_S8_KB;
+
+    for (int n0 = 0; n0 < np; n0 += DSPM_GEMM_S8_NB) {
+        int n_end = n0 + DSPM_GEMM_S8_NB < np ? n0 + DSPM_GEMM_S8_NB : np;
+
+        for (int i = 0; i < m; i += 2) {
+            int rows = m - i < 2 ? m - i : 2;
+            const int8_t *a0 = a + (size_t)i * lda;
+            const int8_t *a1 = rows > 1 ? a0 + lda : a0;
+
+            // The last partial block is read from zero-padded copies so the
+            // kernels never read past the end of a row
+            alignas(16) int8_t tail0[DSPM_GEMM_S8_KB] = {0};
+            alignas(16) int8_t tail1[DSPM_GEMM_S8_KB] = {0};
+            if (ktail) {
+                memcpy(tail0, a0 + kfull * DSPM_GEMM_S8_KB, ktail);
+                memcpy(tail1, a1 + kfull * DSPM_GEMM_S8_KB, ktail);
+            }
+
+            for (int nb = n0; nb < n_end; nb += DSPM_GEMM_S8_NR) {
+                const int8_t *panel = packed + (size_t)(nb / DSPM_GEMM_S8_NR) * kblocks * DSPM_GEMM_S8_PANEL;
+                int32_t acc[2][DSPM_GEMM_S8_NR] = {{0}};
+                if (kfull) {
+                    kernel_2x4(a0, a1, panel, kfull, acc);
+                }
+                if (ktail) {
+                    kernel_2x4_generic(tail0, tail1, panel + (size_t)kfull * DSPM_GEMM_S8_PANEL, 1, acc);
+                }
+
+                for (int r = 0; r < DSPM_GEMM_S8_NR && nb + r < n; r++) {
+                    int32_t sum;
+                    memcpy(&sum, sums_bytes + (size_t)(nb + r) * sizeof(int32_t), sizeof(sum));
+                    for (int j = 0; j < rows; j++) {
+                        int32_t total = acc[j][r] + rq->input_offset * sum;
+                        c[(size_t)(i + j) * ldc + nb + r] = requant_one(total, nb + r, rq);
+                    }
+                }
+            }
+        }
+
+        dsp_budget_poll();
+    }
+
+    return DSP_RET_OK;
+}
+
+dsp_ret_t dspm_gemm_s8_ref(const int8_t *a, int lda, int m, int k, const int8_t *w, int n,
+                           const dspm_requant_s8_t *rq, int8_t *c, int ldc) {
+    if (!a || !w || !c || m <= 0 || k <= 0 || n <= 0 || lda <= 0 || ldc < n || !requant_valid(rq, n)) {
+        return DSP_RET_FAIL;
+    }
+
+    for (int i = 0; i < m; i++) {
+        const int8_t *x = a + (size_t)i * lda;
+        for (int o = 0; o < n; o++) {
+            const int8_t *wo = w + (size_t)o * k;
+            int32_t acc = 0;
+            for (int j = 0; j < k; j++) {
+                acc += ((int32_t)x[j] + rq->input_offset) * wo[j];
+            }
+            c[(size_t)i * ldc + o] = requant_one(acc, o, rq);
+        }
+    }
+
+    return DSP_RET_OK;
+}
+
+dsp_ret_t dsps_conv1d_s8(const int8_t *x, int frames, int in_ch, const int8_t *packed, int out_ch,
+                         int kernel, int stride, const dspm_requant_s8_t *rq, int8_t *y) {
+    if (kernel <= 0 || stride <= 0 || in_ch <= 0 || frames < kernel) {
+        return DSP_RET_FAIL;
+    }
+    int out_frames = (frames - kernel) / stride + 1;
+    return dspm_gemm_s8(x, stride * in_ch, out_frames, kernel * in_ch, packed, out_ch, rq, y, out_ch);
+}
+
+dsp_ret_t dsps_conv1d_s8_ref(const int8_t *x, int frames, int in_ch, const int8_t *w, int out_ch,
+                             int kernel, int stride, const dspm_requant_s8_t *rq, int8_t *y) {
+    if (!x || !w || !y || kernel <= 0 || stride <= 0 || in_ch <= 0 || out_ch <= 0 ||
+        frames < kernel || !requant_valid(rq, out_ch)) {
+        return DSP_RET_FAIL;
+    }
+
+    int out_frames = (frames - kernel) / stride + 1;
+    for (int t = 0; t < out_frames; t++) {
+        for (int o = 0; o < out_ch; o++) {
+            int32_t acc = 0;
+            for (int kk = 0; kk < kernel; kk++) {
+                const int8_t *xt = x + (size_t)(t * stride + kk) * in_ch;
+                const int8_t *wk = w + ((size_t)o * kernel + kk) * in_ch;
+                for (int i = 0; i < in_ch; i++) {
+                    acc += ((int32_t)xt[i] + rq->input_offset) * wk[i];
+                }
+            }
+            y[(size_t)t * out_ch + o] = requant_one(acc, o, rq);
+        }
+    }
+
+    return DSP_RET_OK;
+}
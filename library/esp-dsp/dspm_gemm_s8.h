@@ -0,0 +1,126 @@
+#ifndef _DSPM_GEMM_S8_H_
+#define _DSPM_GEMM_S8_H_
+
+#include <stddef.h>
+#include <stdint.h>
+#include "dsp_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Packed weight panels: 4 output channels by 16 inputs per block
+#define DSPM_GEMM_S8_NR 4
+#define DSPM_GEMM_S8_KB 16
+
+// Largest requantization right shift, keeping 31 + shift below 64
+#define DSPM_REQUANT_MAX_SHIFT 32
+
+/**
+ * @brief Per-output-channel requantization of int32 accumulators
+ *
+ * out[n] = clamp(((acc + bias[n]) * multiplier[n]) >> (31 + shift[n]) + output_offset)
+ * with round-half-up, where acc = sum((x + input_offset) * w).
+ *
+ * Only scales below one are representable: shift[n] must lie in
+ * 0..DSPM_REQUANT_MAX_SHIFT, and the kernels reject parameters with a
+ * shift outside it.
+ */
+typedef struct {
+    const int32_t* bias;        // [n] in accumulator units, NULL for none
+    const int32_t* multiplier;  // [n] Q31
+    const int8_t* shift;        // [n] right shift after the Q31 multiply, >= 0
+    int32_t input_offset;       // Minus the input zero point
+    int32_t output_offset;      // Output zero point
+    int32_t act_min;            // Clamp, e.g. the zero point for ReLU
+    int32_t act_max;
+} dspm_requant_s8_t;
+
+/**
+ * @brief Size of a packed weight buffer
+ *
+ * @param n Output channels (rows of W)
+ * @param k Inputs per output (columns of W)
+ * @return Bytes, including the per-row weight sums
+ */
+size_t dspm_gemm_s8_packed_size(int n, int k);
+
+/**
+ * @brief Pack W[n][k] for dspm_gemm_s8 (run offline or once at load)
+ *
+ * Rows are grouped by DSPM_GEMM_S8_NR and inputs by DSPM_GEMM_S8_KB, zero
+ * padded, so the kernels read one contiguous 64-byte panel per step. The
+ * row sums used to fold the input offset are stored after the panels.
+ *
+ * @param w Row-major weights [n][k]
+ * @param n Output channels
+ * @param k Inputs per output
+ * @param packed Buffer of dspm_gemm_s8_packed_size(n, k) bytes, 16-byte aligned
+ * @return ESP_OK on success
+ */
+dsp_ret_t dspm_gemm_s8_pack(const int8_t *w, int n, int k, int8_t *packed);
+
+/**
+ * @brief C[m][n] = requant(A[m][k] x W[n][k]^T), int8 in, int32 accumulate
+ *
+ * Cache blocked over output channels so a block of packed weights stays
+ * hot while every row of A streams past it; each step computes two rows
+ * by four channels in registers. Uses AVX2 or SSE2 on the host and the
+ * ESP32-S3 PIE vector MAC when CONFIG_DSP_OPTIMIZED and the opt-in
+ * CONFIG_DSP_GEMM_S8_PIE are set, otherwise a portable kernel. Results
+ * are bit-exact with dspm_gemm_s8_ref.
+ *
+ * @param a Activations, row i at a + i * lda
+ * @param lda Row stride of A in elements; rows may overlap (lda < k)
+ * @param m Rows of A
+ * @param k Inputs per row
+ * @param packed Weights from dspm_gemm_s8_pack
+ * @param n Output channels
+ * @param rq Requantization parameters
+ * @param c Output, row i at c + i * ldc
+ * @param ldc Row stride of C in elements (>= n)
+ * @return ESP_OK on success, DSP_RET_FAIL on bad arguments or a shift
+ *         outside 0..DSPM_REQUANT_MAX_SHIFT
+ */
+dsp_ret_t dspm_gemm_s8(const int8_t *a, int lda, int m, int k, const int8_t *packed, int n,
+                       const dspm_requant_s8_t *rq, int8_t *c, int ldc);
+
+/**
+ * @brief Scalar reference for dspm_gemm_s8 on unpacked W[n][k]
+ */
+dsp_ret_t dspm_gemm_s8_ref(const int8_t *a, int lda, int m, int k, const int8_t *w, int n,
+                           const dspm_requant_s8_t *rq, int8_t *c, int ldc);
+
+/**
+ * @brief Valid 1-D convolution over time, layout [time][channel]
+ *
+ * Each output frame's receptive field is kernel * in_ch contiguous
+ * values, so this is dspm_gemm_s8 with a row stride of stride * in_ch and
+ * no im2col copy. Weights are [out_ch][kernel][in_ch], packed with
+ * dspm_gemm_s8_pack(w, out_ch, kernel * in_ch, packed).
+ *
+ * @param x Input [frames][in_ch]
+ * @param frames Input frames
+ * @param in_ch Input channels
+ * @param packed Packed weights
+ * @param out_ch Output channels
+ * @param kernel Kernel length in frames
+ * @param stride Frames between outputs
+ * @param rq Requantization parameters
+ * @param y Output [(frames - kernel) / stride + 1][out_ch]
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_conv1d_s8(const int8_t *x, int frames, int in_ch, const int8_t *packed, int out_ch,
+                         int kernel, int stride, const dspm_requant_s8_t *rq, int8_t *y);
+
+/**
+ * @brief Scalar reference for dsps_conv1d_s8 on unpacked weights
+ */
+dsp_ret_t dsps_conv1d_s8_ref(const int8_t *x, int frames, int in_ch, const int8_t *w, int out_ch,
+                             int kernel, int stride, const dspm_requant_s8_t *rq, int8_t *y);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DSPM_GEMM_S8_H_
@@ -0,0 +1,325 @@
+#include "dsps_fft.h"
+#include <math.h>
+
+static void fillBitrev(uint16_t *bitrev, int m) {
+    int bits = 0;
+    while ((1 << bits) < m) {
+        bits++;
+    }
+    for (int i = 0; i < m; i++) {
+        int r = 0;
+        for (int b = 0; b < bits; b++) {
+            if (i & (1 << b)) {
+                r |= 1 << (bits - 1 - b);
+            }
+        }
+        bitrev[i] = (uint16_t)r;
+    }
+}
+
+dsp_ret_t dsps_fft_plan_init_f32(fft_plan_f32_t *plan, float *twiddle, uint16_t *bitrev, int n) {
+    if (!plan || !twiddle || !bitrev || n < 4 || n > 65536 || (n & (n - 1)) != 0) {
+        return DSP_RET_FAIL;
+    }
+
+    plan->twiddle = twiddle;
+    plan->bitrev = bitrev;
+    plan->n = n;
+
+    for (int k = 0; k < n / 2; k++) {
+        double phase = 2.0 * M_PI * k / n;
+        twiddle[2 * k] = (float)cos(phase);
+        twiddle[2 * k + 1] = (float)sin(phase);
+    }
+    fillBitrev(bitrev, n / 2);
+
+    return DSP_RET_OK;
+}
+
+// In-place m = n/2 point complex FFT of interleaved data; the inverse
+// direction uses conjugate twiddles and is not scaled
+static void complexFft(const fft_plan_f32_t *plan, float *data, bool inverse) {
+    const int m = plan->n / 2;
+    const float* tw = plan->twiddle;
+    const float sign = inverse ? -1.0f : 1.0f;
+
+    for (int i = 0; i < m; i++) {
+        int r = plan->bitrev[i];
+        if (r > i) {
+            float re = data[2 * i];
+            float im = data[2 * i + 1];
+            data[2 * i] = data[2 * r];
+            data[2 * i + 1] = data[2 * r + 1];
+            data[2 * r] = re;
+            data[2 * r + 1] = im;
+        }
+    }
+
+    // Radix-2 butterflies; W_m^j = W_n^(2j)
+    for (int size = 2; size <= m; size <<= 1) {
+        int half = size >> 1;
+        int stride = 2 * (m / size);
+        for (int start = 0; start < m; start += size) {
+            for (int j = 0; j < half; j++) {
+                float c = tw[2 * j * stride];
+                float s = sign * tw[2 * j * stride + 1];
+                float* a = &data[2 * (start + j)];
+                float* b = &data[2 * (start + j + half)];
+                // t = b * (c - i s)
+                float tr = b[0] * c + b[1] * s;
+                float ti = b[1] * c - b[0] * s;
+                b[0] = a[0] - tr;
+                b[1] = a[1] - ti;
+                a[0] += tr;
+                a[1] += ti;
+            }
+        }
+    }
+}
+
+dsp_ret_t dsps_rfft_f32(const fft_plan_f32_t *plan, float *data) {
+    if (!plan || !plan->twiddle || !data) {
+        return DSP_RET_FAIL;
+    }
+
+    const int n = plan->n;
+    const int m = n / 2;
+    const float* tw = plan->twiddle;
+
+    // Even/odd samples as one m point complex sequence
+    complexFft(plan, data, false);
+
+    // Split the m point result into the n point real spectrum
+    float z0r = data[0];
+    float z0i = data[1];
+    data[0] = z0r + z0i;
+    data[1] = z0r - z0i;
+
+    for (int k = 1; k <= m / 2; k++) {
+        float* zk = &data[2 * k];
+        float* zm = &data[2 * (m - k)];
+        float fer = 0.5f * (zk[0] + zm[0]);
+        float fei = 0.5f * (zk[1] - zm[1]);
+        float for_ = 0.5f * (zk[1] + zm[1]);
+        float foi = -0.5f * (zk[0] - zm[0]);
+        float c = tw[2 * k];
+        float s = tw[2 * k + 1];
+        float wr = c * for_ + s * foi;
+        float wi = c * foi - s * for_;
+        zk[0] = fer + wr;
+        zk[1] = fei + wi;
+        zm[0] = fer - wr;
+        zm[1] = wi - fei;
+    }
+
+    return DSP_RET_OK;
+}
+
+dsp_ret_t dsps_irfft_f32(const fft_plan_f32_t *plan, float *data) {
+    if (!plan || !plan->twiddle || !data) {
+        return DSP_RET_FAIL;
+    }
+
+    const int n = plan->n;
+    const int m = n / 2;
+    const float* tw = plan->twiddle;
+
+    // Undo the split: Z[k] = Fe[k] + i Fo[k], where X[k] = Fe[k] + W^k Fo[k]
+    float x0 = data[0];
+    float xm = data[1];
+    data[0] = 0.5f * (x0 + xm);
+    data[1] = 0.5f * (x0 - xm);
+
+    for (int k = 1; k <= m / 2; k++) {
+        float* xk = &data[2 * k];
+        float* xj = &data[2 * (m - k)];
+        // Fe = (X[k] + conj(X[m-k])) / 2, Fo = (X[k] - conj(X[m-k])) / 2 * conj(W^k)
+        float fer = 0.5f * (xk[0] + xj[0]);
+        float fei = 0.5f * (xk[1] - xj[1]);
+        float dr = 0.5f * (xk[0] - xj[0]);
+        float di = 0.5f * (xk[1] + xj[1]);
+        float c = tw[2 * k];
+        float s = tw[2 * k + 1];
+        float for_ = dr * c - di * s;
+        float foi = dr * s + di * c;
+        // Z[k] = Fe + i Fo, Z[m-k] = conj(Fe) + i conj(Fo)
+        xk[0] = fer - foi;
+        xk[1] = fei + for_;
+        xj[0] = fer + foi;
+        xj[1] = for_ - fei;
+    }
+
+    complexFft(plan, data, true);
+
+    const float scale = 1.0f / m;
+    for (int i = 0; i < n; i++) {
+        data[i] *= scale;
+    }
+
+    return DSP_RET_OK;
+}
+
+dsp_ret_t dsps_rfft_power_f32(const float *packed, float *power, int n) {
+    if (!packed || !power || n < 4) {
+        return DSP_RET_FAIL;
+    }
+
+    power[0] = packed[0] * packed[0];
+    power[n / 2] = packed[1] * packed[1];
+    for (int k = 1; k < n / 2; k++) {
+        power[k] = packed[2 * k] * packed[2 * k] + packed[2 * k + 1] * packed[2 * k + 1];
+    }
+
+    return DSP_RET_OK;
+}
+
+dsp_ret_t dsps_fft_plan_init_s16(fft_plan_s16_t *plan, int16_t *twiddle, uint16_t *bitrev, int n) {
+    if (!plan || !twiddle || !bitrev || n < 4 || n > 65536 || (n & (n - 1)) != 0) {
+        return DSP_RET_FAIL;
+    }
+
+    plan->twiddle = twiddle;
+    plan->bitrev = bitrev;
+    plan->n = n;
+
+    for (int k = 0; k < n / 2; k++) {
+        double phase = 2.0 * M_PI * k / n;
+        twiddle[2 * k] = (int16_t)lrint(fmin(cos(phase) * 32768.0, 32767.0));
+        twiddle[2 * k + 1] = (int16_t)lrint(fmin(sin(phase) * 32768.0, 32767.0));
+    }
+    fillBitrev(bitrev, n / 2);
+
+    return DSP_RET_OK;
+}
+
+static inline int16_t saturate16(int32_t value) {
+    if (value > 32767) {
+        return 32767;
+    }
+    if (value < -32768) {
+        return -32768;
+    }
+    return (int16_t)value;
+}
+
+// Q15 counterpart of complexFft. The forward direction halves every stage
+// (overall 1/m); the inverse is unscaled and saturates.
+static void complexFftS16(const fft_plan_s16_t *plan, int16_t *data, bool inverse) {
+    const int m = plan->n / 2;
+    const int16_t* tw = plan->twiddle;
+    const int32_t sign = inverse ? -1 : 1;
+
+    for (int i = 0; i < m; i++) {
+        int r = plan->bitrev[i];
+        if (r > i) {
+            int16_t re = data[2 * i];
+            int16_t im = data[2 * i + 1];
+            data[2 * i] = data[2 * r];
+            data[2 * i + 1] = data[2 * r + 1];
+            data[2 * r] = re;
+            data[2 * r + 1] = im;
+        }
+    }
+
+    for (int size = 2; size <= m; size <<= 1) {
+        int half = size >> 1;
+        int stride = 2 * (m / size);
+        for (int start = 0; start < m; start += size) {
+            for (int j = 0; j < half; j++) {
+                int32_t c = tw[2 * j * stride];
+                int32_t s = sign * tw[2 * j * stride + 1];
+                int16_t* a = &data[2 * (start + j)];
+                int16_t* b = &data[2 * (start + j + half)];
+                int32_t tr = (b[0] * c + b[1] * s + (1 << 14)) >> 15;
+                int32_t ti = (b[1] * c - b[0] * s + (1 << 14)) >> 15;
+                if (inverse) {
+                    b[0] = saturate16(a[0] - tr);
+                    b[1] = saturate16(a[1] - ti);
+                    a[0] = saturate16(a[0] + tr);
+                    a[1] = saturate16(a[1] + ti);
+                } else {
+                    b[0] = saturate16((a[0] - tr + 1) >> 1);
+                    b[1] = saturate16((a[1] - ti + 1) >> 1);
+                    a[0] = saturate16((a[0] + tr + 1) >> 1);
+                    a[1] = saturate16((a[1] + ti + 1) >> 1);
+                }
+            }
+        }
+    }
+}
+
+dsp_ret_t dsps_rfft_s16(const fft_plan_s16_t *plan, int16_t *data) {
+    if (!plan || !plan->twiddle || !data) {
+        return DSP_RET_FAIL;
+    }
+
+    const int n = plan->n;
+    const int m = n / 2;
+    const int16_t* tw = plan->twiddle;
+
+    complexFftS16(plan, data, false);
+
+    // Same split as dsps_rfft_f32 on Z/m, with the 1/2 factors folded into
+    // one final 1/4 so the output is X/n
+    int32_t z0r = data[0];
+    int32_t z0i = data[1];
+    data[0] = saturate16((z0r + z0i + 1) >> 1);
+    data[1] = saturate16((z0r - z0i + 1) >> 1);
+
+    for (int k = 1; k <= m / 2; k++) {
+        int16_t* zk = &data[2 * k];
+        int16_t* zm = &data[2 * (m - k)];
+        int32_t fer = zk[0] + zm[0];
+        int32_t fei = zk[1] - zm[1];
+        int32_t for_ = zk[1] + zm[1];
+        int32_t foi = zm[0] - zk[0];
+        int64_t c = tw[2 * k];
+        int64_t s = tw[2 * k + 1];
+        int32_t wr = (int32_t)((c * for_ + s * foi + (1 << 14)) >> 15);
+        int32_t wi = (int32_t)((c * foi - s * for_ + (1 << 14)) >> 15);
+        zk[0] = saturate16((fer + wr + 2) >> 2);
+        zk[1] = saturate16((fei + wi + 2) >> 2);
+        zm[0] = saturate16((fer - wr + 2) >> 2);
+        zm[1] = saturate16((wi - fei + 2) >> 2);
+    }
+
+    return DSP_RET_OK;
+}
+
+dsp_ret_t dsps_irfft_s16(const fft_plan_s16_t *plan, int16_t *data) {
+    if (!plan || !plan->twiddle || !data) {
+        return DSP_RET_FAIL;
+    }
+
+    const int n = plan->n;
+    const int m = n / 2;
+    const int16_t* tw = plan->twiddle;
+
+    // Undo the split without the 1/2 factors: X/n in, Z/m out, so the
+    // unscaled inverse returns x
+    int32_t x0 = data[0];
+    int32_t xm = data[1];
+    data[0] = saturate16(x0 + xm);
+    data[1] = saturate16(x0 - xm);
+
+    for (int k = 1; k <= m / 2; k++) {
+        int16_t* xk = &data[2 * k];
+        int16_t* xj = &data[2 * (m - k)];
+        int32_t fer = xk[0] + xj[0];
+        int32_t fei = xk[1] - xj[1];
+        int64_t dr = xk[0] - xj[0];
+        int64_t di = xk[1] + xj[1];
+        int64_t c = tw[2 * k];
+        int64_t s = tw[2 * k + 1];
+        int32_t for_ = (int32_t)((dr * c - di * s + (1 << 14)) >> 15);
+        int32_t foi = (int32_t)((dr * s + di * c + (1 << 14)) >> 15);
+        xk[0] = saturate16(fer - foi);
+        xk[1] = saturate16(fei + for_);
+        xj[0] = saturate16(fer + foi);
+        xj[1] = saturate16(for_ - fei);
+    }
+
+    complexFftS16(plan, data, true);
+
+    return DSP_RET_OK;
+}
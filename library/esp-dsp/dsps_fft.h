@@ -0,0 +1,119 @@
+#ifndef _DSPS_FFT_H_
+#define _DSPS_FFT_H_
+
+#include <stdint.h>
+#include "dsp_platform.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Table sizes for a real FFT of length n
+#define DSPS_FFT_TWIDDLE_LEN(n) (n)
+#define DSPS_FFT_BITREV_LEN(n) ((n) / 2)
+
+typedef struct {
+    float* twiddle;     // cos/sin pairs of 2*pi*k/n for k < n/2
+    uint16_t* bitrev;   // Bit-reversal permutation of the n/2 point complex FFT
+    int n;              // Real FFT length
+} fft_plan_f32_t;
+
+typedef struct {
+    int16_t* twiddle;   // Q15 cos/sin pairs of 2*pi*k/n for k < n/2
+    uint16_t* bitrev;   // Bit-reversal permutation of the n/2 point complex FFT
+    int n;              // Real FFT length
+} fft_plan_s16_t;
+
+/**
+ * @brief Initialize a real FFT plan
+ *
+ * Tables are computed once here and shared by every transform that uses
+ * the plan, so the transform itself does no trigonometry or allocation.
+ *
+ * @param plan Pointer to plan structure
+ * @param twiddle Array of DSPS_FFT_TWIDDLE_LEN(n) floats
+ * @param bitrev Array of DSPS_FFT_BITREV_LEN(n) entries
+ * @param n Transform length, power of two between 4 and 65536
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_fft_plan_init_f32(fft_plan_f32_t *plan, float *twiddle, uint16_t *bitrev, int n);
+
+/**
+ * @brief In-place real FFT
+ *
+ * The n real inputs are computed as an n/2 point complex FFT followed by a
+ * split step. Output is packed: data[0] is DC, data[1] is Nyquist, and
+ * data[2k], data[2k+1] are the real and imaginary parts of bin k for
+ * 0 < k < n/2.
+ *
+ * @param plan Initialized plan
+ * @param data Array of n floats
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_rfft_f32(const fft_plan_f32_t *plan, float *data);
+
+/**
+ * @brief In-place inverse real FFT
+ *
+ * Takes the packed layout produced by dsps_rfft_f32 and returns n real
+ * samples, scaled so that dsps_irfft_f32(dsps_rfft_f32(x)) == x.
+ *
+ * @param plan Initialized plan
+ * @param data Array of n floats
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_irfft_f32(const fft_plan_f32_t *plan, float *data);
+
+/**
+ * @brief Power spectrum of a packed real FFT output
+ *
+ * @param packed Output of dsps_rfft_f32
+ * @param power Array of n/2 + 1 bin powers
+ * @param n Transform length
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_rfft_power_f32(const float *packed, float *power, int n);
+
+/**
+ * @brief Initialize a Q15 real FFT plan
+ *
+ * @param plan Pointer to plan structure
+ * @param twiddle Array of DSPS_FFT_TWIDDLE_LEN(n) entries
+ * @param bitrev Array of DSPS_FFT_BITREV_LEN(n) entries
+ * @param n Transform length, power of two between 4 and 65536
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_fft_plan_init_s16(fft_plan_s16_t *plan, int16_t *twiddle, uint16_t *bitrev, int n);
+
+/**
+ * @brief In-place Q15 real FFT
+ *
+ * Same packed layout as dsps_rfft_f32, scaled by 1/n: every butterfly
+ * stage halves its outputs so nothing overflows, at the cost of about one
+ * bit of precision per stage. Inputs with headroom to spare should be
+ * shifted up first (block floating point).
+ *
+ * @param plan Initialized plan
+ * @param data Array of n samples
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_rfft_s16(const fft_plan_s16_t *plan, int16_t *data);
+
+/**
+ * @brief In-place Q15 inverse real FFT
+ *
+ * Takes the packed layout produced by dsps_rfft_s16 and returns n samples,
+ * so that dsps_irfft_s16(dsps_rfft_s16(x)) == x up to rounding. Results
+ * saturate rather than wrap.
+ *
+ * @param plan Initialized plan
+ * @param data Array of n samples
+ * @return ESP_OK on success
+ */
+dsp_ret_t dsps_irfft_s16(const fft_plan_s16_t *plan, int16_t *data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // _DSPS_FFT_H_
@@ -1,15 +1,6 @@
 #include "dsps_fir.h"
-#include "freertos/FreeRTOS.h"
-#include "freertos/task.h"
+#include "dsp_budget.h"
 #include <string.h>
-#include "Arduino.h"
-
-// Platform-specific yield implementation
-static inline void dsp_yield() {
-    #ifdef ESP_PLATFORM
-        vTaskDelay(1); // Give 1 tick to other tasks
-    #endif
-}
 
 dsp_ret_t dsps_fir_init_f32(fir_f32_t *fir, float *coeffs, float *delay, int coeffs_len) {
     if (!fir || !coeffs || !delay || coeffs_len <= 0) {
@@ -31,7 +22,8 @@ dsp_ret_t dsps_fir_f32(fir_f32_t *fir, const float *input, float *output, int le
         return DSP_RET_FAIL;
     }
     
-    // Process in smaller chunks to prevent watchdog triggers
+    // Check the task's time budget every chunk; the CPU is only given up
+    // once the slice is exhausted, never on a task with slice 0
     const int CHUNK_SIZE = 32;
     
     for (int chunk = 0; chunk < len; chunk += CHUNK_SIZE) {
@@ -61,8 +53,7 @@ dsp_ret_t dsps_fir_f32(fir_f32_t *fir, const float *input, float *output, int le
             output[chunk + i] = sum;
         }
         
-        // Feed watchdog using platform-specific yield
-        yield();
+        dsp_budget_poll();
     }
     
     return DSP_RET_OK;
@@ -0,0 +1,204 @@
+#ifndef FEATURE_STREAM_H
+#define FEATURE_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "log_mel.h"
+#include "pipeline_runtime.h"
+
+/**
+ * Feature offload wire format. Every packet is
+ *
+ *   'L' 'M'        sync
+ *   uint8 type     FeaturePacketType
+ *   uint8 seq      packet counter, wraps; gaps are lost packets
+ *   uint16 length  payload bytes
+ *   payload
+ *   uint16 crc     CRC-16/CCITT-FALSE over type..payload
+ *
+ * little-endian. CONFIG opens a stream and describes the frames:
+ *
+ *   uint16 sample_rate, uint8 window_ms, uint8 hop_ms, uint8 mel_bins,
+ *   uint8 frames_per_packet, float32 scale, float32 offset
+ *
+ * FEATURES carries uint32 first_frame followed by whole frames of
+ * mel_bins int8 values, feature = offset + scale * q. END carries the
+ * uint32 frame count of the stream.
+ */
+#define FEATURE_SYNC_0 0x4c             // 'L'
+#define FEATURE_SYNC_1 0x4d             // 'M'
+#define FEATURE_HEADER_BYTES 6
+#define FEATURE_CRC_BYTES 2
+#define FEATURE_CONFIG_BYTES 14
+#define FEATURE_MAX_PAYLOAD 1024
+
+enum class FeaturePacketType : uint8_t {
+    CONFIG = 1,
+    FEATURES = 2,
+    END = 3
+};
+
+// CRC-16/CCITT-FALSE: polynomial 0x1021, initial value 0xffff
+uint16_t featureCrc16(const uint8_t* data, size_t length, uint16_t crc = 0xffff);
+
+struct FeatureStreamConfig {
+    float min_value;                // Log-mel range mapped onto int8; values
+    float max_value;                // outside it are clamped
+    uint8_t frames_per_packet;      // Header overhead is paid once per packet
+};
+
+// ln power from -24 to +8 in steps of 0.125 (about 0.5 dB), 4 frames per packet
+FeatureStreamConfig defaultFeatureStreamConfig();
+
+struct FeatureStreamStats {
+    uint32_t frames;
+    uint32_t packets;
+    uint64_t bytes;                 // Everything written, headers included
+    uint32_t write_failures;        // Packets the link did not take
+    uint32_t clipped;               // Feature values outside the range
+};
+
+/**
+ * @class FeatureStreamEncoder
+ * @brief Turns audio into quantized log-mel packets for a paired host
+ *
+ * 16 kHz int16 PCM is 256 kbit/s; 80 int8 mel bins per 10 ms hop is 64
+ * kbit/s before framing, and about 66 kbit/s with four frames per
+ * packet. Audio goes through a LogMelFrontEnd owned by the encoder, or
+ * features computed elsewhere are pushed directly. The packet buffer is
+ * sized in the constructor; nothing is allocated while streaming.
+ *
+ * The write function is the transport (BluetoothManager::sendData on
+ * target, a file descriptor on the host). A failed write drops that
+ * packet only; the receiver sees the gap in the sequence numbers.
+ */
+class FeatureStreamEncoder {
+public:
+    using WriteFunction = std::function<bool(const uint8_t* data, size_t length)>;
+
+    FeatureStreamEncoder(const LogMelConfig& mel = defaultLogMelConfig(),
+                         const FeatureStreamConfig& config = defaultFeatureStreamConfig());
+
+    FeatureStreamEncoder(const FeatureStreamEncoder&) = delete;
+    FeatureStreamEncoder& operator=(const FeatureStreamEncoder&) = delete;
+
+    /**
+     * Reset the front end and send CONFIG
+     */
+    bool begin(WriteFunction write);
+
+    /**
+     * Push audio; frames are sent as packets fill
+     *
+     * @return Number of feature frames produced
+     */
+    size_t feed(const int16_t* samples, size_t count);
+
+    // Push one frame of mel_bins log-mel values
+    void pushFrame(const float* features);
+
+    /**
+     * Flush the front end and the partial packet, then send END
+     */
+    bool end();
+
+    bool isStreaming() const { return streaming_; }
+
+    /**
+     * Stage function for PipelineRuntime::addStage; frames pass through
+     */
+    audio_processing::PipelineRuntime::StageFunction stageFunction();
+
+    int melBins() const { return frontend_.melBins(); }
+    float scale() const { return scale_; }
+    float offset() const { return offset_; }
+    const FeatureStreamStats& stats() const { return stats_; }
+
+private:
+    void sendPacket(FeaturePacketType type, size_t payload);
+
+    LogMelConfig mel_;
+    FeatureStreamConfig config_;
+    LogMelFrontEnd frontend_;
+    LogMelFrontEnd::FrameCallback on_frame_;
+    WriteFunction write_;
+    float scale_;
+    float offset_;
+    std::vector<uint8_t> packet_;
+    uint32_t frame_index_;
+    uint32_t first_frame_;
+    uint8_t pending_;
+    uint8_t seq_;
+    bool streaming_;
+    FeatureStreamStats stats_;
+};
+
+struct FeatureStreamInfo {
+    int sample_rate;
+    uint8_t window_ms;
+    uint8_t hop_ms;
+    uint8_t mel_bins;
+    uint8_t frames_per_packet;
+    float scale;
+    float offset;
+};
+
+struct FeatureReceiverStats {
+    uint32_t packets;
+    uint32_t frames;
+    uint32_t crc_errors;
+    uint32_t lost_packets;          // From sequence gaps
+    uint32_t lost_frames;           // From frame index gaps
+    uint64_t skipped_bytes;         // Discarded while looking for sync
+};
+
+/**
+ * @class FeatureStreamReceiver
+ * @brief Host-side reference receiver for FeatureStreamEncoder packets
+ *
+ * Bytes are pushed in whatever pieces the transport delivers. A bad CRC
+ * or an implausible header costs one byte of resync rather than the rest
+ * of the stream. Frames come out dequantized with their stream index, so
+ * a recognizer on the host sees the features the device computed, and a
+ * gap shows up as a jump in the index.
+ */
+class FeatureStreamReceiver {
+public:
+    using ConfigFunction = std::function<void(const FeatureStreamInfo& info)>;
+    using FrameFunction = std::function<void(uint32_t index, const float* features)>;
+    using EndFunction = std::function<void(uint32_t frames)>;
+
+    FeatureStreamReceiver();
+
+    void setConfig(ConfigFunction config) { config_ = config; }
+    void setFrame(FrameFunction frame) { frame_ = frame; }
+    void setEnd(EndFunction end) { end_ = end; }
+
+    // Parse a piece of the byte stream
+    void push(const uint8_t* data, size_t length);
+
+    bool hasConfig() const { return has_config_; }
+    const FeatureStreamInfo& info() const { return info_; }
+    const FeatureReceiverStats& stats() const { return stats_; }
+
+private:
+    bool parse();
+    void handlePacket(FeaturePacketType type, const uint8_t* payload, size_t length);
+
+    ConfigFunction config_;
+    FrameFunction frame_;
+    EndFunction end_;
+    std::vector<uint8_t> buffer_;
+    size_t start_;
+    FeatureStreamInfo info_;
+    bool has_config_;
+    bool has_seq_;
+    uint8_t next_seq_;
+    uint32_t next_frame_;
+    std::vector<float> features_;
+    FeatureReceiverStats stats_;
+};
+
+#endif // FEATURE_STREAM_H
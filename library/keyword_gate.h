@@ -0,0 +1,88 @@
+#ifndef KEYWORD_GATE_H
+#define KEYWORD_GATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "audio_frame_pool.h"
+#include "keyword_spotter.h"
+#include "pipeline_runtime.h"
+
+namespace audio_processing {
+
+/**
+ * @struct KeywordGateStats
+ * @brief Gate counters and the time spent spotting
+ */
+struct KeywordGateStats {
+    uint32_t frames_in;            // Frames seen by the gate
+    uint32_t frames_passed;        // Frames forwarded while awake
+    uint32_t frames_dropped;       // Frames held back while asleep
+    uint32_t wakes;                // Keyword hits that opened the gate
+    uint64_t spot_us;              // Time spent in the keyword spotter
+};
+
+/**
+ * @class KeywordGate
+ * @brief Pipeline stage that keeps everything behind it asleep until a
+ *        keyword is spotted
+ *
+ * While asleep every frame goes through the KeywordSpotter and is
+ * dropped. A hit calls the wake function (typically starting a
+ * SpeechRecognizer session or resetting an Endpointer) and then forwards
+ * frames unchanged for listen_ms, or until close() is called, without
+ * running the spotter. The frame that completes the keyword is not
+ * forwarded; the command follows it. The gate owns the spotter's hit
+ * function.
+ */
+class KeywordGate {
+public:
+    using WakeFunction = std::function<void(const KwsHit& hit)>;
+
+    KeywordGate(KeywordSpotter& spotter, uint32_t listen_ms, int sample_rate = 16000);
+
+    KeywordGate(const KeywordGate&) = delete;
+    KeywordGate& operator=(const KeywordGate&) = delete;
+
+    void setWake(WakeFunction wake) { _wake = wake; }
+
+    /**
+     * Gate one frame
+     *
+     * @param frame Input frame, never modified
+     * @return true to forward the frame, false to drop it
+     */
+    bool process(FrameRef& frame);
+
+    /**
+     * Stage function for PipelineRuntime::addStage
+     */
+    PipelineRuntime::StageFunction stageFunction();
+
+    bool isOpen() const { return _open.load(); }
+
+    /**
+     * Go back to sleep now (e.g. once the utterance has been dispatched)
+     */
+    void close();
+
+    void getStats(KeywordGateStats* stats) const;
+
+private:
+    KeywordSpotter& _spotter;
+    WakeFunction _wake;
+    KwsHit _last_hit;
+    uint64_t _listen_samples;
+    uint64_t _listened;
+    std::atomic<bool> _open;
+    std::atomic<bool> _close_requested;
+    std::atomic<uint32_t> _frames_in;
+    std::atomic<uint32_t> _frames_passed;
+    std::atomic<uint32_t> _frames_dropped;
+    std::atomic<uint32_t> _wakes;
+    std::atomic<uint64_t> _spot_us;
+};
+
+} // namespace audio_processing
+
+#endif // KEYWORD_GATE_H
@@ -0,0 +1,187 @@
+#ifndef KEYWORD_SPOTTER_H
+#define KEYWORD_SPOTTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include "log_mel.h"
+
+// Affine int8 quantization: real = scale * (q - zero_point)
+struct KwsQuant {
+    float scale;
+    int32_t zero_point;
+};
+
+enum class KwsLayerType : uint8_t {
+    CONV1D,             // Full 1-D convolution over time, valid padding
+    DEPTHWISE_CONV1D,   // One filter per channel, same padding
+    POINTWISE,          // 1x1 convolution (channel mixing)
+    AVG_POOL,           // Mean over the whole time axis
+    FULLY_CONNECTED
+};
+
+/**
+ * @brief One quantized layer; every pointer refers to const data, so a
+ *        model compiled into the firmware is read straight from flash
+ *
+ * Activations are [time][channel]. Weight layouts:
+ *  - CONV1D: [out][kernel][in]
+ *  - DEPTHWISE_CONV1D: [kernel][channel]
+ *  - POINTWISE, FULLY_CONNECTED: [out][in]
+ *
+ * Accumulation is int32 over (x - input zero point) * w. Each output
+ * channel is requantized with a Q31 multiplier and a right shift, so the
+ * effective scale is multiplier * 2^-(31 + shift). Scales must be below
+ * one: init() rejects a model with a negative shift.
+ */
+struct KwsLayer {
+    KwsLayerType type;
+    uint16_t in_channels;
+    uint16_t out_channels;
+    uint8_t kernel;
+    uint8_t stride;
+    bool relu;
+    const int8_t* weights;
+    const int32_t* bias;            // [out], in accumulator units
+    const int32_t* multiplier;      // [out]
+    const int8_t* shift;            // [out]
+    KwsQuant output;
+    const int8_t* packed = nullptr; // Conv/pointwise/FC weights from dspm_gemm_s8_pack, or null
+};
+
+struct KwsModel {
+    uint16_t input_frames;          // Feature frames per inference window
+    uint16_t input_bins;            // Log-mel bins per frame
+    KwsQuant input;
+    const KwsLayer* layers;
+    uint8_t layer_count;
+    uint8_t class_count;
+    uint8_t first_keyword;          // Classes before this are silence/unknown
+    const char* const* labels;
+};
+
+// Structured test model: 40 bins x 49 frames, DS-CNN with two
+// depthwise-separable blocks. Classes are silence, unknown (energy below
+// 1 kHz) and "keyword" (energy between 2 and 4 kHz).
+const KwsModel& kwsTestModel();
+
+struct KwsConfig {
+    int sample_rate;
+    uint8_t hop_frames;             // Feature frames between inferences
+    uint8_t smoothing;              // Inferences averaged per posterior
+    float threshold;                // Smoothed keyword posterior for a hit
+    uint32_t refractory_ms;         // No new hit this soon after one
+};
+
+KwsConfig defaultKwsConfig(int sample_rate = 16000);
+
+struct KwsHit {
+    int keyword;                    // Class index
+    const char* label;
+    float score;                    // Smoothed posterior
+    uint64_t frame;                 // Feature frame that completed the window
+};
+
+struct KwsStats {
+    uint32_t inferences;
+    uint32_t hits;
+    uint32_t last_cycles;           // CPU cycles of the last inference
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+};
+
+/**
+ * @class KeywordSpotter
+ * @brief Always-on int8 keyword spotter over log-mel features
+ *
+ * Audio runs through a LogMelFrontEnd sized to the model; each feature
+ * frame is quantized into a ring that forms the input window, and the
+ * network runs every hop_frames frames. Layer outputs ping-pong between
+ * two buffers in a caller-provided (typically static) arena, so nothing
+ * is allocated after construction and the model weights are never copied.
+ * Posteriors are averaged over the last smoothing inferences before the
+ * threshold is applied, which suppresses single-window false alarms.
+ */
+class KeywordSpotter {
+public:
+    static const int MAX_CLASSES = 16;
+    static const int MAX_SMOOTHING = 16;
+
+    using HitFunction = std::function<void(const KwsHit& hit)>;
+
+    KeywordSpotter(const KwsModel& model, const KwsConfig& config, void* arena, size_t arena_bytes);
+
+    KeywordSpotter(const KeywordSpotter&) = delete;
+    KeywordSpotter& operator=(const KeywordSpotter&) = delete;
+
+    // Arena needed for a model: input ring plus the two largest activations
+    static size_t arenaBytes(const KwsModel& model);
+
+    // Check the model and the arena; false if the spotter cannot run
+    bool init();
+
+    void setHit(HitFunction hit) { hit_ = hit; }
+
+    /**
+     * Push audio
+     *
+     * @return true if a keyword was detected during this call
+     */
+    bool feed(const int16_t* samples, size_t count);
+
+    /**
+     * Push one log-mel frame of model.input_bins values
+     *
+     * @return true if a keyword was detected
+     */
+    bool pushFeatures(const float* features);
+
+    /**
+     * Run the network on the current window without smoothing or hits
+     *
+     * @return class_count int8 logits, quantized with the last layer's output
+     */
+    const int8_t* infer();
+
+    // Smoothed and last raw posteriors, class_count entries
+    const float* posteriors() const { return smoothed_; }
+    const float* rawPosteriors() const { return raw_; }
+
+    // Clear audio, window and smoothing state (counters are kept)
+    void reset();
+
+    const KwsStats& stats() const { return stats_; }
+    const KwsModel& model() const { return model_; }
+
+private:
+    void runLayer(const KwsLayer& layer, const int8_t* input, int in_frames, int8_t* output, int* out_frames);
+    bool classify();
+
+    const KwsModel& model_;
+    KwsConfig config_;
+    LogMelFrontEnd frontend_;
+    LogMelFrontEnd::FrameCallback on_frame_;
+    HitFunction hit_;
+    bool ready_;
+
+    int8_t* arena_;
+    size_t arena_bytes_;
+    int8_t* ring_;                  // input_frames x input_bins
+    int8_t* act_[2];
+    size_t act_bytes_;
+    int ring_head_;                 // Oldest frame in the ring
+    uint64_t frames_;
+    uint32_t since_inference_;
+    uint32_t refractory_frames_;
+    uint64_t last_hit_frame_;
+    bool hit_in_call_;
+
+    float history_[MAX_SMOOTHING][MAX_CLASSES];
+    int history_count_;
+    int history_pos_;
+    float raw_[MAX_CLASSES];
+    float smoothed_[MAX_CLASSES];
+    KwsStats stats_;
+};
+
+#endif // KEYWORD_SPOTTER_H
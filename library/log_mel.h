@@ -0,0 +1,108 @@
+#ifndef LOG_MEL_H
+#define LOG_MEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "dsps_fft.h"
+
+struct LogMelConfig {
+    int sample_rate;
+    uint32_t window_ms;       // Analysis window (Hann)
+    uint32_t hop_ms;          // One feature frame per hop
+    int mel_bins;
+    float min_hz;
+    float max_hz;             // 0 = Nyquist
+    float power_floor;        // Clamp before the log
+};
+
+LogMelConfig defaultLogMelConfig(int sample_rate = 16000);
+
+/**
+ * @brief Fast natural log for positive normal floats
+ *
+ * Exponent from the float bits plus a polynomial fit of log2 on the
+ * mantissa; absolute error below 2e-4 over the whole range.
+ */
+float fastLog(float x);
+
+/**
+ * @class LogMelFrontEnd
+ * @brief Incremental log-mel spectrogram
+ *
+ * Samples are pushed as they arrive and a feature frame is produced every
+ * hop once a full window is buffered, so the features for an utterance are
+ * ready when its last sample is. The Hann window, FFT plan and mel
+ * filterbank are computed once in the constructor; the filterbank is
+ * stored sparsely as a start bin, a length and a run of weights per mel
+ * band, which touches only the nonzero triangle of each filter. Nothing is
+ * allocated per frame.
+ *
+ * Mel bands are HTK triangles (2595 * log10(1 + f / 700)), unnormalized,
+ * applied to the power spectrum of samples scaled to [-1, 1).
+ */
+class LogMelFrontEnd {
+public:
+    // Called with mel_bins log energies per frame
+    using FrameCallback = std::function<void(const float* features)>;
+
+    explicit LogMelFrontEnd(const LogMelConfig& config = defaultLogMelConfig());
+
+    // Drop buffered samples and restart frame numbering
+    void reset();
+
+    /**
+     * Push samples, calling frame for each feature frame completed
+     *
+     * @return Number of frames produced
+     */
+    size_t feed(const int16_t* samples, size_t count, const FrameCallback& frame);
+
+    /**
+     * End of stream: zero-pad so every buffered sample is covered by a frame
+     *
+     * @return Number of frames produced
+     */
+    size_t flush(const FrameCallback& frame);
+
+    int melBins() const { return config_.mel_bins; }
+    size_t windowSamples() const { return window_len_; }
+    size_t hopSamples() const { return hop_len_; }
+    int fftSize() const { return fft_size_; }
+    uint64_t framesProduced() const { return frames_; }
+
+    // Filterbank access for tests and offline tools
+    int melStart(int band) const { return mel_start_[band]; }
+    int melLength(int band) const { return mel_length_[band]; }
+    const float* melWeights(int band) const { return &mel_weights_[mel_offset_[band]]; }
+
+private:
+    void buildFilterbank();
+    void computeFrame(const FrameCallback& frame);
+
+    LogMelConfig config_;
+    size_t window_len_;
+    size_t hop_len_;
+    int fft_size_;
+
+    std::vector<float> window_;
+    std::vector<float> twiddle_;
+    std::vector<uint16_t> bitrev_;
+    fft_plan_f32_t plan_;
+
+    std::vector<uint16_t> mel_start_;
+    std::vector<uint16_t> mel_length_;
+    std::vector<uint32_t> mel_offset_;
+    std::vector<float> mel_weights_;
+
+    std::vector<float> pending_;      // Up to window_len_ samples, oldest first
+    size_t pending_count_;
+    size_t covered_;                  // Pending samples already inside an emitted frame
+    std::vector<float> fft_buf_;
+    std::vector<float> power_;
+    std::vector<float> features_;
+    uint64_t frames_;
+};
+
+#endif // LOG_MEL_H
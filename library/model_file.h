@@ -0,0 +1,171 @@
+#ifndef MODEL_FILE_H
+#define MODEL_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+#include "esp_partition.h"
+#endif
+
+/**
+ * Model container, little-endian:
+ *
+ *   ModelFileHeader                 at 0
+ *   ModelTensorEntry[tensor_count]  at table_offset
+ *   tensor blobs                    each at a MODEL_FILE_ALIGN offset
+ *
+ * Offsets are from the start of the file. The flash partition and the
+ * host mmap both start on a page boundary, so every blob is 64-byte
+ * aligned in memory and can be handed to the DSP kernels in place.
+ */
+#define MODEL_FILE_MAGIC 0x464d5253u    // "SRMF"
+#define MODEL_FILE_VERSION 1
+#define MODEL_FILE_ALIGN 64
+#define MODEL_TENSOR_NAME_LEN 24
+#define MODEL_TENSOR_MAX_RANK 4
+
+// Data partition subtype for models (0x40-0xfe are free for applications)
+#define MODEL_PARTITION_SUBTYPE 0x40
+
+enum class ModelTensorType : uint8_t {
+    INT8,
+    INT16,
+    INT32,
+    FLOAT32,
+    INT8_GEMM_PACKED    // dims {n, k}, from dspm_gemm_s8_pack
+};
+
+struct ModelFileHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t header_bytes;          // sizeof(ModelFileHeader)
+    char arch[16];                  // Backend the weights are for, e.g. "whisper"
+    uint32_t tensor_count;
+    uint32_t table_offset;
+    uint32_t file_bytes;
+    uint32_t reserved[7];
+};
+
+struct ModelTensorEntry {
+    char name[MODEL_TENSOR_NAME_LEN];   // NUL terminated
+    ModelTensorType type;
+    uint8_t rank;
+    uint16_t flags;                 // Reserved, 0
+    uint32_t dims[MODEL_TENSOR_MAX_RANK];
+    uint32_t offset;
+    uint32_t bytes;
+    float scale;                    // Affine quantization, 1 and 0 for float
+    int32_t zero_point;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(ModelFileHeader) == 64, "ModelFileHeader layout");
+static_assert(sizeof(ModelTensorEntry) == 64, "ModelTensorEntry layout");
+
+// A tensor as used by a backend: data points into the mapping
+struct ModelTensor {
+    const char* name;
+    ModelTensorType type;
+    uint8_t rank;
+    uint32_t dims[MODEL_TENSOR_MAX_RANK];
+    const void* data;
+    size_t bytes;
+    float scale;
+    int32_t zero_point;
+};
+
+/**
+ * @class ModelFile
+ * @brief Read-only view of a model container, mapped rather than loaded
+ *
+ * On target open() maps a flash data partition through the MMU with
+ * esp_partition_mmap; on the host it mmaps a file. Either way nothing is
+ * copied: opening costs a header and table check, independent of the
+ * model size, and tensors are read from flash (through the cache) or the
+ * page cache in place, which leaves PSRAM for activations.
+ *
+ * Write the container to the partition with
+ *   esptool.py write_flash <model partition offset> model.bin
+ */
+class ModelFile {
+public:
+    ModelFile();
+    ~ModelFile();
+
+    ModelFile(const ModelFile&) = delete;
+    ModelFile& operator=(const ModelFile&) = delete;
+
+    /**
+     * Map a model
+     *
+     * @param source Partition label on target, file path on the host
+     * @return true if the container is valid
+     */
+    bool open(const char* source);
+
+    /**
+     * Use a container already in memory (e.g. embedded in the firmware);
+     * not owned, must be 16-byte aligned and outlive this object
+     */
+    bool openMemory(const void* data, size_t bytes);
+
+    void close();
+
+    bool isOpen() const { return base_ != nullptr; }
+    const char* arch() const;
+    uint32_t tensorCount() const;
+    size_t fileBytes() const;
+    const uint8_t* data() const { return base_; }
+    uint64_t openMicros() const { return open_us_; }
+
+    bool tensor(uint32_t index, ModelTensor* out) const;
+    bool find(const char* name, ModelTensor* out) const;
+
+private:
+    bool validate(const uint8_t* base, size_t bytes);
+    void unmap();
+
+    const uint8_t* base_;
+    size_t mapped_bytes_;
+    uint64_t open_us_;
+#ifdef ESP_PLATFORM
+    esp_partition_mmap_handle_t handle_;
+#endif
+    bool owns_mapping_;
+};
+
+/**
+ * @class ModelFileWriter
+ * @brief Builds containers offline (or in tests)
+ */
+class ModelFileWriter {
+public:
+    explicit ModelFileWriter(const char* arch);
+
+    bool add(const char* name, ModelTensorType type, const uint32_t* dims, uint8_t rank,
+             const void* data, float scale = 1.0f, int32_t zero_point = 0);
+
+    // Pack W[n][k] with dspm_gemm_s8_pack so the loader needs no packing step
+    bool addPackedGemm(const char* name, const int8_t* w, uint32_t n, uint32_t k,
+                       float scale = 1.0f, int32_t zero_point = 0);
+
+    std::vector<uint8_t> build() const;
+    bool write(const char* path) const;
+
+private:
+    struct Pending {
+        ModelTensorEntry entry;
+        std::vector<uint8_t> data;
+    };
+
+    std::string arch_;
+    std::vector<Pending> tensors_;
+};
+
+// Bytes a tensor of this type and shape occupies in a container
+size_t modelTensorBytes(ModelTensorType type, const uint32_t* dims, uint8_t rank);
+
+#endif // MODEL_FILE_H
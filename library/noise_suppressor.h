@@ -0,0 +1,203 @@
+#ifndef NOISE_SUPPRESSOR_H
+#define NOISE_SUPPRESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include "audio_frame_pool.h"
+#include "audio_platform.h"
+#include "dsps_fft.h"
+#include "pipeline_runtime.h"
+
+namespace audio_processing {
+
+/**
+ * @brief Arithmetic used by a NoiseSuppressor
+ */
+enum class NoiseSuppressorMode {
+    FLOAT,      // Float FFT and gains, for cores with an FPU
+    FIXED       // Q15 FFT with block floating point, integer gains
+};
+
+/**
+ * @struct NoiseSuppressorConfig
+ * @brief Frame, noise tracking and gain parameters for a NoiseSuppressor
+ */
+struct NoiseSuppressorConfig {
+    int sample_rate;                // Sample rate in Hz
+    size_t hop_samples;             // Hop H, a power of two; the window and FFT are 2H (50% overlap)
+    NoiseSuppressorMode mode;       // Float or fixed-point path
+    float min_gain_db;              // Gain floor; lower removes more noise but adds musical noise
+    float dd_smoothing;             // Decision-directed weight of the previous frame's clean estimate
+    float noise_smoothing;          // Noise spectrum smoothing per non-speech frame
+    float speech_ratio;             // Mean bin power over the noise estimate that marks a frame as speech
+    uint32_t init_frames;           // Leading frames averaged into the first noise estimate
+    uint32_t noise_refresh_frames;  // Speech run after which the noise estimate is relearned, 0 = never
+};
+
+/**
+ * Default suppressor: 8 ms hop, 16 ms window, 15 dB floor
+ *
+ * @param sample_rate Sample rate in Hz
+ * @return Suppressor configuration
+ */
+NoiseSuppressorConfig defaultNoiseSuppressorConfig(int sample_rate = 16000);
+
+/**
+ * @struct NoiseStats
+ * @brief Suppressor counters and cost
+ */
+struct NoiseStats {
+    uint64_t frames;                // Hops processed
+    uint64_t speech_frames;         // Hops classified as speech
+    uint64_t noise_updates;         // Hops the noise estimate was updated on
+    uint32_t noise_relearns;        // Initial averages restarted after a long speech run
+    uint32_t last_cycles;           // CPU cycles of the last hop
+    uint32_t max_cycles;
+    uint64_t total_cycles;
+    uint64_t process_us;            // Time spent in process()
+};
+
+/**
+ * @class NoiseSuppressor
+ * @brief Single-channel stationary noise suppression for the capture chain
+ *
+ * Short-time Fourier analysis with a square-root Hann window at 50%
+ * overlap: each hop, the last 2H samples are windowed and transformed, a
+ * Wiener gain is applied per bin, and the inverse is windowed again and
+ * overlap-added. The two square-root windows multiply to a Hann window,
+ * whose 50% overlaps sum to one, so unit gains reproduce the input
+ * delayed by H samples.
+ *
+ * The noise power spectrum starts as the average of the first
+ * init_frames hops, which are assumed to be background, and afterwards
+ * follows hops whose bins between 100 and 4000 Hz average less than
+ * speech_ratio times their estimate; bins well above the estimate are
+ * skipped even then. During speech it is held. Real speech pauses between
+ * words, so a run of noise_refresh_frames loud hops means the background
+ * got louder (a fan switched on) and restarts the initial average. The gain is G = S / (S + N) with the
+ * clean power S estimated decision-directed (Ephraim-Malah): a weighted
+ * sum of the previous hop's output power and the current excess over
+ * the noise, which smooths the gain over time and keeps musical noise
+ * down. Gains are floored at min_gain_db.
+ *
+ * In FIXED mode the frame is shifted up to use its headroom before a Q15
+ * FFT, powers are kept as integers with four fraction bits, and gains
+ * are Q15, so no float operation runs per bin.
+ *
+ * All buffers are allocated in init(); process() does no allocation. The
+ * stage form rewrites the frame in place and belongs after the echo
+ * canceller, which needs the raw microphone signal, and before VAD.
+ */
+class NoiseSuppressor {
+public:
+    NoiseSuppressor();
+    ~NoiseSuppressor();
+
+    NoiseSuppressor(const NoiseSuppressor&) = delete;
+    NoiseSuppressor& operator=(const NoiseSuppressor&) = delete;
+
+    /**
+     * Allocate the FFT and spectrum buffers
+     *
+     * @param config Suppressor configuration
+     * @param region Memory region for the buffers
+     * @return true if initialization was successful, false otherwise
+     */
+    bool init(const NoiseSuppressorConfig& config = defaultNoiseSuppressorConfig(),
+              MemoryRegion region = MemoryRegion::INTERNAL);
+
+    /**
+     * Free all buffers
+     */
+    void deinit();
+
+    bool isInitialized() const { return _input != nullptr; }
+
+    /**
+     * Suppress noise in a block of samples
+     *
+     * The output lags the input by latencySamples().
+     *
+     * @param in Input samples
+     * @param out Output samples; may be the same buffer as in
+     * @param count Number of samples, a multiple of hop_samples
+     * @return true if processed, false if not initialized or count is not
+     *         a multiple of hop_samples
+     */
+    bool process(const int16_t* in, int16_t* out, size_t count);
+
+    /**
+     * Suppress noise in one capture frame in place
+     *
+     * Silence markers and frames that are not a multiple of the hop pass
+     * through.
+     *
+     * @param frame Capture frame
+     * @return true to forward the frame
+     */
+    bool process(FrameRef& frame);
+
+    /**
+     * Stage function for PipelineRuntime::addStage
+     */
+    PipelineRuntime::StageFunction stageFunction();
+
+    /**
+     * Clear the noise estimate, overlap buffers and counters
+     */
+    void reset();
+
+    /**
+     * Counters, updated by the thread calling process()
+     */
+    const NoiseStats& stats() const { return _stats; }
+
+    const NoiseSuppressorConfig& config() const { return _config; }
+    size_t latencySamples() const { return _config.hop_samples; }
+    bool isSpeech() const { return _speech_run > 0; }
+
+private:
+    void processHop(const int16_t* in, int16_t* out);
+    int32_t noiseWeight(bool loud, bool* averaging);
+    void processFloat(int16_t* out);
+    void processFixed(int16_t* out);
+
+    NoiseSuppressorConfig _config;
+    size_t _bins;                   // H + 1 bins of the 2H FFT
+    size_t _band_low;               // Bins the speech decision sums over
+    size_t _band_high;
+
+    int16_t* _input;                // Last 2H input samples
+    uint16_t* _bitrev;
+
+    // Float path; only the buffers of the configured mode are allocated
+    float* _window;                 // Square-root Hann, 2H
+    float* _twiddle;
+    fft_plan_f32_t _plan;
+    float* _fft;                    // Scratch, 2H
+    float* _noise;                  // Noise power per bin
+    float* _clean;                  // Previous hop's output power per bin
+    float* _overlap;                // Second half of the last synthesis frame
+
+    // Fixed path; powers are |X / 2H|^2 with four fraction bits
+    int16_t* _window_q15;
+    int16_t* _twiddle_q15;
+    fft_plan_s16_t _plan_q15;
+    int16_t* _fft_q15;
+    uint32_t* _noise_q4;
+    uint32_t* _clean_q4;
+    int32_t* _overlap_q;
+    int32_t _min_gain_q15;
+    int32_t _dd_q15;
+    int32_t _noise_q15;
+    uint64_t _speech_ratio_q4;
+
+    float _min_gain;
+    uint32_t _frames_seen;          // Hops towards init_frames
+    uint32_t _speech_run;           // Consecutive speech hops
+    NoiseStats _stats;
+};
+
+} // namespace audio_processing
+
+#endif // NOISE_SUPPRESSOR_H
@@ -0,0 +1,193 @@
+#ifndef OUTPUT_FEEDER_H
+#define OUTPUT_FEEDER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "audio_platform.h"
+#include "pcm_ring.h"
+
+namespace audio_processing {
+
+/**
+ * @brief Trade-off between playback latency and underrun margin
+ */
+enum class LatencyProfile {
+    LOW_LATENCY,    // Prompts and barge-in; little margin for a late producer
+    BALANCED,
+    ROBUST          // Producer shares a core with heavy work (STT, Bluetooth)
+};
+
+/**
+ * @brief Buffer sizes behind one latency profile
+ */
+struct OutputProfile {
+    size_t dma_buffers;         // DMA descriptors queued in the I2S driver
+    size_t dma_frames;          // Samples per DMA buffer, also the feeder block
+    size_t ring_samples;        // Ring between producer and feeder
+    size_t start_samples;       // Buffered before playback starts or resumes
+};
+
+/**
+ * Buffer sizes for a latency profile
+ *
+ * @param profile Latency profile
+ * @return DMA and ring sizes
+ */
+OutputProfile outputProfile(LatencyProfile profile);
+
+/**
+ * Worst-case delay from a sample entering the ring to the DAC
+ *
+ * The DMA queue plus the start threshold: the feeder only writes once the
+ * threshold is buffered, and the driver plays out the whole queue first.
+ *
+ * @param profile Buffer sizes
+ * @param sample_rate Output sample rate
+ * @return Latency in microseconds
+ */
+uint32_t outputLatencyUs(const OutputProfile& profile, int sample_rate);
+
+struct OutputStats {
+    uint64_t blocks;            // Blocks handed to DMA
+    uint64_t samples;           // Audio samples played
+    uint64_t silence_samples;   // Zeros played, idle or not
+    uint32_t streams;           // Times playback started from idle
+    uint32_t underruns;         // Times the ring ran dry mid-stream
+    uint64_t underrun_samples;  // Zeros played inside streams
+    uint32_t flushes;
+    uint64_t reference_dropped; // Samples the echo reference ring had no room for
+};
+
+/**
+ * @class OutputFeeder
+ * @brief Ring and feeding policy between an audio producer and I2S DMA
+ *
+ * The producer (the synthesizer through a RingSink, the prompt cache)
+ * writes into the ring at its own pace; the output task calls fill() once
+ * per DMA buffer, paced by the I2S clock. fill() always returns a full
+ * block: what the ring holds, then zeros. The DMA never stalls and never
+ * replays stale buffers, so a late producer costs a gap of silence rather
+ * than a click loop or a blocked output task.
+ *
+ * Playback starts once start_samples are buffered, or earlier when the
+ * producer has called endStream() (a prompt shorter than the threshold).
+ * If the ring runs dry before endStream() that is an underrun: the rest
+ * of the block is silence and playback waits for start_samples again,
+ * so one late burst gives one gap instead of many short ones. Running dry
+ * after endStream() ends the stream cleanly.
+ *
+ * With setReference() every block handed to DMA, silence included, is
+ * also copied into a second ring: the far-end signal an echo canceller
+ * needs, in step with the DAC clock. When the output runs at another rate
+ * than the canceller (Piper plays at 22050 Hz, capture is 16 kHz) the tap
+ * is converted to the reference rate by linear interpolation on the way
+ * in, so the ring always advances at capture speed. There is no
+ * anti-aliasing filter; output content above the capture Nyquist folds
+ * down, at the level it already has in the speech models' output.
+ *
+ * fill(), flush() and the stats belong to the output task; write() and
+ * endStream() to the producer. Nothing takes a lock or allocates after
+ * init().
+ */
+class OutputFeeder {
+public:
+    OutputFeeder();
+    ~OutputFeeder();
+
+    OutputFeeder(const OutputFeeder&) = delete;
+    OutputFeeder& operator=(const OutputFeeder&) = delete;
+
+    /**
+     * Allocate the ring for a profile
+     *
+     * @param profile Buffer sizes
+     * @param region Memory region for the ring
+     * @return true if allocated, false otherwise
+     */
+    bool init(const OutputProfile& profile, MemoryRegion region = MemoryRegion::INTERNAL);
+
+    /**
+     * Free the ring (neither side may be using it)
+     */
+    void deinit();
+
+    /**
+     * Queue samples for playback (producer only)
+     *
+     * @param samples Samples to copy in
+     * @param count Number of samples
+     * @return Number of samples queued, less than count when the ring is full
+     */
+    size_t write(const int16_t* samples, size_t count) { return _ring.write(samples, count); }
+
+    /**
+     * Mark the end of the current stream (producer only)
+     *
+     * Call after the last write(); the feeder plays out what is buffered
+     * and goes idle without counting an underrun.
+     */
+    void endStream() { _end_requested.store(true, std::memory_order_release); }
+
+    /**
+     * Drop buffered audio at the next fill(), e.g. on barge-in
+     */
+    void flush() { _flush_requested.store(true, std::memory_order_release); }
+
+    /**
+     * Produce one DMA block (output task only)
+     *
+     * @param block Destination, always filled with count samples
+     * @param count Samples in the block
+     * @return Number of audio samples in the block; the rest is silence
+     */
+    size_t fill(int16_t* block, size_t count);
+
+    /**
+     * Copy every output block into a ring (set before the output task starts)
+     *
+     * @param reference Ring the echo canceller reads, or nullptr for none
+     * @param reference_rate Rate the ring is read at, normally the capture
+     *        rate; 0 copies blocks at the output rate unchanged
+     */
+    void setReference(PcmRing* reference, int reference_rate = 0);
+
+    /**
+     * Tell the reference tap the rate blocks are played at (any task)
+     *
+     * @param sample_rate Output sample rate
+     */
+    void setSampleRate(int sample_rate) { _sample_rate.store(sample_rate, std::memory_order_relaxed); }
+
+    PcmRing& ring() { return _ring; }
+    const OutputProfile& profile() const { return _profile; }
+    bool isPlaying() const { return _playing; }
+    const OutputStats& stats() const { return _stats; }
+
+private:
+    static const size_t TAP_CHUNK = 64;
+
+    size_t fillBlock(int16_t* block, size_t count);
+    void tapReference(const int16_t* block, size_t count);
+    void writeReference(const int16_t* samples, size_t count);
+
+    PcmRing _ring;
+    PcmRing* _reference;                // Echo reference tap, output task writes
+    int _reference_rate;                // 0 = tap at the output rate
+    std::atomic<int> _sample_rate;      // Output rate
+    int _tap_rate;                      // Output rate the step was computed for
+    uint64_t _tap_step;                 // Output samples per reference sample, Q32
+    uint64_t _tap_pos;                  // Next reference sample, Q32, from the previous block's last sample
+    int16_t _tap_prev;                  // Last output sample of the previous block
+    int16_t _tap_chunk[TAP_CHUNK];      // Converted samples on their way into the ring
+    OutputProfile _profile;
+    bool _playing;                      // Output task only
+    bool _rebuffering;                  // Waiting after an underrun
+    std::atomic<bool> _end_requested;
+    std::atomic<bool> _flush_requested;
+    OutputStats _stats;
+};
+
+} // namespace audio_processing
+
+#endif // OUTPUT_FEEDER_H
@@ -0,0 +1,92 @@
+#ifndef PCM_RING_H
+#define PCM_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "audio_platform.h"
+
+namespace audio_processing {
+
+/**
+ * @class PcmRing
+ * @brief Lock-free single-producer single-consumer ring of int16 samples
+ *
+ * Connects a task that produces audio in bursts (the synthesizer, a
+ * decoder) to one that consumes it at the playback rate. One task writes,
+ * one task reads; neither blocks or takes a lock, so the consumer can be
+ * a high-priority output task. write() and read() move as much as fits
+ * and return the count, leaving the waiting policy to the caller.
+ *
+ * Storage is allocated in init() with a power-of-two capacity; write()
+ * and read() never allocate.
+ */
+class PcmRing {
+public:
+    PcmRing();
+    ~PcmRing();
+
+    PcmRing(const PcmRing&) = delete;
+    PcmRing& operator=(const PcmRing&) = delete;
+
+    /**
+     * Allocate the ring
+     *
+     * @param capacity_samples Minimum capacity, rounded up to a power of two
+     * @param region Memory region for the samples
+     * @return true if allocated, false otherwise
+     */
+    bool init(size_t capacity_samples, MemoryRegion region = MemoryRegion::INTERNAL);
+
+    /**
+     * Free the ring (neither side may be using it)
+     */
+    void deinit();
+
+    /**
+     * Append samples (producer only)
+     *
+     * @param samples Samples to copy in
+     * @param count Number of samples
+     * @return Number of samples written, less than count when the ring fills
+     */
+    size_t write(const int16_t* samples, size_t count);
+
+    /**
+     * Take samples (consumer only)
+     *
+     * @param out Destination
+     * @param count Maximum number of samples
+     * @return Number of samples read, less than count when the ring runs dry
+     */
+    size_t read(int16_t* out, size_t count);
+
+    /**
+     * Drop everything buffered (consumer only)
+     *
+     * @return Number of samples dropped
+     */
+    size_t clear();
+
+    size_t available() const;
+    size_t space() const { return _capacity - available(); }
+    size_t capacity() const { return _capacity; }
+    bool isInitialized() const { return _buffer != nullptr; }
+
+    // Samples that have passed through each side since init()
+    uint64_t totalWritten() const { return _written.load(std::memory_order_relaxed); }
+    uint64_t totalRead() const { return _read.load(std::memory_order_relaxed); }
+
+private:
+    int16_t* _buffer;
+    size_t _capacity;
+    size_t _mask;
+    std::atomic<size_t> _head;            // Next write position, free-running
+    std::atomic<size_t> _tail;            // Next read position, free-running
+    std::atomic<uint64_t> _written;
+    std::atomic<uint64_t> _read;
+};
+
+} // namespace audio_processing
+
+#endif // PCM_RING_H
@@ -0,0 +1,117 @@
+#ifndef PDM_DECIMATOR_H
+#define PDM_DECIMATOR_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "audio_platform.h"
+
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
+
+namespace audio_processing {
+
+/**
+ * @class PDMDecimator
+ * @brief Table-driven PDM to PCM decimating FIR with optional dual-core split
+ *
+ * The lowpass is quantized to integers and folded into one 256-entry
+ * table per filter byte, so each output sample is a handful of integer
+ * table lookups. Integer accumulation makes the result independent of how
+ * a block is split, which is what lets decodeParallel() hand the second
+ * half of a block to the other core and still be bit-exact with decode().
+ *
+ * Bits are consumed LSB first, matching PDMProcessing.
+ */
+class PDMDecimator {
+public:
+    PDMDecimator();
+    ~PDMDecimator();
+
+    /**
+     * Build the filter tables
+     *
+     * @param decimation_factor PDM bits per PCM sample (multiple of 8)
+     * @param filter_taps Filter length in bits (multiple of 8, 0 = 2x decimation)
+     * @param worker_core Core for the helper task used by decodeParallel
+     * @return true if initialization was successful, false otherwise
+     */
+    bool init(int decimation_factor, int filter_taps = 0, int worker_core = 0);
+
+    /**
+     * Free tables and stop the helper task
+     */
+    void deinit();
+
+    /**
+     * Decode a PDM block on the calling core
+     *
+     * @param pdm_data PDM bytes
+     * @param pdm_size Number of bytes (multiple of decimation_factor / 8)
+     * @param pcm_data Output buffer
+     * @param pcm_samples In: capacity, out: samples written
+     * @return true if decoding was successful, false otherwise
+     */
+    bool decode(const uint8_t* pdm_data, size_t pdm_size, int16_t* pcm_data, size_t* pcm_samples);
+
+    /**
+     * Decode a PDM block split across both cores
+     *
+     * The second half is decoded by the helper task while the caller
+     * decodes the first half. Output is bit-exact with decode(). Blocks
+     * shorter than minParallelSamples() are decoded on the calling core.
+     */
+    bool decodeParallel(const uint8_t* pdm_data, size_t pdm_size, int16_t* pcm_data, size_t* pcm_samples);
+
+    /**
+     * Clear the filter history (start of a new stream)
+     */
+    void reset();
+
+    int decimationFactor() const { return _decimation_factor; }
+    int filterTaps() const { return _filter_bytes * 8; }
+    size_t minParallelSamples() const { return _min_parallel_samples; }
+    void setMinParallelSamples(size_t samples) { _min_parallel_samples = samples; }
+
+private:
+    // Number of fractional bits kept in the quantized coefficients
+    static const int COEFF_SHIFT = 8;
+
+    void decodeRange(const uint8_t* pdm_data, size_t first, size_t last, int16_t* pcm_data) const;
+    void updateHistory(const uint8_t* pdm_data, size_t pdm_size);
+    bool startWorker(int core);
+    void stopWorker();
+    static void workerEntry(void* arg);
+    void workerLoop();
+
+    bool _initialized;
+    int _decimation_factor;
+    size_t _bytes_per_sample;      // PDM bytes consumed per output sample
+    size_t _filter_bytes;          // Filter length in bytes
+    size_t _history_bytes;         // Input kept from the previous block
+    int32_t* _table;               // [_filter_bytes][256] partial sums
+    uint8_t* _history;             // Tail of the previous block
+    size_t _min_parallel_samples;
+
+    // Helper task state
+    std::mutex _job_mutex;
+    std::condition_variable _job_cv;
+    const uint8_t* _job_data;
+    size_t _job_first;
+    size_t _job_last;
+    int16_t* _job_output;
+    bool _job_pending;
+    bool _job_done;
+    std::atomic<bool> _worker_running;
+    std::atomic<bool> _worker_finished;
+#ifndef ESP_PLATFORM
+    std::thread _worker;
+#endif
+};
+
+} // namespace audio_processing
+
+#endif // PDM_DECIMATOR_H
@@ -4,16 +4,25 @@
 #include <Arduino.h>
 #include "dsps_fir.h"  // ESP-DSP FIR filter
 #include "dsps_conv.h" // ESP-DSP convolution
+#include "pdm_decimator.h"
 #include <vector>
 
 namespace audio_processing {
 
+// How convertPDMtoPCM turns PDM bits into PCM
+enum class PDMDecodeMode {
+    CHUNKED,             // Float FIR over 256-byte chunks
+    DECIMATOR,           // Table-driven decimator on the calling core
+    DECIMATOR_PARALLEL   // Decimator split across both cores (bit-exact with DECIMATOR)
+};
+
 class PDMProcessing {
 public:
     PDMProcessing();
     ~PDMProcessing();
 
     bool init(int sample_rate, int bit_depth);
+    // In decimator modes *pcm_samples must hold the output capacity on entry
     bool convertPDMtoPCM(const uint8_t* pdm_data, unsigned int pdm_size, 
                         int16_t* pcm_data, unsigned int* pcm_samples);
     bool convertPDMtoWAV(const uint8_t* pdm_data, unsigned int pdm_size, 
@@ -21,6 +30,10 @@ public:
     bool applyFilter(int16_t* pcm_data, unsigned int pcm_samples);
     void deinit();
 
+    // Select the decode path; decimator modes build their tables here
+    bool setDecodeMode(PDMDecodeMode mode);
+    PDMDecodeMode getDecodeMode() const { return _decode_mode; }
+
     // Add these methods to access internal buffers
     float* getPDMFloatBuffer() const { return _pdm_float_buffer; }
     float* getPCMFloatBuffer() const { return _pcm_float_buffer; }
@@ -38,6 +51,8 @@ private:
     float* _pcm_float_buffer; // Temporary buffer for float conversion
     int _filter_len;          // Length of the FIR filter
     int _decimation_factor;   // Decimation factor for PDM to PCM
+    PDMDecodeMode _decode_mode; // Active decode path
+    PDMDecimator _decimator;  // Table-driven decimator
     
     // Helper methods
     void pdmBitsToFloat(const uint8_t* pdm_data, unsigned int pdm_size, float* float_buffer);
@@ -0,0 +1,163 @@
+#ifndef PIPELINE_RUNTIME_H
+#define PIPELINE_RUNTIME_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "audio_frame_pool.h"
+
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
+
+namespace audio_processing {
+
+// Core assignment on the ESP32-S3: the radio and SD/SPI drivers live on
+// core 0, capture and DSP get core 1 to themselves.
+#define PIPELINE_CORE_IO   0
+#define PIPELINE_CORE_DSP  1
+
+/**
+ * @brief Well-known stage roles used to pick a default placement
+ */
+enum class StageRole {
+    CAPTURE,
+    PDM_CONVERSION,
+    VAD,
+    BLUETOOTH,
+    SD_STORAGE,
+    CUSTOM
+};
+
+/**
+ * @struct StageConfig
+ * @brief Placement and queueing parameters for one pipeline stage
+ */
+struct StageConfig {
+    const char* name;              // Task name
+    int core;                      // Core affinity (ignored on host)
+    int priority;                  // FreeRTOS priority (ignored on host)
+    uint32_t stack_size;           // Task stack in bytes
+    size_t queue_depth;            // Input queue depth in frames
+    BackpressurePolicy policy;     // Input queue backpressure policy
+};
+
+/**
+ * Default placement for a stage role
+ *
+ * Capture, PDM conversion and VAD run on PIPELINE_CORE_DSP; Bluetooth and
+ * SD storage run on PIPELINE_CORE_IO so blocking writes never stall DSP.
+ *
+ * @param role Stage role
+ * @param name Task name
+ * @return Stage configuration
+ */
+StageConfig defaultStageConfig(StageRole role, const char* name);
+
+/**
+ * @struct StageStats
+ * @brief Runtime metrics for one stage
+ */
+struct StageStats {
+    uint32_t frames_processed;     // Calls to the stage function
+    uint32_t frames_forwarded;     // Frames passed downstream
+    uint64_t busy_us;              // Time spent inside the stage function
+    uint64_t elapsed_us;           // Time since the pipeline started
+    float cpu_utilization;         // busy_us / elapsed_us in percent
+    ConsumerStats input;           // Input queue metrics (zero for sources)
+};
+
+/**
+ * @class PipelineRuntime
+ * @brief Runs declared stages as pinned tasks connected by bounded queues
+ *
+ * A stage function receives the input frame (empty for a source stage),
+ * may fill or replace it, and returns true to forward it downstream.
+ * Frames travel by reference through FrameFanout queues, so fan-out to
+ * several downstream stages costs no copies. On ESP32 every stage is a
+ * FreeRTOS task pinned to its core; the host build runs std::threads.
+ */
+class PipelineRuntime {
+public:
+    using StageFunction = std::function<bool(FrameRef& frame)>;
+
+    static const int MAX_STAGES = 8;
+
+    PipelineRuntime();
+    ~PipelineRuntime();
+
+    /**
+     * Declare a stage
+     *
+     * @param config Placement and queue parameters
+     * @param function Stage function
+     * @return Stage id, or -1 on failure
+     */
+    int addStage(const StageConfig& config, StageFunction function);
+
+    /**
+     * Connect the output of one stage to the input of another
+     *
+     * A stage has at most one input but may feed several stages.
+     *
+     * @return true if connected, false otherwise
+     */
+    bool connect(int from, int to);
+
+    /**
+     * Create the stage tasks
+     *
+     * @return true if every task was created, false otherwise
+     */
+    bool start();
+
+    /**
+     * Stop all stage tasks and drain their queues
+     */
+    void stop();
+
+    bool isRunning() const { return _running.load(); }
+
+    /**
+     * Get metrics for a stage
+     *
+     * @return true if the stage id is valid, false otherwise
+     */
+    bool getStageStats(int stage, StageStats* stats) const;
+
+    /**
+     * Print per-stage utilization and queue metrics
+     */
+    void printStats() const;
+
+private:
+    struct Stage {
+        StageConfig config;
+        StageFunction function;
+        FrameFanout output;                // Downstream queues
+        FrameFanout* input;                // Upstream output (nullptr for sources)
+        int input_consumer;
+        PipelineRuntime* runtime;
+        std::atomic<uint32_t> frames_processed;
+        std::atomic<uint32_t> frames_forwarded;
+        std::atomic<uint64_t> busy_us;
+        std::atomic<bool> finished;
+#ifdef ESP_PLATFORM
+        void* task;
+#else
+        std::thread thread;
+#endif
+    };
+
+    static void taskEntry(void* arg);
+    void runStage(Stage& stage);
+
+    Stage* _stages[MAX_STAGES];
+    int _stage_count;
+    std::atomic<bool> _running;
+    uint64_t _start_us;
+};
+
+} // namespace audio_processing
+
+#endif // PIPELINE_RUNTIME_H
@@ -0,0 +1,113 @@
+#ifndef PREROLL_BUFFER_H
+#define PREROLL_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include "audio_frame_pool.h"
+
+namespace audio_processing {
+
+/**
+ * @class PreRollBuffer
+ * @brief Keeps the last few hundred ms of captured frames for late triggers
+ *
+ * The capture path push()es every frame. The buffer holds references to
+ * the most recent frames, so the history lives in the frame pool's PSRAM
+ * storage and is never copied. When VAD or a wake word fires, trigger()
+ * publishes the history oldest-first to a FrameFanout, then forwards every
+ * later push() to the same fanout until stopLive(). History and live
+ * frames are ordered under one lock, so the consumer sees one unbroken
+ * stream.
+ *
+ * The frame ring is allocated in init(); push(), trigger() and
+ * takeHistory() never allocate. The frame pool must be sized for the
+ * pre-roll frames on top of the frames in flight, and the trigger
+ * consumer's queue must be deep enough for the burst.
+ */
+class PreRollBuffer {
+public:
+    PreRollBuffer();
+    ~PreRollBuffer();
+
+    PreRollBuffer(const PreRollBuffer&) = delete;
+    PreRollBuffer& operator=(const PreRollBuffer&) = delete;
+
+    /**
+     * Frames needed to cover a duration (rounded up)
+     *
+     * @param duration_ms Pre-roll length in ms, e.g. 300-1000
+     * @param sample_rate Sample rate in Hz
+     * @param frame_samples Samples per frame
+     * @return Frame count
+     */
+    static size_t framesFor(uint32_t duration_ms, int sample_rate, size_t frame_samples);
+
+    /**
+     * Allocate the frame ring
+     *
+     * @param frame_count Frames of history to keep
+     * @return true if allocated, false otherwise
+     */
+    bool init(size_t frame_count);
+
+    /**
+     * Release held frames and free the ring
+     */
+    void deinit();
+
+    /**
+     * Record a captured frame (evicts the oldest when full)
+     *
+     * While live, the frame is published to the trigger fanout instead.
+     */
+    void push(const FrameRef& frame);
+
+    /**
+     * Publish the history and switch to live forwarding
+     *
+     * @param fanout Destination for history and subsequent frames
+     * @return Number of history frames published
+     */
+    size_t trigger(FrameFanout& fanout);
+
+    /**
+     * Stop live forwarding and start collecting history again
+     */
+    void stopLive();
+
+    /**
+     * Move the history out without going live
+     *
+     * @param frames Receives the newest frames, oldest first
+     * @param max_frames Capacity of frames
+     * @return Number of frames written
+     */
+    size_t takeHistory(FrameRef* frames, size_t max_frames);
+
+    /**
+     * Drop the history
+     */
+    void clear();
+
+    bool isLive() const;
+    size_t size() const;
+    size_t capacity() const { return _capacity; }
+    size_t historySamples() const;
+    uint32_t evicted() const { return _evicted; }
+
+private:
+    void clearLocked();
+
+    FrameRef* _ring;              // Held frames (internal RAM, headers only)
+    size_t _capacity;
+    size_t _head;                 // Oldest frame
+    size_t _count;
+    FrameFanout* _live;           // Trigger destination while live
+    uint32_t _evicted;
+    mutable std::mutex _mutex;
+};
+
+} // namespace audio_processing
+
+#endif // PREROLL_BUFFER_H
@@ -0,0 +1,198 @@
+#ifndef PROMPT_CACHE_H
+#define PROMPT_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "synthesizer_backend.h"
+
+// IMA ADPCM block: the first sample and step index in a 4-byte header,
+// then two samples per byte
+#define PROMPT_BLOCK_BYTES 256
+#define PROMPT_BLOCK_SAMPLES 505
+
+struct PromptCacheConfig {
+    size_t psram_budget_bytes;      // Compressed audio held in PSRAM
+    size_t max_entries;             // PSRAM entries
+    size_t max_entry_samples;       // Longer utterances are not cached
+    const char* sd_directory;       // Spill tier; null for PSRAM only
+    size_t sd_budget_bytes;
+    size_t max_sd_entries;
+    uint32_t spill_min_hits;        // Cache hits before an evicted entry is worth writing out
+};
+
+// 512 KB and 64 entries in PSRAM, utterances up to 8 s at 22050 Hz, no
+// SD tier
+PromptCacheConfig defaultPromptCacheConfig();
+
+/**
+ * Key of one rendering of a prompt
+ *
+ * @param normalized Text as TextProcessor::normalize() writes it, so
+ *        "Listening..." and "listening." share an entry
+ * @param voice Voice the audio was rendered with
+ * @param sample_rate Output rate of the backend
+ */
+uint64_t promptKey(const char* normalized, size_t length, const TtsVoice& voice, int sample_rate);
+
+enum class PromptPlayback {
+    MISS,                           // Not cached; nothing was written
+    PLAYED,                         // All of it went out
+    STOPPED                         // Found, but out returned false
+};
+
+struct PromptCacheStats {
+    uint32_t lookups;
+    uint32_t hits;
+    uint32_t psram_hits;
+    uint32_t sd_hits;               // Read from the SD card and moved back to PSRAM
+    uint32_t inserts;
+    uint32_t rejected;              // Too long, or larger than the whole budget
+    uint32_t evictions;             // From PSRAM
+    uint32_t spills;                // Evictions written to the SD card
+    uint32_t sd_evictions;
+    uint32_t sd_errors;
+    uint64_t first_audio_us;        // Last hit: play() call to first samples handed out
+    uint64_t max_first_audio_us;
+    uint64_t total_first_audio_us;  // All hits, for the mean
+    size_t entries;
+    size_t bytes;                   // Compressed bytes in PSRAM
+    size_t sd_entries;
+    size_t sd_bytes;
+};
+
+/**
+ * @class PromptCache
+ * @brief Synthesized audio of repeated prompts, in PSRAM and on SD
+ *
+ * Devices say the same few dozen prompts over and over; each is rendered
+ * once and played from here afterwards. Audio is stored as IMA ADPCM,
+ * 4 bits per sample in blocks of PROMPT_BLOCK_SAMPLES, and play() decodes
+ * one block at a time straight into the caller's sink, so a hit starts
+ * playback after decoding 256 bytes rather than after synthesis.
+ *
+ * The PSRAM tier is an LRU bounded by psram_budget_bytes and max_entries.
+ * Entries evicted after at least spill_min_hits hits are written to
+ * sd_directory as one file per key, with its own LRU under
+ * sd_budget_bytes; one-off replies are dropped rather than wearing the
+ * card. An SD hit streams from the file while moving the entry back to
+ * PSRAM. init() rebuilds the SD index from the directory, so the second
+ * tier survives a reboot.
+ *
+ * New entries are recorded while they are synthesized: beginInsert(),
+ * append() per block of audio, then commitInsert() or abortInsert().
+ * Encoding goes to a staging buffer allocated by init(); play() and
+ * append() never allocate. Not thread-safe: meant to be used from the
+ * synthesizer's task.
+ */
+class PromptCache {
+public:
+    explicit PromptCache(const PromptCacheConfig& config = defaultPromptCacheConfig());
+    ~PromptCache();
+
+    PromptCache(const PromptCache&) = delete;
+    PromptCache& operator=(const PromptCache&) = delete;
+
+    /**
+     * Allocate the entry table and staging buffer, and index the SD tier
+     *
+     * Creates sd_directory if it does not exist. A missing or unwritable
+     * card leaves the cache working from PSRAM only.
+     */
+    bool init();
+    void deinit();
+    bool isInitialized() const { return !slots_.empty(); }
+
+    // Whether key is cached in either tier
+    bool contains(uint64_t key) const;
+
+    /**
+     * Play a cached prompt
+     *
+     * @param out Receives decoded audio a block at a time
+     */
+    PromptPlayback play(uint64_t key, const SynthesizerBackend::AudioFunction& out);
+
+    // Start recording a new entry; replaces a recording in progress
+    void beginInsert(uint64_t key);
+
+    /**
+     * Add audio to the entry being recorded
+     *
+     * @return false once the entry is longer than max_entry_samples; the
+     *         recording is dropped
+     */
+    bool append(const int16_t* samples, size_t count);
+
+    // Store the recording, evicting least recently used entries for room
+    bool commitInsert();
+    void abortInsert();
+    bool isRecording() const { return recording_; }
+
+    // Drop everything, including the SD files
+    void clear();
+
+    const PromptCacheConfig& config() const { return config_; }
+    const PromptCacheStats& stats() const { return stats_; }
+    float hitRate() const { return stats_.lookups ? (float)stats_.hits / (float)stats_.lookups : 0.0f; }
+
+private:
+    struct Slot {
+        uint64_t key;
+        uint8_t* data;              // ADPCM blocks, null when the slot is free
+        uint32_t bytes;
+        uint32_t samples;
+        uint32_t hits;
+        bool on_sd;                 // A copy is already on the card
+        int32_t prev;               // LRU list, most recent first
+        int32_t next;
+    };
+
+    struct SdSlot {
+        uint64_t key;
+        uint32_t bytes;             // File size
+        uint64_t last_use;          // 0 for files found by init()
+    };
+
+    int32_t findSlot(uint64_t key) const;
+    int32_t findSdSlot(uint64_t key) const;
+    void unlink(int32_t slot);
+    void pushFront(int32_t slot);
+    void evict(int32_t slot);
+    bool store(uint64_t key, uint8_t* data, uint32_t bytes, uint32_t samples, bool on_sd);
+    bool makeRoom(size_t bytes);
+    void spill(const Slot& slot);
+    void removeSdSlot(int32_t sd_slot);
+    void indexSdDirectory();
+    PromptPlayback playSd(int32_t sd_slot, const SynthesizerBackend::AudioFunction& out);
+    bool decodeBlock(const uint8_t* block, uint32_t samples, const SynthesizerBackend::AudioFunction& out);
+    void flushBlock();
+    bool sdPath(uint64_t key, char* path, size_t capacity) const;
+
+    PromptCacheConfig config_;
+    std::vector<Slot> slots_;
+    std::vector<SdSlot> sd_slots_;
+    int32_t lru_head_;
+    int32_t lru_tail_;
+    uint64_t clock_;                // Use counter for the SD tier
+    bool sd_ready_;
+    bool sd_pinned_;                // playSd() is promoting sd_pinned_key_
+    uint64_t sd_pinned_key_;
+
+    // Recording
+    bool recording_;
+    uint64_t record_key_;
+    uint8_t* staging_;
+    size_t staging_bytes_;
+    uint32_t record_samples_;
+    int16_t pending_[PROMPT_BLOCK_SAMPLES];     // Block being encoded
+    uint32_t pending_count_;
+    int encode_index_;              // Step index carried across blocks
+
+    uint64_t hit_start_us_;         // play() call, 0 once the first block is out
+    int16_t decoded_[PROMPT_BLOCK_SAMPLES];     // One block, for play()
+    uint8_t file_block_[PROMPT_BLOCK_BYTES];    // One block read from the card
+    PromptCacheStats stats_;
+};
+
+#endif // PROMPT_CACHE_H
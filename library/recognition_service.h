@@ -0,0 +1,209 @@
+#ifndef RECOGNITION_SERVICE_H
+#define RECOGNITION_SERVICE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+#include "audio_frame_pool.h"
+#include "endpointer.h"
+#include "pipeline_runtime.h"
+#include "speech_recognizer.h"
+
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
+
+struct RecognitionServiceConfig {
+    size_t queue_depth;              // Pending jobs, excluding the one running
+    size_t max_job_frames;           // FrameRefs held per utterance job
+    size_t feed_chunk_samples;       // Cancellation is checked between chunks
+    bool cancel_stale;               // A new job cancels everything before it
+    const char* name;                // Task name
+    int core;                        // Core affinity (ignored on host)
+    int priority;                    // FreeRTOS priority (ignored on host)
+    uint32_t stack_size;             // Task stack in bytes
+};
+
+// Worker on the I/O core: capture and DSP keep core 1 to themselves
+RecognitionServiceConfig defaultRecognitionServiceConfig();
+
+enum class RecognitionStatus {
+    DONE,
+    CANCELLED,
+    FAILED                           // The recognizer could not start a session
+};
+
+struct RecognitionResult {
+    uint32_t job_id;
+    RecognitionStatus status;
+    std::string text;                // Empty unless DONE
+    uint64_t queued_us;              // Submit to start
+    uint64_t run_us;                 // Start to result
+    uint64_t latency_us;             // Submit to result
+};
+
+struct RecognitionServiceStats {
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t cancelled;
+    uint32_t failed;
+    uint32_t rejected;               // Queue full, or too many cancellations unreported
+    uint32_t queue_depth;            // Pending now
+    uint32_t max_queue_depth;
+    uint64_t last_latency_us;        // Completed jobs only
+    uint64_t max_latency_us;
+    uint64_t total_latency_us;
+};
+
+/**
+ * @class RecognitionService
+ * @brief Runs a SpeechRecognizer on its own task behind a bounded job queue
+ *
+ * submit() returns as soon as the job is queued, so the caller's loop
+ * keeps servicing capture and BT while the worker decodes. Jobs take
+ * their audio by ownership transfer: a sample buffer is moved in, and an
+ * Endpointer utterance is held as FrameRefs, so no samples are copied.
+ * Results arrive through a callback, run on the worker task, or a future.
+ *
+ * With cancel_stale a new job cancels every older one: pending jobs are
+ * reported CANCELLED without running, and the running job stops at its
+ * next feed chunk. Cancelled jobs wait for the worker to report them in
+ * a list of queue_depth + 1 entries; a submit() or cancel() that would
+ * overflow it is refused, so neither allocates. The recognizer must not
+ * be used elsewhere while the service is running.
+ */
+class RecognitionService {
+public:
+    using ResultCallback = std::function<void(const RecognitionResult& result)>;
+
+    RecognitionService(SpeechRecognizer& recognizer, const RecognitionServiceConfig& config);
+    ~RecognitionService();
+
+    RecognitionService(const RecognitionService&) = delete;
+    RecognitionService& operator=(const RecognitionService&) = delete;
+
+    /**
+     * Preallocate the queue and start the worker task
+     */
+    bool start();
+
+    /**
+     * Stop the worker; jobs still queued complete as CANCELLED on the
+     * calling task
+     */
+    void stop();
+
+    bool isRunning() const { return running_.load(); }
+
+    /**
+     * Queue an utterance buffer, taking ownership of it
+     *
+     * @param audio Samples; moved from only if the job is accepted
+     * @param done Result callback (may be empty)
+     * @return Job id, or 0 if the queue is full or the service is stopped
+     */
+    uint32_t submit(std::vector<int16_t>&& audio, ResultCallback done);
+
+    /**
+     * Queue an Endpointer utterance by reference to its frames
+     */
+    uint32_t submit(const Utterance& utterance, ResultCallback done);
+
+    /**
+     * Queue an utterance buffer and get the result as a future; an
+     * invalid future means the job was rejected
+     */
+    std::future<RecognitionResult> submit(std::vector<int16_t>&& audio);
+
+    /**
+     * Cancel one job, pending or running
+     *
+     * @return true if the job was still pending or running, false if it
+     *         was unknown or the pending job could not be cancelled yet
+     */
+    bool cancel(uint32_t job_id);
+
+    // Cancel the running job and, oldest first, every pending job the
+    // cancelled list has room for
+    void cancelAll();
+
+    /**
+     * Wait until nothing is queued or running
+     *
+     * @return false on timeout
+     */
+    bool waitIdle(uint32_t timeout_ms);
+
+    void getStats(RecognitionServiceStats* stats) const;
+
+private:
+    struct Job {
+        uint32_t id;
+        std::vector<int16_t> audio;
+        std::vector<audio_processing::FrameRef> frames;
+        size_t frame_samples;        // Samples to take from frames
+        ResultCallback done;
+        uint64_t submit_us;
+    };
+
+    // A pending job cancelled before it ran: its audio is released at
+    // once and only the callback is kept for the worker to report
+    struct Cancelled {
+        uint32_t id;
+        ResultCallback done;
+        uint64_t submit_us;
+    };
+
+    static void taskEntry(void* arg);
+    void run();
+    Job* reserveLocked();
+    uint32_t commitLocked(Job& job, ResultCallback done);
+    void cancelPendingLocked(size_t index);
+    void cancelStaleLocked();
+    bool canCancelLocked(size_t count) const;
+    RecognitionStatus runJob(Job& job, std::string* text);
+    void report(const Job& job, RecognitionStatus status, const std::string& text, uint64_t start_us);
+    void reportCancelled(const Cancelled& cancelled);
+    static void clearJob(Job& job);
+
+    SpeechRecognizer& recognizer_;
+    RecognitionServiceConfig config_;
+    std::vector<Job> queue_;         // Ring of queue_depth slots
+    size_t head_;
+    size_t count_;
+    std::vector<Cancelled> cancelled_;   // Waiting to be reported, at most queue_depth + 1
+    std::vector<Cancelled> reporting_;   // Swapped with cancelled_ by the worker
+    Job current_;                    // Job the worker is running, id 0 when none
+    bool busy_;                      // Worker is running a job or reporting
+    std::atomic<bool> cancel_current_;
+    uint32_t next_id_;
+    mutable std::mutex mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::atomic<bool> running_;
+    std::atomic<bool> finished_;
+    RecognitionServiceStats stats_;
+#ifdef ESP_PLATFORM
+    void* task_;
+#else
+    std::thread thread_;
+#endif
+};
+
+// Endpointer dispatch that hands each utterance to the service
+inline Endpointer::DispatchFunction serviceDispatch(RecognitionService& service,
+                                                    RecognitionService::ResultCallback done) {
+    return [&service, done](const Utterance& utterance) {
+        if (service.submit(utterance, done) == 0) {
+            AUDIO_LOGF("Recognition queue full, utterance dropped\n");
+        }
+    };
+}
+
+#endif // RECOGNITION_SERVICE_H
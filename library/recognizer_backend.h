@@ -0,0 +1,92 @@
+#ifndef RECOGNIZER_BACKEND_H
+#define RECOGNIZER_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "log_mel.h"
+#include "model_file.h"
+
+// One recognition engine behind SpeechRecognizer. A session is begin(),
+// any number of feed() calls as audio arrives, then finish(). Backends
+// should do their front end and encoder work inside feed() so that
+// finish() only has to decode what is left.
+class RecognizerBackend {
+public:
+    virtual ~RecognizerBackend() {}
+
+    virtual const char* name() const = 0;
+
+    // model is mapped by SpeechRecognizer and outlives the backend's use of
+    // it; tensors are used in place. Null when no model was given.
+    virtual bool initialize(const ModelFile* model) { (void)model; return true; }
+
+    virtual bool begin() = 0;
+    virtual bool feed(const int16_t* samples, size_t count) = 0;
+
+    // Best hypothesis so far, may be empty
+    virtual std::string partial() = 0;
+
+    // Final transcription; ends the session
+    virtual std::string finish() = 0;
+};
+
+// Whisper stand-in. The log-mel front end runs in feed() as audio arrives;
+// Whisper decodes whole windows, so the features are transcribed in finish().
+// The feature buffer holds one 30 s window and is allocated by the first
+// begin(); audio past the window is dropped and feed() returns false.
+class WhisperBackend : public RecognizerBackend {
+public:
+    WhisperBackend();
+
+    const char* name() const override { return "whisper"; }
+    bool initialize(const ModelFile* model) override;
+    bool begin() override;
+    bool feed(const int16_t* samples, size_t count) override;
+    std::string partial() override { return std::string(); }
+    std::string finish() override;
+
+private:
+    std::string whisper_transcribe(const std::vector<float>& mel, size_t frames);
+
+    const ModelFile* model_;            // Weights, read in place
+    LogMelFrontEnd frontend_;
+    LogMelFrontEnd::FrameCallback collect_;
+    std::vector<float> mel_;           // frames x mel bins, row-major
+    size_t max_mel_values_;            // One window of features
+    bool window_full_;
+};
+
+// Deterministic host backend for latency and integration tests. Audio is
+// cut into fixed chunks as it arrives; each chunk runs a synthetic encoder
+// (encoder_passes multiply-add sweeps) and maps its zero-crossing rate to
+// a word. The transcript depends only on the samples, never on how they
+// were split across feed() calls.
+class HostRecognizerBackend : public RecognizerBackend {
+public:
+    HostRecognizerBackend(size_t chunk_samples = 1600, int encoder_passes = 8,
+                          float silence_energy = 1000.0f);
+
+    const char* name() const override { return "host"; }
+    bool begin() override;
+    bool feed(const int16_t* samples, size_t count) override;
+    std::string partial() override { return transcript_; }
+    std::string finish() override;
+
+    uint32_t chunksEncoded() const { return chunks_; }
+
+private:
+    void encodeChunk(size_t length);
+
+    std::vector<int16_t> chunk_;
+    size_t chunk_fill_;
+    int encoder_passes_;
+    float silence_energy_;
+    int last_word_;
+    uint32_t chunks_;
+    float encoder_state_;
+    std::string transcript_;
+};
+
+#endif // RECOGNIZER_BACKEND_H
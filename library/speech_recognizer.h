@@ -1,17 +1,56 @@
 #ifndef SPEECH_RECOGNIZER_H
 #define SPEECH_RECOGNIZER_H
 
+#include <cstdint>
 #include <string>
 #include <vector>
+#include "model_file.h"
+#include "recognizer_backend.h"
+
+struct RecognizerStats {
+    uint32_t sessions;
+    uint64_t samples_fed;        // Current or last session
+    uint64_t feed_us;            // Time spent in feed() this session
+    uint64_t last_finish_us;     // Time spent in finish(), i.e. after end of speech
+    uint64_t max_finish_us;
+    uint64_t init_us;            // initialize(), including mapping the model
+};
 
 class SpeechRecognizer {
 public:
     SpeechRecognizer();
-    bool initialize();
+
+    // Use another backend (not owned)
+    explicit SpeechRecognizer(RecognizerBackend* backend);
+
+    /**
+     * Map the model and hand it to the backend
+     *
+     * @param model_source Model partition label on target, container path
+     *        on the host; null for backends that need no weights
+     */
+    bool initialize(const char* model_source = nullptr);
+
+    // Streaming session
+    bool begin();
+    bool feed(const int16_t* samples, size_t count);
+    std::string partial();
+    std::string finish();
+
+    bool inSession() const { return in_session_; }
+    RecognizerBackend* backend() const { return backend_; }
+    const RecognizerStats& stats() const { return stats_; }
+    const ModelFile& model() const { return model_; }
+
+    // Whole utterance at once (one begin/feed/finish session)
     std::string recognizeSpeech(const std::vector<int16_t>& audio_data);
 
 private:
-    std::string whisper_transcribe(const std::vector<int16_t>& audio_data);
+    ModelFile model_;               // Before whisper_, so it is destroyed last
+    WhisperBackend whisper_;
+    RecognizerBackend* backend_;
+    bool in_session_;
+    RecognizerStats stats_;
 };
 
-#endif // SPEECH_RECOGNIZER_H
\ No newline at end of file
+#endif // SPEECH_RECOGNIZER_H
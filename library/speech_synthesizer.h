@@ -0,0 +1,156 @@
+#ifndef SPEECH_SYNTHESIZER_H
+#define SPEECH_SYNTHESIZER_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "audio_sink.h"
+#include "model_file.h"
+#include "prompt_cache.h"
+#include "synthesizer_backend.h"
+#include "text_processor.h"
+
+struct SynthesizerConfig {
+    size_t first_chunk_chars;       // The first chunk ends at the first phrase break past this
+    size_t max_chunk_chars;         // No chunk is longer
+};
+
+// First chunk at the first phrase break after 12 characters, then whole
+// sentences of up to 160 characters
+SynthesizerConfig defaultSynthesizerConfig();
+
+/**
+ * @class TextChunker
+ * @brief Cuts text into the pieces a synthesizer renders one at a time
+ *
+ * The first chunk is kept short, ending at the first phrase break (, ; :
+ * or sentence end) once first_chars are reached, because its length is
+ * the time to first audio. Later chunks are whole sentences, which is
+ * where prosody resets anyway. A sentence longer than max_chars is cut at
+ * its last phrase break, else its last space, within the limit.
+ * Punctuation only counts as a break before whitespace or the end, so
+ * "3.5" stays whole. Chunks point into the text; nothing is copied or
+ * allocated.
+ */
+class TextChunker {
+public:
+    TextChunker(const char* text, size_t length, const SynthesizerConfig& config);
+
+    /**
+     * Next chunk, trimmed of surrounding whitespace
+     *
+     * @return false when the text is used up
+     */
+    bool next(const char** chunk, size_t* length);
+
+private:
+    const char* text_;
+    size_t length_;
+    size_t pos_;
+    SynthesizerConfig config_;
+    bool first_;
+};
+
+struct SynthesisStats {
+    uint32_t utterances;
+    uint32_t chunks;                // Last utterance
+    uint64_t samples;               // Last utterance
+    uint64_t first_audio_us;        // Last utterance: synthesize() call to first samples in the sink
+    uint64_t max_first_audio_us;
+    uint64_t synth_us;              // Last utterance, excluding time blocked in the sink
+    uint64_t sink_us;               // Last utterance, time blocked in the sink
+    float rtf;                      // Last utterance: synth time / audio duration
+    uint32_t cancelled;
+    uint64_t init_us;               // initialize(), including mapping the model
+    bool from_cache;                // Last utterance was played from the prompt cache
+    uint32_t cache_hits;
+};
+
+/**
+ * @class SpeechSynthesizer
+ * @brief Streams synthesized speech into a sink chunk by chunk
+ *
+ * Text is cut by a TextChunker and each chunk goes to the backend in
+ * turn; its audio is written to the sink as soon as the backend hands it
+ * over. With a RingSink the playback task starts on the first chunk while
+ * the rest is still being synthesized, so the wait before speech is one
+ * short phrase rather than the whole reply. A real-time factor below 1
+ * keeps the ring from running dry after that.
+ *
+ * With a PromptCache attached, each utterance is keyed by its normalized
+ * text and the voice. A hit is played from the cache without touching
+ * the backend; a miss is recorded into the cache as it is synthesized.
+ *
+ * synthesize() runs in the caller's task. cancel() may be called from
+ * any task and stops it at the next block of audio. Each call is a job
+ * with its own number, and cancel() targets the job running when it is
+ * issued: a cancel() while idle is a no-op, so it never stops the next,
+ * unrelated prompt.
+ */
+class SpeechSynthesizer {
+public:
+    SpeechSynthesizer();
+
+    // Use another backend (not owned)
+    explicit SpeechSynthesizer(SynthesizerBackend* backend,
+                               const SynthesizerConfig& config = defaultSynthesizerConfig());
+
+    SpeechSynthesizer(const SpeechSynthesizer&) = delete;
+    SpeechSynthesizer& operator=(const SpeechSynthesizer&) = delete;
+
+    /**
+     * Map the model and hand it to the backend
+     *
+     * @param model_source Model partition label on target, container path
+     *        on the host; null for backends that need no weights
+     */
+    bool initialize(const char* model_source = nullptr);
+
+    /**
+     * Synthesize text into a sink
+     *
+     * Opens the sink at the backend's sample rate and closes it when done.
+     *
+     * @param text NUL-terminated UTF-8 text
+     * @return true if all of it was synthesized and written
+     */
+    bool synthesize(const char* text, AudioSink& sink);
+
+    // Play repeated utterances from cache (not owned; null to detach).
+    // The cache is initialized by the caller.
+    void setPromptCache(PromptCache* cache);
+    PromptCache* promptCache() const { return cache_; }
+
+    // Stop the synthesize() in progress, if any
+    void cancel() { cancelled_job_.store(job_.load()); }
+
+    void setVoice(const TtsVoice& voice) { voice_ = voice; }
+    const TtsVoice& voice() const { return voice_; }
+    int sampleRate() const { return backend_->sampleRate(); }
+    SynthesizerBackend* backend() const { return backend_; }
+    const SynthesisStats& stats() const { return stats_; }
+    const ModelFile& model() const { return model_; }
+
+private:
+    bool writeAudio(const int16_t* samples, size_t count);
+    bool isCancelled() const { return cancelled_job_.load() == job_.load(); }
+    bool promptKeyOf(const char* text, uint64_t* key);
+
+    ModelFile model_;               // Before piper_, so it is destroyed last
+    PiperBackend piper_;
+    SynthesizerBackend* backend_;
+    SynthesizerConfig config_;
+    TtsVoice voice_;
+    SynthesizerBackend::AudioFunction on_audio_;
+    AudioSink* sink_;               // During synthesize()
+    uint64_t start_us_;
+    std::atomic<uint32_t> job_;             // Number of the current or last synthesize()
+    std::atomic<uint32_t> cancelled_job_;   // Job the last cancel() targeted
+    PromptCache* cache_;
+    TextProcessor normalizer_;      // normalize() only, for cache keys
+    std::vector<char> key_text_;
+    SynthesisStats stats_;
+};
+
+#endif // SPEECH_SYNTHESIZER_H
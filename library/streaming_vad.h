@@ -0,0 +1,95 @@
+#ifndef STREAMING_VAD_H
+#define STREAMING_VAD_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief One per-hop decision from StreamingVAD
+ */
+struct VADDecision {
+    bool speech;            // Smoothed decision
+    bool raw_speech;        // Unsmoothed energy comparison
+    uint32_t energy;        // Mean square energy over the window
+    uint64_t end_sample;    // Stream position (exclusive) the decision refers to
+};
+
+/**
+ * @class StreamingVAD
+ * @brief Energy VAD over arbitrary-length sample spans
+ *
+ * Keeps a running integer sum of squares over a sliding window, so each
+ * sample costs one multiply-add and one subtract regardless of window
+ * size. A decision is emitted every hop, smoothed with attack (hops of
+ * speech needed to switch on) and hangover (hops of silence needed to
+ * switch off). The window is allocated once in the constructor; process()
+ * never allocates or copies the input.
+ */
+class StreamingVAD {
+public:
+    /**
+     * @param energy_threshold Mean square energy threshold (same units as VoiceActivityDetector)
+     * @param window_size Energy window in samples
+     * @param hop_size Samples between decisions
+     * @param attack_hops Consecutive speech hops before switching to speech
+     * @param hangover_hops Consecutive silence hops before switching to silence
+     */
+    StreamingVAD(float energy_threshold, int window_size, int hop_size,
+                 int attack_hops = 2, int hangover_hops = 8);
+    ~StreamingVAD();
+
+    StreamingVAD(const StreamingVAD&) = delete;
+    StreamingVAD& operator=(const StreamingVAD&) = delete;
+
+    /**
+     * Feed samples and collect the decisions for every completed hop
+     *
+     * @param samples Input samples
+     * @param count Number of samples, any length
+     * @param decisions Output array, may be nullptr to only track state
+     * @param max_decisions Capacity of the output array
+     * @return Number of decisions written
+     */
+    size_t process(const int16_t* samples, size_t count, VADDecision* decisions, size_t max_decisions);
+
+    /**
+     * Change the threshold without resetting the window
+     */
+    void setThreshold(float energy_threshold);
+
+    /**
+     * Current smoothed decision
+     */
+    bool isSpeech() const { return speech_; }
+
+    /**
+     * Mean square energy of the current window
+     */
+    uint32_t currentEnergy() const { return (uint32_t)(sum_squares_ / (uint64_t)window_size_); }
+
+    uint64_t samplesProcessed() const { return total_samples_; }
+    int hopSize() const { return hop_size_; }
+    int windowSize() const { return window_size_; }
+
+    /**
+     * Clear the window and smoothing state
+     */
+    void reset();
+
+private:
+    int16_t* window_;           // Ring of the last window_size_ samples
+    int window_size_;
+    int hop_size_;
+    int attack_hops_;
+    int hangover_hops_;
+    int window_pos_;
+    int hop_pos_;
+    uint64_t sum_squares_;      // Running sum of squares over the window
+    uint64_t threshold_sum_;    // Threshold scaled by window size
+    uint64_t total_samples_;
+    int speech_run_;
+    int silence_run_;
+    bool speech_;
+};
+
+#endif // STREAMING_VAD_H
@@ -0,0 +1,95 @@
+#ifndef SYNTHESIZER_BACKEND_H
+#define SYNTHESIZER_BACKEND_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "model_file.h"
+#include "text_processor.h"
+
+// Voice parameters, named as in Piper
+struct TtsVoice {
+    uint16_t speaker;           // Speaker id for multi-speaker models
+    float length_scale;         // Phoneme duration; above 1 is slower speech
+    float noise_scale;          // Generator noise
+    float noise_w;              // Phoneme duration noise
+};
+
+// Single speaker at the model's own pace
+TtsVoice defaultTtsVoice();
+
+// One synthesis engine behind SpeechSynthesizer. synthesize() is called
+// once per text chunk (a sentence or phrase) and hands audio to out as it
+// is produced; it may call out any number of times. out returning false
+// means stop: the caller was cancelled or the sink is gone.
+class SynthesizerBackend {
+public:
+    using AudioFunction = std::function<bool(const int16_t* samples, size_t count)>;
+
+    virtual ~SynthesizerBackend() {}
+
+    virtual const char* name() const = 0;
+
+    // model is mapped by SpeechSynthesizer and outlives the backend's use
+    // of it; tensors are used in place. Null when no model was given.
+    virtual bool initialize(const ModelFile* model) { (void)model; return true; }
+
+    // Output sample rate in Hz
+    virtual int sampleRate() const = 0;
+
+    // text is length bytes, not terminated
+    virtual bool synthesize(const char* text, size_t length, const TtsVoice& voice, const AudioFunction& out) = 0;
+};
+
+// Piper stand-in. Piper (VITS) generates a whole phrase in one pass, so
+// audio comes out per chunk and the chunk length is what bounds the time
+// to first audio. Its encoder takes phoneme ids: the text processor
+// looks words up in the model's lexicon when it carries one (lex.*) and
+// uses letter-to-sound rules otherwise.
+class PiperBackend : public SynthesizerBackend {
+public:
+    PiperBackend();
+
+    const char* name() const override { return "piper"; }
+    bool initialize(const ModelFile* model) override;
+    int sampleRate() const override { return sample_rate_; }
+    bool synthesize(const char* text, size_t length, const TtsVoice& voice, const AudioFunction& out) override;
+
+    const TextProcessor& textProcessor() const { return text_; }
+
+private:
+    bool piper_synthesize(const uint8_t* ids, size_t count, size_t length, const TtsVoice& voice,
+                          const AudioFunction& out);
+
+    const ModelFile* model_;            // Weights, read in place
+    int sample_rate_;
+    TextProcessor text_;
+    std::vector<uint8_t> ids_;          // Phonemes of one chunk
+};
+
+// Deterministic host backend for latency and integration tests. Like
+// Piper it renders a whole chunk before handing any of it out. Each
+// letter becomes a tone whose pitch depends on the letter and the
+// speaker, spaces and punctuation become pauses, and every output sample
+// costs synth_passes multiply-adds of synthetic model work.
+class HostSynthesizerBackend : public SynthesizerBackend {
+public:
+    HostSynthesizerBackend(int sample_rate = 16000, uint32_t ms_per_char = 60, int synth_passes = 16);
+
+    const char* name() const override { return "host"; }
+    int sampleRate() const override { return sample_rate_; }
+    bool synthesize(const char* text, size_t length, const TtsVoice& voice, const AudioFunction& out) override;
+
+    uint32_t chunksSynthesized() const { return chunks_; }
+
+private:
+    int sample_rate_;
+    uint32_t ms_per_char_;
+    int synth_passes_;
+    uint32_t chunks_;
+    float model_state_;
+    std::vector<int16_t> audio_;        // One chunk, reused
+};
+
+#endif // SYNTHESIZER_BACKEND_H
@@ -0,0 +1,201 @@
+#ifndef TEXT_PROCESSOR_H
+#define TEXT_PROCESSOR_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "model_file.h"
+
+/**
+ * Phoneme ids. 1..PHONEME_COUNT are the ARPAbet phonemes without stress
+ * (AA AE AH ... ZH, as in CMUdict), followed by three boundary ids. 0 is
+ * never produced.
+ */
+#define PHONEME_COUNT 39
+#define PHONEME_WORD_BREAK 40           // Between words
+#define PHONEME_PAUSE 41                // , ; :
+#define PHONEME_STOP 42                 // . ! ?
+
+// ARPAbet name of a phoneme id, "" for boundaries, null for invalid ids
+const char* phonemeName(uint8_t id);
+
+// Id of an ARPAbet name; a trailing stress digit is ignored. 0 if unknown.
+uint8_t phonemeId(const char* name, size_t length);
+
+/**
+ * Rule-based letter-to-sound for words missing from the lexicon
+ *
+ * @param word Lowercase letters and apostrophes
+ * @param length Bytes in word
+ * @param ids Receives phoneme ids
+ * @param capacity Capacity of ids
+ * @return Number of ids written
+ */
+size_t letterToSound(const char* word, size_t length, uint8_t* ids, size_t capacity);
+
+/**
+ * Lexicon container, three tensors in a ModelFile:
+ *
+ *   lex.info  INT32 {2}          words, longest pronunciation
+ *   lex.da    INT32 {states, 2}  double array: base, check per state
+ *   lex.pool  INT8  {bytes}      leaf entries
+ *
+ * Letters a-z map to codes 1-26 and the apostrophe to 27; code 0 ends a
+ * word. State s moves on code c to t = base[s] + c when check[t] == s.
+ * The root is state 0. A branch holding a single word ends early in a
+ * leaf whose base is -(entry + 1), an offset into the pool where the
+ * entry is
+ *
+ *   uint8 tail_length, the rest of the word, uint8 count, phoneme ids
+ *
+ * so a word costs about one state per letter it shares with others.
+ */
+#define LEXICON_CODE_COUNT 28
+
+struct LexiconInfo {
+    uint32_t words;
+    uint32_t states;
+    uint32_t max_phonemes;
+    size_t bytes;                   // In flash
+};
+
+/**
+ * @class Lexicon
+ * @brief Pronunciation dictionary read in place from a ModelFile
+ *
+ * A lookup walks one double-array state per letter, each a pair of
+ * int32 next to each other in flash, and ends comparing the leaf's tail.
+ * Nothing is copied into RAM and nothing is allocated.
+ */
+class Lexicon {
+public:
+    Lexicon();
+
+    // The model must outlive the lexicon; false if it has no lexicon
+    bool attach(const ModelFile& model);
+    void detach();
+    bool isAttached() const { return da_ != nullptr; }
+
+    /**
+     * Look up a word
+     *
+     * @param word Lowercase letters and apostrophes
+     * @param length Bytes in word
+     * @param phonemes Receives a pointer to the ids in the pool
+     * @param count Receives the number of ids
+     * @return true if the word is in the lexicon
+     */
+    bool lookup(const char* word, size_t length, const uint8_t** phonemes, size_t* count) const;
+
+    const LexiconInfo& info() const { return info_; }
+
+private:
+    const int32_t* da_;
+    const uint8_t* pool_;
+    size_t pool_bytes_;
+    LexiconInfo info_;
+};
+
+/**
+ * @class LexiconBuilder
+ * @brief Builds the lexicon tensors offline (or in tests)
+ */
+class LexiconBuilder {
+public:
+    /**
+     * Add a word
+     *
+     * @param word Letters and apostrophes, any case
+     * @param arpabet Space separated phonemes, e.g. "HH AH0 L OW1"
+     * @return false if the word or a phoneme is not representable; a
+     *         word added twice keeps its first pronunciation
+     */
+    bool add(const char* word, const char* arpabet);
+
+    // Add the lex.* tensors; false if the lexicon is empty
+    bool build(ModelFileWriter& writer);
+
+    size_t words() const { return entries_.size(); }
+
+private:
+    struct Entry {
+        std::string word;
+        std::vector<uint8_t> phonemes;
+    };
+
+    void place(int32_t state, size_t lo, size_t hi, size_t depth);
+    int32_t findBase(const int* codes, size_t count);
+    void grow(size_t states);
+
+    std::vector<Entry> entries_;
+    std::vector<int32_t> base_;
+    std::vector<int32_t> check_;
+    std::vector<uint8_t> pool_;
+    size_t first_free_;
+};
+
+struct TextProcessorStats {
+    uint32_t texts;
+    uint32_t words;                 // Phonemized
+    uint32_t lexicon_hits;
+    uint32_t lts_words;             // Letter-to-sound fallbacks
+    uint32_t truncated;             // Outputs cut short for capacity
+};
+
+/**
+ * @class TextProcessor
+ * @brief Normalizes text and turns it into phoneme ids
+ *
+ * normalize() rewrites what a speaker would read differently from its
+ * spelling: numbers ("1,250", "-3.5", "21st"), dates ("March 5, 2024",
+ * "2024-03-05", "3/5/2024"), times ("7:05 pm"), currency ("$3.50") and
+ * units after a number ("5 km", "20°C", "90%"). The result is lowercase
+ * words separated by single spaces, with , ; : . ! ? kept, and reads the
+ * same when normalized again. phonemize() looks every word up in the
+ * lexicon and falls back to letter-to-sound rules for misses.
+ *
+ * Output goes to caller buffers; process() uses one scratch buffer sized
+ * in the constructor. Nothing is allocated per text.
+ */
+class TextProcessor {
+public:
+    explicit TextProcessor(size_t max_text_bytes = 2048);
+
+    // Words are looked up in the model's lexicon from now on
+    bool attachLexicon(const ModelFile& model) { return lexicon_.attach(model); }
+    void detachLexicon() { lexicon_.detach(); }
+    const Lexicon& lexicon() const { return lexicon_; }
+
+    /**
+     * Normalize text
+     *
+     * @param text UTF-8 text
+     * @param length Bytes in text
+     * @param out Receives the normalized text, NUL terminated
+     * @param capacity Capacity of out; text that does not fit is dropped
+     *        at a word boundary
+     * @return Length of the normalized text
+     */
+    size_t normalize(const char* text, size_t length, char* out, size_t capacity);
+
+    /**
+     * Phonemes of normalized text
+     *
+     * @return Number of ids written; phonemes that do not fit are dropped
+     *         at a word boundary
+     */
+    size_t phonemize(const char* normalized, size_t length, uint8_t* ids, size_t capacity);
+
+    // normalize() then phonemize()
+    size_t process(const char* text, size_t length, uint8_t* ids, size_t capacity);
+
+    const TextProcessorStats& stats() const { return stats_; }
+
+private:
+    Lexicon lexicon_;
+    std::vector<char> scratch_;
+    TextProcessorStats stats_;
+};
+
+#endif // TEXT_PROCESSOR_H
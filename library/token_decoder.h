@@ -0,0 +1,254 @@
+#ifndef TOKEN_DECODER_H
+#define TOKEN_DECODER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "model_file.h"
+
+/**
+ * Decoder shape, stored in the model as the INT32 tensor "dec.hparams"
+ * (DECODER_HPARAMS_COUNT values in this order). Weights, all [rows][cols]
+ * INT8 (symmetric, per-tensor scale) or FLOAT32:
+ *
+ *   dec.tok_emb     [n_vocab][n_state]   also the output projection
+ *   dec.pos_emb     [n_ctx][n_state]
+ *   dec.ln          [2][n_state]         gamma, beta (FLOAT32)
+ *   dec.<l>.attn_ln, attn_q, attn_k, attn_v, attn_out
+ *   dec.<l>.xattn_ln, xattn_q, xattn_k, xattn_v, xattn_out
+ *                                        (only when n_audio_ctx > 0)
+ *   dec.<l>.mlp_ln, mlp_fc1 [n_mlp][n_state], mlp_fc2 [n_state][n_mlp]
+ *
+ * Any projection may have a FLOAT32 bias named "<projection>.b".
+ */
+struct DecoderHparams {
+    uint32_t n_vocab;
+    uint32_t n_ctx;                 // Maximum text context in tokens
+    uint32_t n_audio_ctx;           // Encoder frames for cross-attention, 0 for none
+    uint32_t n_state;
+    uint32_t n_head;
+    uint32_t n_layer;
+    uint32_t n_mlp;
+    int32_t token_sot;
+    int32_t token_eot;
+    int32_t token_no_timestamps;
+    int32_t token_timestamp_begin;  // This and every id above it is a timestamp
+};
+
+#define DECODER_HPARAMS_COUNT 11
+static_assert(sizeof(DecoderHparams) == DECODER_HPARAMS_COUNT * 4, "DecoderHparams layout");
+
+struct DecoderConfig {
+    uint32_t max_context;           // Tokens cached, 0 for the model's n_ctx
+    uint32_t max_audio_context;     // Encoder frames cached, 0 for the model's n_audio_ctx
+    uint32_t max_tokens;            // Generated per utterance, 0 to stop only at EOT or a full context
+    bool timestamps;                // Allow timestamp tokens
+    float timestamp_step_s;         // Seconds per timestamp token
+};
+
+DecoderConfig defaultDecoderConfig();
+
+enum class DecodeStop {
+    END_OF_TEXT,
+    MAX_TOKENS,
+    CONTEXT_FULL,
+    CALLER                          // The token callback returned false
+};
+
+struct DecodedToken {
+    int32_t id;
+    uint32_t index;                 // Position among the generated tokens
+    bool timestamp;
+    float time_s;                   // Timestamp tokens only
+    float logit;
+};
+
+struct DecoderStats {
+    uint32_t utterances;
+    uint32_t tokens;                // Generated, all utterances
+    uint32_t last_tokens;
+    uint64_t last_decode_us;        // Prompt and generation of the last utterance
+    float last_tokens_per_s;
+    size_t kv_bytes;                // Self and cross caches
+    size_t arena_bytes;             // Activation arena capacity
+    size_t peak_arena_bytes;        // Arena high-water mark since load()
+    size_t total_bytes;             // Everything load() allocated
+};
+
+/**
+ * @class ActivationArena
+ * @brief Bump allocator over a preallocated block
+ *
+ * alloc() hands out 16-byte aligned slices and reset() releases them all
+ * at once; mark() and rewind() scope scratch that only lives for one step.
+ * The high-water mark survives resets so the block can be sized from a
+ * real run.
+ */
+class ActivationArena {
+public:
+    ActivationArena() : base_(nullptr), capacity_(0), used_(0), peak_(0) {}
+
+    void attach(void* base, size_t bytes);
+
+    template <typename T>
+    T* alloc(size_t count) {
+        size_t bytes = (count * sizeof(T) + 15) & ~(size_t)15;
+        if (base_ == nullptr || bytes > capacity_ - used_) {
+            return nullptr;
+        }
+        T* slice = reinterpret_cast<T*>(base_ + used_);
+        used_ += bytes;
+        if (used_ > peak_) {
+            peak_ = used_;
+        }
+        return slice;
+    }
+
+    size_t mark() const { return used_; }
+    void rewind(size_t mark) { used_ = mark < used_ ? mark : used_; }
+    void reset() { used_ = 0; }
+
+    size_t used() const { return used_; }
+    size_t capacity() const { return capacity_; }
+    size_t peak() const { return peak_; }
+
+private:
+    uint8_t* base_;
+    size_t capacity_;
+    size_t used_;
+    size_t peak_;
+};
+
+/**
+ * @class TokenDecoder
+ * @brief Greedy transformer decoder with a fixed KV cache
+ *
+ * load() reads the shape from the model and allocates one block (PSRAM
+ * when present) holding the self-attention key/value cache for
+ * max_context tokens, the cross-attention cache for max_audio_context
+ * encoder frames, the token history and the activation arena. Nothing
+ * is allocated after that: begin() resets the arena and fills the cross
+ * cache, and each token costs one forward pass over the cached keys with
+ * its scratch rewound afterwards, so the arena peak does not depend on
+ * the utterance length.
+ *
+ * Weights are read in place from the mapped model. Activations are
+ * float; INT8 weights are dequantized with their tensor scale inside the
+ * dot products.
+ *
+ * Greedy selection suppresses the prompt tokens and, unless timestamps
+ * are enabled, every timestamp token. With timestamps the first token
+ * is a timestamp and timestamps never go backwards. Generation stops on
+ * end-of-text without running a pass for it.
+ */
+class TokenDecoder {
+public:
+    // Called as each token is chosen; return false to stop decoding
+    using TokenFunction = std::function<bool(const DecodedToken& token)>;
+
+    explicit TokenDecoder(const DecoderConfig& config = defaultDecoderConfig());
+    ~TokenDecoder();
+
+    TokenDecoder(const TokenDecoder&) = delete;
+    TokenDecoder& operator=(const TokenDecoder&) = delete;
+
+    /**
+     * Bind the weights and allocate the caches and arena
+     *
+     * @param model Mapped model; must outlive the decoder or unload()
+     * @return false if a tensor is missing or malformed, or out of memory
+     */
+    bool load(const ModelFile& model);
+    void unload();
+    bool isLoaded() const { return block_ != nullptr; }
+
+    /**
+     * Start an utterance
+     *
+     * @param audio Encoder output, frames x n_state, row-major; may be
+     *        null for models without cross-attention
+     * @param frames Encoder frames, at most max_audio_context
+     */
+    bool begin(const float* audio, size_t frames);
+
+    /**
+     * Decode greedily from the start-of-transcript prompt; call once
+     * per begin()
+     *
+     * @param token Called for each generated token (may be empty)
+     * @return Number of tokens generated
+     */
+    size_t decode(const TokenFunction& token);
+
+    // Prompt and generated tokens of the current utterance
+    const int32_t* tokens() const { return tokens_; }
+    size_t tokenCount() const { return count_; }
+
+    DecodeStop lastStop() const { return last_stop_; }
+    const DecoderHparams& hparams() const { return hparams_; }
+    const DecoderStats& stats() const { return stats_; }
+
+    // Bytes load() will allocate for a model and config
+    static size_t memoryBytes(const DecoderHparams& hparams, const DecoderConfig& config);
+
+private:
+    struct Matrix {
+        const void* data;
+        bool int8;
+        uint32_t rows;
+        uint32_t cols;
+        float scale;
+        const float* bias;
+    };
+
+    struct Layer {
+        const float* attn_ln;
+        Matrix attn_q, attn_k, attn_v, attn_out;
+        const float* xattn_ln;
+        Matrix xattn_q, xattn_k, xattn_v, xattn_out;
+        const float* mlp_ln;
+        Matrix mlp_fc1, mlp_fc2;
+    };
+
+    bool bindMatrix(const ModelFile& model, const char* name, uint32_t rows, uint32_t cols, Matrix* out);
+    bool bindNorm(const ModelFile& model, const char* name, const float** out);
+    void matvec(const Matrix& w, const float* x, float* y) const;
+    void rowOf(const Matrix& w, uint32_t row, float* y) const;
+    void layerNorm(const float* params, const float* x, float* y) const;
+    void attend(const float* q, const float* keys, const float* values, size_t count, float* scores, float* out) const;
+    void forward(int32_t token);
+    int32_t select(const float* logits, float* logit) const;
+
+    DecoderConfig config_;
+    DecoderHparams hparams_;
+    uint32_t max_context_;
+    uint32_t max_audio_context_;
+    Matrix tok_emb_;
+    Matrix pos_emb_;
+    const float* ln_;
+    std::vector<Layer> layers_;     // Sized once in load()
+
+    uint8_t* block_;
+    float* self_kv_;                // [layer][k|v][max_context][n_state]
+    float* cross_kv_;               // [layer][k|v][max_audio_context][n_state]
+    int32_t* tokens_;               // [max_context + 1]
+    float* logits_;                 // [n_vocab], from the arena per utterance
+    ActivationArena arena_;
+    size_t audio_frames_;
+    size_t position_;               // Tokens in the self-attention cache
+    size_t count_;                  // Tokens in tokens_
+    int32_t last_timestamp_;
+    DecodeStop last_stop_;
+    DecoderStats stats_;
+};
+
+/**
+ * Random test decoder for host runs: int8 weights from a fixed seed,
+ * FLOAT32 positional embedding. With eot_after > 0 the positional
+ * embedding makes end-of-text win after exactly that many generated tokens
+ * (no timestamps); 0 leaves it to chance.
+ */
+std::vector<uint8_t> buildDecoderTestModel(const DecoderHparams& hparams, uint32_t seed, uint32_t eot_after);
+
+#endif // TOKEN_DECODER_H
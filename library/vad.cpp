@@ -1,8 +1,13 @@
 #include "vad.h"
 #include <cmath>
+#include <cstring>
 
 VoiceActivityDetector::VoiceActivityDetector(float energy_threshold, int frame_size)
-    : energy_threshold_(energy_threshold), frame_size_(frame_size) {}
+    : energy_threshold_(energy_threshold), frame_size_(frame_size),
+      adaptive_(false), snr_linear_(1.0f), min_energy_(0.0f), last_energy_(0.0f),
+      mode_(VADMode::ENERGY), min_band_ratio_(1.0f), max_flatness_(0.5f) {
+    memset(&last_features_, 0, sizeof(last_features_));
+}
 
 bool VoiceActivityDetector::isSpeech(const std::vector<int16_t>& audio_frame) {
     if (audio_frame.size() != frame_size_) {
@@ -10,7 +15,68 @@ bool VoiceActivityDetector::isSpeech(const std::vector<int16_t>& audio_frame) {
     }
 
     float energy = calculateEnergy(audio_frame);
-    return energy > energy_threshold_;
+    last_energy_ = energy;
+
+    bool speech;
+    if (adaptive_ && noise_floor_.isCalibrated()) {
+        float threshold = noise_floor_.floor() * snr_linear_;
+        speech = energy > (threshold > min_energy_ ? threshold : min_energy_);
+    } else {
+        speech = energy > energy_threshold_;
+    }
+
+    // Only frames that pass the energy gate pay for the filter bank
+    if (speech && mode_ == VADMode::SPECTRAL) {
+        speech = isSpeechSpectrum(audio_frame);
+    }
+
+    if (adaptive_) {
+        noise_floor_.update(energy, speech);
+    }
+    return speech;
+}
+
+void VoiceActivityDetector::setMode(VADMode mode, int sample_rate) {
+    mode_ = mode;
+    if (mode == VADMode::SPECTRAL && sample_rate != analyzer_.sampleRate()) {
+        analyzer_.configure(sample_rate);
+    }
+}
+
+void VoiceActivityDetector::setSpectralThresholds(float min_band_ratio, float max_flatness) {
+    min_band_ratio_ = min_band_ratio;
+    max_flatness_ = max_flatness;
+}
+
+bool VoiceActivityDetector::isSpeechSpectrum(const std::vector<int16_t>& audio_frame) {
+    last_features_ = analyzer_.analyze(audio_frame.data(), audio_frame.size());
+    return last_features_.band_ratio > min_band_ratio_ && last_features_.flatness < max_flatness_;
+}
+
+void VoiceActivityDetector::enableAdaptiveThreshold(float snr_db, float min_energy) {
+    adaptive_ = true;
+    snr_linear_ = powf(10.0f, snr_db / 10.0f);
+    min_energy_ = min_energy;
+}
+
+void VoiceActivityDetector::disableAdaptiveThreshold() {
+    adaptive_ = false;
+}
+
+bool VoiceActivityDetector::loadCalibration(VADCalibrationStore& store) {
+    float floor = 0.0f;
+    if (!store.load(&floor)) {
+        return false;
+    }
+    noise_floor_.seed(floor);
+    return true;
+}
+
+bool VoiceActivityDetector::saveCalibration(VADCalibrationStore& store) {
+    if (!noise_floor_.isCalibrated()) {
+        return false;
+    }
+    return store.save(noise_floor_.floor());
 }
 
 float VoiceActivityDetector::calculateEnergy(const std::vector<int16_t>& audio_frame) {
@@ -19,4 +85,4 @@ float VoiceActivityDetector::calculateEnergy(const std::vector<int16_t>& audio_f
         energy += sample * sample;
     }
     return energy / frame_size_;
-} 
\ No newline at end of file
+}
\ No newline at end of file
@@ -3,6 +3,13 @@
 
 #include <vector>
 #include <cstdint>
+#include "vad_calibration.h"
+#include "band_energy.h"
+
+enum class VADMode {
+    ENERGY,     // Broadband energy only
+    SPECTRAL    // Energy gate plus speech-band ratio and flatness checks
+};
 
 class VoiceActivityDetector {
 public:
@@ -10,11 +17,44 @@ public:
 
     bool isSpeech(const std::vector<std::int16_t>& audio_frame);
 
+    // Adaptive mode: speech is a frame at least snr_db above the tracked
+    // noise floor (and above min_energy). The fixed threshold is used
+    // until the floor is calibrated.
+    void enableAdaptiveThreshold(float snr_db, float min_energy = 50.0f);
+    void disableAdaptiveThreshold();
+    bool isAdaptive() const { return adaptive_; }
+    bool isCalibrated() const { return noise_floor_.isCalibrated(); }
+    float noiseFloor() const { return noise_floor_.floor(); }
+    float lastEnergy() const { return last_energy_; }
+
+    // Spectral mode rejects loud frames whose energy is mostly outside
+    // 300-3000 Hz (fans, rumble) or flat across the speech bands (hiss,
+    // door slams). The energy/adaptive threshold still gates first.
+    void setMode(VADMode mode, int sample_rate = 16000);
+    VADMode mode() const { return mode_; }
+    void setSpectralThresholds(float min_band_ratio, float max_flatness);
+    const BandFeatures& lastFeatures() const { return last_features_; }
+
+    // Start calibrated from a floor learned on a previous boot
+    bool loadCalibration(VADCalibrationStore& store);
+    bool saveCalibration(VADCalibrationStore& store);
+
 private:
     float calculateEnergy(const std::vector<std::int16_t>& audio_frame);
+    bool isSpeechSpectrum(const std::vector<std::int16_t>& audio_frame);
 
     float energy_threshold_;
     int frame_size_;
+    bool adaptive_;
+    float snr_linear_;
+    float min_energy_;
+    float last_energy_;
+    NoiseFloorTracker noise_floor_;
+    VADMode mode_;
+    float min_band_ratio_;
+    float max_flatness_;
+    BandFeatures last_features_;
+    BandEnergyAnalyzer analyzer_;
 };
 
-#endif // VAD_H 
\ No newline at end of file
+#endif // VAD_H 
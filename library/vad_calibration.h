@@ -0,0 +1,100 @@
+#ifndef VAD_CALIBRATION_H
+#define VAD_CALIBRATION_H
+
+#include <cstdint>
+
+/**
+ * @class NoiseFloorTracker
+ * @brief Asymmetric EMA estimate of the background noise energy
+ *
+ * The floor falls quickly towards quieter frames and rises slowly on
+ * louder ones, so it follows the minimum of the energy envelope (HVAC,
+ * fans) without being dragged up by speech. Speech frames can only
+ * lower the floor; they never raise it.
+ */
+class NoiseFloorTracker {
+public:
+    /**
+     * @param rise_rate EMA rate when energy of a non-speech frame is above the floor
+     * @param fall_rate EMA rate when energy is below the floor
+     * @param calibration_frames Updates needed before the floor is trusted
+     */
+    NoiseFloorTracker(float rise_rate = 0.01f, float fall_rate = 0.2f, uint32_t calibration_frames = 50);
+
+    /**
+     * Feed the energy of one frame
+     *
+     * @param energy Mean square energy of the frame
+     * @param speech Whether the frame was classified as speech; speech
+     *               frames are skipped unless they are below the floor
+     */
+    void update(float energy, bool speech);
+
+    /**
+     * Start from a previously learned floor (e.g. loaded from NVS)
+     */
+    void seed(float floor);
+
+    void reset();
+
+    float floor() const { return floor_; }
+    bool isCalibrated() const { return frames_ >= calibration_frames_; }
+    uint32_t frames() const { return frames_; }
+
+private:
+    float rise_rate_;
+    float fall_rate_;
+    uint32_t calibration_frames_;
+    float floor_;
+    uint32_t frames_;
+};
+
+/**
+ * @class VADCalibrationStore
+ * @brief Persists the learned noise floor across boots
+ *
+ * Stored in NVS on target (namespace "vad") and in a small file on host.
+ * save() skips the write unless the floor moved by more than
+ * min_change_db since the last save, to limit flash wear.
+ */
+class VADCalibrationStore {
+public:
+    explicit VADCalibrationStore(const char* key = "noise_floor", float min_change_db = 1.0f);
+
+    /**
+     * Load a saved floor
+     *
+     * @param floor Receives the floor
+     * @return true if a valid calibration was found, false otherwise
+     */
+    bool load(float* floor);
+
+    /**
+     * Save the floor if it changed enough since the last save
+     *
+     * @return true if the floor was written, false if skipped or failed
+     */
+    bool save(float floor);
+
+    /**
+     * Remove the saved calibration
+     */
+    bool erase();
+
+    uint32_t writes() const { return writes_; }
+
+#ifndef ESP_PLATFORM
+    /**
+     * Directory for calibration files on host (default ".")
+     */
+    static void setHostDirectory(const char* dir);
+#endif
+
+private:
+    const char* key_;
+    float min_change_db_;
+    float last_saved_;
+    uint32_t writes_;
+};
+
+#endif // VAD_CALIBRATION_H
@@ -0,0 +1,134 @@
+#ifndef VAD_GATE_H
+#define VAD_GATE_H
+
+#include <atomic>
+#include <cstdint>
+#include "audio_frame_pool.h"
+#include "pipeline_runtime.h"
+#include "streaming_vad.h"
+
+namespace audio_processing {
+
+/**
+ * @brief What the gate sends downstream while the room is silent
+ */
+enum class SilencePolicy {
+    SKIP,      // Forward nothing
+    MARKER     // Forward a zero-length FRAME_FLAG_SILENCE frame so BT/SD can
+               // keep their timeline (comfort noise, WAV gap) without samples
+};
+
+/**
+ * @struct VADGateConfig
+ * @brief Detector and silence handling parameters for a VADGate
+ */
+struct VADGateConfig {
+    float energy_threshold;        // StreamingVAD mean square threshold
+    int window_size;               // Energy window in samples
+    int hop_size;                  // Samples between decisions
+    int attack_hops;               // Speech hops needed to open the gate
+    int hangover_hops;             // Silence hops needed to close the gate
+    SilencePolicy policy;          // Downstream output during silence
+    uint32_t marker_interval;      // Silent frames between repeated markers (0 = first only)
+};
+
+/**
+ * Default gate: 20 ms window, 10 ms hop, 300 ms hangover, markers once a second
+ *
+ * @param sample_rate Sample rate in Hz
+ * @param frame_samples Samples per frame, used to time the marker interval
+ * @return Gate configuration
+ */
+VADGateConfig defaultVADGateConfig(int sample_rate = 16000, size_t frame_samples = 512);
+
+/**
+ * @struct GateStats
+ * @brief Gate counters and the estimated downstream work avoided
+ */
+struct GateStats {
+    uint32_t frames_in;            // Frames seen by the gate
+    uint32_t frames_passed;        // Audio frames forwarded
+    uint32_t frames_skipped;       // Audio frames held back
+    uint32_t markers_sent;         // Silence markers forwarded
+    uint64_t gate_us;              // Time spent in the detector
+    uint64_t downstream_us;        // Busy time of the tracked stages
+    uint64_t saved_us;             // Estimated downstream time avoided
+    float skip_ratio;              // frames_skipped / frames_in
+};
+
+/**
+ * @class VADGate
+ * @brief Pipeline stage that only forwards frames while someone is talking
+ *
+ * Runs a StreamingVAD (one multiply-add per sample) right after PDM
+ * conversion, so the post filter, Bluetooth streaming, SD recording and
+ * STT behind it see nothing, or only sparse silence markers, during
+ * silence. Frames are never modified: markers come from a small private
+ * pool, so other consumers of the same frame are unaffected.
+ *
+ * CPU saved is estimated from the stages registered with
+ * trackDownstream(): their busy time per forwarded frame times the
+ * number of skipped frames.
+ */
+class VADGate {
+public:
+    static const int MAX_TRACKED = 4;
+    static const size_t MARKER_POOL_SIZE = 4;
+
+    explicit VADGate(const VADGateConfig& config);
+    ~VADGate();
+
+    VADGate(const VADGate&) = delete;
+    VADGate& operator=(const VADGate&) = delete;
+
+    /**
+     * Gate one frame
+     *
+     * @param frame Input frame; replaced by a silence marker when one is due
+     * @return true to forward the frame, false to drop it
+     */
+    bool process(FrameRef& frame);
+
+    /**
+     * Stage function for PipelineRuntime::addStage
+     */
+    PipelineRuntime::StageFunction stageFunction();
+
+    /**
+     * Count a downstream stage's busy time towards the CPU-saved estimate
+     *
+     * @return true if tracked, false if MAX_TRACKED stages are already tracked
+     */
+    bool trackDownstream(const PipelineRuntime* runtime, int stage);
+
+    void getStats(GateStats* stats) const;
+
+    bool isOpen() const { return _vad.isSpeech(); }
+
+    /**
+     * Clear detector state and counters
+     */
+    void reset();
+
+private:
+    struct Tracked {
+        const PipelineRuntime* runtime;
+        int stage;
+    };
+
+    VADGateConfig _config;
+    StreamingVAD _vad;
+    FramePool _markers;
+    uint32_t _silent_run;
+    Tracked _tracked[MAX_TRACKED];
+    int _tracked_count;
+    std::atomic<uint32_t> _frames_in;
+    std::atomic<uint32_t> _frames_passed;
+    std::atomic<uint32_t> _frames_skipped;
+    std::atomic<uint32_t> _markers_sent;
+    std::atomic<uint64_t> _gate_us;
+};
+
+} // namespace audio_processing
+
+#endif // VAD_GATE_H
@@ -0,0 +1,59 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+// Heap allocation counter for tests that check a path does not allocate.
+// Replaces the global operator new and delete, so include it from the test
+// file only, once per binary. Host only: on target the counters do not
+// exist and tests guard their use with #ifndef ARDUINO.
+//
+//     allocations.store(0);
+//     count_allocations = true;
+//     ...code under test...
+//     count_allocations = false;
+//     TEST_ASSERT_EQUAL(0, allocations.load());
+
+#ifndef ARDUINO
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+// Count heap allocations made by the calling thread while armed
+static thread_local bool count_allocations = false;
+static std::atomic<uint32_t> allocations(0);
+static std::atomic<uint64_t> allocated_bytes(0);
+
+void* operator new(std::size_t size) {
+    if (count_allocations) {
+        allocations++;
+        allocated_bytes += size;
+    }
+    void* p = std::malloc(size ? size : 1);
+    if (p == nullptr) {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    if (count_allocations) {
+        allocations++;
+        allocated_bytes += size;
+    }
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+#endif
+
+#endif // ALLOC_COUNTER_H
@@ -0,0 +1,273 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "../../library/audio_async.h"
+
+using namespace audio_processing;
+
+// Test instances
+FramePool* pool = nullptr;
+Executor* executor = nullptr;
+FrameChannel* audio = nullptr;
+AsyncSink* sd = nullptr;
+AsyncSink* bt = nullptr;
+AsyncEvent* btConnected = nullptr;
+
+// Test configuration constants
+const size_t TEST_FRAME_COUNT = 8;
+const size_t TEST_FRAME_SAMPLES = 160;
+const int TEST_FRAMES = 50;
+
+// Results written by the coroutines
+std::atomic<int> framesWritten(0);
+std::atomic<int> framesOutOfOrder(0);
+std::atomic<int> sdSamples(0);
+std::atomic<int> btFrames(0);
+uint64_t resumedAt = 0;
+
+void setUp(void) {
+    pool = new FramePool();
+    TEST_ASSERT_TRUE(pool->init(TEST_FRAME_COUNT, TEST_FRAME_SAMPLES));
+    executor = new Executor();
+    audio = new FrameChannel();
+    sd = new AsyncSink();
+    bt = new AsyncSink();
+    btConnected = new AsyncEvent();
+    framesWritten = 0;
+    framesOutOfOrder = 0;
+    sdSamples = 0;
+    btFrames = 0;
+    resumedAt = 0;
+}
+
+void tearDown(void) {
+    sd->end();
+    bt->end();
+    delete executor;
+    executor = nullptr;
+    delete audio;
+    audio = nullptr;
+    delete sd;
+    sd = nullptr;
+    delete bt;
+    bt = nullptr;
+    delete btConnected;
+    btConnected = nullptr;
+    delete pool;
+    pool = nullptr;
+}
+
+// Simulated capture: one frame per millisecond, then end of stream
+static void simulateCapture(int frames) {
+    for (int i = 0; i < frames; i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        FrameRef frame = pool->acquire();
+        if (!frame) {
+            continue;
+        }
+        frame->samples[0] = (int16_t)i;
+        frame->length = TEST_FRAME_SAMPLES;
+        audio->push(std::move(frame));
+    }
+    audio->close();
+}
+
+Task recordAndStream() {
+    int expected = 0;
+    while (true) {
+        FrameRef frame = co_await audio->nextFrame();
+        if (!frame) {
+            break;
+        }
+        if (frame.data()[0] < expected) {
+            framesOutOfOrder++;
+        }
+        expected = frame.data()[0] + 1;
+
+        bool sd_ok = co_await sd->write(frame);
+        bool bt_ok = co_await bt->write(frame);
+        if (sd_ok && bt_ok) {
+            framesWritten++;
+        }
+    }
+    executor->stop();
+}
+
+Task waitForConnection() {
+    co_await btConnected->wait();
+    resumedAt = audioMicros();
+    executor->stop();
+}
+
+Task sleepThenStop(uint32_t ms) {
+    co_await executor->sleepFor(ms);
+    resumedAt = audioMicros();
+    executor->stop();
+}
+
+Task receiveOneFrame() {
+    FrameRef frame = co_await audio->nextFrame();
+    if (frame) {
+        framesWritten++;
+    }
+}
+
+Task finishImmediately() {
+    co_return;
+}
+
+void test_capture_to_sinks() {
+    TEST_ASSERT_TRUE(sd->begin("sd", [](const FrameRef& frame) {
+        sdSamples += (int)frame.size();
+        return true;
+    }));
+    TEST_ASSERT_TRUE(bt->begin("bt", [](const FrameRef&) {
+        btFrames++;
+        return true;
+    }));
+
+    TEST_ASSERT_TRUE(executor->spawn(recordAndStream()));
+    std::thread capture(simulateCapture, TEST_FRAMES);
+    executor->run();
+    capture.join();
+
+    TEST_ASSERT_EQUAL(0, executor->liveTasks());
+    TEST_ASSERT_EQUAL(0, framesOutOfOrder.load());
+    TEST_ASSERT_EQUAL(framesWritten.load(), btFrames.load());
+    TEST_ASSERT_EQUAL(framesWritten.load() * (int)TEST_FRAME_SAMPLES, sdSamples.load());
+    TEST_ASSERT_GREATER_THAN(TEST_FRAMES / 2, framesWritten.load());
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+
+    // Each frame wakes the executor at most once per awaited event; a
+    // polling loop would wake thousands of times
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_FRAMES * 3 + 4, (int)executor->wakeups());
+}
+
+void test_event_wakes_waiter() {
+    TEST_ASSERT_TRUE(executor->spawn(waitForConnection()));
+
+    uint64_t set_at = 0;
+    std::thread connector([&set_at]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        set_at = audioMicros();
+        btConnected->set();
+    });
+    executor->run();
+    connector.join();
+
+    TEST_ASSERT_TRUE(resumedAt >= set_at);
+    TEST_ASSERT_LESS_OR_EQUAL(3, (int)executor->wakeups());
+}
+
+void test_sleep_costs_no_polling() {
+    uint64_t begin = audioMicros();
+    TEST_ASSERT_TRUE(executor->spawn(sleepThenStop(30)));
+    executor->run();
+
+    TEST_ASSERT_GREATER_OR_EQUAL(30000, (int)(resumedAt - begin));
+    TEST_ASSERT_LESS_OR_EQUAL(3, (int)executor->wakeups());
+}
+
+void test_run_once_without_work() {
+    TEST_ASSERT_EQUAL(0, executor->runOnce());
+
+    // Awaiting an already-set event does not suspend
+    btConnected->set();
+    TEST_ASSERT_TRUE(executor->spawn(waitForConnection()));
+    TEST_ASSERT_EQUAL(1, executor->runOnce());
+    TEST_ASSERT_EQUAL(0, executor->liveTasks());
+}
+
+void test_sink_write_fails_when_stopped() {
+    TEST_ASSERT_TRUE(executor->spawn(recordAndStream()));
+    std::thread capture(simulateCapture, 5);
+    executor->run();
+    capture.join();
+
+    // Sinks were never started, every write completes with false
+    TEST_ASSERT_EQUAL(0, framesWritten.load());
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+void test_full_ready_queue_keeps_waiter() {
+    // Suspend a reader on the channel; it holds a ready slot from here on
+    TEST_ASSERT_TRUE(executor->spawn(receiveOneFrame()));
+    TEST_ASSERT_EQUAL(1, executor->runOnce());
+    TEST_ASSERT_EQUAL(1, executor->liveTasks());
+
+    // Fill every remaining slot from another source
+    int spawned = 0;
+    while (executor->spawn(finishImmediately())) {
+        spawned++;
+    }
+    TEST_ASSERT_EQUAL(Executor::MAX_READY - 1, spawned);
+
+    // The wake-up still lands even though post() would now be refused
+    FrameRef frame = pool->acquire();
+    TEST_ASSERT_TRUE(frame);
+    frame->length = TEST_FRAME_SAMPLES;
+    audio->push(std::move(frame));
+
+    TEST_ASSERT_EQUAL(Executor::MAX_READY, executor->runOnce());
+    TEST_ASSERT_EQUAL(1, framesWritten.load());
+    TEST_ASSERT_EQUAL(0, executor->liveTasks());
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+void test_second_consumer_completes_empty() {
+    // The first reader suspends; the second finds it waiting and returns
+    TEST_ASSERT_TRUE(executor->spawn(receiveOneFrame()));
+    TEST_ASSERT_TRUE(executor->spawn(receiveOneFrame()));
+    TEST_ASSERT_EQUAL(2, executor->runOnce());
+    TEST_ASSERT_EQUAL(1, executor->liveTasks());
+    TEST_ASSERT_EQUAL(0, framesWritten.load());
+
+    // The first reader still gets the frame
+    FrameRef frame = pool->acquire();
+    TEST_ASSERT_TRUE(frame);
+    frame->length = TEST_FRAME_SAMPLES;
+    audio->push(std::move(frame));
+
+    TEST_ASSERT_EQUAL(1, executor->runOnce());
+    TEST_ASSERT_EQUAL(1, framesWritten.load());
+    TEST_ASSERT_EQUAL(0, executor->liveTasks());
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_capture_to_sinks);
+    RUN_TEST(test_event_wakes_waiter);
+    RUN_TEST(test_sleep_costs_no_polling);
+    RUN_TEST(test_run_once_without_work);
+    RUN_TEST(test_sink_write_fails_when_stopped);
+    RUN_TEST(test_full_ready_queue_keeps_waiter);
+    RUN_TEST(test_second_consumer_completes_empty);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Async Pipeline Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
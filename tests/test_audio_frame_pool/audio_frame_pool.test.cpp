@@ -0,0 +1,233 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <thread>
+#include <chrono>
+#include "../../library/audio_frame_pool.h"
+
+using namespace audio_processing;
+
+// Test instances
+FramePool* pool = nullptr;
+FrameFanout* fanout = nullptr;
+
+// Test configuration constants
+const size_t TEST_FRAME_COUNT = 4;
+const size_t TEST_FRAME_SAMPLES = 512;
+
+void setUp(void) {
+    pool = new FramePool();
+    fanout = new FrameFanout();
+    TEST_ASSERT_TRUE(pool->init(TEST_FRAME_COUNT, TEST_FRAME_SAMPLES, MemoryRegion::PSRAM));
+}
+
+void tearDown(void) {
+    // Fanout holds references into the pool, release those first
+    delete fanout;
+    fanout = nullptr;
+    delete pool;
+    pool = nullptr;
+}
+
+static FrameRef makeFrame(int16_t value) {
+    FrameRef frame = pool->acquire();
+    if (frame) {
+        for (size_t i = 0; i < frame->capacity; i++) {
+            frame->samples[i] = value;
+        }
+        frame->length = frame->capacity;
+    }
+    return frame;
+}
+
+void test_pool_exhaustion() {
+    FrameRef frames[TEST_FRAME_COUNT];
+    for (size_t i = 0; i < TEST_FRAME_COUNT; i++) {
+        frames[i] = pool->acquire();
+        TEST_ASSERT_TRUE((bool)frames[i]);
+    }
+    TEST_ASSERT_EQUAL(0, pool->available());
+
+    FrameRef extra = pool->acquire();
+    TEST_ASSERT_FALSE((bool)extra);
+    TEST_ASSERT_EQUAL(1, pool->exhaustedCount());
+
+    frames[0].reset();
+    TEST_ASSERT_EQUAL(1, pool->available());
+    extra = pool->acquire();
+    TEST_ASSERT_TRUE((bool)extra);
+}
+
+void test_frame_returns_after_last_consumer() {
+    int vad = fanout->addConsumer("vad", 4, BackpressurePolicy::DROP_NEWEST);
+    int sd = fanout->addConsumer("sd", 4, BackpressurePolicy::DROP_NEWEST);
+    int bt = fanout->addConsumer("bt", 4, BackpressurePolicy::DROP_NEWEST);
+
+    {
+        FrameRef frame = makeFrame(42);
+        TEST_ASSERT_EQUAL(3, fanout->publish(frame));
+    }
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT - 1, pool->available());
+
+    FrameRef a, b, c;
+    TEST_ASSERT_TRUE(fanout->receive(vad, a));
+    TEST_ASSERT_TRUE(fanout->receive(sd, b));
+    TEST_ASSERT_TRUE(fanout->receive(bt, c));
+
+    // Every consumer sees the same storage, nothing was copied
+    TEST_ASSERT_EQUAL_PTR(a.data(), b.data());
+    TEST_ASSERT_EQUAL_PTR(b.data(), c.data());
+    TEST_ASSERT_EQUAL(42, c.data()[TEST_FRAME_SAMPLES - 1]);
+
+    a.reset();
+    b.reset();
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT - 1, pool->available());
+    c.reset();
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+void test_drop_oldest_policy() {
+    int id = fanout->addConsumer("bt", 2, BackpressurePolicy::DROP_OLDEST);
+
+    for (int i = 1; i <= 3; i++) {
+        FrameRef frame = makeFrame(i);
+        TEST_ASSERT_EQUAL(1, fanout->publish(frame));
+    }
+
+    // Frame 1 was evicted and returned to the pool
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT - 2, pool->available());
+
+    FrameRef frame;
+    TEST_ASSERT_TRUE(fanout->receive(id, frame));
+    TEST_ASSERT_EQUAL(2, frame.data()[0]);
+    TEST_ASSERT_TRUE(fanout->receive(id, frame));
+    TEST_ASSERT_EQUAL(3, frame.data()[0]);
+
+    ConsumerStats stats;
+    TEST_ASSERT_TRUE(fanout->getStats(id, &stats));
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+    TEST_ASSERT_EQUAL(2, stats.consumed);
+}
+
+void test_drop_newest_policy() {
+    int id = fanout->addConsumer("sd", 2, BackpressurePolicy::DROP_NEWEST);
+
+    for (int i = 1; i <= 3; i++) {
+        FrameRef frame = makeFrame(i);
+        fanout->publish(frame);
+    }
+
+    FrameRef frame;
+    TEST_ASSERT_TRUE(fanout->receive(id, frame));
+    TEST_ASSERT_EQUAL(1, frame.data()[0]);
+    TEST_ASSERT_TRUE(fanout->receive(id, frame));
+    TEST_ASSERT_EQUAL(2, frame.data()[0]);
+    TEST_ASSERT_FALSE(fanout->receive(id, frame));
+
+    ConsumerStats stats;
+    TEST_ASSERT_TRUE(fanout->getStats(id, &stats));
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+}
+
+void test_block_policy() {
+    int id = fanout->addConsumer("stt", 1, BackpressurePolicy::BLOCK, 500);
+
+    FrameRef first = makeFrame(1);
+    TEST_ASSERT_EQUAL(1, fanout->publish(first));
+    first.reset();
+
+    std::thread reader([id]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        FrameRef frame;
+        fanout->receive(id, frame, 100);
+    });
+
+    // Queue is full, publish waits until the reader frees a slot
+    FrameRef second = makeFrame(2);
+    TEST_ASSERT_EQUAL(1, fanout->publish(second));
+    reader.join();
+
+    FrameRef frame;
+    TEST_ASSERT_TRUE(fanout->receive(id, frame));
+    TEST_ASSERT_EQUAL(2, frame.data()[0]);
+
+    ConsumerStats stats;
+    TEST_ASSERT_TRUE(fanout->getStats(id, &stats));
+    TEST_ASSERT_EQUAL(0, stats.dropped);
+}
+
+void test_block_policy_timeout() {
+    int id = fanout->addConsumer("stt", 1, BackpressurePolicy::BLOCK, 20);
+
+    FrameRef first = makeFrame(1);
+    FrameRef second = makeFrame(2);
+    TEST_ASSERT_EQUAL(1, fanout->publish(first));
+    TEST_ASSERT_EQUAL(0, fanout->publish(second));
+
+    ConsumerStats stats;
+    TEST_ASSERT_TRUE(fanout->getStats(id, &stats));
+    TEST_ASSERT_EQUAL(1, stats.dropped);
+}
+
+void test_consumer_lag_metrics() {
+    int fast = fanout->addConsumer("vad", 4, BackpressurePolicy::DROP_OLDEST);
+    int slow = fanout->addConsumer("bt", 4, BackpressurePolicy::DROP_OLDEST);
+
+    FrameRef frame;
+    for (int i = 0; i < 3; i++) {
+        FrameRef published = makeFrame(i);
+        fanout->publish(published);
+        published.reset();
+        TEST_ASSERT_TRUE(fanout->receive(fast, frame));
+        frame.reset();
+    }
+
+    ConsumerStats stats;
+    TEST_ASSERT_TRUE(fanout->getStats(fast, &stats));
+    TEST_ASSERT_EQUAL(0, stats.lag_frames);
+    TEST_ASSERT_EQUAL(0, stats.depth);
+
+    TEST_ASSERT_TRUE(fanout->getStats(slow, &stats));
+    TEST_ASSERT_EQUAL(3, stats.lag_frames);
+    TEST_ASSERT_EQUAL(3, stats.depth);
+    TEST_ASSERT_EQUAL(3, stats.max_lag_frames);
+
+    TEST_ASSERT_TRUE(fanout->receive(slow, frame));
+    TEST_ASSERT_TRUE(fanout->getStats(slow, &stats));
+    TEST_ASSERT_EQUAL(2, stats.lag_frames);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pool_exhaustion);
+    RUN_TEST(test_frame_returns_after_last_consumer);
+    RUN_TEST(test_drop_oldest_policy);
+    RUN_TEST(test_drop_newest_policy);
+    RUN_TEST(test_block_policy);
+    RUN_TEST(test_block_policy_timeout);
+    RUN_TEST(test_consumer_lag_metrics);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Frame Pool Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
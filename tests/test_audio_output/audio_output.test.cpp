@@ -0,0 +1,420 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <vector>
+#include "../../library/output_feeder.h"
+#include "../../library/speech_synthesizer.h"
+#include "../../library/audio_sink.h"
+#include "../../library/audio_platform.h"
+
+#ifndef ARDUINO
+#include <chrono>
+#include <thread>
+#endif
+
+using namespace audio_processing;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const int TEST_CLOCK_SPEEDUP = 8;               // Simulated DMA runs 8x real time
+const size_t TEST_STREAM_SAMPLES = 48000;       // 3 s of audio
+const int16_t TEST_RAMP_PERIOD = 20000;
+
+// Test instances
+OutputProfile small_profile = {2, 64, 1024, 256};
+
+// Sample i of a test stream: never zero, so silence is easy to tell apart
+int16_t rampSample(uint64_t i) {
+    return (int16_t)(i % TEST_RAMP_PERIOD + 1);
+}
+
+// Audio samples in order with nothing lost or repeated; zeros are skipped
+bool isContiguousRamp(const std::vector<int16_t>& out, uint64_t* audio_samples) {
+    uint64_t n = 0;
+    for (int16_t s : out) {
+        if (s == 0) {
+            continue;
+        }
+        if (s != rampSample(n)) {
+            return false;
+        }
+        n++;
+    }
+    *audio_samples = n;
+    return true;
+}
+
+size_t writeRamp(OutputFeeder& feeder, uint64_t* next, size_t count) {
+    int16_t samples[512];
+    size_t total = 0;
+    while (count > 0) {
+        size_t n = count < 512 ? count : 512;
+        for (size_t i = 0; i < n; i++) {
+            samples[i] = rampSample(*next + i);
+        }
+        size_t written = feeder.write(samples, n);
+        *next += written;
+        total += written;
+        count -= written;
+        if (written < n) {
+            break;
+        }
+    }
+    return total;
+}
+
+#ifndef ARDUINO
+// Stands in for the I2S driver: one fill() per DMA buffer period
+class SimulatedDma {
+public:
+    SimulatedDma(OutputFeeder& feeder, int sample_rate, int speedup)
+        : _feeder(feeder), _frames(feeder.profile().dma_frames), _stop(false), _blocks(0), _max_fill_us(0) {
+        _period = std::chrono::microseconds((int64_t)_frames * 1000000 / sample_rate / speedup);
+    }
+
+    void start() {
+        _stop.store(false);
+        _thread = std::thread([this]() { run(); });
+    }
+
+    void stop() {
+        _stop.store(true);
+        if (_thread.joinable()) {
+            _thread.join();
+        }
+    }
+
+    uint64_t blocks() const { return _blocks.load(); }
+    uint64_t maxFillUs() const { return _max_fill_us; }
+    std::chrono::microseconds period() const { return _period; }
+    std::vector<int16_t> output;
+
+private:
+    void run() {
+        std::vector<int16_t> block(_frames);
+        auto next = std::chrono::steady_clock::now();
+        while (!_stop.load()) {
+            uint64_t start = audioMicros();
+            _feeder.fill(block.data(), _frames);
+            uint64_t took = audioMicros() - start;
+            if (took > _max_fill_us) {
+                _max_fill_us = took;
+            }
+            output.insert(output.end(), block.begin(), block.end());
+            _blocks++;
+            next += _period;
+            std::this_thread::sleep_until(next);
+        }
+    }
+
+    OutputFeeder& _feeder;
+    size_t _frames;
+    std::chrono::microseconds _period;
+    std::atomic<bool> _stop;
+    std::atomic<uint64_t> _blocks;
+    uint64_t _max_fill_us;
+    std::thread _thread;
+};
+
+void waitUntilIdle(OutputFeeder& feeder, SimulatedDma& dma) {
+    // Idle once the ring is empty and one more block has gone out
+    while (feeder.ring().available() > 0) {
+        std::this_thread::sleep_for(dma.period());
+    }
+    uint64_t blocks = dma.blocks();
+    while (dma.blocks() < blocks + 2) {
+        std::this_thread::sleep_for(dma.period());
+    }
+}
+#endif
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_latency_profiles(void) {
+    OutputProfile low = outputProfile(LatencyProfile::LOW_LATENCY);
+    OutputProfile balanced = outputProfile(LatencyProfile::BALANCED);
+    OutputProfile robust = outputProfile(LatencyProfile::ROBUST);
+    uint32_t low_us = outputLatencyUs(low, TEST_SAMPLE_RATE);
+    uint32_t balanced_us = outputLatencyUs(balanced, TEST_SAMPLE_RATE);
+    uint32_t robust_us = outputLatencyUs(robust, TEST_SAMPLE_RATE);
+    AUDIO_LOGF("output latency at %d Hz: low %.1f ms, balanced %.1f ms, robust %.1f ms\n", TEST_SAMPLE_RATE,
+               low_us / 1000.0f, balanced_us / 1000.0f, robust_us / 1000.0f);
+
+    TEST_ASSERT_LESS_THAN(balanced_us, low_us);
+    TEST_ASSERT_LESS_THAN(robust_us, balanced_us);
+    TEST_ASSERT_LESS_THAN(50000, low_us);
+    TEST_ASSERT_EQUAL(40000, outputLatencyUs(low, 16000));      // 3 x 128 + 256 samples
+    TEST_ASSERT_EQUAL(0, outputLatencyUs(low, 0));
+    for (const OutputProfile& p : {low, balanced, robust}) {
+        // Room to reach the start threshold with a burst in flight
+        TEST_ASSERT_GREATER_OR_EQUAL(2 * p.start_samples, p.ring_samples);
+        TEST_ASSERT_GREATER_OR_EQUAL(p.dma_frames, p.start_samples);
+    }
+
+    OutputFeeder feeder;
+    OutputProfile bad = low;
+    bad.ring_samples = bad.dma_frames - 1;
+    TEST_ASSERT_FALSE(feeder.init(bad));
+    bad = low;
+    bad.start_samples = 100000;
+    TEST_ASSERT_TRUE(feeder.init(bad));
+    TEST_ASSERT_EQUAL(feeder.ring().capacity(), feeder.profile().start_samples);
+}
+
+void test_idle_output_is_silence(void) {
+    OutputFeeder feeder;
+    TEST_ASSERT_TRUE(feeder.init(small_profile));
+    int16_t block[64];
+    memset(block, 0x55, sizeof(block));
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    for (int16_t s : block) {
+        TEST_ASSERT_EQUAL(0, s);
+    }
+    TEST_ASSERT_EQUAL(1, feeder.stats().blocks);
+    TEST_ASSERT_EQUAL(64, feeder.stats().silence_samples);
+    TEST_ASSERT_EQUAL(0, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(0, feeder.stats().streams);
+    TEST_ASSERT_FALSE(feeder.isPlaying());
+}
+
+void test_start_threshold_and_end_of_stream(void) {
+    OutputFeeder feeder;
+    TEST_ASSERT_TRUE(feeder.init(small_profile));
+    int16_t block[64];
+    uint64_t next = 0;
+
+    // Below the threshold nothing plays yet
+    TEST_ASSERT_EQUAL(200, writeRamp(feeder, &next, 200));
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(200, feeder.ring().available());
+
+    // Reaching it starts the stream
+    writeRamp(feeder, &next, 100);
+    TEST_ASSERT_EQUAL(64, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(1, block[0]);
+    TEST_ASSERT_TRUE(feeder.isPlaying());
+    TEST_ASSERT_EQUAL(1, feeder.stats().streams);
+
+    // The last partial block after endStream() is not an underrun
+    feeder.endStream();
+    TEST_ASSERT_EQUAL(64, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(64, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(64, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(44, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(300, block[43]);
+    TEST_ASSERT_EQUAL(0, block[44]);
+    TEST_ASSERT_FALSE(feeder.isPlaying());
+    TEST_ASSERT_EQUAL(0, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(300, feeder.stats().samples);
+
+    // A prompt shorter than the threshold plays once it is complete
+    writeRamp(feeder, &next, 50);
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    feeder.endStream();
+    TEST_ASSERT_EQUAL(50, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(2, feeder.stats().streams);
+    TEST_ASSERT_EQUAL(0, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+
+    // An end with nothing buffered does not start the next stream early
+    feeder.endStream();
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    writeRamp(feeder, &next, 100);
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(0, feeder.stats().underruns);
+}
+
+void test_underrun_counts_once_and_rebuffers(void) {
+    OutputFeeder feeder;
+    TEST_ASSERT_TRUE(feeder.init(small_profile));
+    int16_t block[64];
+    uint64_t next = 0;
+    writeRamp(feeder, &next, 300);
+    for (int i = 0; i < 4; i++) {
+        TEST_ASSERT_EQUAL(64, feeder.fill(block, 64));
+    }
+
+    // Dry mid-stream: the rest of the block is silence
+    TEST_ASSERT_EQUAL(44, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(0, block[63]);
+    TEST_ASSERT_EQUAL(1, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(20, feeder.stats().underrun_samples);
+
+    // Still dry: one underrun, more silent samples
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(1, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(148, feeder.stats().underrun_samples);
+
+    // A trickle does not restart playback; the threshold does
+    writeRamp(feeder, &next, 100);
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    writeRamp(feeder, &next, 156);
+    TEST_ASSERT_EQUAL(64, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(301, block[0]);                   // Carries on where it stopped
+    TEST_ASSERT_EQUAL(1, feeder.stats().streams);       // Same stream
+    TEST_ASSERT_EQUAL(1, feeder.stats().underruns);
+
+    // Barge-in drops what is buffered and goes idle
+    feeder.flush();
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(0, feeder.ring().available());
+    TEST_ASSERT_EQUAL(1, feeder.stats().flushes);
+    TEST_ASSERT_EQUAL(1, feeder.stats().underruns);
+    uint64_t underrun_samples = feeder.stats().underrun_samples;
+    TEST_ASSERT_EQUAL(0, feeder.fill(block, 64));
+    TEST_ASSERT_EQUAL(underrun_samples, feeder.stats().underrun_samples);
+}
+
+#ifndef ARDUINO
+void test_simulated_dma_with_bursty_producer(void) {
+    OutputFeeder feeder;
+    TEST_ASSERT_TRUE(feeder.init(outputProfile(LatencyProfile::BALANCED)));
+    SimulatedDma dma(feeder, TEST_SAMPLE_RATE, TEST_CLOCK_SPEEDUP);
+    dma.output.reserve(4 * TEST_STREAM_SAMPLES);
+    dma.start();
+
+    // Bursts of 20-120 ms of audio at uneven intervals, faster than real
+    // time on average, waiting while the ring is full as a RingSink does
+    uint64_t next = 0;
+    uint32_t seed = 11;
+    const auto sample_us = std::chrono::microseconds(1000000 / TEST_SAMPLE_RATE / TEST_CLOCK_SPEEDUP);
+    while (next < TEST_STREAM_SAMPLES) {
+        seed = seed * 1664525u + 1013904223u;
+        size_t burst = 320 + (seed >> 8) % 1600;
+        if (burst > TEST_STREAM_SAMPLES - next) {
+            burst = TEST_STREAM_SAMPLES - next;
+        }
+        size_t written = 0;
+        while (written < burst) {
+            written += writeRamp(feeder, &next, burst - written);
+            if (written < burst) {
+                std::this_thread::sleep_for(dma.period());
+            }
+        }
+        std::this_thread::sleep_for(sample_us * (burst / 2));
+    }
+    feeder.endStream();
+    waitUntilIdle(feeder, dma);
+    dma.stop();
+
+    uint64_t audio = 0;
+    TEST_ASSERT_TRUE(isContiguousRamp(dma.output, &audio));
+    TEST_ASSERT_EQUAL(TEST_STREAM_SAMPLES, audio);
+    TEST_ASSERT_EQUAL(0, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(1, feeder.stats().streams);
+    TEST_ASSERT_EQUAL(dma.blocks() * feeder.profile().dma_frames, dma.output.size());
+    AUDIO_LOGF("bursty producer: %llu blocks, %u underruns, fill max %llu us\n",
+               (unsigned long long)dma.blocks(), (unsigned)feeder.stats().underruns,
+               (unsigned long long)dma.maxFillUs());
+}
+
+void test_simulated_dma_with_slow_producer(void) {
+    // A producer at 70% of real time: gaps of silence, no lost or repeated
+    // audio, and the DMA clock never waits for the producer
+    OutputFeeder feeder;
+    TEST_ASSERT_TRUE(feeder.init(outputProfile(LatencyProfile::LOW_LATENCY)));
+    SimulatedDma dma(feeder, TEST_SAMPLE_RATE, TEST_CLOCK_SPEEDUP);
+    dma.output.reserve(4 * TEST_STREAM_SAMPLES);
+    const size_t total = TEST_STREAM_SAMPLES / 4;
+    const size_t chunk = 160;
+    const auto chunk_period = std::chrono::microseconds(
+        (int64_t)chunk * 1000000 / TEST_SAMPLE_RATE / TEST_CLOCK_SPEEDUP * 10 / 7);
+
+    uint64_t start = audioMicros();
+    dma.start();
+    uint64_t next = 0;
+    auto due = std::chrono::steady_clock::now();
+    while (next < total) {
+        writeRamp(feeder, &next, chunk);
+        due += chunk_period;
+        std::this_thread::sleep_until(due);
+    }
+    feeder.endStream();
+    waitUntilIdle(feeder, dma);
+    dma.stop();
+    uint64_t elapsed_us = audioMicros() - start;
+
+    uint64_t audio = 0;
+    TEST_ASSERT_TRUE(isContiguousRamp(dma.output, &audio));
+    TEST_ASSERT_EQUAL(total, audio);
+    TEST_ASSERT_GREATER_THAN(0, feeder.stats().underruns);
+    TEST_ASSERT_GREATER_THAN(0, feeder.stats().underrun_samples);
+    // Blocks kept coming at the DMA rate throughout
+    uint64_t expected_blocks = elapsed_us / (uint64_t)dma.period().count();
+    TEST_ASSERT_GREATER_THAN(expected_blocks * 8 / 10, dma.blocks());
+    AUDIO_LOGF("slow producer: %u underruns, %.1f ms of gaps, %llu of ~%llu blocks\n",
+               (unsigned)feeder.stats().underruns,
+               feeder.stats().underrun_samples * 1000.0f / TEST_SAMPLE_RATE,
+               (unsigned long long)dma.blocks(), (unsigned long long)expected_blocks);
+}
+
+void test_synthesizer_plays_through_output(void) {
+    OutputFeeder feeder;
+    TEST_ASSERT_TRUE(feeder.init(outputProfile(LatencyProfile::BALANCED)));
+    SimulatedDma dma(feeder, TEST_SAMPLE_RATE, TEST_CLOCK_SPEEDUP);
+    dma.output.reserve(8 * TEST_STREAM_SAMPLES);
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE, 60, 16);
+    SpeechSynthesizer synthesizer(&backend);
+    TEST_ASSERT_TRUE(synthesizer.initialize());
+    RingSink sink(feeder.ring());
+
+    dma.start();
+    const char* text = "Sure, the kitchen timer is set for ten minutes. I will let you know when it is done.";
+    TEST_ASSERT_TRUE(synthesizer.synthesize(text, sink));
+    feeder.endStream();
+    waitUntilIdle(feeder, dma);
+    dma.stop();
+
+    TEST_ASSERT_EQUAL(synthesizer.stats().samples, feeder.stats().samples);
+    TEST_ASSERT_EQUAL(0, feeder.stats().underruns);
+    TEST_ASSERT_EQUAL(1, feeder.stats().streams);
+    TEST_ASSERT_GREATER_THAN(0, sink.stats().waits);    // The ring paced the synthesizer
+}
+#endif
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_latency_profiles);
+    RUN_TEST(test_idle_output_is_silence);
+    RUN_TEST(test_start_threshold_and_end_of_stream);
+    RUN_TEST(test_underrun_counts_once_and_rebuffers);
+#ifndef ARDUINO
+    RUN_TEST(test_simulated_dma_with_bursty_producer);
+    RUN_TEST(test_simulated_dma_with_slow_producer);
+    RUN_TEST(test_synthesizer_plays_through_output);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Audio Output Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
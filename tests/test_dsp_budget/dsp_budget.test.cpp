@@ -0,0 +1,193 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <thread>
+#include "../../library/esp-dsp/dsp_budget.h"
+#include "../../library/esp-dsp/dsps_fir.h"
+
+// Fake clock: every read advances time by a fixed step
+static uint32_t fake_now = 0;
+static uint32_t fake_step = 0;
+static uint32_t fake_yields = 0;
+
+static uint32_t fakeClock(void) {
+    fake_now += fake_step;
+    return fake_now;
+}
+
+static void fakeYield(void) {
+    fake_yields++;
+}
+
+// Test configuration constants
+const uint32_t TEST_TICKS_PER_US = 240;
+const int TEST_TAPS = 64;
+
+void setUp(void) {
+    fake_now = 0;
+    fake_step = 0;
+    fake_yields = 0;
+    dsp_budget_set_clock(fakeClock, TEST_TICKS_PER_US);
+    dsp_budget_set_yield(fakeYield);
+}
+
+void tearDown(void) {
+    dsp_budget_set_sleep_ticks(0);
+    dsp_budget_set_clock(NULL, 0);
+    dsp_budget_set_yield(NULL);
+}
+
+void test_no_yield_within_slice() {
+    dsp_budget_set_slice_us(1000);
+    fake_step = 0;
+    for (int i = 0; i < 100; i++) {
+        TEST_ASSERT_EQUAL(0, dsp_budget_poll());
+    }
+    TEST_ASSERT_EQUAL(0, fake_yields);
+    TEST_ASSERT_EQUAL(100, dsp_budget_current()->polls);
+}
+
+void test_yield_when_slice_exhausted() {
+    dsp_budget_set_slice_us(1000);
+
+    // 100 us per poll: the 10th poll crosses the 1 ms slice
+    fake_step = 100 * TEST_TICKS_PER_US;
+    int yielded_at = -1;
+    for (int i = 0; i < 20 && yielded_at < 0; i++) {
+        if (dsp_budget_poll()) {
+            yielded_at = i;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, fake_yields);
+    TEST_ASSERT_INT_WITHIN(1, 9, yielded_at);
+}
+
+void test_yield_rate_follows_slice() {
+    dsp_budget_set_slice_us(500);
+    fake_step = 10 * TEST_TICKS_PER_US;
+
+    // 10 ms of polling with a 0.5 ms slice, the yield itself costs one step
+    for (int i = 0; i < 1000; i++) {
+        dsp_budget_poll();
+    }
+    TEST_ASSERT_INT_WITHIN(2, 20, fake_yields);
+    TEST_ASSERT_EQUAL(fake_yields, dsp_budget_current()->yields);
+}
+
+void test_zero_slice_never_yields() {
+    dsp_budget_set_slice_us(0);
+    fake_step = 1000000;
+    for (int i = 0; i < 1000; i++) {
+        TEST_ASSERT_EQUAL(0, dsp_budget_poll());
+    }
+    TEST_ASSERT_EQUAL(0, fake_yields);
+}
+
+void test_clock_wraparound() {
+    dsp_budget_set_slice_us(1000);
+    fake_now = 0xFFFFFFFFu - 50 * TEST_TICKS_PER_US;
+    dsp_budget_restart();
+    fake_step = 100 * TEST_TICKS_PER_US;
+    for (int i = 0; i < 5; i++) {
+        TEST_ASSERT_EQUAL(0, dsp_budget_poll());
+    }
+    TEST_ASSERT_EQUAL(0, fake_yields);
+}
+
+void test_budget_is_per_task() {
+    dsp_budget_set_slice_us(0);
+    uint32_t other_slice = 1;
+
+    std::thread worker([&other_slice]() {
+        other_slice = dsp_budget_current()->slice_ticks;
+    });
+    worker.join();
+
+    TEST_ASSERT_EQUAL(0, dsp_budget_current()->slice_ticks);
+    TEST_ASSERT_EQUAL(DSP_BUDGET_DEFAULT_SLICE_US * TEST_TICKS_PER_US, other_slice);
+}
+
+void test_sleep_is_opt_in() {
+    // A task that never asked to sleep only yields
+    std::thread worker([]() {
+        TEST_ASSERT_EQUAL(0, dsp_budget_current()->sleep_ticks);
+    });
+    worker.join();
+
+    // Sleeping tasks block instead of calling the yield function
+    dsp_budget_set_slice_us(1000);
+    dsp_budget_set_sleep_ticks(1);
+    fake_step = 600 * TEST_TICKS_PER_US;
+    TEST_ASSERT_EQUAL(0, dsp_budget_poll());
+    TEST_ASSERT_EQUAL(1, dsp_budget_poll());
+    TEST_ASSERT_EQUAL(0, fake_yields);
+    TEST_ASSERT_EQUAL(1, dsp_budget_current()->yields);
+
+    dsp_budget_set_sleep_ticks(0);
+    TEST_ASSERT_EQUAL(0, dsp_budget_poll());
+    TEST_ASSERT_EQUAL(1, dsp_budget_poll());
+    TEST_ASSERT_EQUAL(1, fake_yields);
+}
+
+void test_fir_yields_only_on_budget() {
+    float coeffs[TEST_TAPS];
+    float delay_line[TEST_TAPS];
+    float input[1024];
+    float output[1024];
+    for (int i = 0; i < TEST_TAPS; i++) {
+        coeffs[i] = 1.0f / TEST_TAPS;
+    }
+    for (int i = 0; i < 1024; i++) {
+        input[i] = (i & 1) ? 1.0f : -1.0f;
+    }
+    fir_f32_t fir;
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_fir_init_f32(&fir, coeffs, delay_line, TEST_TAPS));
+
+    // Fast clock: 1024 samples fit in one slice, no yields at all
+    dsp_budget_set_slice_us(2000);
+    fake_step = 1 * TEST_TICKS_PER_US;
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_fir_f32(&fir, input, output, 1024));
+    TEST_ASSERT_EQUAL(0, fake_yields);
+
+    // Slow clock: each 32-sample chunk "takes" 500 us, yield every 4 chunks
+    dsp_budget_set_slice_us(2000);
+    fake_step = 500 * TEST_TICKS_PER_US;
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_fir_f32(&fir, input, output, 1024));
+    TEST_ASSERT_INT_WITHIN(2, 1024 / 32 / 4, fake_yields);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_no_yield_within_slice);
+    RUN_TEST(test_yield_when_slice_exhausted);
+    RUN_TEST(test_yield_rate_follows_slice);
+    RUN_TEST(test_zero_slice_never_yields);
+    RUN_TEST(test_clock_wraparound);
+    RUN_TEST(test_budget_is_per_task);
+    RUN_TEST(test_sleep_is_opt_in);
+    RUN_TEST(test_fir_yields_only_on_budget);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting DSP Budget Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
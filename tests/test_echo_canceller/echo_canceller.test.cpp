@@ -0,0 +1,486 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <vector>
+#include "../../library/echo_canceller.h"
+#include "../../library/output_feeder.h"
+#include "../alloc_counter.h"
+#include "../test_signals.h"
+
+using namespace audio_processing;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_ECHO_TAPS = 640;                  // 40 ms room response
+const float TEST_ECHO_GAIN = 0.5f;                  // Speaker to mic coupling, about -6 dB
+const float TEST_FAR_RMS = 3000.0f;
+const float TEST_NOISE_RMS = 3.0f;                  // Mic self-noise, ~54 dB below the echo
+const float TEST_MIN_ERLE_DB = 20.0f;
+const float TEST_MIN_DOUBLE_TALK_ERLE_DB = 30.0f;
+const float TEST_MIN_RECOVERED_ERLE_DB = 15.0f;
+const size_t TEST_FRAME_SAMPLES = 512;
+
+// Test instances
+EchoCanceller* aec = nullptr;
+
+// Exponentially decaying random room response
+static std::vector<float> echoPath(uint32_t seed, float gain) {
+    std::vector<float> h(TEST_ECHO_TAPS);
+    double sum = 0.0;
+    for (size_t i = 0; i < h.size(); i++) {
+        h[i] = uniformNoise(seed) * expf(-(float)i / (0.008f * TEST_SAMPLE_RATE));
+        sum += (double)h[i] * h[i];
+    }
+    float scale = gain / sqrtf((float)sum);
+    for (float& v : h) {
+        v *= scale;
+    }
+    return h;
+}
+
+// Echo of far delayed by delay samples through h, starting at sample begin
+static void addEcho(std::vector<float>& mic, const std::vector<float>& far, const std::vector<float>& h,
+                    size_t delay, size_t begin, size_t end) {
+    for (size_t i = begin; i < end; i++) {
+        double acc = 0.0;
+        for (size_t k = 0; k < h.size() && k + delay <= i; k++) {
+            acc += h[k] * far[i - delay - k];
+        }
+        mic[i] += (float)acc;
+    }
+}
+
+static std::vector<float> micNoise(size_t count, uint32_t seed) {
+    std::vector<float> mic(count);
+    for (float& v : mic) {
+        v = TEST_NOISE_RMS * 1.732f * uniformNoise(seed);
+    }
+    return mic;
+}
+
+// Energy ratio of a over b in dB over [begin, end)
+static float ratioDb(const std::vector<float>& a, const std::vector<float>& b, size_t begin, size_t end) {
+    double ea = 1.0, eb = 1.0;
+    for (size_t i = begin; i < end; i++) {
+        ea += (double)a[i] * a[i];
+        eb += (double)b[i] * b[i];
+    }
+    return (float)(10.0 * log10(ea / eb));
+}
+
+static std::vector<float> toFloat(const std::vector<int16_t>& x) {
+    return std::vector<float>(x.begin(), x.end());
+}
+
+static std::vector<float> runCanceller(EchoCanceller& canceller, const std::vector<float>& mic,
+                                       const std::vector<float>& far) {
+    std::vector<int16_t> near_pcm = toPcm(mic);
+    std::vector<int16_t> far_pcm = toPcm(far);
+    std::vector<int16_t> out(mic.size());
+    for (size_t i = 0; i + TEST_FRAME_SAMPLES <= mic.size(); i += TEST_FRAME_SAMPLES) {
+        TEST_ASSERT_TRUE(canceller.process(&near_pcm[i], &far_pcm[i], &out[i], TEST_FRAME_SAMPLES));
+    }
+    return toFloat(out);
+}
+
+static EchoCancellerConfig fixedDelayConfig(size_t delay_blocks) {
+    EchoCancellerConfig config = defaultEchoCancellerConfig(TEST_SAMPLE_RATE);
+    config.estimate_delay = false;
+    config.fixed_delay_blocks = delay_blocks;
+    return config;
+}
+
+void setUp(void) {
+    aec = new EchoCanceller();
+}
+
+void tearDown(void) {
+    delete aec;
+    aec = nullptr;
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_default_config(void) {
+    EchoCancellerConfig config = defaultEchoCancellerConfig(16000);
+    TEST_ASSERT_EQUAL(128, config.block_samples);
+    TEST_ASSERT_EQUAL(16, config.partitions);
+    TEST_ASSERT_EQUAL(64, config.max_delay_blocks);
+    TEST_ASSERT_EQUAL(64, defaultEchoCancellerConfig(8000).block_samples);
+    TEST_ASSERT_EQUAL(16, defaultEchoCancellerConfig(8000).partitions);
+
+    EchoCancellerConfig bad = config;
+    bad.block_samples = 100;
+    TEST_ASSERT_FALSE(aec->init(bad));
+    bad = config;
+    bad.fixed_delay_blocks = config.max_delay_blocks + 1;
+    TEST_ASSERT_FALSE(aec->init(bad));
+    TEST_ASSERT_TRUE(aec->init(config));
+
+    int16_t samples[100] = {};
+    TEST_ASSERT_FALSE(aec->process(samples, samples, samples, 100));
+}
+
+// The canceller's filter runs through dsps_irfft_f32; check it against a
+// double precision inverse DFT, not only as the inverse of dsps_rfft_f32
+void test_irfft_matches_reference_dft(void) {
+    static const int LENGTHS[] = {8, 64, 256};
+    for (int n : LENGTHS) {
+        std::vector<float> twiddle(DSPS_FFT_TWIDDLE_LEN(n));
+        std::vector<uint16_t> bitrev(DSPS_FFT_BITREV_LEN(n));
+        fft_plan_f32_t plan;
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_fft_plan_init_f32(&plan, twiddle.data(), bitrev.data(), n));
+
+        uint32_t seed = 7u + (uint32_t)n;
+        std::vector<double> x(n);
+        for (int j = 0; j < n; j++) {
+            x[j] = uniformNoise(seed);
+        }
+
+        // Packed spectrum of x from a direct DFT
+        std::vector<float> packed(n);
+        for (int k = 0; k <= n / 2; k++) {
+            double re = 0.0, im = 0.0;
+            for (int j = 0; j < n; j++) {
+                double phase = -2.0 * M_PI * (double)j * (double)k / (double)n;
+                re += x[j] * cos(phase);
+                im += x[j] * sin(phase);
+            }
+            if (k == 0) {
+                packed[0] = (float)re;
+            } else if (k == n / 2) {
+                packed[1] = (float)re;
+            } else {
+                packed[2 * k] = (float)re;
+                packed[2 * k + 1] = (float)im;
+            }
+        }
+
+        std::vector<float> data = packed;
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_irfft_f32(&plan, data.data()));
+        for (int j = 0; j < n; j++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f * (float)n, (float)x[j], data[j]);
+        }
+
+        // Round trip through the forward transform
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_rfft_f32(&plan, data.data()));
+        for (int i = 0; i < n; i++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f * (float)n, packed[i], data[i]);
+        }
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_irfft_f32(&plan, data.data()));
+        for (int j = 0; j < n; j++) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-5f * (float)n, (float)x[j], data[j]);
+        }
+    }
+}
+
+void test_far_silence_passes_through(void) {
+    TEST_ASSERT_TRUE(aec->init());
+    const size_t count = 32 * TEST_FRAME_SAMPLES;
+    std::vector<int16_t> near_pcm = toPcm(speechLike(count, 7, 2000.0f));
+    std::vector<int16_t> far_pcm(count, 0);
+    std::vector<int16_t> out(count);
+
+#ifndef ARDUINO
+    allocations = 0;
+    count_allocations = true;
+#endif
+    for (size_t i = 0; i < count; i += TEST_FRAME_SAMPLES) {
+        TEST_ASSERT_TRUE(aec->process(&near_pcm[i], &far_pcm[i], &out[i], TEST_FRAME_SAMPLES));
+    }
+#ifndef ARDUINO
+    count_allocations = false;
+    TEST_ASSERT_EQUAL(0, allocations.load());
+#endif
+    TEST_ASSERT_EQUAL_INT16_ARRAY(near_pcm.data(), out.data(), count);
+    TEST_ASSERT_EQUAL(0, aec->stats().adapted_blocks);
+    TEST_ASSERT_EQUAL(0, aec->stats().double_talk_blocks);
+}
+
+void test_converges_on_echo_path(void) {
+    TEST_ASSERT_TRUE(aec->init(fixedDelayConfig(0)));
+    const size_t count = 8 * TEST_SAMPLE_RATE;
+    std::vector<float> far = speechLike(count, 1, TEST_FAR_RMS);
+    std::vector<float> mic = micNoise(count, 2);
+    addEcho(mic, far, echoPath(3, TEST_ECHO_GAIN), 0, 0, count);
+
+    std::vector<float> out = runCanceller(*aec, mic, far);
+    float first_second = ratioDb(mic, out, 0, TEST_SAMPLE_RATE);
+    float erle = ratioDb(mic, out, count - 2 * TEST_SAMPLE_RATE, count);
+    AUDIO_LOGF("ERLE: %.1f dB in the first second, %.1f dB after 6 s (tracked %.1f dB)\n",
+               first_second, erle, aec->stats().erle_db);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_ERLE_DB, erle);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_ERLE_DB - 5.0f, aec->stats().erle_db);
+    TEST_ASSERT_EQUAL(0, aec->stats().resets);
+    // Echo alone is not double talk once converged
+    TEST_ASSERT_LESS_THAN(aec->stats().blocks / 20, aec->stats().double_talk_blocks);
+}
+
+void test_estimates_bulk_delay(void) {
+    // 150 ms between the output and the microphone: beyond the 128 ms tail
+    TEST_ASSERT_TRUE(aec->init());
+    const size_t count = 10 * TEST_SAMPLE_RATE;
+    const size_t delay = 2400;
+    std::vector<float> far = speechLike(count, 4, TEST_FAR_RMS);
+    std::vector<float> mic = micNoise(count, 5);
+    addEcho(mic, far, echoPath(6, TEST_ECHO_GAIN), delay, 0, count);
+
+    std::vector<float> out = runCanceller(*aec, mic, far);
+    float erle = ratioDb(mic, out, count - 2 * TEST_SAMPLE_RATE, count);
+    AUDIO_LOGF("bulk delay %u samples: estimate %d blocks of %u, %u moves, ERLE %.1f dB\n", (unsigned)delay,
+               aec->delayBlocks(), (unsigned)aec->config().block_samples, (unsigned)aec->stats().delay_changes,
+               erle);
+    int expected = (int)(delay / aec->config().block_samples);
+    TEST_ASSERT_INT_WITHIN(1, expected, aec->delayBlocks());
+    TEST_ASSERT_GREATER_OR_EQUAL(1, aec->stats().delay_changes);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_ERLE_DB, erle);
+}
+
+// Converge, then let a near-end talker speak over the echo for 2 s; returns
+// the echo attenuation during double talk (output minus near speech vs echo)
+static float doubleTalkAttenuation(EchoCanceller& canceller, uint32_t* flagged, uint32_t* talk_blocks) {
+    const size_t count = 9 * TEST_SAMPLE_RATE;
+    const size_t talk_begin = 6 * TEST_SAMPLE_RATE;
+    const size_t talk_end = 8 * TEST_SAMPLE_RATE;
+    std::vector<float> far = speechLike(count, 8, TEST_FAR_RMS);
+    std::vector<float> echo(count, 0.0f);
+    addEcho(echo, far, echoPath(9, TEST_ECHO_GAIN), 0, 0, count);
+    std::vector<float> talker = speechLike(count, 10, 1500.0f);
+    std::vector<float> noise = micNoise(count, 11);
+    std::vector<float> mic(count);
+    for (size_t i = 0; i < count; i++) {
+        mic[i] = echo[i] + noise[i] + (i >= talk_begin && i < talk_end ? talker[i] : 0.0f);
+    }
+
+    std::vector<float> out(count);
+    std::vector<int16_t> near_pcm = toPcm(mic);
+    std::vector<int16_t> far_pcm = toPcm(far);
+    std::vector<int16_t> out_pcm(count);
+    const size_t n = canceller.config().block_samples;
+    *flagged = 0;
+    *talk_blocks = 0;
+    for (size_t i = 0; i < count; i += n) {
+        canceller.process(&near_pcm[i], &far_pcm[i], &out_pcm[i], n);
+        if (i >= talk_begin && i < talk_end) {
+            double talker_energy = 0.0;
+            for (size_t j = i; j < i + n; j++) {
+                talker_energy += (double)talker[j] * talker[j];
+            }
+            if (talker_energy / n > 300.0 * 300.0) {
+                (*talk_blocks)++;
+                *flagged += canceller.isDoubleTalk() ? 1 : 0;
+            }
+        }
+    }
+    for (size_t i = 0; i < count; i++) {
+        out[i] = out_pcm[i] - (i >= talk_begin && i < talk_end ? talker[i] : 0.0f);
+    }
+    return ratioDb(echo, out, talk_begin, talk_end);
+}
+
+void test_double_talk_freezes_adaptation(void) {
+    TEST_ASSERT_TRUE(aec->init(fixedDelayConfig(0)));
+    uint32_t flagged = 0, talk_blocks = 0;
+    float protected_db = doubleTalkAttenuation(*aec, &flagged, &talk_blocks);
+
+    // Same scene with the detector disabled
+    EchoCancellerConfig config = fixedDelayConfig(0);
+    config.double_talk_ratio = 1e9f;
+    EchoCanceller unprotected;
+    TEST_ASSERT_TRUE(unprotected.init(config));
+    uint32_t unprotected_flagged = 0, unused = 0;
+    float unprotected_db = doubleTalkAttenuation(unprotected, &unprotected_flagged, &unused);
+
+    AUDIO_LOGF("double talk: %u of %u talker blocks flagged, echo attenuation %.1f dB (%.1f dB without detector)\n",
+               (unsigned)flagged, (unsigned)talk_blocks, protected_db, unprotected_db);
+    TEST_ASSERT_GREATER_THAN(talk_blocks * 8 / 10, flagged);
+    TEST_ASSERT_EQUAL(0, unprotected_flagged);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_DOUBLE_TALK_ERLE_DB, protected_db);
+    TEST_ASSERT_GREATER_THAN_FLOAT(unprotected_db + 20.0f, protected_db);
+}
+
+void test_reconverges_after_path_change(void) {
+    TEST_ASSERT_TRUE(aec->init(fixedDelayConfig(0)));
+    const size_t count = 12 * TEST_SAMPLE_RATE;
+    const size_t change = 5 * TEST_SAMPLE_RATE;
+    std::vector<float> far = speechLike(count, 12, TEST_FAR_RMS);
+    std::vector<float> mic = micNoise(count, 13);
+    addEcho(mic, far, echoPath(14, TEST_ECHO_GAIN), 0, 0, change);
+    addEcho(mic, far, echoPath(15, TEST_ECHO_GAIN), 0, change, count);
+
+    std::vector<float> out = runCanceller(*aec, mic, far);
+    float before = ratioDb(mic, out, change - TEST_SAMPLE_RATE, change);
+    float just_after = ratioDb(mic, out, change, change + TEST_SAMPLE_RATE / 4);
+    float recovered = ratioDb(mic, out, count - 2 * TEST_SAMPLE_RATE, count);
+    AUDIO_LOGF("path change: ERLE %.1f dB before, %.1f dB just after, %.1f dB 5 s later\n",
+               before, just_after, recovered);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_ERLE_DB, before);
+    TEST_ASSERT_LESS_THAN_FLOAT(before, just_after);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_RECOVERED_ERLE_DB, recovered);
+}
+
+// Band-limited read of x at fractional index pos: Hann-windowed sinc with
+// its cutoff at the capture Nyquist, the microphone's view of the DAC
+static float capturedAt(const std::vector<float>& x, double pos, int rate) {
+    const int half = 16;
+    const double fc = (double)TEST_SAMPLE_RATE / 2.0 / rate;
+    long center = (long)floor(pos);
+    double acc = 0.0;
+    for (long m = center - half + 1; m <= center + half; m++) {
+        if (m < 0 || m >= (long)x.size()) {
+            continue;
+        }
+        double t = pos - m;
+        double sinc = fabs(t) < 1e-9 ? 2.0 * fc : sin(2.0 * M_PI * fc * t) / (M_PI * t);
+        double window = 0.5 + 0.5 * cos(M_PI * t / half);
+        acc += x[m] * sinc * window;
+    }
+    return (float)acc;
+}
+
+// Output runs 0.5 s ahead of capture at output_rate; the feeder taps every
+// DMA block into the reference ring at the capture rate and the stage
+// cancels frames in place. Returns the ERLE over the last 2 s.
+static float stageErle(int output_rate) {
+    OutputFeeder feeder;
+    OutputProfile profile = outputProfile(LatencyProfile::BALANCED);
+    TEST_ASSERT_TRUE(feeder.init(profile));
+    feeder.setSampleRate(output_rate);
+    PcmRing reference;
+    TEST_ASSERT_TRUE(reference.init(TEST_SAMPLE_RATE));
+    feeder.setReference(&reference, TEST_SAMPLE_RATE);
+    TEST_ASSERT_TRUE(aec->init());
+    aec->setReference(&reference);
+    FramePool pool;
+    TEST_ASSERT_TRUE(pool.init(4, TEST_FRAME_SAMPLES));
+
+    const double ratio = (double)output_rate / TEST_SAMPLE_RATE;   // Output samples per capture sample
+    const size_t count = 10 * TEST_SAMPLE_RATE;
+    const size_t far_count = (size_t)(count * ratio);
+    // Blocks reach the DAC after the DMA queue, then the air and mic filter
+    const double dma_delay = (double)(profile.dma_buffers * profile.dma_frames);
+    const size_t air_delay = 480;
+    std::vector<float> far = speechLike(far_count, 16, TEST_FAR_RMS, output_rate);
+    std::vector<int16_t> far_pcm = toPcm(far);
+    std::vector<float> played;                               // Blocks handed to DMA, in order
+    played.reserve(far_count + output_rate);
+    std::vector<int16_t> block(profile.dma_frames);
+    size_t written = 0;
+
+    // The feeder fills while the producer keeps the ring topped up
+    auto playBlock = [&]() {
+        size_t space = feeder.ring().space();
+        size_t n = far_count - written < space ? far_count - written : space;
+        written += feeder.write(&far_pcm[written], n);
+        feeder.fill(block.data(), block.size());
+        played.insert(played.end(), block.begin(), block.end());
+    };
+    while (played.size() < (size_t)output_rate / 2) {
+        playBlock();
+    }
+    const size_t lead = played.size();
+    const size_t lead_capture = (size_t)(lead / ratio);
+
+    std::vector<float> mic_all = micNoise(count, 17);
+    std::vector<float> mic(count, 0.0f), out(count, 0.0f);
+    std::vector<float> heard;                                // DAC output as captured, per capture sample
+    heard.reserve(count);
+    std::vector<float> h = echoPath(18, TEST_ECHO_GAIN);
+    size_t captured = 0;
+    while (captured + TEST_FRAME_SAMPLES <= count - lead_capture) {
+        size_t end = captured + TEST_FRAME_SAMPLES;
+        while (played.size() < lead + (size_t)(end * ratio) + 32) {
+            playBlock();
+        }
+        // Capture sample i hears what was handed to DMA at lead + (i - air) * ratio - dma
+        while (heard.size() < end) {
+            double pos = lead + ((double)heard.size() - air_delay) * ratio - dma_delay;
+            heard.push_back(pos < 0.0 ? 0.0f : capturedAt(played, pos, output_rate));
+        }
+        for (size_t i = captured; i < end; i++) {
+            double acc = mic_all[i];
+            for (size_t k = 0; k < h.size() && k <= i; k++) {
+                acc += h[k] * heard[i - k];
+            }
+            mic[i] = (float)acc;
+        }
+        FrameRef frame = pool.acquire();
+        TEST_ASSERT_TRUE((bool)frame);
+        std::vector<int16_t> pcm = toPcm(std::vector<float>(mic.begin() + captured, mic.begin() + end));
+        memcpy(frame->samples, pcm.data(), TEST_FRAME_SAMPLES * sizeof(int16_t));
+        frame->length = TEST_FRAME_SAMPLES;
+        TEST_ASSERT_TRUE(aec->process(frame));
+        for (size_t i = 0; i < TEST_FRAME_SAMPLES; i++) {
+            out[captured + i] = frame->samples[i];
+        }
+        captured = end;
+    }
+
+    float erle = ratioDb(mic, out, captured - 2 * TEST_SAMPLE_RATE, captured);
+    const EchoStats& stats = aec->stats();
+    AUDIO_LOGF("stage at %d Hz: dropped %llu reference samples, delay %d blocks, ERLE %.1f dB, %.1f us per block (%.2f%% of real time)\n",
+               output_rate, (unsigned long long)stats.reference_dropped, aec->delayBlocks(), erle,
+               (double)stats.process_us / stats.blocks,
+               100.0 * stats.process_us / (stats.blocks * 1e6 * aec->config().block_samples / TEST_SAMPLE_RATE));
+    TEST_ASSERT_GREATER_THAN(0, stats.reference_dropped);
+    TEST_ASSERT_EQUAL(0, stats.reference_missing);
+    TEST_ASSERT_EQUAL(0, feeder.stats().reference_dropped);
+
+    // Silence markers pass untouched and consume no reference
+    FrameRef marker = pool.acquire();
+    marker->length = 0;
+    marker->flags = FRAME_FLAG_SILENCE;
+    size_t available = reference.available();
+    TEST_ASSERT_TRUE(aec->process(marker));
+    TEST_ASSERT_EQUAL(available, reference.available());
+    return erle;
+}
+
+void test_stage_reads_output_reference(void) {
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_ERLE_DB, stageErle(TEST_SAMPLE_RATE));
+}
+
+void test_stage_reference_from_other_output_rate(void) {
+    // Piper plays at 22050 Hz; the tap must arrive at capture speed
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_ERLE_DB, stageErle(22050));
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_config);
+    RUN_TEST(test_irfft_matches_reference_dft);
+    RUN_TEST(test_far_silence_passes_through);
+    RUN_TEST(test_converges_on_echo_path);
+    RUN_TEST(test_estimates_bulk_delay);
+    RUN_TEST(test_double_talk_freezes_adaptation);
+    RUN_TEST(test_reconverges_after_path_change);
+    RUN_TEST(test_stage_reads_output_reference);
+    RUN_TEST(test_stage_reference_from_other_output_rate);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Echo Canceller Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
@@ -0,0 +1,218 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include "../../library/endpointer.h"
+
+using audio_processing::FramePool;
+using audio_processing::FrameRef;
+
+// Test instances
+FramePool* pool = nullptr;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_FRAME_SAMPLES = 160;     // 10 ms
+const size_t TEST_POOL_FRAMES = 320;
+const uint32_t TEST_MAX_UTTERANCE_MS = 2000;
+
+struct Dispatched {
+    uint64_t start_sample;
+    uint64_t end_sample;
+    EndReason reason;
+    uint32_t frames_fed;       // Frames fed when the dispatch happened
+    bool samples_match;
+};
+
+static std::vector<Dispatched> dispatched;
+static uint32_t frames_fed = 0;
+
+void setUp(void) {
+    pool = new FramePool();
+    TEST_ASSERT_TRUE(pool->init(TEST_POOL_FRAMES, TEST_FRAME_SAMPLES));
+    dispatched.clear();
+    frames_fed = 0;
+}
+
+void tearDown(void) {
+    delete pool;
+    pool = nullptr;
+}
+
+static EndpointerConfig testConfig() {
+    EndpointerConfig config = defaultEndpointerConfig(TEST_SAMPLE_RATE);
+    config.max_utterance_ms = TEST_MAX_UTTERANCE_MS;
+    return config;
+}
+
+// Speech frames carry a ramp so copied spans can be checked; silence is low noise
+static FrameRef makeFrame(uint32_t index, bool speech) {
+    FrameRef frame = pool->acquire();
+    for (size_t i = 0; i < TEST_FRAME_SAMPLES; i++) {
+        uint32_t n = index * TEST_FRAME_SAMPLES + i;
+        frame->samples[i] = speech ?
+            (int16_t)(3000.0f * sinf(2.0f * (float)M_PI * 300.0f * n / TEST_SAMPLE_RATE)) :
+            (int16_t)((n * 7) % 17 - 8);
+    }
+    frame->length = TEST_FRAME_SAMPLES;
+    return frame;
+}
+
+static void recordDispatch(const Utterance& utterance) {
+    Dispatched d;
+    d.start_sample = utterance.start_sample;
+    d.end_sample = utterance.end_sample;
+    d.reason = utterance.reason;
+    d.frames_fed = frames_fed;
+
+    std::vector<int16_t> audio(utterance.samples());
+    d.samples_match = utterance.copyTo(audio.data(), audio.size()) == audio.size();
+    for (size_t i = 0; i < audio.size() && d.samples_match; i++) {
+        uint64_t n = utterance.start_sample + i;
+        size_t frame = (size_t)(i / TEST_FRAME_SAMPLES);
+        d.samples_match = audio[i] == utterance.frames[frame].data()[n % TEST_FRAME_SAMPLES];
+    }
+    dispatched.push_back(d);
+}
+
+// Feed `count` frames with a fixed decision, optionally through the internal VAD
+static void feedRun(Endpointer& endpointer, uint32_t count, bool speech, bool internal_vad) {
+    for (uint32_t i = 0; i < count; i++) {
+        FrameRef frame = makeFrame(frames_fed, speech);
+        frames_fed++;
+        if (internal_vad) {
+            endpointer.feed(frame);
+        } else {
+            endpointer.feed(frame, speech);
+        }
+    }
+}
+
+static uint64_t frameSample(uint32_t frame) {
+    return (uint64_t)frame * TEST_FRAME_SAMPLES;
+}
+
+void test_boundaries_with_external_decisions() {
+    Endpointer endpointer(testConfig());
+    TEST_ASSERT_TRUE(endpointer.init(TEST_FRAME_SAMPLES));
+    endpointer.setDispatch(recordDispatch);
+
+    feedRun(endpointer, 50, false, false);
+    feedRun(endpointer, 60, true, false);     // Utterance 1 with a 200 ms pause
+    feedRun(endpointer, 20, false, false);
+    feedRun(endpointer, 40, true, false);
+    feedRun(endpointer, 60, false, false);
+    feedRun(endpointer, 10, true, false);     // 100 ms click, too short
+    feedRun(endpointer, 60, false, false);
+    feedRun(endpointer, 250, true, false);    // 2.5 s, cut at 2 s
+    feedRun(endpointer, 60, false, false);
+    feedRun(endpointer, 30, true, false);     // Pending at end of stream
+    endpointer.flush();
+
+    TEST_ASSERT_EQUAL(4, dispatched.size());
+
+    TEST_ASSERT_EQUAL(frameSample(50), dispatched[0].start_sample);
+    TEST_ASSERT_EQUAL(frameSample(170), dispatched[0].end_sample);
+    TEST_ASSERT_TRUE(dispatched[0].reason == EndReason::SILENCE);
+    TEST_ASSERT_EQUAL(170 + 50, dispatched[0].frames_fed);   // Exactly at the 500 ms timeout
+
+    TEST_ASSERT_EQUAL(frameSample(300), dispatched[1].start_sample);
+    TEST_ASSERT_EQUAL(frameSample(500), dispatched[1].end_sample);
+    TEST_ASSERT_TRUE(dispatched[1].reason == EndReason::MAX_LENGTH);
+
+    TEST_ASSERT_EQUAL(frameSample(500), dispatched[2].start_sample);
+    TEST_ASSERT_EQUAL(frameSample(550), dispatched[2].end_sample);
+    TEST_ASSERT_TRUE(dispatched[2].reason == EndReason::SILENCE);
+
+    TEST_ASSERT_EQUAL(frameSample(610), dispatched[3].start_sample);
+    TEST_ASSERT_EQUAL(frameSample(640), dispatched[3].end_sample);
+    TEST_ASSERT_TRUE(dispatched[3].reason == EndReason::FLUSH);
+
+    for (size_t i = 0; i < dispatched.size(); i++) {
+        TEST_ASSERT_TRUE(dispatched[i].samples_match);
+    }
+
+    TEST_ASSERT_EQUAL(4, endpointer.stats().utterances);
+    TEST_ASSERT_EQUAL(1, endpointer.stats().rejected_short);
+    TEST_ASSERT_EQUAL(1, endpointer.stats().forced_max);
+
+    // Every held frame went back to the pool
+    TEST_ASSERT_FALSE(endpointer.inUtterance());
+    TEST_ASSERT_EQUAL(TEST_POOL_FRAMES, pool->available());
+}
+
+void test_boundaries_with_internal_vad() {
+    Endpointer endpointer(testConfig());
+    TEST_ASSERT_TRUE(endpointer.init(TEST_FRAME_SAMPLES));
+    endpointer.setDispatch(recordDispatch);
+
+    feedRun(endpointer, 40, false, true);
+    feedRun(endpointer, 80, true, true);
+    feedRun(endpointer, 70, false, true);
+
+    // Within two frames of the true edges (20 ms VAD window)
+    TEST_ASSERT_EQUAL(1, dispatched.size());
+    TEST_ASSERT_INT_WITHIN(2 * TEST_FRAME_SAMPLES, frameSample(40), dispatched[0].start_sample);
+    TEST_ASSERT_INT_WITHIN(2 * TEST_FRAME_SAMPLES, frameSample(120), dispatched[0].end_sample);
+    TEST_ASSERT_TRUE(dispatched[0].samples_match);
+}
+
+void test_end_of_speech_to_dispatch_latency() {
+    EndpointerConfig config = testConfig();
+    config.trailing_silence_ms = 200;
+    Endpointer endpointer(config);
+    TEST_ASSERT_TRUE(endpointer.init(TEST_FRAME_SAMPLES));
+    endpointer.setDispatch(recordDispatch);
+
+    // Real-time replay: one frame every 10 ms
+    for (uint32_t i = 0; i < 60 && dispatched.empty(); i++) {
+        bool speech = i < 30;
+        FrameRef frame = makeFrame(frames_fed++, speech);
+        endpointer.feed(frame, speech);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    TEST_ASSERT_EQUAL(1, dispatched.size());
+    const EndpointerStats& stats = endpointer.stats();
+    AUDIO_LOGF("End of speech to dispatch: %llu us (timeout %u ms)\n",
+               (unsigned long long)stats.last_latency_us, (unsigned)config.trailing_silence_ms);
+
+    // The timeout itself, plus scheduling slack, nothing more
+    TEST_ASSERT_GREATER_OR_EQUAL(config.trailing_silence_ms * 1000ull, stats.last_latency_us);
+    TEST_ASSERT_LESS_THAN(config.trailing_silence_ms * 1000ull + 100000ull, stats.last_latency_us);
+    TEST_ASSERT_EQUAL(stats.last_latency_us, endpointer.averageLatencyUs());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_boundaries_with_external_decisions);
+    RUN_TEST(test_boundaries_with_internal_vad);
+    RUN_TEST(test_end_of_speech_to_dispatch_latency);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Endpointer Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
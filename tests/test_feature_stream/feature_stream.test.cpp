@@ -0,0 +1,307 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "../../library/feature_stream.h"
+#include "../../library/log_mel.h"
+#include "../../library/audio_platform.h"
+
+#ifndef ARDUINO
+#include <fcntl.h>
+#include <poll.h>
+#include <stdlib.h>
+#include <termios.h>
+#include <unistd.h>
+#include <thread>
+#endif
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_SECONDS = 3;
+const size_t TEST_CHUNK_SAMPLES = 320;          // 20 ms writes, like the capture task
+const int TEST_PTY_TIMEOUT_MS = 2000;
+
+// Test instances
+std::vector<std::vector<float>> reference;      // Locally computed log-mel frames
+std::vector<std::vector<float>> received;
+std::vector<uint32_t> received_index;
+uint32_t end_frames = 0;
+
+void setUp(void) {
+    reference.clear();
+    received.clear();
+    received_index.clear();
+    end_frames = 0;
+}
+
+void tearDown(void) {
+}
+
+// Speech-like test signal: a gliding voiced tone with bursts of noise
+static std::vector<int16_t> makeAudio() {
+    std::vector<int16_t> audio(TEST_SECONDS * TEST_SAMPLE_RATE);
+    double phase = 0.0;
+    uint32_t noise = 12345;
+    for (size_t i = 0; i < audio.size(); i++) {
+        double t = (double)i / TEST_SAMPLE_RATE;
+        phase += 2.0 * M_PI * (150.0 + 100.0 * sin(2.0 * M_PI * 0.7 * t)) / TEST_SAMPLE_RATE;
+        double voiced = 0.0;
+        for (int h = 1; h <= 8; h++) {
+            voiced += sin(h * phase) / h;
+        }
+        noise = noise * 1664525u + 1013904223u;
+        double burst = fmod(t, 0.5) < 0.1 ? ((int32_t)(noise >> 16) - 32768) / 32768.0 : 0.0;
+        double envelope = fmod(t, 1.0) < 0.8 ? 1.0 : 0.0;
+        audio[i] = (int16_t)(envelope * (6000.0 * voiced + 3000.0 * burst));
+    }
+    return audio;
+}
+
+static void computeReference(const std::vector<int16_t>& audio) {
+    LogMelFrontEnd frontend(defaultLogMelConfig(TEST_SAMPLE_RATE));
+    LogMelFrontEnd::FrameCallback collect = [&](const float* features) {
+        reference.emplace_back(features, features + frontend.melBins());
+    };
+    frontend.feed(audio.data(), audio.size(), collect);
+    frontend.flush(collect);
+}
+
+static void attach(FeatureStreamReceiver& receiver) {
+    receiver.setFrame([](uint32_t index, const float* features) {
+        received_index.push_back(index);
+        received.emplace_back(features, features + 80);
+    });
+    receiver.setEnd([](uint32_t frames) {
+        end_frames = frames;
+    });
+}
+
+// Every frame within half a quantization step of the reference (or clamped)
+static void checkAgainstReference(const FeatureStreamEncoder& encoder) {
+    TEST_ASSERT_EQUAL(reference.size(), received.size());
+    const float low = encoder.offset() - 128.0f * encoder.scale();
+    const float high = encoder.offset() + 127.0f * encoder.scale();
+    float max_error = 0.0f;
+    for (size_t f = 0; f < reference.size(); f++) {
+        TEST_ASSERT_EQUAL(f, received_index[f]);
+        for (size_t i = 0; i < reference[f].size(); i++) {
+            float expected = reference[f][i] < low ? low : (reference[f][i] > high ? high : reference[f][i]);
+            float error = fabsf(received[f][i] - expected);
+            max_error = error > max_error ? error : max_error;
+        }
+    }
+    TEST_ASSERT_LESS_OR_EQUAL_FLOAT(0.5f * encoder.scale() + 1e-4f, max_error);
+}
+
+// Tests ----------------------------------------------------------------------
+
+void test_crc_check_value(void) {
+    const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    TEST_ASSERT_EQUAL(0x29b1, featureCrc16(check, sizeof(check)));
+}
+
+void test_round_trip_in_memory(void) {
+    std::vector<int16_t> audio = makeAudio();
+    computeReference(audio);
+
+    std::vector<uint8_t> wire;
+    FeatureStreamEncoder encoder;
+    TEST_ASSERT_TRUE(encoder.begin([&](const uint8_t* data, size_t length) {
+        wire.insert(wire.end(), data, data + length);
+        return true;
+    }));
+    for (size_t pos = 0; pos < audio.size(); pos += TEST_CHUNK_SAMPLES) {
+        encoder.feed(&audio[pos], TEST_CHUNK_SAMPLES);
+    }
+    TEST_ASSERT_TRUE(encoder.end());
+
+    // Delivered in odd-sized pieces, as a serial port would
+    FeatureStreamReceiver receiver;
+    attach(receiver);
+    for (size_t pos = 0; pos < wire.size(); pos += 37) {
+        receiver.push(&wire[pos], wire.size() - pos < 37 ? wire.size() - pos : 37);
+    }
+    TEST_ASSERT_TRUE(receiver.hasConfig());
+    TEST_ASSERT_EQUAL(TEST_SAMPLE_RATE, receiver.info().sample_rate);
+    TEST_ASSERT_EQUAL(80, receiver.info().mel_bins);
+    TEST_ASSERT_EQUAL(10, receiver.info().hop_ms);
+    TEST_ASSERT_EQUAL(reference.size(), end_frames);
+    TEST_ASSERT_EQUAL(0, receiver.stats().crc_errors);
+    TEST_ASSERT_EQUAL(0, receiver.stats().skipped_bytes);
+    checkAgainstReference(encoder);
+
+    // About a quarter of 16-bit PCM
+    double seconds = (double)audio.size() / TEST_SAMPLE_RATE;
+    double kbps = wire.size() * 8.0 / seconds / 1000.0;
+    AUDIO_LOGF("Feature stream: %.1f kbit/s vs %.1f kbit/s PCM, %u frames, %u clipped values\n", kbps,
+               TEST_SAMPLE_RATE * 16.0 / 1000.0, (unsigned)encoder.stats().frames, (unsigned)encoder.stats().clipped);
+    TEST_ASSERT_TRUE(kbps < 70.0);
+    TEST_ASSERT_EQUAL(wire.size(), encoder.stats().bytes);
+}
+
+// Corrupted and dropped packets cost only themselves
+void test_receiver_resyncs(void) {
+    std::vector<int16_t> audio = makeAudio();
+    std::vector<std::vector<uint8_t>> packets;
+    FeatureStreamEncoder encoder;
+    encoder.begin([&](const uint8_t* data, size_t length) {
+        packets.emplace_back(data, data + length);
+        return true;
+    });
+    encoder.feed(audio.data(), audio.size());
+    encoder.end();
+    TEST_ASSERT_GREATER_THAN(20, packets.size());
+
+    std::vector<uint8_t> wire;
+    for (size_t i = 0; i < packets.size(); i++) {
+        if (i == 5) {
+            continue;                               // Lost on the link
+        }
+        if (i == 9) {
+            packets[i][packets[i].size() / 2] ^= 0x40;  // Bit error
+        }
+        if (i == 14) {
+            wire.push_back(FEATURE_SYNC_0);         // Line noise between packets
+            wire.push_back(FEATURE_SYNC_1);
+            wire.push_back(0x7f);
+        }
+        wire.insert(wire.end(), packets[i].begin(), packets[i].end());
+    }
+
+    FeatureStreamReceiver receiver;
+    attach(receiver);
+    receiver.push(wire.data(), wire.size());
+    const FeatureReceiverStats& stats = receiver.stats();
+    const uint8_t frames_per_packet = defaultFeatureStreamConfig().frames_per_packet;
+    TEST_ASSERT_EQUAL(1, stats.crc_errors);
+    TEST_ASSERT_EQUAL(2, stats.lost_packets);
+    TEST_ASSERT_EQUAL(2 * frames_per_packet, stats.lost_frames);
+    TEST_ASSERT_EQUAL(packets.size() - 2, stats.packets);
+    TEST_ASSERT_EQUAL(encoder.stats().frames - 2 * frames_per_packet, stats.frames);
+    TEST_ASSERT_EQUAL(encoder.stats().frames, end_frames);
+    // Frames after the damage carry their true index
+    TEST_ASSERT_EQUAL(encoder.stats().frames - 1, received_index.back());
+}
+
+void test_failed_writes_are_counted(void) {
+    FeatureStreamEncoder encoder;
+    int calls = 0;
+    TEST_ASSERT_TRUE(encoder.begin([&](const uint8_t*, size_t) { return ++calls != 3; }));
+    std::vector<int16_t> audio = makeAudio();
+    encoder.feed(audio.data(), TEST_SAMPLE_RATE / 10);
+    encoder.end();
+    TEST_ASSERT_EQUAL(1, encoder.stats().write_failures);
+    TEST_ASSERT_FALSE(encoder.isStreaming());
+    TEST_ASSERT_EQUAL(0, encoder.feed(audio.data(), 160));
+}
+
+#ifndef ARDUINO
+// End to end through a pseudo-terminal: the encoder writes the master side
+// the way the firmware writes the SPP port, the receiver reads the slave
+// side the way the host reads /dev/rfcomm0
+void test_pty_loopback(void) {
+    int master = posix_openpt(O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(master >= 0);
+    TEST_ASSERT_EQUAL(0, grantpt(master));
+    TEST_ASSERT_EQUAL(0, unlockpt(master));
+    int slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+    TEST_ASSERT_TRUE(slave >= 0);
+    struct termios raw;
+    TEST_ASSERT_EQUAL(0, tcgetattr(slave, &raw));
+    cfmakeraw(&raw);
+    TEST_ASSERT_EQUAL(0, tcsetattr(slave, TCSANOW, &raw));
+
+    std::vector<int16_t> audio = makeAudio();
+    computeReference(audio);
+
+    FeatureStreamReceiver receiver;
+    attach(receiver);
+    bool ended = false;
+    receiver.setEnd([&](uint32_t frames) {
+        end_frames = frames;
+        ended = true;
+    });
+    std::thread host([&] {
+        uint8_t buffer[256];
+        while (!ended) {
+            struct pollfd pfd = {slave, POLLIN, 0};
+            if (poll(&pfd, 1, TEST_PTY_TIMEOUT_MS) <= 0) {
+                break;
+            }
+            ssize_t n = read(slave, buffer, sizeof(buffer));
+            if (n <= 0) {
+                break;
+            }
+            receiver.push(buffer, (size_t)n);
+        }
+    });
+
+    FeatureStreamEncoder encoder;
+    uint64_t start = audio_processing::audioMicros();
+    encoder.begin([&](const uint8_t* data, size_t length) {
+        size_t done = 0;
+        while (done < length) {
+            ssize_t n = write(master, data + done, length - done);
+            if (n <= 0) {
+                return false;
+            }
+            done += (size_t)n;
+        }
+        return true;
+    });
+    for (size_t pos = 0; pos < audio.size(); pos += TEST_CHUNK_SAMPLES) {
+        encoder.feed(&audio[pos], TEST_CHUNK_SAMPLES);
+    }
+    encoder.end();
+    host.join();
+    uint64_t elapsed = audio_processing::audioMicros() - start;
+    close(slave);
+    close(master);
+
+    AUDIO_LOGF("PTY loopback: %u packets, %llu bytes in %llu us\n", (unsigned)receiver.stats().packets,
+               (unsigned long long)encoder.stats().bytes, (unsigned long long)elapsed);
+    TEST_ASSERT_TRUE(ended);
+    TEST_ASSERT_EQUAL(0, encoder.stats().write_failures);
+    TEST_ASSERT_EQUAL(0, receiver.stats().crc_errors);
+    TEST_ASSERT_EQUAL(0, receiver.stats().lost_packets);
+    TEST_ASSERT_EQUAL(reference.size(), end_frames);
+    checkAgainstReference(encoder);
+}
+#endif
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_crc_check_value);
+    RUN_TEST(test_round_trip_in_memory);
+    RUN_TEST(test_receiver_resyncs);
+    RUN_TEST(test_failed_writes_are_counted);
+#ifndef ARDUINO
+    RUN_TEST(test_pty_loopback);
+#endif
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Feature Stream Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
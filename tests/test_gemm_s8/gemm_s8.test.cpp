@@ -0,0 +1,281 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <stdint.h>
+#include <string.h>
+#include <vector>
+#include "../../library/esp-dsp/dspm_gemm_s8.h"
+#include "../../library/audio_platform.h"
+
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const int TEST_RANDOM_CASES = 300;
+const int TEST_BENCH_REPEATS = 3;
+
+// Test instances
+static uint32_t seed = 1;
+
+void setUp(void) {
+    seed = 1;
+}
+
+void tearDown(void) {
+}
+
+static uint32_t nextRandom() {
+    seed = seed * 1664525u + 1013904223u;
+    return seed >> 8;
+}
+
+static int randomRange(int low, int high) {
+    return low + (int)(nextRandom() % (uint32_t)(high - low + 1));
+}
+
+static void fillRandom(std::vector<int8_t>& values) {
+    for (size_t i = 0; i < values.size(); i++) {
+        values[i] = (int8_t)randomRange(-128, 127);
+    }
+}
+
+// 16-byte aligned view into a vector, as the kernels expect of packed weights
+static int8_t* aligned(std::vector<int8_t>& storage, size_t bytes) {
+    storage.assign(bytes + 16, 0);
+    uintptr_t address = (uintptr_t)storage.data();
+    return storage.data() + ((16 - (address & 15)) & 15);
+}
+
+// Per-channel parameters plus the arrays they point at
+struct Requant {
+    std::vector<int32_t> bias;
+    std::vector<int32_t> multiplier;
+    std::vector<int8_t> shift;
+    dspm_requant_s8_t rq;
+
+    Requant(int n, int k, bool relu) : bias(n), multiplier(n), shift(n) {
+        int log_k = 0;
+        while ((1 << log_k) < k) {
+            log_k++;
+        }
+        for (int i = 0; i < n; i++) {
+            bias[i] = randomRange(-20000, 20000);
+            multiplier[i] = (int32_t)(0x40000000u + nextRandom() % 0x3fffffffu);
+            shift[i] = (int8_t)(log_k + randomRange(4, 8));
+        }
+        rq.bias = bias.data();
+        rq.multiplier = multiplier.data();
+        rq.shift = shift.data();
+        rq.input_offset = randomRange(-20, 128);
+        rq.output_offset = randomRange(-128, 20);
+        rq.act_min = relu ? rq.output_offset : -128;
+        rq.act_max = 127;
+    }
+};
+
+// Packed vs reference on one shape; returns the number of mismatches
+static int compareGemm(int m, int k, int n, int lda, int ldc, bool relu) {
+    std::vector<int8_t> a((size_t)(m - 1) * lda + k);
+    std::vector<int8_t> w((size_t)n * k);
+    fillRandom(a);
+    fillRandom(w);
+    Requant requant(n, k, relu);
+
+    std::vector<int8_t> storage;
+    int8_t* packed = aligned(storage, dspm_gemm_s8_packed_size(n, k));
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8_pack(w.data(), n, k, packed));
+
+    // Untouched padding between rows of C must stay as it was
+    std::vector<int8_t> expected((size_t)m * ldc, 0x55);
+    std::vector<int8_t> actual((size_t)m * ldc, 0x55);
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8_ref(a.data(), lda, m, k, w.data(), n, &requant.rq,
+                                                   expected.data(), ldc));
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8(a.data(), lda, m, k, packed, n, &requant.rq,
+                                               actual.data(), ldc));
+
+    int mismatches = 0;
+    for (size_t i = 0; i < actual.size(); i++) {
+        if (actual[i] != expected[i]) {
+            mismatches++;
+        }
+    }
+    return mismatches;
+}
+
+// Tests ----------------------------------------------------------------------
+
+void test_rejects_bad_arguments(void) {
+    std::vector<int8_t> a(64), w(64), c(64);
+    std::vector<int8_t> storage;
+    int8_t* packed = aligned(storage, dspm_gemm_s8_packed_size(4, 16));
+    Requant requant(4, 16, false);
+
+    TEST_ASSERT_EQUAL(0, dspm_gemm_s8_packed_size(0, 16));
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dspm_gemm_s8_pack(nullptr, 4, 16, packed));
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8_pack(w.data(), 4, 16, packed));
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dspm_gemm_s8(a.data(), 16, 2, 16, packed, 4, &requant.rq, c.data(), 2));
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dspm_gemm_s8(a.data(), 16, 2, 16, packed, 4, nullptr, c.data(), 4));
+    requant.rq.act_min = 10;
+    requant.rq.act_max = 0;
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dspm_gemm_s8(a.data(), 16, 2, 16, packed, 4, &requant.rq, c.data(), 4));
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dsps_conv1d_s8(a.data(), 2, 8, packed, 4, 3, 1, &requant.rq, c.data()));
+
+    // A scale of one or more needs a negative shift, which is not supported
+    Requant up(4, 16, false);
+    up.shift[3] = -1;
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dspm_gemm_s8(a.data(), 16, 2, 16, packed, 4, &up.rq, c.data(), 4));
+    TEST_ASSERT_EQUAL(DSP_RET_FAIL, dspm_gemm_s8_ref(a.data(), 16, 2, 16, w.data(), 4, &up.rq, c.data(), 4));
+    up.shift[3] = 0;
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8(a.data(), 16, 2, 16, packed, 4, &up.rq, c.data(), 4));
+}
+
+// Odd shapes hit every edge: partial panels, k tails, one-row tails,
+// strided rows and the channel block boundary
+void test_gemm_matches_reference(void) {
+    int failures = 0;
+    for (int i = 0; i < TEST_RANDOM_CASES; i++) {
+        int m = randomRange(1, 9);
+        int k = randomRange(1, 80);
+        int n = randomRange(1, 150);
+        int lda = k + randomRange(0, 5);
+        int ldc = n + randomRange(0, 3);
+        int mismatches = compareGemm(m, k, n, lda, ldc, (i & 1) != 0);
+        if (mismatches) {
+            AUDIO_LOGF("Mismatch: m=%d k=%d n=%d lda=%d ldc=%d -> %d values\n", m, k, n, lda, ldc, mismatches);
+            failures++;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, failures);
+
+    // Saturating extremes: every product is -128 * -128
+    std::vector<int8_t> a(256, -128), w(64 * 256, -128), c(64), expected(64);
+    Requant requant(64, 256, false);
+    requant.rq.input_offset = 0;
+    std::vector<int8_t> storage;
+    int8_t* packed = aligned(storage, dspm_gemm_s8_packed_size(64, 256));
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8_pack(w.data(), 64, 256, packed));
+    dspm_gemm_s8_ref(a.data(), 256, 1, 256, w.data(), 64, &requant.rq, expected.data(), 64);
+    dspm_gemm_s8(a.data(), 256, 1, 256, packed, 64, &requant.rq, c.data(), 64);
+    TEST_ASSERT_EQUAL_INT8_ARRAY(expected.data(), c.data(), 64);
+}
+
+void test_conv1d_matches_reference(void) {
+    const int shapes[][5] = {
+        // frames, in_ch, out_ch, kernel, stride
+        {49, 40, 8, 3, 1},
+        {50, 40, 8, 3, 2},
+        {20, 7, 13, 5, 3},
+        {3, 3, 5, 3, 1},
+        {100, 80, 64, 3, 1},
+    };
+    for (const int* s : shapes) {
+        int frames = s[0], in_ch = s[1], out_ch = s[2], kernel = s[3], stride = s[4];
+        int out_frames = (frames - kernel) / stride + 1;
+        std::vector<int8_t> x((size_t)frames * in_ch), w((size_t)out_ch * kernel * in_ch);
+        fillRandom(x);
+        fillRandom(w);
+        Requant requant(out_ch, kernel * in_ch, true);
+
+        std::vector<int8_t> storage;
+        int8_t* packed = aligned(storage, dspm_gemm_s8_packed_size(out_ch, kernel * in_ch));
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8_pack(w.data(), out_ch, kernel * in_ch, packed));
+
+        std::vector<int8_t> expected((size_t)out_frames * out_ch), actual(expected.size());
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_conv1d_s8_ref(x.data(), frames, in_ch, w.data(), out_ch,
+                                                         kernel, stride, &requant.rq, expected.data()));
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dsps_conv1d_s8(x.data(), frames, in_ch, packed, out_ch,
+                                                     kernel, stride, &requant.rq, actual.data()));
+        TEST_ASSERT_EQUAL_INT8_ARRAY(expected.data(), actual.data(), (int)expected.size());
+    }
+}
+
+// Encoder-sized layers (384-wide model, 1 s of 10 ms frames) in GOPS
+void test_gemm_throughput(void) {
+    struct Shape {
+        const char* name;
+        int m, k, n;
+        int kernel, stride;     // kernel 0 for a plain GEMM
+    };
+    const Shape shapes[] = {
+        {"attention proj 384x384", 100, 384, 384, 0, 0},
+        {"ffn up 384->1536", 100, 384, 1536, 0, 0},
+        {"ffn down 1536->384", 100, 1536, 384, 0, 0},
+        {"conv1 k3 80->384", 100, 80, 384, 3, 1},
+        {"conv2 k3/2 384->384", 100, 384, 384, 3, 2},
+    };
+
+    for (const Shape& shape : shapes) {
+        int k = shape.kernel ? shape.kernel * shape.k : shape.k;
+        int rows = shape.kernel ? (shape.m - shape.kernel) / shape.stride + 1 : shape.m;
+        std::vector<int8_t> a((size_t)shape.m * shape.k), w((size_t)shape.n * k);
+        fillRandom(a);
+        fillRandom(w);
+        Requant requant(shape.n, k, true);
+        std::vector<int8_t> storage;
+        int8_t* packed = aligned(storage, dspm_gemm_s8_packed_size(shape.n, k));
+        dspm_gemm_s8_pack(w.data(), shape.n, k, packed);
+        std::vector<int8_t> expected((size_t)rows * shape.n), actual(expected.size());
+
+        uint64_t best = UINT64_MAX;
+        uint64_t best_ref = UINT64_MAX;
+        for (int r = 0; r < TEST_BENCH_REPEATS; r++) {
+            uint64_t start = audioMicros();
+            if (shape.kernel) {
+                dsps_conv1d_s8(a.data(), shape.m, shape.k, packed, shape.n, shape.kernel, shape.stride,
+                               &requant.rq, actual.data());
+            } else {
+                dspm_gemm_s8(a.data(), k, rows, k, packed, shape.n, &requant.rq, actual.data(), shape.n);
+            }
+            uint64_t elapsed = audioMicros() - start;
+            best = elapsed < best ? elapsed : best;
+
+            start = audioMicros();
+            if (shape.kernel) {
+                dsps_conv1d_s8_ref(a.data(), shape.m, shape.k, w.data(), shape.n, shape.kernel, shape.stride,
+                                   &requant.rq, expected.data());
+            } else {
+                dspm_gemm_s8_ref(a.data(), k, rows, k, w.data(), shape.n, &requant.rq, expected.data(), shape.n);
+            }
+            elapsed = audioMicros() - start;
+            best_ref = elapsed < best_ref ? elapsed : best_ref;
+        }
+
+        double ops = 2.0 * rows * k * shape.n;
+        double gops = ops / (double)(best ? best : 1) / 1000.0;
+        double ref_gops = ops / (double)(best_ref ? best_ref : 1) / 1000.0;
+        AUDIO_LOGF("%-24s %3dx%4dx%4d: %7.2f GOPS (reference %5.2f, %.1fx)\n", shape.name, rows, k,
+                   shape.n, gops, ref_gops, gops / ref_gops);
+        TEST_ASSERT_EQUAL_INT8_ARRAY(expected.data(), actual.data(), (int)expected.size());
+    }
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_rejects_bad_arguments);
+    RUN_TEST(test_gemm_matches_reference);
+    RUN_TEST(test_conv1d_matches_reference);
+    RUN_TEST(test_gemm_throughput);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting GEMM S8 Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
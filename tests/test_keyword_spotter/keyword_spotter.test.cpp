@@ -0,0 +1,292 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "../../library/keyword_spotter.h"
+#include "../../library/keyword_gate.h"
+#include "../../library/speech_recognizer.h"
+#include "../../library/esp-dsp/dspm_gemm_s8.h"
+
+using audio_processing::FramePool;
+using audio_processing::FrameRef;
+using audio_processing::KeywordGate;
+using audio_processing::KeywordGateStats;
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_FRAME_SAMPLES = 160;     // 10 ms
+const size_t TEST_ARENA_BYTES = 8192;
+const uint32_t TEST_LISTEN_MS = 1000;
+const int TEST_BENCH_INFERENCES = 200;
+
+// Static tensor arena, as on target
+alignas(16) static int8_t arena[TEST_ARENA_BYTES];
+
+// Test instances
+KeywordSpotter* spotter = nullptr;
+
+void setUp(void) {
+    spotter = new KeywordSpotter(kwsTestModel(), defaultKwsConfig(TEST_SAMPLE_RATE), arena, sizeof(arena));
+    TEST_ASSERT_TRUE(spotter->init());
+}
+
+void tearDown(void) {
+    delete spotter;
+    spotter = nullptr;
+}
+
+// Quiet noise with optional tone bursts: {start_ms, length_ms, freq}
+struct Burst {
+    uint32_t start_ms;
+    uint32_t length_ms;
+    float freq;
+};
+
+static std::vector<int16_t> makeAudio(uint32_t total_ms, const Burst* bursts, size_t count) {
+    std::vector<int16_t> audio((size_t)total_ms * TEST_SAMPLE_RATE / 1000);
+    uint32_t seed = 1;
+    for (size_t i = 0; i < audio.size(); i++) {
+        seed = seed * 1664525u + 1013904223u;
+        float sample = (float)((int)((seed >> 16) % 17) - 8);
+        for (size_t b = 0; b < count; b++) {
+            size_t start = (size_t)bursts[b].start_ms * TEST_SAMPLE_RATE / 1000;
+            size_t end = start + (size_t)bursts[b].length_ms * TEST_SAMPLE_RATE / 1000;
+            if (i >= start && i < end) {
+                double cycles = fmod((double)bursts[b].freq * i / TEST_SAMPLE_RATE, 1.0);
+                sample += (float)(6000.0 * sin(2.0 * M_PI * cycles));
+            }
+        }
+        audio[i] = (int16_t)sample;
+    }
+    return audio;
+}
+
+// Fill the input window with one feature frame repeated
+static const int8_t* inferConstant(const float* frame) {
+    spotter->reset();
+    for (int i = 0; i < kwsTestModel().input_frames; i++) {
+        spotter->pushFeatures(frame);
+    }
+    return spotter->infer();
+}
+
+// Tests ----------------------------------------------------------------------
+
+void test_arena_is_checked(void) {
+    size_t needed = KeywordSpotter::arenaBytes(kwsTestModel());
+    AUDIO_LOGF("Test model arena: %u bytes\n", (unsigned)needed);
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_ARENA_BYTES, needed);
+
+    KeywordSpotter small(kwsTestModel(), defaultKwsConfig(TEST_SAMPLE_RATE), arena, needed - 1);
+    TEST_ASSERT_FALSE(small.init());
+    TEST_ASSERT_FALSE(small.pushFeatures(nullptr));
+    TEST_ASSERT_NULL(small.infer());
+}
+
+// Golden int8 logits {silence, unknown, keyword} for fixed input windows
+void test_golden_logits(void) {
+    float frame[40];
+
+    // Digital silence
+    for (int i = 0; i < 40; i++) {
+        frame[i] = -23.0f;
+    }
+    const int8_t golden_silence[] = {16, 0, 0};
+    TEST_ASSERT_EQUAL_INT8_ARRAY(golden_silence, inferConstant(frame), 3);
+
+    // Mel group 5 (2.8-3.7 kHz) active over a -11 floor
+    for (int i = 0; i < 40; i++) {
+        frame[i] = (i >= 25 && i < 30) ? 5.0f : -11.0f;
+    }
+    const int8_t golden_keyword[] = {-48, -127, 127};
+    TEST_ASSERT_EQUAL_INT8_ARRAY(golden_keyword, inferConstant(frame), 3);
+
+    // Mel group 1 (300-600 Hz) active
+    for (int i = 0; i < 40; i++) {
+        frame[i] = (i >= 5 && i < 10) ? 5.0f : -11.0f;
+    }
+    const int8_t golden_unknown[] = {-48, 127, -127};
+    TEST_ASSERT_EQUAL_INT8_ARRAY(golden_unknown, inferConstant(frame), 3);
+
+    // Time-varying pattern that exercises padding, stride and pooling
+    spotter->reset();
+    for (int t = 0; t < kwsTestModel().input_frames; t++) {
+        for (int i = 0; i < 40; i++) {
+            frame[i] = -12.0f + 0.35f * (float)((t * 7 + i * 13) % 41);
+        }
+        spotter->pushFeatures(frame);
+    }
+    const int8_t golden_pattern[] = {-33, 16, -16};
+    TEST_ASSERT_EQUAL_INT8_ARRAY(golden_pattern, spotter->infer(), 3);
+}
+
+// Layers with packed weights run the blocked kernels; logits must not move
+void test_packed_layers_match(void) {
+    const KwsModel& model = kwsTestModel();
+    std::vector<KwsLayer> layers(model.layers, model.layers + model.layer_count);
+    std::vector<std::vector<int8_t>> storage(layers.size());
+    for (size_t i = 0; i < layers.size(); i++) {
+        KwsLayer& layer = layers[i];
+        if (layer.type != KwsLayerType::CONV1D && layer.type != KwsLayerType::POINTWISE &&
+            layer.type != KwsLayerType::FULLY_CONNECTED) {
+            continue;
+        }
+        // The test model pools to one frame before its classifier
+        int k = layer.type == KwsLayerType::CONV1D ? layer.kernel * layer.in_channels : layer.in_channels;
+        storage[i].assign(dspm_gemm_s8_packed_size(layer.out_channels, k) + 16, 0);
+        int8_t* packed = storage[i].data() + ((16 - ((uintptr_t)storage[i].data() & 15)) & 15);
+        TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8_pack(layer.weights, layer.out_channels, k, packed));
+        layer.packed = packed;
+    }
+    KwsModel packed_model = model;
+    packed_model.layers = layers.data();
+
+    alignas(16) static int8_t packed_arena[TEST_ARENA_BYTES];
+    KeywordSpotter packed_spotter(packed_model, defaultKwsConfig(TEST_SAMPLE_RATE), packed_arena,
+                                  sizeof(packed_arena));
+    TEST_ASSERT_TRUE(packed_spotter.init());
+
+    float frame[40];
+    for (int t = 0; t < model.input_frames; t++) {
+        for (int i = 0; i < 40; i++) {
+            frame[i] = -12.0f + 0.35f * (float)((t * 7 + i * 13) % 41);
+        }
+        spotter->pushFeatures(frame);
+        packed_spotter.pushFeatures(frame);
+    }
+    const int8_t golden_pattern[] = {-33, 16, -16};
+    TEST_ASSERT_EQUAL_INT8_ARRAY(golden_pattern, spotter->infer(), 3);
+    TEST_ASSERT_EQUAL_INT8_ARRAY(golden_pattern, packed_spotter.infer(), 3);
+}
+
+// One hit for the 3 kHz "keyword", none for the 500 Hz word or silence
+void test_detects_keyword_in_audio(void) {
+    const Burst bursts[] = {{1000, 800, 3000.0f}, {3000, 800, 500.0f}};
+    std::vector<int16_t> audio = makeAudio(5000, bursts, 2);
+
+    std::vector<KwsHit> hits;
+    spotter->setHit([&hits](const KwsHit& hit) { hits.push_back(hit); });
+    float max_unknown = 0.0f;
+    for (size_t pos = 0; pos + TEST_FRAME_SAMPLES <= audio.size(); pos += TEST_FRAME_SAMPLES) {
+        spotter->feed(&audio[pos], TEST_FRAME_SAMPLES);
+        if (spotter->posteriors()[1] > max_unknown) {
+            max_unknown = spotter->posteriors()[1];
+        }
+    }
+
+    // Refractory period: a keyword held for 800 ms is one hit
+    TEST_ASSERT_EQUAL(1, hits.size());
+    TEST_ASSERT_EQUAL(1, spotter->stats().hits);
+    TEST_ASSERT_EQUAL_STRING("keyword", hits[0].label);
+    TEST_ASSERT_GREATER_OR_EQUAL_FLOAT(0.8f, hits[0].score);
+    // Detected inside the burst (frame index is in 10 ms hops)
+    TEST_ASSERT_GREATER_OR_EQUAL(100, hits[0].frame);
+    TEST_ASSERT_LESS_THAN(180, hits[0].frame);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.8f, max_unknown);
+}
+
+// The gate drops audio until the keyword, then lets the command through
+void test_gate_wakes_recognizer(void) {
+    FramePool pool;
+    TEST_ASSERT_TRUE(pool.init(8, TEST_FRAME_SAMPLES));
+    KeywordGate gate(*spotter, TEST_LISTEN_MS, TEST_SAMPLE_RATE);
+
+    HostRecognizerBackend backend(1600, 1);
+    SpeechRecognizer recognizer(&backend);
+    uint32_t wake_frame = 0;
+    uint32_t frame_index = 0;
+    gate.setWake([&](const KwsHit& hit) {
+        TEST_ASSERT_EQUAL(2, hit.keyword);
+        wake_frame = frame_index;
+        recognizer.begin();
+    });
+
+    // Unknown word first, then keyword, then a command (500 Hz)
+    const Burst bursts[] = {{500, 600, 500.0f}, {2000, 600, 3000.0f}, {2800, 500, 500.0f}};
+    std::vector<int16_t> audio = makeAudio(5000, bursts, 3);
+    uint32_t passed = 0;
+    for (size_t pos = 0; pos + TEST_FRAME_SAMPLES <= audio.size(); pos += TEST_FRAME_SAMPLES) {
+        FrameRef frame = pool.acquire();
+        memcpy(frame->samples, &audio[pos], TEST_FRAME_SAMPLES * sizeof(int16_t));
+        frame->length = TEST_FRAME_SAMPLES;
+        if (gate.process(frame)) {
+            passed++;
+            recognizer.feed(frame.data(), frame.size());
+            if (!gate.isOpen() && recognizer.inSession()) {
+                AUDIO_LOGF("Command: \"%s\"\n", recognizer.finish().c_str());
+            }
+        }
+        frame_index++;
+    }
+
+    KeywordGateStats stats;
+    gate.getStats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.wakes);
+    TEST_ASSERT_EQUAL(1, recognizer.stats().sessions);
+    TEST_ASSERT_GREATER_OR_EQUAL(200, wake_frame);
+    TEST_ASSERT_EQUAL(TEST_LISTEN_MS / 10, passed);
+    TEST_ASSERT_EQUAL(stats.frames_in, stats.frames_passed + stats.frames_dropped);
+    TEST_ASSERT_FALSE(gate.isOpen());
+    TEST_ASSERT_EQUAL(TEST_LISTEN_MS * TEST_SAMPLE_RATE / 1000, recognizer.stats().samples_fed);
+}
+
+void test_inference_cycles(void) {
+    float frame[40];
+    for (int i = 0; i < 40; i++) {
+        frame[i] = -11.0f + (float)(i % 7);
+    }
+    for (int i = 0; i < kwsTestModel().input_frames; i++) {
+        spotter->pushFeatures(frame);
+    }
+    uint64_t start = audioMicros();
+    for (int i = 0; i < TEST_BENCH_INFERENCES; i++) {
+        spotter->infer();
+    }
+    uint64_t elapsed = audioMicros() - start;
+
+    const KwsStats& stats = spotter->stats();
+    uint32_t average = (uint32_t)(stats.total_cycles / stats.inferences);
+    AUDIO_LOGF("KWS inference: %u cycles average, %u max, %.1f us (%d inferences/s at hop 2)\n",
+               (unsigned)average, (unsigned)stats.max_cycles,
+               (float)elapsed / TEST_BENCH_INFERENCES, TEST_SAMPLE_RATE / 160 / 2);
+    TEST_ASSERT_EQUAL(TEST_BENCH_INFERENCES, stats.inferences);
+    TEST_ASSERT_GREATER_THAN(0, stats.last_cycles);
+    TEST_ASSERT_LESS_OR_EQUAL(stats.max_cycles, average);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_arena_is_checked);
+    RUN_TEST(test_golden_logits);
+    RUN_TEST(test_packed_layers_match);
+    RUN_TEST(test_detects_keyword_in_audio);
+    RUN_TEST(test_gate_wakes_recognizer);
+    RUN_TEST(test_inference_cycles);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Keyword Spotter Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
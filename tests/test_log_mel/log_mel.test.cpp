@@ -0,0 +1,256 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <atomic>
+#include <vector>
+#include "../../library/log_mel.h"
+#include "../../library/audio_platform.h"
+#include "../alloc_counter.h"
+
+using audio_processing::audioMicros;
+
+// Test instances
+LogMelFrontEnd* frontend = nullptr;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_SIGNAL_SAMPLES = TEST_SAMPLE_RATE;          // 1 s
+const float TEST_MAX_LOG_ERROR = 2e-3f;                    // Natural log units
+const double TEST_MIN_REFERENCE_POWER = 1e-6;               // Skip near-empty bands
+const int TEST_BENCHMARK_SECONDS = 10;
+
+static std::vector<int16_t> signal;
+
+// Chirp from 100 Hz to 6 kHz over low-level noise
+static void buildSignal() {
+    signal.resize(TEST_SIGNAL_SAMPLES);
+    uint32_t seed = 12345;
+    double phase = 0.0;
+    for (size_t i = 0; i < TEST_SIGNAL_SAMPLES; i++) {
+        double freq = 100.0 + 5900.0 * i / TEST_SIGNAL_SAMPLES;
+        phase += 2.0 * M_PI * freq / TEST_SAMPLE_RATE;
+        seed = seed * 1664525u + 1013904223u;
+        double noise = ((seed >> 16) & 0xffff) / 65536.0 - 0.5;
+        signal[i] = (int16_t)(8000.0 * sin(phase) + 400.0 * noise);
+    }
+}
+
+void setUp(void) {
+    if (signal.empty()) {
+        buildSignal();
+    }
+    frontend = new LogMelFrontEnd(defaultLogMelConfig(TEST_SAMPLE_RATE));
+}
+
+void tearDown(void) {
+    delete frontend;
+    frontend = nullptr;
+}
+
+static double hzToMelReference(double hz) {
+    return 2595.0 * log10(1.0 + hz / 700.0);
+}
+
+static double melToHzReference(double mel) {
+    return 700.0 * (pow(10.0, mel / 2595.0) - 1.0);
+}
+
+// Whole-signal reference: double precision, direct DFT, dense filterbank, libm log
+static std::vector<std::vector<double>> referenceLogMel(const std::vector<int16_t>& x, const LogMelConfig& config) {
+    const size_t win = (size_t)config.sample_rate * config.window_ms / 1000;
+    const size_t hop = (size_t)config.sample_rate * config.hop_ms / 1000;
+    size_t n_fft = 1;
+    while (n_fft < win) {
+        n_fft <<= 1;
+    }
+    const size_t bins = n_fft / 2 + 1;
+
+    std::vector<std::vector<double>> fbank(config.mel_bins, std::vector<double>(bins, 0.0));
+    double max_mel = hzToMelReference(config.sample_rate / 2.0);
+    for (int m = 0; m < config.mel_bins; m++) {
+        double lo = melToHzReference(max_mel * m / (config.mel_bins + 1));
+        double center = melToHzReference(max_mel * (m + 1) / (config.mel_bins + 1));
+        double hi = melToHzReference(max_mel * (m + 2) / (config.mel_bins + 1));
+        for (size_t k = 0; k < bins; k++) {
+            double f = (double)k * config.sample_rate / n_fft;
+            double w = fmin((f - lo) / (center - lo), (hi - f) / (hi - center));
+            fbank[m][k] = w > 0.0 ? w : 0.0;
+        }
+    }
+
+    std::vector<std::vector<double>> frames;
+    std::vector<double> frame(win);
+    std::vector<double> power(bins);
+    for (size_t start = 0; start + win <= x.size(); start += hop) {
+        for (size_t i = 0; i < win; i++) {
+            double hann = 0.5 - 0.5 * cos(2.0 * M_PI * i / win);
+            frame[i] = hann * x[start + i] / 32768.0;
+        }
+        for (size_t k = 0; k < bins; k++) {
+            double re = 0.0;
+            double im = 0.0;
+            for (size_t i = 0; i < win; i++) {
+                re += frame[i] * cos(2.0 * M_PI * k * i / n_fft);
+                im -= frame[i] * sin(2.0 * M_PI * k * i / n_fft);
+            }
+            power[k] = re * re + im * im;
+        }
+        std::vector<double> mel(config.mel_bins);
+        for (int m = 0; m < config.mel_bins; m++) {
+            double sum = 0.0;
+            for (size_t k = 0; k < bins; k++) {
+                sum += fbank[m][k] * power[k];
+            }
+            mel[m] = sum;
+        }
+        frames.push_back(mel);
+    }
+    return frames;
+}
+
+void test_fast_log_accuracy(void) {
+    double max_error = 0.0;
+    for (double x = 1e-10; x < 1e6; x *= 1.001) {
+        max_error = fmax(max_error, fabs(fastLog((float)x) - log(x)));
+    }
+    TEST_ASSERT_LESS_THAN_FLOAT(2e-4f, (float)max_error);
+}
+
+void test_matches_reference(void) {
+    LogMelConfig config = defaultLogMelConfig(TEST_SAMPLE_RATE);
+    TEST_ASSERT_EQUAL(400, frontend->windowSamples());
+    TEST_ASSERT_EQUAL(160, frontend->hopSamples());
+    TEST_ASSERT_EQUAL(512, frontend->fftSize());
+    TEST_ASSERT_EQUAL(80, frontend->melBins());
+
+    std::vector<std::vector<float>> frames;
+    LogMelFrontEnd::FrameCallback collect = [&frames](const float* features) {
+        frames.push_back(std::vector<float>(features, features + 80));
+    };
+    frontend->feed(signal.data(), signal.size(), collect);
+
+    std::vector<std::vector<double>> reference = referenceLogMel(signal, config);
+    TEST_ASSERT_EQUAL(reference.size(), frames.size());
+    TEST_ASSERT_EQUAL((TEST_SIGNAL_SAMPLES - 400) / 160 + 1, frames.size());
+
+    double max_error = 0.0;
+    size_t compared = 0;
+    for (size_t f = 0; f < frames.size(); f++) {
+        for (int m = 0; m < 80; m++) {
+            if (reference[f][m] < TEST_MIN_REFERENCE_POWER) {
+                continue;
+            }
+            max_error = fmax(max_error, fabs(frames[f][m] - log(reference[f][m])));
+            compared++;
+        }
+    }
+    AUDIO_LOGF("Log-mel vs reference: %zu values, max error %.2e\n", compared, max_error);
+    TEST_ASSERT_GREATER_THAN(frames.size() * 40, compared);
+    TEST_ASSERT_LESS_THAN_FLOAT(TEST_MAX_LOG_ERROR, (float)max_error);
+
+    // Sparse filterbank holds only the triangle
+    size_t weights = 0;
+    for (int m = 0; m < 80; m++) {
+        weights += frontend->melLength(m);
+        for (int i = 0; i < frontend->melLength(m); i++) {
+            TEST_ASSERT_GREATER_THAN_FLOAT(0.0f, frontend->melWeights(m)[i]);
+        }
+    }
+    TEST_ASSERT_LESS_THAN(80 * 257 / 20, weights);
+}
+
+// Frames must not depend on how capture splits the samples
+void test_incremental_matches_batch(void) {
+    std::vector<float> batch;
+    LogMelFrontEnd::FrameCallback collect_batch = [&batch](const float* features) {
+        batch.insert(batch.end(), features, features + 80);
+    };
+    frontend->feed(signal.data(), signal.size(), collect_batch);
+    frontend->flush(collect_batch);
+
+    const size_t feed_sizes[] = {1, 37, 160, 320, 4096};
+    for (size_t feed_size : feed_sizes) {
+        std::vector<float> chunked;
+        LogMelFrontEnd::FrameCallback collect = [&chunked](const float* features) {
+            chunked.insert(chunked.end(), features, features + 80);
+        };
+        frontend->reset();
+        for (size_t pos = 0; pos < signal.size(); pos += feed_size) {
+            size_t n = signal.size() - pos < feed_size ? signal.size() - pos : feed_size;
+            frontend->feed(&signal[pos], n, collect);
+        }
+        frontend->flush(collect);
+        TEST_ASSERT_EQUAL(batch.size(), chunked.size());
+        TEST_ASSERT_EQUAL_MEMORY(batch.data(), chunked.data(), batch.size() * sizeof(float));
+    }
+
+    // flush() covers the tail once and never repeats a frame
+    TEST_ASSERT_EQUAL((TEST_SIGNAL_SAMPLES - 400) / 160 + 2, batch.size() / 80);
+    TEST_ASSERT_EQUAL(0, frontend->flush(collect_batch));
+}
+
+void test_throughput(void) {
+    uint32_t frames = 0;
+    float sink = 0.0f;
+    LogMelFrontEnd::FrameCallback consume = [&frames, &sink](const float* features) {
+        frames++;
+        sink += features[0];
+    };
+
+    const size_t feed = 160;
+#ifndef ARDUINO
+    allocations.store(0);
+    count_allocations = true;
+#endif
+    uint64_t start = audioMicros();
+    for (int s = 0; s < TEST_BENCHMARK_SECONDS; s++) {
+        for (size_t pos = 0; pos + feed <= signal.size(); pos += feed) {
+            frontend->feed(&signal[pos], feed, consume);
+        }
+    }
+    uint64_t elapsed = audioMicros() - start;
+#ifndef ARDUINO
+    count_allocations = false;
+    TEST_ASSERT_EQUAL(0, allocations.load());
+#endif
+
+    float fps = frames * 1e6f / (float)(elapsed > 0 ? elapsed : 1);
+    AUDIO_LOGF("Log-mel: %u frames in %llu us, %.0f frames/s (%.1fx real time)\n",
+               (unsigned)frames, (unsigned long long)elapsed, fps, fps / 100.0f);
+    TEST_ASSERT_TRUE(isfinite(sink));
+    // 100 frames/s is real time at a 10 ms hop
+    TEST_ASSERT_GREATER_THAN_FLOAT(100.0f, fps);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fast_log_accuracy);
+    RUN_TEST(test_matches_reference);
+    RUN_TEST(test_incremental_matches_batch);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Log-Mel Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
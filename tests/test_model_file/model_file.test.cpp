@@ -0,0 +1,256 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "../../library/model_file.h"
+#include "../../library/speech_recognizer.h"
+#include "../../library/esp-dsp/dspm_gemm_s8.h"
+#include "../../library/audio_platform.h"
+
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const char* TEST_MODEL_PATH = "model_file.test.bin";
+const uint32_t TEST_GEMM_N = 24;
+const uint32_t TEST_GEMM_K = 40;
+const uint32_t TEST_LARGE_TENSORS = 4;
+const uint32_t TEST_LARGE_TENSOR_BYTES = 2u << 20;     // 8 MB model in total
+
+// Test instances
+ModelFile* model = nullptr;
+
+void setUp(void) {
+    model = new ModelFile();
+}
+
+void tearDown(void) {
+    delete model;
+    model = nullptr;
+    remove(TEST_MODEL_PATH);
+}
+
+static std::vector<int8_t> gemmWeights() {
+    std::vector<int8_t> w(TEST_GEMM_N * TEST_GEMM_K);
+    for (size_t i = 0; i < w.size(); i++) {
+        w[i] = (int8_t)((i * 37 + 11) % 251 - 125);
+    }
+    return w;
+}
+
+// Small mixed model: int8 matrix, float vector, packed GEMM weights
+static ModelFileWriter smallModel(const char* arch) {
+    ModelFileWriter writer(arch);
+    int8_t matrix[3 * 5];
+    for (int i = 0; i < 15; i++) {
+        matrix[i] = (int8_t)(i - 7);
+    }
+    const uint32_t matrix_dims[] = {3, 5};
+    writer.add("encoder.matrix", ModelTensorType::INT8, matrix_dims, 2, matrix, 0.5f, -3);
+    const float vector[] = {1.0f, -2.5f, 3.25f, 0.0f};
+    const uint32_t vector_dims[] = {4};
+    writer.add("encoder.scale", ModelTensorType::FLOAT32, vector_dims, 1, vector);
+    std::vector<int8_t> w = gemmWeights();
+    writer.addPackedGemm("encoder.proj", w.data(), TEST_GEMM_N, TEST_GEMM_K, 0.01f, 0);
+    return writer;
+}
+
+// Tests ----------------------------------------------------------------------
+
+void test_round_trip_in_place(void) {
+    TEST_ASSERT_TRUE(smallModel("whisper").write(TEST_MODEL_PATH));
+    TEST_ASSERT_TRUE(model->open(TEST_MODEL_PATH));
+    TEST_ASSERT_EQUAL_STRING("whisper", model->arch());
+    TEST_ASSERT_EQUAL(3, model->tensorCount());
+
+    ModelTensor matrix;
+    TEST_ASSERT_TRUE(model->find("encoder.matrix", &matrix));
+    TEST_ASSERT_EQUAL(ModelTensorType::INT8, matrix.type);
+    TEST_ASSERT_EQUAL(2, matrix.rank);
+    TEST_ASSERT_EQUAL(3, matrix.dims[0]);
+    TEST_ASSERT_EQUAL(5, matrix.dims[1]);
+    TEST_ASSERT_EQUAL(15, matrix.bytes);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, matrix.scale);
+    TEST_ASSERT_EQUAL(-3, matrix.zero_point);
+    TEST_ASSERT_EQUAL(-7, static_cast<const int8_t*>(matrix.data)[0]);
+    TEST_ASSERT_EQUAL(7, static_cast<const int8_t*>(matrix.data)[14]);
+
+    ModelTensor vector;
+    TEST_ASSERT_TRUE(model->find("encoder.scale", &vector));
+    TEST_ASSERT_EQUAL_FLOAT(3.25f, static_cast<const float*>(vector.data)[2]);
+    TEST_ASSERT_FALSE(model->find("decoder.missing", nullptr));
+
+    // Every blob is aligned and inside the mapping: nothing was copied
+    for (uint32_t i = 0; i < model->tensorCount(); i++) {
+        ModelTensor t;
+        TEST_ASSERT_TRUE(model->tensor(i, &t));
+        const uint8_t* data = static_cast<const uint8_t*>(t.data);
+        TEST_ASSERT_EQUAL(0, (uintptr_t)data % MODEL_FILE_ALIGN);
+        TEST_ASSERT_TRUE(data > model->data() && data + t.bytes <= model->data() + model->fileBytes());
+    }
+
+    // Packed weights drive the GEMM straight from the mapping
+    ModelTensor proj;
+    TEST_ASSERT_TRUE(model->find("encoder.proj", &proj));
+    TEST_ASSERT_EQUAL(ModelTensorType::INT8_GEMM_PACKED, proj.type);
+    std::vector<int8_t> w = gemmWeights();
+    std::vector<int8_t> x(3 * TEST_GEMM_K);
+    for (size_t i = 0; i < x.size(); i++) {
+        x[i] = (int8_t)(i % 19 - 9);
+    }
+    std::vector<int32_t> multiplier(TEST_GEMM_N, 0x40000000);
+    std::vector<int8_t> shift(TEST_GEMM_N, 6);
+    dspm_requant_s8_t rq = {nullptr, multiplier.data(), shift.data(), 0, 0, -128, 127};
+    std::vector<int8_t> expected(3 * TEST_GEMM_N), actual(3 * TEST_GEMM_N);
+    dspm_gemm_s8_ref(x.data(), TEST_GEMM_K, 3, TEST_GEMM_K, w.data(), TEST_GEMM_N, &rq, expected.data(), TEST_GEMM_N);
+    TEST_ASSERT_EQUAL(DSP_RET_OK, dspm_gemm_s8(x.data(), TEST_GEMM_K, 3, TEST_GEMM_K,
+                                               static_cast<const int8_t*>(proj.data), TEST_GEMM_N, &rq,
+                                               actual.data(), TEST_GEMM_N));
+    TEST_ASSERT_EQUAL_INT8_ARRAY(expected.data(), actual.data(), (int)expected.size());
+
+    // The same bytes work from memory
+    std::vector<uint8_t> file = smallModel("whisper").build();
+    std::vector<uint8_t> storage(file.size() + 16);
+    uint8_t* aligned = storage.data() + ((16 - ((uintptr_t)storage.data() & 15)) & 15);
+    memcpy(aligned, file.data(), file.size());
+    ModelFile memory;
+    TEST_ASSERT_TRUE(memory.openMemory(aligned, file.size()));
+    TEST_ASSERT_EQUAL(3, memory.tensorCount());
+    TEST_ASSERT_FALSE(memory.openMemory(aligned + 1, file.size()));
+}
+
+void test_rejects_bad_containers(void) {
+    TEST_ASSERT_FALSE(model->open("does-not-exist.bin"));
+    TEST_ASSERT_FALSE(model->isOpen());
+
+    ModelFileWriter writer("whisper");
+    const uint32_t dims[] = {4};
+    int8_t data[4] = {1, 2, 3, 4};
+    TEST_ASSERT_TRUE(writer.add("a", ModelTensorType::INT8, dims, 1, data));
+    TEST_ASSERT_FALSE(writer.add("a", ModelTensorType::INT8, dims, 1, data));
+    TEST_ASSERT_FALSE(writer.add("a-name-that-is-far-too-long", ModelTensorType::INT8, dims, 1, data));
+    TEST_ASSERT_FALSE(writer.add("b", ModelTensorType::INT8, dims, 0, data));
+    std::vector<uint8_t> good = writer.build();
+
+    // Each corruption on its own must be caught by the header/table check
+    struct Corruption {
+        size_t offset;
+        uint8_t value;
+    };
+    const size_t entry = sizeof(ModelFileHeader);
+    const Corruption corruptions[] = {
+        {0, 0x00},                                              // Magic
+        {4, 0x02},                                              // Version
+        {offsetof(ModelFileHeader, tensor_count), 0x40},        // Table past the end
+        {entry + offsetof(ModelTensorEntry, offset), 0x41},     // Misaligned blob
+        {entry + offsetof(ModelTensorEntry, bytes), 0x05},      // Size vs shape
+        {entry + offsetof(ModelTensorEntry, dims) + 3, 0x7f},   // Blob past the end
+        {entry + offsetof(ModelTensorEntry, type), 0x09},       // Unknown type
+        {entry, 0x00},                                          // Empty name
+    };
+    std::vector<uint8_t> storage(good.size() + 16);
+    uint8_t* aligned = storage.data() + ((16 - ((uintptr_t)storage.data() & 15)) & 15);
+    for (const Corruption& corruption : corruptions) {
+        memcpy(aligned, good.data(), good.size());
+        TEST_ASSERT_TRUE(model->openMemory(aligned, good.size()));
+        aligned[corruption.offset] = corruption.value;
+        TEST_ASSERT_FALSE(model->openMemory(aligned, good.size()));
+    }
+
+    // Truncated file
+    memcpy(aligned, good.data(), good.size());
+    TEST_ASSERT_FALSE(model->openMemory(aligned, good.size() - 1));
+    TEST_ASSERT_FALSE(model->openMemory(aligned, sizeof(ModelFileHeader) - 1));
+}
+
+void test_recognizer_binds_model(void) {
+    TEST_ASSERT_TRUE(smallModel("whisper").write(TEST_MODEL_PATH));
+    SpeechRecognizer recognizer;
+    TEST_ASSERT_TRUE(recognizer.initialize(TEST_MODEL_PATH));
+    TEST_ASSERT_TRUE(recognizer.model().isOpen());
+    TEST_ASSERT_EQUAL(3, recognizer.model().tensorCount());
+
+    // Weights built for another backend are refused
+    TEST_ASSERT_TRUE(smallModel("kws").write(TEST_MODEL_PATH));
+    TEST_ASSERT_FALSE(recognizer.initialize(TEST_MODEL_PATH));
+    TEST_ASSERT_FALSE(recognizer.initialize("does-not-exist.bin"));
+
+    // Backends that need no weights still initialize without a model
+    HostRecognizerBackend backend;
+    SpeechRecognizer host(&backend);
+    TEST_ASSERT_TRUE(host.initialize());
+    TEST_ASSERT_FALSE(host.model().isOpen());
+}
+
+// Mapping cost does not grow with the model; a copy does
+void test_startup_time(void) {
+    ModelFileWriter writer("whisper");
+    std::vector<int8_t> blob(TEST_LARGE_TENSOR_BYTES);
+    for (size_t i = 0; i < blob.size(); i++) {
+        blob[i] = (int8_t)(i * 13);
+    }
+    for (uint32_t i = 0; i < TEST_LARGE_TENSORS; i++) {
+        char name[MODEL_TENSOR_NAME_LEN];
+        snprintf(name, sizeof(name), "layer%u.weight", (unsigned)i);
+        const uint32_t dims[] = {TEST_LARGE_TENSOR_BYTES / 1024, 1024};
+        TEST_ASSERT_TRUE(writer.add(name, ModelTensorType::INT8, dims, 2, blob.data()));
+    }
+    TEST_ASSERT_TRUE(writer.write(TEST_MODEL_PATH));
+
+    SpeechRecognizer recognizer;
+    TEST_ASSERT_TRUE(recognizer.initialize(TEST_MODEL_PATH));
+    uint64_t init_us = recognizer.stats().init_us;
+
+    // Baseline: what loading the same file into RAM costs
+    uint64_t start = audioMicros();
+    FILE* in = fopen(TEST_MODEL_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(in);
+    std::vector<uint8_t> copy(recognizer.model().fileBytes());
+    size_t read = fread(copy.data(), 1, copy.size(), in);
+    fclose(in);
+    uint64_t copy_us = audioMicros() - start;
+    TEST_ASSERT_EQUAL(copy.size(), read);
+
+    AUDIO_LOGF("Model %u KB: initialize %llu us (map %llu us), copy into RAM %llu us\n",
+               (unsigned)(recognizer.model().fileBytes() / 1024), (unsigned long long)init_us,
+               (unsigned long long)recognizer.model().openMicros(), (unsigned long long)copy_us);
+    TEST_ASSERT_LESS_THAN(copy_us, init_us);
+
+    // Touching a tensor reads the file contents through the mapping
+    ModelTensor last;
+    TEST_ASSERT_TRUE(recognizer.model().find("layer3.weight", &last));
+    TEST_ASSERT_EQUAL_MEMORY(blob.data(), last.data, blob.size());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_round_trip_in_place);
+    RUN_TEST(test_rejects_bad_containers);
+    RUN_TEST(test_recognizer_binds_model);
+    RUN_TEST(test_startup_time);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Model File Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
@@ -0,0 +1,353 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <atomic>
+#include <vector>
+#include "../../library/noise_suppressor.h"
+#include "../alloc_counter.h"
+#include "../test_signals.h"
+
+using namespace audio_processing;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const float TEST_SPEECH_RMS = 2000.0f;
+const size_t TEST_LEAD_SAMPLES = TEST_SAMPLE_RATE / 2;      // Noise only, for the initial estimate
+const size_t TEST_SPEECH_SAMPLES = 8 * TEST_SAMPLE_RATE;
+const float TEST_MIN_STATIONARY_GAIN_DB = 3.0f;             // SNR improvement on white and fan noise
+const float TEST_MIN_STREET_GAIN_DB = 1.0f;                 // Nonstationary noise is only partly tracked
+const float TEST_MAX_FIXED_LOSS_DB = 1.0f;                  // Fixed path against float
+const float TEST_MIN_NOISE_ATTENUATION_DB = 12.0f;
+const size_t TEST_FRAME_SAMPLES = 512;
+
+// Test instances
+NoiseSuppressor* ns = nullptr;
+
+enum class NoiseKind { WHITE, FAN, STREET };
+
+static const char* noiseName(NoiseKind kind) {
+    switch (kind) {
+        case NoiseKind::WHITE: return "white";
+        case NoiseKind::FAN: return "fan";
+        default: return "street";
+    }
+}
+
+// White: flat. Fan: low-passed rumble with mains hum harmonics. Street:
+// pink-ish noise whose level swells and fades as traffic passes
+static std::vector<float> noise(NoiseKind kind, size_t count, uint32_t seed, float rms) {
+    std::vector<float> out(count);
+    float state = 0.0f;
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        float x = uniformNoise(seed);
+        float t = (float)i / TEST_SAMPLE_RATE;
+        switch (kind) {
+            case NoiseKind::WHITE:
+                out[i] = x;
+                break;
+            case NoiseKind::FAN:
+                state = 0.95f * state + 0.05f * x;
+                out[i] = 4.0f * state + 0.2f * sinf(2.0f * (float)M_PI * 100.0f * t) +
+                         0.1f * sinf(2.0f * (float)M_PI * 200.0f * t);
+                break;
+            default: {
+                state = 0.8f * state + 0.2f * x;
+                float swell = 1.0f + 0.7f * sinf(2.0f * (float)M_PI * 0.3f * t) *
+                                     sinf(2.0f * (float)M_PI * 0.07f * t);
+                out[i] = state * swell;
+                break;
+            }
+        }
+        sum += (double)out[i] * out[i];
+    }
+    float scale = rms / sqrtf((float)(sum / count));
+    for (float& v : out) {
+        v *= scale;
+    }
+    return out;
+}
+
+static NoiseSuppressorConfig modeConfig(NoiseSuppressorMode mode) {
+    NoiseSuppressorConfig config = defaultNoiseSuppressorConfig(TEST_SAMPLE_RATE);
+    config.mode = mode;
+    return config;
+}
+
+static std::vector<int16_t> runSuppressor(NoiseSuppressor& suppressor, const std::vector<int16_t>& in) {
+    std::vector<int16_t> out(in.size());
+    for (size_t i = 0; i + TEST_FRAME_SAMPLES <= in.size(); i += TEST_FRAME_SAMPLES) {
+        TEST_ASSERT_TRUE(suppressor.process(&in[i], &out[i], TEST_FRAME_SAMPLES));
+    }
+    return out;
+}
+
+// SNR of out against clean delayed by latency, over [begin, end)
+static float snrDb(const std::vector<float>& clean, const std::vector<int16_t>& out, size_t latency,
+                   size_t begin, size_t end) {
+    double signal = 1.0, error = 1.0;
+    for (size_t i = begin; i < end; i++) {
+        double d = out[i] - clean[i - latency];
+        signal += (double)clean[i - latency] * clean[i - latency];
+        error += d * d;
+    }
+    return (float)(10.0 * log10(signal / error));
+}
+
+struct Benchmark {
+    float input_snr_db;
+    float output_snr_db;
+    double cycles_per_hop;
+    double us_per_hop;
+};
+
+// Noise-only lead, then speech in noise at input_snr_db
+static Benchmark benchmark(NoiseKind kind, float input_snr_db, NoiseSuppressorMode mode) {
+    const size_t count = TEST_LEAD_SAMPLES + TEST_SPEECH_SAMPLES;
+    std::vector<float> clean(count, 0.0f);
+    std::vector<float> speech = speechLike(TEST_SPEECH_SAMPLES, 21, TEST_SPEECH_RMS);
+    std::copy(speech.begin(), speech.end(), clean.begin() + TEST_LEAD_SAMPLES);
+    float noise_rms = TEST_SPEECH_RMS * powf(10.0f, -input_snr_db / 20.0f);
+    std::vector<float> mix = noise(kind, count, 22, noise_rms);
+    for (size_t i = 0; i < count; i++) {
+        mix[i] += clean[i];
+    }
+    std::vector<int16_t> in = toPcm(mix);
+
+    NoiseSuppressor suppressor;
+    TEST_ASSERT_TRUE(suppressor.init(modeConfig(mode)));
+    std::vector<int16_t> out = runSuppressor(suppressor, in);
+
+    const size_t latency = suppressor.latencySamples();
+    const size_t begin = TEST_LEAD_SAMPLES + TEST_SAMPLE_RATE / 2;
+    const NoiseStats& stats = suppressor.stats();
+    Benchmark result;
+    result.input_snr_db = snrDb(clean, in, 0, begin, count);
+    result.output_snr_db = snrDb(clean, out, latency, begin, count);
+    result.cycles_per_hop = (double)stats.total_cycles / stats.frames;
+    result.us_per_hop = (double)stats.process_us / stats.frames;
+    return result;
+}
+
+void setUp(void) {
+    ns = new NoiseSuppressor();
+}
+
+void tearDown(void) {
+    delete ns;
+    ns = nullptr;
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_default_config(void) {
+    NoiseSuppressorConfig config = defaultNoiseSuppressorConfig(16000);
+    TEST_ASSERT_EQUAL(128, config.hop_samples);
+    TEST_ASSERT_EQUAL(64, defaultNoiseSuppressorConfig(8000).hop_samples);
+    TEST_ASSERT_EQUAL(31, config.init_frames);
+
+    NoiseSuppressorConfig bad = config;
+    bad.hop_samples = 100;
+    TEST_ASSERT_FALSE(ns->init(bad));
+    bad = config;
+    bad.dd_smoothing = 1.0f;
+    TEST_ASSERT_FALSE(ns->init(bad));
+    TEST_ASSERT_TRUE(ns->init(config));
+    TEST_ASSERT_EQUAL(128, ns->latencySamples());
+
+    int16_t samples[100] = {};
+    TEST_ASSERT_FALSE(ns->process(samples, samples, 100));
+}
+
+void test_unit_gain_reconstructs_input(void) {
+    // A 0 dB floor forces every gain to one: the windows must then give
+    // back the input delayed by one hop
+    const size_t count = 64 * TEST_FRAME_SAMPLES;
+    std::vector<float> speech = speechLike(count, 3, TEST_SPEECH_RMS);
+    std::vector<int16_t> in = toPcm(speech);
+    const NoiseSuppressorMode modes[] = {NoiseSuppressorMode::FLOAT, NoiseSuppressorMode::FIXED};
+    for (NoiseSuppressorMode mode : modes) {
+        NoiseSuppressorConfig config = modeConfig(mode);
+        config.min_gain_db = 0.0f;
+        TEST_ASSERT_TRUE(ns->init(config));
+
+        std::vector<int16_t> out(count);
+#ifndef ARDUINO
+        allocations = 0;
+        count_allocations = true;
+#endif
+        for (size_t i = 0; i < count; i += TEST_FRAME_SAMPLES) {
+            TEST_ASSERT_TRUE(ns->process(&in[i], &out[i], TEST_FRAME_SAMPLES));
+        }
+#ifndef ARDUINO
+        count_allocations = false;
+        TEST_ASSERT_EQUAL(0, allocations.load());
+#endif
+
+        const size_t latency = ns->latencySamples();
+        int max_error = 0;
+        for (size_t i = latency; i < count; i++) {
+            int error = abs(out[i] - in[i - latency]);
+            max_error = error > max_error ? error : max_error;
+        }
+        float snr = snrDb(speech, out, latency, latency, count);
+        AUDIO_LOGF("%s reconstruction: max error %d, SNR %.1f dB\n",
+                   mode == NoiseSuppressorMode::FIXED ? "fixed" : "float", max_error, snr);
+        if (mode == NoiseSuppressorMode::FLOAT) {
+            TEST_ASSERT_LESS_OR_EQUAL(1, max_error);
+        } else {
+            TEST_ASSERT_GREATER_THAN_FLOAT(40.0f, snr);
+        }
+    }
+}
+
+void test_attenuates_stationary_noise(void) {
+    const NoiseSuppressorMode modes[] = {NoiseSuppressorMode::FLOAT, NoiseSuppressorMode::FIXED};
+    for (NoiseSuppressorMode mode : modes) {
+        TEST_ASSERT_TRUE(ns->init(modeConfig(mode)));
+        const size_t count = 4 * TEST_SAMPLE_RATE;
+        std::vector<int16_t> in = toPcm(noise(NoiseKind::WHITE, count, 5, 300.0f));
+        std::vector<int16_t> out = runSuppressor(*ns, in);
+
+        double ein = 1.0, eout = 1.0;
+        for (size_t i = TEST_SAMPLE_RATE; i < count; i++) {
+            ein += (double)in[i] * in[i];
+            eout += (double)out[i] * out[i];
+        }
+        float attenuation = (float)(10.0 * log10(ein / eout));
+        AUDIO_LOGF("%s noise-only attenuation: %.1f dB, %llu speech hops of %llu\n",
+                   mode == NoiseSuppressorMode::FIXED ? "fixed" : "float", attenuation,
+                   (unsigned long long)ns->stats().speech_frames, (unsigned long long)ns->stats().frames);
+        TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_NOISE_ATTENUATION_DB, attenuation);
+        TEST_ASSERT_LESS_THAN_FLOAT(-ns->config().min_gain_db + 1.0f, attenuation);
+        TEST_ASSERT_LESS_THAN(ns->stats().frames / 20, ns->stats().speech_frames);
+    }
+}
+
+void test_relearns_louder_background(void) {
+    // A fan switches on 10 dB above the old background with nobody
+    // talking: every hop then looks like speech until the estimate is
+    // relearned
+    TEST_ASSERT_TRUE(ns->init());
+    const size_t step = 2 * TEST_SAMPLE_RATE;
+    const size_t count = 7 * TEST_SAMPLE_RATE;
+    std::vector<float> quiet = noise(NoiseKind::FAN, count, 9, 100.0f);
+    std::vector<float> loud = noise(NoiseKind::FAN, count, 10, 316.0f);
+    std::vector<float> mix(quiet.begin(), quiet.begin() + step);
+    mix.insert(mix.end(), loud.begin() + step, loud.end());
+    std::vector<int16_t> in = toPcm(mix);
+    std::vector<int16_t> out = runSuppressor(*ns, in);
+
+    double ein = 1.0, eout = 1.0;
+    for (size_t i = count - TEST_SAMPLE_RATE; i < count; i++) {
+        ein += (double)in[i] * in[i];
+        eout += (double)out[i] * out[i];
+    }
+    float attenuation = (float)(10.0 * log10(ein / eout));
+    AUDIO_LOGF("after background step: %u relearns, attenuation %.1f dB\n",
+               (unsigned)ns->stats().noise_relearns, attenuation);
+    TEST_ASSERT_EQUAL(1, ns->stats().noise_relearns);
+    TEST_ASSERT_GREATER_THAN_FLOAT(TEST_MIN_NOISE_ATTENUATION_DB, attenuation);
+    TEST_ASSERT_FALSE(ns->isSpeech());
+}
+
+void test_snr_improvement_benchmark(void) {
+    // Host benchmark: SNR gain and cost per hop on synthetic noisy speech
+    const NoiseKind kinds[] = {NoiseKind::WHITE, NoiseKind::FAN, NoiseKind::STREET};
+    const float input_snrs[] = {0.0f, 5.0f};
+    for (NoiseKind kind : kinds) {
+        for (float input_snr : input_snrs) {
+            Benchmark fl = benchmark(kind, input_snr, NoiseSuppressorMode::FLOAT);
+            Benchmark fx = benchmark(kind, input_snr, NoiseSuppressorMode::FIXED);
+            AUDIO_LOGF("%-6s %4.1f dB in: float %5.1f dB (+%.1f, %.0f cycles, %.1f us/hop), "
+                       "fixed %5.1f dB (+%.1f, %.0f cycles, %.1f us/hop)\n",
+                       noiseName(kind), fl.input_snr_db, fl.output_snr_db, fl.output_snr_db - fl.input_snr_db,
+                       fl.cycles_per_hop, fl.us_per_hop, fx.output_snr_db, fx.output_snr_db - fx.input_snr_db,
+                       fx.cycles_per_hop, fx.us_per_hop);
+            float min_gain = kind == NoiseKind::STREET ? TEST_MIN_STREET_GAIN_DB : TEST_MIN_STATIONARY_GAIN_DB;
+            TEST_ASSERT_GREATER_THAN_FLOAT(min_gain, fl.output_snr_db - fl.input_snr_db);
+            TEST_ASSERT_GREATER_THAN_FLOAT(fl.output_snr_db - TEST_MAX_FIXED_LOSS_DB, fx.output_snr_db);
+            TEST_ASSERT_GREATER_THAN_FLOAT(0.0, fl.cycles_per_hop);
+        }
+    }
+}
+
+void test_stage_processes_frames_in_place(void) {
+    TEST_ASSERT_TRUE(ns->init());
+    NoiseSuppressor reference;
+    TEST_ASSERT_TRUE(reference.init());
+    FramePool pool;
+    TEST_ASSERT_TRUE(pool.init(4, TEST_FRAME_SAMPLES));
+
+    const size_t count = 64 * TEST_FRAME_SAMPLES;
+    std::vector<float> mix = speechLike(count, 11, TEST_SPEECH_RMS);
+    std::vector<float> background = noise(NoiseKind::WHITE, count, 12, 500.0f);
+    for (size_t i = 0; i < count; i++) {
+        mix[i] += background[i];
+    }
+    std::vector<int16_t> in = toPcm(mix);
+    std::vector<int16_t> expected = runSuppressor(reference, in);
+
+    PipelineRuntime::StageFunction stage = ns->stageFunction();
+    for (size_t i = 0; i < count; i += TEST_FRAME_SAMPLES) {
+        FrameRef frame = pool.acquire();
+        TEST_ASSERT_TRUE((bool)frame);
+        memcpy(frame->samples, &in[i], TEST_FRAME_SAMPLES * sizeof(int16_t));
+        frame->length = TEST_FRAME_SAMPLES;
+        TEST_ASSERT_TRUE(stage(frame));
+        TEST_ASSERT_EQUAL_INT16_ARRAY(&expected[i], frame->samples, TEST_FRAME_SAMPLES);
+    }
+
+    // Silence markers and odd lengths pass untouched
+    uint64_t frames = ns->stats().frames;
+    FrameRef marker = pool.acquire();
+    marker->length = 0;
+    marker->flags = FRAME_FLAG_SILENCE;
+    TEST_ASSERT_TRUE(stage(marker));
+    FrameRef odd = pool.acquire();
+    odd->length = 100;
+    odd->flags = 0;
+    for (size_t i = 0; i < 100; i++) {
+        odd->samples[i] = (int16_t)i;
+    }
+    TEST_ASSERT_TRUE(stage(odd));
+    TEST_ASSERT_EQUAL(99, odd->samples[99]);
+    TEST_ASSERT_EQUAL(frames, ns->stats().frames);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_config);
+    RUN_TEST(test_unit_gain_reconstructs_input);
+    RUN_TEST(test_attenuates_stationary_noise);
+    RUN_TEST(test_relearns_louder_background);
+    RUN_TEST(test_snr_improvement_benchmark);
+    RUN_TEST(test_stage_processes_frames_in_place);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Noise Suppressor Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
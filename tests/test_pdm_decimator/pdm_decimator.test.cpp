@@ -0,0 +1,200 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <vector>
+#include "../../library/pdm_decimator.h"
+
+using namespace audio_processing;
+
+// Test instances
+PDMDecimator* serial_dec = nullptr;
+PDMDecimator* parallel_dec = nullptr;
+
+// Test configuration constants
+const int TEST_DECIMATION_FACTOR = 64;
+const float TEST_TONE_HZ = 440.0f;
+const float TEST_PCM_RATE = 16000.0f;
+
+void setUp(void) {
+    serial_dec = new PDMDecimator();
+    parallel_dec = new PDMDecimator();
+}
+
+void tearDown(void) {
+    delete serial_dec;
+    serial_dec = nullptr;
+    delete parallel_dec;
+    parallel_dec = nullptr;
+}
+
+// First-order sigma-delta modulator producing LSB-first PDM bytes
+static std::vector<uint8_t> makePDMTone(size_t bytes, int decimation, float amplitude) {
+    std::vector<uint8_t> pdm(bytes, 0);
+    float integrator = 0.0f;
+    float bit_rate = TEST_PCM_RATE * decimation;
+    for (size_t i = 0; i < bytes * 8; i++) {
+        float x = amplitude * sinf(2.0f * (float)M_PI * TEST_TONE_HZ * i / bit_rate);
+        float y = integrator >= 0.0f ? 1.0f : -1.0f;
+        integrator += x - y;
+        if (y > 0) {
+            pdm[i / 8] |= (uint8_t)(1 << (i % 8));
+        }
+    }
+    return pdm;
+}
+
+static void checkBitExact(int decimation, int taps, size_t block_bytes, size_t blocks) {
+    TEST_ASSERT_TRUE(serial_dec->init(decimation, taps));
+    TEST_ASSERT_TRUE(parallel_dec->init(decimation, taps));
+    parallel_dec->setMinParallelSamples(2);
+
+    std::vector<uint8_t> pdm = makePDMTone(block_bytes * blocks, decimation, 0.5f);
+    size_t per_block = block_bytes * 8 / decimation;
+    std::vector<int16_t> a(per_block), b(per_block);
+
+    for (size_t blk = 0; blk < blocks; blk++) {
+        size_t na = a.size(), nb = b.size();
+        TEST_ASSERT_TRUE(serial_dec->decode(&pdm[blk * block_bytes], block_bytes, a.data(), &na));
+        TEST_ASSERT_TRUE(parallel_dec->decodeParallel(&pdm[blk * block_bytes], block_bytes, b.data(), &nb));
+        TEST_ASSERT_EQUAL(per_block, na);
+        TEST_ASSERT_EQUAL(na, nb);
+        TEST_ASSERT_EQUAL_INT16_ARRAY(a.data(), b.data(), na);
+    }
+}
+
+void test_parallel_bit_exact_default() {
+    checkBitExact(64, 0, 1024, 8);
+}
+
+void test_parallel_bit_exact_high_oversampling() {
+    checkBitExact(128, 512, 4096, 4);
+    serial_dec->deinit();
+    parallel_dec->deinit();
+    checkBitExact(256, 512, 4096, 4);
+}
+
+void test_parallel_bit_exact_small_blocks() {
+    // Blocks shorter than the filter exercise history across several blocks
+    checkBitExact(64, 256, 16, 64);
+}
+
+void test_block_split_matches_whole_stream() {
+    TEST_ASSERT_TRUE(serial_dec->init(TEST_DECIMATION_FACTOR));
+    TEST_ASSERT_TRUE(parallel_dec->init(TEST_DECIMATION_FACTOR));
+
+    std::vector<uint8_t> pdm = makePDMTone(4096, TEST_DECIMATION_FACTOR, 0.5f);
+    std::vector<int16_t> whole(512), pieces(512);
+    size_t n = whole.size();
+    TEST_ASSERT_TRUE(serial_dec->decode(pdm.data(), pdm.size(), whole.data(), &n));
+
+    size_t offset = 0, produced = 0;
+    const size_t sizes[] = {8, 512, 40, 1024, 2512};
+    for (size_t i = 0; i < 5; i++) {
+        size_t count = pieces.size() - produced;
+        TEST_ASSERT_TRUE(parallel_dec->decodeParallel(&pdm[offset], sizes[i], &pieces[produced], &count));
+        offset += sizes[i];
+        produced += count;
+    }
+    TEST_ASSERT_EQUAL(4096, offset);
+    TEST_ASSERT_EQUAL(512, produced);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(whole.data(), pieces.data(), 512);
+}
+
+void test_decoded_tone_tracks_input() {
+    TEST_ASSERT_TRUE(serial_dec->init(TEST_DECIMATION_FACTOR, 256));
+    std::vector<uint8_t> pdm = makePDMTone(8192, TEST_DECIMATION_FACTOR, 0.5f);
+    std::vector<int16_t> pcm(1024);
+    size_t n = pcm.size();
+    TEST_ASSERT_TRUE(serial_dec->decode(pdm.data(), pdm.size(), pcm.data(), &n));
+
+    // Skip the filter warm-up, then compare against the ideal tone allowing
+    // for the filter's group delay
+    float delay = (256 - 1) / 2.0f / TEST_DECIMATION_FACTOR;
+    double err = 0.0, ref = 0.0;
+    for (size_t i = 64; i < n; i++) {
+        float t = (i + 1) - delay - 1.0f / TEST_DECIMATION_FACTOR;
+        float expected = 0.5f * 32767.0f * sinf(2.0f * (float)M_PI * TEST_TONE_HZ * t / TEST_PCM_RATE);
+        err += (pcm[i] - expected) * (pcm[i] - expected);
+        ref += expected * expected;
+    }
+    float snr = 10.0f * log10f((float)(ref / err));
+    TEST_ASSERT_GREATER_THAN_FLOAT(20.0f, snr);
+}
+
+void test_rejects_invalid_sizes() {
+    TEST_ASSERT_FALSE(serial_dec->init(60));
+    TEST_ASSERT_TRUE(serial_dec->init(TEST_DECIMATION_FACTOR));
+    uint8_t pdm[12] = {0};
+    int16_t pcm[4];
+    size_t n = 4;
+    TEST_ASSERT_FALSE(serial_dec->decode(pdm, 12, pcm, &n)); // not a multiple of 8 bytes
+    n = 0;
+    TEST_ASSERT_FALSE(serial_dec->decode(pdm, 8, pcm, &n));  // no room for output
+}
+
+void test_parallel_scaling() {
+    const int decimation = 128;
+    const size_t block_bytes = 32768;
+    const int iterations = 20;
+    TEST_ASSERT_TRUE(serial_dec->init(decimation, 1024));
+    TEST_ASSERT_TRUE(parallel_dec->init(decimation, 1024));
+
+    std::vector<uint8_t> pdm = makePDMTone(block_bytes, decimation, 0.5f);
+    std::vector<int16_t> pcm(block_bytes * 8 / decimation);
+
+    uint64_t begin = audioMicros();
+    for (int i = 0; i < iterations; i++) {
+        size_t n = pcm.size();
+        serial_dec->decode(pdm.data(), pdm.size(), pcm.data(), &n);
+    }
+    uint64_t serial_us = audioMicros() - begin;
+
+    begin = audioMicros();
+    for (int i = 0; i < iterations; i++) {
+        size_t n = pcm.size();
+        parallel_dec->decodeParallel(pdm.data(), pdm.size(), pcm.data(), &n);
+    }
+    uint64_t parallel_us = audioMicros() - begin;
+
+    AUDIO_LOGF("PDM decode x%d, 1024 taps: serial %llu us, parallel %llu us, speedup %.2fx\n",
+               decimation, (unsigned long long)serial_us, (unsigned long long)parallel_us,
+               (float)serial_us / (float)parallel_us);
+    TEST_ASSERT_GREATER_THAN(0, parallel_us);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_parallel_bit_exact_default);
+    RUN_TEST(test_parallel_bit_exact_high_oversampling);
+    RUN_TEST(test_parallel_bit_exact_small_blocks);
+    RUN_TEST(test_block_split_matches_whole_stream);
+    RUN_TEST(test_decoded_tone_tracks_input);
+    RUN_TEST(test_rejects_invalid_sizes);
+    RUN_TEST(test_parallel_scaling);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting PDM Decimator Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
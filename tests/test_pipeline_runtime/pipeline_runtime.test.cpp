@@ -0,0 +1,243 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "../../library/pipeline_runtime.h"
+
+using namespace audio_processing;
+
+// Test instances
+FramePool* pool = nullptr;
+PipelineRuntime* runtime = nullptr;
+
+// Test configuration constants
+const size_t TEST_FRAME_COUNT = 16;
+const size_t TEST_FRAME_SAMPLES = 256;
+const uint32_t TEST_FRAMES = 200;
+
+void setUp(void) {
+    pool = new FramePool();
+    TEST_ASSERT_TRUE(pool->init(TEST_FRAME_COUNT, TEST_FRAME_SAMPLES));
+    runtime = new PipelineRuntime();
+}
+
+void tearDown(void) {
+    delete runtime;
+    runtime = nullptr;
+    delete pool;
+    pool = nullptr;
+}
+
+static void sleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static bool waitFor(const std::atomic<uint32_t>& counter, uint32_t target, uint32_t timeout_ms) {
+    for (uint32_t waited = 0; waited < timeout_ms; waited++) {
+        if (counter.load() >= target) {
+            return true;
+        }
+        sleepMs(1);
+    }
+    return counter.load() >= target;
+}
+
+void test_default_placement() {
+    TEST_ASSERT_EQUAL(PIPELINE_CORE_DSP, defaultStageConfig(StageRole::CAPTURE, "capture").core);
+    TEST_ASSERT_EQUAL(PIPELINE_CORE_DSP, defaultStageConfig(StageRole::PDM_CONVERSION, "pdm").core);
+    TEST_ASSERT_EQUAL(PIPELINE_CORE_DSP, defaultStageConfig(StageRole::VAD, "vad").core);
+    TEST_ASSERT_EQUAL(PIPELINE_CORE_IO, defaultStageConfig(StageRole::BLUETOOTH, "bt").core);
+    TEST_ASSERT_EQUAL(PIPELINE_CORE_IO, defaultStageConfig(StageRole::SD_STORAGE, "sd").core);
+    TEST_ASSERT_GREATER_THAN(defaultStageConfig(StageRole::BLUETOOTH, "bt").priority,
+                             defaultStageConfig(StageRole::CAPTURE, "capture").priority);
+}
+
+void test_stage_wiring_preserves_order() {
+    std::atomic<uint32_t> produced(0);
+    std::atomic<uint32_t> received(0);
+    std::atomic<uint32_t> out_of_order(0);
+
+    StageConfig capture_cfg = defaultStageConfig(StageRole::CAPTURE, "capture");
+    StageConfig pdm_cfg = defaultStageConfig(StageRole::PDM_CONVERSION, "pdm");
+    StageConfig sd_cfg = defaultStageConfig(StageRole::SD_STORAGE, "sd");
+    pdm_cfg.policy = BackpressurePolicy::BLOCK;
+    sd_cfg.policy = BackpressurePolicy::BLOCK;
+
+    int capture = runtime->addStage(capture_cfg, [&](FrameRef& frame) {
+        if (produced.load() >= TEST_FRAMES) {
+            return false;
+        }
+        frame = pool->acquire();
+        if (!frame) {
+            return false;
+        }
+        for (size_t i = 0; i < frame->capacity; i++) {
+            frame->samples[i] = (int16_t)produced.load();
+        }
+        frame->length = frame->capacity;
+        produced++;
+        return true;
+    });
+
+    int pdm = runtime->addStage(pdm_cfg, [](FrameRef& frame) {
+        for (size_t i = 0; i < frame.size(); i++) {
+            frame.data()[i] = (int16_t)(frame.data()[i] * 2);
+        }
+        return true;
+    });
+
+    int sd = runtime->addStage(sd_cfg, [&](FrameRef& frame) {
+        if (frame.data()[0] != (int16_t)(received.load() * 2)) {
+            out_of_order++;
+        }
+        received++;
+        return false;
+    });
+
+    TEST_ASSERT_TRUE(runtime->connect(capture, pdm));
+    TEST_ASSERT_TRUE(runtime->connect(pdm, sd));
+    TEST_ASSERT_FALSE(runtime->connect(capture, sd)); // sd already has an input
+
+    TEST_ASSERT_TRUE(runtime->start());
+    TEST_ASSERT_TRUE(waitFor(received, TEST_FRAMES, 5000));
+    runtime->stop();
+
+    TEST_ASSERT_EQUAL(TEST_FRAMES, received.load());
+    TEST_ASSERT_EQUAL(0, out_of_order.load());
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+void test_fan_out_to_io_stages() {
+    std::atomic<uint32_t> produced(0);
+    std::atomic<uint32_t> bt_frames(0);
+    std::atomic<uint32_t> sd_frames(0);
+
+    int vad = runtime->addStage(defaultStageConfig(StageRole::VAD, "vad"), [&](FrameRef& frame) {
+        if (produced.load() >= 20) {
+            return false;
+        }
+        frame = pool->acquire();
+        if (!frame) {
+            return false;
+        }
+        frame->length = frame->capacity;
+        produced++;
+        return true;
+    });
+    StageConfig bt_cfg = defaultStageConfig(StageRole::BLUETOOTH, "bt");
+    StageConfig sd_cfg = defaultStageConfig(StageRole::SD_STORAGE, "sd");
+    bt_cfg.policy = BackpressurePolicy::BLOCK;
+    sd_cfg.policy = BackpressurePolicy::BLOCK;
+    int bt = runtime->addStage(bt_cfg, [&](FrameRef&) { bt_frames++; return false; });
+    int sd = runtime->addStage(sd_cfg, [&](FrameRef&) { sd_frames++; return false; });
+
+    TEST_ASSERT_TRUE(runtime->connect(vad, bt));
+    TEST_ASSERT_TRUE(runtime->connect(vad, sd));
+    TEST_ASSERT_TRUE(runtime->start());
+    TEST_ASSERT_TRUE(waitFor(bt_frames, 20, 2000));
+    TEST_ASSERT_TRUE(waitFor(sd_frames, 20, 2000));
+    runtime->stop();
+
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+void test_cpu_utilization_reported() {
+    std::atomic<uint32_t> produced(0);
+
+    int source = runtime->addStage(defaultStageConfig(StageRole::CAPTURE, "capture"), [&](FrameRef& frame) {
+        frame = pool->acquire();
+        if (!frame) {
+            return false;
+        }
+        produced++;
+        sleepMs(2);
+        return true;
+    });
+    int busy = runtime->addStage(defaultStageConfig(StageRole::PDM_CONVERSION, "pdm"), [](FrameRef&) {
+        // Spin for ~1 ms per frame to simulate DSP load
+        uint64_t begin = audioMicros();
+        while (audioMicros() - begin < 1000) {
+        }
+        return false;
+    });
+    TEST_ASSERT_TRUE(runtime->connect(source, busy));
+
+    TEST_ASSERT_TRUE(runtime->start());
+    TEST_ASSERT_TRUE(waitFor(produced, 50, 2000));
+    runtime->stop();
+
+    StageStats stats;
+    TEST_ASSERT_TRUE(runtime->getStageStats(busy, &stats));
+    runtime->printStats();
+    TEST_ASSERT_GREATER_THAN(0, stats.frames_processed);
+    TEST_ASSERT_GREATER_THAN_FLOAT(5.0f, stats.cpu_utilization);
+    TEST_ASSERT_LESS_THAN_FLOAT(100.0f, stats.cpu_utilization);
+}
+
+void test_throughput() {
+    std::atomic<uint32_t> received(0);
+    const uint32_t frames = 5000;
+
+    StageConfig sink_cfg = defaultStageConfig(StageRole::BLUETOOTH, "sink");
+    sink_cfg.policy = BackpressurePolicy::BLOCK;
+    std::atomic<uint32_t> produced(0);
+    int source = runtime->addStage(defaultStageConfig(StageRole::CAPTURE, "capture"), [&](FrameRef& frame) {
+        if (produced.load() >= frames) {
+            return false;
+        }
+        frame = pool->acquire();
+        if (!frame) {
+            return false;
+        }
+        produced++;
+        return true;
+    });
+    int sink = runtime->addStage(sink_cfg, [&](FrameRef&) { received++; return false; });
+    TEST_ASSERT_TRUE(runtime->connect(source, sink));
+
+    uint64_t begin = audioMicros();
+    TEST_ASSERT_TRUE(runtime->start());
+    TEST_ASSERT_TRUE(waitFor(received, frames, 10000));
+    uint64_t elapsed = audioMicros() - begin;
+    runtime->stop();
+
+    float fps = frames * 1e6f / (float)elapsed;
+    AUDIO_LOGF("Pipeline throughput: %.0f frames/s (%.1fx real time at 16 kHz)\n",
+               fps, fps * TEST_FRAME_SAMPLES / 16000.0f);
+    TEST_ASSERT_EQUAL(frames, received.load());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_default_placement);
+    RUN_TEST(test_stage_wiring_preserves_order);
+    RUN_TEST(test_fan_out_to_io_stages);
+    RUN_TEST(test_cpu_utilization_reported);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Pipeline Runtime Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
@@ -0,0 +1,193 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "../../library/preroll_buffer.h"
+#include "../alloc_counter.h"
+
+using namespace audio_processing;
+
+// Test instances
+FramePool* pool = nullptr;
+PreRollBuffer* preroll = nullptr;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_FRAME_SAMPLES = 256;
+const size_t TEST_POOL_FRAMES = 48;
+const uint32_t TEST_PREROLL_MS = 300;
+
+void setUp(void) {
+    pool = new FramePool();
+    TEST_ASSERT_TRUE(pool->init(TEST_POOL_FRAMES, TEST_FRAME_SAMPLES));
+    preroll = new PreRollBuffer();
+}
+
+void tearDown(void) {
+    delete preroll;
+    preroll = nullptr;
+    delete pool;
+    pool = nullptr;
+}
+
+// Frame whose samples continue a global ramp, so any gap or repeat shows
+static FrameRef makeFrame(uint32_t index) {
+    FrameRef frame = pool->acquire();
+    if (!frame) {
+        return frame;
+    }
+    for (size_t i = 0; i < TEST_FRAME_SAMPLES; i++) {
+        frame->samples[i] = (int16_t)(uint16_t)(index * TEST_FRAME_SAMPLES + i);
+    }
+    frame->length = TEST_FRAME_SAMPLES;
+    return frame;
+}
+
+static uint32_t frameIndex(const FrameRef& frame) {
+    return (uint16_t)frame.data()[0] / TEST_FRAME_SAMPLES;
+}
+
+void test_frames_for_duration() {
+    TEST_ASSERT_EQUAL(10, PreRollBuffer::framesFor(300, 16000, 512));
+    TEST_ASSERT_EQUAL(32, PreRollBuffer::framesFor(1000, 16000, 512));
+    TEST_ASSERT_EQUAL(19, PreRollBuffer::framesFor(300, 16000, 256));
+    TEST_ASSERT_EQUAL(0, PreRollBuffer::framesFor(300, 16000, 0));
+}
+
+void test_ring_keeps_newest_frames() {
+    TEST_ASSERT_TRUE(preroll->init(4));
+    for (uint32_t i = 0; i < 10; i++) {
+        preroll->push(makeFrame(i));
+    }
+    TEST_ASSERT_EQUAL(4, preroll->size());
+    TEST_ASSERT_EQUAL(6, preroll->evicted());
+    TEST_ASSERT_EQUAL(4 * TEST_FRAME_SAMPLES, preroll->historySamples());
+
+    // Evicted frames went back to the pool, held ones did not
+    TEST_ASSERT_EQUAL(TEST_POOL_FRAMES - 4, pool->available());
+
+    FrameRef history[3];
+    TEST_ASSERT_EQUAL(3, preroll->takeHistory(history, 3));
+    TEST_ASSERT_EQUAL(7, frameIndex(history[0]));
+    TEST_ASSERT_EQUAL(8, frameIndex(history[1]));
+    TEST_ASSERT_EQUAL(9, frameIndex(history[2]));
+    TEST_ASSERT_EQUAL(0, preroll->size());
+
+    for (int i = 0; i < 3; i++) {
+        history[i].reset();
+    }
+    TEST_ASSERT_EQUAL(TEST_POOL_FRAMES, pool->available());
+}
+
+void test_history_is_shared_not_copied() {
+    TEST_ASSERT_TRUE(preroll->init(2));
+    FrameRef frame = makeFrame(0);
+    preroll->push(frame);
+    TEST_ASSERT_EQUAL(2, frame->refs.load());
+
+    FrameRef history[2];
+    TEST_ASSERT_EQUAL(1, preroll->takeHistory(history, 2));
+    TEST_ASSERT_EQUAL_PTR(frame.data(), history[0].data());
+    TEST_ASSERT_EQUAL(2, frame->refs.load());
+}
+
+void test_trigger_continuity_and_no_allocation() {
+    size_t frames = PreRollBuffer::framesFor(TEST_PREROLL_MS, TEST_SAMPLE_RATE, TEST_FRAME_SAMPLES);
+    TEST_ASSERT_TRUE(preroll->init(frames));
+
+    FrameFanout fanout;
+    int consumer = fanout.addConsumer("stt", TEST_POOL_FRAMES, BackpressurePolicy::BLOCK, 1000);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, consumer);
+
+    // Capture task: pushes a frame per ms, regardless of the trigger
+    std::atomic<bool> running(true);
+    std::atomic<uint32_t> captured(0);
+    std::thread capture([&] {
+        uint32_t index = 0;
+        while (running.load()) {
+            FrameRef frame = makeFrame(index);
+            if (frame) {
+                preroll->push(frame);
+                index++;
+                captured.store(index);
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    while (captured.load() < 3 * frames) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+#ifndef ARDUINO
+    allocations.store(0);
+    count_allocations = true;
+#endif
+    size_t history = preroll->trigger(fanout);
+#ifndef ARDUINO
+    count_allocations = false;
+    TEST_ASSERT_EQUAL(0, allocations.load());
+#endif
+    TEST_ASSERT_EQUAL(frames, history);
+    TEST_ASSERT_TRUE(preroll->isLive());
+
+    // History then live frames: one unbroken sample ramp
+    const size_t expected = history + 20;
+    uint16_t previous = 0;
+    uint32_t discontinuities = 0;
+    for (size_t received = 0; received < expected; received++) {
+        FrameRef frame;
+        TEST_ASSERT_TRUE(fanout.receive(consumer, frame, 1000));
+        for (size_t i = 0; i < frame.size(); i++) {
+            uint16_t sample = (uint16_t)frame.data()[i];
+            if ((received > 0 || i > 0) && sample != (uint16_t)(previous + 1)) {
+                discontinuities++;
+            }
+            previous = sample;
+        }
+    }
+    TEST_ASSERT_EQUAL(0, discontinuities);
+
+    running.store(false);
+    capture.join();
+    preroll->stopLive();
+    TEST_ASSERT_FALSE(preroll->isLive());
+
+    fanout.clear();
+    preroll->clear();
+    TEST_ASSERT_EQUAL(TEST_POOL_FRAMES, pool->available());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_frames_for_duration);
+    RUN_TEST(test_ring_keeps_newest_frames);
+    RUN_TEST(test_history_is_shared_not_copied);
+    RUN_TEST(test_trigger_continuity_and_no_allocation);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Pre-roll Buffer Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
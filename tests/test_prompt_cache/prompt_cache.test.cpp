@@ -0,0 +1,541 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "../../library/prompt_cache.h"
+#include "../../library/speech_synthesizer.h"
+#include "../../library/audio_platform.h"
+#include "../alloc_counter.h"
+
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_ENTRY_SAMPLES = 16000;        // 1 s, 32 blocks
+const size_t TEST_ENTRY_BYTES = 32 * PROMPT_BLOCK_BYTES;
+const int TEST_BENCHMARK_REQUESTS = 400;
+#ifdef ARDUINO
+const char* TEST_SD_DIRECTORY = "/sdcard/prompt_test";
+#else
+const char* TEST_SD_DIRECTORY = "/tmp/prompt_cache_test";
+#endif
+
+const char* const TEST_PROMPTS[] = {
+    "Listening.", "Sorry, I didn't catch that.", "Okay.", "Done.", "Timer set.", "Timer cancelled.",
+    "I'm not sure how to help with that.", "Turning on the lights.", "Turning off the lights.",
+    "Volume up.", "Volume down.", "Here's what I found.", "Please try again.", "Goodbye!",
+    "Connecting to Wi-Fi.", "Wi-Fi connected.", "Battery low.", "Charging.", "Update available.",
+    "Restarting now.", "The alarm is set.", "Alarm stopped.", "Music paused.", "Resuming.",
+    "Bluetooth pairing.", "Paired.", "No internet connection.", "Muted.", "Unmuted.", "Hello!",
+    "Good morning.", "Good night.", "One moment.", "Still working on it.", "That's all.",
+    "I can't reach the server.", "Your reminder is saved.", "Microphone off.", "Microphone on.", "Ready.",
+};
+const size_t TEST_PROMPT_COUNT = sizeof(TEST_PROMPTS) / sizeof(TEST_PROMPTS[0]);
+
+// Test instances
+class CollectSink : public AudioSink {
+public:
+    bool begin(int sample_rate) override {
+        rate = sample_rate;
+        audio.clear();
+        return true;
+    }
+    bool write(const int16_t* samples, size_t count) override {
+        audio.insert(audio.end(), samples, samples + count);
+        return true;
+    }
+    void end() override {}
+
+    int rate = 0;
+    std::vector<int16_t> audio;
+};
+
+std::vector<int16_t> sweep(size_t count, float start_hz, float amplitude = 8000.0f) {
+    std::vector<int16_t> audio(count);
+    float phase = 0.0f;
+    for (size_t i = 0; i < count; i++) {
+        float hz = start_hz + 2000.0f * (float)i / (float)count;
+        phase += 2.0f * (float)M_PI * hz / TEST_SAMPLE_RATE;
+        audio[i] = (int16_t)(amplitude * sinf(phase));
+    }
+    return audio;
+}
+
+float snrDb(const std::vector<int16_t>& reference, const std::vector<int16_t>& decoded) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i = 0; i < reference.size() && i < decoded.size(); i++) {
+        double e = (double)reference[i] - (double)decoded[i];
+        signal += (double)reference[i] * reference[i];
+        noise += e * e;
+    }
+    return (float)(10.0 * log10(signal / (noise > 0.0 ? noise : 1e-9)));
+}
+
+bool insert(PromptCache& cache, uint64_t key, const std::vector<int16_t>& audio) {
+    cache.beginInsert(key);
+    // In uneven pieces, as a backend hands them over
+    for (size_t pos = 0; pos < audio.size();) {
+        size_t n = audio.size() - pos < 777 ? audio.size() - pos : 777;
+        if (!cache.append(audio.data() + pos, n)) {
+            return false;
+        }
+        pos += n;
+    }
+    return cache.commitInsert();
+}
+
+PromptPlayback playInto(PromptCache& cache, uint64_t key, std::vector<int16_t>& out) {
+    out.clear();
+    return cache.play(key, [&out](const int16_t* samples, size_t count) {
+        out.insert(out.end(), samples, samples + count);
+        return true;
+    });
+}
+
+PromptCacheConfig testConfig(size_t entries_in_budget, const char* sd_directory = nullptr) {
+    PromptCacheConfig config = defaultPromptCacheConfig();
+    config.psram_budget_bytes = entries_in_budget * TEST_ENTRY_BYTES;
+    config.max_entry_samples = 4 * TEST_ENTRY_SAMPLES;
+    config.sd_directory = sd_directory;
+    return config;
+}
+
+// Empties the SD tier left over from an earlier run
+void clearSdDirectory() {
+    PromptCache cache(testConfig(1, TEST_SD_DIRECTORY));
+    cache.init();
+    cache.clear();
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_prompt_key(void) {
+    TtsVoice voice = defaultTtsVoice();
+    uint64_t key = promptKey("listening.", 10, voice, TEST_SAMPLE_RATE);
+    TEST_ASSERT_TRUE(key == promptKey("listening.", 10, voice, TEST_SAMPLE_RATE));
+    TEST_ASSERT_FALSE(key == promptKey("listening!", 10, voice, TEST_SAMPLE_RATE));
+    TEST_ASSERT_FALSE(key == promptKey("listening.", 10, voice, 22050));
+
+    TtsVoice other = voice;
+    other.speaker = 3;
+    TEST_ASSERT_FALSE(key == promptKey("listening.", 10, other, TEST_SAMPLE_RATE));
+    other = voice;
+    other.length_scale = 1.1f;
+    TEST_ASSERT_FALSE(key == promptKey("listening.", 10, other, TEST_SAMPLE_RATE));
+    other = voice;
+    other.length_scale += 1e-5f;                // Below the key's resolution
+    TEST_ASSERT_TRUE(key == promptKey("listening.", 10, other, TEST_SAMPLE_RATE));
+}
+
+void test_round_trip_is_compressed(void) {
+    PromptCache cache(testConfig(4));
+    TEST_ASSERT_TRUE(cache.init());
+    std::vector<int16_t> audio = sweep(TEST_ENTRY_SAMPLES + 400, 200.0f);
+    TEST_ASSERT_TRUE(insert(cache, 1, audio));
+    TEST_ASSERT_EQUAL(1, cache.stats().entries);
+    TEST_ASSERT_EQUAL(33 * PROMPT_BLOCK_BYTES, cache.stats().bytes);    // 4:1 on 16-bit PCM
+
+    std::vector<int16_t> out;
+    TEST_ASSERT_TRUE(playInto(cache, 1, out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_EQUAL(audio.size(), out.size());
+    TEST_ASSERT_EQUAL(audio[0], out[0]);
+    TEST_ASSERT_EQUAL(audio[PROMPT_BLOCK_SAMPLES], out[PROMPT_BLOCK_SAMPLES]);   // Block headers are exact
+    TEST_ASSERT_GREATER_THAN_FLOAT(20.0f, snrDb(audio, out));
+
+    TEST_ASSERT_TRUE(playInto(cache, 2, out) == PromptPlayback::MISS);
+    TEST_ASSERT_EQUAL(0, out.size());
+    TEST_ASSERT_EQUAL(2, cache.stats().lookups);
+    TEST_ASSERT_EQUAL(1, cache.stats().hits);
+    TEST_ASSERT_EQUAL_FLOAT(0.5f, cache.hitRate());
+
+    // Stopping mid-way leaves the entry in place
+    size_t blocks = 0;
+    PromptPlayback playback = cache.play(1, [&blocks](const int16_t*, size_t) { return ++blocks < 3; });
+    TEST_ASSERT_TRUE(playback == PromptPlayback::STOPPED);
+    TEST_ASSERT_EQUAL(3, blocks);
+    TEST_ASSERT_TRUE(cache.contains(1));
+}
+
+void test_lru_evicts_by_bytes(void) {
+    PromptCache cache(testConfig(3));
+    TEST_ASSERT_TRUE(cache.init());
+    std::vector<int16_t> audio = sweep(TEST_ENTRY_SAMPLES, 300.0f);
+    std::vector<int16_t> out;
+    TEST_ASSERT_TRUE(insert(cache, 'A', audio));
+    TEST_ASSERT_TRUE(insert(cache, 'B', audio));
+    TEST_ASSERT_TRUE(insert(cache, 'C', audio));
+    TEST_ASSERT_EQUAL(3 * TEST_ENTRY_BYTES, cache.stats().bytes);
+    TEST_ASSERT_EQUAL(0, cache.stats().evictions);
+
+    // A is used again, so B is now the least recent
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_TRUE(insert(cache, 'D', audio));
+    TEST_ASSERT_EQUAL(1, cache.stats().evictions);
+    TEST_ASSERT_TRUE(cache.contains('A'));
+    TEST_ASSERT_FALSE(cache.contains('B'));
+    TEST_ASSERT_TRUE(cache.contains('C'));
+    TEST_ASSERT_TRUE(cache.contains('D'));
+
+    // A double-length entry pushes out the two least recent
+    std::vector<int16_t> longer = sweep(2 * TEST_ENTRY_SAMPLES, 300.0f);
+    TEST_ASSERT_TRUE(insert(cache, 'E', longer));
+    TEST_ASSERT_EQUAL(3, cache.stats().evictions);
+    TEST_ASSERT_FALSE(cache.contains('A'));
+    TEST_ASSERT_FALSE(cache.contains('C'));
+    TEST_ASSERT_TRUE(cache.contains('D'));
+    TEST_ASSERT_TRUE(cache.contains('E'));
+    TEST_ASSERT_LESS_OR_EQUAL(cache.config().psram_budget_bytes, cache.stats().bytes);
+    TEST_ASSERT_EQUAL(2, cache.stats().entries);
+
+    // The entry count is a limit of its own
+    PromptCacheConfig config = testConfig(100);
+    config.max_entries = 2;
+    PromptCache few(config);
+    TEST_ASSERT_TRUE(few.init());
+    for (uint64_t key = 1; key <= 5; key++) {
+        TEST_ASSERT_TRUE(insert(few, key, audio));
+    }
+    TEST_ASSERT_EQUAL(2, few.stats().entries);
+    TEST_ASSERT_EQUAL(3, few.stats().evictions);
+    TEST_ASSERT_TRUE(few.contains(4));
+    TEST_ASSERT_TRUE(few.contains(5));
+}
+
+void test_rejects_what_does_not_fit(void) {
+    PromptCache cache(testConfig(3));
+    TEST_ASSERT_TRUE(cache.init());
+
+    // Longer than max_entry_samples: dropped while recording
+    std::vector<int16_t> too_long = sweep(4 * TEST_ENTRY_SAMPLES + 1, 300.0f);
+    TEST_ASSERT_FALSE(insert(cache, 1, too_long));
+    TEST_ASSERT_FALSE(cache.isRecording());
+    TEST_ASSERT_FALSE(cache.commitInsert());
+
+    // Fits the recording but not the budget
+    std::vector<int16_t> large = sweep(4 * TEST_ENTRY_SAMPLES, 300.0f);
+    TEST_ASSERT_TRUE(insert(cache, 7, sweep(TEST_ENTRY_SAMPLES, 300.0f)));
+    TEST_ASSERT_FALSE(insert(cache, 2, large));
+    TEST_ASSERT_EQUAL(2, cache.stats().rejected);
+    TEST_ASSERT_TRUE(cache.contains(7));                // Nothing evicted for it
+
+    // Aborted and empty recordings are not stored
+    cache.beginInsert(3);
+    cache.append(large.data(), 1000);
+    cache.abortInsert();
+    TEST_ASSERT_FALSE(cache.contains(3));
+    cache.beginInsert(4);
+    TEST_ASSERT_FALSE(cache.commitInsert());
+    TEST_ASSERT_EQUAL(1, cache.stats().inserts);
+}
+
+void test_sd_tier_spills_and_promotes(void) {
+    clearSdDirectory();
+    PromptCache cache(testConfig(2, TEST_SD_DIRECTORY));
+    TEST_ASSERT_TRUE(cache.init());
+    std::vector<int16_t> a = sweep(TEST_ENTRY_SAMPLES, 250.0f);
+    std::vector<int16_t> out;
+    TEST_ASSERT_TRUE(insert(cache, 'A', a));
+    TEST_ASSERT_TRUE(insert(cache, 'B', a));
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_TRUE(playInto(cache, 'B', out) == PromptPlayback::PLAYED);
+    std::vector<int16_t> psram_copy = out;
+
+    // A was played, so its eviction is written out; C never was and is not
+    TEST_ASSERT_TRUE(insert(cache, 'C', a));
+    TEST_ASSERT_EQUAL(1, cache.stats().spills);
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_entries);
+    TEST_ASSERT_EQUAL(TEST_ENTRY_BYTES + 24, cache.stats().sd_bytes);
+    TEST_ASSERT_TRUE(insert(cache, 'D', a));
+    TEST_ASSERT_EQUAL(2, cache.stats().spills);          // B
+    TEST_ASSERT_TRUE(insert(cache, 'E', a));
+    TEST_ASSERT_EQUAL(2, cache.stats().spills);          // C, unplayed, is dropped
+    TEST_ASSERT_FALSE(cache.contains('C'));
+
+    // From the card, identical to the PSRAM copy, and back in PSRAM
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_hits);
+    TEST_ASSERT_EQUAL(psram_copy.size(), out.size());
+    TEST_ASSERT_EQUAL_INT16_ARRAY(psram_copy.data(), out.data(), out.size());
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_hits);
+    TEST_ASSERT_EQUAL(3, cache.stats().psram_hits);
+
+    // Evicting the promoted copy again does not rewrite the file
+    const uint32_t spills = cache.stats().spills;
+    TEST_ASSERT_TRUE(insert(cache, 'F', a));
+    TEST_ASSERT_TRUE(insert(cache, 'G', a));
+    TEST_ASSERT_EQUAL(spills, cache.stats().spills);
+    TEST_ASSERT_TRUE(cache.contains('A'));
+}
+
+// Promoting the only file on a one-entry card must not spill it away
+void test_sd_tier_single_entry_promotes(void) {
+    clearSdDirectory();
+    PromptCacheConfig config = testConfig(1, TEST_SD_DIRECTORY);
+    config.max_sd_entries = 1;
+    PromptCache cache(config);
+    TEST_ASSERT_TRUE(cache.init());
+    std::vector<int16_t> a = sweep(TEST_ENTRY_SAMPLES, 250.0f);
+    std::vector<int16_t> out;
+    TEST_ASSERT_TRUE(insert(cache, 'A', a));
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_TRUE(insert(cache, 'B', a));
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_entries);      // A
+    TEST_ASSERT_TRUE(playInto(cache, 'B', out) == PromptPlayback::PLAYED);
+
+    // Making room for A evicts B, whose spill finds only the pinned A
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_EQUAL(a.size(), out.size());
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_hits);
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_entries);
+    TEST_ASSERT_EQUAL(0, cache.stats().sd_errors);
+    TEST_ASSERT_FALSE(cache.contains('B'));
+    TEST_ASSERT_TRUE(playInto(cache, 'A', out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_EQUAL(1, cache.stats().sd_hits);
+    cache.clear();
+}
+
+void test_sd_tier_budget_and_restart(void) {
+    clearSdDirectory();
+    PromptCacheConfig config = testConfig(1, TEST_SD_DIRECTORY);
+    config.sd_budget_bytes = 3 * (TEST_ENTRY_BYTES + 24);
+    std::vector<int16_t> audio = sweep(TEST_ENTRY_SAMPLES, 400.0f);
+    std::vector<int16_t> out;
+    {
+        PromptCache cache(config);
+        TEST_ASSERT_TRUE(cache.init());
+        // Each entry is played once, then pushed to the card by the next
+        for (uint64_t key = 1; key <= 6; key++) {
+            TEST_ASSERT_TRUE(insert(cache, key, audio));
+            TEST_ASSERT_TRUE(playInto(cache, key, out) == PromptPlayback::PLAYED);
+            if (key == 4) {
+                TEST_ASSERT_TRUE(playInto(cache, 2, out) == PromptPlayback::PLAYED);    // 2 from the card
+            }
+        }
+        TEST_ASSERT_EQUAL(3, cache.stats().sd_entries);
+        TEST_ASSERT_LESS_OR_EQUAL(config.sd_budget_bytes, cache.stats().sd_bytes);
+        TEST_ASSERT_TRUE(cache.stats().sd_evictions >= 2);
+        TEST_ASSERT_TRUE(cache.contains(2));             // Used recently on the card
+        TEST_ASSERT_FALSE(cache.contains(1));
+        TEST_ASSERT_TRUE(cache.contains(5));
+        TEST_ASSERT_TRUE(cache.contains(6));
+    }
+
+    // A damaged file is dropped when the directory is indexed again
+    char path[160];
+    snprintf(path, sizeof(path), "%s/%016llx.pcm", TEST_SD_DIRECTORY, 5ull);
+    FILE* file = fopen(path, "r+b");
+    TEST_ASSERT_NOT_NULL(file);
+    fputc(0, file);
+    fclose(file);
+
+    PromptCache restarted(config);
+    TEST_ASSERT_TRUE(restarted.init());
+    TEST_ASSERT_EQUAL(0, restarted.stats().entries);
+    TEST_ASSERT_EQUAL(2, restarted.stats().sd_entries);
+    TEST_ASSERT_FALSE(restarted.contains(5));
+    TEST_ASSERT_TRUE(playInto(restarted, 2, out) == PromptPlayback::PLAYED);
+    TEST_ASSERT_EQUAL(audio.size(), out.size());
+    TEST_ASSERT_GREATER_THAN_FLOAT(20.0f, snrDb(audio, out));
+    TEST_ASSERT_EQUAL(1, restarted.stats().sd_hits);
+
+    restarted.clear();
+    TEST_ASSERT_EQUAL(0, restarted.stats().sd_entries);
+    PromptCache emptied(config);
+    TEST_ASSERT_TRUE(emptied.init());
+    TEST_ASSERT_EQUAL(0, emptied.stats().sd_entries);
+}
+
+void test_synthesizer_plays_prompts_from_cache(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE, 60, 64);
+    SpeechSynthesizer synthesizer(&backend);
+    TEST_ASSERT_TRUE(synthesizer.initialize());
+    PromptCache cache(testConfig(16));
+    TEST_ASSERT_TRUE(cache.init());
+    synthesizer.setPromptCache(&cache);
+    CollectSink sink;
+
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Sorry, I didn't catch that.", sink));
+    TEST_ASSERT_FALSE(synthesizer.stats().from_cache);
+    std::vector<int16_t> first = sink.audio;
+    const uint64_t synth_first_audio_us = synthesizer.stats().first_audio_us;
+    const uint32_t chunks = backend.chunksSynthesized();
+    TEST_ASSERT_EQUAL(1, cache.stats().entries);
+
+    // Same words written differently: played from the cache, backend idle
+    TEST_ASSERT_TRUE(synthesizer.synthesize("  sorry,  i didn't  CATCH that. ", sink));
+    TEST_ASSERT_TRUE(synthesizer.stats().from_cache);
+    TEST_ASSERT_EQUAL(chunks, backend.chunksSynthesized());
+    TEST_ASSERT_EQUAL(0, synthesizer.stats().chunks);
+    TEST_ASSERT_EQUAL(first.size(), sink.audio.size());
+    TEST_ASSERT_EQUAL(first.size(), synthesizer.stats().samples);
+    TEST_ASSERT_GREATER_THAN_FLOAT(20.0f, snrDb(first, sink.audio));
+    TEST_ASSERT_LESS_THAN(synth_first_audio_us, synthesizer.stats().first_audio_us);
+    TEST_ASSERT_EQUAL(1, synthesizer.stats().cache_hits);
+
+    // Another voice is another rendering
+    TtsVoice slow = defaultTtsVoice();
+    slow.length_scale = 1.3f;
+    synthesizer.setVoice(slow);
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Sorry, I didn't catch that.", sink));
+    TEST_ASSERT_FALSE(synthesizer.stats().from_cache);
+    TEST_ASSERT_EQUAL(2, cache.stats().entries);
+    synthesizer.setVoice(defaultTtsVoice());
+
+    // Texts too long to be prompts are not cached
+    std::string reply;
+    while (reply.size() < 600) {
+        reply += "This is a long reply that will not be repeated. ";
+    }
+    TEST_ASSERT_TRUE(synthesizer.synthesize(reply.c_str(), sink));
+    TEST_ASSERT_EQUAL(2, cache.stats().entries);
+    TEST_ASSERT_EQUAL(3, cache.stats().lookups);
+
+    // Detached, everything is synthesized again
+    synthesizer.setPromptCache(nullptr);
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Sorry, I didn't catch that.", sink));
+    TEST_ASSERT_FALSE(synthesizer.stats().from_cache);
+    TEST_ASSERT_EQUAL_INT16_ARRAY(first.data(), sink.audio.data(), first.size());
+}
+
+#ifndef ARDUINO
+void test_play_does_not_allocate(void) {
+    PromptCache cache(testConfig(4));
+    TEST_ASSERT_TRUE(cache.init());
+    std::vector<int16_t> audio = sweep(TEST_ENTRY_SAMPLES, 300.0f);
+    TEST_ASSERT_TRUE(insert(cache, 1, audio));
+    uint64_t total = 0;
+    SynthesizerBackend::AudioFunction out = [&total](const int16_t* samples, size_t count) {
+        total += (uint64_t)samples[0] + count;
+        return true;
+    };
+
+    allocations.store(0);
+    count_allocations = true;
+    PromptPlayback playback = cache.play(1, out);
+    cache.beginInsert(2);
+    cache.append(audio.data(), audio.size());
+    count_allocations = false;
+    TEST_ASSERT_EQUAL(0, allocations.load());
+    TEST_ASSERT_TRUE(playback == PromptPlayback::PLAYED);
+    cache.abortInsert();
+}
+#endif
+
+void test_benchmark_hit_rate_and_latency(void) {
+    clearSdDirectory();
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE, 60, 64);
+    SpeechSynthesizer synthesizer(&backend);
+    TEST_ASSERT_TRUE(synthesizer.initialize());
+    // Room for about half of the prompts in PSRAM, the rest spill
+    PromptCacheConfig config = defaultPromptCacheConfig();
+    config.psram_budget_bytes = 192 * 1024;
+    config.sd_directory = TEST_SD_DIRECTORY;
+    PromptCache cache(config);
+    TEST_ASSERT_TRUE(cache.init());
+    synthesizer.setPromptCache(&cache);
+    CollectSink sink;
+
+    // Prompts by a Zipf-like popularity, with one in five requests a
+    // one-off reply
+    uint32_t seed = 7;
+    auto next = [&seed](uint32_t n) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % n;
+    };
+    uint64_t miss_first_audio_us = 0;
+    uint64_t hit_first_audio_us = 0;
+    uint32_t misses = 0;
+    uint32_t hits = 0;
+    char reply[64];
+    for (int i = 0; i < TEST_BENCHMARK_REQUESTS; i++) {
+        const char* text;
+        if (next(5) == 0) {
+            snprintf(reply, sizeof(reply), "Your order %u has shipped.", (unsigned)next(100000));
+            text = reply;
+        } else {
+            size_t r = next(1000);
+            text = TEST_PROMPTS[(r * r / 1000) * TEST_PROMPT_COUNT / 1000];
+        }
+        TEST_ASSERT_TRUE(synthesizer.synthesize(text, sink));
+        if (synthesizer.stats().from_cache) {
+            hits++;
+            hit_first_audio_us += synthesizer.stats().first_audio_us;
+        } else {
+            misses++;
+            miss_first_audio_us += synthesizer.stats().first_audio_us;
+        }
+    }
+
+    const PromptCacheStats& stats = cache.stats();
+    AUDIO_LOGF("prompt cache: %u requests, hit rate %.1f%% (%u PSRAM, %u SD), %u evictions, %u spills\n",
+               (unsigned)stats.lookups, 100.0f * cache.hitRate(), (unsigned)stats.psram_hits,
+               (unsigned)stats.sd_hits, (unsigned)stats.evictions, (unsigned)stats.spills);
+    AUDIO_LOGF("first audio: hit %.2f ms mean (cache %.3f ms mean, %.3f ms max), miss %.2f ms mean; "
+               "%u entries %.1f KB PSRAM, %u files %.1f KB SD\n",
+               hits ? hit_first_audio_us / 1000.0f / hits : 0.0f,
+               stats.hits ? stats.total_first_audio_us / 1000.0f / stats.hits : 0.0f,
+               stats.max_first_audio_us / 1000.0f, misses ? miss_first_audio_us / 1000.0f / misses : 0.0f,
+               (unsigned)stats.entries, stats.bytes / 1024.0f, (unsigned)stats.sd_entries,
+               stats.sd_bytes / 1024.0f);
+
+    TEST_ASSERT_EQUAL(hits, stats.hits);
+    TEST_ASSERT_GREATER_THAN(0, stats.sd_hits);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.5f, cache.hitRate());       // One request in five is never repeated
+    TEST_ASSERT_LESS_OR_EQUAL(config.psram_budget_bytes, stats.bytes);
+    // Hits start playback in a small fraction of the synthesis wait
+    TEST_ASSERT_LESS_THAN(miss_first_audio_us / misses / 10, hit_first_audio_us / hits);
+    cache.clear();
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_prompt_key);
+    RUN_TEST(test_round_trip_is_compressed);
+    RUN_TEST(test_lru_evicts_by_bytes);
+    RUN_TEST(test_rejects_what_does_not_fit);
+    RUN_TEST(test_sd_tier_spills_and_promotes);
+    RUN_TEST(test_sd_tier_single_entry_promotes);
+    RUN_TEST(test_sd_tier_budget_and_restart);
+    RUN_TEST(test_synthesizer_plays_prompts_from_cache);
+#ifndef ARDUINO
+    RUN_TEST(test_play_does_not_allocate);
+#endif
+    RUN_TEST(test_benchmark_hit_rate_and_latency);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Prompt Cache Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
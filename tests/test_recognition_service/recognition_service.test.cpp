@@ -0,0 +1,390 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../../library/recognition_service.h"
+#include "../../library/audio_platform.h"
+
+using audio_processing::FramePool;
+using audio_processing::FrameRef;
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_CHUNK_SAMPLES = 1600;
+const int TEST_FAST_PASSES = 1;
+const int TEST_SLOW_PASSES = 2000;             // Tens of ms per utterance
+const uint32_t TEST_IDLE_TIMEOUT_MS = 10000;
+const size_t TEST_FRAME_SAMPLES = 160;
+const size_t TEST_UTTERANCE_FRAMES = 100;
+
+// Host backend that remembers where its audio came from
+class RecordingBackend : public HostRecognizerBackend {
+public:
+    explicit RecordingBackend(int passes) : HostRecognizerBackend(TEST_CHUNK_SAMPLES, passes) {}
+
+    bool begin() override {
+        first_sample = nullptr;
+        return HostRecognizerBackend::begin();
+    }
+
+    bool feed(const int16_t* samples, size_t count) override {
+        if (first_sample == nullptr) {
+            first_sample = samples;
+        }
+        return HostRecognizerBackend::feed(samples, count);
+    }
+
+    const int16_t* first_sample = nullptr;
+};
+
+// Host backend whose begin() holds the worker until released, or fails
+class GateBackend : public HostRecognizerBackend {
+public:
+    GateBackend() : HostRecognizerBackend(TEST_CHUNK_SAMPLES, TEST_FAST_PASSES) {}
+
+    bool begin() override {
+        entered.store(true);
+        while (!released.load()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return !fail_begin && HostRecognizerBackend::begin();
+    }
+
+    std::atomic<bool> entered{false};
+    std::atomic<bool> released{false};
+    bool fail_begin = false;
+};
+
+// Collects results delivered on the worker task
+struct ResultLog {
+    std::mutex mutex;
+    std::vector<RecognitionResult> results;
+
+    RecognitionService::ResultCallback callback() {
+        return [this](const RecognitionResult& result) {
+            std::lock_guard<std::mutex> lock(mutex);
+            results.push_back(result);
+        };
+    }
+
+    const RecognitionResult* find(uint32_t id) {
+        for (const RecognitionResult& result : results) {
+            if (result.job_id == id) {
+                return &result;
+            }
+        }
+        return nullptr;
+    }
+};
+
+// Test instances
+RecognitionServiceConfig config;
+
+void setUp(void) {
+    config = defaultRecognitionServiceConfig();
+}
+
+void tearDown(void) {
+}
+
+// One second of a tone: a single word for the host backend
+static std::vector<int16_t> makeUtterance(float freq) {
+    std::vector<int16_t> audio(TEST_SAMPLE_RATE + TEST_CHUNK_SAMPLES / 2);
+    for (size_t i = 0; i < audio.size(); i++) {
+        double cycles = fmod((double)freq * i / TEST_SAMPLE_RATE, 1.0);
+        audio[i] = (int16_t)(6000.0 * sin(2.0 * M_PI * cycles));
+    }
+    return audio;
+}
+
+// Tests ----------------------------------------------------------------------
+
+// Same transcript as the synchronous call, from the caller's own buffer
+void test_results_match_synchronous(void) {
+    RecordingBackend backend(TEST_FAST_PASSES);
+    SpeechRecognizer recognizer(&backend);
+    std::string expected = recognizer.recognizeSpeech(makeUtterance(2500.0f));
+    TEST_ASSERT_FALSE(expected.empty());
+
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+    ResultLog log;
+    std::vector<int16_t> audio = makeUtterance(2500.0f);
+    const int16_t* buffer = audio.data();
+    uint32_t id = service.submit(std::move(audio), log.callback());
+    TEST_ASSERT_NOT_EQUAL(0, id);
+    TEST_ASSERT_TRUE(audio.empty());                 // Ownership moved to the job
+    TEST_ASSERT_TRUE(service.waitIdle(TEST_IDLE_TIMEOUT_MS));
+
+    TEST_ASSERT_EQUAL(1, log.results.size());
+    TEST_ASSERT_EQUAL(id, log.results[0].job_id);
+    TEST_ASSERT_EQUAL(RecognitionStatus::DONE, log.results[0].status);
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), log.results[0].text.c_str());
+    TEST_ASSERT_TRUE(buffer == backend.first_sample);    // Decoded in place, not copied
+
+    std::future<RecognitionResult> future = service.submit(makeUtterance(2500.0f));
+    TEST_ASSERT_TRUE(future.valid());
+    RecognitionResult result = future.get();
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), result.text.c_str());
+    TEST_ASSERT_GREATER_OR_EQUAL(result.run_us, result.latency_us);
+    service.stop();
+}
+
+// The caller only pays for queueing, the worker pays for decoding
+void test_submit_does_not_block(void) {
+    RecordingBackend backend(TEST_SLOW_PASSES);
+    SpeechRecognizer recognizer(&backend);
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+
+    std::vector<int16_t> audio = makeUtterance(400.0f);
+    uint64_t start = audioMicros();
+    std::future<RecognitionResult> future = service.submit(std::move(audio));
+    uint64_t submit_us = audioMicros() - start;
+    RecognitionResult result = future.get();
+
+    AUDIO_LOGF("Submit %llu us, queued %llu us, decode %llu us\n", (unsigned long long)submit_us,
+               (unsigned long long)result.queued_us, (unsigned long long)result.run_us);
+    TEST_ASSERT_EQUAL(RecognitionStatus::DONE, result.status);
+    TEST_ASSERT_LESS_THAN(result.run_us / 10, submit_us);
+    service.stop();
+}
+
+// A new utterance makes everything older stale
+void test_cancels_stale_jobs(void) {
+    RecordingBackend backend(TEST_SLOW_PASSES);
+    SpeechRecognizer recognizer(&backend);
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+
+    ResultLog log;
+    uint32_t first = service.submit(makeUtterance(400.0f), log.callback());
+    uint32_t second = service.submit(makeUtterance(400.0f), log.callback());
+    uint32_t third = service.submit(makeUtterance(2500.0f), log.callback());
+    TEST_ASSERT_TRUE(service.waitIdle(TEST_IDLE_TIMEOUT_MS));
+
+    TEST_ASSERT_EQUAL(3, log.results.size());
+    TEST_ASSERT_EQUAL(RecognitionStatus::CANCELLED, log.find(first)->status);
+    TEST_ASSERT_EQUAL(RecognitionStatus::CANCELLED, log.find(second)->status);
+    TEST_ASSERT_TRUE(log.find(second)->text.empty());
+    TEST_ASSERT_EQUAL(RecognitionStatus::DONE, log.find(third)->status);
+
+    RecognitionServiceStats stats;
+    service.getStats(&stats);
+    TEST_ASSERT_EQUAL(3, stats.submitted);
+    TEST_ASSERT_EQUAL(2, stats.cancelled);
+    TEST_ASSERT_EQUAL(1, stats.completed);
+    TEST_ASSERT_EQUAL(0, stats.queue_depth);
+    service.stop();
+}
+
+// Without cancel_stale the queue is bounded and rejects leave the buffer
+void test_bounded_queue(void) {
+    config.cancel_stale = false;
+    config.queue_depth = 2;
+    RecordingBackend backend(TEST_SLOW_PASSES);
+    SpeechRecognizer recognizer(&backend);
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+
+    ResultLog log;
+    uint32_t ids[5];
+    uint32_t rejected = 0;
+    for (int i = 0; i < 5; i++) {
+        std::vector<int16_t> audio = makeUtterance(400.0f);
+        ids[i] = service.submit(std::move(audio), log.callback());
+        if (ids[i] == 0) {
+            rejected++;
+            TEST_ASSERT_EQUAL(TEST_SAMPLE_RATE + TEST_CHUNK_SAMPLES / 2, audio.size());
+        }
+    }
+    TEST_ASSERT_GREATER_OR_EQUAL(2, rejected);
+
+    // Cancel the newest accepted job while it is still waiting
+    uint32_t last = 0;
+    for (int i = 0; i < 5; i++) {
+        last = ids[i] ? ids[i] : last;
+    }
+    TEST_ASSERT_TRUE(service.cancel(last));
+    TEST_ASSERT_FALSE(service.cancel(12345));
+    TEST_ASSERT_TRUE(service.waitIdle(TEST_IDLE_TIMEOUT_MS));
+
+    RecognitionServiceStats stats;
+    service.getStats(&stats);
+    AUDIO_LOGF("Submitted %u, rejected %u, max depth %u, average latency %llu us\n",
+               (unsigned)stats.submitted, (unsigned)stats.rejected, (unsigned)stats.max_queue_depth,
+               (unsigned long long)(stats.completed ? stats.total_latency_us / stats.completed : 0));
+    TEST_ASSERT_EQUAL(rejected, stats.rejected);
+    TEST_ASSERT_EQUAL(5 - rejected, stats.submitted);
+    TEST_ASSERT_EQUAL(stats.submitted, stats.completed + stats.cancelled);
+    TEST_ASSERT_EQUAL(1, stats.cancelled);
+    TEST_ASSERT_EQUAL(RecognitionStatus::CANCELLED, log.find(last)->status);
+    TEST_ASSERT_LESS_OR_EQUAL(2, stats.max_queue_depth);
+    TEST_ASSERT_GREATER_OR_EQUAL(stats.last_latency_us, stats.max_latency_us);
+    service.stop();
+}
+
+// Cancellations waiting for a stuck worker are bounded, not grown
+void test_cancelled_list_is_bounded(void) {
+    config.queue_depth = 2;
+    GateBackend backend;
+    SpeechRecognizer recognizer(&backend);
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+
+    ResultLog log;
+    uint32_t running = service.submit(makeUtterance(400.0f), log.callback());
+    while (!backend.entered.load()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    // Each submit cancels the one before it; queue_depth + 1 fit
+    uint32_t last = 0;
+    for (size_t i = 0; i <= config.queue_depth + 1; i++) {
+        last = service.submit(makeUtterance(400.0f), log.callback());
+        TEST_ASSERT_NOT_EQUAL(0, last);
+    }
+    TEST_ASSERT_EQUAL(0, service.submit(makeUtterance(2500.0f), log.callback()));
+    TEST_ASSERT_FALSE(service.cancel(last));
+
+    RecognitionServiceStats stats;
+    service.getStats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.rejected);
+
+    backend.released.store(true);
+    TEST_ASSERT_TRUE(service.waitIdle(TEST_IDLE_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL(config.queue_depth + 3, log.results.size());
+    TEST_ASSERT_EQUAL(RecognitionStatus::CANCELLED, log.find(running)->status);
+    TEST_ASSERT_EQUAL(RecognitionStatus::DONE, log.find(last)->status);
+    service.getStats(&stats);
+    TEST_ASSERT_EQUAL(config.queue_depth + 2, stats.cancelled);
+    TEST_ASSERT_EQUAL(1, stats.completed);
+    service.stop();
+}
+
+// A recognizer that cannot start is a failure, not a cancellation
+void test_begin_failure_is_reported(void) {
+    GateBackend backend;
+    backend.released.store(true);
+    backend.fail_begin = true;
+    SpeechRecognizer recognizer(&backend);
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+
+    std::future<RecognitionResult> future = service.submit(makeUtterance(400.0f));
+    TEST_ASSERT_TRUE(future.valid());
+    RecognitionResult result = future.get();
+    TEST_ASSERT_EQUAL(RecognitionStatus::FAILED, result.status);
+    TEST_ASSERT_TRUE(result.text.empty());
+    TEST_ASSERT_TRUE(service.waitIdle(TEST_IDLE_TIMEOUT_MS));
+
+    RecognitionServiceStats stats;
+    service.getStats(&stats);
+    TEST_ASSERT_EQUAL(1, stats.failed);
+    TEST_ASSERT_EQUAL(0, stats.cancelled);
+    TEST_ASSERT_EQUAL(0, stats.completed);
+    service.stop();
+}
+
+// Endpointer utterances are held as frame references until decoded
+void test_utterance_frames_are_held(void) {
+    FramePool pool;
+    TEST_ASSERT_TRUE(pool.init(TEST_UTTERANCE_FRAMES + 8, TEST_FRAME_SAMPLES));
+    std::vector<int16_t> audio = makeUtterance(2500.0f);
+    std::vector<FrameRef> frames;
+    for (size_t i = 0; i < TEST_UTTERANCE_FRAMES; i++) {
+        FrameRef frame = pool.acquire();
+        memcpy(frame->samples, &audio[i * TEST_FRAME_SAMPLES], TEST_FRAME_SAMPLES * sizeof(int16_t));
+        frame->length = TEST_FRAME_SAMPLES;
+        frames.push_back(frame);
+    }
+
+    RecordingBackend backend(TEST_SLOW_PASSES);
+    SpeechRecognizer recognizer(&backend);
+    std::vector<int16_t> flat(audio.begin(), audio.begin() + TEST_UTTERANCE_FRAMES * TEST_FRAME_SAMPLES);
+    std::string expected = recognizer.recognizeSpeech(flat);
+
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+    ResultLog log;
+    Utterance utterance;
+    utterance.frames = frames.data();
+    utterance.frame_count = frames.size();
+    utterance.start_sample = 0;
+    utterance.end_sample = TEST_UTTERANCE_FRAMES * TEST_FRAME_SAMPLES;
+    utterance.end_of_speech_us = audioMicros();
+    utterance.reason = EndReason::SILENCE;
+    Endpointer::DispatchFunction dispatch = serviceDispatch(service, log.callback());
+    dispatch(utterance);
+    frames.clear();
+
+    // The job keeps the frames out of the pool while it runs
+    TEST_ASSERT_EQUAL(8, pool.available());
+    TEST_ASSERT_TRUE(service.waitIdle(TEST_IDLE_TIMEOUT_MS));
+    TEST_ASSERT_EQUAL(TEST_UTTERANCE_FRAMES + 8, pool.available());
+    TEST_ASSERT_EQUAL(1, log.results.size());
+    TEST_ASSERT_EQUAL_STRING(expected.c_str(), log.results[0].text.c_str());
+    service.stop();
+}
+
+// Stopping cancels what is left and refuses new work
+void test_stop_cancels_pending(void) {
+    config.cancel_stale = false;
+    RecordingBackend backend(TEST_SLOW_PASSES);
+    SpeechRecognizer recognizer(&backend);
+    RecognitionService service(recognizer, config);
+    TEST_ASSERT_TRUE(service.start());
+
+    ResultLog log;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_NOT_EQUAL(0, service.submit(makeUtterance(400.0f), log.callback()));
+    }
+    service.stop();
+    TEST_ASSERT_EQUAL(3, log.results.size());
+    TEST_ASSERT_EQUAL(0, service.submit(makeUtterance(400.0f), log.callback()));
+    TEST_ASSERT_FALSE(service.submit(makeUtterance(400.0f)).valid());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_results_match_synchronous);
+    RUN_TEST(test_submit_does_not_block);
+    RUN_TEST(test_cancels_stale_jobs);
+    RUN_TEST(test_bounded_queue);
+    RUN_TEST(test_cancelled_list_is_bounded);
+    RUN_TEST(test_begin_failure_is_reported);
+    RUN_TEST(test_utterance_frames_are_held);
+    RUN_TEST(test_stop_cancels_pending);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Recognition Service Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
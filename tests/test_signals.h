@@ -0,0 +1,71 @@
+#ifndef TEST_SIGNALS_H
+#define TEST_SIGNALS_H
+
+// Synthetic signals shared by the DSP test suites. Deterministic for a
+// given seed, so results repeat from run to run and across suites.
+
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Uniform noise in [-1, 1) from a linear congruential generator
+static float uniformNoise(uint32_t& seed) {
+    seed = seed * 1664525u + 1013904223u;
+    return (float)(seed >> 8) / (float)(1u << 23) - 1.0f;
+}
+
+// Speech-like test signal: noise through two resonances whose frequencies
+// change every syllable, syllables of random length separated by short
+// random pauses, so neither the spectrum nor the envelope repeats
+static std::vector<float> speechLike(size_t count, uint32_t seed, float rms, int sample_rate = 16000) {
+    std::vector<float> out(count);
+    float y1 = 0.0f, y2 = 0.0f, z1 = 0.0f, z2 = 0.0f;
+    float a1 = 0.0f, a2 = 0.0f, b1 = 0.0f, b2 = 0.0f;
+    size_t syllable_end = 0, voice_end = 0, syllable_start = 0;
+    double sum = 0.0;
+    for (size_t i = 0; i < count; i++) {
+        if (i >= syllable_end) {
+            float r = 0.97f;
+            float f1 = 300.0f + 600.0f * (uniformNoise(seed) + 1.0f) / 2.0f;
+            float f2 = 1200.0f + 1600.0f * (uniformNoise(seed) + 1.0f) / 2.0f;
+            a1 = 2.0f * r * cosf(2.0f * (float)M_PI * f1 / sample_rate);
+            b1 = 2.0f * r * cosf(2.0f * (float)M_PI * f2 / sample_rate);
+            a2 = b2 = -r * r;
+            syllable_start = i;
+            voice_end = i + (size_t)((0.12f + 0.11f * (uniformNoise(seed) + 1.0f)) * sample_rate);
+            syllable_end = voice_end + (size_t)(0.075f * (uniformNoise(seed) + 1.0f) * sample_rate);
+        }
+        float x = uniformNoise(seed);
+        float y = x + a1 * y1 + a2 * y2;
+        y2 = y1;
+        y1 = y;
+        float z = x + b1 * z1 + b2 * z2;
+        z2 = z1;
+        z1 = z;
+        float envelope = 0.0f;
+        if (i < voice_end) {
+            float phase = (float)(i - syllable_start) / (float)(voice_end - syllable_start);
+            envelope = sinf((float)M_PI * phase);
+        }
+        out[i] = (y + 0.5f * z) * envelope;
+        sum += (double)out[i] * out[i];
+    }
+    float scale = rms / sqrtf((float)(sum / count));
+    for (float& v : out) {
+        v *= scale;
+    }
+    return out;
+}
+
+// Round and saturate to 16-bit PCM
+static std::vector<int16_t> toPcm(const std::vector<float>& x) {
+    std::vector<int16_t> out(x.size());
+    for (size_t i = 0; i < x.size(); i++) {
+        float v = x[i] > 32767.0f ? 32767.0f : (x[i] < -32768.0f ? -32768.0f : x[i]);
+        out[i] = (int16_t)lrintf(v);
+    }
+    return out;
+}
+
+#endif // TEST_SIGNALS_H
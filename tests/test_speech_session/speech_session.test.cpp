@@ -0,0 +1,195 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <string>
+#include <vector>
+#include "../../library/speech_recognizer.h"
+#include "../../library/audio_platform.h"
+
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_CHUNK_SAMPLES = 1600;        // 100 ms encoder chunk
+const int TEST_ENCODER_PASSES = 64;            // Make the encoder cost measurable
+const size_t TEST_FEED_SAMPLES = 320;          // 20 ms per feed() from capture
+
+static std::vector<int16_t> utterance;
+
+// Three tones separated by pauses: low, high, low again
+static void buildUtterance() {
+    const float tones[] = {400.0f, 2500.0f, 400.0f};
+    utterance.clear();
+    for (float freq : tones) {
+        for (int i = 0; i < TEST_SAMPLE_RATE / 2; i++) {
+            utterance.push_back((int16_t)(6000.0f * sinf(2.0f * (float)M_PI * freq * i / TEST_SAMPLE_RATE)));
+        }
+        for (int i = 0; i < TEST_SAMPLE_RATE / 5; i++) {
+            utterance.push_back((int16_t)((i * 7) % 17 - 8));
+        }
+    }
+    // Half a chunk of tail so finish() has something left to encode
+    utterance.insert(utterance.end(), TEST_CHUNK_SAMPLES / 2, 0);
+}
+
+void setUp(void) {
+    if (utterance.empty()) {
+        buildUtterance();
+    }
+}
+
+void tearDown(void) {}
+
+// The transcript must not depend on how capture splits the audio
+void test_transcript_independent_of_chunking(void) {
+    HostRecognizerBackend backend(TEST_CHUNK_SAMPLES, 1);
+    SpeechRecognizer recognizer(&backend);
+    TEST_ASSERT_TRUE(recognizer.initialize());
+
+    std::string batch = recognizer.recognizeSpeech(utterance);
+    TEST_ASSERT_EQUAL_STRING("one three one", batch.c_str());
+
+    const size_t feed_sizes[] = {1, 160, 333, 1600, 4096};
+    for (size_t feed_size : feed_sizes) {
+        TEST_ASSERT_TRUE(recognizer.begin());
+        for (size_t pos = 0; pos < utterance.size(); pos += feed_size) {
+            size_t n = utterance.size() - pos < feed_size ? utterance.size() - pos : feed_size;
+            TEST_ASSERT_TRUE(recognizer.feed(&utterance[pos], n));
+        }
+        TEST_ASSERT_EQUAL_STRING(batch.c_str(), recognizer.finish().c_str());
+        TEST_ASSERT_EQUAL(utterance.size(), recognizer.stats().samples_fed);
+    }
+}
+
+// Partials grow as audio arrives and are a prefix of the final transcript
+void test_partials_are_prefixes(void) {
+    HostRecognizerBackend backend(TEST_CHUNK_SAMPLES, 1);
+    SpeechRecognizer recognizer(&backend);
+    TEST_ASSERT_TRUE(recognizer.begin());
+    TEST_ASSERT_TRUE(recognizer.partial().empty());
+
+    std::vector<std::string> partials;
+    for (size_t pos = 0; pos < utterance.size(); pos += TEST_FEED_SAMPLES) {
+        size_t n = utterance.size() - pos < TEST_FEED_SAMPLES ? utterance.size() - pos : TEST_FEED_SAMPLES;
+        recognizer.feed(&utterance[pos], n);
+        std::string current = recognizer.partial();
+        if (partials.empty() || current != partials.back()) {
+            partials.push_back(current);
+        }
+    }
+    std::string final_text = recognizer.finish();
+
+    // "", "one", "one three", "one three one"
+    TEST_ASSERT_GREATER_OR_EQUAL(3, partials.size());
+    for (const std::string& p : partials) {
+        TEST_ASSERT_EQUAL(0, final_text.compare(0, p.size(), p));
+    }
+    TEST_ASSERT_FALSE(recognizer.inSession());
+    TEST_ASSERT_TRUE(recognizer.partial().empty());
+    TEST_ASSERT_FALSE(recognizer.feed(utterance.data(), 1));
+}
+
+// With the encoder running during feed(), finish() after end of speech only
+// covers the last partial chunk instead of the whole utterance
+void test_end_of_speech_latency(void) {
+    HostRecognizerBackend backend(TEST_CHUNK_SAMPLES, TEST_ENCODER_PASSES);
+    SpeechRecognizer recognizer(&backend);
+
+    // Batch: everything arrives at end of speech
+    uint64_t start = audioMicros();
+    recognizer.begin();
+    recognizer.feed(utterance.data(), utterance.size());
+    std::string batch = recognizer.finish();
+    uint64_t batch_latency = audioMicros() - start;
+
+    // Streaming: capture-sized feeds while speaking, then finish()
+    recognizer.begin();
+    for (size_t pos = 0; pos < utterance.size(); pos += TEST_FEED_SAMPLES) {
+        size_t n = utterance.size() - pos < TEST_FEED_SAMPLES ? utterance.size() - pos : TEST_FEED_SAMPLES;
+        recognizer.feed(&utterance[pos], n);
+    }
+    start = audioMicros();
+    std::string streamed = recognizer.finish();
+    uint64_t streaming_latency = audioMicros() - start;
+
+    AUDIO_LOGF("End of speech to transcript: batch %llu us, streaming %llu us (%u chunks, %llu us in feed)\n",
+               (unsigned long long)batch_latency, (unsigned long long)streaming_latency,
+               (unsigned)backend.chunksEncoded(), (unsigned long long)recognizer.stats().feed_us);
+
+    TEST_ASSERT_EQUAL_STRING(batch.c_str(), streamed.c_str());
+    // finish() times itself inside the window measured here
+    TEST_ASSERT_GREATER_THAN(0, recognizer.stats().last_finish_us);
+    TEST_ASSERT_LESS_OR_EQUAL(streaming_latency, recognizer.stats().last_finish_us);
+    TEST_ASSERT_LESS_THAN(batch_latency / 4, streaming_latency);
+}
+
+// The Whisper stub is one backend behind the same session API
+void test_whisper_backend_session(void) {
+    SpeechRecognizer recognizer;
+    TEST_ASSERT_TRUE(recognizer.initialize());
+    TEST_ASSERT_EQUAL_STRING("whisper", recognizer.backend()->name());
+
+    TEST_ASSERT_TRUE(recognizer.begin());
+    recognizer.feed(utterance.data(), utterance.size());
+    TEST_ASSERT_TRUE(recognizer.partial().empty());
+    TEST_ASSERT_EQUAL_STRING("Transcribed text from Whisper", recognizer.finish().c_str());
+    TEST_ASSERT_EQUAL_STRING("Transcribed text from Whisper", recognizer.recognizeSpeech(utterance).c_str());
+    TEST_ASSERT_EQUAL(2, recognizer.stats().sessions);
+}
+
+// Features for one 30 s window are kept; audio past it is refused
+void test_whisper_backend_window_is_bounded(void) {
+    SpeechRecognizer recognizer;
+    TEST_ASSERT_TRUE(recognizer.initialize());
+
+    const size_t window_samples = 30 * TEST_SAMPLE_RATE;
+    TEST_ASSERT_TRUE(recognizer.begin());
+    size_t fed = 0;
+    bool accepted = true;
+    while (accepted && fed < window_samples + TEST_SAMPLE_RATE) {
+        accepted = recognizer.feed(utterance.data(), utterance.size());
+        fed += utterance.size();
+    }
+    TEST_ASSERT_FALSE(accepted);
+    TEST_ASSERT_GREATER_OR_EQUAL(window_samples, fed);
+    TEST_ASSERT_EQUAL_STRING("Transcribed text from Whisper", recognizer.finish().c_str());
+
+    // The next session starts with an empty window
+    TEST_ASSERT_TRUE(recognizer.begin());
+    TEST_ASSERT_TRUE(recognizer.feed(utterance.data(), utterance.size()));
+    recognizer.finish();
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_transcript_independent_of_chunking);
+    RUN_TEST(test_partials_are_prefixes);
+    RUN_TEST(test_end_of_speech_latency);
+    RUN_TEST(test_whisper_backend_session);
+    RUN_TEST(test_whisper_backend_window_is_bounded);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Speech Session Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
@@ -0,0 +1,400 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <string>
+#include <vector>
+#include "../../library/speech_synthesizer.h"
+#include "../../library/audio_sink.h"
+#include "../../library/pcm_ring.h"
+#include "../../library/audio_platform.h"
+
+#ifndef ARDUINO
+#include <chrono>
+#include <thread>
+#endif
+
+using namespace audio_processing;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const int TEST_SYNTH_PASSES = 64;               // Heavy enough that chunking shows in the timing
+const size_t TEST_RING_SAMPLES = 8000;          // 0.5 s at 16 kHz
+const size_t TEST_PLAYBACK_BLOCK = 320;         // 20 ms per read, like an I2S DMA buffer
+const char* TEST_WAV_PATH = "/tmp/speech_synthesizer_test.wav";
+
+const char* TEST_REPLY =
+    "Sure, the kitchen timer is set for ten minutes. I will let you know when it is done. "
+    "In the meantime, the oven is preheating to 180 degrees, which takes about 3.5 minutes. "
+    "Would you like me to read the next step of the recipe?";
+
+// Test instances
+class CollectSink : public AudioSink {
+public:
+    bool begin(int sample_rate) override {
+        rate = sample_rate;
+        audio.clear();
+        begun++;
+        return true;
+    }
+    bool write(const int16_t* samples, size_t count) override {
+        audio.insert(audio.end(), samples, samples + count);
+        writes++;
+        return true;
+    }
+    void end() override { ended++; }
+
+    int rate = 0;
+    int begun = 0;
+    int ended = 0;
+    int writes = 0;
+    std::vector<int16_t> audio;
+};
+
+std::vector<std::string> chunksOf(const char* text, const SynthesizerConfig& config) {
+    std::vector<std::string> chunks;
+    TextChunker chunker(text, strlen(text), config);
+    const char* chunk;
+    size_t length;
+    while (chunker.next(&chunk, &length)) {
+        chunks.push_back(std::string(chunk, length));
+    }
+    return chunks;
+}
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_pcm_ring_wraps(void) {
+    PcmRing ring;
+    TEST_ASSERT_TRUE(ring.init(100));
+    TEST_ASSERT_EQUAL(128, ring.capacity());
+
+    std::vector<int16_t> in(1000), out(1000);
+    for (size_t i = 0; i < in.size(); i++) {
+        in[i] = (int16_t)(i * 7);
+    }
+    // Uneven writes and reads walk the positions across the wrap many times
+    size_t written = 0, read = 0;
+    while (read < in.size()) {
+        written += ring.write(&in[written], (in.size() - written) < 37 ? in.size() - written : 37);
+        TEST_ASSERT_LESS_OR_EQUAL(ring.capacity(), ring.available());
+        read += ring.read(&out[read], 23);
+    }
+    TEST_ASSERT_EQUAL_INT16_ARRAY(in.data(), out.data(), in.size());
+    TEST_ASSERT_EQUAL(1000, ring.totalRead());
+
+    // A full ring takes nothing more, clear() empties it
+    TEST_ASSERT_EQUAL(128, ring.write(in.data(), 200));
+    TEST_ASSERT_EQUAL(0, ring.write(in.data(), 1));
+    TEST_ASSERT_EQUAL(0, ring.space());
+    TEST_ASSERT_EQUAL(128, ring.clear());
+    TEST_ASSERT_EQUAL(0, ring.available());
+    TEST_ASSERT_EQUAL(0, ring.read(out.data(), 10));
+}
+
+void test_chunker_phrases_then_sentences(void) {
+    std::vector<std::string> chunks = chunksOf(
+        "  Hello there, how are you today? I am fine.\nIt costs 3.5 euros;  thanks!  ",
+        defaultSynthesizerConfig());
+    TEST_ASSERT_EQUAL(4, chunks.size());
+    TEST_ASSERT_EQUAL_STRING("Hello there,", chunks[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("how are you today?", chunks[1].c_str());
+    TEST_ASSERT_EQUAL_STRING("I am fine.", chunks[2].c_str());
+    TEST_ASSERT_EQUAL_STRING("It costs 3.5 euros;  thanks!", chunks[3].c_str());
+
+    // A short opening sentence is a chunk on its own
+    chunks = chunksOf("Hi. Okay", defaultSynthesizerConfig());
+    TEST_ASSERT_EQUAL(2, chunks.size());
+    TEST_ASSERT_EQUAL_STRING("Hi.", chunks[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("Okay", chunks[1].c_str());
+    TEST_ASSERT_EQUAL(0, chunksOf("   \n ", defaultSynthesizerConfig()).size());
+}
+
+void test_chunker_limits_long_sentences(void) {
+    SynthesizerConfig config = defaultSynthesizerConfig();
+    config.max_chunk_chars = 24;
+    const char* text = "one two three four five six seven, eight nine ten eleven twelve thirteen "
+                       "fourteen supercalifragilisticexpialidocious";
+    std::vector<std::string> chunks = chunksOf(text, config);
+
+    // Chunks appear in order and cover every word; cuts fall on spaces
+    // except inside the one word longer than the limit
+    size_t pos = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        TEST_ASSERT_GREATER_THAN(0, chunks[i].size());
+        TEST_ASSERT_LESS_OR_EQUAL(config.max_chunk_chars, chunks[i].size());
+        size_t found = std::string(text).find(chunks[i], pos);
+        TEST_ASSERT_EQUAL(pos + (pos > 0 && text[pos] == ' ' ? 1 : 0), found);
+        pos = found + chunks[i].size();
+    }
+    TEST_ASSERT_EQUAL(strlen(text), pos);
+    TEST_ASSERT_EQUAL_STRING("one two three four five", chunks[0].c_str());
+    TEST_ASSERT_EQUAL_STRING("six seven,", chunks[1].c_str());
+}
+
+void test_default_backend_paces_text(void) {
+    SpeechSynthesizer synthesizer;
+    TEST_ASSERT_TRUE(synthesizer.initialize());
+    TEST_ASSERT_EQUAL_STRING("piper", synthesizer.backend()->name());
+
+    CollectSink sink;
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Hello there, world.", sink));
+    TEST_ASSERT_EQUAL(22050, sink.rate);
+    TEST_ASSERT_EQUAL(1, sink.begun);
+    TEST_ASSERT_EQUAL(1, sink.ended);
+    TEST_ASSERT_EQUAL(2, synthesizer.stats().chunks);
+    TEST_ASSERT_EQUAL(sink.audio.size(), synthesizer.stats().samples);
+    // "Hello there," and "world." at 70 ms per character
+    TEST_ASSERT_EQUAL((12 + 6) * 70 * 22050 / 1000, sink.audio.size());
+}
+
+void test_chunking_cuts_time_to_first_audio(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE, 60, TEST_SYNTH_PASSES);
+    CollectSink sink;
+
+    SpeechSynthesizer streaming(&backend);
+    TEST_ASSERT_TRUE(streaming.synthesize(TEST_REPLY, sink));
+    SynthesisStats chunked = streaming.stats();
+    size_t chunked_samples = sink.audio.size();
+
+    // The whole reply as one piece, straight to the backend
+    uint64_t start = audioMicros();
+    uint64_t single_first_audio_us = 0;
+    size_t single_samples = 0;
+    TEST_ASSERT_TRUE(backend.synthesize(TEST_REPLY, strlen(TEST_REPLY), defaultTtsVoice(),
+                                        [&](const int16_t* samples, size_t count) {
+                                            (void)samples;
+                                            if (single_samples == 0) {
+                                                single_first_audio_us = audioMicros() - start;
+                                            }
+                                            single_samples += count;
+                                            return true;
+                                        }));
+
+    AUDIO_LOGF("first audio: %u chunks %.1f ms, one piece %.1f ms\n", (unsigned)chunked.chunks,
+               chunked.first_audio_us / 1000.0f, single_first_audio_us / 1000.0f);
+    TEST_ASSERT_EQUAL(4, chunked.chunks);
+    // The first chunk is one sentence out of four
+    TEST_ASSERT_LESS_THAN(single_first_audio_us / 3, chunked.first_audio_us);
+    // Same speech, minus the whitespace between chunks
+    TEST_ASSERT_LESS_OR_EQUAL(single_samples, chunked_samples);
+    TEST_ASSERT_GREATER_THAN(single_samples * 9 / 10, chunked_samples);
+}
+
+void test_voice_changes_audio(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE);
+    SpeechSynthesizer synthesizer(&backend);
+    CollectSink sink;
+
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Testing voices.", sink));
+    std::vector<int16_t> normal = sink.audio;
+
+    TtsVoice slow = defaultTtsVoice();
+    slow.length_scale = 1.5f;
+    synthesizer.setVoice(slow);
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Testing voices.", sink));
+    TEST_ASSERT_INT_WITHIN(normal.size() / 100, normal.size() * 3 / 2, sink.audio.size());
+
+    TtsVoice other = defaultTtsVoice();
+    other.speaker = 1;
+    synthesizer.setVoice(other);
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Testing voices.", sink));
+    TEST_ASSERT_EQUAL(normal.size(), sink.audio.size());
+    TEST_ASSERT_FALSE(memcmp(normal.data(), sink.audio.data(), normal.size() * sizeof(int16_t)) == 0);
+}
+
+void test_cancel_stops_at_next_block(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE);
+    SpeechSynthesizer synthesizer(&backend);
+
+    class CancellingSink : public CollectSink {
+    public:
+        explicit CancellingSink(SpeechSynthesizer& s) : synth(s) {}
+        bool write(const int16_t* samples, size_t count) override {
+            synth.cancel();
+            return CollectSink::write(samples, count);
+        }
+        SpeechSynthesizer& synth;
+    } sink(synthesizer);
+
+    TEST_ASSERT_FALSE(synthesizer.synthesize(TEST_REPLY, sink));
+    TEST_ASSERT_EQUAL(1, synthesizer.stats().chunks);
+    TEST_ASSERT_EQUAL(1, synthesizer.stats().cancelled);
+    TEST_ASSERT_EQUAL(1, sink.ended);
+
+    // The next utterance starts clean
+    TEST_ASSERT_FALSE(synthesizer.synthesize("Again.", sink));
+    CollectSink plain;
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Again.", plain));
+    TEST_ASSERT_GREATER_THAN(0, plain.audio.size());
+
+    // A cancel while idle targets no job and leaves the next prompt alone
+    synthesizer.cancel();
+    TEST_ASSERT_TRUE(synthesizer.synthesize("Again.", plain));
+    TEST_ASSERT_GREATER_THAN(0, plain.audio.size());
+    TEST_ASSERT_EQUAL(2, synthesizer.stats().cancelled);
+}
+
+#ifndef ARDUINO
+void test_wav_file_sink(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE);
+    SpeechSynthesizer synthesizer(&backend);
+    CollectSink reference;
+    TEST_ASSERT_TRUE(synthesizer.synthesize(TEST_REPLY, reference));
+
+    WavFileSink wav(TEST_WAV_PATH);
+    TEST_ASSERT_TRUE(synthesizer.synthesize(TEST_REPLY, wav));
+    TEST_ASSERT_EQUAL(reference.audio.size(), wav.samples());
+
+    FILE* f = fopen(TEST_WAV_PATH, "rb");
+    TEST_ASSERT_NOT_NULL(f);
+    std::vector<uint8_t> bytes;
+    uint8_t buffer[4096];
+    size_t n;
+    while ((n = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        bytes.insert(bytes.end(), buffer, buffer + n);
+    }
+    fclose(f);
+    remove(TEST_WAV_PATH);
+
+    TEST_ASSERT_EQUAL(44 + reference.audio.size() * 2, bytes.size());
+    TEST_ASSERT_EQUAL_MEMORY("RIFF", bytes.data(), 4);
+    TEST_ASSERT_EQUAL_MEMORY("WAVEfmt ", bytes.data() + 8, 8);
+    TEST_ASSERT_EQUAL_MEMORY("data", bytes.data() + 36, 4);
+    uint32_t rate, data_bytes;
+    memcpy(&rate, bytes.data() + 24, 4);
+    memcpy(&data_bytes, bytes.data() + 40, 4);
+    TEST_ASSERT_EQUAL(TEST_SAMPLE_RATE, rate);
+    TEST_ASSERT_EQUAL(reference.audio.size() * 2, data_bytes);
+    TEST_ASSERT_EQUAL_MEMORY(reference.audio.data(), bytes.data() + 44, data_bytes);
+}
+
+void test_playback_starts_before_synthesis_ends(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE, 60, TEST_SYNTH_PASSES);
+    SpeechSynthesizer synthesizer(&backend);
+    CollectSink reference;
+    TEST_ASSERT_TRUE(synthesizer.synthesize(TEST_REPLY, reference));
+
+    PcmRing ring;
+    TEST_ASSERT_TRUE(ring.init(TEST_RING_SAMPLES));
+    RingSink sink(ring);
+
+    // Playback task: one block per ms, 20x real time, so the test is quick
+    // but the ring still fills and the synthesizer has to wait
+    std::atomic<bool> done(false);
+    std::vector<int16_t> played;
+    uint64_t first_play_us = 0;
+    std::thread player([&]() {
+        std::vector<int16_t> block(TEST_PLAYBACK_BLOCK);
+        while (!done.load() || ring.available() > 0) {
+            size_t n = ring.read(block.data(), block.size());
+            if (n > 0 && first_play_us == 0) {
+                first_play_us = audioMicros();
+            }
+            played.insert(played.end(), block.begin(), block.begin() + n);
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+    });
+
+    uint64_t start = audioMicros();
+    TEST_ASSERT_TRUE(synthesizer.synthesize(TEST_REPLY, sink));
+    uint64_t finished = audioMicros();
+    done.store(true);
+    player.join();
+
+    const SynthesisStats& stats = synthesizer.stats();
+    AUDIO_LOGF("ring playback: first audio %.1f ms, playing after %.1f ms, synthesis %.1f ms, "
+               "%u waits for %.1f ms\n", stats.first_audio_us / 1000.0f, (first_play_us - start) / 1000.0f,
+               (finished - start) / 1000.0f, (unsigned)sink.stats().waits, sink.stats().wait_us / 1000.0f);
+    TEST_ASSERT_EQUAL(reference.audio.size(), played.size());
+    TEST_ASSERT_EQUAL_INT16_ARRAY(reference.audio.data(), played.data(), played.size());
+    TEST_ASSERT_LESS_THAN(finished, first_play_us);
+    TEST_ASSERT_GREATER_THAN(0, sink.stats().waits);
+    TEST_ASSERT_EQUAL(0, sink.stats().timeouts);
+    // Blocking on the ring is not synthesis time
+    TEST_ASSERT_GREATER_THAN(0, stats.sink_us);
+    TEST_ASSERT_LESS_THAN(finished - start, stats.synth_us + 1);
+}
+
+void test_ring_sink_times_out_without_playback(void) {
+    PcmRing ring;
+    TEST_ASSERT_TRUE(ring.init(256));
+    RingSink sink(ring, 20);
+    TEST_ASSERT_TRUE(sink.begin(TEST_SAMPLE_RATE));
+    std::vector<int16_t> audio(1000, 1);
+    TEST_ASSERT_FALSE(sink.write(audio.data(), audio.size()));
+    TEST_ASSERT_EQUAL(1, sink.stats().timeouts);
+    TEST_ASSERT_EQUAL(256, sink.stats().samples);
+}
+#endif
+
+void test_benchmark(void) {
+    HostSynthesizerBackend backend(TEST_SAMPLE_RATE, 60, TEST_SYNTH_PASSES);
+    SpeechSynthesizer synthesizer(&backend);
+    CollectSink sink;
+    const int runs = 5;
+    uint64_t first_audio = 0;
+    float rtf = 0.0f;
+    for (int i = 0; i < runs; i++) {
+        TEST_ASSERT_TRUE(synthesizer.synthesize(TEST_REPLY, sink));
+        first_audio += synthesizer.stats().first_audio_us;
+        rtf += synthesizer.stats().rtf;
+    }
+    const SynthesisStats& stats = synthesizer.stats();
+    AUDIO_LOGF("host TTS: %.2f s of audio in %u chunks, time to first audio %.2f ms, RTF %.4f\n",
+               stats.samples / (float)TEST_SAMPLE_RATE, (unsigned)stats.chunks,
+               first_audio / (float)runs / 1000.0f, rtf / runs);
+    TEST_ASSERT_EQUAL(runs, stats.utterances);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.0f, stats.rtf);
+    TEST_ASSERT_LESS_THAN_FLOAT(1.0f, stats.rtf);
+    TEST_ASSERT_LESS_OR_EQUAL(stats.max_first_audio_us, stats.first_audio_us);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_pcm_ring_wraps);
+    RUN_TEST(test_chunker_phrases_then_sentences);
+    RUN_TEST(test_chunker_limits_long_sentences);
+    RUN_TEST(test_default_backend_paces_text);
+    RUN_TEST(test_chunking_cuts_time_to_first_audio);
+    RUN_TEST(test_voice_changes_audio);
+    RUN_TEST(test_cancel_stops_at_next_block);
+#ifndef ARDUINO
+    RUN_TEST(test_wav_file_sink);
+    RUN_TEST(test_playback_starts_before_synthesis_ends);
+    RUN_TEST(test_ring_sink_times_out_without_playback);
+#endif
+    RUN_TEST(test_benchmark);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Speech Synthesizer Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
@@ -0,0 +1,174 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <vector>
+#include "../../library/streaming_vad.h"
+#include "../../library/vad.h"
+#include "../../library/audio_platform.h"
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const int TEST_WINDOW = 400;      // 25 ms
+const int TEST_HOP = 160;         // 10 ms
+const float TEST_THRESHOLD = 1000.0f;
+
+void setUp(void) {
+}
+
+void tearDown(void) {
+}
+
+// Deterministic white noise so results do not depend on libc rand()
+static uint32_t lcg_state = 1;
+static int16_t noise(int amplitude) {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return (int16_t)(((int32_t)(lcg_state >> 16) % (2 * amplitude + 1)) - amplitude);
+}
+
+// Silence (amplitude 10) / speech (amplitude 3000) segments in milliseconds
+static std::vector<int16_t> makePattern(const int* segments_ms, int segments) {
+    std::vector<int16_t> pcm;
+    lcg_state = 1;
+    for (int s = 0; s < segments; s++) {
+        int amplitude = (s % 2 == 0) ? 10 : 3000;
+        int samples = segments_ms[s] * TEST_SAMPLE_RATE / 1000;
+        for (int i = 0; i < samples; i++) {
+            pcm.push_back(noise(amplitude));
+        }
+    }
+    return pcm;
+}
+
+void test_detects_speech_segment() {
+    const int segments[] = {500, 1000, 500};
+    std::vector<int16_t> pcm = makePattern(segments, 3);
+    StreamingVAD vad(TEST_THRESHOLD, TEST_WINDOW, TEST_HOP, 2, 8);
+
+    std::vector<VADDecision> decisions(pcm.size() / TEST_HOP);
+    size_t n = vad.process(pcm.data(), pcm.size(), decisions.data(), decisions.size());
+    TEST_ASSERT_EQUAL(pcm.size() / TEST_HOP, n);
+
+    int onset = -1, offset = -1;
+    for (size_t i = 0; i < n; i++) {
+        if (onset < 0 && decisions[i].speech) onset = (int)i;
+        if (onset >= 0 && offset < 0 && !decisions[i].speech) offset = (int)i;
+    }
+    // Speech starts at hop 50 and ends at hop 150
+    TEST_ASSERT_INT_WITHIN(2, 51, onset);
+    TEST_ASSERT_INT_WITHIN(3, 150 + 8 + 2, offset);
+    TEST_ASSERT_FALSE(vad.isSpeech());
+}
+
+void test_chunking_does_not_change_decisions() {
+    const int segments[] = {300, 400, 200, 600, 300};
+    std::vector<int16_t> pcm = makePattern(segments, 5);
+
+    StreamingVAD whole(TEST_THRESHOLD, TEST_WINDOW, TEST_HOP);
+    std::vector<VADDecision> a(pcm.size() / TEST_HOP + 1);
+    size_t na = whole.process(pcm.data(), pcm.size(), a.data(), a.size());
+
+    StreamingVAD chunked(TEST_THRESHOLD, TEST_WINDOW, TEST_HOP);
+    std::vector<VADDecision> b(pcm.size() / TEST_HOP + 1);
+    size_t nb = 0, offset = 0;
+    const size_t sizes[] = {1, 7, 159, 160, 161, 333, 512, 1000};
+    for (int i = 0; offset < pcm.size(); i++) {
+        size_t len = sizes[i % 8];
+        if (len > pcm.size() - offset) len = pcm.size() - offset;
+        nb += chunked.process(&pcm[offset], len, &b[nb], b.size() - nb);
+        offset += len;
+    }
+
+    TEST_ASSERT_EQUAL(na, nb);
+    for (size_t i = 0; i < na; i++) {
+        TEST_ASSERT_EQUAL(a[i].speech, b[i].speech);
+        TEST_ASSERT_EQUAL(a[i].energy, b[i].energy);
+        TEST_ASSERT_EQUAL(a[i].end_sample, b[i].end_sample);
+    }
+}
+
+void test_click_rejected_by_attack() {
+    std::vector<int16_t> pcm(TEST_SAMPLE_RATE / 2, 0);
+    for (int i = 0; i < 32; i++) {
+        pcm[4000 + i] = (i % 2) ? 20000 : -20000;
+    }
+    StreamingVAD vad(TEST_THRESHOLD, TEST_WINDOW, TEST_HOP, 4, 8);
+    std::vector<VADDecision> decisions(pcm.size() / TEST_HOP);
+    size_t n = vad.process(pcm.data(), pcm.size(), decisions.data(), decisions.size());
+
+    bool any_raw = false, any_speech = false;
+    for (size_t i = 0; i < n; i++) {
+        any_raw |= decisions[i].raw_speech;
+        any_speech |= decisions[i].speech;
+    }
+    TEST_ASSERT_TRUE(any_raw);
+    TEST_ASSERT_FALSE(any_speech);
+}
+
+void test_matches_frame_vad() {
+    // With window == hop and no smoothing, raw decisions equal the frame VAD
+    const int segments[] = {200, 200, 200};
+    std::vector<int16_t> pcm = makePattern(segments, 3);
+    StreamingVAD stream(TEST_THRESHOLD, TEST_HOP, TEST_HOP, 1, 1);
+    VoiceActivityDetector frame_vad(TEST_THRESHOLD, TEST_HOP);
+
+    for (size_t offset = 0; offset + TEST_HOP <= pcm.size(); offset += TEST_HOP) {
+        VADDecision d;
+        TEST_ASSERT_EQUAL(1, stream.process(&pcm[offset], TEST_HOP, &d, 1));
+        std::vector<int16_t> frame(pcm.begin() + offset, pcm.begin() + offset + TEST_HOP);
+        TEST_ASSERT_EQUAL(frame_vad.isSpeech(frame), d.raw_speech);
+    }
+}
+
+void test_throughput() {
+    const int segments[] = {2000, 3000, 2000, 3000};
+    std::vector<int16_t> pcm = makePattern(segments, 4);
+    StreamingVAD vad(TEST_THRESHOLD, TEST_WINDOW, TEST_HOP);
+    VADDecision decisions[64];
+
+    const int iterations = 20;
+    uint64_t begin = audio_processing::audioMicros();
+    for (int it = 0; it < iterations; it++) {
+        for (size_t offset = 0; offset < pcm.size(); offset += 512) {
+            size_t len = pcm.size() - offset < 512 ? pcm.size() - offset : 512;
+            vad.process(&pcm[offset], len, decisions, 64);
+        }
+    }
+    uint64_t elapsed = audio_processing::audioMicros() - begin;
+    double sps = (double)pcm.size() * iterations * 1e6 / (double)(elapsed > 0 ? elapsed : 1);
+    AUDIO_LOGF("StreamingVAD: %.1f Msamples/s (%.0fx real time at 16 kHz)\n",
+               sps / 1e6, sps / TEST_SAMPLE_RATE);
+    TEST_ASSERT_GREATER_THAN(TEST_SAMPLE_RATE, (int)sps);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_detects_speech_segment);
+    RUN_TEST(test_chunking_does_not_change_decisions);
+    RUN_TEST(test_click_rejected_by_attack);
+    RUN_TEST(test_matches_frame_vad);
+    RUN_TEST(test_throughput);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Streaming VAD Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
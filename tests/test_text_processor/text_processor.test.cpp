@@ -0,0 +1,544 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <stdio.h>
+#include <string.h>
+#include <atomic>
+#include <map>
+#include <string>
+#include <vector>
+#include "../../library/text_processor.h"
+#include "../../library/synthesizer_backend.h"
+#include "../../library/model_file.h"
+#include "../../library/audio_platform.h"
+#include "../alloc_counter.h"
+
+using audio_processing::audioMicros;
+
+// Test configuration constants
+const size_t TEST_SYNTHETIC_WORDS = 20000;
+const int TEST_BENCHMARK_RUNS = 200;
+const size_t TEST_MAX_IDS = 2048;
+
+// A slice of CMUdict: common words, number words, months and unit names,
+// enough that the benchmark text is mostly lexicon hits
+const char* const TEST_LEXICON[][2] = {
+    {"a", "AH0"}, {"about", "AH0 B AW1 T"}, {"after", "AE1 F T ER0"}, {"am", "AE1 M"},
+    {"an", "AE1 N"}, {"and", "AH0 N D"}, {"any", "EH1 N IY0"}, {"are", "AA1 R"},
+    {"at", "AE1 T"}, {"be", "B IY1"}, {"been", "B IH1 N"}, {"but", "B AH1 T"},
+    {"by", "B AY1"}, {"can", "K AE1 N"}, {"celsius", "S EH1 L S IY0 AH0 S"}, {"could", "K UH1 D"},
+    {"day", "D EY1"}, {"degree", "D IH0 G R IY1"}, {"degrees", "D IH0 G R IY1 Z"}, {"do", "D UW1"},
+    {"dollar", "D AA1 L ER0"}, {"dollars", "D AA1 L ER0 Z"}, {"done", "D AH1 N"}, {"for", "F AO1 R"},
+    {"from", "F R AH1 M"}, {"have", "HH AE1 V"}, {"hello", "HH AH0 L OW1"}, {"hour", "AW1 ER0"},
+    {"hours", "AW1 ER0 Z"}, {"i", "AY1"}, {"in", "IH0 N"}, {"is", "IH1 Z"},
+    {"it", "IH1 T"}, {"it's", "IH1 T S"}, {"kilometer", "K IH0 L AA1 M AH0 T ER0"},
+    {"kilometers", "K IH0 L AA1 M AH0 T ER0 Z"}, {"kitchen", "K IH1 CH AH0 N"}, {"know", "N OW1"},
+    {"let", "L EH1 T"}, {"like", "L AY1 K"}, {"me", "M IY1"}, {"meantime", "M IY1 N T AY2 M"},
+    {"minute", "M IH1 N AH0 T"}, {"minutes", "M IH1 N AH0 T S"}, {"more", "M AO1 R"}, {"my", "M AY1"},
+    {"next", "N EH1 K S T"}, {"not", "N AA1 T"}, {"of", "AH1 V"}, {"on", "AA1 N"},
+    {"or", "AO1 R"}, {"oven", "AH1 V AH0 N"}, {"percent", "P ER0 S EH1 N T"}, {"point", "P OY1 N T"},
+    {"preheating", "P R IY0 HH IY1 T IH0 NG"}, {"read", "R IY1 D"}, {"read", "R EH1 D"},
+    {"recipe", "R EH1 S AH0 P IY0"}, {"set", "S EH1 T"}, {"step", "S T EH1 P"}, {"sure", "SH UH1 R"},
+    {"takes", "T EY1 K S"}, {"the", "DH AH0"}, {"timer", "T AY1 M ER0"}, {"to", "T UW1"},
+    {"today", "T AH0 D EY1"}, {"weather", "W EH1 DH ER0"}, {"when", "W EH1 N"}, {"which", "W IH1 CH"},
+    {"will", "W IH1 L"}, {"with", "W IH1 DH"}, {"world", "W ER1 L D"}, {"would", "W UH1 D"},
+    {"you", "Y UW1"}, {"your", "Y AO1 R"},
+    {"zero", "Z IH1 R OW0"}, {"one", "W AH1 N"}, {"two", "T UW1"}, {"three", "TH R IY1"},
+    {"four", "F AO1 R"}, {"five", "F AY1 V"}, {"six", "S IH1 K S"}, {"seven", "S EH1 V AH0 N"},
+    {"eight", "EY1 T"}, {"nine", "N AY1 N"}, {"ten", "T EH1 N"}, {"eleven", "IH0 L EH1 V AH0 N"},
+    {"twelve", "T W EH1 L V"}, {"thirteen", "TH ER1 T IY1 N"}, {"fifteen", "F IH0 F T IY1 N"},
+    {"eighteen", "EY0 T IY1 N"}, {"twenty", "T W EH1 N T IY0"}, {"thirty", "TH ER1 D IY0"},
+    {"forty", "F AO1 R T IY0"}, {"fifty", "F IH1 F T IY0"}, {"sixty", "S IH1 K S T IY0"},
+    {"eighty", "EY1 T IY0"}, {"ninety", "N AY1 N T IY0"}, {"hundred", "HH AH1 N D R AH0 D"},
+    {"thousand", "TH AW1 Z AH0 N D"}, {"million", "M IH1 L Y AH0 N"}, {"first", "F ER1 S T"},
+    {"second", "S EH1 K AH0 N D"}, {"third", "TH ER1 D"}, {"fifth", "F IH1 F TH"},
+    {"twelfth", "T W EH1 L F TH"}, {"march", "M AA1 R CH"}, {"may", "M EY1"}, {"june", "JH UW1 N"},
+    {"december", "D IH0 S EH1 M B ER0"},
+};
+const size_t TEST_LEXICON_SIZE = sizeof(TEST_LEXICON) / sizeof(TEST_LEXICON[0]);
+
+const char* TEST_TEXT =
+    "Sure, the kitchen timer is set for 10 minutes. I will let you know when it is done. "
+    "In the meantime, the oven is preheating to 180 degrees, which takes about 3.5 minutes. "
+    "The weather on March 5th, 2024 will be 21°C with 40% rain; your next step is at 7:05 pm. "
+    "Would you like me to read the recipe, or convert 2.5 kg into pounds for $3.50?";
+
+// Test instances
+std::vector<uint8_t> model_bytes;
+ModelFile* model = nullptr;
+TextProcessor* processor = nullptr;
+
+std::vector<uint8_t> parseArpabet(const char* arpabet) {
+    std::vector<uint8_t> ids;
+    const char* p = arpabet;
+    while (*p) {
+        const char* start = p;
+        while (*p && *p != ' ') {
+            p++;
+        }
+        ids.push_back(phonemeId(start, (size_t)(p - start)));
+        while (*p == ' ') {
+            p++;
+        }
+    }
+    return ids;
+}
+
+bool buildModel(LexiconBuilder& builder, std::vector<uint8_t>& bytes, ModelFile& file) {
+    ModelFileWriter writer("piper");
+    if (!builder.build(writer)) {
+        return false;
+    }
+    bytes = writer.build();
+    return file.openMemory(bytes.data(), bytes.size());
+}
+
+std::string normalized(const char* text) {
+    char out[1024];
+    processor->normalize(text, strlen(text), out, sizeof(out));
+    return std::string(out);
+}
+
+std::string phonemeString(const uint8_t* ids, size_t count) {
+    std::string s;
+    for (size_t i = 0; i < count; i++) {
+        if (!s.empty()) {
+            s += ' ';
+        }
+        s += ids[i] == PHONEME_WORD_BREAK ? "|" : ids[i] == PHONEME_PAUSE ? "," : ids[i] == PHONEME_STOP ? "."
+                                                                                                          : phonemeName(ids[i]);
+    }
+    return s;
+}
+
+std::string ltsString(const char* word) {
+    uint8_t ids[64];
+    size_t n = letterToSound(word, strlen(word), ids, sizeof(ids));
+    return phonemeString(ids, n);
+}
+
+void setUp(void) {
+    LexiconBuilder builder;
+    for (size_t i = 0; i < TEST_LEXICON_SIZE; i++) {
+        builder.add(TEST_LEXICON[i][0], TEST_LEXICON[i][1]);
+    }
+    model = new ModelFile();
+    buildModel(builder, model_bytes, *model);
+    processor = new TextProcessor();
+    processor->attachLexicon(*model);
+}
+
+void tearDown(void) {
+    delete processor;
+    processor = nullptr;
+    delete model;
+    model = nullptr;
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_phoneme_ids(void) {
+    TEST_ASSERT_EQUAL(3, phonemeId("AH", 2));
+    TEST_ASSERT_EQUAL(3, phonemeId("AH0", 3));
+    TEST_ASSERT_EQUAL(PHONEME_COUNT, phonemeId("ZH1", 3));
+    TEST_ASSERT_EQUAL(0, phonemeId("XX", 2));
+    for (uint8_t id = 1; id <= PHONEME_COUNT; id++) {
+        const char* name = phonemeName(id);
+        TEST_ASSERT_EQUAL(id, phonemeId(name, strlen(name)));
+    }
+    TEST_ASSERT_EQUAL_STRING("", phonemeName(PHONEME_STOP));
+    TEST_ASSERT_NULL(phonemeName(0));
+    TEST_ASSERT_NULL(phonemeName(PHONEME_STOP + 1));
+}
+
+void test_lexicon_lookup(void) {
+    const Lexicon& lexicon = processor->lexicon();
+    TEST_ASSERT_TRUE(lexicon.isAttached());
+    // "read" is listed twice; the first pronunciation is kept
+    TEST_ASSERT_EQUAL(TEST_LEXICON_SIZE - 1, lexicon.info().words);
+    TEST_ASSERT_EQUAL(9, lexicon.info().max_phonemes);      // kilometers
+
+    for (size_t i = 0; i < TEST_LEXICON_SIZE; i++) {
+        const char* word = TEST_LEXICON[i][0];
+        const uint8_t* phonemes = nullptr;
+        size_t count = 0;
+        TEST_ASSERT_TRUE(lexicon.lookup(word, strlen(word), &phonemes, &count));
+        std::vector<uint8_t> expected = parseArpabet(strcmp(word, "read") == 0 ? "R IY1 D" : TEST_LEXICON[i][1]);
+        TEST_ASSERT_EQUAL(expected.size(), count);
+        TEST_ASSERT_EQUAL_MEMORY(expected.data(), phonemes, count);
+    }
+
+    // Prefixes, extensions and near misses of stored words
+    static const char* const MISSES[] = {"", "th", "thes", "ann", "anyway", "hundreds", "x", "it'", "zeros", "b"};
+    for (const char* word : MISSES) {
+        const uint8_t* phonemes;
+        size_t count;
+        TEST_ASSERT_FALSE(lexicon.lookup(word, strlen(word), &phonemes, &count));
+    }
+    const uint8_t* phonemes;
+    size_t count;
+    TEST_ASSERT_FALSE(lexicon.lookup("The", 3, &phonemes, &count));          // Lookups take normalized text
+    TEST_ASSERT_TRUE(lexicon.lookup("the world", 3, &phonemes, &count));     // Length, not terminator
+
+    LexiconBuilder builder;
+    TEST_ASSERT_FALSE(builder.add("naïve", "N AY0 IY1 V"));
+    TEST_ASSERT_FALSE(builder.add("word", "W ER1 XX D"));
+    TEST_ASSERT_FALSE(builder.add("word", ""));
+    ModelFileWriter writer("piper");
+    TEST_ASSERT_FALSE(builder.build(writer));
+}
+
+// A pool cut short in flash must not be read past its end
+void test_lexicon_rejects_truncated_pool(void) {
+    ModelTensor info, da, pool;
+    TEST_ASSERT_TRUE(model->find("lex.info", &info));
+    TEST_ASSERT_TRUE(model->find("lex.da", &da));
+    TEST_ASSERT_TRUE(model->find("lex.pool", &pool));
+
+    // The last pool byte is the last phoneme of some entry
+    ModelFileWriter writer("piper");
+    uint32_t short_pool = pool.dims[0] - 1;
+    TEST_ASSERT_TRUE(writer.add("lex.info", info.type, info.dims, info.rank, info.data));
+    TEST_ASSERT_TRUE(writer.add("lex.da", da.type, da.dims, da.rank, da.data));
+    TEST_ASSERT_TRUE(writer.add("lex.pool", pool.type, &short_pool, 1, pool.data));
+    std::vector<uint8_t> bytes = writer.build();
+    ModelFile truncated;
+    TEST_ASSERT_TRUE(truncated.openMemory(bytes.data(), bytes.size()));
+    Lexicon lexicon;
+    TEST_ASSERT_TRUE(lexicon.attach(truncated));
+    ModelTensor cut;
+    TEST_ASSERT_TRUE(truncated.find("lex.pool", &cut));
+    const uint8_t* end = static_cast<const uint8_t*>(cut.data) + cut.bytes;
+
+    size_t misses = 0;
+    for (size_t i = 0; i < TEST_LEXICON_SIZE; i++) {
+        const uint8_t* phonemes;
+        size_t count;
+        if (lexicon.lookup(TEST_LEXICON[i][0], strlen(TEST_LEXICON[i][0]), &phonemes, &count)) {
+            TEST_ASSERT_TRUE(phonemes + count <= end);
+        } else {
+            misses++;
+        }
+    }
+    TEST_ASSERT_EQUAL(1, misses);
+}
+
+void test_normalize_numbers(void) {
+    static const char* const CASES[][2] = {
+        {"0", "zero"},
+        {"7", "seven"},
+        {"42", "forty two"},
+        {"180", "one hundred eighty"},
+        {"1,250,000", "one million two hundred fifty thousand"},
+        {"1,25", "one, twenty five"},
+        {"-3", "minus three"},
+        {"3.14", "three point one four"},
+        {"007", "zero zero seven"},
+        {"5-10", "five to ten"},
+        {"1st 2nd 3rd 4th 21st 100th", "first second third fourth twenty first one hundredth"},
+        {"1984", "nineteen eighty four"},
+        {"1905", "nineteen oh five"},
+        {"2005", "two thousand five"},
+        {"2024", "twenty twenty four"},
+        {"2500", "two thousand five hundred"},
+        {"$3.50", "three dollars and fifty cents"},
+        {"$1", "one dollar"},
+        {"$0.99", "ninety nine cents"},
+        {"\xe2\x82\xac" "20.01", "twenty euros and one cent"},
+        {"\xc2\xa3" "2", "two pounds"},
+        {"1234567890123", "one two three four five six seven eight nine zero one two three"},
+        {"1,000,000,000,000", "one zero zero zero zero zero zero zero zero zero zero zero zero"},
+        {"-1,000,000,000,000.5", "minus one zero zero zero zero zero zero zero zero zero zero zero zero point five"},
+    };
+    for (const auto& c : CASES) {
+        TEST_ASSERT_EQUAL_STRING(c[1], normalized(c[0]).c_str());
+    }
+}
+
+void test_normalize_dates_times_units(void) {
+    static const char* const CASES[][2] = {
+        {"March 5th, 2024", "march fifth, twenty twenty four"},
+        {"on Dec. 25", "on december twenty fifth"},
+        {"Sept 1 2001", "september first two thousand one"},
+        {"2024-03-05", "march fifth twenty twenty four"},
+        {"3/5/24", "march fifth twenty twenty four"},
+        {"May I", "may i"},
+        {"7:05 pm", "seven oh five pee em"},
+        {"9:00", "nine o'clock"},
+        {"19:30", "nineteen thirty"},
+        {"10:00 a.m.", "ten ay em"},
+        {"5 km", "five kilometers"},
+        {"1 km", "one kilometer"},
+        {"12km/h", "twelve kilometers per hour"},
+        {"21\xc2\xb0" "C", "twenty one degrees celsius"},
+        {"98.6 \xc2\xb0" "F", "ninety eight point six degrees fahrenheit"},
+        {"40%", "forty percent"},
+        {"250 mAh", "two hundred fifty milliamp hours"},
+        {"5 miles", "five miles"},
+        {"2 g", "two grams"},
+        {"2 go", "two go"},
+    };
+    for (const auto& c : CASES) {
+        TEST_ASSERT_EQUAL_STRING(c[1], normalized(c[0]).c_str());
+    }
+}
+
+void test_normalize_words_and_punctuation(void) {
+    TEST_ASSERT_EQUAL_STRING("hello, world!", normalized("  Hello ,  WORLD!! ").c_str());
+    TEST_ASSERT_EQUAL_STRING("doctor smith versus mister jones", normalized("Dr. Smith vs. Mr. Jones").c_str());
+    TEST_ASSERT_EQUAL_STRING("you ess bee and nasa", normalized("USB & NASA").c_str());
+    TEST_ASSERT_EQUAL_STRING("it's well known", normalized("it's well-known").c_str());
+    TEST_ASSERT_EQUAL_STRING("caf", normalized("caf\xc3\xa9").c_str());
+
+    // Words longer than the word buffer are read in pieces, not cut short
+    TEST_ASSERT_EQUAL_STRING("pneumonoultramicroscopicsilicovo lcanoconiosis",
+                             normalized("Pneumonoultramicroscopicsilicovolcanoconiosis").c_str());
+
+    // Normalized text reads the same when normalized again
+    std::string once = normalized(TEST_TEXT);
+    TEST_ASSERT_EQUAL_STRING(once.c_str(), normalized(once.c_str()).c_str());
+}
+
+void test_normalize_truncates_at_word_boundary(void) {
+    char out[24];
+    size_t n = processor->normalize("one two three four five six seven", 33, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("one two three four five", out);
+    TEST_ASSERT_EQUAL(23, n);
+    TEST_ASSERT_EQUAL(1, processor->stats().truncated);
+
+    n = processor->normalize("1,250,000", 9, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("one million two hundred", out);
+    TEST_ASSERT_EQUAL(strlen(out), n);
+    TEST_ASSERT_EQUAL(0, processor->normalize("x", 1, out, 0));
+}
+
+void test_letter_to_sound(void) {
+    static const char* const CASES[][2] = {
+        {"cat", "K AE T"},
+        {"ship", "SH IH P"},
+        {"make", "M EY K"},
+        {"night", "N AY T"},
+        {"phone", "F OW N"},
+        {"station", "S T EY SH AH N"},
+        {"think", "TH IH NG K"},
+        {"quick", "K W IH K"},
+        {"little", "L IH T L"},
+        {"rhythm", "R IH TH M"},
+        {"speech", "S P IY CH"},
+    };
+    for (const auto& c : CASES) {
+        TEST_ASSERT_EQUAL_STRING(c[1], ltsString(c[0]).c_str());
+    }
+    TEST_ASSERT_EQUAL_STRING("", ltsString("").c_str());
+    uint8_t ids[2];
+    TEST_ASSERT_EQUAL(2, letterToSound("station", 7, ids, sizeof(ids)));
+}
+
+void test_phonemize_lexicon_then_rules(void) {
+    uint8_t ids[TEST_MAX_IDS];
+    const char* text = "Hello, world. It's a zorbly day!";
+    size_t n = processor->process(text, strlen(text), ids, TEST_MAX_IDS);
+    TEST_ASSERT_EQUAL_STRING("HH AH L OW , W ER L D . IH T S | AH | Z AO R B L IH | D EY .",
+                             phonemeString(ids, n).c_str());
+    TEST_ASSERT_EQUAL(6, processor->stats().words);
+    TEST_ASSERT_EQUAL(5, processor->stats().lexicon_hits);
+    TEST_ASSERT_EQUAL(1, processor->stats().lts_words);
+
+    // Without a lexicon every word goes through the rules
+    TextProcessor rules_only;
+    n = rules_only.process("cat ship", 8, ids, TEST_MAX_IDS);
+    TEST_ASSERT_EQUAL_STRING("K AE T | SH IH P", phonemeString(ids, n).c_str());
+    TEST_ASSERT_EQUAL(2, rules_only.stats().lts_words);
+
+    // Words that do not fit are dropped whole
+    n = processor->process("hello world", 11, ids, 6);
+    TEST_ASSERT_EQUAL(4, n);
+    TEST_ASSERT_EQUAL(1, processor->stats().truncated);
+}
+
+void test_piper_backend_uses_lexicon(void) {
+    PiperBackend backend;
+    TEST_ASSERT_TRUE(backend.initialize(model));
+    TEST_ASSERT_TRUE(backend.textProcessor().lexicon().isAttached());
+    size_t samples = 0;
+    TEST_ASSERT_TRUE(backend.synthesize("hello world", 11, defaultTtsVoice(),
+                                        [&](const int16_t* audio, size_t count) {
+                                            (void)audio;
+                                            samples += count;
+                                            return true;
+                                        }));
+    TEST_ASSERT_GREATER_THAN(0, samples);
+    TEST_ASSERT_EQUAL(2, backend.textProcessor().stats().lexicon_hits);
+
+    TEST_ASSERT_TRUE(backend.initialize(nullptr));
+    TEST_ASSERT_FALSE(backend.textProcessor().lexicon().isAttached());
+}
+
+#ifndef ARDUINO
+void test_processing_does_not_allocate(void) {
+    uint8_t ids[TEST_MAX_IDS];
+    char out[1024];
+    const uint8_t* phonemes;
+    size_t count;
+
+    allocations.store(0);
+    count_allocations = true;
+    processor->normalize(TEST_TEXT, strlen(TEST_TEXT), out, sizeof(out));
+    size_t n = processor->process(TEST_TEXT, strlen(TEST_TEXT), ids, TEST_MAX_IDS);
+    processor->lexicon().lookup("hello", 5, &phonemes, &count);
+    count_allocations = false;
+    TEST_ASSERT_EQUAL(0, allocations.load());
+    TEST_ASSERT_GREATER_THAN(100, n);
+}
+#endif
+
+void test_large_lexicon_and_benchmark(void) {
+    // Pseudo-words from syllables, pronounced by the rules
+    static const char* const ONSETS[] = {"b", "br", "c", "ch", "d", "f", "g", "gr", "h", "j", "k", "l", "m",
+                                         "n", "p", "pl", "r", "s", "sh", "st", "t", "th", "tr", "v", "w", "z"};
+    static const char* const NUCLEI[] = {"a", "e", "i", "o", "u", "ai", "ee", "oo", "ou", "y"};
+    static const char* const CODAS[] = {"", "", "n", "r", "s", "t", "ck", "ng", "ll", "nd"};
+    std::vector<std::string> words;
+    uint32_t seed = 2024;
+    auto next = [&seed](uint32_t n) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % n;
+    };
+    std::map<std::string, std::vector<uint8_t>> reference;
+    LexiconBuilder builder;
+    while (reference.size() < TEST_SYNTHETIC_WORDS) {
+        std::string word;
+        uint32_t syllables = 1 + next(3);
+        for (uint32_t s = 0; s < syllables; s++) {
+            word += ONSETS[next(26)];
+            word += NUCLEI[next(10)];
+            word += CODAS[next(10)];
+        }
+        if (reference.count(word)) {
+            continue;
+        }
+        uint8_t ids[64];
+        size_t n = letterToSound(word.c_str(), word.size(), ids, sizeof(ids));
+        std::string arpabet;
+        for (size_t i = 0; i < n; i++) {
+            arpabet += (i ? " " : "") + std::string(phonemeName(ids[i]));
+        }
+        if (n == 0 || !builder.add(word.c_str(), arpabet.c_str())) {
+            continue;
+        }
+        reference[word] = std::vector<uint8_t>(ids, ids + n);
+        words.push_back(word);
+    }
+
+    uint64_t start = audioMicros();
+    std::vector<uint8_t> bytes;
+    ModelFile large;
+    TEST_ASSERT_TRUE(buildModel(builder, bytes, large));
+    uint64_t build_us = audioMicros() - start;
+    Lexicon lexicon;
+    TEST_ASSERT_TRUE(lexicon.attach(large));
+    TEST_ASSERT_EQUAL(TEST_SYNTHETIC_WORDS, lexicon.info().words);
+
+    size_t hits = 0;
+    for (const std::string& word : words) {
+        const uint8_t* phonemes;
+        size_t count;
+        const std::vector<uint8_t>& expected = reference[word];
+        if (lexicon.lookup(word.c_str(), word.size(), &phonemes, &count) && count == expected.size() &&
+            memcmp(phonemes, expected.data(), count) == 0) {
+            hits++;
+        }
+    }
+    start = audioMicros();
+    size_t found = 0;
+    for (const std::string& word : words) {
+        const uint8_t* phonemes;
+        size_t count;
+        found += lexicon.lookup(word.c_str(), word.size(), &phonemes, &count) ? 1 : 0;
+    }
+    uint64_t lookup_us = audioMicros() - start;
+    TEST_ASSERT_EQUAL(words.size(), hits);
+    TEST_ASSERT_EQUAL(words.size(), found);
+    TEST_ASSERT_EQUAL(words.size(), hits);
+
+#ifndef ARDUINO
+    // Heap the same words take in a std::map on this host
+    allocated_bytes.store(0);
+    count_allocations = true;
+    {
+        std::map<std::string, std::vector<uint8_t>> copy(reference);
+    }
+    count_allocations = false;
+    uint64_t map_bytes = allocated_bytes.load();
+#else
+    uint64_t map_bytes = 0;
+#endif
+
+    // Whole text, normalization included
+    uint8_t ids[TEST_MAX_IDS];
+    const uint32_t words_before = processor->stats().words;
+    start = audioMicros();
+    for (int run = 0; run < TEST_BENCHMARK_RUNS; run++) {
+        processor->process(TEST_TEXT, strlen(TEST_TEXT), ids, TEST_MAX_IDS);
+    }
+    uint64_t process_us = audioMicros() - start;
+    const uint32_t processed = processor->stats().words - words_before;
+
+    const LexiconInfo& info = lexicon.info();
+    AUDIO_LOGF("lexicon: %u words, %u states, %.1f KB in flash (%.1f bytes/word), built in %.1f ms; "
+               "std::map %.1f KB of heap\n", (unsigned)info.words, (unsigned)info.states, info.bytes / 1024.0f,
+               (float)info.bytes / info.words, build_us / 1000.0f, map_bytes / 1024.0f);
+    AUDIO_LOGF("lookups: %.0f words/s; text processing: %.0f words/s (%u%% lexicon hits), "
+               "RAM %u bytes + %u scratch\n", words.size() * 1e6 / (lookup_us ? lookup_us : 1),
+               processed * 1e6 / (process_us ? process_us : 1),
+               (unsigned)(100 * processor->stats().lexicon_hits / processor->stats().words),
+               (unsigned)sizeof(TextProcessor), 2048u);
+
+    // Tails keep the double array near one state per word
+    TEST_ASSERT_LESS_THAN(3 * TEST_SYNTHETIC_WORDS, info.states);
+#ifndef ARDUINO
+    TEST_ASSERT_LESS_THAN(map_bytes, info.bytes);
+#endif
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_phoneme_ids);
+    RUN_TEST(test_lexicon_lookup);
+    RUN_TEST(test_lexicon_rejects_truncated_pool);
+    RUN_TEST(test_normalize_numbers);
+    RUN_TEST(test_normalize_dates_times_units);
+    RUN_TEST(test_normalize_words_and_punctuation);
+    RUN_TEST(test_normalize_truncates_at_word_boundary);
+    RUN_TEST(test_letter_to_sound);
+    RUN_TEST(test_phonemize_lexicon_then_rules);
+    RUN_TEST(test_piper_backend_uses_lexicon);
+#ifndef ARDUINO
+    RUN_TEST(test_processing_does_not_allocate);
+#endif
+    RUN_TEST(test_large_lexicon_and_benchmark);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Text Processor Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
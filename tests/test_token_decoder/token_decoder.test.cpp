@@ -0,0 +1,483 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <vector>
+#include "../../library/token_decoder.h"
+#include "../../library/model_file.h"
+#include "../../library/audio_platform.h"
+
+// Test configuration constants
+const uint32_t TEST_SEED = 1234;
+const uint32_t TEST_EOT_AFTER = 12;
+const uint32_t TEST_AUDIO_FRAMES = 30;
+const int TEST_BENCH_UTTERANCES = 4;
+
+// Test instances
+ModelFile* model = nullptr;
+std::vector<uint8_t> model_bytes;
+
+// Small Whisper-shaped decoder: 50 text tokens, 4 specials, 10 timestamps
+static DecoderHparams testHparams() {
+    DecoderHparams hp;
+    hp.n_vocab = 64;
+    hp.n_ctx = 48;
+    hp.n_audio_ctx = TEST_AUDIO_FRAMES;
+    hp.n_state = 64;
+    hp.n_head = 4;
+    hp.n_layer = 2;
+    hp.n_mlp = 256;
+    hp.token_sot = 50;
+    hp.token_eot = 51;
+    hp.token_no_timestamps = 52;
+    hp.token_timestamp_begin = 54;
+    return hp;
+}
+
+// Larger shape for the throughput run, Whisper tiny widths with fewer layers
+static DecoderHparams benchHparams() {
+    DecoderHparams hp = testHparams();
+    hp.n_vocab = 1024;
+    hp.n_ctx = 128;
+    hp.n_audio_ctx = 150;
+    hp.n_state = 384;
+    hp.n_head = 6;
+    hp.n_layer = 2;
+    hp.n_mlp = 1536;
+    hp.token_sot = 1000;
+    hp.token_eot = 1001;
+    hp.token_no_timestamps = 1002;
+    hp.token_timestamp_begin = 1004;
+    return hp;
+}
+
+static bool openModel(const DecoderHparams& hp, uint32_t eot_after) {
+    model_bytes = buildDecoderTestModel(hp, TEST_SEED, eot_after);
+    return model->openMemory(model_bytes.data(), model_bytes.size());
+}
+
+static std::vector<float> testAudio(const DecoderHparams& hp, size_t frames) {
+    std::vector<float> audio(frames * hp.n_state);
+    for (size_t i = 0; i < audio.size(); i++) {
+        audio[i] = sinf(0.37f * (float)i) + 0.5f * cosf(0.011f * (float)(i * i % 977));
+    }
+    return audio;
+}
+
+void setUp(void) {
+    model = new ModelFile();
+}
+
+void tearDown(void) {
+    delete model;
+    model = nullptr;
+    model_bytes.clear();
+}
+
+// Reference: the whole sequence recomputed for every token, no cache ----------
+
+static std::vector<float> dequantized(const char* name, size_t expected) {
+    std::vector<float> out;
+    ModelTensor tensor;
+    if (!model->find(name, &tensor)) {
+        return out;
+    }
+    size_t count = tensor.type == ModelTensorType::INT8 ? tensor.bytes : tensor.bytes / 4;
+    out.resize(count);
+    for (size_t i = 0; i < count; i++) {
+        out[i] = tensor.type == ModelTensorType::INT8 ? static_cast<const int8_t*>(tensor.data)[i] * tensor.scale
+                                                      : static_cast<const float*>(tensor.data)[i];
+    }
+    TEST_ASSERT_EQUAL(expected, count);
+    return out;
+}
+
+static std::vector<float> layerTensor(uint32_t l, const char* part, size_t expected) {
+    char name[MODEL_TENSOR_NAME_LEN + 8];
+    snprintf(name, sizeof(name), "dec.%u.%s", (unsigned)l, part);
+    return dequantized(name, expected);
+}
+
+static std::vector<float> project(const std::vector<float>& w, const std::vector<float>& bias,
+                                  const std::vector<float>& x, size_t rows) {
+    size_t cols = x.size();
+    std::vector<float> y(rows);
+    for (size_t r = 0; r < rows; r++) {
+        double acc = bias.empty() ? 0.0 : bias[r];
+        for (size_t c = 0; c < cols; c++) {
+            acc += (double)w[r * cols + c] * x[c];
+        }
+        y[r] = (float)acc;
+    }
+    return y;
+}
+
+static std::vector<float> norm(const std::vector<float>& params, const std::vector<float>& x) {
+    size_t d = x.size();
+    double mean = 0.0, var = 0.0;
+    for (float v : x) {
+        mean += v;
+    }
+    mean /= d;
+    for (float v : x) {
+        var += (v - mean) * (v - mean);
+    }
+    double inv = 1.0 / sqrt(var / d + 1e-5);
+    std::vector<float> y(d);
+    for (size_t i = 0; i < d; i++) {
+        y[i] = (float)((x[i] - mean) * inv * params[i] + params[d + i]);
+    }
+    return y;
+}
+
+static std::vector<float> attention(const DecoderHparams& hp, const std::vector<float>& q,
+                                    const std::vector<std::vector<float>>& keys,
+                                    const std::vector<std::vector<float>>& values) {
+    size_t head_dim = hp.n_state / hp.n_head;
+    std::vector<float> out(hp.n_state, 0.0f);
+    for (size_t h = 0; h < hp.n_head; h++) {
+        std::vector<double> scores(keys.size());
+        double max = -1e30, sum = 0.0;
+        for (size_t t = 0; t < keys.size(); t++) {
+            double dot = 0.0;
+            for (size_t i = 0; i < head_dim; i++) {
+                dot += (double)q[h * head_dim + i] * keys[t][h * head_dim + i];
+            }
+            scores[t] = dot / sqrt((double)head_dim);
+            max = scores[t] > max ? scores[t] : max;
+        }
+        for (double& s : scores) {
+            s = exp(s - max);
+            sum += s;
+        }
+        for (size_t t = 0; t < keys.size(); t++) {
+            for (size_t i = 0; i < head_dim; i++) {
+                out[h * head_dim + i] += (float)(scores[t] / sum * values[t][h * head_dim + i]);
+            }
+        }
+    }
+    return out;
+}
+
+// Logits after the last token of sequence
+static std::vector<float> referenceLogits(const DecoderHparams& hp, const std::vector<int32_t>& sequence,
+                                          const std::vector<float>& audio) {
+    const size_t d = hp.n_state;
+    std::vector<float> tok = dequantized("dec.tok_emb", hp.n_vocab * d);
+    std::vector<float> pos = dequantized("dec.pos_emb", hp.n_ctx * d);
+    std::vector<std::vector<float>> x(sequence.size());
+    for (size_t p = 0; p < sequence.size(); p++) {
+        x[p].resize(d);
+        for (size_t i = 0; i < d; i++) {
+            x[p][i] = tok[sequence[p] * d + i] + pos[p * d + i];
+        }
+    }
+    const std::vector<float> none;
+    for (uint32_t l = 0; l < hp.n_layer; l++) {
+        std::vector<float> ln = layerTensor(l, "attn_ln", 2 * d);
+        std::vector<float> wq = layerTensor(l, "attn_q", d * d), wk = layerTensor(l, "attn_k", d * d);
+        std::vector<float> wv = layerTensor(l, "attn_v", d * d), wo = layerTensor(l, "attn_out", d * d);
+        std::vector<float> bo = layerTensor(l, "attn_out.b", d);
+        std::vector<std::vector<float>> q(x.size()), k(x.size()), v(x.size());
+        for (size_t p = 0; p < x.size(); p++) {
+            std::vector<float> h = norm(ln, x[p]);
+            q[p] = project(wq, none, h, d);
+            k[p] = project(wk, none, h, d);
+            v[p] = project(wv, none, h, d);
+        }
+        for (size_t p = 0; p < x.size(); p++) {
+            std::vector<std::vector<float>> keys(k.begin(), k.begin() + p + 1);
+            std::vector<std::vector<float>> values(v.begin(), v.begin() + p + 1);
+            std::vector<float> out = project(wo, bo, attention(hp, q[p], keys, values), d);
+            for (size_t i = 0; i < d; i++) {
+                x[p][i] += out[i];
+            }
+        }
+
+        if (hp.n_audio_ctx > 0) {
+            std::vector<float> xln = layerTensor(l, "xattn_ln", 2 * d);
+            std::vector<float> xq = layerTensor(l, "xattn_q", d * d), xk = layerTensor(l, "xattn_k", d * d);
+            std::vector<float> xv = layerTensor(l, "xattn_v", d * d), xo = layerTensor(l, "xattn_out", d * d);
+            std::vector<std::vector<float>> keys, values;
+            for (size_t t = 0; t < audio.size() / d; t++) {
+                std::vector<float> frame(audio.begin() + t * d, audio.begin() + (t + 1) * d);
+                keys.push_back(project(xk, none, frame, d));
+                values.push_back(project(xv, none, frame, d));
+            }
+            for (size_t p = 0; p < x.size(); p++) {
+                std::vector<float> h = norm(xln, x[p]);
+                std::vector<float> out = project(xo, none, attention(hp, project(xq, none, h, d), keys, values), d);
+                for (size_t i = 0; i < d; i++) {
+                    x[p][i] += out[i];
+                }
+            }
+        }
+
+        std::vector<float> mln = layerTensor(l, "mlp_ln", 2 * d);
+        std::vector<float> fc1 = layerTensor(l, "mlp_fc1", hp.n_mlp * d);
+        std::vector<float> fc2 = layerTensor(l, "mlp_fc2", d * hp.n_mlp);
+        for (size_t p = 0; p < x.size(); p++) {
+            std::vector<float> hidden = project(fc1, none, norm(mln, x[p]), hp.n_mlp);
+            for (float& value : hidden) {
+                value = (float)(0.5 * value * (1.0 + erf(value / sqrt(2.0))));
+            }
+            std::vector<float> out = project(fc2, none, hidden, d);
+            for (size_t i = 0; i < d; i++) {
+                x[p][i] += out[i];
+            }
+        }
+    }
+    return project(tok, none, norm(dequantized("dec.ln", 2 * d), x.back()), hp.n_vocab);
+}
+
+// Greedy text decoding with the reference, no timestamps
+static std::vector<int32_t> referenceDecode(const DecoderHparams& hp, const std::vector<float>& audio,
+                                            size_t max_tokens) {
+    std::vector<int32_t> sequence = {hp.token_sot, hp.token_no_timestamps};
+    std::vector<int32_t> generated;
+    while (generated.size() < max_tokens && sequence.size() <= hp.n_ctx) {
+        std::vector<float> logits = referenceLogits(hp, sequence, audio);
+        int32_t best = -1;
+        for (int32_t v = 0; v < hp.token_timestamp_begin; v++) {
+            if (v != hp.token_sot && v != hp.token_no_timestamps && (best < 0 || logits[v] > logits[best])) {
+                best = v;
+            }
+        }
+        if (best == hp.token_eot) {
+            break;
+        }
+        generated.push_back(best);
+        sequence.push_back(best);
+    }
+    return generated;
+}
+
+// Tests ----------------------------------------------------------------------
+
+void test_load_sizes_memory_once(void) {
+    DecoderHparams hp = testHparams();
+    TEST_ASSERT_TRUE(openModel(hp, TEST_EOT_AFTER));
+    TokenDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.load(*model));
+    const DecoderStats& stats = decoder.stats();
+    TEST_ASSERT_EQUAL(TokenDecoder::memoryBytes(hp, defaultDecoderConfig()), stats.total_bytes);
+    // Self cache: 2 layers x K,V x 48 tokens x 64; cross cache: 2 x 2 x 30 x 64
+    TEST_ASSERT_EQUAL((2 * 2 * 48 * 64 + 2 * 2 * 30 * 64) * sizeof(float), stats.kv_bytes);
+
+    // Capping the context shrinks the cache
+    DecoderConfig config = defaultDecoderConfig();
+    config.max_context = 16;
+    TokenDecoder small(config);
+    TEST_ASSERT_TRUE(small.load(*model));
+    TEST_ASSERT_LESS_THAN(stats.total_bytes, small.stats().total_bytes);
+
+    // Audio longer than the cross cache is refused
+    std::vector<float> audio = testAudio(hp, TEST_AUDIO_FRAMES + 1);
+    TEST_ASSERT_FALSE(decoder.begin(audio.data(), TEST_AUDIO_FRAMES + 1));
+    TEST_ASSERT_FALSE(decoder.begin(nullptr, 0));
+    TEST_ASSERT_EQUAL(0, decoder.decode(nullptr));      // Not begun
+}
+
+void test_rejects_models_without_decoder(void) {
+    ModelFileWriter writer("whisper");
+    const float vector[] = {1.0f, 2.0f};
+    const uint32_t dims[] = {2};
+    writer.add("encoder.scale", ModelTensorType::FLOAT32, dims, 1, vector);
+    model_bytes = writer.build();
+    TEST_ASSERT_TRUE(model->openMemory(model_bytes.data(), model_bytes.size()));
+    TokenDecoder decoder;
+    TEST_ASSERT_FALSE(decoder.load(*model));
+    TEST_ASSERT_FALSE(decoder.isLoaded());
+
+    // Bad shape: heads do not divide the state
+    DecoderHparams hp = testHparams();
+    hp.n_head = 5;
+    TEST_ASSERT_TRUE(openModel(hp, 0));
+    TEST_ASSERT_FALSE(decoder.load(*model));
+}
+
+// The cached decoder chooses exactly what a full recompute chooses
+void test_matches_full_recompute(void) {
+    DecoderHparams hp = testHparams();
+    TEST_ASSERT_TRUE(openModel(hp, 0));
+    std::vector<float> audio = testAudio(hp, TEST_AUDIO_FRAMES);
+    DecoderConfig config = defaultDecoderConfig();
+    config.max_tokens = 10;
+    TokenDecoder decoder(config);
+    TEST_ASSERT_TRUE(decoder.load(*model));
+    TEST_ASSERT_TRUE(decoder.begin(audio.data(), TEST_AUDIO_FRAMES));
+
+    std::vector<int32_t> streamed;
+    size_t count = decoder.decode([&](const DecodedToken& token) {
+        TEST_ASSERT_EQUAL(streamed.size(), token.index);
+        TEST_ASSERT_FALSE(token.timestamp);
+        streamed.push_back(token.id);
+        return true;
+    });
+    std::vector<int32_t> expected = referenceDecode(hp, audio, config.max_tokens);
+    TEST_ASSERT_EQUAL(expected.size(), count);
+    TEST_ASSERT_EQUAL(expected.size(), streamed.size());
+    for (size_t i = 0; i < expected.size(); i++) {
+        TEST_ASSERT_EQUAL(expected[i], streamed[i]);
+        TEST_ASSERT_EQUAL(expected[i], decoder.tokens()[2 + i]);
+    }
+    TEST_ASSERT_EQUAL(hp.token_sot, decoder.tokens()[0]);
+    TEST_ASSERT_EQUAL(hp.token_no_timestamps, decoder.tokens()[1]);
+    TEST_ASSERT_EQUAL(config.max_tokens, count);
+    TEST_ASSERT_EQUAL(DecodeStop::MAX_TOKENS, decoder.lastStop());
+}
+
+void test_stops_on_end_of_text(void) {
+    DecoderHparams hp = testHparams();
+    TEST_ASSERT_TRUE(openModel(hp, TEST_EOT_AFTER));
+    std::vector<float> audio = testAudio(hp, TEST_AUDIO_FRAMES);
+    TokenDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.load(*model));
+    TEST_ASSERT_TRUE(decoder.begin(audio.data(), TEST_AUDIO_FRAMES));
+    TEST_ASSERT_EQUAL(TEST_EOT_AFTER, decoder.decode(nullptr));
+    TEST_ASSERT_EQUAL(DecodeStop::END_OF_TEXT, decoder.lastStop());
+    TEST_ASSERT_EQUAL(2 + TEST_EOT_AFTER, decoder.tokenCount());
+    for (size_t i = 0; i < decoder.tokenCount(); i++) {
+        TEST_ASSERT_NOT_EQUAL(hp.token_eot, decoder.tokens()[i]);
+    }
+}
+
+void test_other_stops(void) {
+    DecoderHparams hp = testHparams();
+    TEST_ASSERT_TRUE(openModel(hp, 0));
+    std::vector<float> audio = testAudio(hp, TEST_AUDIO_FRAMES);
+
+    // The token callback ends the utterance
+    TokenDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.load(*model));
+    TEST_ASSERT_TRUE(decoder.begin(audio.data(), TEST_AUDIO_FRAMES));
+    TEST_ASSERT_EQUAL(3, decoder.decode([](const DecodedToken& token) { return token.index < 2; }));
+    TEST_ASSERT_EQUAL(DecodeStop::CALLER, decoder.lastStop());
+
+    // A full context ends it without writing past the cache
+    DecoderConfig config = defaultDecoderConfig();
+    config.max_context = 6;
+    TokenDecoder small(config);
+    TEST_ASSERT_TRUE(small.load(*model));
+    TEST_ASSERT_TRUE(small.begin(audio.data(), TEST_AUDIO_FRAMES));
+    TEST_ASSERT_EQUAL(5, small.decode(nullptr));
+    TEST_ASSERT_EQUAL(DecodeStop::CONTEXT_FULL, small.lastStop());
+    TEST_ASSERT_EQUAL(7, small.tokenCount());       // The last token chosen is never cached
+}
+
+void test_timestamps(void) {
+    DecoderHparams hp = testHparams();
+    TEST_ASSERT_TRUE(openModel(hp, 0));
+    std::vector<float> audio = testAudio(hp, TEST_AUDIO_FRAMES);
+    DecoderConfig config = defaultDecoderConfig();
+    config.timestamps = true;
+    config.max_tokens = 20;
+    TokenDecoder decoder(config);
+    TEST_ASSERT_TRUE(decoder.load(*model));
+    TEST_ASSERT_TRUE(decoder.begin(audio.data(), TEST_AUDIO_FRAMES));
+
+    std::vector<DecodedToken> tokens;
+    decoder.decode([&](const DecodedToken& token) {
+        tokens.push_back(token);
+        return true;
+    });
+    TEST_ASSERT_GREATER_THAN(0, tokens.size());
+    TEST_ASSERT_TRUE(tokens[0].timestamp);
+    TEST_ASSERT_EQUAL(hp.token_sot, decoder.tokens()[0]);
+    float last = -1.0f;
+    for (const DecodedToken& token : tokens) {
+        TEST_ASSERT_NOT_EQUAL(hp.token_no_timestamps, token.id);
+        TEST_ASSERT_EQUAL(token.id >= hp.token_timestamp_begin, token.timestamp);
+        if (token.timestamp) {
+            TEST_ASSERT_FLOAT_WITHIN(1e-6f, (token.id - hp.token_timestamp_begin) * 0.02f, token.time_s);
+            TEST_ASSERT_TRUE(token.time_s >= last);
+            last = token.time_s;
+        }
+    }
+}
+
+// Peak memory is reached on the first utterance and never grows
+void test_memory_is_bounded(void) {
+    DecoderHparams hp = testHparams();
+    TEST_ASSERT_TRUE(openModel(hp, TEST_EOT_AFTER));
+    std::vector<float> audio = testAudio(hp, TEST_AUDIO_FRAMES);
+    TokenDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.load(*model));
+    size_t peak = 0;
+    for (int i = 0; i < 3; i++) {
+        TEST_ASSERT_TRUE(decoder.begin(audio.data(), TEST_AUDIO_FRAMES - i));
+        decoder.decode(nullptr);
+        if (i == 0) {
+            peak = decoder.stats().peak_arena_bytes;
+        }
+        TEST_ASSERT_EQUAL(peak, decoder.stats().peak_arena_bytes);
+    }
+    TEST_ASSERT_EQUAL(decoder.stats().arena_bytes, peak);
+    TEST_ASSERT_EQUAL(3, decoder.stats().utterances);
+}
+
+void test_tokens_per_second(void) {
+    DecoderHparams hp = benchHparams();
+    TEST_ASSERT_TRUE(openModel(hp, 100));
+    std::vector<float> audio = testAudio(hp, hp.n_audio_ctx);
+    TokenDecoder decoder;
+    TEST_ASSERT_TRUE(decoder.load(*model));
+
+    uint64_t start = audio_processing::audioMicros();
+    TEST_ASSERT_TRUE(decoder.begin(audio.data(), hp.n_audio_ctx));
+    uint64_t cross_us = audio_processing::audioMicros() - start;
+    decoder.decode(nullptr);
+    float best = decoder.stats().last_tokens_per_s;
+    for (int i = 1; i < TEST_BENCH_UTTERANCES; i++) {
+        TEST_ASSERT_TRUE(decoder.begin(audio.data(), hp.n_audio_ctx));
+        decoder.decode(nullptr);
+        best = decoder.stats().last_tokens_per_s > best ? decoder.stats().last_tokens_per_s : best;
+    }
+    const DecoderStats& stats = decoder.stats();
+    AUDIO_LOGF("Decoder %u state, %u layers, %u vocab: %u tokens, %.1f tokens/s (cross cache fill %llu us)\n",
+               (unsigned)hp.n_state, (unsigned)hp.n_layer, (unsigned)hp.n_vocab, (unsigned)stats.last_tokens,
+               best, (unsigned long long)cross_us);
+    AUDIO_LOGF("Decoder memory: %u bytes total, KV cache %u, arena peak %u of %u, weights %u (mapped)\n",
+               (unsigned)stats.total_bytes, (unsigned)stats.kv_bytes, (unsigned)stats.peak_arena_bytes,
+               (unsigned)stats.arena_bytes, (unsigned)model->fileBytes());
+    TEST_ASSERT_EQUAL(100, stats.last_tokens);
+    TEST_ASSERT_GREATER_THAN(0.0f, best);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_load_sizes_memory_once);
+    RUN_TEST(test_rejects_models_without_decoder);
+    RUN_TEST(test_matches_full_recompute);
+    RUN_TEST(test_stops_on_end_of_text);
+    RUN_TEST(test_other_stops);
+    RUN_TEST(test_timestamps);
+    RUN_TEST(test_memory_is_bounded);
+    RUN_TEST(test_tokens_per_second);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Token Decoder Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
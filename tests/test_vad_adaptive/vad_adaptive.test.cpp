@@ -0,0 +1,208 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include "../../library/vad.h"
+#include "../../library/vad_calibration.h"
+#include "../../library/audio_platform.h"
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const int TEST_FRAME_SIZE = 160;          // 10 ms
+const float TEST_FIXED_THRESHOLD = 1000.0f;
+const float TEST_SNR_DB = 6.0f;
+
+VADCalibrationStore* store = nullptr;
+
+void setUp(void) {
+#ifndef ESP_PLATFORM
+    VADCalibrationStore::setHostDirectory("/tmp");
+#endif
+    store = new VADCalibrationStore("test_floor");
+    store->erase();
+}
+
+void tearDown(void) {
+    store->erase();
+    delete store;
+    store = nullptr;
+}
+
+// Synthetic corpus ---------------------------------------------------------
+
+static uint32_t lcg_state = 1;
+static float uniformNoise() {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return ((lcg_state >> 8) / 8388608.0f) - 1.0f;
+}
+
+struct NoiseProfile {
+    const char* name;
+    float white;     // White noise amplitude
+    float hum;       // 120 Hz hum amplitude (HVAC, fans)
+};
+
+const NoiseProfile QUIET_ROOM = {"quiet room", 15.0f, 0.0f};
+const NoiseProfile OFFICE = {"office", 150.0f, 60.0f};
+const NoiseProfile HVAC = {"hvac", 200.0f, 400.0f};
+
+static uint64_t sample_clock = 0;
+
+// One frame of noise, optionally with a 1 kHz tone burst on top
+static std::vector<int16_t> makeFrame(const NoiseProfile& noise, float tone) {
+    std::vector<int16_t> frame(TEST_FRAME_SIZE);
+    for (int i = 0; i < TEST_FRAME_SIZE; i++, sample_clock++) {
+        float t = (float)sample_clock / TEST_SAMPLE_RATE;
+        float x = noise.white * uniformNoise() + noise.hum * sinf(2.0f * (float)M_PI * 120.0f * t) +
+                  tone * sinf(2.0f * (float)M_PI * 1000.0f * t);
+        frame[i] = (int16_t)fmaxf(-32768.0f, fminf(32767.0f, x));
+    }
+    return frame;
+}
+
+static float noiseEnergy(const NoiseProfile& noise) {
+    // Uniform white noise: A^2/3, sine: A^2/2
+    return noise.white * noise.white / 3.0f + noise.hum * noise.hum / 2.0f;
+}
+
+struct Rates {
+    float false_trigger;
+    float detection;
+};
+
+// 3 s warm-up on noise, then alternating 500 ms noise / 300 ms bursts at burst_snr_db
+static Rates runCorpus(VoiceActivityDetector& vad, const NoiseProfile& noise, float burst_snr_db,
+                       int warmup_frames = 300) {
+    lcg_state = 7;
+    sample_clock = 0;
+    for (int i = 0; i < warmup_frames; i++) {
+        vad.isSpeech(makeFrame(noise, 0.0f));
+    }
+
+    float tone = sqrtf(2.0f * noiseEnergy(noise) * powf(10.0f, burst_snr_db / 10.0f));
+    int noise_frames = 0, false_triggers = 0, burst_frames = 0, detections = 0;
+    for (int cycle = 0; cycle < 10; cycle++) {
+        for (int i = 0; i < 50; i++, noise_frames++) {
+            false_triggers += vad.isSpeech(makeFrame(noise, 0.0f)) ? 1 : 0;
+        }
+        for (int i = 0; i < 30; i++, burst_frames++) {
+            detections += vad.isSpeech(makeFrame(noise, tone)) ? 1 : 0;
+        }
+    }
+
+    Rates rates;
+    rates.false_trigger = (float)false_triggers / noise_frames;
+    rates.detection = (float)detections / burst_frames;
+    return rates;
+}
+
+// Tests ---------------------------------------------------------------------
+
+void test_fixed_threshold_fails_in_hvac() {
+    VoiceActivityDetector vad(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+    Rates rates = runCorpus(vad, HVAC, 15.0f);
+    AUDIO_LOGF("fixed/%s: false trigger %.1f%%, detection %.1f%%\n",
+           HVAC.name, rates.false_trigger * 100, rates.detection * 100);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, rates.false_trigger);
+}
+
+void test_adaptive_false_trigger_rates() {
+    const NoiseProfile* profiles[] = {&QUIET_ROOM, &OFFICE, &HVAC};
+    for (int p = 0; p < 3; p++) {
+        VoiceActivityDetector vad(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+        vad.enableAdaptiveThreshold(TEST_SNR_DB);
+        Rates rates = runCorpus(vad, *profiles[p], 15.0f);
+        AUDIO_LOGF("adaptive/%s: floor %.0f, false trigger %.1f%%, detection %.1f%%\n",
+               profiles[p]->name, vad.noiseFloor(), rates.false_trigger * 100, rates.detection * 100);
+        TEST_ASSERT_LESS_THAN_FLOAT(0.02f, rates.false_trigger);
+        TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, rates.detection);
+    }
+}
+
+void test_quiet_talker_detected() {
+    // Bursts 8 dB over a quiet room (~550 energy) sit below the fixed threshold
+    VoiceActivityDetector fixed(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+    Rates fixed_rates = runCorpus(fixed, QUIET_ROOM, 8.0f);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.1f, fixed_rates.detection);
+
+    VoiceActivityDetector adaptive(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+    adaptive.enableAdaptiveThreshold(TEST_SNR_DB);
+    Rates adaptive_rates = runCorpus(adaptive, QUIET_ROOM, 8.0f);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, adaptive_rates.detection);
+}
+
+void test_cold_boot_starts_calibrated() {
+    VoiceActivityDetector learned(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+    learned.enableAdaptiveThreshold(TEST_SNR_DB);
+    runCorpus(learned, HVAC, 15.0f);
+    TEST_ASSERT_TRUE(learned.saveCalibration(*store));
+
+    // Fresh detector without calibration: triggers while relearning
+    VoiceActivityDetector cold(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+    cold.enableAdaptiveThreshold(TEST_SNR_DB);
+    Rates cold_rates = runCorpus(cold, HVAC, 15.0f, 0);
+
+    // Fresh detector seeded from the store: calibrated from the first frame
+    VADCalibrationStore reopened("test_floor");
+    VoiceActivityDetector warm(TEST_FIXED_THRESHOLD, TEST_FRAME_SIZE);
+    warm.enableAdaptiveThreshold(TEST_SNR_DB);
+    TEST_ASSERT_TRUE(warm.loadCalibration(reopened));
+    TEST_ASSERT_TRUE(warm.isCalibrated());
+    TEST_ASSERT_FLOAT_WITHIN(1.0f, learned.noiseFloor(), warm.noiseFloor());
+    Rates warm_rates = runCorpus(warm, HVAC, 15.0f, 0);
+
+    AUDIO_LOGF("cold boot false trigger %.1f%%, warm boot %.1f%%\n",
+           cold_rates.false_trigger * 100, warm_rates.false_trigger * 100);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.02f, warm_rates.false_trigger);
+    TEST_ASSERT_GREATER_THAN_FLOAT(warm_rates.false_trigger, cold_rates.false_trigger);
+}
+
+void test_store_limits_writes() {
+    TEST_ASSERT_TRUE(store->save(1000.0f));
+    TEST_ASSERT_FALSE(store->save(1050.0f));   // +0.2 dB, skipped
+    TEST_ASSERT_FALSE(store->save(1100.0f));   // +0.4 dB, skipped
+    TEST_ASSERT_TRUE(store->save(1500.0f));    // +1.8 dB, written
+    TEST_ASSERT_EQUAL(2, store->writes());
+
+    float floor = 0.0f;
+    VADCalibrationStore reopened("test_floor");
+    TEST_ASSERT_TRUE(reopened.load(&floor));
+    TEST_ASSERT_FLOAT_WITHIN(0.01f, 1500.0f, floor);
+
+    TEST_ASSERT_TRUE(store->erase());
+    TEST_ASSERT_FALSE(reopened.load(&floor));
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_fixed_threshold_fails_in_hvac);
+    RUN_TEST(test_adaptive_false_trigger_rates);
+    RUN_TEST(test_quiet_talker_detected);
+    RUN_TEST(test_cold_boot_starts_calibrated);
+    RUN_TEST(test_store_limits_writes);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Adaptive VAD Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
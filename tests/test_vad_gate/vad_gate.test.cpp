@@ -0,0 +1,285 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "../../library/vad_gate.h"
+
+using namespace audio_processing;
+
+// Test instances
+FramePool* pool = nullptr;
+PipelineRuntime* runtime = nullptr;
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const size_t TEST_FRAME_COUNT = 16;
+const size_t TEST_FRAME_SAMPLES = 512;
+const uint32_t TEST_FRAMES = 400;
+const uint32_t TEST_SPEECH_PERIOD = 100;   // One utterance every 100 frames (3.2 s)
+const uint32_t TEST_SPEECH_FRAMES = 10;    // 320 ms of speech, ~90% silence
+
+void setUp(void) {
+    pool = new FramePool();
+    TEST_ASSERT_TRUE(pool->init(TEST_FRAME_COUNT, TEST_FRAME_SAMPLES));
+    runtime = new PipelineRuntime();
+}
+
+void tearDown(void) {
+    delete runtime;
+    runtime = nullptr;
+    delete pool;
+    pool = nullptr;
+}
+
+static void sleepMs(uint32_t ms) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+}
+
+static bool waitFor(const std::atomic<uint32_t>& counter, uint32_t target, uint32_t timeout_ms) {
+    for (uint32_t waited = 0; waited < timeout_ms; waited++) {
+        if (counter.load() >= target) {
+            return true;
+        }
+        sleepMs(1);
+    }
+    return counter.load() >= target;
+}
+
+static bool isSpeechFrame(uint32_t index) {
+    return index % TEST_SPEECH_PERIOD < TEST_SPEECH_FRAMES;
+}
+
+// Room tone or a 300 Hz "voice" at roughly conversational level
+static void fillFrame(FrameRef& frame, uint32_t index) {
+    float amplitude = isSpeechFrame(index) ? 3000.0f : 8.0f;
+    for (size_t i = 0; i < TEST_FRAME_SAMPLES; i++) {
+        float t = (float)(index * TEST_FRAME_SAMPLES + i) / TEST_SAMPLE_RATE;
+        frame->samples[i] = (int16_t)(amplitude * sinf(2.0f * (float)M_PI * 300.0f * t));
+    }
+    frame->length = TEST_FRAME_SAMPLES;
+}
+
+// Stand-in for the post filter: a 32-tap moving average, done the slow way
+static void heavyFilter(FrameRef& frame) {
+    static int16_t scratch[TEST_FRAME_SAMPLES];
+    for (size_t n = 0; n < frame.size(); n++) {
+        int32_t acc = 0;
+        for (size_t k = 0; k < 32 && k <= n; k++) {
+            acc += frame.data()[n - k];
+        }
+        scratch[n] = (int16_t)(acc / 32);
+    }
+    for (size_t n = 0; n < frame.size(); n++) {
+        frame.data()[n] = scratch[n];
+    }
+}
+
+void test_gate_passes_speech_and_skips_silence() {
+    VADGateConfig config = defaultVADGateConfig(TEST_SAMPLE_RATE, TEST_FRAME_SAMPLES);
+    config.policy = SilencePolicy::SKIP;
+    VADGate gate(config);
+
+    uint32_t passed_speech = 0;
+    uint32_t passed = 0;
+    for (uint32_t i = 0; i < TEST_SPEECH_PERIOD; i++) {
+        FrameRef frame = pool->acquire();
+        fillFrame(frame, i);
+        if (gate.process(frame)) {
+            passed++;
+            passed_speech += isSpeechFrame(i) ? 1 : 0;
+            TEST_ASSERT_EQUAL(0, frame->flags);
+        }
+    }
+
+    // Every speech frame plus the hangover tail (300 ms ~ 10 frames)
+    TEST_ASSERT_EQUAL(TEST_SPEECH_FRAMES, passed_speech);
+    TEST_ASSERT_LESS_OR_EQUAL(TEST_SPEECH_FRAMES + 11, passed);
+
+    GateStats stats;
+    gate.getStats(&stats);
+    TEST_ASSERT_EQUAL(TEST_SPEECH_PERIOD, stats.frames_in);
+    TEST_ASSERT_EQUAL(passed, stats.frames_passed);
+    TEST_ASSERT_EQUAL(TEST_SPEECH_PERIOD - passed, stats.frames_skipped);
+    TEST_ASSERT_EQUAL(0, stats.markers_sent);
+}
+
+void test_gate_emits_sparse_markers() {
+    VADGateConfig config = defaultVADGateConfig(TEST_SAMPLE_RATE, TEST_FRAME_SAMPLES);
+    config.marker_interval = 10;
+    VADGate gate(config);
+
+    uint32_t markers = 0;
+    for (uint32_t i = 0; i < 50; i++) {
+        FrameRef frame = pool->acquire();
+        fillFrame(frame, TEST_SPEECH_FRAMES + i);   // Silence only
+        AudioFrame* original = frame.get();
+        if (gate.process(frame)) {
+            TEST_ASSERT_TRUE(frame.get() != original);
+            TEST_ASSERT_EQUAL(FRAME_FLAG_SILENCE, frame->flags);
+            TEST_ASSERT_EQUAL(0, frame.size());
+            markers++;
+        }
+        TEST_ASSERT_EQUAL(0, original->flags);   // Shared input is never touched
+    }
+
+    // Silence start, then one every 10 frames
+    TEST_ASSERT_EQUAL(5, markers);
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+void test_gated_pipeline_saves_downstream_work() {
+    std::atomic<uint32_t> produced(0);
+    std::atomic<uint32_t> gated(0);
+    std::atomic<uint32_t> bt_audio(0), bt_markers(0);
+    std::atomic<uint32_t> sd_audio(0), sd_markers(0);
+    std::atomic<uint32_t> stt_frames(0);
+    std::atomic<uint32_t> done(0);
+
+    VADGateConfig gate_config = defaultVADGateConfig(TEST_SAMPLE_RATE, TEST_FRAME_SAMPLES);
+    VADGate gate(gate_config);
+
+    StageConfig capture_cfg = defaultStageConfig(StageRole::CAPTURE, "capture");
+    StageConfig gate_cfg = defaultStageConfig(StageRole::VAD, "gate");
+    StageConfig filter_cfg = defaultStageConfig(StageRole::CUSTOM, "filter");
+    StageConfig bt_cfg = defaultStageConfig(StageRole::BLUETOOTH, "bt");
+    StageConfig sd_cfg = defaultStageConfig(StageRole::SD_STORAGE, "sd");
+    StageConfig stt_cfg = defaultStageConfig(StageRole::CUSTOM, "stt");
+    gate_cfg.policy = BackpressurePolicy::BLOCK;
+    filter_cfg.policy = BackpressurePolicy::BLOCK;
+    bt_cfg.policy = BackpressurePolicy::BLOCK;
+    sd_cfg.policy = BackpressurePolicy::BLOCK;
+    stt_cfg.policy = BackpressurePolicy::BLOCK;
+
+    int capture = runtime->addStage(capture_cfg, [&](FrameRef& frame) {
+        if (produced.load() >= TEST_FRAMES) {
+            return false;
+        }
+        frame = pool->acquire();
+        if (!frame) {
+            return false;
+        }
+        fillFrame(frame, produced.load());
+        produced++;
+        return true;
+    });
+
+    PipelineRuntime::StageFunction gate_function = gate.stageFunction();
+    int gate_stage = runtime->addStage(gate_cfg, [&](FrameRef& frame) {
+        bool forward = gate_function(frame);
+        gated++;
+        return forward;
+    });
+
+    int filter = runtime->addStage(filter_cfg, [](FrameRef& frame) {
+        if (!(frame->flags & FRAME_FLAG_SILENCE)) {
+            heavyFilter(frame);
+        }
+        return true;
+    });
+
+    int bt = runtime->addStage(bt_cfg, [&](FrameRef& frame) {
+        // Real sink: sendAudioData() for audio, a short keepalive for markers
+        if (frame->flags & FRAME_FLAG_SILENCE) {
+            bt_markers++;
+        } else {
+            bt_audio++;
+        }
+        done++;
+        return false;
+    });
+
+    int sd = runtime->addStage(sd_cfg, [&](FrameRef& frame) {
+        if (frame->flags & FRAME_FLAG_SILENCE) {
+            sd_markers++;
+        } else {
+            sd_audio++;
+        }
+        return false;
+    });
+
+    int stt = runtime->addStage(stt_cfg, [&](FrameRef& frame) {
+        if (frame->flags & FRAME_FLAG_SILENCE) {
+            return false;
+        }
+        stt_frames++;
+        return false;
+    });
+
+    TEST_ASSERT_TRUE(runtime->connect(capture, gate_stage));
+    TEST_ASSERT_TRUE(runtime->connect(gate_stage, filter));
+    TEST_ASSERT_TRUE(runtime->connect(filter, bt));
+    TEST_ASSERT_TRUE(runtime->connect(filter, sd));
+    TEST_ASSERT_TRUE(runtime->connect(filter, stt));
+    TEST_ASSERT_TRUE(gate.trackDownstream(runtime, filter));
+    TEST_ASSERT_TRUE(gate.trackDownstream(runtime, bt));
+    TEST_ASSERT_TRUE(gate.trackDownstream(runtime, sd));
+    TEST_ASSERT_TRUE(gate.trackDownstream(runtime, stt));
+
+    TEST_ASSERT_TRUE(runtime->start());
+    TEST_ASSERT_TRUE(waitFor(gated, TEST_FRAMES, 10000));
+
+    GateStats stats;
+    gate.getStats(&stats);
+    uint32_t forwarded = stats.frames_passed + stats.markers_sent;
+    TEST_ASSERT_TRUE(waitFor(done, forwarded, 5000));
+    sleepMs(20);
+    gate.getStats(&stats);
+    runtime->stop();
+
+    AUDIO_LOGF("Gate: %u in, %u passed, %u skipped (%.0f%%), %u markers\n",
+               (unsigned)stats.frames_in, (unsigned)stats.frames_passed,
+               (unsigned)stats.frames_skipped, stats.skip_ratio * 100, (unsigned)stats.markers_sent);
+    AUDIO_LOGF("Gate cost %llu us, downstream %llu us, saved ~%llu us\n",
+               (unsigned long long)stats.gate_us, (unsigned long long)stats.downstream_us,
+               (unsigned long long)stats.saved_us);
+
+    TEST_ASSERT_EQUAL(TEST_FRAMES, stats.frames_in);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.75f, stats.skip_ratio);
+
+    // Every sink saw the same audio; STT never saw a marker or a silent frame
+    TEST_ASSERT_EQUAL(stats.frames_passed, bt_audio.load());
+    TEST_ASSERT_EQUAL(stats.frames_passed, sd_audio.load());
+    TEST_ASSERT_EQUAL(stats.frames_passed, stt_frames.load());
+    TEST_ASSERT_EQUAL(stats.markers_sent, bt_markers.load());
+    TEST_ASSERT_EQUAL(stats.markers_sent, sd_markers.load());
+    TEST_ASSERT_GREATER_THAN(0, stats.markers_sent);
+    TEST_ASSERT_LESS_THAN(stats.frames_skipped / 4, stats.markers_sent);
+
+    // The work avoided dwarfs what the detector costs
+    TEST_ASSERT_GREATER_THAN(stats.gate_us, stats.saved_us);
+    TEST_ASSERT_EQUAL(TEST_FRAME_COUNT, pool->available());
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_gate_passes_speech_and_skips_silence);
+    RUN_TEST(test_gate_emits_sparse_markers);
+    RUN_TEST(test_gated_pipeline_saves_downstream_work);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting VAD Gate Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif
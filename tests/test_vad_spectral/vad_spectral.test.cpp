@@ -0,0 +1,237 @@
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#include <unity.h>
+#include <math.h>
+#include <vector>
+#include "../../library/vad.h"
+#include "../../library/band_energy.h"
+#include "../../library/audio_platform.h"
+
+#if !defined(ARDUINO) && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#endif
+
+// Test configuration constants
+const int TEST_SAMPLE_RATE = 16000;
+const int TEST_FRAME_SIZE = 512;          // 32 ms
+const float TEST_THRESHOLD = 10000.0f;    // ~100 RMS
+const int TEST_FRAMES = 60;
+const int TEST_BENCH_FRAMES = 500;
+
+void setUp(void) {}
+void tearDown(void) {}
+
+// Synthetic sources ----------------------------------------------------------
+
+static uint32_t lcg_state = 1;
+static float uniformNoise() {
+    lcg_state = lcg_state * 1664525u + 1013904223u;
+    return ((lcg_state >> 8) / 8388608.0f) - 1.0f;
+}
+
+enum Source { VOICED, FAN, DOOR_SLAM, HISS };
+
+static const char* sourceName(Source source) {
+    switch (source) {
+        case VOICED: return "voiced";
+        case FAN: return "fan";
+        case DOOR_SLAM: return "door slam";
+        default: return "hiss";
+    }
+}
+
+static float formantGain(float f) {
+    // Three vowel formants on a -6 dB/octave glottal tilt
+    const float formants[3] = {700.0f, 1200.0f, 2600.0f};
+    const float widths[3] = {110.0f, 130.0f, 180.0f};
+    float gain = 0.0f;
+    for (int i = 0; i < 3; i++) {
+        float d = (f - formants[i]) / widths[i];
+        gain += 1.0f / (1.0f + d * d);
+    }
+    return gain * 200.0f / f;
+}
+
+static uint64_t sample_clock = 0;
+static float fan_state = 0.0f;
+
+static std::vector<int16_t> makeFrame(Source source, float level) {
+    std::vector<int16_t> frame(TEST_FRAME_SIZE);
+    for (int i = 0; i < TEST_FRAME_SIZE; i++, sample_clock++) {
+        float t = (float)sample_clock / TEST_SAMPLE_RATE;
+        float x = 0.0f;
+        switch (source) {
+            case VOICED: {
+                const float pitch = 140.0f;
+                for (int h = 1; h * pitch < 4000.0f; h++) {
+                    x += formantGain(h * pitch) * sinf(2.0f * (float)M_PI * h * pitch * t);
+                }
+                break;
+            }
+            case FAN:
+                // Low-passed noise plus blade-pass hum
+                fan_state += 0.05f * (uniformNoise() - fan_state);
+                x = 8.0f * fan_state + 0.3f * sinf(2.0f * (float)M_PI * 100.0f * t);
+                break;
+            case DOOR_SLAM:
+                // Decaying broadband burst, restarted every frame
+                x = uniformNoise() * expf(-(float)i / 200.0f) * 2.0f;
+                break;
+            case HISS:
+                x = uniformNoise();
+                break;
+        }
+        x *= level;
+        frame[i] = (int16_t)fmaxf(-32768.0f, fminf(32767.0f, x));
+    }
+    return frame;
+}
+
+static float detectionRate(VoiceActivityDetector& vad, Source source, float level) {
+    lcg_state = 3;
+    sample_clock = 0;
+    fan_state = 0.0f;
+    int detections = 0;
+    for (int i = 0; i < TEST_FRAMES; i++) {
+        detections += vad.isSpeech(makeFrame(source, level)) ? 1 : 0;
+    }
+    return (float)detections / TEST_FRAMES;
+}
+
+static uint32_t cycleCount() {
+#if defined(ARDUINO)
+    return ESP.getCycleCount();
+#elif defined(__x86_64__) || defined(__i386__)
+    return (uint32_t)__rdtsc();
+#else
+    return (uint32_t)audio_processing::audioMicros();
+#endif
+}
+
+// Tests ----------------------------------------------------------------------
+
+void test_analyzer_band_layout() {
+    BandEnergyAnalyzer analyzer(TEST_SAMPLE_RATE);
+    TEST_ASSERT_GREATER_THAN(0, analyzer.binCount());
+    TEST_ASSERT_GREATER_OR_EQUAL_FLOAT(300.0f, analyzer.binFrequency(0));
+    TEST_ASSERT_LESS_THAN_FLOAT(3000.0f, analyzer.binFrequency(analyzer.binCount() - 1));
+
+    // A 1.5 kHz tone lands in the high speech band, 6 kHz out of band
+    std::vector<int16_t> tone(TEST_FRAME_SIZE);
+    for (int i = 0; i < TEST_FRAME_SIZE; i++) {
+        tone[i] = (int16_t)(8000.0f * sinf(2.0f * (float)M_PI * 1500.0f * i / TEST_SAMPLE_RATE));
+    }
+    BandFeatures features = analyzer.analyze(tone.data(), tone.size());
+    TEST_ASSERT_GREATER_THAN_FLOAT(100.0f * features.low_speech, features.high_speech);
+    TEST_ASSERT_GREATER_THAN_FLOAT(100.0f, features.band_ratio);
+
+    for (int i = 0; i < TEST_FRAME_SIZE; i++) {
+        tone[i] = (int16_t)(8000.0f * sinf(2.0f * (float)M_PI * 6000.0f * i / TEST_SAMPLE_RATE));
+    }
+    features = analyzer.analyze(tone.data(), tone.size());
+    TEST_ASSERT_LESS_THAN_FLOAT(0.01f, features.band_ratio);
+}
+
+void test_energy_mode_triggers_on_noise() {
+    VoiceActivityDetector vad(TEST_THRESHOLD, TEST_FRAME_SIZE);
+    TEST_ASSERT_TRUE(vad.mode() == VADMode::ENERGY);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, detectionRate(vad, VOICED, 1000.0f));
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, detectionRate(vad, FAN, 1000.0f));
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, detectionRate(vad, DOOR_SLAM, 4000.0f));
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, detectionRate(vad, HISS, 1000.0f));
+}
+
+void test_spectral_mode_rejects_noise() {
+    VoiceActivityDetector vad(TEST_THRESHOLD, TEST_FRAME_SIZE);
+    vad.setMode(VADMode::SPECTRAL, TEST_SAMPLE_RATE);
+
+    const Source sources[] = {VOICED, FAN, DOOR_SLAM, HISS};
+    const float levels[] = {1000.0f, 1000.0f, 4000.0f, 1000.0f};
+    float rates[4];
+    for (int s = 0; s < 4; s++) {
+        rates[s] = detectionRate(vad, sources[s], levels[s]);
+        const BandFeatures& f = vad.lastFeatures();
+        AUDIO_LOGF("spectral/%s: rate %.0f%%, band ratio %.2f, flatness %.2f\n",
+                   sourceName(sources[s]), rates[s] * 100, f.band_ratio, f.flatness);
+    }
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, rates[0]);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.05f, rates[1]);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.05f, rates[2]);
+    TEST_ASSERT_LESS_THAN_FLOAT(0.05f, rates[3]);
+}
+
+void test_spectral_mode_keeps_energy_gate() {
+    VoiceActivityDetector vad(TEST_THRESHOLD, TEST_FRAME_SIZE);
+    vad.setMode(VADMode::SPECTRAL, TEST_SAMPLE_RATE);
+    TEST_ASSERT_EQUAL_FLOAT(0.0f, detectionRate(vad, VOICED, 20.0f));
+
+    vad.setMode(VADMode::ENERGY);
+    TEST_ASSERT_GREATER_THAN_FLOAT(0.9f, detectionRate(vad, FAN, 1000.0f));
+}
+
+void test_benchmark_cycles_per_frame() {
+    lcg_state = 5;
+    sample_clock = 0;
+    std::vector<int16_t> frame = makeFrame(VOICED, 1000.0f);
+
+    VoiceActivityDetector energy(TEST_THRESHOLD, TEST_FRAME_SIZE);
+    VoiceActivityDetector spectral(TEST_THRESHOLD, TEST_FRAME_SIZE);
+    spectral.setMode(VADMode::SPECTRAL, TEST_SAMPLE_RATE);
+
+    int hits = 0;
+    uint32_t start = cycleCount();
+    for (int i = 0; i < TEST_BENCH_FRAMES; i++) {
+        hits += energy.isSpeech(frame) ? 1 : 0;
+    }
+    uint32_t energy_cycles = (cycleCount() - start) / TEST_BENCH_FRAMES;
+
+    uint64_t start_us = audio_processing::audioMicros();
+    start = cycleCount();
+    for (int i = 0; i < TEST_BENCH_FRAMES; i++) {
+        hits += spectral.isSpeech(frame) ? 1 : 0;
+    }
+    uint32_t spectral_cycles = (cycleCount() - start) / TEST_BENCH_FRAMES;
+    uint64_t spectral_us = (audio_processing::audioMicros() - start_us) / TEST_BENCH_FRAMES;
+
+    AUDIO_LOGF("energy VAD: %u cycles/frame, spectral VAD: %u cycles/frame (%.1fx), %llu us/frame\n",
+               (unsigned)energy_cycles, (unsigned)spectral_cycles,
+               energy_cycles ? (float)spectral_cycles / energy_cycles : 0.0f,
+               (unsigned long long)spectral_us);
+    TEST_ASSERT_EQUAL(2 * TEST_BENCH_FRAMES, hits);
+
+    // Must stay a small fraction of the 32 ms frame period
+    TEST_ASSERT_LESS_THAN(3200, (int)spectral_us);
+}
+
+int runTests() {
+    UNITY_BEGIN();
+    RUN_TEST(test_analyzer_band_layout);
+    RUN_TEST(test_energy_mode_triggers_on_noise);
+    RUN_TEST(test_spectral_mode_rejects_noise);
+    RUN_TEST(test_spectral_mode_keeps_energy_gate);
+    RUN_TEST(test_benchmark_cycles_per_frame);
+    return UNITY_END();
+}
+
+#ifdef ARDUINO
+void setup() {
+    Serial.begin(115200);
+    while (!Serial) {
+        ; // Wait for serial port to connect
+    }
+
+    delay(2000);  // Allow serial to settle
+
+    Serial.println("\n\n=== Starting Spectral VAD Tests ===\n");
+    runTests();
+}
+
+void loop() {
+    // Empty loop
+}
+#else
+int main() {
+    return runTests();
+}
+#endif